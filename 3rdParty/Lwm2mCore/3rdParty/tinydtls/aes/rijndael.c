@@ -31,6 +31,27 @@
 
 #include "rijndael.h"
 
+/*
+ * The AES instructions of the CPU are used when the compiler can generate them and the CPU
+ * reports them at run time: AES-NI on x86, the cryptographic extension on AArch64. Define
+ * DTLS_NO_CPU_CRYPTO to only build the portable implementation.
+ */
+#if !defined(DTLS_NO_CPU_CRYPTO) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define AES_CPU_X86
+#include <string.h>
+#include <cpuid.h>
+#include <immintrin.h>
+#elif !defined(DTLS_NO_CPU_CRYPTO) && defined(__GNUC__) && defined(__AARCH64EL__) && \
+    defined(__ARM_FEATURE_CRYPTO) && defined(__linux__)
+#define AES_CPU_ARMV8
+#include <string.h>
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
 #undef FULL_UNROLL
 
 /*
@@ -1229,6 +1250,132 @@ rijndaelDecrypt(const aes_u32 rk[/*4*(Nr + 1)*/], int Nr, const aes_u8 ct[16],
 }
 #endif
 
+#if defined(AES_CPU_X86) || defined(AES_CPU_ARMV8)
+#ifdef AES_CPU_X86
+__attribute__((target("aes,sse2")))
+static void
+rijndaelEncryptCpu(const aes_u32 rk[/*4*(Nr + 1)*/], int Nr, const aes_u8 pt[16],
+    aes_u8 ct[16])
+{
+	const __m128i *k = (const __m128i *)rk;
+	__m128i s;
+	int r;
+
+	s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)pt), _mm_loadu_si128(k));
+	for (r = 1; r < Nr; r++)
+		s = _mm_aesenc_si128(s, _mm_loadu_si128(k + r));
+	s = _mm_aesenclast_si128(s, _mm_loadu_si128(k + Nr));
+	_mm_storeu_si128((__m128i *)ct, s);
+}
+
+static int
+rijndaelCpuPresent(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+	return (ecx & bit_AES) && (edx & bit_SSE2);
+}
+#else /* AES_CPU_ARMV8 */
+static void
+rijndaelEncryptCpu(const aes_u32 rk[/*4*(Nr + 1)*/], int Nr, const aes_u8 pt[16],
+    aes_u8 ct[16])
+{
+	const aes_u8 *k = (const aes_u8 *)rk;
+	uint8x16_t s;
+	int r;
+
+	/* AESE starts with the AddRoundKey that AES-NI does last */
+	s = vld1q_u8(pt);
+	for (r = 0; r < Nr - 1; r++)
+		s = vaesmcq_u8(vaeseq_u8(s, vld1q_u8(k + 16 * r)));
+	s = vaeseq_u8(s, vld1q_u8(k + 16 * (Nr - 1)));
+	s = veorq_u8(s, vld1q_u8(k + 16 * Nr));
+	vst1q_u8(ct, s);
+}
+
+static int
+rijndaelCpuPresent(void)
+{
+	return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+}
+#endif
+
+/* -1 until the CPU is probed, then 1 if its AES instructions are used */
+static int aes_cpu = -1;
+
+/* store the schedule of rijndaelKeySetupEnc() as the bytes loaded by the AES instructions */
+static void
+rijndaelKeyToCpu(aes_u32 rk[/*4*(Nr + 1)*/], int Nr)
+{
+	aes_u8 b[4];
+	int i;
+
+	for (i = 0; i < 4 * (Nr + 1); i++) {
+		PUTU32(b, rk[i]);
+		memcpy(&rk[i], b, 4);
+	}
+}
+
+/* FIPS-197 appendix C.1 */
+static int
+rijndaelCpuSelfTest(void)
+{
+	static const aes_u8 key[16] = {
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+	};
+	static const aes_u8 pt[16] = {
+		0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+		0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+	};
+	static const aes_u8 ct[16] = {
+		0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+		0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+	};
+	aes_u32 rk[4*(AES_MAXROUNDS + 1)];
+	aes_u8 out[16];
+	int Nr;
+
+	Nr = rijndaelKeySetupEnc(rk, key, 128);
+	rijndaelKeyToCpu(rk, Nr);
+	rijndaelEncryptCpu(rk, Nr, pt, out);
+	return memcmp(out, ct, sizeof(ct)) == 0;
+}
+
+int
+rijndael_use_cpu(int enable)
+{
+	if (!enable)
+		aes_cpu = 0;
+	else if (aes_cpu != 1)
+		aes_cpu = rijndaelCpuPresent() && rijndaelCpuSelfTest();
+	return aes_cpu;
+}
+#else
+int
+rijndael_use_cpu(int enable)
+{
+	(void)enable;
+	return 0;
+}
+#endif
+
+static void
+rijndael_set_cpu(rijndael_ctx *ctx)
+{
+	ctx->cpu = 0;
+#if defined(AES_CPU_X86) || defined(AES_CPU_ARMV8)
+	if (aes_cpu < 0)
+		rijndael_use_cpu(1);
+	if (aes_cpu) {
+		rijndaelKeyToCpu(ctx->ek, ctx->Nr);
+		ctx->cpu = 1;
+	}
+#endif
+}
+
 /* setup key context for encryption only */
 int
 rijndael_set_key_enc_only(rijndael_ctx *ctx, const u_char *key, int bits)
@@ -1240,6 +1387,7 @@ rijndael_set_key_enc_only(rijndael_ctx *ctx, const u_char *key, int bits)
 		return -1;
 
 	ctx->Nr = rounds;
+	rijndael_set_cpu(ctx);
 #ifdef WITH_AES_DECRYPT
 	ctx->enc_only = 1;
 #endif
@@ -1262,6 +1410,7 @@ rijndael_set_key(rijndael_ctx *ctx, const u_char *key, int bits)
 
 	ctx->Nr = rounds;
 	ctx->enc_only = 0;
+	rijndael_set_cpu(ctx);
 
 	return 0;
 }
@@ -1276,5 +1425,11 @@ rijndael_decrypt(rijndael_ctx *ctx, const u_char *src, u_char *dst)
 void
 rijndael_encrypt(rijndael_ctx *ctx, const u_char *src, u_char *dst)
 {
+#if defined(AES_CPU_X86) || defined(AES_CPU_ARMV8)
+	if (ctx->cpu) {
+		rijndaelEncryptCpu(ctx->ek, ctx->Nr, src, dst);
+		return;
+	}
+#endif
 	rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
 }
@@ -48,6 +48,7 @@ typedef struct {
 	int	enc_only;		/* context contains only encrypt schedule */
 #endif
 	int	Nr;			/* key-length-dependent number of rounds */
+	int	cpu;			/* ek is in the byte order of the CPU AES instructions */
 	aes_u32	ek[4*(AES_MAXROUNDS + 1)];	/* encrypt key schedule */
 #ifdef WITH_AES_DECRYPT
 	aes_u32	dk[4*(AES_MAXROUNDS + 1)];	/* decrypt key schedule */
@@ -59,6 +60,10 @@ int	 rijndael_set_key_enc_only(rijndael_ctx *, const u_char *, int);
 void	 rijndael_decrypt(rijndael_ctx *, const u_char *, u_char *);
 void	 rijndael_encrypt(rijndael_ctx *, const u_char *, u_char *);
 
+/* Enables (1) or disables (0) the AES instructions of the CPU for the keys set up afterwards.
+ * Returns 1 if they are used, i.e. if they are enabled, present and pass their self-test. */
+int	 rijndael_use_cpu(int);
+
 int	rijndaelKeySetupEnc(aes_u32 rk[/*4*(Nr + 1)*/], const aes_u8 cipherKey[], int keyBits);
 int	rijndaelKeySetupDec(aes_u32 rk[/*4*(Nr + 1)*/], const aes_u8 cipherKey[], int keyBits);
 void	rijndaelEncrypt(const aes_u32 rk[/*4*(Nr + 1)*/], int Nr, const aes_u8 pt[16], aes_u8 ct[16]);
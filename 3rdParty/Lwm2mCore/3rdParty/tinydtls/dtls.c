@@ -2628,23 +2628,29 @@ check_server_hello(dtls_context_t *ctx,
    * When the server accepts to resume the previous session, it sends back
    * the session ID length and the session ID in order to notify the client.
   */
-  if (*data) {
-    peer->session_id.size = *data;
-    if (peer->resumption) {
-      if (0 == memcmp(peer->session_id.id, data + 1, peer->session_id.size)) {
-        dtls_info("server is willing to resume the session\n");
-        return 0; /* session resume, no need to init security parameters */
-      }
-      else {
-        dtls_warn("session id mismatch\n");
-        return dtls_alert_fatal_create(DTLS_ALERT_CLOSE_NOTIFY);
-      }
-    } else {
-      /* server assigned session id */
-      memcpy(peer->session_id.id, data + 1, peer->session_id.size);
-      data += peer->session_id.size + 1;
-      data_length -= (peer->session_id.size + 1);
+  if (*data > sizeof(peer->session_id.id)) {
+    dtls_warn("session id too long\n");
+    return dtls_alert_fatal_create(DTLS_ALERT_DECODE_ERROR);
+  }
+
+  if (peer->resumption) {
+    if (*data && (*data == peer->session_id.size) &&
+        (0 == memcmp(peer->session_id.id, data + 1, peer->session_id.size))) {
+      dtls_info("server is willing to resume the session\n");
+      return 0; /* session resume, no need to init security parameters */
     }
+
+    /* the server may decline to resume the session: go on with a full handshake */
+    dtls_info("server declined to resume the session\n");
+    peer->resumption = false;
+  }
+
+  peer->session_id.size = *data;
+  if (*data) {
+    /* server assigned session id */
+    memcpy(peer->session_id.id, data + 1, peer->session_id.size);
+    data += peer->session_id.size + 1;
+    data_length -= (peer->session_id.size + 1);
   }
   else {
     SKIP_VAR_FIELD(data, data_length, uint8); /* skip session id */
@@ -3184,6 +3190,93 @@ dtls_resume(dtls_context_t *ctx, const session_t *dst)
   return -1;
 }
 
+int
+dtls_get_resumption(dtls_context_t *ctx, const session_t *dst,
+		    dtls_resumption_t *resumption)
+{
+  dtls_peer_t *peer = dtls_get_peer(ctx, dst);
+
+  if (!peer || !resumption) {
+    return -1;
+  }
+
+  if ((peer->state != DTLS_STATE_CONNECTED) || !peer->handshake_params ||
+      (peer->session_id.size <= 0)) {
+    return -1;
+  }
+
+  memset(resumption, 0, sizeof(dtls_resumption_t));
+  memcpy(&resumption->session_id, &peer->session_id, sizeof(session_id_t));
+  resumption->cipher = peer->handshake_params->cipher;
+  memcpy(resumption->master_secret, peer->handshake_params->tmp.master_secret,
+	 DTLS_MASTER_SECRET_LENGTH);
+
+  return 0;
+}
+
+int
+dtls_resume_session(dtls_context_t *ctx, const session_t *dst,
+		    const dtls_resumption_t *resumption)
+{
+  dtls_peer_t *peer;
+  int err;
+
+  if (!resumption || (resumption->session_id.size <= 0) ||
+      ((size_t)resumption->session_id.size > sizeof(resumption->session_id.id))) {
+    return -1;
+  }
+
+  if (dtls_get_peer(ctx, dst)) {
+    dtls_warn("peer already exists\n");
+    return -1;
+  }
+
+  peer = dtls_new_peer(dst);
+  if (!peer) {
+    dtls_crit("cannot create new peer\n");
+    return -1;
+  }
+
+  /* set local peer role to client, remote is server */
+  peer->role = DTLS_CLIENT;
+
+  peer->handshake_params = dtls_handshake_new();
+  if (!peer->handshake_params) {
+    dtls_free_peer(peer);
+    return -1;
+  }
+
+  if (dtls_add_peer(ctx, peer) < 0) {
+    dtls_alert("cannot add peer\n");
+    dtls_free_peer(peer);
+    return -1;
+  }
+
+  /* restore the session to resume, the key block is calculated from
+   * the master secret once the server has accepted to resume it */
+  memcpy(&peer->session_id, &resumption->session_id, sizeof(session_id_t));
+  memcpy(peer->handshake_params->tmp.master_secret, resumption->master_secret,
+	 DTLS_MASTER_SECRET_LENGTH);
+  peer->handshake_params->cipher = resumption->cipher;
+  peer->handshake_params->compression = TLS_COMPRESSION_NULL;
+  peer->handshake_params->hs_state.mseq_r = 0;
+  peer->handshake_params->hs_state.mseq_s = 0;
+
+  /* send ClientHello with empty Cookie */
+  err = dtls_send_client_hello(ctx, peer, NULL, 0);
+  if (err < 0) {
+    dtls_warn("cannot send ClientHello\n");
+    return err;
+  }
+
+  peer->resumption = true;
+  peer->state = DTLS_STATE_CLIENTHELLO;
+
+  CALL(ctx, event, &peer->session, 0, DTLS_EVENT_CONNECT);
+
+  return err;
+}
+
 static int
 handle_handshake_msg(dtls_context_t *ctx, dtls_peer_t *peer, session_t *session,
 		 const dtls_peer_type role, const dtls_state_t state,
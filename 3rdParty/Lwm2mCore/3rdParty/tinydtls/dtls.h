@@ -284,6 +284,46 @@ int dtls_renegotiate(dtls_context_t *ctx, const session_t *dst);
 
 int dtls_resume(dtls_context_t *ctx, const session_t *dst);
 
+/**
+ * Holds the state needed to resume a session with an abbreviated
+ * handshake, possibly from another DTLS context (e.g. after a
+ * restart of the application).
+ */
+typedef struct {
+  session_id_t session_id;	/**< session identifier assigned by the server */
+  dtls_cipher_t cipher;		/**< cipher suite of the session */
+  uint8 master_secret[DTLS_MASTER_SECRET_LENGTH]; /**< master secret of the session */
+} dtls_resumption_t;
+
+/**
+ * Retrieves the state needed to resume the session established with
+ * @p dst. This function returns zero on success, and a value less
+ * than zero if no session with a session identifier is established.
+ *
+ * @param ctx        The DTLS context to use.
+ * @param dst        The remote party of the session.
+ * @param resumption The resumption state to fill.
+ * @return A value less than zero on error, zero otherwise.
+ */
+int dtls_get_resumption(dtls_context_t *ctx, const session_t *dst,
+			dtls_resumption_t *resumption);
+
+/**
+ * Starts an abbreviated handshake with @p dst, resuming the session
+ * described by @p resumption. The remote party must not be known by
+ * @p ctx yet. If the server declines to resume the session, a full
+ * handshake is done instead. This function returns a value greater
+ * than zero when a ClientHello message was sent, and a value less
+ * than zero on error.
+ *
+ * @param ctx        The DTLS context to use.
+ * @param dst        The remote party to connect to.
+ * @param resumption The session to resume, see dtls_get_resumption().
+ * @return A value less than zero on error, greater than zero otherwise.
+ */
+int dtls_resume_session(dtls_context_t *ctx, const session_t *dst,
+			const dtls_resumption_t *resumption);
+
 /** 
  * Writes the application data given in @p buf to the peer specified
  * by @p session. 
@@ -214,7 +214,7 @@ dsrv_print_addr(const session_t *addr, char *buf, size_t len) {
 /*Macro-ed in dtls_debug.h in order to use the platform's standard debug output*/
 #ifndef __RTOS__
 void
-dsrv_log(log_t level, char *format, ...) {
+dsrv_log(log_t level, const char *format, ...) {
   static char timebuf[32];
   va_list ap;
   FILE *log_fd;
@@ -239,7 +239,7 @@ dsrv_log(log_t level, char *format, ...) {
 /*SWISTOP*/
 #elif defined (HAVE_VPRINTF) /* WITH_CONTIKI */
 void
-dsrv_log(log_t level, char *format, ...) {
+dsrv_log(log_t level, const char *format, ...) {
   static char timebuf[32];
   va_list ap;
 
@@ -76,7 +76,7 @@ void dtls_set_log_level(log_t level);
 #ifdef HAVE_VPRINTF
 /*SWISTART*/
 #ifndef __RTOS__
-void dsrv_log(log_t level, char *format, ...);
+void dsrv_log(log_t level, const char *format, ...);
 #else /*__RTOS__*/
 #define dsrv_log(dblv,fmt,...)  lwm2m_printf(fmt, ##__VA_ARGS__)
 #endif /*__RTOS__*/
@@ -115,6 +115,28 @@
 #error Define BYTE_ORDER to be equal to either LITTLE_ENDIAN or BIG_ENDIAN
 #endif
 
+/*
+ * SHA-256 INSTRUCTIONS NOTE:
+ *
+ * The SHA-256 transform uses the instructions of the CPU when the
+ * compiler can generate them and the CPU reports them at run time:
+ * SHA-NI on x86, the cryptographic extension on AArch64. Define
+ * DTLS_NO_CPU_CRYPTO to only build the portable transform.
+ */
+#if defined(WITH_SHA256) && !defined(DTLS_NO_CPU_CRYPTO) && \
+    BYTE_ORDER == LITTLE_ENDIAN && defined(__GNUC__)
+#  if (__GNUC__ >= 5) && (defined(__x86_64__) || defined(__i386__))
+#    define SHA2_CPU_X86
+#    include <cpuid.h>
+#    include <immintrin.h>
+#  elif defined(__AARCH64EL__) && defined(__ARM_FEATURE_CRYPTO) && defined(__linux__)
+#    define SHA2_CPU_ARMV8
+#    include <arm_neon.h>
+#    include <sys/auxv.h>
+#    include <asm/hwcap.h>
+#  endif
+#endif
+
 /*
  * Define the followingsha2_* types to types of the correct length on
  * the native archtecture.   Most BSD systems and Linux define u_intXX_t
@@ -413,7 +435,7 @@ void dtls_sha256_init(dtls_sha256_ctx* context) {
 	(h) = T1 + Sigma0_256(a) + Maj((a), (b), (c)); \
 	j++
 
-void dtls_sha256_transform(dtls_sha256_ctx* context, const sha2_word32* data) {
+static void dtls_sha256_transform_generic(dtls_sha256_ctx* context, const sha2_word32* data) {
 	sha2_word32	a, b, c, d, e, f, g, h, s0, s1;
 	sha2_word32	T1, *W256;
 	int		j;
@@ -471,7 +493,7 @@ void dtls_sha256_transform(dtls_sha256_ctx* context, const sha2_word32* data) {
 
 #else /* SHA2_UNROLL_TRANSFORM */
 
-void dtls_sha256_transform(dtls_sha256_ctx* context, const sha2_word32* data) {
+static void dtls_sha256_transform_generic(dtls_sha256_ctx* context, const sha2_word32* data) {
 	sha2_word32	a, b, c, d, e, f, g, h, s0, s1;
 	sha2_word32	T1, T2, *W256;
 	int		j;
@@ -551,6 +573,141 @@ void dtls_sha256_transform(dtls_sha256_ctx* context, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+#if defined(SHA2_CPU_X86)
+__attribute__((target("sha,ssse3,sse4.1")))
+static void dtls_sha256_transform_cpu(dtls_sha256_ctx* context, const sha2_word32* data) {
+	const __m128i	mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	const sha2_byte	*bytes = (const sha2_byte*)data;
+	__m128i		state0, state1, abef, cdgh, msg, tmp, W[4];
+	int		j;
+
+	/* The instructions work on the ABEF and CDGH halves of the state */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&context->state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&context->state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+	abef = state0;
+	cdgh = state1;
+
+	/* Four rounds per iteration, with the message schedule kept in W[] */
+	for (j = 0; j < 16; j++) {
+		if (j < 4) {
+			msg = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(bytes + 16 * j)), mask);
+		} else {
+			msg = _mm_sha256msg1_epu32(W[j & 3], W[(j - 3) & 3]);
+			msg = _mm_add_epi32(msg, _mm_alignr_epi8(W[(j - 1) & 3], W[(j - 2) & 3], 4));
+			msg = _mm_sha256msg2_epu32(msg, W[(j - 1) & 3]);
+		}
+		W[j & 3] = msg;
+		msg = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i*)&K256[4 * j]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+	}
+
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	_mm_storeu_si128((__m128i*)&context->state[0], _mm_blend_epi16(tmp, state1, 0xf0));
+	_mm_storeu_si128((__m128i*)&context->state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+static int dtls_sha256_cpu_present(void) {
+	unsigned int	eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+	    !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) {
+		return 0;
+	}
+	if (__get_cpuid_max(0, 0) < 7) {
+		return 0;
+	}
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	return (ebx & bit_SHA) != 0;
+}
+#elif defined(SHA2_CPU_ARMV8)
+static void dtls_sha256_transform_cpu(dtls_sha256_ctx* context, const sha2_word32* data) {
+	const sha2_byte	*bytes = (const sha2_byte*)data;
+	uint32x4_t	state0, state1, abcd, efgh, msg, tmp, W[4];
+	int		j;
+
+	state0 = abcd = vld1q_u32(&context->state[0]);
+	state1 = efgh = vld1q_u32(&context->state[4]);
+
+	/* Four rounds per iteration, with the message schedule kept in W[] */
+	for (j = 0; j < 16; j++) {
+		if (j < 4) {
+			msg = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(bytes + 16 * j)));
+		} else {
+			msg = vsha256su0q_u32(W[j & 3], W[(j - 3) & 3]);
+			msg = vsha256su1q_u32(msg, W[(j - 2) & 3], W[(j - 1) & 3]);
+		}
+		W[j & 3] = msg;
+		msg = vaddq_u32(msg, vld1q_u32(&K256[4 * j]));
+		tmp = state0;
+		state0 = vsha256hq_u32(state0, state1, msg);
+		state1 = vsha256h2q_u32(state1, tmp, msg);
+	}
+
+	vst1q_u32(&context->state[0], vaddq_u32(state0, abcd));
+	vst1q_u32(&context->state[4], vaddq_u32(state1, efgh));
+}
+
+static int dtls_sha256_cpu_present(void) {
+	return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+}
+#endif
+
+#if defined(SHA2_CPU_X86) || defined(SHA2_CPU_ARMV8)
+/* -1 until the CPU is probed, then 1 if its SHA-256 instructions are used */
+static int sha256_cpu = -1;
+
+/* Checks the transform of the CPU on the single block of "abc" (FIPS 180-2 appendix B.1) */
+static int dtls_sha256_cpu_self_test(void) {
+	static const sha2_word32 expected[8] = {
+		0xba7816bfUL, 0x8f01cfeaUL, 0x414140deUL, 0x5dae2223UL,
+		0xb00361a3UL, 0x96177a9cUL, 0xb410ff61UL, 0xf20015adUL
+	};
+	dtls_sha256_ctx	context;
+
+	dtls_sha256_init(&context);
+	context.buffer[0] = 'a';
+	context.buffer[1] = 'b';
+	context.buffer[2] = 'c';
+	context.buffer[3] = 0x80;
+	context.buffer[DTLS_SHA256_BLOCK_LENGTH - 1] = 24;
+	dtls_sha256_transform_cpu(&context, (sha2_word32*)context.buffer);
+	return memcmp(context.state, expected, sizeof(expected)) == 0;
+}
+
+int dtls_sha256_use_cpu(int enable) {
+	if (!enable) {
+		sha256_cpu = 0;
+	} else if (sha256_cpu != 1) {
+		sha256_cpu = dtls_sha256_cpu_present() && dtls_sha256_cpu_self_test();
+	}
+	return sha256_cpu;
+}
+#else
+int dtls_sha256_use_cpu(int enable) {
+	(void)enable;
+	return 0;
+}
+#endif
+
+void dtls_sha256_transform(dtls_sha256_ctx* context, const sha2_word32* data) {
+#if defined(SHA2_CPU_X86) || defined(SHA2_CPU_ARMV8)
+	if (sha256_cpu < 0) {
+		dtls_sha256_use_cpu(1);
+	}
+	if (sha256_cpu) {
+		dtls_sha256_transform_cpu(context, data);
+		return;
+	}
+#endif
+	dtls_sha256_transform_generic(context, data);
+}
+
 void dtls_sha256_update(dtls_sha256_ctx* context, const sha2_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 
@@ -133,6 +133,7 @@ void dtls_sha256_update(dtls_sha256_ctx*, const uint8_t*, size_t);
 void dtls_sha256_final(uint8_t[DTLS_SHA256_DIGEST_LENGTH], dtls_sha256_ctx*);
 char* dtls_sha256_end(dtls_sha256_ctx*, char[DTLS_SHA256_DIGEST_STRING_LENGTH]);
 char* dtls_sha256_data(const uint8_t*, size_t, char[DTLS_SHA256_DIGEST_STRING_LENGTH]);
+int dtls_sha256_use_cpu(int);
 #endif
 
 #ifdef WITH_SHA384
@@ -159,6 +160,7 @@ void dtls_sha256_update(dtls_sha256_ctx*, const u_int8_t*, size_t);
 void dtls_sha256_final(u_int8_t[DTLS_SHA256_DIGEST_LENGTH], dtls_sha256_ctx*);
 char* dtls_sha256_end(dtls_sha256_ctx*, char[DTLS_SHA256_DIGEST_STRING_LENGTH]);
 char* dtls_sha256_data(const u_int8_t*, size_t, char[DTLS_SHA256_DIGEST_STRING_LENGTH]);
+int dtls_sha256_use_cpu(int);
 #endif
 
 #ifdef WITH_SHA384
@@ -187,6 +189,7 @@ void dtls_sha256_update();
 void dtls_sha256_final();
 char* dtls_sha256_end();
 char* dtls_sha256_data();
+int dtls_sha256_use_cpu();
 #endif
 
 #ifdef WITH_SHA384
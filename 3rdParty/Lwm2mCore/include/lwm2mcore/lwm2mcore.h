@@ -245,6 +245,7 @@ typedef enum
     LWM2MCORE_CREDENTIAL_DM_SERVER_PUBLIC_KEY,  ///< LWM2M Server’s or LWM2M Bootstrap Server’s Certificate (Certificate mode), public key (RPK mode)
     LWM2MCORE_CREDENTIAL_DM_SECRET_KEY,         ///< secret key or private key of the security mode
     LWM2MCORE_CREDENTIAL_DM_ADDRESS,            ///< DM server address
+    LWM2MCORE_CREDENTIAL_DTLS_SESSION,          ///< Last DTLS session, to resume it after a restart
     LWM2MCORE_CREDENTIAL_MAX                    ///< Internal usage
 }lwm2mcore_Credentials_t;
 /**
@@ -795,6 +796,20 @@ void lwm2mcore_SetPushCallback
     lwm2mcore_PushAckCallback_t callbackP  ///< [IN] push callback pointer
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * @brief Function to set the inactivity duration after which the DTLS session is resumed before
+ * sending data, in order to recover from a NAT binding expiration. Default value is 40 seconds.
+ *
+ * @remark Setting 0 keeps the idle connection as it is, which saves a handshake per exchange on
+ * networks where the NAT binding of the client outlives its inactivity periods.
+ */
+//--------------------------------------------------------------------------------------------------
+void lwm2mcore_SetDtlsNatTimeout
+(
+    uint32_t timeout                    ///< [IN] Inactivity duration in seconds
+);
+
 /**
   * @}
   */
@@ -173,6 +173,9 @@ static uint8_t SetCoapError
 /**
  * Function which returns a registered object
  *
+ * The object index built by BuildObjectIndex is searched by dichotomy. When several objects share
+ * the same object ID, the first one registered is returned.
+ *
  * @return
  *      - object pointer  if the object is found
  *      - NULL  if the object is not found
@@ -185,18 +188,48 @@ static lwm2mcore_internalObject_t* FindObject
 )
 {
     lwm2mcore_internalObject_t* objPtr = NULL;
+    uint16_t low;
+    uint16_t high;
 
     if (NULL == ctxPtr)
     {
         return NULL;
     }
 
-    for (objPtr = DLIST_FIRST(&(ctxPtr->objects_list)); objPtr; objPtr = DLIST_NEXT(objPtr, list))
+    if (NULL == ctxPtr->objectIndexPtr)
     {
-        if (objPtr->id == oid)
+        for (objPtr = DLIST_FIRST(&(ctxPtr->objects_list));
+             objPtr;
+             objPtr = DLIST_NEXT(objPtr, list))
         {
-            break;
+            if (objPtr->id == oid)
+            {
+                break;
+            }
         }
+        return objPtr;
+    }
+
+    /* Look for the first index entry whose object ID is not lower than oid */
+    low = 0;
+    high = ctxPtr->objectIndexCount;
+    while (low < high)
+    {
+        uint16_t middle = low + (high - low) / 2;
+
+        if (ctxPtr->objectIndexPtr[middle]->id < oid)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if ((low < ctxPtr->objectIndexCount) && (ctxPtr->objectIndexPtr[low]->id == oid))
+    {
+        objPtr = ctxPtr->objectIndexPtr[low];
     }
 
     return objPtr;
@@ -206,6 +239,8 @@ static lwm2mcore_internalObject_t* FindObject
 /**
  * Function which returns a registered resource for a specific object
  *
+ * The resource index built by BuildResourceIndex is searched by dichotomy.
+ *
  * @return
  *      - resource pointer  if the resource is found
  *      - NULL  if the object is not found
@@ -218,17 +253,44 @@ static lwm2mcore_internalResource_t* FindResource
 )
 {
     lwm2mcore_internalResource_t* resourcePtr = NULL;
+    uint16_t low;
+    uint16_t high;
 
     LWM2MCORE_ASSERT(objPtr);
 
-    for (resourcePtr = DLIST_FIRST(&(objPtr->resource_list));
-         resourcePtr;
-         resourcePtr = DLIST_NEXT(resourcePtr, list))
+    if (NULL == objPtr->resourceIndexPtr)
     {
-        if (resourcePtr->id == rid)
+        for (resourcePtr = DLIST_FIRST(&(objPtr->resource_list));
+             resourcePtr;
+             resourcePtr = DLIST_NEXT(resourcePtr, list))
         {
-            break;
+            if (resourcePtr->id == rid)
+            {
+                break;
+            }
         }
+        return resourcePtr;
+    }
+
+    low = 0;
+    high = objPtr->resourceIndexCount;
+    while (low < high)
+    {
+        uint16_t middle = low + (high - low) / 2;
+
+        if (objPtr->resourceIndexPtr[middle]->id < rid)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if ((low < objPtr->resourceIndexCount) && (objPtr->resourceIndexPtr[low]->id == rid))
+    {
+        resourcePtr = objPtr->resourceIndexPtr[low];
     }
 
     return resourcePtr;
@@ -1259,6 +1321,127 @@ static struct _lwm2mcore_objectsList* GetObjectsList
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the index of the resources of an object, sorted by resource ID.
+ *
+ * If the index cannot be allocated, FindResource walks the resource list instead.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BuildResourceIndex
+(
+    lwm2mcore_internalObject_t* objPtr      ///< [IN] Object pointer
+)
+{
+    lwm2mcore_internalResource_t* resourcePtr;
+    uint16_t count = 0;
+    uint16_t i;
+
+    if (NULL != objPtr->resourceIndexPtr)
+    {
+        lwm2m_free(objPtr->resourceIndexPtr);
+    }
+    objPtr->resourceIndexPtr = NULL;
+    objPtr->resourceIndexCount = 0;
+
+    for (resourcePtr = DLIST_FIRST(&(objPtr->resource_list));
+         resourcePtr;
+         resourcePtr = DLIST_NEXT(resourcePtr, list))
+    {
+        count++;
+    }
+
+    if (0 == count)
+    {
+        return;
+    }
+
+    objPtr->resourceIndexPtr = (lwm2mcore_internalResource_t**)
+                                lwm2m_malloc(count * sizeof(lwm2mcore_internalResource_t*));
+    if (NULL == objPtr->resourceIndexPtr)
+    {
+        LOG_ARG("No index for the resources of object %d", objPtr->id);
+        return;
+    }
+
+    /* Insertion sort: the resource tables are short and usually already sorted */
+    for (resourcePtr = DLIST_FIRST(&(objPtr->resource_list));
+         resourcePtr;
+         resourcePtr = DLIST_NEXT(resourcePtr, list))
+    {
+        for (i = objPtr->resourceIndexCount;
+             (i > 0) && (objPtr->resourceIndexPtr[i - 1]->id > resourcePtr->id);
+             i--)
+        {
+            objPtr->resourceIndexPtr[i] = objPtr->resourceIndexPtr[i - 1];
+        }
+        objPtr->resourceIndexPtr[i] = resourcePtr;
+        objPtr->resourceIndexCount++;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the index of the registered objects, sorted by object ID.
+ *
+ * Objects sharing the same object ID keep their registration order, i.e. their object instance ID
+ * order. If the index cannot be allocated, FindObject walks the object list instead.
+ */
+//--------------------------------------------------------------------------------------------------
+static void BuildObjectIndex
+(
+    lwm2mcore_context_t* ctxPtr             ///< [IN] LWM2M core context
+)
+{
+    lwm2mcore_internalObject_t* objPtr;
+    uint16_t count = 0;
+    uint16_t i;
+
+    if (NULL == ctxPtr)
+    {
+        return;
+    }
+
+    if (NULL != ctxPtr->objectIndexPtr)
+    {
+        lwm2m_free(ctxPtr->objectIndexPtr);
+    }
+    ctxPtr->objectIndexPtr = NULL;
+    ctxPtr->objectIndexCount = 0;
+
+    for (objPtr = DLIST_FIRST(&(ctxPtr->objects_list)); objPtr; objPtr = DLIST_NEXT(objPtr, list))
+    {
+        count++;
+    }
+
+    if (0 == count)
+    {
+        return;
+    }
+
+    ctxPtr->objectIndexPtr = (lwm2mcore_internalObject_t**)
+                             lwm2m_malloc(count * sizeof(lwm2mcore_internalObject_t*));
+    if (NULL == ctxPtr->objectIndexPtr)
+    {
+        LOG("No index for the registered objects");
+        return;
+    }
+
+    for (objPtr = DLIST_FIRST(&(ctxPtr->objects_list)); objPtr; objPtr = DLIST_NEXT(objPtr, list))
+    {
+        for (i = ctxPtr->objectIndexCount;
+             (i > 0) && (ctxPtr->objectIndexPtr[i - 1]->id > objPtr->id);
+             i--)
+        {
+            ctxPtr->objectIndexPtr[i] = ctxPtr->objectIndexPtr[i - 1];
+        }
+        ctxPtr->objectIndexPtr[i] = objPtr;
+        ctxPtr->objectIndexCount++;
+    }
+
+    LOG_ARG("%d objects indexed", ctxPtr->objectIndexCount);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize LwM2M object
@@ -1335,6 +1518,8 @@ static lwm2mcore_internalObject_t* InitObject
         DLIST_INSERT_TAIL(&(objPtr->resource_list), resourcePtr, list);
     }
 
+    BuildResourceIndex(objPtr);
+
     return objPtr;
 }
 
@@ -1431,6 +1616,13 @@ void omanager_ObjectsFree
     }
 
     /* Free memory for objects and resources for LwM2MCore */
+    if (NULL != Lwm2mcoreCtxPtr->objectIndexPtr)
+    {
+        lwm2m_free(Lwm2mcoreCtxPtr->objectIndexPtr);
+    }
+    Lwm2mcoreCtxPtr->objectIndexPtr = NULL;
+    Lwm2mcoreCtxPtr->objectIndexCount = 0;
+
     while ((objPtr = DLIST_FIRST(objectsListPtr)) != NULL)
     {
         while ((resPtr = DLIST_FIRST(&(objPtr->resource_list))) != NULL)
@@ -1438,6 +1630,10 @@ void omanager_ObjectsFree
             DLIST_REMOVE_HEAD(&(objPtr->resource_list), list);
             lwm2m_free(resPtr);
         }
+        if (NULL != objPtr->resourceIndexPtr)
+        {
+            lwm2m_free(objPtr->resourceIndexPtr);
+        }
         DLIST_REMOVE_HEAD(objectsListPtr, list);
         lwm2m_free(objPtr);
     }
@@ -1711,6 +1907,7 @@ static bool RegisterObjTable
      */
     objectsListPtr = GetObjectsList();
     InitObjectsList(objectsListPtr, handlerPtr);
+    BuildObjectIndex(Lwm2mcoreCtxPtr);
     *registeredObjNbPtr = ObjNb;
     return true;
 }
@@ -482,6 +482,8 @@ typedef struct _lwm2mcore_internalObject            /// See lwm2mcore_internalOb
                                                     ///< instances
     lwm2m_attribute_t attr;                         ///< object attributes
     struct _lwm2m_resource_list resource_list;      ///< resource linked list
+    lwm2mcore_internalResource_t** resourceIndexPtr; ///< resources sorted by resource id
+    uint16_t resourceIndexCount;                    ///< number of entries in resourceIndexPtr
 }lwm2mcore_internalObject_t;
 
 //--------------------------------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <platform/types.h>
 #include <lwm2mcore/lwm2mcore.h>
+#include <lwm2mcore/security.h>
 #include <lwm2mcore/socket.h>
 #include <lwm2mcore/udp.h>
 #include "objects.h"
@@ -40,6 +41,44 @@
 //--------------------------------------------------------------------------------------------------
 dtls_context_t* DtlsContextPtr;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Inactivity duration in seconds after which the DTLS session is resumed before sending data.
+ * When set to 0, the connection is kept as it is whatever the inactivity duration.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t NatTimeout = DTLS_NAT_TIMEOUT;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Structure of the last DTLS session established with a server. It is kept in the platform
+ * storage in order to resume the session with an abbreviated handshake on the next connection to
+ * the same server, even after a restart of the client.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char              uri[URI_LENGTH];                              ///< Server URI
+    uint8_t           identity[DTLS_PSK_MAX_CLIENT_IDENTITY_LEN];   ///< PSK identity
+    uint16_t          identityLen;                                  ///< PSK identity length
+    dtls_resumption_t resumption;                                   ///< Session to resume
+}
+StoredSession_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Last DTLS session established with a server
+ */
+//--------------------------------------------------------------------------------------------------
+static StoredSession_t StoredSession;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Is the last DTLS session read from the platform storage?
+ */
+//--------------------------------------------------------------------------------------------------
+static bool StoredSessionLoaded = false;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to search the server URI (resource 0 of object 0)
@@ -233,6 +272,146 @@ static char* SecurityGetSecretKey
     return NULL;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to get the server URI and the PSK identity of a connection: a stored session can only
+ * be resumed on a connection with the same server URI and PSK identity.
+ *
+ * @return
+ *  - true on success
+ *  - false in case of failure
+ */
+//--------------------------------------------------------------------------------------------------
+static bool GetSessionOwner
+(
+    dtls_Connection_t* connPtr,     ///< [IN] DTLS connection structure
+    StoredSession_t* sessionPtr     ///< [OUT] Session in which the URI and identity are written
+)
+{
+    char* identityPtr;
+    int length = 0;
+
+    memset(sessionPtr, 0, sizeof(StoredSession_t));
+
+    if (NULL == SecurityGetUri(connPtr->securityObjPtr,
+                               connPtr->securityInstId,
+                               sessionPtr->uri,
+                               sizeof(sessionPtr->uri)))
+    {
+        return false;
+    }
+
+    identityPtr = SecurityGetPublicId(connPtr->securityObjPtr, connPtr->securityInstId, &length);
+    if (NULL == identityPtr)
+    {
+        return false;
+    }
+
+    if ((0 >= length) || ((size_t)length > sizeof(sessionPtr->identity)))
+    {
+        lwm2m_free(identityPtr);
+        return false;
+    }
+
+    memcpy(sessionPtr->identity, identityPtr, length);
+    sessionPtr->identityLen = (uint16_t)length;
+    lwm2m_free(identityPtr);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to get the last DTLS session established with a server. The session is read from the
+ * platform storage on first call.
+ *
+ * @return
+ *  - pointer on the stored session, with a session Id size set to 0 if no session is stored
+ */
+//--------------------------------------------------------------------------------------------------
+static StoredSession_t* GetStoredSession
+(
+    void
+)
+{
+    if (!StoredSessionLoaded)
+    {
+        size_t len = sizeof(StoredSession);
+
+        if ((LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_GetCredential(
+                                                                LWM2MCORE_CREDENTIAL_DTLS_SESSION,
+                                                                LWM2MCORE_NO_SERVER_ID,
+                                                                (char*)&StoredSession,
+                                                                &len))
+         || (sizeof(StoredSession) != len))
+        {
+            memset(&StoredSession, 0, sizeof(StoredSession));
+        }
+        StoredSessionLoaded = true;
+    }
+
+    return &StoredSession;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to store the DTLS session established on a connection. The platform storage is only
+ * written if the session changed, i.e. not when a stored session was resumed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StoreSession
+(
+    dtls_Connection_t* connPtr      ///< [IN] DTLS connection structure
+)
+{
+    StoredSession_t session;
+
+    if (!GetSessionOwner(connPtr, &session))
+    {
+        return;
+    }
+
+    if (0 != dtls_get_resumption(connPtr->dtlsContextPtr,
+                                 connPtr->dtlsSessionPtr,
+                                 &session.resumption))
+    {
+        LOG("No session Id assigned by the server");
+        return;
+    }
+
+    if (0 == memcmp(&session, GetStoredSession(), sizeof(StoredSession_t)))
+    {
+        return;
+    }
+
+    memcpy(&StoredSession, &session, sizeof(StoredSession_t));
+    if (LWM2MCORE_ERR_COMPLETED_OK != lwm2mcore_SetCredential(LWM2MCORE_CREDENTIAL_DTLS_SESSION,
+                                                              LWM2MCORE_NO_SERVER_ID,
+                                                              (char*)&StoredSession,
+                                                              sizeof(StoredSession)))
+    {
+        LOG("Unable to store the DTLS session");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to forget the stored DTLS session, e.g. when the handshake with a server failed
+ */
+//--------------------------------------------------------------------------------------------------
+static void ForgetStoredSession
+(
+    void
+)
+{
+    if (0 == GetStoredSession()->resumption.session_id.size)
+    {
+        return;
+    }
+
+    memset(&StoredSession, 0, sizeof(StoredSession));
+    lwm2mcore_DeleteCredential(LWM2MCORE_CREDENTIAL_DTLS_SESSION, LWM2MCORE_NO_SERVER_ID);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to send data on DTLS
@@ -490,9 +669,9 @@ static int dtlsEventCb
                                     ///< greater indicate internal DTLS session changes.
 )
 {
+    dtls_Connection_t* connPtr;
+
     (void)level;
-    (void)sessionPtr;
-    (void)ctxPtr;
 
     switch (code)
     {
@@ -506,6 +685,15 @@ static int dtlsEventCb
 
         case DTLS_EVENT_CONNECTED:
         {
+            /* Keep the session in order to resume it on next connection */
+            connPtr = dtls_FindConnection((dtls_Connection_t*)ctxPtr->app,
+                                          &(sessionPtr->addr.st),
+                                          sessionPtr->size);
+            if (NULL != connPtr)
+            {
+                StoreSession(connPtr);
+            }
+
             /* Notify that the device authentication succeeds */
             smanager_SendSessionEvent(EVENT_TYPE_AUTHENTICATION, EVENT_STATUS_DONE_SUCCESS);
         }
@@ -514,6 +702,9 @@ static int dtlsEventCb
         case DTLS_ALERT_INTERNAL_ERROR:
         case DTLS_ALERT_HANDSHAKE_FAILURE:
         {
+            /* The stored session may be the cause of the failure: do not resume it anymore */
+            ForgetStoredSession();
+
             /* Notify that the device authentication fails */
             smanager_SendSessionEvent(EVENT_TYPE_AUTHENTICATION, EVENT_STATUS_DONE_FAIL);
         }
@@ -954,7 +1145,13 @@ static int ConnectionSend
         time_t timeFromLastData = lwm2m_gettime() - connPtr->lastSend;
         LOG_ARG("now - connP->lastSend %d", timeFromLastData);
 
-        if (firstBlock)
+        if (NULL == dtls_get_peer(connPtr->dtlsContextPtr, connPtr->dtlsSessionPtr))
+        {
+            // First data sent to the server: resume the stored session if any, else the full
+            // handshake is initiated by dtls_write
+            dtls_ResumeStoredSession(connPtr);
+        }
+        else if (firstBlock)
         {
             // If difference is negative, a time update could have been made on platform side.
             // In this case, do a rehandshake
@@ -967,7 +1164,7 @@ static int ConnectionSend
                     return -1;
                 }
             }
-            else if ((0 < DTLS_NAT_TIMEOUT) && (DTLS_NAT_TIMEOUT < timeFromLastData))
+            else if ((0 < NatTimeout) && ((time_t)NatTimeout < timeFromLastData))
             {
                 if (0 != dtls_Resume(connPtr))
                 {
@@ -1114,6 +1311,67 @@ int dtls_Resume
     return result;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to resume the DTLS session stored during a previous connection to the same server
+ *
+ * @return
+ *  - 0 if an abbreviated handshake is initiated
+ *  - -1 if no session can be resumed on this connection
+ */
+//--------------------------------------------------------------------------------------------------
+int dtls_ResumeStoredSession
+(
+    dtls_Connection_t* connPtr  ///< [IN] DTLS connection structure
+)
+{
+    StoredSession_t owner;
+    StoredSession_t* storedPtr;
+    int result;
+
+    // if not a dtls connection we do nothing
+    if (NULL == (connPtr->dtlsSessionPtr))
+    {
+        return -1;
+    }
+
+    storedPtr = GetStoredSession();
+    if ((0 == storedPtr->resumption.session_id.size)
+     || (!GetSessionOwner(connPtr, &owner))
+     || (0 != strcmp(owner.uri, storedPtr->uri))
+     || (owner.identityLen != storedPtr->identityLen)
+     || (0 != memcmp(owner.identity, storedPtr->identity, owner.identityLen)))
+    {
+        return -1;
+    }
+
+    LOG("Initiate a DTLS resume of the stored session");
+
+    result = dtls_resume_session(connPtr->dtlsContextPtr,
+                                 connPtr->dtlsSessionPtr,
+                                 &storedPtr->resumption);
+    if (0 > result)
+    {
+        LOG_ARG("Error DTLS resume of the stored session %d", result);
+        return -1;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to set the inactivity duration after which the DTLS session is resumed before sending
+ * data
+ */
+//--------------------------------------------------------------------------------------------------
+void dtls_SetNatTimeout
+(
+    uint32_t timeout            ///< [IN] Inactivity duration in seconds, 0 to keep the connection
+)
+{
+    NatTimeout = timeout;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to send data on a specific peer
@@ -42,7 +42,8 @@
 //--------------------------------------------------------------------------------------------------
 /**
  * @brief Define value for the DTLS rehandshake: after 40 seconds of inactivity, a rehandshake is
- * needed in order to send any data to the server
+ * needed in order to send any data to the server. Default value of the inactivity duration set by
+ * dtls_SetNatTimeout().
  */
 //--------------------------------------------------------------------------------------------------
 #define DTLS_NAT_TIMEOUT 40
@@ -201,6 +202,32 @@ int dtls_Resume
 (
     dtls_Connection_t* connPtr          ///< [IN] DTLS connection structure
 );
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * @brief Function to resume the DTLS session stored during a previous connection to the same
+ * server, possibly before a restart of the client
+ *
+ * @return
+ *  - @c 0 if an abbreviated handshake is initiated
+ *  - @c -1 if no session can be resumed on this connection
+ */
+//--------------------------------------------------------------------------------------------------
+int dtls_ResumeStoredSession
+(
+    dtls_Connection_t* connPtr          ///< [IN] DTLS connection structure
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * @brief Function to set the inactivity duration after which the DTLS session is resumed before
+ * sending data. When set to 0, the connection is kept as it is whatever the inactivity duration.
+ */
+//--------------------------------------------------------------------------------------------------
+void dtls_SetNatTimeout
+(
+    uint32_t timeout                    ///< [IN] Inactivity duration in seconds
+);
 /**
   * @}
   */
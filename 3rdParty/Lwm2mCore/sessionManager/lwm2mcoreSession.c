@@ -1232,6 +1232,21 @@ void lwm2mcore_SetPushCallback
     lwm2m_set_push_callback(PushCallbackHandler);
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function to set the inactivity duration after which the DTLS session is resumed before sending
+ * data. Setting 0 keeps the idle connection as it is.
+ */
+//--------------------------------------------------------------------------------------------------
+void lwm2mcore_SetDtlsNatTimeout
+(
+    uint32_t timeout                    ///< [IN] Inactivity duration in seconds
+)
+{
+    LOG_ARG("DTLS NAT timeout %u", timeout);
+    dtls_SetNatTimeout(timeout);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to push data to lwm2mCore
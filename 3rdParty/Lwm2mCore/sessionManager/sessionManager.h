@@ -29,6 +29,8 @@
 typedef struct
 {
     struct _lwm2mcore_objectsList objects_list;     ///< list of supported objects
+    lwm2mcore_internalObject_t** objectIndexPtr;    ///< objects_list sorted by object id
+    uint16_t objectIndexCount;                      ///< number of entries in objectIndexPtr
 }lwm2mcore_context_t;
 
 
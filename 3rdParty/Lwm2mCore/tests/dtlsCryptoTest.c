@@ -0,0 +1,439 @@
+//-------------------------------------------------------------------------------------------------
+/**
+ * @file dtlsCryptoTest.c
+ *
+ * Known answer tests and throughput of the tinydtls AES and SHA-256 implementations.
+ *
+ * The AES block cipher, the AES-CCM encryption of the DTLS records and the SHA-256 hash are
+ * checked against the test vectors of FIPS-197, RFC 3610 and FIPS 180-2, first with the portable
+ * implementation then with the instructions of the CPU when they are available. Both
+ * implementations are then compared on random inputs and their throughputs are measured.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "crypto.h"
+#include "ccm.h"
+#include "tests/ccm-testdata.c"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro definition for assert.
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_FATAL(formatString, ...) \
+        { printf(formatString, ##__VA_ARGS__); exit(EXIT_FAILURE); }
+
+#define TEST_ASSERT(condition) \
+        if (!(condition)) { TEST_FATAL("Assert Failed: '%s'\n", #condition) }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of random inputs on which both implementations are compared
+ */
+//--------------------------------------------------------------------------------------------------
+#define RANDOM_COUNT        1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffer hashed or encrypted by the throughput measures: a CoAP block of 1 KB
+ */
+//--------------------------------------------------------------------------------------------------
+#define BENCH_SIZE          1024
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Minimal duration of a throughput measure in milliseconds
+ */
+//--------------------------------------------------------------------------------------------------
+#define BENCH_DURATION      200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length of the DTLS 1.2 AES-CCM additional data and of the record key
+ */
+//--------------------------------------------------------------------------------------------------
+#define CCM_AAD_LEN         13
+#define CCM_KEY_LEN         16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Throughput of the implementations, in MB/s
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    double aesBlock;        ///< AES block encryption
+    double ccmRecord;       ///< AES-CCM encryption of a DTLS record
+    double sha256;          ///< SHA-256 hash
+}
+Throughput_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the monotonic time in milliseconds
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetTimeMs
+(
+    void
+)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Select the implementation used by rijndael and SHA-256
+ *
+ * @return
+ *  - true if the instructions of the CPU are used
+ */
+//--------------------------------------------------------------------------------------------------
+static bool UseCpu
+(
+    bool enable
+)
+{
+    int aes = rijndael_use_cpu(enable);
+    int sha = dtls_sha256_use_cpu(enable);
+    return aes || sha;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill a buffer with pseudo-random bytes
+ */
+//--------------------------------------------------------------------------------------------------
+static void FillRandom
+(
+    uint8_t* bufferPtr,
+    size_t length
+)
+{
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        bufferPtr[i] = (uint8_t)rand();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash a buffer with SHA-256
+ */
+//--------------------------------------------------------------------------------------------------
+static void Sha256
+(
+    const uint8_t* dataPtr,
+    size_t length,
+    uint8_t digest[DTLS_SHA256_DIGEST_LENGTH]
+)
+{
+    dtls_sha256_ctx ctx;
+    dtls_sha256_init(&ctx);
+    dtls_sha256_update(&ctx, dataPtr, length);
+    dtls_sha256_final(digest, &ctx);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * AES known answer test: FIPS-197 appendix C.1
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestAesKat
+(
+    void
+)
+{
+    static const uint8_t key[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    };
+    static const uint8_t plain[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+    };
+    static const uint8_t cipher[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+        0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+    };
+    rijndael_ctx ctx;
+    uint8_t out[16];
+
+    TEST_ASSERT(0 == rijndael_set_key_enc_only(&ctx, key, 128));
+    rijndael_encrypt(&ctx, plain, out);
+    TEST_ASSERT(0 == memcmp(out, cipher, sizeof(cipher)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * AES-CCM known answer test: packet vectors of RFC 3610
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestCcmKat
+(
+    void
+)
+{
+    uint8_t msg[sizeof(data[0].msg) + DTLS_CCM_MAX];
+    rijndael_ctx ctx;
+    long int len;
+    size_t i;
+
+    for (i = 0; i < sizeof(data) / sizeof(data[0]); i++)
+    {
+        memcpy(msg, data[i].msg, data[i].lm);
+        TEST_ASSERT(0 == rijndael_set_key_enc_only(&ctx, data[i].key, 8 * sizeof(data[i].key)));
+
+        len = dtls_ccm_encrypt_message(&ctx, data[i].M, data[i].L, data[i].nonce,
+                                       msg + data[i].la, data[i].lm - data[i].la,
+                                       msg, data[i].la);
+        TEST_ASSERT((size_t)len + data[i].la == data[i].r_lm);
+        TEST_ASSERT(0 == memcmp(msg, data[i].result, data[i].r_lm));
+
+        len = dtls_ccm_decrypt_message(&ctx, data[i].M, data[i].L, data[i].nonce,
+                                       msg + data[i].la, data[i].r_lm - data[i].la,
+                                       msg, data[i].la);
+        TEST_ASSERT((size_t)len == data[i].lm - data[i].la);
+        TEST_ASSERT(0 == memcmp(msg, data[i].msg, data[i].lm));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SHA-256 known answer tests: FIPS 180-2 appendix B, hashed at once and byte per byte
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestSha256Kat
+(
+    void
+)
+{
+    static const char* messages[] = {
+        "abc",
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+        ""
+    };
+    static const uint8_t digests[][DTLS_SHA256_DIGEST_LENGTH] = {
+        { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae,
+          0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61,
+          0xf2, 0x00, 0x15, 0xad },
+        { 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e,
+          0x60, 0x39, 0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4,
+          0x19, 0xdb, 0x06, 0xc1 },
+        { 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f,
+          0xb9, 0x24, 0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b,
+          0x78, 0x52, 0xb8, 0x55 }
+    };
+    static const uint8_t millionDigest[DTLS_SHA256_DIGEST_LENGTH] = {
+        0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7,
+        0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc,
+        0xc7, 0x11, 0x2c, 0xd0
+    };
+    uint8_t digest[DTLS_SHA256_DIGEST_LENGTH];
+    uint8_t block[1000];
+    dtls_sha256_ctx ctx;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < sizeof(messages) / sizeof(messages[0]); i++)
+    {
+        Sha256((const uint8_t*)messages[i], strlen(messages[i]), digest);
+        TEST_ASSERT(0 == memcmp(digest, digests[i], sizeof(digest)));
+
+        dtls_sha256_init(&ctx);
+        for (j = 0; j < strlen(messages[i]); j++)
+        {
+            dtls_sha256_update(&ctx, (const uint8_t*)&messages[i][j], 1);
+        }
+        dtls_sha256_final(digest, &ctx);
+        TEST_ASSERT(0 == memcmp(digest, digests[i], sizeof(digest)));
+    }
+
+    // One million 'a'
+    memset(block, 'a', sizeof(block));
+    dtls_sha256_init(&ctx);
+    for (i = 0; i < 1000; i++)
+    {
+        dtls_sha256_update(&ctx, block, sizeof(block));
+    }
+    dtls_sha256_final(digest, &ctx);
+    TEST_ASSERT(0 == memcmp(digest, millionDigest, sizeof(digest)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compare the results of the portable implementation and of the CPU instructions on random
+ * keys, records and messages
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRandom
+(
+    void
+)
+{
+    uint8_t key[CCM_KEY_LEN];
+    uint8_t nonce[DTLS_CCM_BLOCKSIZE];
+    uint8_t aad[CCM_AAD_LEN];
+    uint8_t plain[BENCH_SIZE];
+    uint8_t portable[BENCH_SIZE + DTLS_CCM_MAX];
+    uint8_t cpu[BENCH_SIZE + DTLS_CCM_MAX];
+    uint8_t portableDigest[DTLS_SHA256_DIGEST_LENGTH];
+    uint8_t cpuDigest[DTLS_SHA256_DIGEST_LENGTH];
+    int portableLen;
+    int cpuLen;
+    size_t length;
+    int i;
+
+    for (i = 0; i < RANDOM_COUNT; i++)
+    {
+        FillRandom(key, sizeof(key));
+        FillRandom(nonce, sizeof(nonce));
+        FillRandom(aad, sizeof(aad));
+        length = (size_t)rand() % (sizeof(plain) + 1);
+        FillRandom(plain, length);
+
+        UseCpu(false);
+        portableLen = dtls_encrypt(plain, length, portable, nonce, key, sizeof(key),
+                                   aad, sizeof(aad));
+        Sha256(plain, length, portableDigest);
+
+        UseCpu(true);
+        cpuLen = dtls_encrypt(plain, length, cpu, nonce, key, sizeof(key), aad, sizeof(aad));
+        Sha256(plain, length, cpuDigest);
+
+        TEST_ASSERT(portableLen == cpuLen);
+        TEST_ASSERT(0 == memcmp(portable, cpu, (size_t)cpuLen));
+        TEST_ASSERT(0 == memcmp(portableDigest, cpuDigest, sizeof(cpuDigest)));
+
+        // Records encrypted by one implementation are decrypted by the other one
+        TEST_ASSERT((int)length == dtls_decrypt(portable, (size_t)portableLen, portable, nonce,
+                                                key, sizeof(key), aad, sizeof(aad)));
+        TEST_ASSERT(0 == memcmp(portable, plain, length));
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Measure the throughput of the selected implementation
+ */
+//--------------------------------------------------------------------------------------------------
+static void Measure
+(
+    Throughput_t* throughputPtr
+)
+{
+    static uint8_t buffer[BENCH_SIZE + DTLS_CCM_MAX];
+    uint8_t key[CCM_KEY_LEN];
+    uint8_t nonce[DTLS_CCM_BLOCKSIZE];
+    uint8_t aad[CCM_AAD_LEN];
+    uint8_t digest[DTLS_SHA256_DIGEST_LENGTH];
+    rijndael_ctx ctx;
+    double start;
+    double elapsed;
+    unsigned long count;
+    size_t i;
+
+    FillRandom(key, sizeof(key));
+    FillRandom(nonce, sizeof(nonce));
+    FillRandom(aad, sizeof(aad));
+    FillRandom(buffer, sizeof(buffer));
+
+    TEST_ASSERT(0 == rijndael_set_key_enc_only(&ctx, key, 8 * sizeof(key)));
+    start = GetTimeMs();
+    count = 0;
+    do
+    {
+        for (i = 0; i < BENCH_SIZE; i += DTLS_CCM_BLOCKSIZE)
+        {
+            rijndael_encrypt(&ctx, buffer + i, buffer + i);
+        }
+        count++;
+        elapsed = GetTimeMs() - start;
+    }
+    while (elapsed < BENCH_DURATION);
+    throughputPtr->aesBlock = count * BENCH_SIZE / (elapsed * 1000.0);
+
+    start = GetTimeMs();
+    count = 0;
+    do
+    {
+        TEST_ASSERT(0 < dtls_encrypt(buffer, BENCH_SIZE, buffer, nonce, key, sizeof(key),
+                                     aad, sizeof(aad)));
+        count++;
+        elapsed = GetTimeMs() - start;
+    }
+    while (elapsed < BENCH_DURATION);
+    throughputPtr->ccmRecord = count * BENCH_SIZE / (elapsed * 1000.0);
+
+    start = GetTimeMs();
+    count = 0;
+    do
+    {
+        Sha256(buffer, BENCH_SIZE, digest);
+        count++;
+        elapsed = GetTimeMs() - start;
+    }
+    while (elapsed < BENCH_DURATION);
+    throughputPtr->sha256 = count * BENCH_SIZE / (elapsed * 1000.0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main function
+ */
+//--------------------------------------------------------------------------------------------------
+int main
+(
+    void
+)
+{
+    Throughput_t portable;
+    Throughput_t cpu;
+    bool cpuUsed;
+
+    srand(1);
+
+    // Known answers of the portable implementation
+    UseCpu(false);
+    TestAesKat();
+    TestCcmKat();
+    TestSha256Kat();
+    Measure(&portable);
+
+    // Known answers of the CPU instructions, if any
+    cpuUsed = UseCpu(true);
+    printf("AES: %s, SHA-256: %s\n", rijndael_use_cpu(true) ? "CPU" : "portable",
+           dtls_sha256_use_cpu(true) ? "CPU" : "portable");
+    TestAesKat();
+    TestCcmKat();
+    TestSha256Kat();
+    Measure(&cpu);
+    printf("Known answer tests passed\n");
+
+    TestRandom();
+    printf("Portable and CPU implementations match on %d random inputs\n", RANDOM_COUNT);
+
+    printf("Throughput on %d bytes:     portable       CPU\n", BENCH_SIZE);
+    printf("  AES-128 blocks:           %7.1f MB/s %7.1f MB/s\n", portable.aesBlock,
+           cpu.aesBlock);
+    printf("  AES-CCM DTLS records:     %7.1f MB/s %7.1f MB/s\n", portable.ccmRecord,
+           cpu.ccmRecord);
+    printf("  SHA-256:                  %7.1f MB/s %7.1f MB/s\n", portable.sha256, cpu.sha256);
+    if (!cpuUsed)
+    {
+        printf("No AES or SHA-256 instructions on this CPU: both measures use the portable code\n");
+    }
+
+    return EXIT_SUCCESS;
+}
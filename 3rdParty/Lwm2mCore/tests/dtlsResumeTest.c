@@ -0,0 +1,615 @@
+//-------------------------------------------------------------------------------------------------
+/**
+ * @file dtlsResumeTest.c
+ *
+ * Loopback test of the DTLS session resumption.
+ *
+ * A DTLS 1.2 PSK server with a session cache is started on the loopback interface and the
+ * tinydtls client connects to it several times, each time from a new DTLS context and a new UDP
+ * port as after a restart of the client. For each connection, the handshake type reported by the
+ * server, the number of datagrams exchanged and the time to the first CoAP response are measured.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include "dtls.h"
+#include "dtls_debug.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Macro definition for assert.
+ */
+//--------------------------------------------------------------------------------------------------
+#define TEST_FATAL(formatString, ...) \
+        { printf(formatString, ##__VA_ARGS__); exit(EXIT_FAILURE); }
+
+#define TEST_ASSERT(condition) \
+        if (!(condition)) { TEST_FATAL("Assert Failed: '%s'\n", #condition) }
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * PSK identity and key shared by the client and the server
+ */
+//--------------------------------------------------------------------------------------------------
+#define PSK_IDENTITY        "dtlsResumeTest"
+#define PSK_KEY             "0123456789ABCDEF"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Cipher suite used by the server: the one used by the client with a PSK
+ */
+//--------------------------------------------------------------------------------------------------
+#define SERVER_CIPHER_LIST  "PSK-AES128-CCM8:@SECLEVEL=0"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timeout in seconds of one connection
+ */
+//--------------------------------------------------------------------------------------------------
+#define CONNECTION_TIMEOUT  5
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of connections of each kind used to compute the mean values
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOOP_COUNT          20
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffers
+ */
+//--------------------------------------------------------------------------------------------------
+#define BUFFER_SIZE         1500
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP payloads sent back by the server, depending on the handshake done for the connection
+ */
+//--------------------------------------------------------------------------------------------------
+#define PAYLOAD_FULL        "full"
+#define PAYLOAD_RESUMED     "resumed"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Measures of one connection
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool     connected;                 ///< Handshake completed
+    bool     resumed;                   ///< Abbreviated handshake reported by the server
+    bool     responseReceived;          ///< CoAP response received
+    uint32_t sentCount;                 ///< Number of datagrams sent by the client
+    uint32_t receivedCount;             ///< Number of datagrams received by the client
+    double   responseTimeMs;            ///< Time to the first CoAP response in milliseconds
+}
+ConnectionResult_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client context, given as application data to the DTLS context
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    int                 sock;           ///< Client socket
+    ConnectionResult_t* resultPtr;      ///< Measures of the connection
+}
+ClientContext_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the monotonic time in milliseconds
+ */
+//--------------------------------------------------------------------------------------------------
+static double GetTimeMs
+(
+    void
+)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server: PSK callback
+ */
+//--------------------------------------------------------------------------------------------------
+static unsigned int ServerPskCb
+(
+    SSL* sslPtr,
+    const char* identityPtr,
+    unsigned char* pskPtr,
+    unsigned int maxPskLen
+)
+{
+    (void)sslPtr;
+
+    if ((!identityPtr) || strcmp(identityPtr, PSK_IDENTITY) || (maxPskLen < strlen(PSK_KEY)))
+    {
+        return 0;
+    }
+    memcpy(pskPtr, PSK_KEY, strlen(PSK_KEY));
+    return strlen(PSK_KEY);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server: cookie generation callback. A constant cookie is enough on the loopback interface.
+ */
+//--------------------------------------------------------------------------------------------------
+static int ServerGenerateCookieCb
+(
+    SSL* sslPtr,
+    unsigned char* cookiePtr,
+    unsigned int* cookieLenPtr
+)
+{
+    (void)sslPtr;
+    memset(cookiePtr, 0xA5, DTLS_COOKIE_LENGTH);
+    *cookieLenPtr = DTLS_COOKIE_LENGTH;
+    return 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server: cookie verification callback
+ */
+//--------------------------------------------------------------------------------------------------
+static int ServerVerifyCookieCb
+(
+    SSL* sslPtr,
+    const unsigned char* cookiePtr,
+    unsigned int cookieLen
+)
+{
+    unsigned char cookie[DTLS_COOKIE_LENGTH];
+    unsigned int len;
+
+    ServerGenerateCookieCb(sslPtr, cookie, &len);
+    return ((cookieLen == len) && (0 == memcmp(cookie, cookiePtr, len)));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Server: serve the connections until the socket times out.
+ *
+ * For each connection, the CoAP request is answered with a payload telling if the session was
+ * resumed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunServer
+(
+    int sock
+)
+{
+    // The version specific method is used so that the HelloVerifyRequest is sent in a DTLS 1.2
+    // record, the only version accepted by tinydtls
+    SSL_CTX* ctxPtr = SSL_CTX_new(DTLSv1_2_server_method());
+    struct timeval timeout = { CONNECTION_TIMEOUT, 0 };
+    static const unsigned char sessionIdContext[] = "dtlsResumeTest";
+
+    TEST_ASSERT(ctxPtr);
+    SSL_CTX_set_min_proto_version(ctxPtr, DTLS1_2_VERSION);
+    TEST_ASSERT(SSL_CTX_set_cipher_list(ctxPtr, SERVER_CIPHER_LIST));
+    SSL_CTX_set_psk_server_callback(ctxPtr, ServerPskCb);
+    SSL_CTX_set_cookie_generate_cb(ctxPtr, ServerGenerateCookieCb);
+    SSL_CTX_set_cookie_verify_cb(ctxPtr, ServerVerifyCookieCb);
+    SSL_CTX_set_session_cache_mode(ctxPtr, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_set_session_id_context(ctxPtr, sessionIdContext, sizeof(sessionIdContext) - 1);
+    SSL_CTX_set_options(ctxPtr, SSL_OP_NO_TICKET);
+    SSL_CTX_set_read_ahead(ctxPtr, 1);
+
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    for (;;)
+    {
+        BIO_ADDR* clientAddrPtr = BIO_ADDR_new();
+        BIO* bioPtr = BIO_new_dgram(sock, BIO_NOCLOSE);
+        SSL* sslPtr = SSL_new(ctxPtr);
+        uint8_t request[BUFFER_SIZE];
+        uint8_t response[BUFFER_SIZE];
+        const char* payloadPtr;
+        int len;
+        int rc;
+
+        SSL_set_bio(sslPtr, bioPtr, bioPtr);
+        SSL_set_options(sslPtr, SSL_OP_COOKIE_EXCHANGE);
+
+        do
+        {
+            rc = DTLSv1_listen(sslPtr, clientAddrPtr);
+        }
+        while (0 == rc);
+
+        if (rc < 0)
+        {
+            // No more clients
+            SSL_free(sslPtr);
+            BIO_ADDR_free(clientAddrPtr);
+            break;
+        }
+
+        BIO_ctrl(bioPtr, BIO_CTRL_DGRAM_SET_PEER, 0, clientAddrPtr);
+
+        if ((SSL_accept(sslPtr) > 0) && ((len = SSL_read(sslPtr, request, sizeof(request))) >= 4))
+        {
+            payloadPtr = SSL_session_reused(sslPtr) ? PAYLOAD_RESUMED : PAYLOAD_FULL;
+
+            // CoAP ACK 2.05 Content with the message id of the request
+            response[0] = 0x60;
+            response[1] = 0x45;
+            response[2] = request[2];
+            response[3] = request[3];
+            response[4] = 0xFF;
+            memcpy(response + 5, payloadPtr, strlen(payloadPtr));
+            SSL_write(sslPtr, response, 5 + strlen(payloadPtr));
+        }
+        else
+        {
+            ERR_print_errors_fp(stdout);
+        }
+
+        SSL_shutdown(sslPtr);
+        SSL_free(sslPtr);
+        BIO_ADDR_free(clientAddrPtr);
+    }
+
+    SSL_CTX_free(ctxPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client: send a DTLS record to the server
+ */
+//--------------------------------------------------------------------------------------------------
+static int ClientWriteCb
+(
+    struct dtls_context_t* ctxPtr,
+    session_t* sessionPtr,
+    uint8* bufferPtr,
+    size_t len
+)
+{
+    ClientContext_t* clientPtr = (ClientContext_t*)dtls_get_app_data(ctxPtr);
+
+    clientPtr->resultPtr->sentCount++;
+    return sendto(clientPtr->sock, bufferPtr, len, MSG_DONTWAIT,
+                  &sessionPtr->addr.sa, sessionPtr->size);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client: application data received from the server
+ */
+//--------------------------------------------------------------------------------------------------
+static int ClientReadCb
+(
+    struct dtls_context_t* ctxPtr,
+    session_t* sessionPtr,
+    uint8* bufferPtr,
+    size_t len
+)
+{
+    ClientContext_t* clientPtr = (ClientContext_t*)dtls_get_app_data(ctxPtr);
+    (void)sessionPtr;
+
+    if ((len > 5) && (0x45 == bufferPtr[1]) && (0xFF == bufferPtr[4])
+     && (!clientPtr->resultPtr->responseReceived))
+    {
+        clientPtr->resultPtr->responseReceived = true;
+        clientPtr->resultPtr->resumed = ((len - 5) == strlen(PAYLOAD_RESUMED))
+                                        && (0 == memcmp(bufferPtr + 5, PAYLOAD_RESUMED, len - 5));
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client: DTLS events
+ */
+//--------------------------------------------------------------------------------------------------
+static int ClientEventCb
+(
+    struct dtls_context_t* ctxPtr,
+    session_t* sessionPtr,
+    dtls_alert_level_t level,
+    unsigned short code
+)
+{
+    ClientContext_t* clientPtr = (ClientContext_t*)dtls_get_app_data(ctxPtr);
+    (void)sessionPtr;
+    (void)level;
+
+    if (DTLS_EVENT_CONNECTED == code)
+    {
+        clientPtr->resultPtr->connected = true;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client: PSK information
+ */
+//--------------------------------------------------------------------------------------------------
+static int ClientGetPskInfoCb
+(
+    struct dtls_context_t* ctxPtr,
+    const session_t* sessionPtr,
+    dtls_credentials_type_t type,
+    const unsigned char* descPtr,
+    size_t descLen,
+    unsigned char* resultPtr,
+    size_t resultLen
+)
+{
+    (void)ctxPtr;
+    (void)sessionPtr;
+    (void)descPtr;
+    (void)descLen;
+
+    switch (type)
+    {
+        case DTLS_PSK_IDENTITY:
+            if (resultLen < strlen(PSK_IDENTITY))
+            {
+                break;
+            }
+            memcpy(resultPtr, PSK_IDENTITY, strlen(PSK_IDENTITY));
+            return strlen(PSK_IDENTITY);
+
+        case DTLS_PSK_KEY:
+            if (resultLen < strlen(PSK_KEY))
+            {
+                break;
+            }
+            memcpy(resultPtr, PSK_KEY, strlen(PSK_KEY));
+            return strlen(PSK_KEY);
+
+        default:
+            break;
+    }
+    return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Client: connect to the server from a new DTLS context and a new socket, send a CoAP request and
+ * wait for the response.
+ *
+ * If resumeInPtr is set, the session is resumed. If resumeOutPtr is set, it is filled with the
+ * session established with the server.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunClient
+(
+    const struct sockaddr_in* serverAddrPtr,    ///< [IN] Server address
+    const dtls_resumption_t* resumeInPtr,       ///< [IN] Session to resume, or NULL
+    dtls_resumption_t* resumeOutPtr,            ///< [OUT] Established session, or NULL
+    ConnectionResult_t* resultPtr               ///< [OUT] Measures of the connection
+)
+{
+    static dtls_handler_t handlers =
+    {
+        .write = ClientWriteCb,
+        .read = ClientReadCb,
+        .event = ClientEventCb,
+        .get_psk_info = ClientGetPskInfoCb,
+    };
+    // CoAP CON GET request
+    uint8_t request[] = { 0x40, 0x01, 0x12, 0x34 };
+    ClientContext_t client;
+    dtls_context_t* ctxPtr;
+    session_t session;
+    bool requestSent = false;
+    double startMs;
+    double endMs;
+
+    memset(resultPtr, 0, sizeof(ConnectionResult_t));
+    client.resultPtr = resultPtr;
+    client.sock = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT(client.sock >= 0);
+
+    memset(&session, 0, sizeof(session));
+    session.size = sizeof(struct sockaddr_in);
+    memcpy(&session.addr.sin, serverAddrPtr, sizeof(struct sockaddr_in));
+
+    ctxPtr = dtls_new_context(&client);
+    TEST_ASSERT(ctxPtr);
+    dtls_set_handler(ctxPtr, &handlers);
+
+    startMs = GetTimeMs();
+    endMs = startMs + CONNECTION_TIMEOUT * 1000;
+
+    if (resumeInPtr)
+    {
+        TEST_ASSERT(dtls_resume_session(ctxPtr, &session, resumeInPtr) > 0);
+    }
+    else
+    {
+        TEST_ASSERT(dtls_connect(ctxPtr, &session) > 0);
+    }
+
+    while ((!resultPtr->responseReceived) && (GetTimeMs() < endMs))
+    {
+        struct pollfd fds = { client.sock, POLLIN, 0 };
+        clock_time_t next = 0;
+
+        if (resultPtr->connected && !requestSent)
+        {
+            TEST_ASSERT(dtls_write(ctxPtr, &session, request, sizeof(request)) > 0);
+            requestSent = true;
+        }
+
+        if (poll(&fds, 1, 100) > 0)
+        {
+            uint8_t buffer[BUFFER_SIZE];
+            session_t from;
+            int len;
+
+            memset(&from, 0, sizeof(from));
+            from.size = sizeof(from.addr);
+            len = recvfrom(client.sock, buffer, sizeof(buffer), 0, &from.addr.sa, &from.size);
+            if (len > 0)
+            {
+                resultPtr->receivedCount++;
+                dtls_handle_message(ctxPtr, &from, buffer, len);
+            }
+        }
+        else
+        {
+            dtls_check_retransmit(ctxPtr, &next);
+        }
+    }
+
+    resultPtr->responseTimeMs = GetTimeMs() - startMs;
+
+    if (resumeOutPtr)
+    {
+        TEST_ASSERT(0 == dtls_get_resumption(ctxPtr, &session, resumeOutPtr));
+    }
+
+    dtls_free_context(ctxPtr);
+    close(client.sock);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Display the measures of a connection
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintResult
+(
+    const char* namePtr,
+    const ConnectionResult_t* resultPtr
+)
+{
+    printf("%-28s %-8s handshake, %2u datagrams sent, %2u received, first response in %.2f ms\n",
+           namePtr,
+           resultPtr->responseReceived ? (resultPtr->resumed ? "resumed" : "full") : "failed",
+           resultPtr->sentCount,
+           resultPtr->receivedCount,
+           resultPtr->responseTimeMs);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main function
+ */
+//--------------------------------------------------------------------------------------------------
+int main
+(
+    void
+)
+{
+    struct sockaddr_in serverAddr;
+    socklen_t serverAddrLen = sizeof(serverAddr);
+    dtls_resumption_t resumption;
+    dtls_resumption_t resumedSession;
+    dtls_resumption_t unknownSession;
+    ConnectionResult_t result;
+    ConnectionResult_t fullTotal;
+    ConnectionResult_t resumedTotal;
+    int serverSock;
+    int status;
+    pid_t serverPid;
+    int i;
+
+    // Server socket on an ephemeral loopback port
+    serverSock = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT(serverSock >= 0);
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT(0 == bind(serverSock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)));
+    TEST_ASSERT(0 == getsockname(serverSock, (struct sockaddr*)&serverAddr, &serverAddrLen));
+
+    serverPid = fork();
+    TEST_ASSERT(serverPid >= 0);
+    if (0 == serverPid)
+    {
+        RunServer(serverSock);
+        exit(EXIT_SUCCESS);
+    }
+    close(serverSock);
+
+    dtls_init();
+    dtls_set_log_level(DTLS_LOG_WARN);
+
+    // First connection: full handshake
+    RunClient(&serverAddr, NULL, &resumption, &result);
+    PrintResult("First connection:", &result);
+    TEST_ASSERT(result.responseReceived);
+    TEST_ASSERT(!result.resumed);
+
+    // Connection after a restart of the client: abbreviated handshake, the session is unchanged
+    RunClient(&serverAddr, &resumption, &resumedSession, &result);
+    PrintResult("Resumed after restart:", &result);
+    TEST_ASSERT(result.responseReceived);
+    TEST_ASSERT(result.resumed);
+    TEST_ASSERT(0 == memcmp(&resumedSession, &resumption, sizeof(resumption)));
+
+    // Session unknown by the server: fall back to a full handshake
+    memcpy(&unknownSession, &resumption, sizeof(unknownSession));
+    unknownSession.session_id.id[0] ^= 0xFF;
+    RunClient(&serverAddr, &unknownSession, NULL, &result);
+    PrintResult("Unknown session:", &result);
+    TEST_ASSERT(result.responseReceived);
+    TEST_ASSERT(!result.resumed);
+
+    // Mean values
+    memset(&fullTotal, 0, sizeof(fullTotal));
+    memset(&resumedTotal, 0, sizeof(resumedTotal));
+    for (i = 0; i < LOOP_COUNT; i++)
+    {
+        RunClient(&serverAddr, NULL, NULL, &result);
+        TEST_ASSERT(result.responseReceived && !result.resumed);
+        fullTotal.sentCount += result.sentCount;
+        fullTotal.receivedCount += result.receivedCount;
+        fullTotal.responseTimeMs += result.responseTimeMs;
+
+        RunClient(&serverAddr, &resumption, NULL, &result);
+        TEST_ASSERT(result.responseReceived && result.resumed);
+        resumedTotal.sentCount += result.sentCount;
+        resumedTotal.receivedCount += result.receivedCount;
+        resumedTotal.responseTimeMs += result.responseTimeMs;
+    }
+
+    printf("Mean over %d connections:\n", LOOP_COUNT);
+    printf("  full handshake:    %.1f datagrams sent, %.1f received, first response in %.2f ms\n",
+           (double)fullTotal.sentCount / LOOP_COUNT,
+           (double)fullTotal.receivedCount / LOOP_COUNT,
+           fullTotal.responseTimeMs / LOOP_COUNT);
+    printf("  resumed handshake: %.1f datagrams sent, %.1f received, first response in %.2f ms\n",
+           (double)resumedTotal.sentCount / LOOP_COUNT,
+           (double)resumedTotal.receivedCount / LOOP_COUNT,
+           resumedTotal.responseTimeMs / LOOP_COUNT);
+    TEST_ASSERT(resumedTotal.sentCount < fullTotal.sentCount);
+
+    kill(serverPid, SIGTERM);
+    waitpid(serverPid, &status, 0);
+
+    printf("DTLS resumption test OK\n");
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <time.h>
 #include "internals.h"
 #include "liblwm2m.h"
 #include <lwm2mcore/lwm2mcore.h>
@@ -36,6 +37,20 @@
 //--------------------------------------------------------------------------------------------------
 #define MAX_LEN_PAYLOAD  100
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of read requests on every registered object instance for the request rate test.
+ */
+//--------------------------------------------------------------------------------------------------
+#define REQUEST_RATE_LOOP_COUNT  200
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resource Id which is not supported by any object.
+ */
+//--------------------------------------------------------------------------------------------------
+#define UNKNOWN_RESOURCE_ID  0xFFFE
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -251,6 +266,98 @@ static void test_lwm2mcore_Push
                                LWM2MCORE_PUSH_CONTENT_CBOR, &midPtr) == LWM2MCORE_PUSH_INITIATED);
 }
 
+//-------------------------------------------------------------------------------------------------
+/**
+ * Send a read request on an object instance, as Wakaama does when a CoAP GET is received.
+ *
+ * @return
+ *      - CoAP result of the read callback
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t ReadRequest
+(
+    lwm2m_object_t* objectPtr,      ///< [IN] Object
+    uint16_t oiid,                  ///< [IN] Object instance Id
+    int resourceId                  ///< [IN] Resource Id, or -1 to read the full object instance
+)
+{
+    uint8_t result;
+    int numData = 0;
+    lwm2m_data_t* dataArrayPtr = NULL;
+
+    if (0 <= resourceId)
+    {
+        numData = 1;
+        dataArrayPtr = lwm2m_data_new(numData);
+        TEST_ASSERT(NULL != dataArrayPtr);
+        dataArrayPtr->id = (uint16_t)resourceId;
+    }
+
+    result = objectPtr->readFunc(oiid, &numData, &dataArrayPtr, objectPtr);
+    lwm2m_data_free(numData, dataArrayPtr);
+    return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+/**
+ * Test the object and resource lookup, and measure the read request rate of the object manager
+ */
+//--------------------------------------------------------------------------------------------------
+static void test_omanager_RequestRate
+(
+    void
+)
+{
+    smanager_ClientData_t* dataPtr = (smanager_ClientData_t*)Lwm2mcoreRef;
+    lwm2m_object_t* objectPtr;
+    lwm2m_list_t* instancePtr;
+    struct timespec start;
+    struct timespec end;
+    double elapsedSec;
+    uint32_t requestCount = 0;
+    int i;
+
+    TEST_ASSERT(NULL != dataPtr);
+
+    /* A resource which is not registered is not found, whatever the object */
+    for (objectPtr = dataPtr->lwm2mHPtr->objectList; objectPtr; objectPtr = objectPtr->next)
+    {
+        if ((NULL != objectPtr->readFunc) && (NULL != objectPtr->instanceList))
+        {
+            TEST_ASSERT(ReadRequest(objectPtr, objectPtr->instanceList->id, UNKNOWN_RESOURCE_ID)
+                        == COAP_404_NOT_FOUND);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < REQUEST_RATE_LOOP_COUNT; i++)
+    {
+        for (objectPtr = dataPtr->lwm2mHPtr->objectList; objectPtr; objectPtr = objectPtr->next)
+        {
+            if (NULL == objectPtr->readFunc)
+            {
+                continue;
+            }
+
+            for (instancePtr = objectPtr->instanceList;
+                 instancePtr;
+                 instancePtr = instancePtr->next)
+            {
+                ReadRequest(objectPtr, instancePtr->id, -1);
+                requestCount++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsedSec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    TEST_ASSERT(0 != requestCount);
+    printf("%u read requests in %.3f s: %.0f requests/s\n",
+           requestCount, elapsedSec, (elapsedSec > 0) ? requestCount / elapsedSec : 0);
+}
+
 //-------------------------------------------------------------------------------------------------
 /**
  * Test function for lwm2m_connect_server API
@@ -423,6 +530,9 @@ int main
     printf("======== test of lwm2mcore_Push() ========\n");
     test_lwm2mcore_Push();
 
+    printf("======== test of object manager request rate ========\n");
+    test_omanager_RequestRate();
+
     printf("======== test of lwm2m_connect_server() ========\n");
     test_lwm2m_connect_server();
 
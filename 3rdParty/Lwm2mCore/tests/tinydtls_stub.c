@@ -120,3 +120,29 @@ int dtls_resume
     (void)dst;
     return -1;
 };
+
+int dtls_get_resumption
+(
+    dtls_context_t* ctx,
+    const session_t* dst,
+    dtls_resumption_t* resumption
+)
+{
+    (void)ctx;
+    (void)dst;
+    (void)resumption;
+    return -1;
+}
+
+int dtls_resume_session
+(
+    dtls_context_t* ctx,
+    const session_t* dst,
+    const dtls_resumption_t* resumption
+)
+{
+    (void)ctx;
+    (void)dst;
+    (void)resumption;
+    return -1;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file bsdiff.h
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef BSDIFF_INCLUDE_GUARD
+#define BSDIFF_INCLUDE_GUARD
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Suffix array of an original image, shared by all the patches computed against this image
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct bsDiffIndex bsDiffIndex_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the suffix array of an original image.
+ *
+ * @return
+ *      - Pointer to the index, or NULL if there is not enough memory
+ */
+//--------------------------------------------------------------------------------------------------
+bsDiffIndex_t *bsDiffCreateIndex
+(
+    const uint8_t *oldPtr,  ///< [IN] Original image. Must stay valid as long as the index is used
+    off_t oldsize           ///< [IN] Size of the original image
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release an index built by bsDiffCreateIndex().
+ */
+//--------------------------------------------------------------------------------------------------
+void bsDiffDeleteIndex
+(
+    bsDiffIndex_t *indexPtr ///< [IN] Index to release
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the BSDIFF40 patch from the original image of an index to a new image. The patch is
+ * the same as the one the bsdiff tool writes in a file. This function is reentrant.
+ *
+ * @return
+ *      - LE_OK            On success. The patch must be released with free(3)
+ *      - LE_NO_MEMORY     If there is not enough memory
+ *      - LE_FAULT         On other failures
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t bsDiff
+(
+    const bsDiffIndex_t *indexPtr,
+                            ///< [IN] Index of the original image
+    const uint8_t *newPtr,  ///< [IN] New image
+    off_t newsize,          ///< [IN] Size of the new image
+    uint8_t **patchPtr,     ///< [OUT] Patch
+    size_t *patchLenPtr     ///< [OUT] Length of the patch
+);
+
+#endif // BSDIFF_INCLUDE_GUARD
@@ -62,6 +62,325 @@ static off_t offtin(u_char *buf)
 }
 
 #ifdef SIERRA_BSPATCH
+//--------------------------------------------------------------------------------------------------
+/**
+ * Patch descriptor kept open while the patch segments of an image are applied, and the context it
+ * was opened with. Keeping it open avoids to scan the flash and to restart the I/O for every
+ * segment.
+ */
+//--------------------------------------------------------------------------------------------------
+static pa_patch_Desc_t PatchDesc = NULL;
+static pa_patch_Context_t PatchCtx;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Destination of a patch segment. The destination is built block after block: a block is written
+ * to flash while the next one is decompressed.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_patch_Desc_t desc;       ///< Patch descriptor
+    uint8_t *bufPtr;            ///< Destination buffer being filled, NULL if none
+    off_t blockOffset;          ///< Offset of the buffer in the destination image
+    size_t blockSize;           ///< Size of a destination block
+    size_t fillSize;            ///< Size of the data in the buffer
+    uint32_t *crc32Ptr;         ///< CRC32 of the data patched, may be NULL
+}
+PatchDest_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if two patch contexts concern the same origin and destination images
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSameImage
+(
+    const pa_patch_Context_t *ctx1Ptr,
+    const pa_patch_Context_t *ctx2Ptr
+)
+{
+    return (ctx1Ptr->segmentSize == ctx2Ptr->segmentSize) &&
+           (ctx1Ptr->origImage == ctx2Ptr->origImage) &&
+           (ctx1Ptr->origImageSize == ctx2Ptr->origImageSize) &&
+           (ctx1Ptr->origImageDesc.flash.mtdNum == ctx2Ptr->origImageDesc.flash.mtdNum) &&
+           (ctx1Ptr->origImageDesc.flash.ubiVolId == ctx2Ptr->origImageDesc.flash.ubiVolId) &&
+           (ctx1Ptr->destImage == ctx2Ptr->destImage) &&
+           (ctx1Ptr->destImageDesc.flash.mtdNum == ctx2Ptr->destImageDesc.flash.mtdNum) &&
+           (ctx1Ptr->destImageDesc.flash.ubiVolId == ctx2Ptr->destImageDesc.flash.ubiVolId);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close the patch descriptor
+ *
+ * @return
+ *      - LE_OK            On success, or if no descriptor is open
+ *      - others           Depending of pa_patch_Close
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ClosePatchDesc
+(
+    bool update,            ///< [IN] Update the destination size
+    size_t destSize         ///< [IN] Final size of the destination
+)
+{
+    le_result_t res = LE_OK;
+
+    if( PatchDesc )
+    {
+        res = pa_patch_Close( PatchDesc, update, destSize );
+        PatchDesc = NULL;
+    }
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the patch file at a given offset and start a bzip2 decompression from there
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_FAULT         On failure
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t OpenBzStream
+(
+    const char *patchfile,  ///< [IN] File containing the patch
+    off_t offset,           ///< [IN] Offset of the bzip2 stream
+    FILE **fPtr,            ///< [OUT] Patch file
+    BZFILE **bzPtr          ///< [OUT] Decompression stream
+)
+{
+    int bz2err;
+
+    if ((*fPtr = fopen(patchfile, "r")) == NULL)
+    {
+        LE_ERROR("fopen(%s): %m", patchfile);
+        return LE_FAULT;
+    }
+    if (fseeko(*fPtr, offset, SEEK_SET))
+    {
+        LE_ERROR("fseeko(%s, %lld)", patchfile, (long long)offset);
+        return LE_FAULT;
+    }
+    if ((*bzPtr = BZ2_bzReadOpen(&bz2err, *fPtr, 0, 0, NULL, 0)) == NULL)
+    {
+        LE_ERROR("BZ2_bzReadOpen, bz2err = %d", bz2err);
+        return LE_FAULT;
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a decompression stream and its patch file
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseBzStream
+(
+    FILE **fPtr,            ///< [INOUT] Patch file
+    BZFILE **bzPtr          ///< [INOUT] Decompression stream
+)
+{
+    int bz2err;
+
+    if (*bzPtr)
+    {
+        BZ2_bzReadClose(&bz2err, *bzPtr);
+        *bzPtr = NULL;
+    }
+    if (*fPtr)
+    {
+        fclose(*fPtr);
+        *fPtr = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add the origin data to a diff string. The origin is read by blocks through the read-ahead cache
+ * of the patch descriptor. As in bspatch, data outside the origin image are not added.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - others           Depending of pa_patch_ReadOrigBlock
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddOrigData
+(
+    pa_patch_Desc_t desc,   ///< [IN] Patch descriptor
+    uint8_t *dataPtr,       ///< [INOUT] Diff string
+    size_t size,            ///< [IN] Size of the diff string
+    off_t oldpos,           ///< [IN] Position of the diff string in the origin image
+    off_t oldsize           ///< [IN] Size of the origin image
+)
+{
+    const uint8_t *origPtr;
+    off_t blockOffset;
+    size_t blockSize, len, i;
+    le_result_t res;
+
+    while (size > 0)
+    {
+        if (oldpos < 0)
+        {
+            len = ((off_t)size > -oldpos) ? (size_t)-oldpos : size;
+        }
+        else if (oldpos >= oldsize)
+        {
+            break;
+        }
+        else
+        {
+            res = pa_patch_ReadOrigBlock(desc, oldpos, &origPtr, &blockOffset, &blockSize);
+            if (LE_OK != res)
+            {
+                LE_ERROR("Read of origin at %lx fails: %d", oldpos, res);
+                return res;
+            }
+            if (oldpos >= (blockOffset + (off_t)blockSize))
+            {
+                LE_ERROR("Origin block at %lx is too short: %zx", blockOffset, blockSize);
+                return LE_FAULT;
+            }
+            len = blockOffset + blockSize - oldpos;
+            if ((oldsize - oldpos) < (off_t)len)
+            {
+                len = oldsize - oldpos;
+            }
+            if (size < len)
+            {
+                len = size;
+            }
+            origPtr += oldpos - blockOffset;
+            for (i = 0; i < len; i++)
+            {
+                dataPtr[i] += origPtr[i];
+            }
+        }
+        dataPtr += len;
+        oldpos += len;
+        size -= len;
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue the write of the destination buffer being filled
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - others           Depending of pa_patch_WriteDestBlock
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteDest
+(
+    PatchDest_t *destPtr    ///< [INOUT] Destination of the patch
+)
+{
+    le_result_t res;
+
+    if (destPtr->crc32Ptr)
+    {
+        *destPtr->crc32Ptr = le_crc_Crc32(destPtr->bufPtr, destPtr->fillSize, *destPtr->crc32Ptr);
+    }
+    res = pa_patch_WriteDestBlock(destPtr->desc, destPtr->blockOffset,
+                                  destPtr->bufPtr, destPtr->fillSize);
+    destPtr->bufPtr = NULL;
+    destPtr->blockOffset += destPtr->blockSize;
+    destPtr->fillSize = 0;
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decompress a diff or extra string to the destination. For a diff string, the origin data are
+ * added. The full destination blocks are written while the next ones are decompressed.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_FAULT         If the patch is corrupted
+ *      - others           Depending of the flash accesses
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadDest
+(
+    PatchDest_t *destPtr,   ///< [INOUT] Destination of the patch
+    BZFILE *bzPtr,          ///< [IN] Decompression stream of the string
+    off_t size,             ///< [IN] Size of the string
+    bool isDiff,            ///< [IN] True for a diff string, false for an extra string
+    off_t oldpos,           ///< [IN] Position of the diff string in the origin image
+    off_t oldsize           ///< [IN] Size of the origin image
+)
+{
+    size_t len;
+    int lenread, bz2err;
+    le_result_t res;
+
+    while (size > 0)
+    {
+        if (!destPtr->bufPtr)
+        {
+            res = pa_patch_GetDestBuffer(destPtr->desc, &destPtr->bufPtr);
+            if (LE_OK != res)
+            {
+                LE_ERROR("No destination buffer: %d", res);
+                return res;
+            }
+        }
+
+        len = destPtr->blockSize - destPtr->fillSize;
+        if (size < (off_t)len)
+        {
+            len = size;
+        }
+        lenread = BZ2_bzRead(&bz2err, bzPtr, destPtr->bufPtr + destPtr->fillSize, len);
+        if ((lenread < (int)len) || ((bz2err != BZ_OK) && (bz2err != BZ_STREAM_END)))
+        {
+            LE_ERROR("Corrupt Patch lenread %d len %zu\n", lenread, len);
+            return LE_FAULT;
+        }
+        if (isDiff)
+        {
+            res = AddOrigData(destPtr->desc, destPtr->bufPtr + destPtr->fillSize, len,
+                              oldpos, oldsize);
+            if (LE_OK != res)
+            {
+                return res;
+            }
+            oldpos += len;
+        }
+
+        destPtr->fillSize += len;
+        size -= len;
+        if (destPtr->fillSize == destPtr->blockSize)
+        {
+            res = WriteDest(destPtr);
+            if (LE_OK != res)
+            {
+                return res;
+            }
+        }
+    }
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function apply a delta patch to an origin image and write it to a destination image
+ *
+ * Unlike bspatch, the origin and destination images are never loaded in memory: the patch is
+ * decompressed block after block, the origin is read through a read-ahead cache and the
+ * destination blocks are written while the next ones are decompressed. The memory used is bound
+ * by the maxMemory field of the patch context.
+ *
+ * @return
+ *      - LE_OK       Patch is successfully applied
+ *      - LE_FAULT    On failure
+ */
+//--------------------------------------------------------------------------------------------------
 le_result_t bsPatch
 (
     pa_patch_Context_t *patchContextPtr,
@@ -71,71 +390,237 @@ le_result_t bsPatch
     bool lastPatch,         ///< [IN] True if this is the last patch in this context
     bool forceClose         ///< [IN] Force close of device and resources
 )
+{
+    FILE *f = NULL, *cpf = NULL, *dpf = NULL, *epf = NULL;
+    BZFILE *cpfbz2 = NULL, *dpfbz2 = NULL, *epfbz2 = NULL;
+    int cbz2err;
+    off_t oldsize, newsize;
+    off_t bzctrllen, bzdatalen;
+    u_char header[32], buf[8];
+    off_t oldpos, newpos;
+    off_t ctrl[3];
+    off_t lenread;
+    off_t i;
+    PatchDest_t dest;
+    le_result_t res;
+
+    if (forceClose)
+    {
+        // If forceClose set, close descriptor and release all resources
+        LE_CRIT("Closing and releasing patch resources and MTD due to forceClose\n");
+        return ClosePatchDesc(false, 0);
+    }
+
+    LE_INFO("OrigNum %d DestNum %d, ubiVolId %u SSz %x offset %lx, lastPatch %d\n",
+            patchContextPtr->origImageDesc.flash.mtdNum,
+            patchContextPtr->destImageDesc.flash.mtdNum,
+            patchContextPtr->origImageDesc.flash.ubiVolId,
+            patchContextPtr->segmentSize,
+            patchContextPtr->patchOffset,
+            lastPatch);
+
+    /*
+    File format:
+        0       8       "BSDIFF40"
+        8       8       X
+        16      8       Y
+        24      8       sizeof(newfile)
+        32      X       bzip2(control block)
+        32+X    Y       bzip2(diff block)
+        32+X+Y  ???     bzip2(extra block)
+    with control block a set of triples (x,y,z) meaning "add x bytes
+    from oldfile to x bytes from the diff block; copy y bytes from the
+    extra block; seek forwards in oldfile by z bytes".
+    */
+
+    /* Read header */
+    if ((f = fopen(patchfile, "r")) == NULL)
+    {
+        LE_ERROR("fopen(%s): %m\n", patchfile);
+        goto error;
+    }
+    if (fread(header, 1, 32, f) < 32)
+    {
+        LE_ERROR("Corrupt patch");
+        goto error;
+    }
+    fclose(f);
+    f = NULL;
+
+    /* Check for appropriate magic */
+    if (memcmp(header, "BSDIFF40", 8) != 0)
+    {
+        LE_ERROR("Corrupt patch\n");
+        goto error;
+    }
+
+    /* Read lengths from header */
+    bzctrllen = offtin(header + 8);
+    bzdatalen = offtin(header + 16);
+    newsize = offtin(header + 24);
+    if ((bzctrllen < 0) || (bzdatalen < 0) || (newsize < 0))
+    {
+        LE_ERROR("Corrupt patch\n");
+        goto error;
+    }
+    if (newsize > (off_t)patchContextPtr->segmentSize)
+    {
+        LE_ERROR("Unable to apply patch. newsize is too big: %ld > %zu\n",
+                 newsize, patchContextPtr->segmentSize);
+        goto error;
+    }
+
+    /* Open the flash, or keep the descriptor of the previous segment of the image */
+    if (PatchDesc && !IsSameImage(&PatchCtx, patchContextPtr))
+    {
+        LE_WARN("Previous image was not completed");
+        ClosePatchDesc(false, 0);
+    }
+    if (!PatchDesc)
+    {
+        res = pa_patch_Open(patchContextPtr, &PatchDesc);
+        if (LE_OK != res)
+        {
+            LE_ERROR("pa_patch_Open fails: %d", res);
+            PatchDesc = NULL;
+            goto error;
+        }
+        memcpy(&PatchCtx, patchContextPtr, sizeof(PatchCtx));
+    }
+
+    /* Open the control, diff and extra blocks via libbzip2 */
+    if ((LE_OK != OpenBzStream(patchfile, 32, &cpf, &cpfbz2)) ||
+        (LE_OK != OpenBzStream(patchfile, 32 + bzctrllen, &dpf, &dpfbz2)) ||
+        (LE_OK != OpenBzStream(patchfile, 32 + bzctrllen + bzdatalen, &epf, &epfbz2)))
+    {
+        goto error;
+    }
+
+    dest.desc = PatchDesc;
+    dest.bufPtr = NULL;
+    dest.blockOffset = patchContextPtr->patchOffset;
+    dest.blockSize = pa_patch_GetBlockSize(PatchDesc);
+    dest.fillSize = 0;
+    dest.crc32Ptr = crc32Ptr;
+    if ((!dest.blockSize) || (dest.blockOffset % dest.blockSize))
+    {
+        LE_ERROR("Segment offset %lx is not aligned on a block %zx",
+                 dest.blockOffset, dest.blockSize);
+        goto error;
+    }
+    oldsize = patchContextPtr->origImageSize;
+
+    oldpos = 0; newpos = 0;
+    while (newpos < newsize)
+    {
+        /* Read control data */
+        for (i = 0; i <= 2; i++)
+        {
+            lenread = BZ2_bzRead(&cbz2err, cpfbz2, buf, 8);
+            if ((lenread < 8) || ((cbz2err != BZ_OK) && (cbz2err != BZ_STREAM_END)))
+            {
+                LE_ERROR("Corrupt Patch\n");
+                goto error;
+            }
+            ctrl[i] = offtin(buf);
+        }
+
+        /* Sanity-check */
+        if ((ctrl[0] < 0) || (ctrl[1] < 0) || (newpos + ctrl[0] > newsize))
+        {
+            LE_ERROR("Corrupt Patch\n");
+            goto error;
+        }
+
+        /* Read diff string and add old data to it */
+        if (LE_OK != ReadDest(&dest, dpfbz2, ctrl[0], true, oldpos, oldsize))
+        {
+            goto error;
+        }
+
+        /* Adjust pointers */
+        newpos += ctrl[0];
+        oldpos += ctrl[0];
+
+        /* Sanity-check */
+        if (newpos + ctrl[1] > newsize)
+        {
+            LE_ERROR("Corrupt Patch\n");
+            goto error;
+        }
+
+        /* Read extra string */
+        if (LE_OK != ReadDest(&dest, epfbz2, ctrl[1], false, 0, 0))
+        {
+            goto error;
+        }
+
+        /* Adjust pointers */
+        newpos += ctrl[1];
+        oldpos += ctrl[2];
+    }
+
+    /* Write the last partial block */
+    if (dest.bufPtr && (LE_OK != WriteDest(&dest)))
+    {
+        goto error;
+    }
+    LE_DEBUG("newsize=%lx crc32=%x\n", newsize, crc32Ptr ? *crc32Ptr : 0);
+
+    /* Clean up the bzip2 reads */
+    CloseBzStream(&cpf, &cpfbz2);
+    CloseBzStream(&dpf, &dpfbz2);
+    CloseBzStream(&epf, &epfbz2);
+
+    // The caller records the progress of the update once the segment is applied: the segment has
+    // to be in flash before returning
+    if (lastPatch)
+    {
+        res = ClosePatchDesc(true, patchContextPtr->patchOffset + newsize);
+    }
+    else
+    {
+        res = pa_patch_Flush(PatchDesc);
+    }
+    if (LE_OK != res)
+    {
+        LE_ERROR("Write of the patch segment fails: %d", res);
+        goto error;
+    }
+    return LE_OK;
+
+error:
+    if (f)
+    {
+        fclose(f);
+    }
+    CloseBzStream(&cpf, &cpfbz2);
+    CloseBzStream(&dpf, &dpfbz2);
+    CloseBzStream(&epf, &epfbz2);
+    ClosePatchDesc(false, 0);
+    return LE_FAULT;
+}
 #else
 int main(int argc,char * argv[])
-#endif // SIERRA_BSPATCH
 {
 	FILE * f, * cpf, * dpf, * epf;
 	BZFILE * cpfbz2, * dpfbz2, * epfbz2;
 	int cbz2err, dbz2err, ebz2err;
-#ifndef SIERRA_BSPATCH
 	int fd;
-#endif // SIERRA_BSPATCH
 	ssize_t oldsize,newsize;
 	ssize_t bzctrllen,bzdatalen;
 	u_char header[32],buf[8];
-#ifdef SIERRA_BSPATCH
-	u_char *old = NULL, *new = NULL;
-#else
 	u_char *old, *new;
-#endif
 	off_t oldpos,newpos;
 	off_t ctrl[3];
 	off_t lenread;
 	off_t i;
-#ifdef SIERRA_BSPATCH
-	off_t oldposmax;
-        off_t patchHdrOffset;
-        pa_patch_Desc_t desc = NULL;
-        size_t readSize;
-        le_result_t res = LE_FAULT;
-
-        f = NULL;
-	cpf = NULL;
-        dpf = NULL;
-        epf = NULL;
-	cpfbz2 = NULL;
-        dpfbz2 = NULL;
-        epfbz2 = NULL;
-
-        if( forceClose )
-        {
-            // If forceClose set, close descriptor and release all resources
-            LE_CRIT( "Closing and releasing patch resources and MTD due to forceClose\n" );
-            goto errorfcloseall;
-        }
 
-        patchHdrOffset = patchContextPtr->patchOffset;
-
-        LE_INFO("OrigNum %d DestNum %d, ubiVolId %u SSz %x offset %lx, lastPatch %d\n",
-                patchContextPtr->origImageDesc.flash.mtdNum,
-                patchContextPtr->destImageDesc.flash.mtdNum,
-                patchContextPtr->origImageDesc.flash.ubiVolId,
-                patchContextPtr->segmentSize,
-                patchContextPtr->patchOffset,
-                lastPatch);
-        if ((f = fopen(patchfile, "r")) == NULL)
-        {
-            LE_ERROR("fopen(%s): %m\n", patchfile);
-            return LE_FAULT;
-        }
-#else
 	if(argc!=4) errx(1,"usage: %s oldfile newfile patchfile\n",argv[0]);
 
 	/* Open patch file */
 	if ((f = fopen(argv[3], "r")) == NULL)
 		err(1, "fopen(%s)", argv[3]);
-#endif // SIERRA_BSPATCH
 
 	/*
 	File format:
@@ -154,46 +639,22 @@ int main(int argc,char * argv[])
 	/* Read header */
 	if (fread(header, 1, 32, f) < 32) {
 		if (feof(f))
-#ifdef SIERRA_BSPATCH
-                {
-                    LE_ERROR("Corrupt patch");
-                    goto errorfclose;
-                }
-                LE_ERROR( "fread(%s)", patchfile);
-                goto errorfclose;
-#else
 			errx(1, "Corrupt patch\n");
 		err(1, "fread(%s)", argv[3]);
-#endif // SIERRA_BSPATCH
 	}
 
 	/* Check for appropriate magic */
 	if (memcmp(header, "BSDIFF40", 8) != 0)
-#ifdef SIERRA_BSPATCH
-        {
-            LE_ERROR("Corrupt patch\n");
-            goto errorfclose;
-        }
-#else
 		errx(1, "Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 
 	/* Read lengths from header */
 	bzctrllen=offtin(header+8);
 	bzdatalen=offtin(header+16);
 	newsize=offtin(header+24);
 	if((bzctrllen<0) || (bzdatalen<0) || (newsize<0))
-#ifdef SIERRA_BSPATCH
-        {
-            LE_ERROR("Corrupt patch\n");
-            goto errorfclose;
-        }
-#else
 		errx(1,"Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 
 	/* Close patch file and re-open it via libbzip2 at the right places */
-#ifndef SIERRA_BSPATCH
 	if (fclose(f))
 		err(1, "fclose(%s)", argv[3]);
 	if ((cpf = fopen(argv[3], "r")) == NULL)
@@ -226,83 +687,6 @@ int main(int argc,char * argv[])
 		(close(fd)==-1)) err(1,"%s",argv[1]);
 	if((new=malloc(newsize+1))==NULL) err(1,NULL);
 
-#else
-	if (fclose(f))
-        {
-            LE_ERROR("fclose\n");
-            goto errorfclose;
-        }
-        f = NULL;
-	if ((cpf = fopen(patchfile, "r")) == NULL)
-        {
-            LE_ERROR("fopen(%s)", patchfile);
-            goto errorfcloseall;
-        }
-	if (fseeko(cpf, 32, SEEK_SET))
-        {
-            LE_ERROR("fseeko(%s, %lld)", patchfile, (long long)32);
-            goto errorfcloseall;
-        }
-	if ((cpfbz2 = BZ2_bzReadOpen(&cbz2err, cpf, 0, 0, NULL, 0)) == NULL)
-        {
-            LE_ERROR("BZ2_bzReadOpen, bz2err = %d", cbz2err);
-            goto errorfcloseall;
-        }
-	if ((dpf = fopen(patchfile, "r")) == NULL)
-        {
-            LE_ERROR("fopen(%s)", patchfile);
-            goto errorfcloseall;
-        }
-	if (fseeko(dpf, 32 + bzctrllen, SEEK_SET))
-        {
-            LE_ERROR("fseeko(%s, %lld)", patchfile, (long long)(32 + bzctrllen));
-            goto errorfcloseall;
-        }
-	if ((dpfbz2 = BZ2_bzReadOpen(&dbz2err, dpf, 0, 0, NULL, 0)) == NULL)
-        {
-            LE_ERROR("BZ2_bzReadOpen, bz2err = %d", dbz2err);
-            goto errorfcloseall;
-        }
-	if ((epf = fopen(patchfile, "r")) == NULL)
-        {
-            LE_ERROR("fopen(%s)", patchfile);
-            goto errorfcloseall;
-        }
-	if (fseeko(epf, 32 + bzctrllen + bzdatalen, SEEK_SET))
-        {
-            LE_ERROR("fseeko(%s, %lld)", patchfile, (long long)(32 + bzctrllen + bzdatalen));
-            goto errorfcloseall;
-        }
-	if ((epfbz2 = BZ2_bzReadOpen(&ebz2err, epf, 0, 0, NULL, 0)) == NULL)
-        {
-            LE_ERROR("BZ2_bzReadOpen, bz2err = %d", ebz2err);
-            goto errorfcloseall;
-        }
-
-	oldsize = patchContextPtr->origImageSize;
-        if( newsize > patchContextPtr->segmentSize )
-        {
-            LE_ERROR("Unable to apply patch. newsize is too big: %d > %u\n",
-                     newsize, patchContextPtr->segmentSize);
-            goto errorfcloseall;
-        }
-
-        res = pa_patch_Open( patchContextPtr, &desc, &old, &new );
-        if( LE_OK != res )
-        {
-            LE_ERROR("pa_patch_Open fails");
-            goto errorfcloseall;
-        }
-        res = pa_patch_ReadSegment( desc, patchHdrOffset, old, &readSize );
-        if( (LE_OK != res) && (LE_OUT_OF_RANGE != res) )
-        {
-            LE_ERROR("Readegment fails %d", res);
-            goto errorfcloseall;
-        }
-
-        oldposmax = readSize + patchHdrOffset;
-#endif // SIERRA_BSPATCH
-
 	oldpos=0;newpos=0;
 	while(newpos<newsize) {
 		/* Read control data */
@@ -310,70 +694,24 @@ int main(int argc,char * argv[])
 			lenread = BZ2_bzRead(&cbz2err, cpfbz2, buf, 8);
 			if ((lenread < 8) || ((cbz2err != BZ_OK) &&
 			    (cbz2err != BZ_STREAM_END)))
-#ifdef SIERRA_BSPATCH
-                        {
-                            LE_ERROR("Corrupt Patch\n");
-                            goto errorfcloseall;
-                        }
-#else
 				errx(1, "Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 			ctrl[i]=offtin(buf);
 		};
 
 		/* Sanity-check */
 		if(newpos+ctrl[0]>newsize)
-#ifdef SIERRA_BSPATCH
-                {
-                    LE_ERROR("Corrupt Patch\n");
-                    goto errorfcloseall;
-                }
-#else
 			errx(1,"Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 
 		/* Read diff string */
 		lenread = BZ2_bzRead(&dbz2err, dpfbz2, new + newpos, ctrl[0]);
 		if ((lenread < ctrl[0]) ||
 		    ((dbz2err != BZ_OK) && (dbz2err != BZ_STREAM_END)))
-#ifdef SIERRA_BSPATCH
-                {
-                    LE_ERROR("Corrupt Patch\n");
-                    goto errorfcloseall;
-                }
-#else
 			errx(1, "Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 
 		/* Add old data to diff string */
 		for(i=0;i<ctrl[0];i++)
-#ifndef SIERRA_BSPATCH
 			if((oldpos+i>=0) && (oldpos+i<oldsize))
 				new[newpos+i]+=old[oldpos+i];
-#else
-                {
-                    if( ((oldpos+i) >= oldposmax) || ((oldpos+i) < patchHdrOffset) )
-                    {
-                        LE_DEBUG("Flush PATCH and reading at offset %lx (at blk %lx)\n",
-                                 oldpos, oldpos /patchContextPtr->segmentSize);
-                        patchHdrOffset = ((oldpos+i) / patchContextPtr->segmentSize)
-                                         * patchContextPtr->segmentSize;
-                        LE_DEBUG("Reread at patchHdrOffset=%lx\n", patchHdrOffset);
-                        res = pa_patch_ReadSegment( desc, patchHdrOffset, old, &readSize );
-                        if( (LE_OK != res) /*&& (LE_OUT_OF_RANGE != res)*/ )
-                        {
-                            LE_ERROR("ReadNextSegment fails: res = %d", res);
-                            goto errorfcloseall;
-                        }
-                        oldposmax = readSize + patchHdrOffset;
-                    }
-
-                    if(((oldpos + i) >= 0) && ((oldpos + i) < oldsize))
-                    {
-                        new[newpos + i] += old[oldpos - patchHdrOffset + i];
-                    }
-                }
-#endif // SIERRA_BSPATCH
 
 		/* Adjust pointers */
 		newpos+=ctrl[0];
@@ -381,28 +719,13 @@ int main(int argc,char * argv[])
 
 		/* Sanity-check */
 		if(newpos+ctrl[1]>newsize)
-#ifdef SIERRA_BSPATCH
-                {
-                    LE_ERROR("Corrupt Patch\n");
-                    goto errorfcloseall;
-                }
-#else
 			errx(1,"Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 
 		/* Read extra string */
 		lenread = BZ2_bzRead(&ebz2err, epfbz2, new + newpos, ctrl[1]);
 		if ((lenread < ctrl[1]) ||
 		    ((ebz2err != BZ_OK) && (ebz2err != BZ_STREAM_END)))
-#ifdef SIERRA_BSPATCH
-                {
-                    LE_ERROR("Corrupt Patch lenread %ld ctrl[1] = %ld\n",
-                             lenread, ctrl[1]);
-                    goto errorfcloseall;
-                }
-#else
 			errx(1, "Corrupt patch\n");
-#endif // SIERRA_BSPATCH
 
 		/* Adjust pointers */
 		newpos+=ctrl[1];
@@ -414,7 +737,6 @@ int main(int argc,char * argv[])
 	BZ2_bzReadClose(&dbz2err, dpfbz2);
 	BZ2_bzReadClose(&ebz2err, epfbz2);
 	if (fclose(cpf) || fclose(dpf) || fclose(epf))
-#ifndef SIERRA_BSPATCH
 		err(1, "fclose(%s)", argv[3]);
 
 	/* Write the new file */
@@ -426,60 +748,5 @@ int main(int argc,char * argv[])
 	free(old);
 
 	return 0;
-#else
-        LE_INFO("crc32Ptr = %p", crc32Ptr);
-        if( crc32Ptr )
-        {
-            *crc32Ptr = le_crc_Crc32( new, newsize, *crc32Ptr );
-            LE_DEBUG("newsize=%x crc32=%x\n", newsize, *crc32Ptr);
-        }
-
-        if( LE_OK != pa_patch_WriteSegment( desc,
-                                            patchContextPtr->patchOffset,
-                                            new,
-                                            newsize) )
-        {
-            goto errorfclose;
-        }
-
-        pa_patch_Close( desc, lastPatch, patchContextPtr->patchOffset + newsize );
-        return LE_OK;
-
-errorfcloseall:
-	/* Clean up the bzip2 reads */
-        if( cpfbz2 )
-        {
-	    BZ2_bzReadClose(&cbz2err, cpfbz2);
-        }
-        if( dpfbz2 )
-        {
-	    BZ2_bzReadClose(&dbz2err, dpfbz2);
-        }
-        if( epfbz2 )
-        {
-	    BZ2_bzReadClose(&ebz2err, epfbz2);
-        }
-        if( cpf )
-        {
-	    fclose(cpf);
-        }
-        if( dpf )
-        {
-            fclose(dpf);
-        }
-        if( epf )
-        {
-            fclose(epf);
-        }
-errorfclose:
-        if( f )
-        {
-	    fclose(f);
-        }
-        if( desc )
-        {
-            res = pa_patch_Close( desc, false, 0 );
-        }
-        return (forceClose ? res : LE_FAULT);
-#endif
 }
+#endif // SIERRA_BSPATCH
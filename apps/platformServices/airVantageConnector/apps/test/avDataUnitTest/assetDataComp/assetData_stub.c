@@ -11,6 +11,24 @@
 #include "coapHandlers.h"
 #include "cbor.h"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * CoAP request handler set by avData, and request sent by the simulated server
+ */
+//--------------------------------------------------------------------------------------------------
+static coap_request_handler_t CoapRequestHandler = NULL;
+static const char* RequestUri = "coap://leshan.eclipse.org:5784";
+static coap_method_t RequestMethod = COAP_GET;
+static const uint8_t* RequestPayloadPtr = (const uint8_t*)"1234";
+static size_t RequestPayloadLength = 4;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Code of the last response sent to the simulated server
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_CoapResponseCode_t ResponseCode = COAP_INTERNAL_ERROR;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the client session reference for the current message
@@ -458,6 +476,21 @@ le_result_t le_cfg_GetNodeName
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * le_cfgAdmin_ExportTree() stub.  The settings are then restored node by node.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfgAdmin_ExportTree
+(
+    le_cfg_IteratorRef_t iteratorRef,  ///< [IN] Iterator object to use to read from the tree.
+    const char* LE_NONNULL filePath,   ///< [IN] Import the tree data from this file.
+    const char* LE_NONNULL nodePath    ///< [IN] Where in the tree should this export happen?
+)
+{
+    return LE_FAULT;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Gets the application name of the process with the specified PID.
@@ -503,6 +536,7 @@ bool lwm2mcore_SendAsyncResponse
     lwm2mcore_CoapResponse_t* responsePtr       ///< [IN] CoAP response
 )
 {
+    ResponseCode = responsePtr->code;
     return true;
 }
 
@@ -516,7 +550,7 @@ const char* lwm2mcore_GetRequestUri
     lwm2mcore_CoapRequest_t* requestRef    ///< [IN] Coap request reference
 )
 {
-    return "coap://leshan.eclipse.org:5784";
+    return RequestUri;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -529,7 +563,7 @@ coap_method_t lwm2mcore_GetRequestMethod
     lwm2mcore_CoapRequest_t* requestRef        ///< [IN] Coap request reference
 )
 {
-    return COAP_GET;
+    return RequestMethod;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -542,7 +576,7 @@ const uint8_t* lwm2mcore_GetRequestPayload
     lwm2mcore_CoapRequest_t* requestRef    ///< [IN] Coap request reference
 )
 {
-    return "1234";
+    return RequestPayloadPtr;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -555,7 +589,7 @@ size_t lwm2mcore_GetRequestPayloadLength
     lwm2mcore_CoapRequest_t* requestRef    ///< [IN] Coap request reference
 )
 {
-    return 4;
+    return RequestPayloadLength;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -594,6 +628,7 @@ void lwm2mcore_SetCoapEventHandler
     coap_request_handler_t handlerRef    ///< [IN] Coap action handler
 )
 {
+    CoapRequestHandler = handlerRef;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -646,314 +681,83 @@ le_result_t avcServer_ReleaseSession
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Initializes a CborEncoder structure encoder by pointing it to buffer of size. The flags field is
- * currently unused and must be zero.
- */
-//--------------------------------------------------------------------------------------------------
-void cbor_encoder_init
-(
-    CborEncoder* encoder,
-    uint8_t *buffer,
-    size_t size,
-    int flags
-)
-{
-    if ( NULL != encoder )
-    {
-        encoder->data.ptr = buffer + size;
-        encoder->end = buffer + size;
-        encoder->added = 0;
-        encoder->flags = flags;
-    }
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Creates a CBOR map in the CBOR stream provided by encoder and initializes mapEncoder.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encoder_create_map
-(
-    CborEncoder* encoder,
-    CborEncoder* mapEncoder,
-    size_t length
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Appends the byte string of length to the CBOR stream provided by encoder. CBOR byte strings are
- * arbitrary raw data.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encode_text_string
-(
-    CborEncoder* encoder,
-    const char *string,
-    size_t length
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Appends the signed 64-bit integer value to the CBOR stream provided by encoder.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encode_int
-(
-    CborEncoder* encoder,
-    int64_t value
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Creates a CBOR array in the CBOR stream provided by encoder and initializes arrayEncoder.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encoder_create_array
-(
-    CborEncoder* encoder,
-    CborEncoder* arrayEncoder,
-    size_t length
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Appends the floating-point value of type fpType and pointed to by value to the CBOR stream
- * provided by encoder.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encode_floating_point
-(
-    CborEncoder* encoder,
-    CborType fpType,
-    const void *value)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Appends the unsigned 64-bit integer value to the CBOR stream provided by encoder.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encode_uint
-(
-    CborEncoder* encoder,
-    uint64_t value
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Closes the CBOR container (array or map) provided by containerEncoder and updates the CBOR stream
- * provided by encoder.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encoder_close_container
-(
-    CborEncoder* encoder,
-    const CborEncoder* containerEncoder
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Retrieves the CBOR integer value that points to and stores it in result.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_value_get_int_checked
-(
-    const CborValue *value,
-    int *result
-)
-{
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Decodes the CBOR integer value when it is larger than the 16 bits available in value->extra.
+ * LwM2M client entry point to push data.
+ *
+ * @return
+ *      - LE_OK in case of success.
+ *      - LE_BUSY if busy pushing data.
+ *      - LE_FAULT in case of failure.
  */
 //--------------------------------------------------------------------------------------------------
-uint64_t _cbor_value_decode_int64_internal
+le_result_t avcClient_Push
 (
-    const CborValue *value
+    uint8_t* payload,                       ///< [IN] Payload to push.
+    size_t payloadLength,                   ///< [IN] Payload length.
+    lwm2mcore_PushContent_t contentType,    ///< [IN] Content type.
+    uint16_t* midPtr                        ///< [OUT] Message identifier.
 )
 {
-    return 0;
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Creates a CborValue iterator pointing to the first element of the container
- * represented by \a it and saves it in \a recursed. The \a it container object
- * needs to be kept and passed again to cbor_value_leave_container() in order
- * to continue iterating past this container.
+ * Query the AVC session type.
  *
- * The \a it CborValue iterator must point to a container.
+ * @return
+ *      - LE_AVC_DM_SESSION when a session with the server is opened.
  */
 //--------------------------------------------------------------------------------------------------
-CborError cbor_value_enter_container
+le_avc_SessionType_t avcClient_GetSessionType
 (
-    const CborValue *it,
-    CborValue *recursed
+    void
 )
 {
-    return CborNoError;
+    return LE_AVC_DM_SESSION;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Copies the string pointed by value into the buffer provided at buffer of buflen bytes
+ * Returns the instance reference of this client.
  */
 //--------------------------------------------------------------------------------------------------
-CborError _cbor_value_copy_string
+lwm2mcore_Ref_t avcClient_GetInstance
 (
-    const CborValue *value,
-    void *buffer,
-    size_t *buflen,
-    CborValue *next
+    void
 )
 {
-    return CborNoError;
+    return (lwm2mcore_Ref_t)0x1003;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Appends the CBOR Simple Type of value \a value to the CBOR stream provided by
- * \a encoder.
+ * Send a request from the simulated AirVantage server to avData, and get its response
  *
- * This function is a stub.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_encode_simple_value(CborEncoder* encoder, uint8_t value)
-{
-
-    return CborNoError;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Appends the CBOR Simple Type of value \a value to the CBOR stream provided by
- * \a encoder.
- * This function is a stub.
+ * @return the response code
  */
 //--------------------------------------------------------------------------------------------------
-CborError cbor_value_leave_container
+lwm2mcore_CoapResponseCode_t le_avdataTest_ServerRequest
 (
-    CborValue *it,
-    const CborValue *recursed
+    coap_method_t method,           ///< [IN] Method: COAP_GET, COAP_PUT or COAP_POST
+    const char* uri,                ///< [IN] Asset data path
+    const uint8_t* payloadPtr,      ///< [IN] CBOR payload
+    size_t payloadLength            ///< [IN] Payload length
 )
 {
-    return CborNoError;
-}
+    lwm2mcore_CoapRequest_t request;
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Advances the CBOR value \a it by one element, skipping over containers.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_value_advance
-(
-    CborValue *it
-)
-{
-    return CborNoError;
-}
+    LE_ASSERT(NULL != CoapRequestHandler);
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Initializes the CBOR parser for parsing \a size bytes beginning at \a
- * buffer.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_parser_init
-(
-    const uint8_t *buffer,
-    size_t size,
-    int flags,
-    CborParser *parser,
-    CborValue *it
-)
-{
-    return CborNoError;
-}
+    memset(&request, 0, sizeof(request));
+    RequestUri = uri;
+    RequestMethod = method;
+    RequestPayloadPtr = payloadPtr;
+    RequestPayloadLength = payloadLength;
+    ResponseCode = COAP_INTERNAL_ERROR;
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Returns the error string corresponding to the CBOR error condition \a error.
- */
-//--------------------------------------------------------------------------------------------------
-const char *cbor_error_string
-(
-    CborError error
-)
-{
-    return "stub function";
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Calculates the length of the byte or text string that \a value points to and
- * stores it in \a len.
- */
-//--------------------------------------------------------------------------------------------------
-CborError cbor_value_calculate_string_length
-(
-    const CborValue *value,
-    size_t *len
-)
-{
-    return CborNoError;
-}
+    CoapRequestHandler(&request);
 
-//--------------------------------------------------------------------------------------------------
-/**
- * LwM2M client entry point to push data.
- *
- * @return
- *      - LE_OK in case of success.
- *      - LE_BUSY if busy pushing data.
- *      - LE_FAULT in case of failure.
- */
-//--------------------------------------------------------------------------------------------------
-le_result_t avcClient_Push
-(
-    uint8_t* payload,                       ///< [IN] Payload to push.
-    size_t payloadLength,                   ///< [IN] Payload length.
-    lwm2mcore_PushContent_t contentType,    ///< [IN] Content type.
-    uint16_t* midPtr                        ///< [OUT] Message identifier.
-)
-{
-    return LE_OK;
-}
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Returns the instance reference of this client.
- */
-//--------------------------------------------------------------------------------------------------
-lwm2mcore_Ref_t avcClient_GetInstance
-(
-    void
-)
-{
-    return NULL;
+    return ResponseCode;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -11,8 +11,10 @@
 #include "le_avdata_interface.h"
 #include "le_avc_interface.h"
 #include "le_cfg_interface.h"
+#include "le_cfgAdmin_interface.h"
 #include "lwm2mcore.h"
 #include "liblwm2m.h"
+#include "coapHandlers.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -70,4 +72,19 @@ le_result_t assetData_Init
     void
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send a request from the simulated AirVantage server to avData, and get its response
+ *
+ * @return the response code
+ */
+//--------------------------------------------------------------------------------------------------
+lwm2mcore_CoapResponseCode_t le_avdataTest_ServerRequest
+(
+    coap_method_t method,           ///< [IN] Method: COAP_GET, COAP_PUT or COAP_POST
+    const char* uri,                ///< [IN] Asset data path
+    const uint8_t* payloadPtr,      ///< [IN] CBOR payload
+    size_t payloadLength            ///< [IN] Payload length
+);
+
 #endif /* interfaces.h */
@@ -7,6 +7,7 @@
 
 #include "legato.h"
 #include "interfaces.h"
+#include "cbor.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -91,6 +92,20 @@
 #define GLOBAL_RESOURCE_C_INT_VAL           33
 #define GLOBAL_RESOURCE_D_INT_VAL           44
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *   Number of resources created by the benchmark, and how many share the same parent path
+ */
+//--------------------------------------------------------------------------------------------------
+#define MANY_RESOURCES_COUNT                20000
+#define MANY_RESOURCES_PER_NODE             100
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *   CBOR payload written by the server to the settings created by the benchmark
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t ManySettingsPayload[MANY_RESOURCES_COUNT * 16];
 
 //-------------------------------------------------------------------------------------------------
 /**
@@ -549,6 +564,170 @@ static void TestTimeseries
     LE_INFO("============= Test avdata with times series passed==============");
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create and access a large number of resources, and log how long it takes.  The lookups, and the
+ * checks that a new path isn't above or below an existing one, must not depend on the number of
+ * resources.  Reading every node from the server times the CBOR encoding.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestManyResources
+(
+    void
+)
+{
+    char path[LE_AVDATA_PATH_NAME_BYTES];
+    int intVal;
+    int i;
+    le_clk_Time_t startTime;
+    le_clk_Time_t createTime;
+    le_clk_Time_t accessTime;
+    le_clk_Time_t readTime;
+
+    LE_INFO("============= Test avdata with %d resources ==============", MANY_RESOURCES_COUNT);
+
+    startTime = le_clk_GetRelativeTime();
+    for (i = 0; i < MANY_RESOURCES_COUNT; i++)
+    {
+        LE_ASSERT(snprintf(path, sizeof(path), "/bench/node%d/res%d",
+                           i / MANY_RESOURCES_PER_NODE, i % MANY_RESOURCES_PER_NODE)
+                  < sizeof(path));
+        LE_ASSERT_OK(le_avdata_CreateResource(path, LE_AVDATA_ACCESS_VARIABLE));
+    }
+    createTime = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    startTime = le_clk_GetRelativeTime();
+    for (i = 0; i < MANY_RESOURCES_COUNT; i++)
+    {
+        LE_ASSERT(snprintf(path, sizeof(path), "/bench/node%d/res%d",
+                           i / MANY_RESOURCES_PER_NODE, i % MANY_RESOURCES_PER_NODE)
+                  < sizeof(path));
+        LE_ASSERT_OK(le_avdata_SetInt(path, i));
+        LE_ASSERT_OK(le_avdata_GetInt(path, &intVal));
+        LE_ASSERT(i == intVal);
+    }
+    accessTime = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    // The server sees the resources under the application name.
+    startTime = le_clk_GetRelativeTime();
+    for (i = 0; i < MANY_RESOURCES_COUNT / MANY_RESOURCES_PER_NODE; i++)
+    {
+        LE_ASSERT(snprintf(path, sizeof(path), "/test/bench/node%d", i) < sizeof(path));
+        LE_ASSERT(COAP_CONTENT_AVAILABLE == le_avdataTest_ServerRequest(COAP_GET, path, NULL, 0));
+    }
+    readTime = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    // A path can't be above or below an existing resource.
+    LE_ASSERT(LE_DUPLICATE == le_avdata_CreateResource("/bench/node1", LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT(LE_DUPLICATE == le_avdata_CreateResource("/bench/node1/res1/x",
+                                                       LE_AVDATA_ACCESS_VARIABLE));
+    LE_ASSERT(LE_NOT_FOUND == le_avdata_GetInt("/bench/node1/resX", &intVal));
+
+    LE_INFO("Created %d resources in %ld.%06ld s, set and got them in %ld.%06ld s",
+            MANY_RESOURCES_COUNT, (long)createTime.sec, (long)createTime.usec,
+            (long)accessTime.sec, (long)accessTime.usec);
+    LE_INFO("Encoded %d resources for the server in %ld.%06ld s",
+            MANY_RESOURCES_COUNT, (long)readTime.sec, (long)readTime.usec);
+
+    LE_INFO("============= Test avdata with %d resources passed ==============",
+            MANY_RESOURCES_COUNT);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a large number of settings from the server in a single CBOR map, and log how long it
+ * takes to decode and write it.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestManySettingsWrite
+(
+    void
+)
+{
+    char label[LE_AVDATA_PATH_NAME_BYTES];
+    char path[LE_AVDATA_PATH_NAME_BYTES];
+    CborEncoder rootEncoder;
+    CborEncoder mapEncoder;
+    CborEncoder nodeEncoder;
+    size_t payloadLength;
+    int intVal;
+    int i;
+    le_clk_Time_t startTime;
+    le_clk_Time_t writeTime;
+
+    LE_INFO("============= Test server write of %d settings ==============", MANY_RESOURCES_COUNT);
+
+    for (i = 0; i < MANY_RESOURCES_COUNT; i++)
+    {
+        LE_ASSERT(snprintf(path, sizeof(path), "/benchSettings/node%d/res%d",
+                           i / MANY_RESOURCES_PER_NODE, i % MANY_RESOURCES_PER_NODE)
+                  < sizeof(path));
+        LE_ASSERT_OK(le_avdata_CreateResource(path, LE_AVDATA_ACCESS_SETTING));
+    }
+
+    // The server writes the whole tree, under the application name: each node is a map of its
+    // resources.
+    cbor_encoder_init(&rootEncoder, ManySettingsPayload, sizeof(ManySettingsPayload), 0);
+    LE_ASSERT(CborNoError == cbor_encoder_create_map(&rootEncoder, &mapEncoder,
+                                                     CborIndefiniteLength));
+    for (i = 0; i < MANY_RESOURCES_COUNT; i++)
+    {
+        if (0 == (i % MANY_RESOURCES_PER_NODE))
+        {
+            snprintf(label, sizeof(label), "node%d", i / MANY_RESOURCES_PER_NODE);
+            LE_ASSERT(CborNoError == cbor_encode_text_stringz(&mapEncoder, label));
+            LE_ASSERT(CborNoError == cbor_encoder_create_map(&mapEncoder, &nodeEncoder,
+                                                             CborIndefiniteLength));
+        }
+
+        snprintf(label, sizeof(label), "res%d", i % MANY_RESOURCES_PER_NODE);
+        LE_ASSERT(CborNoError == cbor_encode_text_stringz(&nodeEncoder, label));
+        LE_ASSERT(CborNoError == cbor_encode_int(&nodeEncoder, i));
+
+        if ((MANY_RESOURCES_PER_NODE - 1) == (i % MANY_RESOURCES_PER_NODE))
+        {
+            LE_ASSERT(CborNoError == cbor_encoder_close_container(&mapEncoder, &nodeEncoder));
+        }
+    }
+    LE_ASSERT(CborNoError == cbor_encoder_close_container(&rootEncoder, &mapEncoder));
+    payloadLength = cbor_encoder_get_buffer_size(&rootEncoder, ManySettingsPayload);
+
+    startTime = le_clk_GetRelativeTime();
+    LE_ASSERT(COAP_RESOURCE_CHANGED == le_avdataTest_ServerRequest(COAP_PUT, "/test/benchSettings",
+                                                                   ManySettingsPayload,
+                                                                   payloadLength));
+    writeTime = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    for (i = 0; i < MANY_RESOURCES_COUNT; i++)
+    {
+        LE_ASSERT(snprintf(path, sizeof(path), "/benchSettings/node%d/res%d",
+                           i / MANY_RESOURCES_PER_NODE, i % MANY_RESOURCES_PER_NODE)
+                  < sizeof(path));
+        LE_ASSERT_OK(le_avdata_GetInt(path, &intVal));
+        LE_ASSERT(i == intVal);
+    }
+
+    // Nothing is written if a single value can't be: here, a resource which doesn't exist.
+    cbor_encoder_init(&rootEncoder, ManySettingsPayload, sizeof(ManySettingsPayload), 0);
+    LE_ASSERT(CborNoError == cbor_encoder_create_map(&rootEncoder, &mapEncoder, 2));
+    LE_ASSERT(CborNoError == cbor_encode_text_stringz(&mapEncoder, "res0"));
+    LE_ASSERT(CborNoError == cbor_encode_int(&mapEncoder, -1));
+    LE_ASSERT(CborNoError == cbor_encode_text_stringz(&mapEncoder, "resX"));
+    LE_ASSERT(CborNoError == cbor_encode_int(&mapEncoder, -1));
+    LE_ASSERT(CborNoError == cbor_encoder_close_container(&rootEncoder, &mapEncoder));
+    LE_ASSERT(COAP_BAD_REQUEST == le_avdataTest_ServerRequest(COAP_PUT,
+                           "/test/benchSettings/node0", ManySettingsPayload,
+                           cbor_encoder_get_buffer_size(&rootEncoder, ManySettingsPayload)));
+    LE_ASSERT_OK(le_avdata_GetInt("/benchSettings/node0/res0", &intVal));
+    LE_ASSERT(0 == intVal);
+
+    LE_INFO("Decoded and wrote %d settings (%zu bytes of CBOR) in %ld.%06ld s",
+            MANY_RESOURCES_COUNT, payloadLength, (long)writeTime.sec, (long)writeTime.usec);
+
+    LE_INFO("============= Test server write of %d settings passed ==============",
+            MANY_RESOURCES_COUNT);
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * main of the test
@@ -578,6 +757,12 @@ COMPONENT_INIT
     //Test - time series
     TestTimeseries();
 
+    //Test - many resources
+    TestManyResources();
+
+    //Test - server write of many settings
+    TestManySettingsWrite();
+
     LE_INFO("=============== avDataTest successful ===================");
 
     exit(EXIT_SUCCESS);
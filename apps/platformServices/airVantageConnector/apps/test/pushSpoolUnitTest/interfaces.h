@@ -0,0 +1,79 @@
+/**
+ * This module implements some stubs for push spool unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_avdata_interface.h"
+#include "le_avc_interface.h"
+#include "le_cfg_interface.h"
+#include "lwm2mcore.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open or close the simulated DM session
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_SetSession
+(
+    bool isOpened                   ///< [IN] Whether the DM session is opened
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the spool size read from the config tree by the next pushSpool_Init()
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_SetSpoolSize
+(
+    int32_t maxBytes                ///< [IN] Maximum number of bytes of the spool
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of buffers sent to the server since the last call to le_pushTest_ClearSent()
+ */
+//--------------------------------------------------------------------------------------------------
+size_t le_pushTest_GetSentCount
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a buffer sent to the server since the last call to le_pushTest_ClearSent()
+ *
+ * @return the buffer
+ */
+//--------------------------------------------------------------------------------------------------
+const uint8_t* le_pushTest_GetSent
+(
+    size_t index,                   ///< [IN] Index of the buffer
+    size_t* lengthPtr               ///< [OUT] Length of the buffer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the buffers sent to the server
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_ClearSent
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate the acknowledgement of the last buffer sent, or its failure
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_Ack
+(
+    lwm2mcore_AckResult_t result    ///< [IN] Acknowledgement result
+);
+
+#endif /* interfaces.h */
@@ -0,0 +1,461 @@
+/**
+ * This module implements the unit tests of the push spool.
+ *
+ * Buffers are pushed while no session is opened, so that they are saved in the spool, and the
+ * buffers sent to the server are compared with the pushed ones.  A restart of the AVC is simulated
+ * by initializing the push module again over the files left by the previous run.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "push.h"
+#include "pushSpool.h"
+#include "avcFsConfig.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of buffers pushed by the tests, identified by their index
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_BUFFERS             64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Highest segment index looked for in the spool directory
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_SEGMENT             256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of callbacks received for each pushed buffer, and last status received
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t CallbackCount[MAX_BUFFERS];
+static le_avdata_PushStatus_t CallbackStatus[MAX_BUFFERS];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the content of a buffer: length and bytes depend on the buffer index
+ *
+ * @return the buffer length
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t MakeBuffer
+(
+    size_t index,
+    uint8_t* bufferPtr
+)
+{
+    size_t length = 64 + (index * 37) % 200;
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        bufferPtr[i] = (uint8_t)(index + i * 3);
+    }
+
+    return length;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push callback: the context is the buffer index
+ */
+//--------------------------------------------------------------------------------------------------
+static void PushCallback
+(
+    le_avdata_PushStatus_t status,
+    void* contextPtr
+)
+{
+    size_t index = (size_t)contextPtr;
+
+    LE_ASSERT(index < MAX_BUFFERS);
+
+    CallbackCount[index]++;
+    CallbackStatus[index] = status;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a buffer with a callback
+ *
+ * @return the PushBuffer() result
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Push
+(
+    size_t index
+)
+{
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
+    size_t length = MakeBuffer(index, buffer);
+
+    CallbackCount[index] = 0;
+
+    return PushBuffer(buffer,
+                      length,
+                      LWM2MCORE_PUSH_CONTENT_ZCBOR,
+                      PushCallback,
+                      (void*)index);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check the content of a buffer sent to the server
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckSent
+(
+    size_t sentIndex,
+    size_t index
+)
+{
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
+    size_t length = MakeBuffer(index, buffer);
+    size_t sentLength;
+    const uint8_t* sentPtr;
+
+    LE_ASSERT(le_pushTest_GetSentCount() == sentIndex + 1);
+
+    sentPtr = le_pushTest_GetSent(sentIndex, &sentLength);
+
+    LE_INFO("Sent %zu: buffer %zu", sentIndex, index);
+    LE_ASSERT(sentLength == length);
+    LE_ASSERT(0 == memcmp(sentPtr, buffer, length));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate a restart of the AVC: the data in memory is lost and the spool is read again
+ */
+//--------------------------------------------------------------------------------------------------
+static void Restart
+(
+    void
+)
+{
+    le_pushTest_SetSession(false);
+    le_pushTest_ClearSent();
+    LE_ASSERT_OK(push_Init());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open the session and push the spooled buffers as the server acknowledges them
+ */
+//--------------------------------------------------------------------------------------------------
+static void OpenSession
+(
+    void
+)
+{
+    le_pushTest_SetSession(true);
+    le_pushTest_ClearSent();
+    push_Retry();
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffers pushed without session are sent in order once the session is opened, and removed from
+ * the spool as they are acknowledged
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestAppendAndCommit
+(
+    void
+)
+{
+    size_t freeBytes = pushSpool_GetFreeBytes();
+    size_t i;
+
+    LE_INFO("======== TestAppendAndCommit ========");
+
+    le_pushTest_SetSession(false);
+
+    for (i = 0; i < 3; i++)
+    {
+        LE_ASSERT(LE_BUSY == Push(i));
+    }
+
+    LE_ASSERT(pushSpool_GetFreeBytes() < freeBytes);
+    LE_ASSERT(IsPushBusy() == false);
+
+    OpenSession();
+
+    for (i = 0; i < 3; i++)
+    {
+        CheckSent(i, i);
+        LE_ASSERT(0 == CallbackCount[i]);
+
+        le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+
+        LE_ASSERT(1 == CallbackCount[i]);
+        LE_ASSERT(LE_AVDATA_PUSH_SUCCESS == CallbackStatus[i]);
+    }
+
+    LE_ASSERT(3 == le_pushTest_GetSentCount());
+    LE_ASSERT(pushSpool_IsEmpty());
+    LE_ASSERT(pushSpool_GetFreeBytes() == freeBytes);
+
+    // The spool is not used when the data can be sent right away
+    le_pushTest_ClearSent();
+    LE_ASSERT_OK(Push(3));
+    CheckSent(0, 3);
+    LE_ASSERT(pushSpool_GetFreeBytes() == freeBytes);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    LE_ASSERT(LE_AVDATA_PUSH_SUCCESS == CallbackStatus[3]);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Spooled buffers which are not acknowledged stay in the spool and are sent again, before the
+ * following ones.  Buffers which were not spooled are reported as failed.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestFailure
+(
+    void
+)
+{
+    size_t freeBytes = pushSpool_GetFreeBytes();
+
+    LE_INFO("======== TestFailure ========");
+
+    le_pushTest_SetSession(false);
+    LE_ASSERT(LE_BUSY == Push(10));
+    LE_ASSERT(LE_BUSY == Push(11));
+
+    OpenSession();
+    CheckSent(0, 10);
+
+    // Nothing else is sent until the next retry
+    le_pushTest_Ack(LWM2MCORE_ACK_TIMEOUT);
+    LE_ASSERT(0 == CallbackCount[10]);
+    LE_ASSERT(1 == le_pushTest_GetSentCount());
+    LE_ASSERT(pushSpool_GetFreeBytes() < freeBytes);
+
+    push_Retry();
+    CheckSent(1, 10);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    LE_ASSERT(1 == CallbackCount[10]);
+    LE_ASSERT(LE_AVDATA_PUSH_SUCCESS == CallbackStatus[10]);
+
+    CheckSent(2, 11);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    LE_ASSERT(1 == CallbackCount[11]);
+    LE_ASSERT(LE_AVDATA_PUSH_SUCCESS == CallbackStatus[11]);
+    LE_ASSERT(pushSpool_GetFreeBytes() == freeBytes);
+
+    // A spooled buffer not acknowledged before a restart is sent again after it
+    le_pushTest_SetSession(false);
+    LE_ASSERT(LE_BUSY == Push(12));
+    OpenSession();
+    CheckSent(0, 12);
+    le_pushTest_Ack(LWM2MCORE_ACK_TIMEOUT);
+
+    Restart();
+    OpenSession();
+    CheckSent(0, 12);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    LE_ASSERT(0 == CallbackCount[12]);
+    LE_ASSERT(pushSpool_GetFreeBytes() == freeBytes);
+
+    // Data sent right away is not spooled, so its failure is reported
+    le_pushTest_ClearSent();
+    LE_ASSERT_OK(Push(13));
+    le_pushTest_Ack(LWM2MCORE_ACK_TIMEOUT);
+    LE_ASSERT(1 == CallbackCount[13]);
+    LE_ASSERT(LE_AVDATA_PUSH_FAILED == CallbackStatus[13]);
+
+    push_Retry();
+    LE_ASSERT(1 == le_pushTest_GetSentCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The spool is replayed after a restart from the last saved cursor, so that buffers acknowledged
+ * since the cursor was saved are sent again, and callbacks are lost
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestReplayAfterRestart
+(
+    void
+)
+{
+    size_t freeBytes = pushSpool_GetFreeBytes();
+    size_t i;
+
+    LE_INFO("======== TestReplayAfterRestart ========");
+
+    le_pushTest_SetSession(false);
+
+    // More buffers than the push queue can hold
+    for (i = 20; i < 32; i++)
+    {
+        LE_ASSERT(LE_BUSY == Push(i));
+    }
+
+    OpenSession();
+
+    for (i = 20; i < 29; i++)
+    {
+        CheckSent(i - 20, i);
+        le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+        LE_ASSERT(LE_AVDATA_PUSH_SUCCESS == CallbackStatus[i]);
+    }
+
+    CheckSent(9, 29);
+
+    // The cursor was saved when the 8th buffer was acknowledged
+    Restart();
+    OpenSession();
+
+    for (i = 28; i < 32; i++)
+    {
+        CheckSent(i - 28, i);
+        le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    }
+
+    LE_ASSERT(4 == le_pushTest_GetSentCount());
+    LE_ASSERT(1 == CallbackCount[28]);
+    LE_ASSERT(0 == CallbackCount[29]);
+    LE_ASSERT(0 == CallbackCount[31]);
+    LE_ASSERT(pushSpool_IsEmpty());
+    LE_ASSERT(pushSpool_GetFreeBytes() == freeBytes);
+
+    // Nothing is replayed once everything is acknowledged
+    Restart();
+    OpenSession();
+    LE_ASSERT(0 == le_pushTest_GetSentCount());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A record torn by a power loss ends its segment: the records before it are replayed, and records
+ * appended after the restart go to a new segment
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestTornRecord
+(
+    void
+)
+{
+    static const uint8_t tornRecord[] = { 0x28, 0x00, 0x00, 0x00, 0x40, 0x00 };
+    char path[LE_FS_PATH_MAX_LEN] = "";
+    le_fs_FileRef_t fileRef;
+    int segment;
+
+    LE_INFO("======== TestTornRecord ========");
+
+    le_pushTest_SetSession(false);
+    LE_ASSERT(LE_BUSY == Push(40));
+    LE_ASSERT(LE_BUSY == Push(41));
+
+    // Append the start of a record to the last segment
+    for (segment = MAX_SEGMENT; segment >= 0; segment--)
+    {
+        snprintf(path, sizeof(path), "%s/%08x", PUSH_SPOOL_DIR, segment);
+
+        if (le_fs_Exists(path))
+        {
+            break;
+        }
+    }
+
+    LE_ASSERT(segment >= 0);
+    LE_ASSERT_OK(le_fs_Open(path, LE_FS_WRONLY | LE_FS_APPEND, &fileRef));
+    LE_ASSERT_OK(le_fs_Write(fileRef, tornRecord, sizeof(tornRecord)));
+    LE_ASSERT_OK(le_fs_Close(fileRef));
+
+    Restart();
+    LE_ASSERT(LE_BUSY == Push(42));
+
+    OpenSession();
+
+    CheckSent(0, 40);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    CheckSent(1, 41);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    CheckSent(2, 42);
+    le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+
+    LE_ASSERT(3 == le_pushTest_GetSentCount());
+    LE_ASSERT(0 == CallbackCount[41]);
+    LE_ASSERT(1 == CallbackCount[42]);
+    LE_ASSERT(pushSpool_IsEmpty());
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffers are refused once the spool is full
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestSpoolFull
+(
+    void
+)
+{
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
+    size_t length = MakeBuffer(50, buffer);
+    size_t i;
+
+    LE_INFO("======== TestSpoolFull ========");
+
+    // Room for one buffer more than the push queue holds
+    le_pushTest_SetSpoolSize((MAX_PUSH_QUEUE + 1) * (length + 16));
+    Restart();
+
+    for (i = 0; i < MAX_PUSH_QUEUE + 1; i++)
+    {
+        LE_ASSERT(LE_BUSY == PushBuffer(buffer, length, LWM2MCORE_PUSH_CONTENT_ZCBOR, NULL, NULL));
+    }
+
+    LE_ASSERT(!pushSpool_IsEmpty());
+    LE_ASSERT(LE_NOT_POSSIBLE == PushBuffer(buffer,
+                                            length,
+                                            LWM2MCORE_PUSH_CONTENT_ZCBOR,
+                                            NULL,
+                                            NULL));
+
+    OpenSession();
+
+    for (i = 0; i < MAX_PUSH_QUEUE + 1; i++)
+    {
+        LE_ASSERT(le_pushTest_GetSentCount() == i + 1);
+        le_pushTest_Ack(LWM2MCORE_ACK_RECEIVED);
+    }
+
+    LE_ASSERT(MAX_PUSH_QUEUE + 1 == le_pushTest_GetSentCount());
+    LE_ASSERT(pushSpool_GetFreeBytes() == (MAX_PUSH_QUEUE + 1) * (length + 16));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    LE_INFO("=============== Start pushSpoolUnitTest =====================");
+
+    // Start from an empty spool
+    le_fs_RemoveDirRecursive(PUSH_SPOOL_DIR);
+    LE_ASSERT_OK(push_Init());
+
+    TestAppendAndCommit();
+    TestFailure();
+    TestReplayAfterRestart();
+    TestTornRecord();
+    TestSpoolFull();
+
+    le_fs_RemoveDirRecursive(PUSH_SPOOL_DIR);
+
+    LE_INFO("=============== pushSpoolUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,269 @@
+/**
+ * This module implements some stubs for push spool unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "push.h"
+#include "avcClient.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of buffers sent to the server kept by the stub
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_SENT_BUFFERS        64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffer sent to the server
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];   ///< Buffer
+    size_t length;                              ///< Length of the buffer
+}
+SentBuffer_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffers sent to the server
+ */
+//--------------------------------------------------------------------------------------------------
+static SentBuffer_t SentBuffers[MAX_SENT_BUFFERS];
+static size_t SentCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulated DM session state
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSessionOpened = false;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Spool size returned by the config tree
+ */
+//--------------------------------------------------------------------------------------------------
+static int32_t SpoolMaxBytes = 512 * 1024;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Message identifier of the buffer waiting for its acknowledgement, and of the last buffer sent
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsWaitingAck = false;
+static uint16_t LastMid = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push acknowledgement callback set by the push module
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_PushAckCallback_t PushAckCallback = NULL;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create a read transaction (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn
+(
+    const char* basePath    ///< [IN] Path to the location to create the new iterator
+)
+{
+    return (le_cfg_IteratorRef_t)0x1001;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Cancel a transaction (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_CancelTxn
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Iterator to close
+)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read an integer value from the config tree: only the spool size is read (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_cfg_GetInt
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator to use as a basis for the transaction
+    const char* path,                   ///< [IN] Path to the target node
+    int32_t defaultValue                ///< [IN] Default value
+)
+{
+    return SpoolMaxBytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the push callback (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+void lwm2mcore_SetPushCallback
+(
+    lwm2mcore_PushAckCallback_t callbackP  ///< [IN] push callback pointer
+)
+{
+    PushAckCallback = callbackP;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the session type (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+le_avc_SessionType_t avcClient_GetSessionType
+(
+    void
+)
+{
+    return IsSessionOpened ? LE_AVC_DM_SESSION : LE_AVC_SESSION_INVALID;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a buffer to the server.  Like LwM2MCore, only one buffer can wait for its acknowledgement.
+ * (STUBBED FUNCTION)
+ *
+ * @return
+ *  - LE_OK             The buffer is sent
+ *  - LE_BUSY           A buffer is waiting for its acknowledgement
+ *  - LE_FAULT          There is no session
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t avcClient_Push
+(
+    uint8_t* payload,                       ///< [IN] Payload to push.
+    size_t payloadLength,                   ///< [IN] Payload length.
+    lwm2mcore_PushContent_t contentType,    ///< [IN] Content type.
+    uint16_t* midPtr                        ///< [OUT] Message identifier.
+)
+{
+    if (!IsSessionOpened)
+    {
+        return LE_FAULT;
+    }
+
+    if (IsWaitingAck)
+    {
+        return LE_BUSY;
+    }
+
+    LE_ASSERT(payloadLength <= MAX_CBOR_BUFFER_NUMBYTES);
+    LE_ASSERT(SentCount < MAX_SENT_BUFFERS);
+
+    memcpy(SentBuffers[SentCount].buffer, payload, payloadLength);
+    SentBuffers[SentCount].length = payloadLength;
+    SentCount++;
+
+    IsWaitingAck = true;
+    *midPtr = ++LastMid;
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Open or close the simulated DM session
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_SetSession
+(
+    bool isOpened                   ///< [IN] Whether the DM session is opened
+)
+{
+    IsSessionOpened = isOpened;
+
+    // Closing the session drops the transaction in progress
+    if (!isOpened)
+    {
+        IsWaitingAck = false;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Set the spool size read from the config tree by the next pushSpool_Init()
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_SetSpoolSize
+(
+    int32_t maxBytes                ///< [IN] Maximum number of bytes of the spool
+)
+{
+    SpoolMaxBytes = maxBytes;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of buffers sent to the server since the last call to le_pushTest_ClearSent()
+ */
+//--------------------------------------------------------------------------------------------------
+size_t le_pushTest_GetSentCount
+(
+    void
+)
+{
+    return SentCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a buffer sent to the server since the last call to le_pushTest_ClearSent()
+ *
+ * @return the buffer
+ */
+//--------------------------------------------------------------------------------------------------
+const uint8_t* le_pushTest_GetSent
+(
+    size_t index,                   ///< [IN] Index of the buffer
+    size_t* lengthPtr               ///< [OUT] Length of the buffer
+)
+{
+    LE_ASSERT(index < SentCount);
+
+    *lengthPtr = SentBuffers[index].length;
+    return SentBuffers[index].buffer;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the buffers sent to the server
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_ClearSent
+(
+    void
+)
+{
+    SentCount = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate the acknowledgement of the last buffer sent, or its failure
+ */
+//--------------------------------------------------------------------------------------------------
+void le_pushTest_Ack
+(
+    lwm2mcore_AckResult_t result    ///< [IN] Acknowledgement result
+)
+{
+    LE_ASSERT(IsWaitingAck);
+    LE_ASSERT(NULL != PushAckCallback);
+
+    IsWaitingAck = false;
+    PushAckCallback(result, LastMid);
+}
@@ -933,6 +933,44 @@ void PushMix_08()
 }
 
 
+// Push a record with several resources that is too large for a single push, the callback is
+// expected once all of its chunks are acknowledged
+void PushMix_09()
+{
+    LE_INFO("Running push of a record split in several chunks");
+
+    le_avdata_RecordRef_t recRef = le_avdata_CreateRecord();
+
+    le_result_t result = LE_OK;
+    int value = 0;
+    uint64_t timestamp = 1412320402000;
+
+    while (result == LE_OK)
+    {
+        result = le_avdata_RecordInt(recRef, "chunk/counter", value, timestamp);
+        if (result == LE_OK)
+        {
+            result = le_avdata_RecordFloat(recRef, "chunk/level", rand_float(0, 100), timestamp);
+        }
+        if (result == LE_OK)
+        {
+            result = le_avdata_RecordBool(recRef, "chunk/state", (value % 7) == 0, timestamp);
+        }
+        value++;
+        timestamp += 100;
+    }
+
+    LE_ASSERT(result == LE_NO_MEMORY);
+
+    result = le_avdata_PushRecord(recRef, PushCallbackRecord1, (void *)1);
+    LE_INFO("Pushing record in chunks: %s", LE_RESULT_TXT(result));
+    LE_ASSERT((result == LE_OK) || (result == LE_BUSY));
+
+    le_avdata_DeleteRecord(recRef);
+    LE_INFO("Pass");
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Component initializer.  Must return when done initializing.
@@ -1045,6 +1083,9 @@ COMPONENT_INIT
         case 31:
             PushMix_08();
             break;
+        case 32:
+            PushMix_09();
+            break;
         default:
             LE_INFO("Invalid test case");
             break;
@@ -0,0 +1,48 @@
+/**
+ * This module implements some stubs for time series unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _INTERFACES_H
+#define _INTERFACES_H
+
+#include "le_avdata_interface.h"
+#include "le_cfg_interface.h"
+#include "lwm2mcore.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of chunks pushed since the last call to le_tsTest_AckChunks()
+ */
+//--------------------------------------------------------------------------------------------------
+size_t le_tsTest_GetChunkCount
+(
+    void
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a chunk pushed since the last call to le_tsTest_AckChunks()
+ *
+ * @return the compressed chunk
+ */
+//--------------------------------------------------------------------------------------------------
+const uint8_t* le_tsTest_GetChunk
+(
+    size_t index,                   ///< [IN] Index of the chunk
+    size_t* lengthPtr               ///< [OUT] Length of the chunk
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate the acknowledgement of all the pushed chunks by the server, and forget them
+ */
+//--------------------------------------------------------------------------------------------------
+void le_tsTest_AckChunks
+(
+    le_avdata_PushStatus_t status   ///< [IN] Status reported for each chunk
+);
+
+#endif /* interfaces.h */
@@ -0,0 +1,891 @@
+/**
+ * This module implements the unit tests of the time series records.
+ *
+ * Samples are added to a record and the record is pushed.  The pushed chunks are decompressed and
+ * decoded, and compared with a reference model of the record: a plain table of the samples, sorted
+ * by timestamp.  The model computes the pushed values the way the encoder always did, from the
+ * absolute values of the samples, so the packing of the samples in the record is checked end to
+ * end.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "timeseriesData.h"
+#include "tinycbor/cbor.h"
+#include "zlib.h"
+
+#include <float.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resources of the records under test, and their types
+ */
+//--------------------------------------------------------------------------------------------------
+#define RESOURCE_INT                0
+#define RESOURCE_FLOAT              1
+#define RESOURCE_BOOL               2
+#define RESOURCE_STRING             3
+#define RESOURCE_OVERFLOW           4
+#define RESOURCE_COUNT              5
+
+static const char* ResourceNames[RESOURCE_COUNT] =
+{
+    "sensor/int",
+    "sensor/float",
+    "sensor/bool",
+    "sensor/string",
+    "sensor/overflow"
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * First timestamp of the records under test
+ */
+//--------------------------------------------------------------------------------------------------
+#define BASE_TIMESTAMP              1412320402000ULL
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of timestamps of the reference model
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_ROWS                    8192
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of the CBOR data of a chunk once decompressed
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_CHUNK_CBOR_NUMBYTES     (64 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sample of a resource in the reference model
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    bool isPresent;             ///< Whether the resource has a value with this timestamp
+    int32_t intValue;           ///< Value of the int resources
+    double floatValue;          ///< Value of the float resource
+    bool boolValue;             ///< Value of the bool resource
+    const char* strValuePtr;    ///< Value of the string resource, before truncation
+}
+Sample_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference model of the record under test: the sorted timestamps, the samples of each resource
+ * with these timestamps, and the resources in the order of the record header.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t Timestamps[MAX_ROWS];
+static Sample_t Samples[MAX_ROWS][RESOURCE_COUNT];
+static size_t RowCount = 0;
+static int ResourceOrder[RESOURCE_COUNT];
+static size_t ResourceOrderCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of the pseudo-random generator, so that the tests are reproducible
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t RandomState = 1;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push handler calls
+ */
+//--------------------------------------------------------------------------------------------------
+static int PushHandlerCount = 0;
+static le_avdata_PushStatus_t PushHandlerStatus;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * String values.  The last one is longer than the strings kept by a record.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* StringValues[] =
+{
+    "",
+    "a",
+    "open",
+    "closed",
+    "hello World",
+    "0123456789abcdefghijklmnopqrstuvwxyz"
+};
+
+static char LongStringValue[LE_AVDATA_STRING_VALUE_BYTES + 64];
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a pseudo-random number
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t Random
+(
+    void
+)
+{
+    // xorshift32
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 17;
+    RandomState ^= RandomState << 5;
+
+    return RandomState;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push handler
+ */
+//--------------------------------------------------------------------------------------------------
+static void PushHandler
+(
+    le_avdata_PushStatus_t status,  ///< [IN] Status of the push
+    void* contextPtr                ///< [IN] Context
+)
+{
+    LE_ASSERT((void*)0x1234 == contextPtr);
+
+    PushHandlerCount++;
+    PushHandlerStatus = status;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether a resource has a sample in the reference model
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ModelHasResource
+(
+    int resource
+)
+{
+    size_t row;
+
+    for (row = 0; row < RowCount; row++)
+    {
+        if (Samples[row][resource].isPresent)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Apply the addition of a sample to the reference model.  A sample that did not fit in the record
+ * is removed again, with its resource and its timestamp if nothing else uses them.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ModelAdd
+(
+    int resource,
+    const Sample_t* samplePtr,
+    uint64_t timestamp,
+    le_result_t result              ///< [IN] Result of the addition to the record
+)
+{
+    size_t row;
+    size_t i;
+
+    LE_ASSERT((LE_OK == result) || (LE_NO_MEMORY == result));
+
+    for (i = 0; i < ResourceOrderCount; i++)
+    {
+        if (ResourceOrder[i] == resource)
+        {
+            break;
+        }
+    }
+
+    if (i == ResourceOrderCount)
+    {
+        ResourceOrder[ResourceOrderCount++] = resource;
+    }
+
+    for (row = 0; (row < RowCount) && (Timestamps[row] < timestamp); row++)
+    {
+    }
+
+    if ((row == RowCount) || (Timestamps[row] != timestamp))
+    {
+        LE_ASSERT(RowCount < MAX_ROWS);
+
+        memmove(&Timestamps[row + 1], &Timestamps[row], (RowCount - row) * sizeof(Timestamps[0]));
+        memmove(&Samples[row + 1], &Samples[row], (RowCount - row) * sizeof(Samples[0]));
+        memset(&Samples[row], 0, sizeof(Samples[0]));
+        Timestamps[row] = timestamp;
+        RowCount++;
+    }
+
+    Samples[row][resource] = *samplePtr;
+    Samples[row][resource].isPresent = true;
+
+    if (LE_NO_MEMORY != result)
+    {
+        return;
+    }
+
+    Samples[row][resource].isPresent = false;
+
+    if (!ModelHasResource(resource))
+    {
+        for (i = 0; ResourceOrder[i] != resource; i++)
+        {
+        }
+        memmove(&ResourceOrder[i],
+                &ResourceOrder[i + 1],
+                (ResourceOrderCount - i - 1) * sizeof(ResourceOrder[0]));
+        ResourceOrderCount--;
+    }
+
+    for (i = 0; i < RESOURCE_COUNT; i++)
+    {
+        if (Samples[row][i].isPresent)
+        {
+            return;
+        }
+    }
+
+    memmove(&Timestamps[row], &Timestamps[row + 1], (RowCount - row - 1) * sizeof(Timestamps[0]));
+    memmove(&Samples[row], &Samples[row + 1], (RowCount - row - 1) * sizeof(Samples[0]));
+    RowCount--;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an int sample to the record and to the reference model
+ *
+ * @return the result of timeSeries_AddInt()
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddInt
+(
+    timeSeries_RecordRef_t recRef,
+    int resource,
+    int32_t value,
+    uint64_t timestamp
+)
+{
+    Sample_t sample = { .intValue = value };
+    le_result_t result = timeSeries_AddInt(recRef, ResourceNames[resource], value, timestamp);
+
+    ModelAdd(resource, &sample, timestamp, result);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a float sample to the record and to the reference model
+ *
+ * @return the result of timeSeries_AddFloat()
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddFloat
+(
+    timeSeries_RecordRef_t recRef,
+    double value,
+    uint64_t timestamp
+)
+{
+    Sample_t sample = { .floatValue = value };
+    le_result_t result = timeSeries_AddFloat(recRef,
+                                             ResourceNames[RESOURCE_FLOAT],
+                                             value,
+                                             timestamp);
+
+    ModelAdd(RESOURCE_FLOAT, &sample, timestamp, result);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a bool sample to the record and to the reference model
+ *
+ * @return the result of timeSeries_AddBool()
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddBool
+(
+    timeSeries_RecordRef_t recRef,
+    bool value,
+    uint64_t timestamp
+)
+{
+    Sample_t sample = { .boolValue = value };
+    le_result_t result = timeSeries_AddBool(recRef,
+                                            ResourceNames[RESOURCE_BOOL],
+                                            value,
+                                            timestamp);
+
+    ModelAdd(RESOURCE_BOOL, &sample, timestamp, result);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a string sample to the record and to the reference model
+ *
+ * @return the result of timeSeries_AddString()
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddString
+(
+    timeSeries_RecordRef_t recRef,
+    const char* valuePtr,
+    uint64_t timestamp
+)
+{
+    Sample_t sample = { .strValuePtr = valuePtr };
+    le_result_t result = timeSeries_AddString(recRef,
+                                              ResourceNames[RESOURCE_STRING],
+                                              valuePtr,
+                                              timestamp);
+
+    ModelAdd(RESOURCE_STRING, &sample, timestamp, result);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add a random sample of a random resource to the record and to the reference model
+ *
+ * @return the result of the addition
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddRandomSample
+(
+    timeSeries_RecordRef_t recRef,
+    uint64_t timestamp
+)
+{
+    switch (Random() % 4)
+    {
+        case RESOURCE_INT:
+            return AddInt(recRef, RESOURCE_INT, (int32_t)(Random() % 2000000) - 1000000, timestamp);
+
+        case RESOURCE_FLOAT:
+            return AddFloat(recRef, (double)(int32_t)Random() / 4096, timestamp);
+
+        case RESOURCE_BOOL:
+            return AddBool(recRef, Random() % 2, timestamp);
+
+        default:
+            return AddString(recRef,
+                             StringValues[Random() % NUM_ARRAY_MEMBERS(StringValues)],
+                             timestamp);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the next CBOR text string and compare it with the expected one
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckTextString
+(
+    CborValue* valuePtr,
+    const char* expectedPtr,
+    size_t expectedLen
+)
+{
+    char buffer[LE_AVDATA_STRING_VALUE_BYTES];
+    size_t len = sizeof(buffer);
+
+    LE_ASSERT(cbor_value_is_text_string(valuePtr));
+    LE_ASSERT(CborNoError == cbor_value_copy_text_string(valuePtr, buffer, &len, valuePtr));
+    LE_ASSERT(len == expectedLen);
+    LE_ASSERT(0 == memcmp(buffer, expectedPtr, len));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode the next CBOR double and check that it has the expected bits
+ */
+//--------------------------------------------------------------------------------------------------
+static void CheckDouble
+(
+    CborValue* valuePtr,
+    double expected
+)
+{
+    double value;
+
+    LE_ASSERT(cbor_value_is_double(valuePtr));
+    LE_ASSERT(CborNoError == cbor_value_get_double(valuePtr, &value));
+    LE_ASSERT(0 == memcmp(&value, &expected, sizeof(value)));
+    LE_ASSERT(CborNoError == cbor_value_advance_fixed(valuePtr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decode a pushed chunk and compare it with the timestamps of the reference model from firstRow
+ *
+ * @return the number of timestamps of the chunk
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t CheckChunk
+(
+    const uint8_t* chunkPtr,
+    size_t chunkLength,
+    size_t firstRow
+)
+{
+    static uint8_t cborBuffer[MAX_CHUNK_CBOR_NUMBYTES];
+    z_stream stream;
+    CborParser parser;
+    CborValue value;
+    CborValue map;
+    CborValue array;
+    size_t length;
+    size_t cborLength;
+    size_t rowCount;
+    size_t row;
+    size_t i;
+    int32_t lastIntValue[RESOURCE_COUNT] = {0};
+    double lastFloatValue[RESOURCE_COUNT] = {0};
+
+    memset(&stream, 0, sizeof(stream));
+    LE_ASSERT(Z_OK == inflateInit(&stream));
+    stream.next_in = (Bytef*)chunkPtr;
+    stream.avail_in = chunkLength;
+    stream.next_out = cborBuffer;
+    stream.avail_out = sizeof(cborBuffer);
+    LE_ASSERT(Z_STREAM_END == inflate(&stream, Z_FINISH));
+    cborLength = stream.total_out;
+    inflateEnd(&stream);
+
+    LE_ASSERT(CborNoError == cbor_parser_init(cborBuffer, cborLength, 0, &parser, &value));
+    LE_ASSERT(cbor_value_is_map(&value));
+    LE_ASSERT(CborNoError == cbor_value_get_map_length(&value, &length));
+    LE_ASSERT(NUM_TIME_SERIES_MAPS == length);
+    LE_ASSERT(CborNoError == cbor_value_enter_container(&value, &map));
+
+    // Header: the resource names
+    CheckTextString(&map, "h", 1);
+    LE_ASSERT(CborNoError == cbor_value_get_array_length(&map, &length));
+    LE_ASSERT(ResourceOrderCount == length);
+    LE_ASSERT(CborNoError == cbor_value_enter_container(&map, &array));
+    for (i = 0; i < ResourceOrderCount; i++)
+    {
+        const char* namePtr = ResourceNames[ResourceOrder[i]];
+        CheckTextString(&array, namePtr, strlen(namePtr));
+    }
+    LE_ASSERT(CborNoError == cbor_value_leave_container(&map, &array));
+
+    // Factors: 1 for the timestamps and the numbers, 0 for the other types
+    CheckTextString(&map, "f", 1);
+    LE_ASSERT(CborNoError == cbor_value_get_array_length(&map, &length));
+    LE_ASSERT(ResourceOrderCount + 1 == length);
+    LE_ASSERT(CborNoError == cbor_value_enter_container(&map, &array));
+    CheckDouble(&array, 1);
+    for (i = 0; i < ResourceOrderCount; i++)
+    {
+        bool isNumber = (ResourceOrder[i] != RESOURCE_BOOL)
+                        && (ResourceOrder[i] != RESOURCE_STRING);
+        CheckDouble(&array, isNumber ? 1 : 0);
+    }
+    LE_ASSERT(CborNoError == cbor_value_leave_container(&map, &array));
+
+    // Samples: the timestamp and the value of each resource, relative to the previous ones
+    CheckTextString(&map, "s", 1);
+    LE_ASSERT(CborNoError == cbor_value_get_array_length(&map, &length));
+    LE_ASSERT(0 == (length % (ResourceOrderCount + 1)));
+    rowCount = length / (ResourceOrderCount + 1);
+    LE_ASSERT(firstRow + rowCount <= RowCount);
+    LE_ASSERT(CborNoError == cbor_value_enter_container(&map, &array));
+
+    for (row = firstRow; row < firstRow + rowCount; row++)
+    {
+        uint64_t timestamp;
+
+        LE_ASSERT(cbor_value_is_unsigned_integer(&array));
+        LE_ASSERT(CborNoError == cbor_value_get_uint64(&array, &timestamp));
+        LE_ASSERT(timestamp == ((row == firstRow) ? Timestamps[row]
+                                                  : Timestamps[row] - Timestamps[row - 1]));
+        LE_ASSERT(CborNoError == cbor_value_advance_fixed(&array));
+
+        for (i = 0; i < ResourceOrderCount; i++)
+        {
+            int resource = ResourceOrder[i];
+            const Sample_t* samplePtr = &Samples[row][resource];
+            int64_t intValue;
+            bool boolValue;
+
+            if (!samplePtr->isPresent)
+            {
+                LE_ASSERT(cbor_value_is_null(&array));
+                LE_ASSERT(CborNoError == cbor_value_advance_fixed(&array));
+                continue;
+            }
+
+            switch (resource)
+            {
+                case RESOURCE_INT:
+                case RESOURCE_OVERFLOW:
+                    LE_ASSERT(cbor_value_is_integer(&array));
+                    LE_ASSERT(CborNoError == cbor_value_get_int64(&array, &intValue));
+                    LE_ASSERT(intValue ==
+                              (int64_t)samplePtr->intValue - lastIntValue[resource]);
+                    LE_ASSERT(CborNoError == cbor_value_advance_fixed(&array));
+                    lastIntValue[resource] = samplePtr->intValue;
+                    break;
+
+                case RESOURCE_FLOAT:
+                    CheckDouble(&array, (row == firstRow) ? samplePtr->floatValue :
+                                        (samplePtr->floatValue - lastFloatValue[resource]) * 1.0);
+                    lastFloatValue[resource] = samplePtr->floatValue;
+                    break;
+
+                case RESOURCE_BOOL:
+                    LE_ASSERT(cbor_value_is_boolean(&array));
+                    LE_ASSERT(CborNoError == cbor_value_get_boolean(&array, &boolValue));
+                    LE_ASSERT(boolValue == samplePtr->boolValue);
+                    LE_ASSERT(CborNoError == cbor_value_advance_fixed(&array));
+                    break;
+
+                default:
+                    length = strlen(samplePtr->strValuePtr);
+                    if (length > LE_AVDATA_STRING_VALUE_LEN)
+                    {
+                        length = LE_AVDATA_STRING_VALUE_LEN;
+                    }
+                    CheckTextString(&array, samplePtr->strValuePtr, length);
+                    break;
+            }
+        }
+    }
+
+    LE_ASSERT(cbor_value_at_end(&array));
+    LE_ASSERT(CborNoError == cbor_value_leave_container(&map, &array));
+    LE_ASSERT(cbor_value_at_end(&map));
+
+    return rowCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a record, check the pushed chunks against the reference model, and reset the model
+ *
+ * @return the number of pushed chunks
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t PushAndCheck
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    size_t chunkCount;
+    size_t row = 0;
+    size_t i;
+
+    LE_ASSERT_OK(timeSeries_PushRecord(recRef, PushHandler, (void*)0x1234));
+
+    chunkCount = le_tsTest_GetChunkCount();
+    LE_ASSERT(chunkCount > 0);
+
+    for (i = 0; i < chunkCount; i++)
+    {
+        const uint8_t* chunkPtr;
+        size_t chunkLength;
+        size_t rowCount;
+
+        chunkPtr = le_tsTest_GetChunk(i, &chunkLength);
+        rowCount = CheckChunk(chunkPtr, chunkLength, row);
+
+        // Only an empty record is pushed as a chunk without timestamps
+        LE_ASSERT((rowCount > 0) || (0 == RowCount));
+        row += rowCount;
+    }
+
+    LE_ASSERT(RowCount == row);
+
+    PushHandlerCount = 0;
+    le_tsTest_AckChunks(LE_AVDATA_PUSH_SUCCESS);
+    LE_ASSERT(1 == PushHandlerCount);
+    LE_ASSERT(LE_AVDATA_PUSH_SUCCESS == PushHandlerStatus);
+
+    LE_INFO("%zu timestamps pushed in %zu chunks", RowCount, chunkCount);
+
+    RowCount = 0;
+    ResourceOrderCount = 0;
+
+    return chunkCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the timestamps packed as delta-of-delta: periodic timestamps, jitter, and jumps of every
+ * size in both directions
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestDeltaOfDelta
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    static const int64_t deltas[] =
+    {
+        1, 2, 1, 1000, 1000, 999, 1001, 1003, 997, 60000, 1000, 5, 3600000, 7, 1000,
+        (1LL << 20) + 3, 1000, (1LL << 32) + 1, 1000, 1000, (1LL << 40), 1, 1000
+    };
+    uint64_t timestamp = BASE_TIMESTAMP;
+    int32_t value = 0;
+    size_t i;
+
+    LE_INFO("======== Test timestamp delta-of-delta ========");
+
+    // Periodic samples, then every delta above, then periodic samples again
+    for (i = 0; i < 100; i++)
+    {
+        LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, value, timestamp));
+        timestamp += 1000;
+        value += 3;
+    }
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(deltas); i++)
+    {
+        LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, value, timestamp));
+        timestamp += deltas[i];
+        value = (i % 2) ? (value + (1 << 29)) : -value;
+    }
+
+    for (i = 0; i < 100; i++)
+    {
+        LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, value, timestamp));
+        timestamp += 1000 + Random() % 3;
+        value -= 1;
+    }
+
+    // Large values on their own in a record
+    LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, INT32_MIN, timestamp));
+    PushAndCheck(recRef);
+
+    LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, INT32_MAX, timestamp));
+    PushAndCheck(recRef);
+
+    LE_INFO("======== Test timestamp delta-of-delta passed ========");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the float values packed as XOR with the previous value: identical values, values which fit
+ * in the window of the previous one, and values which need a new window
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestFloatXorWindow
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    // Each series starts a new record, so its second value needs a new window: with exactly 32
+    // leading zeros, then with more leading zeros than the 5 bits of the window can hold
+    static const double series[][4] =
+    {
+        { 1.0, 1.0 + 1.0 / (1 << 21), 1.0, 1.0 + 1.0 / (1 << 21) },
+        { 1.0, 1.0 + DBL_EPSILON, 1.0 + 3 * DBL_EPSILON, 1.0 + 2 * DBL_EPSILON }
+    };
+    static const double values[] =
+    {
+        21.5, 21.5, 21.5, 21.625, 21.75, 21.625, 21.5, -21.5, 21.5, 0.0, -0.0, 0.0,
+        1.0 / 3, 2.0 / 3, -1.0, 1.0, 1e-310, DBL_MIN, DBL_MAX, -DBL_MAX, 1.0, INFINITY, 1.0, 1.0
+    };
+    uint64_t timestamp = BASE_TIMESTAMP;
+    double temperature = 21.5;
+    size_t i;
+    size_t j;
+
+    LE_INFO("======== Test float XOR window ========");
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(series); i++)
+    {
+        for (j = 0; j < NUM_ARRAY_MEMBERS(series[i]); j++)
+        {
+            LE_ASSERT_OK(AddFloat(recRef, series[i][j], timestamp));
+            timestamp += 1000;
+        }
+        PushAndCheck(recRef);
+    }
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(values); i++)
+    {
+        LE_ASSERT_OK(AddFloat(recRef, values[i], timestamp));
+        timestamp += 1000;
+    }
+
+    // Slowly changing sensor, mostly using the window of the previous value
+    for (i = 0; i < 200; i++)
+    {
+        temperature += (double)((int)(Random() % 5) - 2) / 8;
+        LE_ASSERT_OK(AddFloat(recRef, temperature, timestamp));
+        timestamp += 1000;
+    }
+
+    // Any bits but NaN
+    for (i = 0; i < 100; i++)
+    {
+        uint64_t bits = ((uint64_t)Random() << 32) | Random();
+        double value;
+
+        memcpy(&value, &bits, sizeof(value));
+        if (isnan(value))
+        {
+            value = -1.5;
+        }
+
+        LE_ASSERT_OK(AddFloat(recRef, value, timestamp));
+        timestamp += 1000;
+    }
+
+    PushAndCheck(recRef);
+
+    LE_INFO("======== Test float XOR window passed ========");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the samples added out of order: timestamps inserted before and between the existing ones,
+ * and values of existing timestamps replaced, for every type
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestOutOfOrder
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    size_t i;
+
+    LE_INFO("======== Test out-of-order samples ========");
+
+    // The first timestamp is inserted before the existing one, then in the middle of them
+    LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, 10, BASE_TIMESTAMP + 5000));
+    LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, 20, BASE_TIMESTAMP + 1000));
+    LE_ASSERT_OK(AddFloat(recRef, 2.5, BASE_TIMESTAMP + 3000));
+    LE_ASSERT_OK(AddBool(recRef, true, BASE_TIMESTAMP + 1000));
+    LE_ASSERT_OK(AddString(recRef, "first", BASE_TIMESTAMP));
+    LE_ASSERT_OK(AddInt(recRef, RESOURCE_INT, 30, BASE_TIMESTAMP + 1000));
+    LE_ASSERT_OK(AddString(recRef, LongStringValue, BASE_TIMESTAMP + 2000));
+    PushAndCheck(recRef);
+
+    // Random timestamps in a small range: many insertions and replacements in long columns
+    for (i = 0; i < 2000; i++)
+    {
+        LE_ASSERT_OK(AddRandomSample(recRef, BASE_TIMESTAMP + (Random() % 200) * 10));
+    }
+    PushAndCheck(recRef);
+
+    LE_INFO("======== Test out-of-order samples passed ========");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test the samples which do not fit in a full record: they must be removed without changing the
+ * rest of the record, whether they were appended, inserted or replacing an existing value
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestOverflowRollback
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    uint64_t timestamp = BASE_TIMESTAMP;
+    le_result_t result;
+    size_t i;
+
+    LE_INFO("======== Test overflow rollback ========");
+
+    do
+    {
+        result = AddRandomSample(recRef, timestamp);
+        timestamp += 1000 + Random() % 2;
+    }
+    while (LE_OK == result);
+
+    LE_ASSERT(LE_NO_MEMORY == result);
+    LE_INFO("Record full with %zu timestamps", RowCount);
+
+    // A new resource and a new timestamp do not fit either
+    LE_ASSERT(LE_NO_MEMORY == AddInt(recRef, RESOURCE_OVERFLOW, 1, timestamp));
+    LE_ASSERT(LE_NO_MEMORY == AddString(recRef, LongStringValue, timestamp));
+
+    // Samples inserted or replaced in the middle of the record, which may or may not fit
+    for (i = 0; i < 50; i++)
+    {
+        uint64_t oldTimestamp = Timestamps[Random() % RowCount];
+
+        result = AddRandomSample(recRef, oldTimestamp + ((i % 2) ? 0 : 500));
+        LE_ASSERT((LE_OK == result) || (LE_NO_MEMORY == result));
+        result = AddString(recRef, LongStringValue, oldTimestamp);
+        LE_ASSERT((LE_OK == result) || (LE_NO_MEMORY == result));
+    }
+
+    // A full record does not fit in a single push
+    LE_ASSERT(PushAndCheck(recRef) > 1);
+
+    // The record is empty and usable again after the push
+    LE_ASSERT_OK(AddInt(recRef, RESOURCE_OVERFLOW, 1, timestamp));
+    PushAndCheck(recRef);
+
+    LE_INFO("======== Test overflow rollback passed ========");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main of the test
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    timeSeries_RecordRef_t recRef;
+
+    LE_INFO("=============== Start timeseriesUnitTest =====================");
+
+    memset(LongStringValue, 'x', sizeof(LongStringValue) - 1);
+    LongStringValue[sizeof(LongStringValue) - 1] = '\0';
+
+    LE_ASSERT_OK(timeSeries_Init());
+    LE_ASSERT_OK(timeSeries_Create(&recRef));
+
+    // An empty record is pushed as a chunk without samples
+    PushAndCheck(recRef);
+
+    TestDeltaOfDelta(recRef);
+    TestFloatXorWindow(recRef);
+    TestOutOfOrder(recRef);
+    TestOverflowRollback(recRef);
+
+    timeSeries_Delete(recRef);
+
+    LE_INFO("=============== timeseriesUnitTest successful ===================");
+
+    exit(EXIT_SUCCESS);
+}
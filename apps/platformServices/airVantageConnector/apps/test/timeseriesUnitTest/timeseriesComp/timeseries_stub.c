@@ -0,0 +1,192 @@
+/**
+ * This module implements some stubs for time series unit tests.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "push.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Chunk pushed by the time series record under test
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];   ///< Compressed chunk
+    size_t length;                              ///< Length of the chunk
+    le_avdata_CallbackResultFunc_t handlerPtr;  ///< Handler called when the chunk is acknowledged
+    void* contextPtr;                           ///< Context of the handler
+}
+Chunk_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Chunks pushed and not acknowledged yet
+ */
+//--------------------------------------------------------------------------------------------------
+static Chunk_t Chunks[MAX_PUSH_QUEUE];
+static size_t ChunkCount = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create a read transaction (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_IteratorRef_t le_cfg_CreateReadTxn
+(
+    const char* basePath    ///< [IN] Path to the location to create the new iterator
+)
+{
+    return (le_cfg_IteratorRef_t)0x1001;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Cancel a transaction (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_CancelTxn
+(
+    le_cfg_IteratorRef_t iteratorRef    ///< [IN] Iterator to close
+)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a string value from the config tree: the default value is returned (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_cfg_GetString
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator to use as a basis for the transaction
+    const char* path,                   ///< [IN] Path to the target node
+    char* value,                        ///< [OUT] Buffer to write the value into
+    size_t valueNumElements,            ///< [IN] Size of the value buffer
+    const char* defaultValue            ///< [IN] Default value
+)
+{
+    return le_utf8_Copy(value, defaultValue, valueNumElements, NULL);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read an integer value from the config tree: the default value is returned (STUBBED FUNCTION)
+ */
+//--------------------------------------------------------------------------------------------------
+int32_t le_cfg_GetInt
+(
+    le_cfg_IteratorRef_t iteratorRef,   ///< [IN] Iterator to use as a basis for the transaction
+    const char* path,                   ///< [IN] Path to the target node
+    int32_t defaultValue                ///< [IN] Default value
+)
+{
+    return defaultValue;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of free slots in the push queue
+ */
+//--------------------------------------------------------------------------------------------------
+size_t push_GetFreeSlotCount
+(
+    void
+)
+{
+    return MAX_PUSH_QUEUE - ChunkCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Push a buffer: the buffer is kept until it is acknowledged by le_tsTest_AckChunks()
+ *
+ * @return
+ *  - LE_OK             The first buffer is pushed
+ *  - LE_BUSY           The buffer is queued behind the first one
+ *  - LE_FAULT          The buffer is too large or the queue is full
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t PushBuffer
+(
+    uint8_t* bufferPtr,
+    size_t bufferLength,
+    lwm2mcore_PushContent_t contentType,
+    le_avdata_CallbackResultFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    LE_ASSERT(LWM2MCORE_PUSH_CONTENT_ZCBOR == contentType);
+
+    if ((bufferLength > MAX_CBOR_BUFFER_NUMBYTES) || (ChunkCount >= MAX_PUSH_QUEUE))
+    {
+        return LE_FAULT;
+    }
+
+    memcpy(Chunks[ChunkCount].buffer, bufferPtr, bufferLength);
+    Chunks[ChunkCount].length = bufferLength;
+    Chunks[ChunkCount].handlerPtr = handlerPtr;
+    Chunks[ChunkCount].contextPtr = contextPtr;
+    ChunkCount++;
+
+    return (1 == ChunkCount) ? LE_OK : LE_BUSY;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of chunks pushed since the last call to le_tsTest_AckChunks()
+ */
+//--------------------------------------------------------------------------------------------------
+size_t le_tsTest_GetChunkCount
+(
+    void
+)
+{
+    return ChunkCount;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a chunk pushed since the last call to le_tsTest_AckChunks()
+ *
+ * @return the compressed chunk
+ */
+//--------------------------------------------------------------------------------------------------
+const uint8_t* le_tsTest_GetChunk
+(
+    size_t index,                   ///< [IN] Index of the chunk
+    size_t* lengthPtr               ///< [OUT] Length of the chunk
+)
+{
+    LE_ASSERT(index < ChunkCount);
+
+    *lengthPtr = Chunks[index].length;
+    return Chunks[index].buffer;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Simulate the acknowledgement of all the pushed chunks by the server, and forget them
+ */
+//--------------------------------------------------------------------------------------------------
+void le_tsTest_AckChunks
+(
+    le_avdata_PushStatus_t status   ///< [IN] Status reported for each chunk
+)
+{
+    size_t i;
+
+    for (i = 0; i < ChunkCount; i++)
+    {
+        if (NULL != Chunks[i].handlerPtr)
+        {
+            Chunks[i].handlerPtr(status, Chunks[i].contextPtr);
+        }
+    }
+
+    ChunkCount = 0;
+}
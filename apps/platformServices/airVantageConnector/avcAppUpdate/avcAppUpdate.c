@@ -13,6 +13,7 @@
 #include "le_print.h"
 #include "appCfg.h"
 #include "assetData.h"
+#include "avData.h"
 #include "avcServer.h"
 #include "packageDownloader.h"
 #include "avcAppUpdate.h"
@@ -825,6 +826,9 @@ static void DeleteAssetDataSetting
     const char* appNamePtr
 )
 {
+    // Write the pending setting updates first, so that they don't recreate the deleted entry
+    avData_FlushSettings();
+
     // Delete setting entry from configTree
     le_cfg_IteratorRef_t iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
     le_cfg_DeleteNode(iterRef, appNamePtr);
@@ -56,6 +56,7 @@ static const char* CredentialLocations[LWM2MCORE_CREDENTIAL_MAX] = {
     "dm_server_public_key",             ///< LWM2MCORE_CREDENTIAL_DM_SERVER_PUBLIC_KEY
     "LWM2M_DM_PSK_SECRET",              ///< LWM2MCORE_CREDENTIAL_DM_SECRET_KEY
     "LWM2M_DM_SERVER_ADDR",             ///< LWM2MCORE_CREDENTIAL_DM_ADDRESS
+    "LWM2M_DTLS_SESSION",               ///< LWM2MCORE_CREDENTIAL_DTLS_SESSION
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -54,6 +54,37 @@
 //--------------------------------------------------------------------------------------------------
 #define CFG_ASSET_SETTING_PATH "/apps/avcService/settings"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delay in ms between a setting update and the config tree write transaction storing it.  The
+ * updates received meanwhile are stored by the same transaction.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SETTING_FLUSH_INTERVAL_MS 1000
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of pending setting updates which triggers a config tree write without waiting for the
+ * flush interval.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_PENDING_SETTINGS 256
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Private directory, in the avcService writeable area, where the config tree exports the settings
+ * of an app to restore them. It is only accessible by avcService, unlike /tmp.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SETTING_EXPORT_DIR_PATH "/legato/systems/current/appsWriteable/avcService/settingsExport"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Template of the unique export file names, created by mkstemp() in SETTING_EXPORT_DIR_PATH
+ */
+//--------------------------------------------------------------------------------------------------
+#define SETTING_EXPORT_FILE_TEMPLATE SETTING_EXPORT_DIR_PATH "/avcSettingsXXXXXX"
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  DOT - Path delimiter string
@@ -260,6 +291,86 @@ typedef struct
 AssetData_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Setting update waiting to be written to the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char path[LE_AVDATA_PATH_NAME_BYTES];       ///< Path relative to CFG_ASSET_SETTING_PATH (key
+                                                ///< in PendingSettingMap).
+    le_avdata_DataType_t dataType;              ///< Data type of the value.
+    AssetValue_t value;                         ///< Value, string allocated from StringPool.
+    le_dls_Link_t link;                         ///< Link in PendingSettingList.
+}
+PendingSetting_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Node of the asset data path tree.  There is a node for every asset data path and for every path
+ * above one (e.g., "/a/b/c" has the nodes "/a", "/a/b" and "/a/b/c" below the root node "/").
+ * Asset data are always leaves, since an asset data path can't be above or below another one.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct PathNode
+{
+    const char* path;                           ///< Path of the node (key in PathNodeMap).
+    AssetData_t* assetDataPtr;                  ///< Asset data at this path, NULL if inner node.
+    struct PathNode* parentPtr;                 ///< Node directly above this one.
+    le_dls_List_t children;                     ///< Nodes directly below this one.
+    le_dls_Link_t link;                         ///< Link in the parent's list of children.
+}
+PathNode_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function called for each asset data found below a path by VisitAssetData().
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*AssetDataVisitor_t)
+(
+    const char* path,                           ///< [IN] Asset data path
+    AssetData_t* assetDataPtr,                  ///< [IN] Asset data
+    void* contextPtr                            ///< [IN] Context given to VisitAssetData()
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map of the asset data path tree nodes, keyed by path.  Together with the tree, it finds an asset
+ * data, and whether a path is above or below an asset data path, in a number of lookups bounded by
+ * the path depth instead of the number of asset data.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t PathNodeMap;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Path tree node memory pool.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PathNodePool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Root node of the asset data path tree.
+ */
+//--------------------------------------------------------------------------------------------------
+static PathNode_t RootPathNode =
+{
+    .path = SLASH_DELIMITER_STRING,
+    .assetDataPtr = NULL,
+    .parentPtr = NULL,
+    .children = LE_DLS_LIST_INIT,
+    .link = LE_DLS_LINK_INIT
+};
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Structure representing an argument in an Argument List.
@@ -345,11 +456,185 @@ static uint32_t RequestCount = 0;
 //--------------------------------------------------------------------------------------------------
 static bool IsRestored = true;
 
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pending setting update memory pool.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PendingSettingPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Map of the pending setting updates, keyed by setting path.  A setting updated several times
+ * before a flush is written once, with its last value.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t PendingSettingMap;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pending setting updates, in update order.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_dls_List_t PendingSettingList = LE_DLS_LIST_INIT;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Timer writing the pending setting updates to the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_timer_Ref_t SettingFlushTimerRef;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /* Helper functions                                                                               */
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create a path tree node and add it to the PathNodeMap.
+ *
+ * @return The new node.
+ */
+//--------------------------------------------------------------------------------------------------
+static PathNode_t* CreatePathNode
+(
+    const char* path,           ///< [IN] Node path, must stay valid as long as the node exists
+    AssetData_t* assetDataPtr   ///< [IN] Asset data at this path, NULL for an inner node
+)
+{
+    PathNode_t* nodePtr = le_mem_ForceAlloc(PathNodePool);
+
+    nodePtr->path = path;
+    nodePtr->assetDataPtr = assetDataPtr;
+    nodePtr->parentPtr = NULL;
+    nodePtr->children = LE_DLS_LIST_INIT;
+    nodePtr->link = LE_DLS_LINK_INIT;
+
+    le_hashmap_Put(PathNodeMap, nodePtr->path, nodePtr);
+
+    return nodePtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add an asset data to the path tree, with the inner nodes above it that don't exist yet.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddPathNodes
+(
+    const char* assetPathPtr,   ///< [IN] Asset data path, as stored in the AssetDataMap
+    AssetData_t* assetDataPtr   ///< [IN] Asset data
+)
+{
+    char parentPath[LE_AVDATA_PATH_NAME_BYTES];
+    PathNode_t* nodePtr = CreatePathNode(assetPathPtr, assetDataPtr);
+    PathNode_t* parentNodePtr;
+    char* slashPtr;
+
+    LE_ASSERT(le_utf8_Copy(parentPath, assetPathPtr, sizeof(parentPath), NULL) == LE_OK);
+
+    // Walk up the path until reaching a node that already exists.
+    do
+    {
+        slashPtr = strrchr(parentPath, SLASH_DELIMITER_CHAR);
+        LE_ASSERT(slashPtr != NULL);
+
+        if (slashPtr == parentPath)
+        {
+            parentNodePtr = &RootPathNode;
+        }
+        else
+        {
+            *slashPtr = '\0';
+            parentNodePtr = le_hashmap_Get(PathNodeMap, parentPath);
+        }
+
+        bool isNew = (parentNodePtr == NULL);
+
+        if (isNew)
+        {
+            char* pathPtr = le_mem_ForceAlloc(AssetPathPool);
+            LE_ASSERT(le_utf8_Copy(pathPtr, parentPath, LE_AVDATA_PATH_NAME_BYTES, NULL) == LE_OK);
+
+            parentNodePtr = CreatePathNode(pathPtr, NULL);
+        }
+
+        nodePtr->parentPtr = parentNodePtr;
+        le_dls_Queue(&parentNodePtr->children, &nodePtr->link);
+
+        nodePtr = isNew ? parentNodePtr : NULL;
+    }
+    while (nodePtr != NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove an asset data from the path tree, with the inner nodes above it that have nothing below
+ * them anymore.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemovePathNodes
+(
+    const char* assetPathPtr    ///< [IN] Asset data path
+)
+{
+    PathNode_t* nodePtr = le_hashmap_Get(PathNodeMap, assetPathPtr);
+
+    while ((nodePtr != NULL) && (nodePtr != &RootPathNode) && le_dls_IsEmpty(&nodePtr->children))
+    {
+        PathNode_t* parentNodePtr = nodePtr->parentPtr;
+
+        le_hashmap_Remove(PathNodeMap, nodePtr->path);
+        le_dls_Remove(&parentNodePtr->children, &nodePtr->link);
+
+        // The asset data path belongs to the AssetDataMap, but inner node paths are ours.
+        if (nodePtr->assetDataPtr == NULL)
+        {
+            le_mem_Release((void*)nodePtr->path);
+        }
+        le_mem_Release(nodePtr);
+
+        nodePtr = parentNodePtr;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Call a function for every asset data at or below a path tree node.
+ */
+//--------------------------------------------------------------------------------------------------
+static void VisitAssetData
+(
+    PathNode_t* nodePtr,            ///< [IN] Path tree node
+    AssetDataVisitor_t visitorFunc, ///< [IN] Function to call
+    void* contextPtr                ///< [IN] Context for the function
+)
+{
+    if (nodePtr->assetDataPtr != NULL)
+    {
+        visitorFunc(nodePtr->path, nodePtr->assetDataPtr, contextPtr);
+        return;
+    }
+
+    le_dls_Link_t* linkPtr = le_dls_Peek(&nodePtr->children);
+
+    while (linkPtr != NULL)
+    {
+        VisitAssetData(CONTAINER_OF(linkPtr, PathNode_t, link), visitorFunc, contextPtr);
+
+        linkPtr = le_dls_PeekNext(&nodePtr->children, linkPtr);
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Handler for client session closes
@@ -374,6 +659,7 @@ static void ClientCloseSessionHandler
         if (assetDataPtr->msgRef == sessionRef)
         {
             LE_DEBUG("Removing asset data: %s", assetPathPtr);
+            RemovePathNodes(assetPathPtr);
             le_hashmap_Remove(AssetDataMap, assetPathPtr);
             le_mem_Release(assetPathPtr);
             le_mem_Release(assetDataPtr);
@@ -643,17 +929,9 @@ static bool IsPathParent
     const char* path ///< [IN] Asset data path
 )
 {
-    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+    PathNode_t* nodePtr = le_hashmap_Get(PathNodeMap, path);
 
-    while (le_hashmap_NextNode(iter) == LE_OK)
-    {
-        if (le_path_IsSubpath(path, le_hashmap_GetKey(iter), SLASH_DELIMITER_STRING))
-        {
-            return true;
-        }
-    }
-
-    return false;
+    return ((nodePtr != NULL) && !le_dls_IsEmpty(&nodePtr->children));
 }
 
 
@@ -667,13 +945,25 @@ static bool IsPathChild
     const char* path ///< [IN] Asset data path
 )
 {
-    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+    char parentPath[LE_AVDATA_PATH_NAME_BYTES];
+    char* slashPtr;
 
-    while (le_hashmap_NextNode(iter) == LE_OK)
+    if (le_utf8_Copy(parentPath, path, sizeof(parentPath), NULL) != LE_OK)
+    {
+        return false;
+    }
+
+    // The first node found above the path tells: the nodes above an inner node are inner nodes.
+    while (((slashPtr = strrchr(parentPath, SLASH_DELIMITER_CHAR)) != NULL) &&
+           (slashPtr != parentPath))
     {
-        if (le_path_IsSubpath(le_hashmap_GetKey(iter), path, SLASH_DELIMITER_STRING))
+        *slashPtr = '\0';
+
+        PathNode_t* nodePtr = le_hashmap_Get(PathNodeMap, parentPath);
+
+        if (nodePtr != NULL)
         {
-            return true;
+            return (nodePtr->assetDataPtr != NULL);
         }
     }
 
@@ -735,23 +1025,7 @@ static AssetData_t* GetAssetData
     const char* path  ///< [IN] Asset data path
 )
 {
-    AssetData_t* assetDataPtr = NULL;
-
-    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
-
-    while (le_hashmap_NextNode(iter) == LE_OK)
-    {
-        const char* key = le_hashmap_GetKey(iter);
-        LE_ASSERT(NULL != key);
-
-        if (strcmp(path, key) == 0)
-        {
-            assetDataPtr = le_hashmap_GetValue(iter);
-            break;
-        }
-    }
-
-    return assetDataPtr;
+    return le_hashmap_Get(AssetDataMap, path);
 }
 
 
@@ -882,25 +1156,49 @@ static void GetNamespacedPath
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Check if the path exists in the hashmap
+ * Gets the asset value of an asset data that was already looked up.
  *
  * @return:
- *      - LE_NOT_FOUND - if the path does not exist in asset data map
- *      - LE_OK - if path exists
+ *      - LE_NOT_PERMITTED - asset data being accessed does not have the right permission
+ *      - LE_OK - access successful.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t IsPathFound
+static le_result_t ReadAssetData
 (
-    const char* path                  ///< [IN] Asset data path
+    AssetData_t* assetDataPtr,         ///< [IN] Asset data
+    const char* namespacedPath,        ///< [IN] Name spaced asset data path
+    AssetValue_t* valuePtr,            ///< [OUT] Asset value
+    le_avdata_DataType_t* dataTypePtr, ///< [OUT] Asset value data type
+    bool isClient                      ///< [IN] Is it client or server access
 )
 {
-    AssetData_t* assetDataPtr = GetAssetData(path);
+    // Check access permission
+    if ((!isClient && ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) !=
+                      LE_AVDATA_ACCESS_READ)) ||
+        (isClient && ((assetDataPtr->clientAccess & LE_AVDATA_ACCESS_READ) !=
+                     LE_AVDATA_ACCESS_READ)))
+    {
+        char* str = isClient ? "client" : "server";
+        LE_ERROR("Asset (%s) does not have read permission for %s access.", namespacedPath, str);
+        return LE_NOT_PERMITTED;
+    }
 
-    if (assetDataPtr == NULL)
+    // Call registered handler.
+    if ((!isClient) && (assetDataPtr->handlerPtr != NULL))
     {
-        return LE_NOT_FOUND;
+        le_avdata_ArgumentListRef_t argListRef
+             = le_ref_CreateRef(ArgListRefMap, &assetDataPtr->arguments);
+
+        assetDataPtr->handlerPtr(namespacedPath, LE_AVDATA_ACCESS_READ,
+                                 argListRef, assetDataPtr->contextPtr);
+
+        le_ref_DeleteRef(ArgListRefMap, argListRef);
     }
 
+    // Get the value.
+    *valuePtr = assetDataPtr->value;
+    *dataTypePtr = assetDataPtr->dataType;
+
     return LE_OK;
 }
 
@@ -947,124 +1245,166 @@ static le_result_t GetVal
         return LE_NOT_FOUND;
     }
 
-    // Check access permission
-    if ((!isClient && ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) !=
-                      LE_AVDATA_ACCESS_READ)) ||
-        (isClient && ((assetDataPtr->clientAccess & LE_AVDATA_ACCESS_READ) !=
-                     LE_AVDATA_ACCESS_READ)))
-    {
-        char* str = isClient ? "client" : "server";
-        LE_ERROR("Asset (%s) does not have read permission for %s access.", namespacedPath, str);
-        return LE_NOT_PERMITTED;
-    }
-
-    // Call registered handler.
-    if ((!isClient) && (assetDataPtr->handlerPtr != NULL))
-    {
-        le_avdata_ArgumentListRef_t argListRef
-             = le_ref_CreateRef(ArgListRefMap, &assetDataPtr->arguments);
-
-        assetDataPtr->handlerPtr(namespacedPath, LE_AVDATA_ACCESS_READ,
-                                 argListRef, assetDataPtr->contextPtr);
-
-        le_ref_DeleteRef(ArgListRefMap, argListRef);
-    }
-
-    // Get the value.
-    *valuePtr = assetDataPtr->value;
-    *dataTypePtr = assetDataPtr->dataType;
-
-    return LE_OK;
+    return ReadAssetData(assetDataPtr, namespacedPath, valuePtr, dataTypePtr, isClient);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Store asset data into the cfgTree to keep them persistent if legato or app restarts.
+ * Write the pending setting updates to the config tree, in a single write transaction.
  */
 //--------------------------------------------------------------------------------------------------
-static void StoreData
+static void FlushSettings
 (
-    const char* path,              ///< [IN] Asset data path
-    AssetValue_t value,            ///< [IN] Asset value
-    le_avdata_DataType_t dataType, ///< [IN] Asset value data type
-    le_cfg_IteratorRef_t iterRef   ///< [IN] Iterator to config tree setting
+    void
 )
 {
-    if (NULL == iterRef)
+    le_dls_Link_t* linkPtr;
+    le_cfg_IteratorRef_t iterRef;
+    size_t count = 0;
+
+    le_timer_Stop(SettingFlushTimerRef);
+
+    if (le_dls_IsEmpty(&PendingSettingList))
     {
-        LE_DEBUG("Asset data setting not stored to config tree");
         return;
     }
 
-    switch (dataType)
+    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
+
+    while (NULL != (linkPtr = le_dls_Pop(&PendingSettingList)))
     {
-        case LE_AVDATA_DATA_TYPE_NONE:
-            break;
-        case LE_AVDATA_DATA_TYPE_INT:
-            le_cfg_SetInt(iterRef, path + 1, value.intValue);
-            break;
-        case LE_AVDATA_DATA_TYPE_FLOAT:
-            le_cfg_SetFloat(iterRef, path + 1, value.floatValue);
-            break;
-        case LE_AVDATA_DATA_TYPE_BOOL:
-            le_cfg_SetBool(iterRef, path + 1, value.boolValue);
-            break;
-        case LE_AVDATA_DATA_TYPE_STRING:
-            le_cfg_SetString(iterRef, path + 1, value.strValuePtr);
-            break;
-        default:
-            LE_ERROR("Invalid data type.");
-            break;
+        PendingSetting_t* settingPtr = CONTAINER_OF(linkPtr, PendingSetting_t, link);
+
+        switch (settingPtr->dataType)
+        {
+            case LE_AVDATA_DATA_TYPE_INT:
+                le_cfg_SetInt(iterRef, settingPtr->path, settingPtr->value.intValue);
+                break;
+            case LE_AVDATA_DATA_TYPE_FLOAT:
+                le_cfg_SetFloat(iterRef, settingPtr->path, settingPtr->value.floatValue);
+                break;
+            case LE_AVDATA_DATA_TYPE_BOOL:
+                le_cfg_SetBool(iterRef, settingPtr->path, settingPtr->value.boolValue);
+                break;
+            case LE_AVDATA_DATA_TYPE_STRING:
+                le_cfg_SetString(iterRef, settingPtr->path, settingPtr->value.strValuePtr);
+                le_mem_Release(settingPtr->value.strValuePtr);
+                break;
+            default:
+                LE_ERROR("Invalid data type.");
+                break;
+        }
+
+        le_hashmap_Remove(PendingSettingMap, settingPtr->path);
+        le_mem_Release(settingPtr);
+        count++;
     }
+
+    le_cfg_CommitTxn(iterRef);
+
+    LE_DEBUG("%zu setting updates stored to config tree", count);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Checks asset value associated with the provided asset data path if dry run flag is set.
- * Otherwise, sets asset value associated with the provided asset data path.
+ * Timer handler writing the pending setting updates to the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SettingFlushTimerHandler
+(
+    le_timer_Ref_t timerRef    ///< [IN] Timer reference
+)
+{
+    FlushSettings();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Store asset data into the cfgTree to keep them persistent if legato or app restarts.
  *
- * @return:
- *      - LE_NOT_FOUND - if the path is invalid and does not point to an asset data
- *      - LE_NOT_PERMITTED - asset data being accessed does not have the right permission
- *      - LE_OK - access successful.
+ * The update is written behind, with the other updates received during SETTING_FLUSH_INTERVAL_MS.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t SetVal
+static void StoreData
 (
     const char* path,              ///< [IN] Asset data path
     AssetValue_t value,            ///< [IN] Asset value
-    le_avdata_DataType_t dataType, ///< [IN] Asset value data type
-    bool isClient,                 ///< [IN] Is it client or server access
-    bool isDryRun,                 ///< [IN] When this flag is set, no write is performed on
-                                   ///<      assetData, rather it checks the validity of input data.
-    le_cfg_IteratorRef_t iterRef   ///< [IN] Iterator to config tree setting
+    le_avdata_DataType_t dataType  ///< [IN] Asset value data type
 )
 {
-    char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
-    char pathCopy[LE_AVDATA_PATH_NAME_LEN] = {0};
-    strncpy(pathCopy, path, LE_AVDATA_PATH_NAME_LEN);
-    pathCopy[LE_AVDATA_PATH_NAME_LEN - 1]= '\0';
-    // Format the path with correct delimiter
-    FormatPath(pathCopy);
+    PendingSetting_t* settingPtr;
 
-    if (isClient)
+    if (LE_AVDATA_DATA_TYPE_NONE == dataType)
     {
-        GetNamespacedPath(pathCopy, namespacedPath, sizeof(namespacedPath));
+        return;
+    }
+
+    // The path is stored relative to CFG_ASSET_SETTING_PATH.
+    settingPtr = le_hashmap_Get(PendingSettingMap, path + 1);
+
+    if (NULL != settingPtr)
+    {
+        if (LE_AVDATA_DATA_TYPE_STRING == settingPtr->dataType)
+        {
+            le_mem_Release(settingPtr->value.strValuePtr);
+        }
     }
     else
     {
-        le_utf8_Copy(namespacedPath, pathCopy, sizeof(namespacedPath), NULL);
+        settingPtr = le_mem_ForceAlloc(PendingSettingPool);
+        LE_ASSERT(LE_OK == le_utf8_Copy(settingPtr->path, path + 1, sizeof(settingPtr->path),
+                                        NULL));
+        settingPtr->link = LE_DLS_LINK_INIT;
+        le_dls_Queue(&PendingSettingList, &settingPtr->link);
+        le_hashmap_Put(PendingSettingMap, settingPtr->path, settingPtr);
     }
 
-    AssetData_t* assetDataPtr = GetAssetData(namespacedPath);
+    settingPtr->dataType = dataType;
+    settingPtr->value = value;
 
-    if (assetDataPtr == NULL)
+    // The asset data keeps its own string, the pending update needs a copy.
+    if (LE_AVDATA_DATA_TYPE_STRING == dataType)
     {
-        return LE_NOT_FOUND;
+        settingPtr->value.strValuePtr = le_mem_ForceAlloc(StringPool);
+        le_utf8_Copy(settingPtr->value.strValuePtr, value.strValuePtr,
+                     LE_AVDATA_STRING_VALUE_BYTES, NULL);
     }
 
+    if (le_hashmap_Size(PendingSettingMap) >= MAX_PENDING_SETTINGS)
+    {
+        FlushSettings();
+    }
+    else if (!le_timer_IsRunning(SettingFlushTimerRef))
+    {
+        le_timer_Start(SettingFlushTimerRef);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks the asset value of an asset data that was already looked up if dry run flag is set.
+ * Otherwise, sets the asset value of that asset data.
+ *
+ * @return:
+ *      - LE_NOT_PERMITTED - asset data being accessed does not have the right permission
+ *      - LE_OK - access successful.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteAssetData
+(
+    AssetData_t* assetDataPtr,     ///< [IN] Asset data
+    const char* namespacedPath,    ///< [IN] Name spaced asset data path
+    AssetValue_t value,            ///< [IN] Asset value
+    le_avdata_DataType_t dataType, ///< [IN] Asset value data type
+    bool isClient,                 ///< [IN] Is it client or server access
+    bool isDryRun                  ///< [IN] When this flag is set, no write is performed on
+                                   ///<      assetData, rather it checks the validity of input data.
+)
+{
     // Check access permission
     if ((!isClient && ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_WRITE) !=
                       LE_AVDATA_ACCESS_WRITE)) ||
@@ -1106,7 +1446,7 @@ static le_result_t SetVal
         if ((assetDataPtr->accessMode == LE_AVDATA_ACCESS_SETTING) &&
             IsRestored)
         {
-            StoreData(namespacedPath, value, dataType, iterRef);
+            StoreData(namespacedPath, value, dataType);
         }
     }
 
@@ -1114,6 +1454,54 @@ static le_result_t SetVal
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks asset value associated with the provided asset data path if dry run flag is set.
+ * Otherwise, sets asset value associated with the provided asset data path.
+ *
+ * @return:
+ *      - LE_NOT_FOUND - if the path is invalid and does not point to an asset data
+ *      - LE_NOT_PERMITTED - asset data being accessed does not have the right permission
+ *      - LE_OK - access successful.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SetVal
+(
+    const char* path,              ///< [IN] Asset data path
+    AssetValue_t value,            ///< [IN] Asset value
+    le_avdata_DataType_t dataType, ///< [IN] Asset value data type
+    bool isClient,                 ///< [IN] Is it client or server access
+    bool isDryRun                  ///< [IN] When this flag is set, no write is performed on
+                                   ///<      assetData, rather it checks the validity of input data.
+)
+{
+    char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
+    char pathCopy[LE_AVDATA_PATH_NAME_LEN] = {0};
+    strncpy(pathCopy, path, LE_AVDATA_PATH_NAME_LEN);
+    pathCopy[LE_AVDATA_PATH_NAME_LEN - 1]= '\0';
+    // Format the path with correct delimiter
+    FormatPath(pathCopy);
+
+    if (isClient)
+    {
+        GetNamespacedPath(pathCopy, namespacedPath, sizeof(namespacedPath));
+    }
+    else
+    {
+        le_utf8_Copy(namespacedPath, pathCopy, sizeof(namespacedPath), NULL);
+    }
+
+    AssetData_t* assetDataPtr = GetAssetData(namespacedPath);
+
+    if (assetDataPtr == NULL)
+    {
+        return LE_NOT_FOUND;
+    }
+
+    return WriteAssetData(assetDataPtr, namespacedPath, value, dataType, isClient, isDryRun);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize resource
@@ -1162,11 +1550,45 @@ static le_result_t InitResource
     assetDataPtr->msgRef = sessionRef;
 
     le_hashmap_Put(AssetDataMap, assetPathPtr, assetDataPtr);
+    AddPathNodes(assetPathPtr, assetDataPtr);
 
     return LE_OK;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore a setting asset data stored in the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RestoreSetting
+(
+    const char* cfgPath,                ///< [IN] Config tree path of the setting
+    le_avdata_DataType_t dataType,      ///< [IN] Setting data type
+    AssetValue_t value,                 ///< [IN] Setting value, string owned by the caller
+    le_msg_SessionRef_t sessionRef      ///< [IN] Session reference
+)
+{
+    const char* path = cfgPath + (sizeof(CFG_ASSET_SETTING_PATH) - 1);
+
+    LE_INFO("Restoring asset data: %s", path);
+
+    if (LE_OK != InitResource(path, LE_AVDATA_ACCESS_SETTING, sessionRef))
+    {
+        return;
+    }
+
+    if (LE_AVDATA_DATA_TYPE_STRING == dataType)
+    {
+        char* strValuePtr = le_mem_ForceAlloc(StringPool);
+        le_utf8_Copy(strValuePtr, value.strValuePtr, LE_AVDATA_STRING_VALUE_BYTES, NULL);
+        value.strValuePtr = strValuePtr;
+    }
+
+    SetVal(path, value, dataType, false, false);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Recursively find all setting asset data paths and restore them.
@@ -1180,7 +1602,6 @@ static void RecursiveRestore
 )
 {
     char strBuffer[LE_CFG_STR_LEN_BYTES] = "";
-    IsRestored = false;
 
     do
     {
@@ -1199,60 +1620,32 @@ static void RecursiveRestore
         }
         else if (type != LE_CFG_TYPE_DOESNT_EXIST)
         {
-            // restore asset data as setting
-            LE_INFO("Restoring asset data: %s", strBuffer + (sizeof(CFG_ASSET_SETTING_PATH) - 1));
-
-            le_result_t result = InitResource(strBuffer + (sizeof(CFG_ASSET_SETTING_PATH) - 1),
-                                              LE_AVDATA_ACCESS_SETTING, sessionRef);
+            AssetValue_t assetValue;
+            char strValue[LE_AVDATA_STRING_VALUE_BYTES] = "";
 
-            // Restore value from config tree for the new setting
-            if (result == LE_OK)
+            // restore asset data as setting
+            switch (type)
             {
-                AssetValue_t assetValue;
-
-                switch (type)
-                {
-                    case LE_CFG_TYPE_INT:
-                        assetValue.intValue = le_cfg_GetInt(iterRef, strBuffer, 0);
-                        SetVal(strBuffer + (sizeof(CFG_ASSET_SETTING_PATH) - 1),
-                               assetValue,
-                               LE_AVDATA_DATA_TYPE_INT,
-                               false,
-                               false,
-                               NULL);
-                        break;
-                    case LE_CFG_TYPE_FLOAT:
-                        assetValue.floatValue = le_cfg_GetFloat(iterRef, strBuffer, 0);
-                        SetVal(strBuffer + (sizeof(CFG_ASSET_SETTING_PATH) - 1),
-                               assetValue,
-                               LE_AVDATA_DATA_TYPE_FLOAT,
-                               false,
-                               false,
-                               NULL);
-                        break;
-                    case LE_CFG_TYPE_BOOL:
-                        assetValue.boolValue = le_cfg_GetBool(iterRef, strBuffer, 0);
-                        SetVal(strBuffer + (sizeof(CFG_ASSET_SETTING_PATH) - 1),
-                               assetValue,
-                               LE_AVDATA_DATA_TYPE_BOOL,
-                               false,
-                               false,
-                               NULL);
-                        break;
-                    case LE_CFG_TYPE_STRING:
-                        assetValue.strValuePtr = le_mem_ForceAlloc(StringPool);
-                        le_cfg_GetString(iterRef, strBuffer, assetValue.strValuePtr, LE_AVDATA_STRING_VALUE_BYTES, "");
-                        SetVal(strBuffer + (sizeof(CFG_ASSET_SETTING_PATH) - 1),
-                               assetValue,
-                               LE_AVDATA_DATA_TYPE_STRING,
-                               false,
-                               false,
-                               NULL);
-                        break;
-                    default:
-                        LE_ERROR("Invalid type.");
-                        return;
-                }
+                case LE_CFG_TYPE_INT:
+                    assetValue.intValue = le_cfg_GetInt(iterRef, strBuffer, 0);
+                    RestoreSetting(strBuffer, LE_AVDATA_DATA_TYPE_INT, assetValue, sessionRef);
+                    break;
+                case LE_CFG_TYPE_FLOAT:
+                    assetValue.floatValue = le_cfg_GetFloat(iterRef, strBuffer, 0);
+                    RestoreSetting(strBuffer, LE_AVDATA_DATA_TYPE_FLOAT, assetValue, sessionRef);
+                    break;
+                case LE_CFG_TYPE_BOOL:
+                    assetValue.boolValue = le_cfg_GetBool(iterRef, strBuffer, 0);
+                    RestoreSetting(strBuffer, LE_AVDATA_DATA_TYPE_BOOL, assetValue, sessionRef);
+                    break;
+                case LE_CFG_TYPE_STRING:
+                    le_cfg_GetString(iterRef, strBuffer, strValue, sizeof(strValue), "");
+                    assetValue.strValuePtr = strValue;
+                    RestoreSetting(strBuffer, LE_AVDATA_DATA_TYPE_STRING, assetValue, sessionRef);
+                    break;
+                default:
+                    LE_ERROR("Invalid type.");
+                    return;
             }
         }
         else
@@ -1261,8 +1654,300 @@ static void RecursiveRestore
         }
     }
     while (le_cfg_GoToNextSibling(iterRef) == LE_OK);
+}
 
-    IsRestored = true;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a token of a config tree export file: '{' and '}' around the children of a stem node, a
+ * node name or value between delimiters ('"' for names and strings, '[' for integers, '(' for
+ * floats), '!' followed by 't' or 'f' for booleans, or '~' for empty nodes.
+ *
+ * @return
+ *  - LE_OK             A token is read
+ *  - LE_OUT_OF_RANGE   End of file
+ *  - LE_FORMAT_ERROR   The token is invalid or too long
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadExportToken
+(
+    FILE* filePtr,          ///< [IN] Export file
+    char* tokenPtr,         ///< [OUT] First character of the token
+    char* bufferPtr,        ///< [OUT] Node name or value
+    size_t bufferSize       ///< [IN] Buffer size
+)
+{
+    int next;
+    char terminal;
+    size_t count = 0;
+
+    do
+    {
+        next = fgetc(filePtr);
+    }
+    while (isspace(next));
+
+    if (EOF == next)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    *tokenPtr = (char)next;
+    bufferPtr[0] = '\0';
+
+    switch (next)
+    {
+        case '{':
+        case '}':
+        case '~':
+            return LE_OK;
+
+        case '!':
+            next = fgetc(filePtr);
+            if (('t' != next) && ('f' != next))
+            {
+                return LE_FORMAT_ERROR;
+            }
+            bufferPtr[0] = (char)next;
+            bufferPtr[1] = '\0';
+            return LE_OK;
+
+        case '"':
+            terminal = '"';
+            break;
+
+        case '[':
+            terminal = ']';
+            break;
+
+        case '(':
+            terminal = ')';
+            break;
+
+        default:
+            return LE_FORMAT_ERROR;
+    }
+
+    while (terminal != (next = fgetc(filePtr)))
+    {
+        if ('\\' == next)
+        {
+            next = fgetc(filePtr);
+        }
+
+        if ((EOF == next) || (count >= (bufferSize - 1)))
+        {
+            return LE_FORMAT_ERROR;
+        }
+
+        bufferPtr[count++] = (char)next;
+    }
+
+    bufferPtr[count] = '\0';
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore the settings of a node of a config tree export file and of its children.
+ *
+ * @return
+ *  - LE_OK             The node is restored
+ *  - LE_FORMAT_ERROR   The file is corrupted
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RestoreExportedNode
+(
+    FILE* filePtr,                      ///< [IN] Export file
+    char* pathPtr,                      ///< [IN] Config tree path of the node, children paths are
+                                        ///<      built after it
+    size_t pathBytes,                   ///< [IN] Size of the path buffer
+    le_msg_SessionRef_t sessionRef      ///< [IN] Session reference
+)
+{
+    char buffer[LE_CFG_STR_LEN_BYTES];
+    char token;
+    AssetValue_t assetValue;
+    size_t pathLen = strlen(pathPtr);
+    le_result_t result;
+
+    if (LE_OK != ReadExportToken(filePtr, &token, buffer, sizeof(buffer)))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    switch (token)
+    {
+        case '{':
+            while (LE_OK == (result = ReadExportToken(filePtr, &token, buffer, sizeof(buffer))))
+            {
+                if ('}' == token)
+                {
+                    return LE_OK;
+                }
+
+                if ('"' != token)
+                {
+                    return LE_FORMAT_ERROR;
+                }
+
+                // The asset data path is the part after CFG_ASSET_SETTING_PATH.
+                if ((pathLen + 1 + strlen(buffer) >= pathBytes) ||
+                    ((pathLen + 1 + strlen(buffer) - (sizeof(CFG_ASSET_SETTING_PATH) - 1))
+                     >= LE_AVDATA_PATH_NAME_BYTES))
+                {
+                    LE_ERROR("Setting path too long: %s/%s", pathPtr, buffer);
+                    return LE_FORMAT_ERROR;
+                }
+
+                snprintf(pathPtr + pathLen, pathBytes - pathLen, "/%s", buffer);
+                result = RestoreExportedNode(filePtr, pathPtr, pathBytes, sessionRef);
+                pathPtr[pathLen] = '\0';
+
+                if (LE_OK != result)
+                {
+                    return result;
+                }
+            }
+            return LE_FORMAT_ERROR;
+
+        case '[':
+            assetValue.intValue = (int)strtol(buffer, NULL, 10);
+            RestoreSetting(pathPtr, LE_AVDATA_DATA_TYPE_INT, assetValue, sessionRef);
+            break;
+
+        case '(':
+            assetValue.floatValue = strtod(buffer, NULL);
+            RestoreSetting(pathPtr, LE_AVDATA_DATA_TYPE_FLOAT, assetValue, sessionRef);
+            break;
+
+        case '!':
+            assetValue.boolValue = ('t' == buffer[0]);
+            RestoreSetting(pathPtr, LE_AVDATA_DATA_TYPE_BOOL, assetValue, sessionRef);
+            break;
+
+        case '"':
+            assetValue.strValuePtr = buffer;
+            RestoreSetting(pathPtr, LE_AVDATA_DATA_TYPE_STRING, assetValue, sessionRef);
+            break;
+
+        case '~':
+            break;
+
+        default:
+            return LE_FORMAT_ERROR;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Create the private export directory if needed, and check that it is a real directory owned by
+ * avcService and not accessible by anybody else.
+ *
+ * @return
+ *  - LE_OK             The directory is ready
+ *  - LE_FAULT          The directory could not be created or is not private
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t MakeExportDir
+(
+    void
+)
+{
+    struct stat st;
+
+    if ((-1 == mkdir(SETTING_EXPORT_DIR_PATH, S_IRWXU)) && (EEXIST != errno))
+    {
+        LE_ERROR("Cannot create '%s': %m", SETTING_EXPORT_DIR_PATH);
+        return LE_FAULT;
+    }
+
+    if (-1 == lstat(SETTING_EXPORT_DIR_PATH, &st))
+    {
+        LE_ERROR("Cannot stat '%s': %m", SETTING_EXPORT_DIR_PATH);
+        return LE_FAULT;
+    }
+
+    if ((!S_ISDIR(st.st_mode)) ||
+        (geteuid() != st.st_uid) ||
+        (0 != (st.st_mode & (S_IRWXG | S_IRWXO))))
+    {
+        LE_ERROR("'%s' is not a private directory", SETTING_EXPORT_DIR_PATH);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Restore the settings of an app from a single export of its config tree subtree, instead of
+ * reading the subtree node by node.
+ *
+ * @return
+ *  - LE_OK             The settings are restored
+ *  - LE_FAULT          The subtree could not be exported
+ *  - LE_FORMAT_ERROR   The export file is corrupted
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RestoreExportedSettings
+(
+    const char* appSettingPath,         ///< [IN] Config tree path of the app settings
+    le_msg_SessionRef_t sessionRef      ///< [IN] Session reference
+)
+{
+    char path[LE_CFG_STR_LEN_BYTES];
+    char filePath[] = SETTING_EXPORT_FILE_TEMPLATE;
+    le_cfg_IteratorRef_t iterRef;
+    le_result_t result;
+    FILE* filePtr;
+    int fd;
+
+    if (LE_OK != MakeExportDir())
+    {
+        return LE_FAULT;
+    }
+
+    // Each export gets its own empty file: an export that is not written is read as corrupted.
+    fd = mkstemp(filePath);
+    if (-1 == fd)
+    {
+        LE_ERROR("Cannot create export file in '%s': %m", SETTING_EXPORT_DIR_PATH);
+        return LE_FAULT;
+    }
+
+    filePtr = fdopen(fd, "r");
+    if (NULL == filePtr)
+    {
+        close(fd);
+        unlink(filePath);
+        return LE_FAULT;
+    }
+
+    iterRef = le_cfg_CreateReadTxn(appSettingPath);
+    result = le_cfgAdmin_ExportTree(iterRef, filePath, "");
+    le_cfg_CancelTxn(iterRef);
+
+    if (LE_OK == result)
+    {
+        le_utf8_Copy(path, appSettingPath, sizeof(path), NULL);
+        result = RestoreExportedNode(filePtr, path, sizeof(path), sessionRef);
+    }
+    else
+    {
+        result = LE_FAULT;
+    }
+
+    fclose(filePtr);
+    unlink(filePath);
+
+    return result;
 }
 
 
@@ -1280,6 +1965,7 @@ static void ClientOpenSessionHandler
     char appName[LE_LIMIT_APP_NAME_LEN+1] = "";
     char appSettingPath[LE_AVDATA_PATH_NAME_BYTES] = "";
     le_cfg_IteratorRef_t iterRef;
+    le_result_t result;
     pid_t pid;
 
     // Get client pid
@@ -1297,20 +1983,33 @@ static void ClientOpenSessionHandler
     // Get the path where the settings for this client app is stored
     snprintf(appSettingPath, sizeof(appSettingPath),"%s/%s", CFG_ASSET_SETTING_PATH, appName);
 
-    // exit if there no setting found in config tree
-    iterRef = le_cfg_CreateReadTxn(appSettingPath);
+    // The settings updated by a previous session of the app may still be pending
+    FlushSettings();
 
-    if (le_cfg_GoToFirstChild(iterRef) != LE_OK)
+    IsRestored = false;
+
+    // Restore setting from config tree
+    result = RestoreExportedSettings(appSettingPath, sessionRef);
+    if (LE_OK != result)
     {
-        LE_INFO("No asset setting to restore.");
+        LE_WARN("Unable to restore exported settings (%s), reading them from config tree",
+                LE_RESULT_TXT(result));
+
+        iterRef = le_cfg_CreateReadTxn(appSettingPath);
+
+        if (le_cfg_GoToFirstChild(iterRef) != LE_OK)
+        {
+            LE_INFO("No asset setting to restore.");
+        }
+        else
+        {
+            RecursiveRestore(iterRef, appSettingPath, sessionRef);
+        }
+
         le_cfg_CancelTxn(iterRef);
-        return;
     }
 
-    // Restore setting from config tree
-    RecursiveRestore(iterRef, appSettingPath, sessionRef);
-    le_cfg_CancelTxn(iterRef);
-
+    IsRestored = true;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1527,176 +2226,179 @@ static le_result_t DecodeAssetData
 }
 
 
-//--------------------------------------------------------------------------------------------------
-/**
- * String compare function for qsort.
- */
-//--------------------------------------------------------------------------------------------------
-static int CompareStrings
-(
-    const void *a,
-    const void *b
-)
-{
-    return strcmp(*(char **)a, *(char **)b);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the value of an asset data in CBOR format with the provided CBOR map encoder, labelled
+ * with the last segment of its path.
+ *
+ * @return:
+ *      - LE_FAULT on any error.
+ *      - LE_OK if success.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EncodeAssetDataEntry
+(
+    PathNode_t* nodePtr,      ///< [IN] Path tree node of the asset data
+    CborEncoder* mapNodePtr,  ///< [OUT] CBOR map encoder
+    bool isClient             ///< [IN] Is client access
+)
+{
+    AssetValue_t assetValue;
+    le_avdata_DataType_t type;
+    le_result_t result;
+
+    if (CborNoError != cbor_encode_text_stringz(mapNodePtr,
+                                                strrchr(nodePtr->path, SLASH_DELIMITER_CHAR) + 1))
+    {
+        return LE_FAULT;
+    }
+
+    result = ReadAssetData(nodePtr->assetDataPtr, nodePtr->path, &assetValue, &type, isClient);
+
+    if (result != LE_OK)
+    {
+        LE_ERROR("Fail to get asset data at [%s]. Result [%s]",
+                 nodePtr->path, LE_RESULT_TXT(result));
+        return LE_FAULT;
+    }
+
+    return EncodeAssetData(type, assetValue, mapNodePtr);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Given a list of asset data paths, look up the associated asset value, and encode them in CBOR
- * format with the provided CBOR encoder. In the initial call, the "level" parameter controls the
- * path depth the encoding begins at.
+ * Encode the asset data that the server can read below a path tree node in CBOR format with the
+ * provided CBOR encoder.  Every level of the tree is a CBOR map, labelled with the path segments,
+ * so the tree is walked once and the CBOR is written as it goes.  Inner nodes without readable
+ * asset data below them are left out.
  *
  * In case of any error, this function returns right away and does not perform further encoding, so
  * the CborEncoder out param (and the associated buffer) would be in an unpredictable state and
  * should not be used.
  *
- * Note: The list of paths MUST be grouped at each level. They don't need to be sorted, but a sorted
- * list achieves the same goal.
- *
  * @return:
  *      - LE_FAULT on any error.
  *      - LE_OK if success.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t EncodeMultiData
+static le_result_t EncodePathNode
 (
-    char* list[], ///< [IN] List of asset data paths. MUST be grouped at each level.
+    PathNode_t* nodePtr,            ///< [IN] Path tree node whose children are encoded
     CborEncoder* parentCborEncoder, ///< [OUT] Parent CBOR encoder
-    int minIndex, ///< [IN] Min index of the list to start with in the current recursion
-    int maxIndex, ///< [IN] Max index of the list to end with in the current recursion
-    int level,    ///< [IN] Path depth for the current recursion
-    bool isClient,   ///< [IN] Is client access
-    bool isNameSpaced ///< [IN] Is name spaced
+    bool isClient,                  ///< [IN] Is client access
+    size_t* countPtr                ///< [OUT] Incremented by the number of asset data encoded
 )
 {
-    // Each range of paths is enclosed in a CBOR map.
-    char* savePtr = NULL;
     CborEncoder mapNode;
+    le_dls_Link_t* linkPtr;
+
     if (CborNoError != cbor_encoder_create_map(parentCborEncoder, &mapNode, CborIndefiniteLength))
     {
         return LE_FAULT;
     }
 
-    char  savedToken[LE_AVDATA_PATH_NAME_BYTES] = ""; // initialized to an empty string.
-    char* currToken = NULL;
-    char* peekToken = NULL;
-
-    int minCurrRange = minIndex;
-    int maxCurrRange = minIndex;
-
-    int i, j;
-    for (i = minIndex; i <= maxIndex; i++)
+    for (linkPtr = le_dls_Peek(&nodePtr->children);
+         linkPtr != NULL;
+         linkPtr = le_dls_PeekNext(&nodePtr->children, linkPtr))
     {
-        char currStrCopy[LE_AVDATA_PATH_NAME_BYTES];
-        LE_ASSERT(le_utf8_Copy(currStrCopy, list[i], sizeof(currStrCopy), NULL) == LE_OK);
-
-        // Getting the token of the current path level.
-        currToken = strtok_r(currStrCopy, SLASH_DELIMITER_STRING, &savePtr);
-        for (j = 1; j < level; j++)
-        {
-            currToken = strtok_r(NULL, SLASH_DELIMITER_STRING, &savePtr);
-        }
+        PathNode_t* childPtr = CONTAINER_OF(linkPtr, PathNode_t, link);
 
-        peekToken = strtok_r(NULL, SLASH_DELIMITER_STRING, &savePtr);
-
-        if (peekToken == NULL)
+        if (childPtr->assetDataPtr == NULL)
         {
-            // When a leaf node is encountered, we need to make recursive calls on the previous
-            // range of branch nodes.
-            if (0 != strcmp(savedToken, ""))
-            {
-                maxCurrRange = i - 1;
-
-                // Encoding the map name of the next recursion first.
-                if ((CborNoError != cbor_encode_text_stringz(&mapNode, savedToken)) ||
-                    (LE_OK != EncodeMultiData(list, &mapNode, minCurrRange, maxCurrRange,
-                                              level+1, isClient, isNameSpaced)))
-                {
-                    return LE_FAULT;
-                }
-            }
-
-            /* CBOR encoding for the leaf node itself. */
-            if (NULL == currToken)
-            {
-                LE_ERROR("currToken is NULL");
-                return LE_FAULT;
-            }
-
-            // Value name.
-            if (CborNoError != cbor_encode_text_stringz(&mapNode, currToken))
+            // Keep the encoder state so that an empty branch can be taken back: the CBOR encoder
+            // only ever appends to the buffer.
+            CborEncoder savedMapNode = mapNode;
+            size_t childCount = 0;
+
+            if ((CborNoError != cbor_encode_text_stringz(&mapNode,
+                                        strrchr(childPtr->path, SLASH_DELIMITER_CHAR) + 1)) ||
+                (LE_OK != EncodePathNode(childPtr, &mapNode, isClient, &childCount)))
             {
                 return LE_FAULT;
             }
 
-            // Use the path to look up its asset data, and do the corresponding encoding.
-            AssetValue_t assetValue;
-            le_avdata_DataType_t type;
-            le_result_t getValresult = GetVal(list[i], &assetValue, &type, isClient, isNameSpaced);
-
-            if (getValresult != LE_OK)
+            if (childCount == 0)
             {
-                LE_ERROR("Fail to get asset data at [%s]. Result [%s]",
-                         list[i], LE_RESULT_TXT(getValresult));
-
-                return LE_FAULT;
+                mapNode = savedMapNode;
             }
-
-            if (LE_OK != EncodeAssetData(type, assetValue, &mapNode))
+            *countPtr += childCount;
+        }
+        else if ((childPtr->assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) ==
+                 LE_AVDATA_ACCESS_READ)
+        {
+            if (LE_OK != EncodeAssetDataEntry(childPtr, &mapNode, isClient))
             {
                 return LE_FAULT;
             }
-
-            // Reset savedToken
-            savedToken[0] = '\0';
+            (*countPtr)++;
         }
-        else if (strcmp(currToken, savedToken) != 0)
-        {
-            // We have encountered a "new" branch node, so make recursive call on the saved range.
-            if (0 != strcmp(savedToken, ""))
-            {
-                maxCurrRange = i - 1;
+    }
 
-                // Encoding the map name of the next recursion first.
-                if ((CborNoError != cbor_encode_text_stringz(&mapNode, savedToken)) ||
-                    (LE_OK != EncodeMultiData(list, &mapNode, minCurrRange, maxCurrRange,
-                                              level+1, isClient, isNameSpaced)))
-                {
-                    return LE_FAULT;
-                }
-            }
+    if (CborNoError != cbor_encoder_close_container(parentCborEncoder, &mapNode))
+    {
+        return LE_FAULT;
+    }
 
-            minCurrRange = i;
-            maxCurrRange = i;
+    return LE_OK;
+}
 
-            // Save the current token
-            LE_ASSERT(le_utf8_Copy(savedToken, currToken, sizeof(savedToken), NULL) == LE_OK);
-        }
-        else
-        {
-            // Do nothing. We've encountered the same branch node.
-        }
 
-    }
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a path tree node in CBOR format with the provided CBOR encoder, inside one CBOR map per
+ * level above it (e.g., {"a": {"b": {"c": value}}} for the asset data "/a/b/c").  The node is
+ * either an asset data, or an inner node whose readable asset data are encoded.
+ *
+ * In case of any error, the CborEncoder out param (and the associated buffer) would be in an
+ * unpredictable state and should not be used.
+ *
+ * @return:
+ *      - LE_FAULT on any error.
+ *      - LE_OK if success.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t EncodePathBranch
+(
+    PathNode_t* branch[],           ///< [IN] Path tree nodes from the top level to the node
+    int depth,                      ///< [IN] Number of nodes in the branch
+    int level,                      ///< [IN] Index of the node encoded in the current recursion
+    CborEncoder* parentCborEncoder, ///< [OUT] Parent CBOR encoder
+    bool isClient,                  ///< [IN] Is client access
+    size_t* countPtr                ///< [OUT] Incremented by the number of asset data encoded
+)
+{
+    PathNode_t* nodePtr = branch[level];
+    CborEncoder mapNode;
+    le_result_t result;
 
-    // This is to finish up the final range of branch nodes, in case the last path is not a leaf
-    // node at the current level.
-    if (peekToken != NULL)
+    if (CborNoError != cbor_encoder_create_map(parentCborEncoder, &mapNode, CborIndefiniteLength))
     {
-        maxCurrRange = i - 1;
+        return LE_FAULT;
+    }
 
-        // Encoding the map name of the next recursion first.
-        if ((CborNoError != cbor_encode_text_stringz(&mapNode, savedToken)) ||
-            (LE_OK != EncodeMultiData(list, &mapNode, minCurrRange, maxCurrRange,
-                                      level+1, isClient, isNameSpaced)))
-        {
-            return LE_FAULT;
-        }
+    if (level < (depth - 1))
+    {
+        result = (CborNoError == cbor_encode_text_stringz(&mapNode,
+                                        strrchr(nodePtr->path, SLASH_DELIMITER_CHAR) + 1)) ?
+                 EncodePathBranch(branch, depth, level + 1, &mapNode, isClient, countPtr) :
+                 LE_FAULT;
+    }
+    else if (nodePtr->assetDataPtr != NULL)
+    {
+        result = EncodeAssetDataEntry(nodePtr, &mapNode, isClient);
+        (*countPtr)++;
+    }
+    else
+    {
+        result = (CborNoError == cbor_encode_text_stringz(&mapNode,
+                                        strrchr(nodePtr->path, SLASH_DELIMITER_CHAR) + 1)) ?
+                 EncodePathNode(nodePtr, &mapNode, isClient, countPtr) :
+                 LE_FAULT;
     }
 
-    if (CborNoError != cbor_encoder_close_container(parentCborEncoder, &mapNode))
+    if ((result != LE_OK) ||
+        (CborNoError != cbor_encoder_close_container(parentCborEncoder, &mapNode)))
     {
         return LE_FAULT;
     }
@@ -1711,6 +2413,9 @@ static le_result_t EncodeMultiData
  * values (i.e. asset data values for specified asset data path) if dry run flag is set. Otherwise,
  * sets the asset data values for asset data paths with input values.
  *
+ * The labels are decoded in place at the end of the path buffer, which is restored to the base path
+ * when the function returns successfully.
+ *
  * In case of any error, this function returns right away and does not perform further decoding, so
  * the CborValue out param would be in an unpredictable state and should not be used.
  *
@@ -1724,10 +2429,10 @@ static le_result_t DecodeMultiData
     CborValue* valuePtr, ///< [OUT] CBOR value. Expected to be a map. Iterator is advanced after the
                          ///<       function call.
     char* path,          ///< [IN] base path.
+    size_t pathLen,      ///< [IN] Length of the base path
     size_t maxPathBytes, ///< [IN] Max allowed length of path including null character
-    bool isDryRun,       ///< [IN] When this flag is set, no write is performed on assetData,
+    bool isDryRun        ///< [IN] When this flag is set, no write is performed on assetData,
                          ///<      rather it checks the validity of input data.
-    le_cfg_IteratorRef_t iterRef ///< [IN] Iterator to config data setting.
 )
 {
     // Entering a CBOR map.
@@ -1752,18 +2457,12 @@ static le_result_t DecodeMultiData
                 return LE_FAULT;
             }
 
-            char buf[LE_AVDATA_STRING_VALUE_BYTES] = {0};
-            size_t strSize = LE_AVDATA_STRING_VALUE_BYTES;
-
-            if (LE_OK != CborSafeCopyString(&map, buf, &strSize))
+            if ((LE_OK != CheckCborStringLen(&map, LE_AVDATA_STRING_VALUE_BYTES)) ||
+                (CborNoError != cbor_value_calculate_string_length(&map, &endingPathSegLen)))
             {
                 return LE_FAULT;
             }
 
-            // Using strlen is safe as both buffers are initialized with all 0
-            endingPathSegLen = strlen(buf);
-            int pathLen = strlen(path);
-
             if (maxPathBytes <= (pathLen + endingPathSegLen + 1))  // +1 for the delimiter
             {
                 LE_CRIT("Path size too big. Max allowed: %zu, Actual: %zu",
@@ -1772,9 +2471,13 @@ static le_result_t DecodeMultiData
                 return LE_FAULT;
             }
 
-            // No need to check return value as length check is done before
-            le_utf8_Append(path, SLASH_DELIMITER_STRING, maxPathBytes, NULL);
-            le_utf8_Append(path, buf, maxPathBytes, NULL);
+            // Append the label right after the delimiter. The length check is done before, so this
+            // should not fail.
+            size_t segBytes = maxPathBytes - (pathLen + 1);
+
+            path[pathLen] = SLASH_DELIMITER_CHAR;
+            LE_ASSERT(CborNoError == cbor_value_copy_text_string(&map, path + pathLen + 1,
+                                                                 &segBytes, NULL));
 
             labelProcessed = true;
         }
@@ -1783,20 +2486,13 @@ static le_result_t DecodeMultiData
             // The value is a map
             if (cbor_value_is_map(&map))
             {
-                if (LE_OK != DecodeMultiData(&map, path, maxPathBytes, isDryRun, iterRef))
-                {
-                    return LE_FAULT;
-                }
-
-                if (strlen(path) < (endingPathSegLen + 1))
+                if (LE_OK != DecodeMultiData(&map, path, pathLen + endingPathSegLen + 1,
+                                             maxPathBytes, isDryRun))
                 {
-                    LE_ERROR("Path length (%zu) can't be smaller than its segment length (%zu)",
-                             strlen(path),
-                             endingPathSegLen + 1);
                     return LE_FAULT;
                 }
 
-                path[strlen(path) - (endingPathSegLen + 1)] = '\0';
+                path[pathLen] = '\0';
 
                 labelProcessed = false;
 
@@ -1816,8 +2512,23 @@ static le_result_t DecodeMultiData
                 return LE_FAULT;
             }
 
-            setValresult = (type == LE_AVDATA_DATA_TYPE_NONE) ?
-                           LE_UNSUPPORTED : SetVal(path, assetValue, type, false, isDryRun, iterRef);
+            // The path is complete, so the asset data is looked up once instead of going through
+            // SetVal(), which would copy and format the path again.
+            AssetData_t* assetDataPtr = GetAssetData(path);
+
+            if (type == LE_AVDATA_DATA_TYPE_NONE)
+            {
+                setValresult = LE_UNSUPPORTED;
+            }
+            else if (assetDataPtr == NULL)
+            {
+                setValresult = LE_NOT_FOUND;
+            }
+            else
+            {
+                setValresult = WriteAssetData(assetDataPtr, path, assetValue, type, false,
+                                              isDryRun);
+            }
 
             if (setValresult != LE_OK)
             {
@@ -1827,15 +2538,7 @@ static le_result_t DecodeMultiData
                 return LE_FAULT;
             }
 
-            if (strlen(path) < (endingPathSegLen + 1))
-            {
-                LE_ERROR("Path length (%zd) can't be smaller than its segment length (%zd)",
-                         strlen(path),
-                         endingPathSegLen + 1);
-                return LE_FAULT;
-            }
-
-            path[strlen(path) - (endingPathSegLen + 1)] = '\0';
+            path[pathLen] = '\0';
 
             labelProcessed = false;
         }
@@ -2052,51 +2755,15 @@ static void ProcessAvServerReadRequest
         {
             LE_DEBUG(">>>>> path not found, but is parent path. Encoding all children nodes.");
 
-            // Gather all eligible paths in a path array.
-            AssetData_t* assetDataPtr;
-            char* pathArray[le_hashmap_Size(AssetDataMap)];
-            memset(pathArray, 0, sizeof(pathArray));
-            int pathArrayIdx = 0;
-
-            le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
-            const char* currentPath;
-
-            while (le_hashmap_NextNode(iter) == LE_OK)
-            {
-                currentPath = le_hashmap_GetKey(iter);
-                assetDataPtr = le_hashmap_GetValue(iter);
-
-                if ((le_path_IsSubpath(path, currentPath, SLASH_DELIMITER_STRING)) &&
-                    ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) == LE_AVDATA_ACCESS_READ))
-                {
-                    // Put the currentPath in the path array.
-                    pathArray[pathArrayIdx] = (char*)currentPath;
-                    pathArrayIdx++;
-                }
-            }
-
-            // Sort the path array. Note that the paths just need to be grouped at each level.
-            qsort(pathArray, pathArrayIdx, sizeof(*pathArray), CompareStrings);
-
-            // Determine the path depth the encoding should start at.
-            int levelCount = 0;
-            int i;
-            for (i = 0; path[i] != '\0'; i++)
-            {
-                if ('/' == path[i])
-                {
-                    levelCount++;
-                }
-            }
-
-            // compose the CBOR buffer
+            // compose the CBOR buffer, starting at the level below the path.
             uint8_t buf[CBOR_DECODER_BUFFER_BYTES] = {0};
             CborEncoder rootNode;
+            size_t count = 0;
 
             cbor_encoder_init(&rootNode, (uint8_t*)&buf, sizeof(buf), 0); // no error check needed.
 
-            if (LE_OK ==  EncodeMultiData(pathArray, &rootNode, 0, (pathArrayIdx - 1),
-                                          (levelCount + 1), false, true))
+            if (LE_OK == EncodePathNode(le_hashmap_Get(PathNodeMap, path), &rootNode, false,
+                                        &count))
             {
                 RespondToAvServer(COAP_CONTENT_AVAILABLE,
                                   buf, cbor_encoder_get_buffer_size(&rootNode, buf));
@@ -2137,7 +2804,6 @@ static void ProcessAvServerWriteRequest
 
     CborParser parser;
     CborValue value;
-    le_cfg_IteratorRef_t iterRef;
 
     if (CborNoError != cbor_parser_init(payload, payloadLen, 0, &parser, &value))
     {
@@ -2187,9 +2853,9 @@ static void ProcessAvServerWriteRequest
                     // Check all requested data by specifying dry run flag true
                     le_result_t result = DecodeMultiData(&value,
                                                          pathBuff,
+                                                         strlen(pathBuff),
                                                          LE_AVDATA_PATH_NAME_BYTES,
-                                                         true,
-                                                         NULL);
+                                                         true);
                     if (LE_OK != result)
                     {
                         RespondToAvServer(COAP_BAD_REQUEST, NULL, 0);
@@ -2207,19 +2873,12 @@ static void ProcessAvServerWriteRequest
                         return;
                     }
 
-                    // Create write transaction
-                    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
                     // Now decode and save to assetData
                     result = DecodeMultiData(&checkedValue,
                                              pathBuff,
+                                             strlen(pathBuff),
                                              LE_AVDATA_PATH_NAME_BYTES,
-                                             false,
-                                             iterRef);
-
-                    LE_INFO("Commit transaction");
-                    // Write setting to config tree
-                    le_cfg_CommitTxn(iterRef);
+                                             false);
 
                     // Data is already checked. So any failure means something bad happened.
                     LE_CRIT_IF(result != LE_OK,
@@ -2259,14 +2918,8 @@ static void ProcessAvServerWriteRequest
         }
         else
         {
-            // Create write transaction
-            iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
             result = (type == LE_AVDATA_DATA_TYPE_NONE) ?
-                     LE_UNSUPPORTED : SetVal(path, assetValue, type, false, false, iterRef);
-
-            // Write setting to config tree
-            le_cfg_CommitTxn(iterRef);
+                     LE_UNSUPPORTED : SetVal(path, assetValue, type, false, false);
 
             switch (result)
             {
@@ -2418,6 +3071,49 @@ static void AvServerRequestHandler
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Resource event handler being set by SetResourceHandler().
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_avdata_ResourceHandlerFunc_t handlerPtr; ///< Handler function, NULL to remove the handler.
+    void* contextPtr;                           ///< Client context for the handler.
+    int count;                                  ///< Number of asset data the handler was set on.
+}
+HandlerSetting_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Asset data visitor setting (or removing) the resource event handler of an asset data.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetResourceHandler
+(
+    const char* path,                           ///< [IN] Asset data path
+    AssetData_t* assetDataPtr,                  ///< [IN] Asset data
+    void* contextPtr                            ///< [IN] Handler setting
+)
+{
+    HandlerSetting_t* settingPtr = contextPtr;
+
+    if (settingPtr->handlerPtr != NULL)
+    {
+        LE_INFO("Registering handler on %s", path);
+    }
+    else
+    {
+        LE_INFO("Removing handler from %s", path);
+    }
+
+    assetDataPtr->handlerPtr = settingPtr->handlerPtr;
+    assetDataPtr->contextPtr = settingPtr->contextPtr;
+    settingPtr->count++;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /* Public functions                                                                               */
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2439,9 +3135,7 @@ le_avdata_ResourceEventHandlerRef_t le_avdata_AddResourceEventHandler
     void* contextPtr                            ///< [IN] context pointer
 )
 {
-    const char* key;
     void* handlerRef = NULL;
-    AssetData_t* assetDataPtr = NULL;
     char pathCopy[LE_AVDATA_PATH_NAME_LEN] = {0};
     strncpy(pathCopy, path, LE_AVDATA_PATH_NAME_LEN);
     pathCopy[LE_AVDATA_PATH_NAME_LEN - 1]= '\0';
@@ -2453,34 +3147,25 @@ le_avdata_ResourceEventHandlerRef_t le_avdata_AddResourceEventHandler
     char namespacedPath[LE_AVDATA_PATH_NAME_BYTES];
     GetNamespacedPath(pathCopy, namespacedPath, sizeof(namespacedPath));
 
-    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
-
     // Add handler to all children under this path
-    while (le_hashmap_NextNode(iter) == LE_OK)
-    {
-        key = le_hashmap_GetKey(iter);
-        LE_ASSERT(NULL != key);
+    PathNode_t* nodePtr = le_hashmap_Get(PathNodeMap, namespacedPath);
+    HandlerSetting_t setting = { handlerPtr, contextPtr, 0 };
 
-        if ((strcmp(namespacedPath, key) == 0) ||
-            le_path_IsSubpath(namespacedPath, key, "/"))
-        {
-            LE_INFO("Registering handler on %s", key);
-            assetDataPtr = le_hashmap_GetValue(iter);
-            assetDataPtr->handlerPtr = handlerPtr;
-            assetDataPtr->contextPtr = contextPtr;
+    if (nodePtr != NULL)
+    {
+        VisitAssetData(nodePtr, SetResourceHandler, &setting);
+    }
 
-            if (NULL == handlerRef)
-            {
-                LE_INFO("Handler registered on path %s", pathCopy);
-                char* assetDataHandlerPtr = le_mem_ForceAlloc(AssetDataHandlerPool);
+    if (setting.count > 0)
+    {
+        LE_INFO("Handler registered on path %s", pathCopy);
+        char* assetDataHandlerPtr = le_mem_ForceAlloc(AssetDataHandlerPool);
 
-                // Copy path and use the path as a reference to the handler.
-                LE_ASSERT(le_utf8_Copy(assetDataHandlerPtr, pathCopy, LE_AVDATA_PATH_NAME_BYTES, NULL) == LE_OK);
+        // Copy path and use the path as a reference to the handler.
+        LE_ASSERT(le_utf8_Copy(assetDataHandlerPtr, pathCopy, LE_AVDATA_PATH_NAME_BYTES, NULL) == LE_OK);
 
-                // Create reference to the handler.
-                handlerRef = le_ref_CreateRef(ResourceEventHandlerMap, assetDataHandlerPtr);
-            }
-        }
+        // Create reference to the handler.
+        handlerRef = le_ref_CreateRef(ResourceEventHandlerMap, assetDataHandlerPtr);
     }
 
     return handlerRef;
@@ -2497,8 +3182,6 @@ void le_avdata_RemoveResourceEventHandler
     le_avdata_ResourceEventHandlerRef_t addHandlerRef ///< [IN] resource event handler ref
 )
 {
-    const char* key;
-    AssetData_t* assetDataPtr = NULL;
     char* path = le_ref_Lookup(ResourceEventHandlerMap, addHandlerRef);
 
     if (NULL == path)
@@ -2515,22 +3198,12 @@ void le_avdata_RemoveResourceEventHandler
     GetNamespacedPath(path, namespacedPath, sizeof(namespacedPath));
 
     // Remove handlers from all resources under this node
-    le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
+    PathNode_t* nodePtr = le_hashmap_Get(PathNodeMap, namespacedPath);
+    HandlerSetting_t setting = { NULL, NULL, 0 };
 
-    while (le_hashmap_NextNode(iter) == LE_OK)
+    if (nodePtr != NULL)
     {
-        key = le_hashmap_GetKey(iter);
-        LE_ASSERT(NULL != key);
-
-        if ((strcmp(namespacedPath, key) == 0) ||
-             le_path_IsSubpath(namespacedPath, key, "/"))
-        {
-            LE_INFO("Removing handler from %s", key);
-            assetDataPtr = le_hashmap_GetValue(iter);
-
-            assetDataPtr->handlerPtr = NULL;
-            assetDataPtr->contextPtr = NULL;
-        }
+        VisitAssetData(nodePtr, SetResourceHandler, &setting);
     }
 
     // Delete the handler reference
@@ -2627,19 +3300,10 @@ le_result_t le_avdata_SetNull
     const char* path ///< [IN] Asset data path
 )
 {
-    le_cfg_IteratorRef_t iterRef;
     AssetValue_t assetValue;
     memset(&assetValue, 0, sizeof(AssetValue_t));
 
-    // Create write transaction
-    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
-    le_result_t result = SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_NONE, true, false, iterRef);
-
-    // Write setting to config tree
-    le_cfg_CommitTxn(iterRef);
-
-    return result;
+    return SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_NONE, true, false);
 }
 
 
@@ -2705,19 +3369,10 @@ le_result_t le_avdata_SetInt
     int32_t value     ///< [IN] integer to be set
 )
 {
-    le_cfg_IteratorRef_t iterRef;
     AssetValue_t assetValue;
     assetValue.intValue = value;
 
-    // Create write transaction
-    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
-    le_result_t result =  SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_INT, true, false, iterRef);
-
-    // Write setting to config tree
-    le_cfg_CommitTxn(iterRef);
-
-    return result;
+    return SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_INT, true, false);
 }
 
 
@@ -2783,19 +3438,10 @@ le_result_t le_avdata_SetFloat
     double value       ///< [IN] float to be set
 )
 {
-    le_cfg_IteratorRef_t iterRef;
     AssetValue_t assetValue;
     assetValue.floatValue = value;
 
-    // Create write transaction
-    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
-    le_result_t result = SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_FLOAT, true, false, iterRef);
-
-    // Write setting to config tree
-    le_cfg_CommitTxn(iterRef);
-
-    return result;
+    return SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_FLOAT, true, false);
 }
 
 
@@ -2861,19 +3507,10 @@ le_result_t le_avdata_SetBool
     bool value        ///< [IN] bool to be set
 )
 {
-    le_cfg_IteratorRef_t iterRef;
     AssetValue_t assetValue;
     assetValue.boolValue = value;
 
-    // Create write transaction
-    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
-    le_result_t result = SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_BOOL, true, false, iterRef);
-
-    // Write setting to config tree
-    le_cfg_CommitTxn(iterRef);
-
-    return result;
+    return SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_BOOL, true, false);
 }
 
 
@@ -2940,20 +3577,11 @@ le_result_t le_avdata_SetString
     const char* value ///< [IN] string to be set
 )
 {
-    le_cfg_IteratorRef_t iterRef;
     AssetValue_t assetValue;
     assetValue.strValuePtr = le_mem_ForceAlloc(StringPool);
     le_utf8_Copy(assetValue.strValuePtr, value, LE_AVDATA_STRING_VALUE_BYTES, NULL);
 
-    // Create write transaction
-    iterRef = le_cfg_CreateWriteTxn(CFG_ASSET_SETTING_PATH);
-
-    le_result_t result = SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_STRING, true, false, iterRef);
-
-    // Write setting to config tree
-    le_cfg_CommitTxn(iterRef);
-
-    return result;
+    return SetVal(path, assetValue, LE_AVDATA_DATA_TYPE_STRING, true, false);
 }
 
 
@@ -3261,64 +3889,51 @@ le_result_t le_avdata_Push
         return LE_FAULT;
     }
 
-    le_result_t result = IsPathFound(namespacedPath);
+    PathNode_t* nodePtr = le_hashmap_Get(PathNodeMap, namespacedPath);
 
-    char* pathArray[le_hashmap_Size(AssetDataMap)];
-    memset(pathArray, 0, sizeof(pathArray));
-    int pathArrayIdx = 0;
-
-    if (result == LE_OK)
+    // There are nodes only for asset data and for the paths above them.
+    if (nodePtr == NULL)
     {
-        pathArray[0] = namespacedPath;
-        pathArrayIdx = 1;
+        return LE_NOT_FOUND;
     }
-    else if (result == LE_NOT_FOUND)
-    {
-        // The path contain children nodes, so there might be multiple asset data under it.
-        if (IsPathParent(namespacedPath))
-        {
-            LE_DEBUG(">>>>> path not found, but is parent path. Encoding all children nodes.");
-
-            // Gather all eligible paths in a path array.
-            AssetData_t* assetDataPtr;
 
-            le_hashmap_It_Ref_t iter = le_hashmap_GetIterator(AssetDataMap);
-            char* currentPath;
+    // List the nodes from the top level down to the path, to nest the CBOR maps from the root.
+    int depth = 0;
+    PathNode_t* branchNodePtr;
 
-            while (le_hashmap_NextNode(iter) == LE_OK)
-            {
-                currentPath = (char *)le_hashmap_GetKey(iter);
-                assetDataPtr = le_hashmap_GetValue(iter);
+    for (branchNodePtr = nodePtr; branchNodePtr != &RootPathNode;
+         branchNodePtr = branchNodePtr->parentPtr)
+    {
+        depth++;
+    }
 
-                if ((le_path_IsSubpath(namespacedPath, currentPath, SLASH_DELIMITER_STRING)) &&
-                    ((assetDataPtr->serverAccess & LE_AVDATA_ACCESS_READ) == LE_AVDATA_ACCESS_READ))
-                {
-                    // Put the currentPath in the path array.
-                    pathArray[pathArrayIdx] = currentPath;
-                    pathArrayIdx++;
-                }
-            }
+    PathNode_t* branch[depth];
+    int level = depth;
 
-            // Sort the path array. Note that the paths just need to be grouped at each level.
-            qsort(pathArray, pathArrayIdx, sizeof(*pathArray), CompareStrings);
-        }
-        else
-        {
-            // Path does not exists
-            return LE_NOT_FOUND;
-        }
-    }
-    else
+    for (branchNodePtr = nodePtr; branchNodePtr != &RootPathNode;
+         branchNodePtr = branchNodePtr->parentPtr)
     {
-        return LE_FAULT;
+        branch[--level] = branchNodePtr;
     }
 
     // compose the CBOR buffer
     uint8_t buf[CBOR_DECODER_BUFFER_BYTES] = {0};
     CborEncoder rootNode;
+    CborEncoder emptyNode;
+    size_t count = 0;
     cbor_encoder_init(&rootNode, (uint8_t*)&buf, sizeof(buf), 0); // no error check needed.
 
-    result = EncodeMultiData(pathArray, &rootNode, 0, (pathArrayIdx - 1), 1, true, true);
+    le_result_t result = EncodePathBranch(branch, depth, 0, &rootNode, true, &count);
+
+    // Nothing readable below the path: push an empty map instead of empty maps nested by level.
+    if ((result == LE_OK) && (count == 0))
+    {
+        cbor_encoder_init(&rootNode, (uint8_t*)&buf, sizeof(buf), 0);
+        result = ((CborNoError == cbor_encoder_create_map(&rootNode, &emptyNode,
+                                                          CborIndefiniteLength)) &&
+                  (CborNoError == cbor_encoder_close_container(&rootNode, &emptyNode))) ?
+                 LE_OK : LE_FAULT;
+    }
 
     if (result == LE_OK)
     {
@@ -3875,6 +4490,38 @@ void le_avdata_ReleaseSession
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the pending setting updates to the config tree, before the settings are accessed
+ * directly in the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+void avData_FlushSettings
+(
+    void
+)
+{
+    FlushSettings();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * SIGTERM handler, writing the pending setting updates before exiting.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SigTermHandler
+(
+    int sigNum    ///< [IN] Signal received
+)
+{
+    LE_INFO("Flushing pending setting updates before exiting.");
+
+    FlushSettings();
+    exit(EXIT_SUCCESS);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Initialize the avData module
@@ -3888,11 +4535,13 @@ void avData_Init
     // Create various memory pools
     AssetPathPool = le_mem_CreatePool("AssetData Path", LE_AVDATA_PATH_NAME_BYTES);
     AssetDataPool = le_mem_CreatePool("AssetData_t", sizeof(AssetData_t));
+    PathNodePool = le_mem_CreatePool("AssetData PathNode_t", sizeof(PathNode_t));
     AssetDataClientPool = le_mem_CreatePool("AssetData client", sizeof(AssetDataClient_t));
     StringPool = le_mem_CreatePool("AssetData string", LE_AVDATA_STRING_VALUE_BYTES);
     ArgumentPool = le_mem_CreatePool("AssetData Argument_t", sizeof(Argument_t));
     RecordRefDataPoolRef = le_mem_CreatePool("Record ref data pool", sizeof(RecordRefData_t));
     AssetDataHandlerPool = le_mem_CreatePool("AssetData Handlers", LE_AVDATA_PATH_NAME_BYTES);
+    PendingSettingPool = le_mem_CreatePool("AssetData PendingSetting_t", sizeof(PendingSetting_t));
 
     // Initialize the asset data client list
     AssetDataClientList = LE_DLS_LIST_INIT;
@@ -3901,6 +4550,22 @@ void avData_Init
     AssetDataMap = le_hashmap_Create("Asset Data Map", MAX_EXPECTED_ASSETDATA,
                                      le_hashmap_HashString, le_hashmap_EqualsString);
 
+    // Create the hashmap to store the asset data path tree nodes, starting with the root.
+    PathNodeMap = le_hashmap_Create("Asset Data Path Map", MAX_EXPECTED_ASSETDATA,
+                                    le_hashmap_HashString, le_hashmap_EqualsString);
+    le_hashmap_Put(PathNodeMap, RootPathNode.path, &RootPathNode);
+
+    // Create the hashmap and the timer for the setting updates written behind to the config tree.
+    PendingSettingMap = le_hashmap_Create("Pending Setting Map", MAX_PENDING_SETTINGS,
+                                          le_hashmap_HashString, le_hashmap_EqualsString);
+    SettingFlushTimerRef = le_timer_Create("SettingFlushTimer");
+    le_timer_SetMsInterval(SettingFlushTimerRef, SETTING_FLUSH_INTERVAL_MS);
+    le_timer_SetHandler(SettingFlushTimerRef, SettingFlushTimerHandler);
+
+    // Don't lose the pending setting updates when the daemon is stopped.
+    le_sig_Block(SIGTERM);
+    le_sig_SetEventHandler(SIGTERM, SigTermHandler);
+
     // The argument list is used once at the command handler execution, so the map is really holding
     // one object at a time. Therefore the map size isn't expected to be big - techinically 1 is
     // enough.
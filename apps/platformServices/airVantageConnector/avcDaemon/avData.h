@@ -34,6 +34,17 @@ void avData_Init
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the pending setting updates to the config tree, before the settings are accessed
+ * directly in the config tree.
+ */
+//--------------------------------------------------------------------------------------------------
+void avData_FlushSettings
+(
+    void
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Called by avcServer when the session state is SESSION_STARTED or SESSION_STOPPED.
@@ -145,6 +145,20 @@
 //--------------------------------------------------------------------------------------------------
 #define UPDATE_TYPE_FILENAME                UPDATE_INFO_DIR "/" "updateType"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directory of the data waiting to be pushed
+ */
+//--------------------------------------------------------------------------------------------------
+#define PUSH_SPOOL_DIR                      PKGDWL_LEFS_DIR "/" "push"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Position of the next data to push in the push spool
+ */
+//--------------------------------------------------------------------------------------------------
+#define PUSH_SPOOL_CURSOR_PATH              PUSH_SPOOL_DIR "/" "cursor"
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Name of the avc configuration file
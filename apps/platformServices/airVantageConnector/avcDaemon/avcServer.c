@@ -4095,8 +4095,15 @@ COMPONENT_INIT
     // Read the user defined timeout from config tree @ /apps/avcService/activityTimeout
     le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(AVC_SERVICE_CFG);
     int timeout = le_cfg_GetInt(iterRef, "activityTimeout", 20);
+    // Read the optional DTLS inactivity duration from @ /apps/avcService/dtlsNatTimeout
+    int natTimeout = le_cfg_GetInt(iterRef, "dtlsNatTimeout", -1);
     le_cfg_CancelTxn(iterRef);
     avcClient_SetActivityTimeout(timeout);
+    if (0 <= natTimeout)
+    {
+        LE_INFO("DTLS NAT timeout set to %d seconds", natTimeout);
+        lwm2mcore_SetDtlsNatTimeout((uint32_t)natTimeout);
+    }
 
     // Display user agreement configuration
     ReadUserAgreementConfiguration();
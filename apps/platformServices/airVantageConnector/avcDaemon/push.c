@@ -10,6 +10,7 @@
 #include "legato.h"
 #include "interfaces.h"
 #include "push.h"
+#include "pushSpool.h"
 #include "avcClient.h"
 
 #include <lwm2mcore/lwm2mcore.h>
@@ -32,19 +33,27 @@ static le_dls_List_t PushDataList;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Returns if data is currently being pushed to the server.
+ * Spooled callback memory pool.  Initialized in push_Init().
  */
 //--------------------------------------------------------------------------------------------------
-static bool IsPushing = false;
+static le_mem_PoolRef_t SpooledCallbackPoolRef = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * List of callbacks of the data waiting in the spool, sorted by sequence number.  Initialized in
+ * push_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_dls_List_t SpooledCallbackList;
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum number of items queued for push.
- * The number 10 is used because it takes max memory limit / MAX_CBOR_BUFFER_NUMBYTES
+ * Returns if data is currently being pushed to the server.
  */
 //--------------------------------------------------------------------------------------------------
-#define MAX_PUSH_QUEUE 10
+static bool IsPushing = false;
 
 
 //--------------------------------------------------------------------------------------------------
@@ -55,10 +64,12 @@ static bool IsPushing = false;
 typedef struct
 {
     uint16_t mid;
-    uint8_t buffer[4096];
+    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
     size_t bufferLength;
     lwm2mcore_PushContent_t contentType;
     bool isSent;
+    bool isSpooled;                         ///< Read from the spool
+    pushSpool_Position_t spoolPosition;     ///< Position after the data in the spool
     le_avdata_CallbackResultFunc_t handlerPtr;
     void* callbackContextPtr;
     le_dls_Link_t link;
@@ -66,6 +77,22 @@ typedef struct
 PushData_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Callback of data waiting in the spool.  Callbacks only live in memory: data recovered from the
+ * spool after a restart is pushed without callback.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t seq;                           ///< Sequence number of the data in the spool
+    le_avdata_CallbackResultFunc_t handlerPtr;
+    void* callbackContextPtr;
+    le_dls_Link_t link;
+}
+SpooledCallback_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Returns if the service is busy pushing data or will be pushing another set of data
@@ -87,53 +114,104 @@ bool IsPushBusy
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Handles ACK returned for every data pushed
+ * Returns the number of buffers that can still be queued for push
  */
 //--------------------------------------------------------------------------------------------------
-static void PushCallBackHandler
+size_t push_GetFreeSlotCount
 (
-    lwm2mcore_AckResult_t result,
-    uint16_t mid
+    void
 )
 {
-    LE_INFO("Push callback mid: %d", mid);
-    le_avdata_PushStatus_t status;
+    size_t pushQueueLength = le_dls_NumLinks(&PushDataList);
+    size_t spoolSlotCount = pushSpool_GetFreeBytes() / (MAX_CBOR_BUFFER_NUMBYTES + 16);
 
-    if (result == LWM2MCORE_ACK_RECEIVED)
+    if (spoolSlotCount >= MAX_PUSH_QUEUE)
     {
-        status = LE_AVDATA_PUSH_SUCCESS;
+        return MAX_PUSH_QUEUE;
     }
-    else
+
+    if (pushQueueLength >= MAX_PUSH_QUEUE)
     {
-        status = LE_AVDATA_PUSH_FAILED;
+        return spoolSlotCount;
     }
 
-    le_dls_Link_t* linkPtr = le_dls_Peek(&PushDataList);
+    return MAX_PUSH_QUEUE - pushQueueLength;
+}
 
-    // Return callback with associated message id
-    while (linkPtr != NULL)
+//--------------------------------------------------------------------------------------------------
+/**
+ * Move data from the spool to the push queue, as long as the queue has free slots
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadSpooledData
+(
+    void
+)
+{
+    while ((le_dls_NumLinks(&PushDataList) < MAX_PUSH_QUEUE) && !pushSpool_IsEmpty())
     {
-        PushData_t* pDataPtr = CONTAINER_OF(linkPtr, PushData_t, link);
-        if (pDataPtr->mid == mid)
+        PushData_t* pDataPtr = le_mem_ForceAlloc(PushDataPoolRef);
+        uint32_t seq;
+
+        if (LE_OK != pushSpool_Read(pDataPtr->buffer,
+                                    &pDataPtr->bufferLength,
+                                    &pDataPtr->contentType,
+                                    &seq,
+                                    &pDataPtr->spoolPosition))
         {
-            le_avdata_CallbackResultFunc_t handlerPtr = pDataPtr->handlerPtr;
-            if (handlerPtr != NULL)
-            {
-                handlerPtr(status, pDataPtr->callbackContextPtr);
-            }
-            le_dls_Remove(&PushDataList, linkPtr);
             le_mem_Release(pDataPtr);
-            linkPtr = NULL;
-            IsPushing = false;
             break;
         }
 
-        linkPtr = le_dls_PeekNext(&PushDataList, linkPtr);
+        pDataPtr->isSent = false;
+        pDataPtr->isSpooled = true;
+        pDataPtr->handlerPtr = NULL;
+        pDataPtr->callbackContextPtr = NULL;
+
+        // Callbacks are sorted like the spool.  Earlier ones belong to data lost from the spool.
+        le_dls_Link_t* linkPtr = le_dls_Peek(&SpooledCallbackList);
+
+        while (linkPtr != NULL)
+        {
+            SpooledCallback_t* callbackPtr = CONTAINER_OF(linkPtr, SpooledCallback_t, link);
+
+            if ((int32_t)(callbackPtr->seq - seq) > 0)
+            {
+                break;
+            }
+
+            le_dls_Remove(&SpooledCallbackList, linkPtr);
+
+            if (callbackPtr->seq == seq)
+            {
+                pDataPtr->handlerPtr = callbackPtr->handlerPtr;
+                pDataPtr->callbackContextPtr = callbackPtr->callbackContextPtr;
+            }
+            else
+            {
+                callbackPtr->handlerPtr(LE_AVDATA_PUSH_FAILED, callbackPtr->callbackContextPtr);
+            }
+
+            le_mem_Release(callbackPtr);
+            linkPtr = le_dls_Peek(&SpooledCallbackList);
+        }
+
+        pDataPtr->link = LE_DLS_LINK_INIT;
+        le_dls_Queue(&PushDataList, &pDataPtr->link);
     }
+}
 
-    // Try sending the next queued item
-    linkPtr = NULL;
-    linkPtr = le_dls_Peek(&PushDataList);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Send the first queued item not sent yet
+ */
+//--------------------------------------------------------------------------------------------------
+static void SendNextData
+(
+    void
+)
+{
+    le_dls_Link_t* linkPtr = le_dls_Peek(&PushDataList);
 
     while (linkPtr != NULL)
     {
@@ -152,6 +230,7 @@ static void PushCallBackHandler
             if (result == LE_OK)
             {
                 pDataPtr->mid = mid;
+                pDataPtr->isSent = true;
                 IsPushing = true;
             }
 
@@ -162,16 +241,135 @@ static void PushCallBackHandler
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save data to the spool, to be pushed once the previous data has been pushed
+ *
+ * @return
+ *  - LE_OK             The data is saved
+ *  - LE_NO_MEMORY      The spool is full, or disabled
+ *  - LE_FAULT          On any other errors
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SpoolBuffer
+(
+    uint8_t* bufferPtr,
+    size_t bufferLength,
+    lwm2mcore_PushContent_t contentType,
+    le_avdata_CallbackResultFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    uint32_t seq;
+    le_result_t result = pushSpool_Append(bufferPtr, bufferLength, contentType, &seq);
+
+    if (result != LE_OK)
+    {
+        return result;
+    }
+
+    LE_DEBUG("Data has been spooled.");
+
+    if (handlerPtr != NULL)
+    {
+        SpooledCallback_t* callbackPtr = le_mem_ForceAlloc(SpooledCallbackPoolRef);
+        callbackPtr->seq = seq;
+        callbackPtr->handlerPtr = handlerPtr;
+        callbackPtr->callbackContextPtr = contextPtr;
+        callbackPtr->link = LE_DLS_LINK_INIT;
+        le_dls_Queue(&SpooledCallbackList, &callbackPtr->link);
+    }
+
+    // Start pushing if nothing is being pushed
+    LoadSpooledData();
+
+    if (!IsPushing && (LE_AVC_DM_SESSION == avcClient_GetSessionType()))
+    {
+        SendNextData();
+    }
+
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles ACK returned for every data pushed
+ */
+//--------------------------------------------------------------------------------------------------
+static void PushCallBackHandler
+(
+    lwm2mcore_AckResult_t result,
+    uint16_t mid
+)
+{
+    LE_INFO("Push callback mid: %d", mid);
+    le_avdata_PushStatus_t status;
+
+    if (result == LWM2MCORE_ACK_RECEIVED)
+    {
+        status = LE_AVDATA_PUSH_SUCCESS;
+    }
+    else
+    {
+        status = LE_AVDATA_PUSH_FAILED;
+    }
+
+    le_dls_Link_t* linkPtr = le_dls_Peek(&PushDataList);
+
+    // Return callback with associated message id
+    while (linkPtr != NULL)
+    {
+        PushData_t* pDataPtr = CONTAINER_OF(linkPtr, PushData_t, link);
+        if (pDataPtr->isSent && (pDataPtr->mid == mid))
+        {
+            IsPushing = false;
+
+            if (pDataPtr->isSpooled && (status != LE_AVDATA_PUSH_SUCCESS))
+            {
+                // Keep the data in the spool and at the head of the queue, so that it is pushed
+                // again, before the data following it, on the next retry
+                LE_WARN("Spooled data mid %d not acknowledged, retry later", mid);
+                pDataPtr->isSent = false;
+                return;
+            }
+
+            le_avdata_CallbackResultFunc_t handlerPtr = pDataPtr->handlerPtr;
+            if (handlerPtr != NULL)
+            {
+                handlerPtr(status, pDataPtr->callbackContextPtr);
+            }
+            if (pDataPtr->isSpooled)
+            {
+                pushSpool_Commit(pDataPtr->spoolPosition);
+            }
+            le_dls_Remove(&PushDataList, linkPtr);
+            le_mem_Release(pDataPtr);
+            linkPtr = NULL;
+            break;
+        }
+
+        linkPtr = le_dls_PeekNext(&PushDataList, linkPtr);
+    }
+
+    // Refill the queue from the spool and try sending the next queued item
+    LoadSpooledData();
+    SendNextData();
+}
+
 
 //--------------------------------------------------------------------------------------------------
 /**
  * Push buffer to the server
  *
  * @return
+ * Data that cannot be sent right away, because there is no session or the queue is full, is saved
+ * in the spool and pushed in order once possible, even after a restart.
+ *
+ * @return
  *  - LE_OK             The function succeeded
  *  - LE_BUSY           Data queued for push
- *  - LE_NOT_POSSIBLE   Data queue is full, try pushing data again later
- *  - LE_FAULT          On any other errors
+ *  - LE_NOT_POSSIBLE   Data queue and spool are full, try pushing data again later
+ *  - LE_FAULT          If the buffer is larger than MAX_CBOR_BUFFER_NUMBYTES or on any other errors
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t PushBuffer
@@ -185,13 +383,35 @@ le_result_t PushBuffer
 {
     uint16_t mid = 0;
     le_result_t result;
+    bool isQueueFull = (le_dls_NumLinks(&PushDataList) >= MAX_PUSH_QUEUE);
 
-    if (le_dls_NumLinks(&PushDataList) >= MAX_PUSH_QUEUE)
+    if (bufferLength > MAX_CBOR_BUFFER_NUMBYTES)
     {
-        return LE_NOT_POSSIBLE;
+        LE_ERROR("Cannot push %zu bytes, limit is %d", bufferLength, MAX_CBOR_BUFFER_NUMBYTES);
+        result = LE_FAULT;
     }
+    else if (isQueueFull
+             || !pushSpool_IsEmpty()
+             || (LE_AVC_DM_SESSION != avcClient_GetSessionType()))
+    {
+        // Keep the order of the data already in the spool
+        if (LE_OK == SpoolBuffer(bufferPtr, bufferLength, contentType, handlerPtr, contextPtr))
+        {
+            return LE_BUSY;
+        }
 
-    result = avcClient_Push(bufferPtr, bufferLength, contentType, &mid);
+        if (isQueueFull || !pushSpool_IsEmpty())
+        {
+            return LE_NOT_POSSIBLE;
+        }
+
+        // Spool is disabled or failing: try to push anyway
+        result = avcClient_Push(bufferPtr, bufferLength, contentType, &mid);
+    }
+    else
+    {
+        result = avcClient_Push(bufferPtr, bufferLength, contentType, &mid);
+    }
 
     if (result != LE_FAULT)
     {
@@ -211,6 +431,7 @@ le_result_t PushBuffer
         }
 
         // Save data to send
+        pDataPtr->isSpooled = false;
         pDataPtr->bufferLength = bufferLength;
         memcpy(pDataPtr->buffer, bufferPtr, bufferLength);
 
@@ -287,6 +508,13 @@ le_result_t push_Retry
         linkPtr = le_dls_PeekNext(&PushDataList, linkPtr);
     }
 
+    // Nothing in progress: start pushing the queued and spooled data
+    if ((LE_NOT_FOUND == result) && !IsPushing)
+    {
+        LoadSpooledData();
+        SendNextData();
+    }
+
     return result;
 }
 
@@ -302,9 +530,13 @@ le_result_t push_Init
 {
     PushDataPoolRef = le_mem_CreatePool("Push record pool", sizeof(PushData_t));
     PushDataList = LE_DLS_LIST_INIT;
+    IsPushing = false;
+
+    SpooledCallbackPoolRef = le_mem_CreatePool("Spooled callback pool", sizeof(SpooledCallback_t));
+    SpooledCallbackList = LE_DLS_LIST_INIT;
 
     // Set the push callback handler
     lwm2mcore_SetPushCallback(PushCallBackHandler);
 
-    return LE_OK;
+    return pushSpool_Init();
 }
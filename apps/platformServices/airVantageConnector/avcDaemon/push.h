@@ -17,6 +17,15 @@
 #define MAX_CBOR_BUFFER_NUMBYTES 4096 // TODO: verify value
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of items queued for push.
+ * The number 10 is used because it takes max memory limit / MAX_CBOR_BUFFER_NUMBYTES
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_PUSH_QUEUE 10
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Returns if the service is busy pushing data or will be pushing another set of data
@@ -28,6 +37,17 @@ LE_SHARED bool IsPushBusy
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Returns the number of buffers that can still be queued for push
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED size_t push_GetFreeSlotCount
+(
+    void
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Push buffer to the server
@@ -36,7 +56,7 @@ LE_SHARED bool IsPushBusy
  *  - LE_OK             The function succeeded
  *  - LE_BUSY           Data queued for push
  *  - LE_NOT_POSSIBLE   Data queue is full, try pushing data again later
- *  - LE_FAULT          On any other errors
+ *  - LE_FAULT          If the buffer is larger than MAX_CBOR_BUFFER_NUMBYTES or on any other errors
  */
 //--------------------------------------------------------------------------------------------------
 LE_SHARED le_result_t PushBuffer
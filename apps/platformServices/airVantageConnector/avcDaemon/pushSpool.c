@@ -0,0 +1,743 @@
+/**
+ * @file pushSpool.c
+ *
+ * Persistent spool of the data waiting to be pushed.
+ *
+ * Data that cannot be pushed right away (no session, or push queue full) is appended to segment
+ * files in PUSH_SPOOL_DIR, named after their index, and replayed in order once it can be pushed.
+ * Each record of a segment is a header followed by the pushed buffer:
+ *
+ *      | seq (4) | length (2) | content type (1) | magic (1) | crc32 (4) | buffer (length) |
+ *
+ * Segments are never modified once written.  The cursor file holds the position after the last
+ * record pushed, and the segments before this position are deleted.  The cursor is only saved
+ * when a segment is deleted or every PUSH_SPOOL_CURSOR_SYNC_COUNT records, so a few records may be
+ * pushed twice after a restart.
+ *
+ * On startup, the segments are scanned from the cursor.  A record that does not match its CRC ends
+ * its segment, which drops a record torn by a power loss, and new records go to a new segment.
+ *
+ * <HR>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "push.h"
+#include "pushSpool.h"
+#include "avcFs.h"
+#include "avcFsConfig.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path and node of the maximum number of bytes used by the spool.  0 disables it.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_PUSH_SPOOL_PATH             "/apps/avcService/pushSpool"
+#define CFG_PUSH_SPOOL_MAX_SIZE         "maxSize"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default maximum number of bytes used by the spool
+ */
+//--------------------------------------------------------------------------------------------------
+#define PUSH_SPOOL_DEFAULT_MAX_BYTES    (512 * 1024)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a segment file.  Segments are deleted as a whole once all their records have
+ * been pushed.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PUSH_SPOOL_SEGMENT_BYTES        (64 * 1024)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of records pushed before the cursor is saved
+ */
+//--------------------------------------------------------------------------------------------------
+#define PUSH_SPOOL_CURSOR_SYNC_COUNT    8
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Magic values of the records and cursor
+ */
+//--------------------------------------------------------------------------------------------------
+#define RECORD_MAGIC                    0xA5
+#define CURSOR_MAGIC                    0x50534331  // "PSC1"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Header of a record
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t seq;               ///< Sequence number
+    uint16_t length;            ///< Length of the buffer
+    uint8_t contentType;        ///< lwm2mcore_PushContent_t
+    uint8_t magic;              ///< RECORD_MAGIC
+    uint32_t crc;               ///< CRC32 of the header, with this field set to 0, and buffer
+}
+RecordHeader_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Content of the cursor file
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t magic;             ///< CURSOR_MAGIC
+    uint32_t segment;           ///< Segment of the next record to push
+    uint32_t offset;            ///< Offset of the next record to push
+    uint32_t nextSeq;           ///< Sequence number of the next record appended
+    uint32_t crc;               ///< CRC32 of the fields above
+}
+Cursor_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of bytes used by the spool.  Read from the config tree in pushSpool_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t MaxBytes = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Position of the next record to push, i.e. after the last record committed
+ */
+//--------------------------------------------------------------------------------------------------
+static pushSpool_Position_t HeadPosition;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Position of the next record to read
+ */
+//--------------------------------------------------------------------------------------------------
+static pushSpool_Position_t ReadPosition;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Segment where records are appended, and its size
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t TailSegment = 0;
+static size_t TailSize = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes of all the segments
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t TotalBytes = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of records not read yet
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t UnreadCount = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of records committed since the cursor was saved
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t UnsavedCount = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sequence number of the next record appended
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t NextSeq = 0;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Files kept open for appending to the tail segment and reading the read segment
+ */
+//--------------------------------------------------------------------------------------------------
+static le_fs_FileRef_t AppendFileRef = NULL;
+static le_fs_FileRef_t ReadFileRef = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the path of a segment file
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetSegmentPath
+(
+    uint32_t segment,
+    char* pathPtr,
+    size_t pathSize
+)
+{
+    snprintf(pathPtr, pathSize, "%s/%08" PRIx32, PUSH_SPOOL_DIR, segment);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Close a file kept open, if any
+ */
+//--------------------------------------------------------------------------------------------------
+static void CloseFile
+(
+    le_fs_FileRef_t* fileRefPtr
+)
+{
+    if (*fileRefPtr != NULL)
+    {
+        if (LE_OK != le_fs_Close(*fileRefPtr))
+        {
+            LE_ERROR("failed to close spool segment");
+        }
+        *fileRefPtr = NULL;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the CRC32 of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetRecordCrc
+(
+    const RecordHeader_t* headerPtr,
+    const uint8_t* bufferPtr
+)
+{
+    RecordHeader_t header = *headerPtr;
+
+    header.crc = 0;
+
+    return le_crc_Crc32((uint8_t*)bufferPtr,
+                        header.length,
+                        le_crc_Crc32((uint8_t*)&header, sizeof(header), LE_CRC_START_CRC32));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a record at the current position of a segment file
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_OUT_OF_RANGE   End of the segment
+ *  - LE_FORMAT_ERROR   The record is truncated or damaged
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadRecord
+(
+    le_fs_FileRef_t fileRef,
+    RecordHeader_t* headerPtr,              ///< [OUT] Record header
+    uint8_t* bufferPtr                      ///< [OUT] Buffer of MAX_CBOR_BUFFER_NUMBYTES bytes
+)
+{
+    size_t size = sizeof(RecordHeader_t);
+
+    if (LE_OK != le_fs_Read(fileRef, (uint8_t*)headerPtr, &size))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    if (0 == size)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    if ((size != sizeof(RecordHeader_t))
+        || (headerPtr->magic != RECORD_MAGIC)
+        || (headerPtr->length > MAX_CBOR_BUFFER_NUMBYTES))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    size = headerPtr->length;
+
+    if ((LE_OK != le_fs_Read(fileRef, bufferPtr, &size))
+        || (size != headerPtr->length)
+        || (GetRecordCrc(headerPtr, bufferPtr) != headerPtr->crc))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the cursor.  The cursor is written to a new file which then replaces the old one, so that
+ * it is never left half written.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveCursor
+(
+    void
+)
+{
+    Cursor_t cursor;
+
+    cursor.magic = CURSOR_MAGIC;
+    cursor.segment = HeadPosition.segment;
+    cursor.offset = HeadPosition.offset;
+    cursor.nextSeq = NextSeq;
+    cursor.crc = le_crc_Crc32((uint8_t*)&cursor, offsetof(Cursor_t, crc), LE_CRC_START_CRC32);
+
+    if ((LE_OK != WriteFs(PUSH_SPOOL_CURSOR_PATH ".new", (uint8_t*)&cursor, sizeof(cursor)))
+        || (LE_OK != le_fs_Move(PUSH_SPOOL_CURSOR_PATH ".new", PUSH_SPOOL_CURSOR_PATH)))
+    {
+        LE_ERROR("Failed to save the push spool cursor");
+        return;
+    }
+
+    UnsavedCount = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the cursor
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_NOT_FOUND      There is no valid cursor
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LoadCursor
+(
+    void
+)
+{
+    Cursor_t cursor;
+    size_t size = 0;
+
+    if ((LE_OK != le_fs_GetSize(PUSH_SPOOL_CURSOR_PATH, &size))
+        || (size != sizeof(cursor))
+        || (LE_OK != ReadFs(PUSH_SPOOL_CURSOR_PATH, (uint8_t*)&cursor, &size))
+        || (size != sizeof(cursor))
+        || (cursor.magic != CURSOR_MAGIC)
+        || (cursor.crc != le_crc_Crc32((uint8_t*)&cursor,
+                                       offsetof(Cursor_t, crc),
+                                       LE_CRC_START_CRC32)))
+    {
+        return LE_NOT_FOUND;
+    }
+
+    HeadPosition.segment = cursor.segment;
+    HeadPosition.offset = cursor.offset;
+    NextSeq = cursor.nextSeq;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Delete a segment file
+ */
+//--------------------------------------------------------------------------------------------------
+static void DeleteSegment
+(
+    uint32_t segment
+)
+{
+    char path[LE_FS_PATH_MAX_LEN];
+    size_t size = 0;
+
+    if (segment == ReadPosition.segment)
+    {
+        CloseFile(&ReadFileRef);
+    }
+
+    if (segment == TailSegment)
+    {
+        CloseFile(&AppendFileRef);
+    }
+
+    GetSegmentPath(segment, path, sizeof(path));
+
+    if (LE_OK == le_fs_GetSize(path, &size))
+    {
+        DeleteFs(path);
+    }
+
+    TotalBytes = (TotalBytes > size) ? (TotalBytes - size) : 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a buffer to the spool
+ *
+ * @return
+ *  - LE_OK             The buffer is saved
+ *  - LE_NO_MEMORY      The spool is full, or disabled
+ *  - LE_FAULT          On any other errors
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pushSpool_Append
+(
+    const uint8_t* bufferPtr,               ///< [IN] Buffer, up to MAX_CBOR_BUFFER_NUMBYTES
+    size_t bufferLength,                    ///< [IN] Buffer length
+    lwm2mcore_PushContent_t contentType,    ///< [IN] Content type
+    uint32_t* seqPtr                        ///< [OUT] Sequence number of the buffer
+)
+{
+    uint8_t record[sizeof(RecordHeader_t) + MAX_CBOR_BUFFER_NUMBYTES];
+    RecordHeader_t* headerPtr = (RecordHeader_t*)record;
+    size_t recordSize = sizeof(RecordHeader_t) + bufferLength;
+    le_result_t result;
+
+    if (bufferLength > MAX_CBOR_BUFFER_NUMBYTES)
+    {
+        return LE_FAULT;
+    }
+
+    if (TotalBytes + recordSize > MaxBytes)
+    {
+        LE_WARN("Push spool is full: %zu bytes", TotalBytes);
+        return LE_NO_MEMORY;
+    }
+
+    // Start a new segment when the tail one is full
+    if ((TailSize > 0) && (TailSize + recordSize > PUSH_SPOOL_SEGMENT_BYTES))
+    {
+        CloseFile(&AppendFileRef);
+        TailSegment++;
+        TailSize = 0;
+    }
+
+    if (NULL == AppendFileRef)
+    {
+        char path[LE_FS_PATH_MAX_LEN];
+
+        GetSegmentPath(TailSegment, path, sizeof(path));
+
+        result = le_fs_Open(path,
+                            LE_FS_WRONLY | LE_FS_CREAT | LE_FS_APPEND | LE_FS_SYNC,
+                            &AppendFileRef);
+        if (LE_OK != result)
+        {
+            LE_ERROR("failed to open %s: %s", path, LE_RESULT_TXT(result));
+            AppendFileRef = NULL;
+            return LE_FAULT;
+        }
+    }
+
+    headerPtr->seq = NextSeq;
+    headerPtr->length = bufferLength;
+    headerPtr->contentType = contentType;
+    headerPtr->magic = RECORD_MAGIC;
+    memcpy(record + sizeof(RecordHeader_t), bufferPtr, bufferLength);
+    headerPtr->crc = GetRecordCrc(headerPtr, record + sizeof(RecordHeader_t));
+
+    result = le_fs_Write(AppendFileRef, record, recordSize);
+    if (LE_OK != result)
+    {
+        // The segment may end with a partial record now: append to a new segment
+        LE_ERROR("failed to write push spool segment: %s", LE_RESULT_TXT(result));
+        CloseFile(&AppendFileRef);
+        TailSegment++;
+        TailSize = 0;
+        return LE_FAULT;
+    }
+
+    TailSize += recordSize;
+    TotalBytes += recordSize;
+    UnreadCount++;
+    *seqPtr = NextSeq++;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the next buffer of the spool.  The buffer stays in the spool until pushSpool_Commit() is
+ * called with its position.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_NOT_FOUND      No buffer left to read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pushSpool_Read
+(
+    uint8_t* bufferPtr,                     ///< [OUT] Buffer of MAX_CBOR_BUFFER_NUMBYTES bytes
+    size_t* bufferLengthPtr,                ///< [OUT] Buffer length
+    lwm2mcore_PushContent_t* contentTypePtr,///< [OUT] Content type
+    uint32_t* seqPtr,                       ///< [OUT] Sequence number of the buffer
+    pushSpool_Position_t* positionPtr       ///< [OUT] Position after the buffer
+)
+{
+    RecordHeader_t header;
+    le_result_t result;
+
+    while (UnreadCount > 0)
+    {
+        if (NULL == ReadFileRef)
+        {
+            char path[LE_FS_PATH_MAX_LEN];
+
+            GetSegmentPath(ReadPosition.segment, path, sizeof(path));
+
+            int32_t offset;
+
+            result = le_fs_Open(path, LE_FS_RDONLY, &ReadFileRef);
+            if (LE_OK == result)
+            {
+                result = le_fs_Seek(ReadFileRef, ReadPosition.offset, LE_FS_SEEK_SET, &offset);
+            }
+
+            if (LE_OK != result)
+            {
+                LE_ERROR("failed to read %s: %s", path, LE_RESULT_TXT(result));
+                CloseFile(&ReadFileRef);
+            }
+        }
+
+        result = (NULL == ReadFileRef) ? LE_FORMAT_ERROR :
+                 ReadRecord(ReadFileRef, &header, bufferPtr);
+
+        if (LE_OK == result)
+        {
+            ReadPosition.offset += sizeof(header) + header.length;
+            UnreadCount--;
+
+            *bufferLengthPtr = header.length;
+            *contentTypePtr = header.contentType;
+            *seqPtr = header.seq;
+            *positionPtr = ReadPosition;
+            return LE_OK;
+        }
+
+        // End of this segment, or rest of this segment unreadable
+        CloseFile(&ReadFileRef);
+
+        if (ReadPosition.segment >= TailSegment)
+        {
+            LE_ERROR("%zu records lost from the push spool", UnreadCount);
+            UnreadCount = 0;
+            break;
+        }
+
+        if (LE_FORMAT_ERROR == result)
+        {
+            LE_WARN("Push spool segment %" PRIu32 " damaged at offset %" PRIu32,
+                    ReadPosition.segment,
+                    ReadPosition.offset);
+        }
+
+        ReadPosition.segment++;
+        ReadPosition.offset = 0;
+    }
+
+    return LE_NOT_FOUND;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the buffers read from the spool up to a position, once they have been pushed
+ */
+//--------------------------------------------------------------------------------------------------
+void pushSpool_Commit
+(
+    pushSpool_Position_t position           ///< [IN] Position returned by pushSpool_Read()
+)
+{
+    uint32_t segment = HeadPosition.segment;
+
+    if ((position.segment < HeadPosition.segment)
+        || ((position.segment == HeadPosition.segment)
+            && (position.offset <= HeadPosition.offset)))
+    {
+        return;
+    }
+
+    if ((0 == UnreadCount)
+        && (position.segment == ReadPosition.segment)
+        && (position.offset == ReadPosition.offset))
+    {
+        // Everything appended has been pushed: drop all the segments, the next record starting a
+        // new one
+        HeadPosition.segment = TailSegment + 1;
+        HeadPosition.offset = 0;
+    }
+    else
+    {
+        HeadPosition = position;
+    }
+
+    UnsavedCount++;
+
+    // The cursor is saved before deleting the segments, so that a restart never looks for records
+    // in a deleted segment
+    if ((segment != HeadPosition.segment) || (UnsavedCount >= PUSH_SPOOL_CURSOR_SYNC_COUNT))
+    {
+        SaveCursor();
+    }
+
+    for (; segment != HeadPosition.segment; segment++)
+    {
+        DeleteSegment(segment);
+    }
+
+    if (HeadPosition.segment > TailSegment)
+    {
+        TailSegment = HeadPosition.segment;
+        TailSize = 0;
+        ReadPosition = HeadPosition;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Returns if there is no buffer left to read in the spool
+ */
+//--------------------------------------------------------------------------------------------------
+bool pushSpool_IsEmpty
+(
+    void
+)
+{
+    return (0 == UnreadCount);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Returns the number of bytes that can still be appended to the spool
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pushSpool_GetFreeBytes
+(
+    void
+)
+{
+    return (MaxBytes > TotalBytes) ? (MaxBytes - TotalBytes) : 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Init the spool, recovering the buffers saved before a restart
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pushSpool_Init
+(
+    void
+)
+{
+    static uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
+    RecordHeader_t header;
+    uint32_t segment;
+
+    // Read the spool size from config tree @ /apps/avcService/pushSpool
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(CFG_PUSH_SPOOL_PATH);
+    int maxBytes = le_cfg_GetInt(iterRef, CFG_PUSH_SPOOL_MAX_SIZE, PUSH_SPOOL_DEFAULT_MAX_BYTES);
+    le_cfg_CancelTxn(iterRef);
+
+    MaxBytes = (maxBytes > 0) ? maxBytes : 0;
+
+    CloseFile(&AppendFileRef);
+    CloseFile(&ReadFileRef);
+
+    HeadPosition.segment = 0;
+    HeadPosition.offset = 0;
+    NextSeq = 0;
+    TotalBytes = 0;
+    UnreadCount = 0;
+    UnsavedCount = 0;
+
+    // Segments can't be found without the cursor: start from scratch
+    if (LE_OK != LoadCursor())
+    {
+        le_fs_RemoveDirRecursive(PUSH_SPOOL_DIR);
+    }
+
+    // Scan the segments following the cursor
+    for (segment = HeadPosition.segment; ; segment++)
+    {
+        char path[LE_FS_PATH_MAX_LEN];
+        le_fs_FileRef_t fileRef;
+        size_t size = 0;
+        le_result_t result;
+
+        GetSegmentPath(segment, path, sizeof(path));
+
+        if ((LE_OK != le_fs_GetSize(path, &size))
+            || (LE_OK != le_fs_Open(path, LE_FS_RDONLY, &fileRef)))
+        {
+            break;
+        }
+
+        TotalBytes += size;
+
+        int32_t offset;
+        result = le_fs_Seek(fileRef,
+                            (segment == HeadPosition.segment) ? HeadPosition.offset : 0,
+                            LE_FS_SEEK_SET,
+                            &offset);
+
+        while ((LE_OK == result) && (LE_OK == (result = ReadRecord(fileRef, &header, buffer))))
+        {
+            UnreadCount++;
+            if ((int32_t)(header.seq + 1 - NextSeq) > 0)
+            {
+                NextSeq = header.seq + 1;
+            }
+        }
+
+        if (LE_FORMAT_ERROR == result)
+        {
+            LE_WARN("Push spool segment %" PRIu32 " is damaged", segment);
+        }
+
+        le_fs_Close(fileRef);
+    }
+
+    // The head segment may have been deleted before the cursor was saved
+    if (segment == HeadPosition.segment)
+    {
+        HeadPosition.offset = 0;
+    }
+
+    // Never append after a record that might be torn
+    TailSegment = segment;
+    TailSize = 0;
+    ReadPosition = HeadPosition;
+
+    // Records appended from now on must be found after a restart
+    SaveCursor();
+
+    LE_INFO("Push spool: %zu records, %zu bytes, limit %zu bytes",
+            UnreadCount,
+            TotalBytes,
+            MaxBytes);
+
+    return LE_OK;
+}
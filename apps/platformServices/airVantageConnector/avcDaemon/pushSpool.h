@@ -0,0 +1,110 @@
+/**
+ * @file pushSpool.h
+ *
+ * Persistent spool of the data waiting to be pushed
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ *
+ */
+
+#ifndef _PUSHSPOOL_H
+#define _PUSHSPOOL_H
+
+#include <lwm2mcore/lwm2mcore.h>
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Position in the spool
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t segment;       ///< Index of the segment file
+    uint32_t offset;        ///< Offset in the segment file
+}
+pushSpool_Position_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a buffer to the spool
+ *
+ * @return
+ *  - LE_OK             The buffer is saved
+ *  - LE_NO_MEMORY      The spool is full, or disabled
+ *  - LE_FAULT          On any other errors
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pushSpool_Append
+(
+    const uint8_t* bufferPtr,               ///< [IN] Buffer, up to MAX_CBOR_BUFFER_NUMBYTES
+    size_t bufferLength,                    ///< [IN] Buffer length
+    lwm2mcore_PushContent_t contentType,    ///< [IN] Content type
+    uint32_t* seqPtr                        ///< [OUT] Sequence number of the buffer
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the next buffer of the spool.  The buffer stays in the spool until pushSpool_Commit() is
+ * called with its position.
+ *
+ * @return
+ *  - LE_OK             The function succeeded
+ *  - LE_NOT_FOUND      No buffer left to read
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pushSpool_Read
+(
+    uint8_t* bufferPtr,                     ///< [OUT] Buffer of MAX_CBOR_BUFFER_NUMBYTES bytes
+    size_t* bufferLengthPtr,                ///< [OUT] Buffer length
+    lwm2mcore_PushContent_t* contentTypePtr,///< [OUT] Content type
+    uint32_t* seqPtr,                       ///< [OUT] Sequence number of the buffer
+    pushSpool_Position_t* positionPtr       ///< [OUT] Position after the buffer
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remove the buffers read from the spool up to a position, once they have been pushed
+ */
+//--------------------------------------------------------------------------------------------------
+void pushSpool_Commit
+(
+    pushSpool_Position_t position           ///< [IN] Position returned by pushSpool_Read()
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Returns if there is no buffer left to read in the spool
+ */
+//--------------------------------------------------------------------------------------------------
+bool pushSpool_IsEmpty
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Returns the number of bytes that can still be appended to the spool
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pushSpool_GetFreeBytes
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Init the spool, recovering the buffers saved before a restart
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pushSpool_Init
+(
+    void
+);
+
+#endif /* _PUSHSPOOL_H */
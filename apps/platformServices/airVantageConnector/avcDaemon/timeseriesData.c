@@ -28,42 +28,80 @@ static le_mem_PoolRef_t RecordDataPoolRef = NULL;
 
 //--------------------------------------------------------------------------------------------------
 /**
-* Timestamp data pool.  Initialized in timeSeries_Init().
+* Resource data pool.  Initialized in timeSeries_Init().
 */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t TimestampDataPoolRef = NULL;
+static le_mem_PoolRef_t ResourceDataPoolRef = NULL;
 
 
 //--------------------------------------------------------------------------------------------------
 /**
-* Resource data pool.  Initialized in timeSeries_Init().
+* Column block pool.  Initialized in timeSeries_Init().
 */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t ResourceDataPoolRef = NULL;
+static le_mem_PoolRef_t ColumnBlockPoolRef = NULL;
 
 
 //--------------------------------------------------------------------------------------------------
 /**
-* Data value pool.  Initialized in timeSeries_Init().
-*/
+ * CBOR buffer memory pool.  Initialized in timeSeries_Init().
+ */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t DataValuePoolRef = NULL;
+static le_mem_PoolRef_t CborBufferPoolRef = NULL;
 
 
 //--------------------------------------------------------------------------------------------------
 /**
-* String value pool.  Initialized in timeSeries_Init().
-*/
+ * Compressed chunk buffer memory pool.  Initialized in timeSeries_Init().
+ */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t StringValuePoolRef = NULL;
+static le_mem_PoolRef_t ChunkBufferPoolRef = NULL;
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * CBOR buffer memory pool.  Initialized in timeSeries_Init().
+ * Push group memory pool.  Initialized in timeSeries_Init().
  */
 //--------------------------------------------------------------------------------------------------
-static le_mem_PoolRef_t CborBufferPoolRef = NULL;
+static le_mem_PoolRef_t PushGroupPoolRef = NULL;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of bytes of CBOR encoded data accumulated in a record.  A record that does not fit
+ * in a single push once compressed is split in several pushes by timeSeries_PushRecord().
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_RECORD_CBOR_NUMBYTES (4 * MAX_CBOR_BUFFER_NUMBYTES)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config tree path and nodes selecting how much CPU is spent compressing the pushed records:
+ *  - compressionPolicy: "cpu" (fastest), "balanced" or "bandwidth" (smallest, default)
+ *  - compressionLevel: zlib level from 0 to 9, overrides the policy
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_TIME_SERIES_PATH        "/apps/avcService/timeSeries"
+#define CFG_COMPRESSION_POLICY      "compressionPolicy"
+#define CFG_COMPRESSION_LEVEL       "compressionLevel"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A chunk compressed to more than this percentage of its CBOR size is mostly incompressible data.
+ * The remaining chunks of the record are then compressed with Z_BEST_SPEED.
+ */
+//--------------------------------------------------------------------------------------------------
+#define POOR_COMPRESSION_PERCENT 90
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * zlib compression level of the pushed records.  Read from the config tree in timeSeries_Init().
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompressionLevel = Z_BEST_COMPRESSION;
 
 
 //--------------------------------------------------------------------------------------------------
@@ -82,6 +120,137 @@ typedef enum
 DataType_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of bytes of packed samples held by each block of a column.  Small blocks keep the memory
+ * of sparse resources low, while the link overhead stays under 10% of the block.
+ */
+//--------------------------------------------------------------------------------------------------
+#define COLUMN_BLOCK_BYTES 120
+#define COLUMN_BLOCK_BITS  (COLUMN_BLOCK_BYTES * 8)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Block of a column
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sls_Link_t link;                     ///< For adding to the block list of the column
+    uint8_t bytes[COLUMN_BLOCK_BYTES];      ///< Packed bits, most significant bit first
+}
+ColumnBlock_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Stream of packed bits, stored in blocks from the column block pool
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sls_List_t blockList;                ///< Blocks of the column
+    size_t bitCount;                        ///< Number of bits written
+}
+Column_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Position of a reader in a column
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Column_t* columnPtr;                    ///< Column being read
+    le_sls_Link_t* blockLinkPtr;            ///< Block of the next bit, NULL before the first one
+    size_t blockBitPos;                     ///< Position of the next bit in the block
+    size_t bitPos;                          ///< Position of the next bit in the column
+}
+ColumnReader_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Sorted unique timestamps of a record.  The first timestamp is stored as is and the next ones as
+* the difference between their delta and the previous delta, which is zero for periodic samples.
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Column_t column;                        ///< Packed timestamps
+    size_t count;                           ///< Number of timestamps
+    uint64_t lastTimestamp;                 ///< Last timestamp written or read
+    int64_t lastDelta;                      ///< Last delta written or read
+}
+TimestampColumn_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Reader of the timestamps of a record
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    ColumnReader_t reader;                  ///< Position in the timestamp column
+    size_t count;                           ///< Number of timestamps read
+    uint64_t lastTimestamp;                 ///< Last timestamp read
+    int64_t lastDelta;                      ///< Last delta read
+}
+TimestampReader_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* State shared by the packing and unpacking of consecutive values
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint64_t lastBits;                      ///< Last int value, or bits of the last float value
+    int leadingZeros;                       ///< Leading zeros of the float XOR window, -1 if none
+    int trailingZeros;                      ///< Trailing zeros of the float XOR window
+}
+ValueCodec_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Values of a resource.  A presence bit per timestamp of the record tells whether the resource has a
+* value with this timestamp, missing trailing bits meaning no value.  Values are packed by type:
+*  - int: zigzag encoded delta to the previous value
+*  - float: XOR with the previous value, keeping only the bits between the leading and trailing
+*    zeros (identical consecutive values take a single bit)
+*  - bool: one bit
+*  - string: the bytes up to and including the terminating null
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    Column_t presence;                      ///< One bit per timestamp of the record
+    Column_t values;                        ///< Packed values
+    size_t count;                           ///< Number of values
+    ValueCodec_t codec;                     ///< State of the packing
+}
+ValueColumn_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Reader of the values of a resource
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    ColumnReader_t presence;                ///< Position in the presence bits
+    ColumnReader_t values;                  ///< Position in the packed values
+    ValueCodec_t codec;                     ///< State of the unpacking
+}
+ValueReader_t;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
 * Data contained in time series
@@ -89,7 +258,7 @@ DataType_t;
 //--------------------------------------------------------------------------------------------------
 typedef struct le_avdata_Record
 {
-    le_dls_List_t timestampList;    ///< List of timestamps for this record
+    TimestampColumn_t timestamps;   ///< Timestamps for this record
     le_dls_List_t resourceList;     ///< List of resources for this record
 
     uint8_t* bufferPtr;             ///< Buffer for accumulating history data.
@@ -109,15 +278,30 @@ RecordData_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
-* Unique timestamps values accumulated
+* Compressed part of a record, ready to be pushed
+*/
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t* bufferPtr;                     ///< Compressed data, from the chunk buffer pool
+    size_t bufferLength;                    ///< Length of compressed data
+}
+Chunk_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+* Record pushed in several chunks.  The client handler is called once all chunks are acknowledged.
 */
 //--------------------------------------------------------------------------------------------------
 typedef struct
 {
-    uint64_t timestamp;                     ///< The timestamp
-    le_dls_Link_t link;                     ///< For adding to the timestamp list
+    le_avdata_CallbackResultFunc_t handlerPtr;  ///< Client handler
+    void* contextPtr;                           ///< Client context
+    size_t pendingCount;                        ///< Number of chunks not acknowledged yet
+    le_avdata_PushStatus_t status;              ///< Failed if any chunk failed
 }
-TimestampData_t;
+PushGroup_t;
 
 
 //--------------------------------------------------------------------------------------------------
@@ -129,7 +313,8 @@ typedef struct
 {
     char name[LE_AVDATA_PATH_NAME_BYTES];   ///< The name of the resource
     DataType_t type;                       ///< The type of the resource
-    le_dls_List_t dataList;                 ///< List of data accumulated over time
+    ValueColumn_t column;                   ///< Data accumulated over time
+    ValueReader_t reader;                   ///< Next data to encode
     double factor;                          ///< Factor of data
     int32_t lastIntValue;                   ///< Last recorded int value
     double lastFloatValue;                  ///< Last recorded float value
@@ -143,415 +328,996 @@ ResourceData_t;
  * Supported data types
  */
 //--------------------------------------------------------------------------------------------------
-typedef struct
+typedef union
 {
-    uint64_t timestamp;
-    union
-    {
-        int intValue;
-        double floatValue;
-        bool boolValue;
-        char* strValuePtr;
-    };
-    le_dls_Link_t link;
+    int intValue;
+    double floatValue;
+    bool boolValue;
+    char* strValuePtr;
 }
 Data_t;
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the number of unique timestamps in a timeseries record
+ * Release all the blocks of a column
  */
 //--------------------------------------------------------------------------------------------------
-size_t GetTimestampCount
+static void ClearColumn
 (
-    timeSeries_RecordRef_t recRef
+    Column_t* columnPtr
 )
 {
-    return le_dls_NumLinks(&recRef->timestampList);
+    le_sls_Link_t* linkPtr = le_sls_Pop(&columnPtr->blockList);
+
+    while ( linkPtr != NULL )
+    {
+        le_mem_Release(CONTAINER_OF(linkPtr, ColumnBlock_t, link));
+        linkPtr = le_sls_Pop(&columnPtr->blockList);
+    }
+
+    columnPtr->bitCount = 0;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the number of resources in a timeseries record
+ * Append bits to a column, most significant bit first
  */
 //--------------------------------------------------------------------------------------------------
-size_t GetResourceCount
+static void WriteBits
 (
-    timeSeries_RecordRef_t recRef
+    Column_t* columnPtr,
+    uint64_t value,
+    int bitCount                        ///< Number of low bits of value to write, up to 64
 )
 {
-    return le_dls_NumLinks(&recRef->resourceList);
+    while (bitCount > 0)
+    {
+        size_t offset = columnPtr->bitCount % COLUMN_BLOCK_BITS;
+
+        if (0 == offset)
+        {
+            ColumnBlock_t* newBlockPtr = le_mem_ForceAlloc(ColumnBlockPoolRef);
+            memset(newBlockPtr->bytes, 0, sizeof(newBlockPtr->bytes));
+            newBlockPtr->link = LE_SLS_LINK_INIT;
+            le_sls_Queue(&columnPtr->blockList, &newBlockPtr->link);
+        }
+
+        ColumnBlock_t* blockPtr = CONTAINER_OF(le_sls_PeekTail(&columnPtr->blockList),
+                                               ColumnBlock_t,
+                                               link);
+        int freeBits = 8 - (offset % 8);
+        int writeCount = (bitCount < freeBits) ? bitCount : freeBits;
+        uint8_t bits = (value >> (bitCount - writeCount)) & ((1 << writeCount) - 1);
+
+        blockPtr->bytes[offset / 8] |= bits << (freeBits - writeCount);
+        columnPtr->bitCount += writeCount;
+        bitCount -= writeCount;
+    }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the specified timestamp
- *
- * @return:
- *      - LE_OK on success
- *      - LE_NOT_FOUND if resource does not exist
+ * Start reading a column from its first bit
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t GetTimestamp
+static void InitColumnReader
 (
-    timeSeries_RecordRef_t recRef,
-    uint64_t timestamp,
-    TimestampData_t** timestampPtrPtr
+    ColumnReader_t* readerPtr,
+    Column_t* columnPtr
 )
 {
-    if (!le_dls_IsEmpty(&recRef->timestampList))
-    {
-        le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->timestampList);
-        TimestampData_t* timestampPtr;
-
-        // Loop through the resources
-        while ( linkPtr != NULL )
-        {
-            timestampPtr = CONTAINER_OF(linkPtr, TimestampData_t, link);
-
-            // if resource already exists but we are trying to accumulate value of a different type
-            if (timestampPtr->timestamp == timestamp)
-            {
-                *timestampPtrPtr = timestampPtr;
-                return LE_OK;
-            }
-
-            linkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
-        }
-    }
-
-    return LE_NOT_FOUND;
+    readerPtr->columnPtr = columnPtr;
+    readerPtr->blockLinkPtr = NULL;
+    readerPtr->blockBitPos = COLUMN_BLOCK_BITS;
+    readerPtr->bitPos = 0;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get data with the corresponding timestamp
+ * Read bits from a column.  The caller must not read past the bits written.
  *
- * @return:
- *      - NULL if data does not exist with the corresponding timestamp
+ * @return the bits read, the first one being the most significant
  */
 //--------------------------------------------------------------------------------------------------
-static Data_t* GetTimestampData
+static uint64_t ReadBits
 (
-    ResourceData_t* resourceDataPtr,
-    uint64_t timestamp
+    ColumnReader_t* readerPtr,
+    int bitCount                        ///< Number of bits to read, up to 64
 )
 {
-    le_dls_Link_t* linkPtr = le_dls_Peek(&resourceDataPtr->dataList);
-    Data_t* dataPtr;
+    uint64_t value = 0;
 
-    // Loop through all the data
-    while ( linkPtr != NULL )
+    while (bitCount > 0)
     {
-        dataPtr = CONTAINER_OF(linkPtr, Data_t, link);
-
-        if (dataPtr->timestamp == timestamp)
+        if (COLUMN_BLOCK_BITS == readerPtr->blockBitPos)
         {
-            return dataPtr;
+            readerPtr->blockLinkPtr = (readerPtr->blockLinkPtr == NULL) ?
+                le_sls_Peek(&readerPtr->columnPtr->blockList) :
+                le_sls_PeekNext(&readerPtr->columnPtr->blockList, readerPtr->blockLinkPtr);
+            readerPtr->blockBitPos = 0;
         }
 
-        linkPtr = le_dls_PeekNext(&resourceDataPtr->dataList, linkPtr);
+        ColumnBlock_t* blockPtr = CONTAINER_OF(readerPtr->blockLinkPtr, ColumnBlock_t, link);
+        size_t offset = readerPtr->blockBitPos;
+        int availableBits = 8 - (offset & 7);
+        int readCount = (bitCount < availableBits) ? bitCount : availableBits;
+        uint8_t bits = (blockPtr->bytes[offset >> 3] >> (availableBits - readCount))
+                       & ((1 << readCount) - 1);
+
+        value = (value << readCount) | bits;
+        readerPtr->blockBitPos += readCount;
+        readerPtr->bitPos += readCount;
+        bitCount -= readCount;
     }
 
-    return NULL;
+    return value;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the number of resources collected with a specific timestamp
+ * Copy bits from a column being read to the end of another one
  */
 //--------------------------------------------------------------------------------------------------
-size_t GetResourceDataTimestampCount
+static void CopyBits
 (
-    timeSeries_RecordRef_t recRef,
-    uint64_t timestamp
+    ColumnReader_t* readerPtr,
+    Column_t* columnPtr,
+    size_t bitCount
 )
 {
-    int rdCount = 0;
-
-    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->resourceList);
-    ResourceData_t* resourceDataPtr;
-
-    while ( linkPtr != NULL )
+    while (bitCount > 0)
     {
-        resourceDataPtr = CONTAINER_OF(linkPtr, ResourceData_t, link);
-        if (GetTimestampData(resourceDataPtr, timestamp) != NULL)
-        {
-            rdCount++;
-        }
+        int copyCount = (bitCount < 64) ? bitCount : 64;
 
-        linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
+        WriteBits(columnPtr, ReadBits(readerPtr, copyCount), copyCount);
+        bitCount -= copyCount;
     }
-
-    return rdCount;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add timestamp into sorted timestamp list
+ * Read a single bit of a column
+ *
+ * @return true if the bit is set, false if it is not set or past the end of the column
  */
 //--------------------------------------------------------------------------------------------------
-static void AddTimestamp
+static bool IsBitSet
 (
-    timeSeries_RecordRef_t recRef,
-    uint64_t timestamp
+    Column_t* columnPtr,
+    size_t bitPos
 )
 {
-    TimestampData_t* timestampPtr;
-    le_result_t result;
-
-    result = GetTimestamp(recRef, timestamp, &timestampPtr);
+    le_sls_Link_t* linkPtr = le_sls_Peek(&columnPtr->blockList);
+    size_t blockIndex;
 
-    // allocate memory for this timestamp and add to timestamplist
-    if (result == LE_NOT_FOUND)
+    if (bitPos >= columnPtr->bitCount)
     {
-        timestampPtr = le_mem_ForceAlloc(TimestampDataPoolRef);
-        timestampPtr->timestamp = timestamp;
-        timestampPtr->link = LE_DLS_LINK_INIT;
-
-        if (le_dls_IsEmpty(&recRef->timestampList))
-        {
-            le_dls_Queue(&recRef->timestampList, &timestampPtr->link);
-        }
-        else
-        {
-            le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->timestampList);
-            le_dls_Link_t* nextLinkPtr = NULL;
-
-            while (linkPtr != NULL)
-            {
-                nextLinkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
+        return false;
+    }
 
-                if (nextLinkPtr != NULL)
-                {
-                    TimestampData_t* nextTimestampPtr;
-                    nextTimestampPtr = CONTAINER_OF(nextLinkPtr, TimestampData_t, link);
+    for (blockIndex = bitPos / COLUMN_BLOCK_BITS; blockIndex > 0; blockIndex--)
+    {
+        linkPtr = le_sls_PeekNext(&columnPtr->blockList, linkPtr);
+    }
 
-                    // add value before next timestamp
-                    if (timestamp < nextTimestampPtr->timestamp)
-                    {
-                        le_dls_AddBefore(&recRef->timestampList, nextLinkPtr, &timestampPtr->link);
-                        break;
-                    }
+    size_t offset = bitPos % COLUMN_BLOCK_BITS;
 
-                    linkPtr = le_dls_PeekNext(&recRef->timestampList, linkPtr);
-                }
-                else
-                {
-                    // queue timestamp if there's not next value to compare to
-                    le_dls_Queue(&recRef->timestampList, &timestampPtr->link);
-                    break;
-                }
-            }
-        }
-    }
+    return (CONTAINER_OF(linkPtr, ColumnBlock_t, link)->bytes[offset / 8] >> (7 - offset % 8)) & 1;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Clear all the timestamps of a record
+ * Map signed values to unsigned ones, small magnitudes giving small values
  */
 //--------------------------------------------------------------------------------------------------
-static void ClearTimestamp
+static uint64_t ZigZagEncode
 (
-    timeSeries_RecordRef_t recRef
+    int64_t value
 )
 {
-    le_dls_Link_t* linkPtr = le_dls_Pop(&recRef->timestampList);
-    TimestampData_t* timestampPtr;
-
-    // Go through each resource, delete the data and remove
-    while ( linkPtr != NULL )
-    {
-        timestampPtr = CONTAINER_OF(linkPtr, TimestampData_t, link);
-        le_mem_Release(timestampPtr);
-        linkPtr = le_dls_Pop(&recRef->timestampList);
-    }
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Clear all the resources of a record
+ * Reverse of ZigZagEncode()
  */
 //--------------------------------------------------------------------------------------------------
-static void ClearResources
+static int64_t ZigZagDecode
 (
-    timeSeries_RecordRef_t recRef
+    uint64_t value
 )
 {
-    le_dls_Link_t* resourcelinkPtr = le_dls_Pop(&recRef->resourceList);
-    ResourceData_t* resourceDataPtr;
-
-    // Go through each resource, delete the data and remove
-    while ( resourcelinkPtr != NULL )
-    {
-        resourceDataPtr = CONTAINER_OF(resourcelinkPtr, ResourceData_t, link);
-
-        le_dls_Link_t* datalinkPtr = le_dls_Pop(&resourceDataPtr->dataList);
-        Data_t* dataPtr;
-
-        // Loop through all the data
-        while ( datalinkPtr != NULL )
-        {
-            dataPtr = CONTAINER_OF(datalinkPtr, Data_t, link);
-
-            if (resourceDataPtr->type == DATA_TYPE_STRING)
-            {
-                le_mem_Release(dataPtr->strValuePtr);
-            }
-
-            le_mem_Release(dataPtr);
-            datalinkPtr = le_dls_Pop(&resourceDataPtr->dataList);
-        }
-
-        le_mem_Release(resourceDataPtr);
-        resourcelinkPtr = le_dls_Pop(&recRef->resourceList);
-    }
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Reset the last valid value stored
+ * Append an unsigned value with a prefix giving its size: '0' for zero, '10', '110' and '1110'
+ * followed by 7, 12 and 20 bits, or '1111' followed by 64 bits.
  */
 //--------------------------------------------------------------------------------------------------
-static void ResetResourceLastValue
+static void WriteVarBits
 (
-    timeSeries_RecordRef_t recRef
+    Column_t* columnPtr,
+    uint64_t value
 )
 {
-    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->resourceList);
-    ResourceData_t* resourceDataPtr;
-
-    while ( linkPtr != NULL )
+    if (0 == value)
     {
-        resourceDataPtr = CONTAINER_OF(linkPtr, ResourceData_t, link);
-        resourceDataPtr->lastIntValue = 0;
-        resourceDataPtr->lastFloatValue = 0;
-        linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
+        WriteBits(columnPtr, 0x0, 1);
+    }
+    else if (value < (1 << 7))
+    {
+        WriteBits(columnPtr, 0x2, 2);
+        WriteBits(columnPtr, value, 7);
+    }
+    else if (value < (1 << 12))
+    {
+        WriteBits(columnPtr, 0x6, 3);
+        WriteBits(columnPtr, value, 12);
+    }
+    else if (value < (1 << 20))
+    {
+        WriteBits(columnPtr, 0xE, 4);
+        WriteBits(columnPtr, value, 20);
+    }
+    else
+    {
+        WriteBits(columnPtr, 0xF, 4);
+        WriteBits(columnPtr, value, 64);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Delete a specified timestamp
+ * Read a value written by WriteVarBits()
  */
 //--------------------------------------------------------------------------------------------------
-static void DeleteTimestamp
+static uint64_t ReadVarBits
 (
-    timeSeries_RecordRef_t recRef,
+    ColumnReader_t* readerPtr
+)
+{
+    static const int valueBits[] = { 7, 12, 20, 64 };
+    int prefixCount = 0;
+
+    while ((prefixCount < 4) && ReadBits(readerPtr, 1))
+    {
+        prefixCount++;
+    }
+
+    if (0 == prefixCount)
+    {
+        return 0;
+    }
+
+    return ReadBits(readerPtr, valueBits[prefixCount - 1]);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize an empty timestamp column
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitTimestampColumn
+(
+    TimestampColumn_t* columnPtr
+)
+{
+    columnPtr->column.blockList = LE_SLS_LIST_INIT;
+    columnPtr->column.bitCount = 0;
+    columnPtr->count = 0;
+    columnPtr->lastTimestamp = 0;
+    columnPtr->lastDelta = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a timestamp, later than the last one, to a timestamp column
+ */
+//--------------------------------------------------------------------------------------------------
+static void AppendTimestamp
+(
+    TimestampColumn_t* columnPtr,
     uint64_t timestamp
 )
 {
-    LE_DEBUG("Deleting timestamp: %" PRIu64, timestamp);
-    TimestampData_t* timestampPtr;
-    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->timestampList);
+    if (0 == columnPtr->count)
+    {
+        WriteBits(&columnPtr->column, timestamp, 64);
+        columnPtr->lastDelta = 0;
+    }
+    else
+    {
+        int64_t delta = timestamp - columnPtr->lastTimestamp;
+
+        WriteVarBits(&columnPtr->column, ZigZagEncode(delta - columnPtr->lastDelta));
+        columnPtr->lastDelta = delta;
+    }
+
+    columnPtr->lastTimestamp = timestamp;
+    columnPtr->count++;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start reading the timestamps of a record from the first one
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitTimestampReader
+(
+    TimestampReader_t* readerPtr,
+    TimestampColumn_t* columnPtr
+)
+{
+    InitColumnReader(&readerPtr->reader, &columnPtr->column);
+    readerPtr->count = 0;
+    readerPtr->lastTimestamp = 0;
+    readerPtr->lastDelta = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the next timestamp of a record.  The caller must not read past the last timestamp.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint64_t ReadTimestamp
+(
+    TimestampReader_t* readerPtr
+)
+{
+    if (0 == readerPtr->count)
+    {
+        readerPtr->lastTimestamp = ReadBits(&readerPtr->reader, 64);
+        readerPtr->lastDelta = 0;
+    }
+    else
+    {
+        readerPtr->lastDelta += ZigZagDecode(ReadVarBits(&readerPtr->reader));
+        readerPtr->lastTimestamp += readerPtr->lastDelta;
+    }
+
+    readerPtr->count++;
+
+    return readerPtr->lastTimestamp;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reset the state of the packing of values
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetValueCodec
+(
+    ValueCodec_t* codecPtr
+)
+{
+    codecPtr->lastBits = 0;
+    codecPtr->leadingZeros = -1;
+    codecPtr->trailingZeros = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pack a value relative to the previous one
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteValue
+(
+    Column_t* columnPtr,
+    ValueCodec_t* codecPtr,
+    DataType_t type,
+    const Data_t* valuePtr
+)
+{
+    uint64_t bits;
+    uint64_t xorBits;
+    const char* charPtr;
+
+    switch (type)
+    {
+        case DATA_TYPE_INT:
+            WriteVarBits(columnPtr,
+                         ZigZagEncode((int64_t)valuePtr->intValue - (int64_t)codecPtr->lastBits));
+            codecPtr->lastBits = (uint64_t)(int64_t)valuePtr->intValue;
+            break;
+
+        case DATA_TYPE_FLOAT:
+            memcpy(&bits, &valuePtr->floatValue, sizeof(bits));
+            xorBits = bits ^ codecPtr->lastBits;
+            codecPtr->lastBits = bits;
+
+            if (0 == xorBits)
+            {
+                WriteBits(columnPtr, 0x0, 1);
+            }
+            else
+            {
+                // The leading zero count is written on 5 bits
+                int leadingZeros = __builtin_clzll(xorBits);
+                int trailingZeros = __builtin_ctzll(xorBits);
+
+                if (leadingZeros > 31)
+                {
+                    leadingZeros = 31;
+                }
+
+                if ((codecPtr->leadingZeros >= 0)
+                    && (leadingZeros >= codecPtr->leadingZeros)
+                    && (trailingZeros >= codecPtr->trailingZeros))
+                {
+                    // Meaningful bits fit in the window of the previous value
+                    WriteBits(columnPtr, 0x2, 2);
+                    WriteBits(columnPtr,
+                              xorBits >> codecPtr->trailingZeros,
+                              64 - codecPtr->leadingZeros - codecPtr->trailingZeros);
+                }
+                else
+                {
+                    int meaningfulBits = 64 - leadingZeros - trailingZeros;
+
+                    WriteBits(columnPtr, 0x3, 2);
+                    WriteBits(columnPtr, leadingZeros, 5);
+                    WriteBits(columnPtr, meaningfulBits - 1, 6);
+                    WriteBits(columnPtr, xorBits >> trailingZeros, meaningfulBits);
+                    codecPtr->leadingZeros = leadingZeros;
+                    codecPtr->trailingZeros = trailingZeros;
+                }
+            }
+            break;
+
+        case DATA_TYPE_BOOL:
+            WriteBits(columnPtr, valuePtr->boolValue ? 1 : 0, 1);
+            break;
+
+        case DATA_TYPE_STRING:
+            charPtr = valuePtr->strValuePtr;
+            do
+            {
+                WriteBits(columnPtr, (uint8_t)*charPtr, 8);
+            }
+            while (*charPtr++ != '\0');
+            break;
+
+        default:
+            LE_INFO("Invalid type");
+            break;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unpack a value written by WriteValue()
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReadValue
+(
+    ColumnReader_t* readerPtr,
+    ValueCodec_t* codecPtr,
+    DataType_t type,
+    Data_t* valuePtr,                   ///< [OUT] Value read
+    char* stringPtr                     ///< [OUT] Buffer of LE_AVDATA_STRING_VALUE_BYTES bytes
+                                        ///  for string values
+)
+{
+    uint64_t xorBits;
+    size_t i;
+
+    switch (type)
+    {
+        case DATA_TYPE_INT:
+            codecPtr->lastBits += ZigZagDecode(ReadVarBits(readerPtr));
+            valuePtr->intValue = (int)(int64_t)codecPtr->lastBits;
+            break;
+
+        case DATA_TYPE_FLOAT:
+            if (0 == ReadBits(readerPtr, 1))
+            {
+                xorBits = 0;
+            }
+            else if (0 == ReadBits(readerPtr, 1))
+            {
+                xorBits = ReadBits(readerPtr,
+                                   64 - codecPtr->leadingZeros - codecPtr->trailingZeros)
+                          << codecPtr->trailingZeros;
+            }
+            else
+            {
+                int leadingZeros = ReadBits(readerPtr, 5);
+                int meaningfulBits = ReadBits(readerPtr, 6) + 1;
+
+                codecPtr->leadingZeros = leadingZeros;
+                codecPtr->trailingZeros = 64 - leadingZeros - meaningfulBits;
+                xorBits = ReadBits(readerPtr, meaningfulBits) << codecPtr->trailingZeros;
+            }
+
+            codecPtr->lastBits ^= xorBits;
+            memcpy(&valuePtr->floatValue, &codecPtr->lastBits, sizeof(valuePtr->floatValue));
+            break;
+
+        case DATA_TYPE_BOOL:
+            valuePtr->boolValue = (ReadBits(readerPtr, 1) != 0);
+            break;
+
+        case DATA_TYPE_STRING:
+            // Strings are truncated to LE_AVDATA_STRING_VALUE_BYTES when added
+            for (i = 0; i < LE_AVDATA_STRING_VALUE_BYTES; i++)
+            {
+                stringPtr[i] = ReadBits(readerPtr, 8);
+                if (stringPtr[i] == '\0')
+                {
+                    break;
+                }
+            }
+            valuePtr->strValuePtr = stringPtr;
+            break;
+
+        default:
+            LE_INFO("Invalid type");
+            break;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize an empty value column
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitValueColumn
+(
+    ValueColumn_t* columnPtr
+)
+{
+    columnPtr->presence.blockList = LE_SLS_LIST_INIT;
+    columnPtr->presence.bitCount = 0;
+    columnPtr->values.blockList = LE_SLS_LIST_INIT;
+    columnPtr->values.bitCount = 0;
+    columnPtr->count = 0;
+    ResetValueCodec(&columnPtr->codec);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release all the values of a value column
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearValueColumn
+(
+    ValueColumn_t* columnPtr
+)
+{
+    ClearColumn(&columnPtr->presence);
+    ClearColumn(&columnPtr->values);
+    InitValueColumn(columnPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Append a value to a value column.  The value must be at or after the last presence bit.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AppendValue
+(
+    ValueColumn_t* columnPtr,
+    size_t row,                         ///< Index of the timestamp of the value in the record
+    DataType_t type,
+    const Data_t* valuePtr
+)
+{
+    size_t missingCount = row - columnPtr->presence.bitCount;
+
+    // The resource has no value with the timestamps since its last value
+    while (missingCount > 0)
+    {
+        int writeCount = (missingCount < 64) ? missingCount : 64;
+
+        WriteBits(&columnPtr->presence, 0, writeCount);
+        missingCount -= writeCount;
+    }
+
+    WriteBits(&columnPtr->presence, 1, 1);
+    WriteValue(&columnPtr->values, &columnPtr->codec, type, valuePtr);
+    columnPtr->count++;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start reading the values of a resource from the first timestamp of the record
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitValueReader
+(
+    ValueReader_t* readerPtr,
+    ValueColumn_t* columnPtr
+)
+{
+    InitColumnReader(&readerPtr->presence, &columnPtr->presence);
+    InitColumnReader(&readerPtr->values, &columnPtr->values);
+    ResetValueCodec(&readerPtr->codec);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the value of a resource with the next timestamp of the record
+ *
+ * @return true if the resource has a value with this timestamp
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ReadNextValue
+(
+    ValueReader_t* readerPtr,
+    DataType_t type,
+    Data_t* valuePtr,                   ///< [OUT] Value read
+    char* stringPtr                     ///< [OUT] Buffer of LE_AVDATA_STRING_VALUE_BYTES bytes
+                                        ///  for string values
+)
+{
+    if ((readerPtr->presence.bitPos >= readerPtr->presence.columnPtr->bitCount)
+        || (0 == ReadBits(&readerPtr->presence, 1)))
+    {
+        return false;
+    }
+
+    ReadValue(&readerPtr->values, &readerPtr->codec, type, valuePtr, stringPtr);
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of unique timestamps in a timeseries record
+ */
+//--------------------------------------------------------------------------------------------------
+size_t GetTimestampCount
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    return recRef->timestamps.count;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the number of resources in a timeseries record
+ */
+//--------------------------------------------------------------------------------------------------
+size_t GetResourceCount
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    return le_dls_NumLinks(&recRef->resourceList);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Find a timestamp in a record
+ *
+ * @return the index of the timestamp, or of the first later timestamp if it is not found
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t FindTimestamp
+(
+    timeSeries_RecordRef_t recRef,
+    uint64_t timestamp,
+    bool* isFoundPtr                    ///< [OUT] Whether the timestamp is in the record
+)
+{
+    TimestampReader_t reader;
+    size_t row;
+
+    *isFoundPtr = false;
+
+    // Timestamps are usually recorded in order
+    if ((0 == recRef->timestamps.count) || (timestamp > recRef->timestamps.lastTimestamp))
+    {
+        return recRef->timestamps.count;
+    }
+
+    if (timestamp == recRef->timestamps.lastTimestamp)
+    {
+        *isFoundPtr = true;
+        return recRef->timestamps.count - 1;
+    }
+
+    InitTimestampReader(&reader, &recRef->timestamps);
+
+    for (row = 0; row < recRef->timestamps.count; row++)
+    {
+        uint64_t rowTimestamp = ReadTimestamp(&reader);
+
+        if (rowTimestamp >= timestamp)
+        {
+            *isFoundPtr = (rowTimestamp == timestamp);
+            break;
+        }
+    }
+
+    return row;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Insert or remove the presence bit of a timestamp in the values of a resource
+ */
+//--------------------------------------------------------------------------------------------------
+static void ShiftPresence
+(
+    ValueColumn_t* columnPtr,
+    size_t row,                         ///< Index of the timestamp
+    bool isInsert                       ///< Insert a cleared bit if true, remove the bit if false
+)
+{
+    Column_t newPresence = { LE_SLS_LIST_INIT, 0 };
+    ColumnReader_t reader;
+
+    if (row >= columnPtr->presence.bitCount)
+    {
+        return;
+    }
+
+    InitColumnReader(&reader, &columnPtr->presence);
+    CopyBits(&reader, &newPresence, row);
+
+    if (isInsert)
+    {
+        WriteBits(&newPresence, 0, 1);
+    }
+    else
+    {
+        ReadBits(&reader, 1);
+    }
+
+    CopyBits(&reader, &newPresence, columnPtr->presence.bitCount - reader.bitPos);
+
+    ClearColumn(&columnPtr->presence);
+    columnPtr->presence = newPresence;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rewrite the timestamps of a record with a timestamp inserted or removed, and shift the presence
+ * bits of the resources accordingly.  Timestamps cannot be modified in place since each one is
+ * packed relative to the previous ones.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RewriteTimestamps
+(
+    timeSeries_RecordRef_t recRef,
+    size_t row,                         ///< Index of the timestamp to insert or remove
+    const uint64_t* timestampPtr        ///< Timestamp to insert, or NULL to remove
+)
+{
+    TimestampColumn_t newColumn;
+    TimestampReader_t reader;
+    size_t i;
+
+    InitTimestampColumn(&newColumn);
+    InitTimestampReader(&reader, &recRef->timestamps);
+
+    for (i = 0; i < recRef->timestamps.count; i++)
+    {
+        uint64_t timestamp = ReadTimestamp(&reader);
+
+        if (i == row)
+        {
+            if (timestampPtr == NULL)
+            {
+                continue;
+            }
+            AppendTimestamp(&newColumn, *timestampPtr);
+        }
+
+        AppendTimestamp(&newColumn, timestamp);
+    }
+
+    if ((row >= recRef->timestamps.count) && (timestampPtr != NULL))
+    {
+        AppendTimestamp(&newColumn, *timestampPtr);
+    }
+
+    ClearColumn(&recRef->timestamps.column);
+    recRef->timestamps = newColumn;
+
+    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->resourceList);
+
+    while ( linkPtr != NULL )
+    {
+        ShiftPresence(&CONTAINER_OF(linkPtr, ResourceData_t, link)->column,
+                      row,
+                      (timestampPtr != NULL));
+        linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Rewrite the values of a resource with the value of a timestamp replaced or removed.  Values cannot
+ * be modified in place since each one is packed relative to the previous ones.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RewriteValues
+(
+    ResourceData_t* resourceDataPtr,
+    size_t row,                         ///< Index of the timestamp of the value
+    const Data_t* valuePtr              ///< New value, or NULL to remove the value
+)
+{
+    ValueColumn_t newColumn;
+    ValueReader_t reader;
+    Data_t value;
+    char stringValue[LE_AVDATA_STRING_VALUE_BYTES];
+    size_t i;
+
+    InitValueColumn(&newColumn);
+    InitValueReader(&reader, &resourceDataPtr->column);
+
+    for (i = 0; i < resourceDataPtr->column.presence.bitCount; i++)
+    {
+        bool isPresent = ReadNextValue(&reader, resourceDataPtr->type, &value, stringValue);
+
+        if (i == row)
+        {
+            if (valuePtr != NULL)
+            {
+                AppendValue(&newColumn, i, resourceDataPtr->type, valuePtr);
+            }
+        }
+        else if (isPresent)
+        {
+            AppendValue(&newColumn, i, resourceDataPtr->type, &value);
+        }
+    }
+
+    if ((row >= resourceDataPtr->column.presence.bitCount) && (valuePtr != NULL))
+    {
+        AppendValue(&newColumn, row, resourceDataPtr->type, valuePtr);
+    }
+
+    ClearValueColumn(&resourceDataPtr->column);
+    resourceDataPtr->column = newColumn;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Clear all the timestamps of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearTimestamp
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    ClearColumn(&recRef->timestamps.column);
+    InitTimestampColumn(&recRef->timestamps);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Clear all the resources of a record
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearResources
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    le_dls_Link_t* resourcelinkPtr = le_dls_Pop(&recRef->resourceList);
+    ResourceData_t* resourceDataPtr;
 
-    while ( linkPtr != NULL )
+    // Go through each resource, delete the data and remove
+    while ( resourcelinkPtr != NULL )
     {
-        timestampPtr = CONTAINER_OF(linkPtr, TimestampData_t, link);
-
-        if (timestampPtr->timestamp == timestamp)
-        {
-            le_mem_Release(timestampPtr);
-            le_dls_Remove(&recRef->timestampList, linkPtr);
-            linkPtr = NULL;
-        }
-        else
-        {
-            linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
-        }
+        resourceDataPtr = CONTAINER_OF(resourcelinkPtr, ResourceData_t, link);
+        ClearValueColumn(&resourceDataPtr->column);
+        le_mem_Release(resourceDataPtr);
+        resourcelinkPtr = le_dls_Pop(&recRef->resourceList);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Delete a resource data
-  * If no other data exists for this specific resource, resource will also be deleted.
+ * Reset the last valid value stored
  */
 //--------------------------------------------------------------------------------------------------
-static void DeleteResourceData
+static void ResetResourceLastValue
 (
-    timeSeries_RecordRef_t recRef,
-    const char* path,
-    uint64_t timestamp
+    timeSeries_RecordRef_t recRef
 )
 {
     le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->resourceList);
     ResourceData_t* resourceDataPtr;
 
-    // Go through each resource until you find this one and remove
     while ( linkPtr != NULL )
     {
         resourceDataPtr = CONTAINER_OF(linkPtr, ResourceData_t, link);
-
-        if (0 == strcmp(path, resourceDataPtr->name))
-        {
-            Data_t* dataPtr = (Data_t*)GetTimestampData(resourceDataPtr, timestamp);
-
-            // Delete this specific resource
-            if (dataPtr != NULL)
-            {
-                LE_DEBUG("Deleting this resource data");
-                // if string we need to deallocate memory for string as well
-                if (resourceDataPtr->type == DATA_TYPE_STRING)
-                {
-                    le_mem_Release(dataPtr->strValuePtr);
-                }
-
-                le_mem_Release(dataPtr);
-                le_dls_Remove(&resourceDataPtr->dataList, &dataPtr->link);
-
-                // Delete this resource if this is the only data entry
-                if (0 == le_dls_NumLinks(&resourceDataPtr->dataList))
-                {
-                    LE_DEBUG("Deleting the resource since no data");
-                    le_mem_Release(resourceDataPtr);
-                    le_dls_Remove(&recRef->resourceList, linkPtr);
-                }
-            }
-
-            linkPtr = NULL;
-        }
-        else
-        {
-            linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
-        }
+        resourceDataPtr->lastIntValue = 0;
+        resourceDataPtr->lastFloatValue = 0;
+        linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Delete a data of a with a specific resource name and timestamp.
- * If no other data exists with this timestamp, timestamp will be deleted as well.
+ * Delete the data of a resource with a specific timestamp.
+ * If no other data exists for this resource, the resource will be deleted as well.
+ * If no other data exists with this timestamp, the timestamp will be deleted as well.
  */
 //--------------------------------------------------------------------------------------------------
 static void DeleteData
 (
     timeSeries_RecordRef_t recRef,
-    const char* path,
+    ResourceData_t* resourceDataPtr,
     uint64_t timestamp
 )
 {
-    DeleteResourceData(recRef, path, timestamp);
+    bool isFound;
+    size_t row = FindTimestamp(recRef, timestamp, &isFound);
+
+    if (!isFound)
+    {
+        return;
+    }
+
+    LE_DEBUG("Deleting this resource data");
+    RewriteValues(resourceDataPtr, row, NULL);
+
+    // Delete this resource if this was the only data entry
+    if (0 == resourceDataPtr->column.count)
+    {
+        LE_DEBUG("Deleting the resource since no data");
+        le_dls_Remove(&recRef->resourceList, &resourceDataPtr->link);
+        ClearValueColumn(&resourceDataPtr->column);
+        le_mem_Release(resourceDataPtr);
+    }
+
+    // delete timestamp if there are no data associated with this timestamp
+    le_dls_Link_t* linkPtr = le_dls_Peek(&recRef->resourceList);
 
-    // delete timestamp ref if there are no data associated with this timestamp
-    if (0 == GetResourceDataTimestampCount(recRef, timestamp))
+    while ( linkPtr != NULL )
     {
-        LE_DEBUG("Deleting timestamp ref since no data exists for this timestamp.");
-        DeleteTimestamp(recRef, timestamp);
+        if (IsBitSet(&CONTAINER_OF(linkPtr, ResourceData_t, link)->column.presence, row))
+        {
+            return;
+        }
+        linkPtr = le_dls_PeekNext(&recRef->resourceList, linkPtr);
     }
+
+    LE_DEBUG("Deleting timestamp: %" PRIu64, timestamp);
+    RewriteTimestamps(recRef, row, NULL);
 }
 
 
@@ -705,54 +1471,28 @@ static le_result_t EncodeResourceDeltaValue
 (
     timeSeries_RecordRef_t recRef,
     ResourceData_t* resourceDataPtr,
-    TimestampData_t* currentTimestampPtr,
-    TimestampData_t* prevTimestampPtr
+    const Data_t* dataPtr,
+    bool isFirstTimestamp
 )
 {
     CborError err;
 
-    // get data with this timestamp from this resource
-    Data_t* dataPtr = (Data_t*)GetTimestampData(resourceDataPtr,
-                                                 currentTimestampPtr->timestamp);
-    Data_t* prevDataPtr = NULL;
-
     int intDelta;
     double floatDelta;
 
-    int prevIntValue;
-    double prevFloatValue;
-
-    if (!dataPtr)
-    {
-       LE_ERROR("dataPtr is NULL");
-       return LE_FAULT;
-    }
-
-    if (prevTimestampPtr != NULL)
-    {
-        prevDataPtr = (Data_t*)GetTimestampData(resourceDataPtr, prevTimestampPtr->timestamp);
-    }
-
-    // delta value is only applicable to int and floats
+    // delta value is only applicable to int and floats, and is computed from the last value encoded
+    // for this resource
     switch (resourceDataPtr->type)
     {
         case DATA_TYPE_INT:
-            if (prevTimestampPtr == NULL)
+            if (isFirstTimestamp)
             {
                 intDelta = dataPtr->intValue * resourceDataPtr->factor;
             }
             else
             {
-                if (prevDataPtr == NULL)
-                {
-                    prevIntValue = resourceDataPtr->lastIntValue;
-                }
-                else
-                {
-                    prevIntValue = prevDataPtr->intValue;
-                }
-
-                intDelta = (dataPtr->intValue - prevIntValue) * resourceDataPtr->factor;
+                intDelta = (dataPtr->intValue - resourceDataPtr->lastIntValue)
+                           * resourceDataPtr->factor;
             }
 
             resourceDataPtr->lastIntValue = dataPtr->intValue;
@@ -761,22 +1501,14 @@ static le_result_t EncodeResourceDeltaValue
             break;
 
         case DATA_TYPE_FLOAT:
-            if (prevTimestampPtr == NULL)
+            if (isFirstTimestamp)
             {
                 floatDelta = dataPtr->floatValue;
             }
             else
             {
-                if (prevDataPtr == NULL)
-                {
-                    prevFloatValue = resourceDataPtr->lastFloatValue;
-                }
-                else
-                {
-                    prevFloatValue = prevDataPtr->floatValue;
-                }
-
-                floatDelta = (dataPtr->floatValue - prevFloatValue) * resourceDataPtr->factor;
+                floatDelta = (dataPtr->floatValue - resourceDataPtr->lastFloatValue)
+                             * resourceDataPtr->factor;
             }
 
             resourceDataPtr->lastFloatValue = dataPtr->floatValue;
@@ -807,7 +1539,8 @@ static le_result_t EncodeResourceDeltaValue
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add resource data to cbor stream array
+ * Add resource data of a range of timestamps to cbor stream array.  The first timestamp of the
+ * range is encoded with absolute values, so that each range can be decoded on its own.
  *
  * @return:
  *      - LE_OK on success
@@ -816,46 +1549,79 @@ static le_result_t EncodeResourceDeltaValue
 //--------------------------------------------------------------------------------------------------
 static le_result_t EncodeResourceDataToCborArray
 (
-    timeSeries_RecordRef_t recRef
+    timeSeries_RecordRef_t recRef,
+    size_t firstRow,                    ///< Index of the first timestamp of the range
+    size_t timestampCount               ///< Number of timestamps in the range
 )
 {
     CborError err;
     le_result_t result = LE_OK;
 
-    le_dls_Link_t* tsLinkPtr = le_dls_Peek(&recRef->timestampList);
-    TimestampData_t* timestampPtr;
-    TimestampData_t* prevTimestampPtr = NULL;
+    TimestampReader_t tsReader;
+    uint64_t prevTimestamp = 0;
+    size_t row;
+
+    le_dls_Link_t* rdLinkPtr;
+    ResourceData_t* resourceDataPtr;
+
+    Data_t value;
+    char stringValue[LE_AVDATA_STRING_VALUE_BYTES];
+
+    // Columns are packed relative to the previous values, so they are all read from the first
+    // timestamp, in lockstep with the timestamps.
+    InitTimestampReader(&tsReader, &recRef->timestamps);
+    rdLinkPtr = le_dls_Peek(&recRef->resourceList);
+
+    while ( rdLinkPtr != NULL )
+    {
+        resourceDataPtr = CONTAINER_OF(rdLinkPtr, ResourceData_t, link);
+        InitValueReader(&resourceDataPtr->reader, &resourceDataPtr->column);
+        rdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
+    }
 
     // Loop through the timestamps
-    while ( tsLinkPtr != NULL )
+    for (row = 0; (row < firstRow + timestampCount) && (row < recRef->timestamps.count); row++)
     {
-        timestampPtr = CONTAINER_OF(tsLinkPtr, TimestampData_t, link);
+        uint64_t timestamp = ReadTimestamp(&tsReader);
+        bool isFirstTimestamp = (row == firstRow);
 
         // sample array starts with timestamp followed by resource data with this timestamp
-        uint64_t timestamp;
-        if (prevTimestampPtr == NULL)
-        {
-            ResetResourceLastValue(recRef);
-            timestamp = timestampPtr->timestamp * recRef->timestampFactor;
-        }
-        else
+        if (row >= firstRow)
         {
-            uint64_t deltaTimestamp = ((timestampPtr->timestamp) - (prevTimestampPtr->timestamp));
-            timestamp = deltaTimestamp * recRef->timestampFactor;
-        }
+            uint64_t encodedTimestamp;
+            if (isFirstTimestamp)
+            {
+                ResetResourceLastValue(recRef);
+                encodedTimestamp = timestamp * recRef->timestampFactor;
+            }
+            else
+            {
+                encodedTimestamp = (timestamp - prevTimestamp) * recRef->timestampFactor;
+            }
 
-        err = cbor_encode_uint(&recRef->sampleArray, timestamp);
-        RETURN_IF_CBOR_ERROR(err);
+            err = cbor_encode_uint(&recRef->sampleArray, encodedTimestamp);
+            RETURN_IF_CBOR_ERROR(err);
+        }
 
-        le_dls_Link_t* rdLinkPtr = le_dls_Peek(&recRef->resourceList);
-        ResourceData_t* resourceDataPtr;
+        rdLinkPtr = le_dls_Peek(&recRef->resourceList);
 
         // Loop through the resource data with this timestamp
         while ( rdLinkPtr != NULL )
         {
             resourceDataPtr = CONTAINER_OF(rdLinkPtr, ResourceData_t, link);
+            rdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
 
-            if (GetTimestampData(resourceDataPtr, timestampPtr->timestamp) == NULL)
+            bool isPresent = ReadNextValue(&resourceDataPtr->reader,
+                                           resourceDataPtr->type,
+                                           &value,
+                                           stringValue);
+
+            if (row < firstRow)
+            {
+                continue;
+            }
+
+            if (!isPresent)
             {
                 result = EncodeResourceDefaultValue(recRef);
             }
@@ -863,15 +1629,17 @@ static le_result_t EncodeResourceDataToCborArray
             {
                 result = EncodeResourceDeltaValue(recRef,
                                                   resourceDataPtr,
-                                                  timestampPtr,
-                                                  prevTimestampPtr);
+                                                  &value,
+                                                  isFirstTimestamp);
             }
 
-            rdLinkPtr = le_dls_PeekNext(&recRef->resourceList, rdLinkPtr);
+            if (result != LE_OK)
+            {
+                return result;
+            }
         }
 
-        prevTimestampPtr = timestampPtr;
-        tsLinkPtr = le_dls_PeekNext(&recRef->timestampList, tsLinkPtr);
+        prevTimestamp = timestamp;
     }
 
     return result;
@@ -880,119 +1648,147 @@ static le_result_t EncodeResourceDataToCborArray
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Encode the data accumulated
+ * Encode the data accumulated for a range of timestamps in the record buffer
  *
  * @return:
  *      - LE_OK on success
- *      - LE_OVERFLOW if buffer is full
+ *      - LE_NO_MEMORY if buffer is full
  *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t Encode
+static le_result_t EncodeTimestamps
 (
-    timeSeries_RecordRef_t recRef
+    timeSeries_RecordRef_t recRef,
+    size_t firstRow,                    ///< Index of the first timestamp of the range
+    size_t timestampCount               ///< Number of timestamps in the range
 )
 {
     CborError err;
     le_result_t result = LE_OK;
 
-    // only encode if it hasn't been encoded
-    if (false == recRef->isEncoded)
+    // Initialize CBOR stream.
+    cbor_encoder_init(&recRef->streamRef,
+                      recRef->bufferPtr,
+                      recRef->bufferSize,
+                      0);
+
+    err = cbor_encoder_create_map(&recRef->streamRef,
+                                  &recRef->mapRef,
+                                  NUM_TIME_SERIES_MAPS);
+    RETURN_IF_CBOR_ERROR(err);
+
+    // Create a map and add the header in to the map.
+    err = cbor_encode_text_stringz(&recRef->mapRef, "h");
+    RETURN_IF_CBOR_ERROR(err);
+
+    // Create an array for the header.
+    err = cbor_encoder_create_array(&recRef->mapRef,
+                                    &recRef->headerArray,
+                                    GetResourceCount(recRef));
+    RETURN_IF_CBOR_ERROR(err);
+
+    // Encode resource names to header array
+    result = EncodeResourceNameToCborArray(recRef);
+    if (result != LE_OK)
     {
-        // clear buffer
-        memset(recRef->bufferPtr, 0, recRef->bufferSize);
+        return result;
+    }
 
-        // Initialize CBOR stream.
-        cbor_encoder_init(&recRef->streamRef,
-                          recRef->bufferPtr,
-                          MAX_CBOR_BUFFER_NUMBYTES,
-                          0);
+    // Close the header array i.e done with entering resource names
+    cbor_encoder_close_container(&recRef->mapRef,
+                                 &recRef->headerArray);
 
-        err = cbor_encoder_create_map(&recRef->streamRef,
-                                      &recRef->mapRef,
-                                      NUM_TIME_SERIES_MAPS);
-        RETURN_IF_CBOR_ERROR(err);
 
-        // Create a map and add the header in to the map.
-        err = cbor_encode_text_stringz(&recRef->mapRef, "h");
-        RETURN_IF_CBOR_ERROR(err);
+    // Create a map for factor.
+    err = cbor_encode_text_stringz(&recRef->mapRef, "f");
+    RETURN_IF_CBOR_ERROR(err);
 
-        // Create an array for the header.
-        err = cbor_encoder_create_array(&recRef->mapRef,
-                                        &recRef->headerArray,
-                                        GetResourceCount(recRef));
-        RETURN_IF_CBOR_ERROR(err);
+    // size of factor array is number of resources + 1 to account for the timestamp factor
+    size_t factorArraySize = GetResourceCount(recRef) + 1;
 
-        // Encode resource names to header array
-        result = EncodeResourceNameToCborArray(recRef);
-        if (result != LE_OK)
-        {
-            return result;
-        }
+    // Create an array of factors (time stamp factor [1], data factor [n])
+    err = cbor_encoder_create_array(&recRef->mapRef,
+                                    &recRef->factorArray,
+                                    factorArraySize);
+    RETURN_IF_CBOR_ERROR(err);
 
-        // Close the header array i.e done with entering resource names
-        cbor_encoder_close_container(&recRef->mapRef,
-                                     &recRef->headerArray);
+    // Encode factor to factor array
+    result = EncodeFactorToCborArray(recRef);
+    if (result != LE_OK)
+    {
+        return result;
+    }
 
+    // Close the factor array i.e done with entering resource names
+    cbor_encoder_close_container(&recRef->mapRef,
+                                 &recRef->factorArray);
 
-        // Create a map for factor.
-        err = cbor_encode_text_stringz(&recRef->mapRef, "f");
-        RETURN_IF_CBOR_ERROR(err);
 
-        // size of factor array is number of resources + 1 to account for the timestamp factor
-        size_t factorArraySize = GetResourceCount(recRef) + 1;
+    // Create a map for samples.
+    err = cbor_encode_text_stringz(&recRef->mapRef, "s");
+    RETURN_IF_CBOR_ERROR(err);
 
-        // Create an array of factors (time stamp factor [1], data factor [n])
-        err = cbor_encoder_create_array(&recRef->mapRef,
-                                        &recRef->factorArray,
-                                        factorArraySize);
-        RETURN_IF_CBOR_ERROR(err);
+    // size of sample array
+    size_t sampleArraySize = (GetResourceCount(recRef) + 1) * timestampCount;
 
-        // Encode factor to factor array
-        result = EncodeFactorToCborArray(recRef);
-        if (result != LE_OK)
-        {
-            return result;
-        }
+    // Create an array of samples
+    err = cbor_encoder_create_array(&recRef->mapRef,
+                                    &recRef->sampleArray,
+                                    sampleArraySize);
+    RETURN_IF_CBOR_ERROR(err);
+
+    // Encode resource data to sample array
+    result = EncodeResourceDataToCborArray(recRef, firstRow, timestampCount);
+    if (result != LE_OK)
+    {
+        return result;
+    }
 
-        // Close the factor array i.e done with entering resource names
-        cbor_encoder_close_container(&recRef->mapRef,
-                                     &recRef->factorArray);
+    // Close the sample array
+    err = cbor_encoder_close_container(&recRef->mapRef,
+                                       &recRef->sampleArray);
+    RETURN_IF_CBOR_ERROR(err);
 
+    err = cbor_encoder_close_container(&recRef->streamRef,
+                                       &recRef->mapRef);
+    RETURN_IF_CBOR_ERROR(err);
 
-        // Create a map for samples.
-        err = cbor_encode_text_stringz(&recRef->mapRef, "s");
-        RETURN_IF_CBOR_ERROR(err);
+    return result;
+}
 
-        // size of sample array
-        size_t sampleArraySize = (GetResourceCount(recRef) + 1) * GetTimestampCount(recRef);
 
-        // Create an array of samples
-        err = cbor_encoder_create_array(&recRef->mapRef,
-                                        &recRef->sampleArray,
-                                        sampleArraySize);
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode the data accumulated
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if buffer is full
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Encode
+(
+    timeSeries_RecordRef_t recRef
+)
+{
+    le_result_t result = LE_OK;
 
-        // Encode resource data to sample array
-        result = EncodeResourceDataToCborArray(recRef);
+    // only encode if it hasn't been encoded
+    if (false == recRef->isEncoded)
+    {
+        result = EncodeTimestamps(recRef,
+                                  0,
+                                  GetTimestampCount(recRef));
         if (result != LE_OK)
         {
             return result;
         }
 
-        // Close the sample array
-        cbor_encoder_close_container(&recRef->mapRef,
-                                     &recRef->sampleArray);
-
-        cbor_encoder_close_container(&recRef->streamRef,
-                                     &recRef->mapRef);
-
-        RETURN_IF_CBOR_ERROR(err);
-
         recRef->isEncoded = true;
     }
 
     LE_DEBUG("Encoded size: %zd", GetEncodedDataSize(recRef));
-    LE_DUMP(recRef->bufferPtr, GetEncodedDataSize(recRef));
 
     return result;
 }
@@ -1015,10 +1811,10 @@ le_result_t timeSeries_Create
     RecordData_t* recordDataPtr;
 
     recordDataPtr = le_mem_ForceAlloc(RecordDataPoolRef);
-    recordDataPtr->timestampList = LE_DLS_LIST_INIT;
+    InitTimestampColumn(&recordDataPtr->timestamps);
     recordDataPtr->resourceList = LE_DLS_LIST_INIT;
     recordDataPtr->bufferPtr = le_mem_ForceAlloc(CborBufferPoolRef);
-    recordDataPtr->bufferSize = MAX_CBOR_BUFFER_NUMBYTES;
+    recordDataPtr->bufferSize = MAX_RECORD_CBOR_NUMBYTES;
     recordDataPtr->timestampFactor = 1;
     recordDataPtr->isEncoded = false;
     *recRefPtr = recordDataPtr;
@@ -1106,7 +1902,8 @@ static le_result_t CreateResourceData
 (
     timeSeries_RecordRef_t recRef,
     const char* path,
-    DataType_t type
+    DataType_t type,
+    ResourceData_t** rdataPtrPtr
 )
 {
     LE_DEBUG("Creating resource: %s of type %d", path, type);
@@ -1115,200 +1912,92 @@ static le_result_t CreateResourceData
 
     if (le_utf8_Copy(resourceDataPtr->name, path, LE_AVDATA_PATH_NAME_BYTES, NULL) == LE_OVERFLOW)
     {
-        return LE_OVERFLOW;
         le_mem_Release(resourceDataPtr);
+        return LE_OVERFLOW;
     }
 
     resourceDataPtr->type = type;
-    resourceDataPtr->dataList = LE_DLS_LIST_INIT;
+    InitValueColumn(&resourceDataPtr->column);
     resourceDataPtr->link = LE_DLS_LINK_INIT;
 
     if ((type == DATA_TYPE_STRING) || (type == DATA_TYPE_BOOL))
     {
-        resourceDataPtr->factor = 0;
-    }
-    else
-    {
-        resourceDataPtr->factor = 1;
-        resourceDataPtr->lastIntValue = 0;
-        resourceDataPtr->lastFloatValue = 0;
-    }
-
-    le_dls_Queue(&recRef->resourceList, &resourceDataPtr->link);
-
-    return LE_OK;
-}
-
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Add the integer value for the specified resource
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t AddIntResourceData
-(
-    timeSeries_RecordRef_t recRef,
-    ResourceData_t* rdataPtr,
-    int32_t value,
-    uint64_t timestamp
-)
-{
-    le_result_t result;
-
-    Data_t* dataPtr = (Data_t*)GetTimestampData(rdataPtr, timestamp);
-
-    // if existing timestamp is used, update value
-    if (dataPtr != NULL)
-    {
-        dataPtr->intValue = value;
-    }
-    else
-    {
-        dataPtr = le_mem_ForceAlloc(DataValuePoolRef);
-        dataPtr->timestamp = timestamp;
-        dataPtr->intValue = value;
-        dataPtr->link = LE_DLS_LINK_INIT;
-        le_dls_Queue(&rdataPtr->dataList, &dataPtr->link);
-    }
-
-    // new entry, we need re-encode
-    recRef->isEncoded = false;
-    result = Encode(recRef);
-
-    // if our buffer cannot fit this new added data, remove it
-    if (result == LE_NO_MEMORY)
-    {
-        DeleteData(recRef, rdataPtr->name, timestamp);
-        recRef->isEncoded = false;
-    }
-
-    return result;
-}
-
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Add the float value for the specified resource
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t AddFloatResourceData
-(
-    timeSeries_RecordRef_t recRef,
-    ResourceData_t* rdataPtr,
-    double value,
-    uint64_t timestamp
-)
-{
-    le_result_t result;
-
-    Data_t* dataPtr = (Data_t*)GetTimestampData(rdataPtr, timestamp);
-
-    // if existing timestamp is used, update value
-    if (dataPtr != NULL)
-    {
-        dataPtr->floatValue = value;
-    }
-    else
-    {
-        dataPtr = le_mem_ForceAlloc(DataValuePoolRef);
-        dataPtr->timestamp = timestamp;
-        dataPtr->floatValue = value;
-        dataPtr->link = LE_DLS_LINK_INIT;
-        le_dls_Queue(&rdataPtr->dataList, &dataPtr->link);
-    }
-
-    // new entry, we need re-encode
-    recRef->isEncoded = false;
-    result = Encode(recRef);
-
-    // if our buffer cannot fit this new added data, remove it
-    if (result == LE_NO_MEMORY)
-    {
-        DeleteData(recRef, rdataPtr->name, timestamp);
-        recRef->isEncoded = false;
+        resourceDataPtr->factor = 0;
+    }
+    else
+    {
+        resourceDataPtr->factor = 1;
+        resourceDataPtr->lastIntValue = 0;
+        resourceDataPtr->lastFloatValue = 0;
     }
 
-    return result;
+    le_dls_Queue(&recRef->resourceList, &resourceDataPtr->link);
+    *rdataPtrPtr = resourceDataPtr;
+
+    return LE_OK;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Add the boolean value for the specified resource
+ * Add the value of the specified resource with a timestamp, creating the resource if needed
+ *
+ * @return:
+ *      - LE_OK on success
+ *      - LE_NO_MEMORY if the current entry was NOT added because the time series buffer is full.
+ *      - LE_OVERFLOW if resource specified is too long
+ *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t AddBoolResourceData
+static le_result_t AddResourceData
 (
     timeSeries_RecordRef_t recRef,
-    ResourceData_t* rdataPtr,
-    bool value,
+    const char* path,
+    DataType_t type,
+    const Data_t* valuePtr,
     uint64_t timestamp
 )
 {
     le_result_t result;
+    ResourceData_t* rdataPtr;
+    bool isFound;
 
-    Data_t* dataPtr = (Data_t*)GetTimestampData(rdataPtr, timestamp);
+    result = GetResourceData(recRef, path, type, &rdataPtr);
 
-    // if existing timestamp is used, update value
-    if (dataPtr != NULL)
+    // resource data does not exists
+    if (result == LE_NOT_FOUND)
     {
-        dataPtr->boolValue = value;
+        result = CreateResourceData(recRef, path, type, &rdataPtr);
     }
-    else
+
+    if (result != LE_OK)
     {
-        dataPtr = le_mem_ForceAlloc(DataValuePoolRef);
-        dataPtr->timestamp = timestamp;
-        dataPtr->boolValue = value;
-        dataPtr->link = LE_DLS_LINK_INIT;
-        le_dls_Queue(&rdataPtr->dataList, &dataPtr->link);
+        return result;
     }
 
-    // new entry, we need re-encode
-    recRef->isEncoded = false;
-    result = Encode(recRef);
+    size_t row = FindTimestamp(recRef, timestamp, &isFound);
 
-    // if our buffer cannot fit this new added data, remove it
-    if (result == LE_NO_MEMORY)
+    if (!isFound)
     {
-        DeleteData(recRef, rdataPtr->name, timestamp);
-        recRef->isEncoded = false;
+        if (row == recRef->timestamps.count)
+        {
+            AppendTimestamp(&recRef->timestamps, timestamp);
+        }
+        else
+        {
+            RewriteTimestamps(recRef, row, &timestamp);
+        }
     }
 
-    return result;
-}
-
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Add the string value for the specified resource
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t AddStringResourceData
-(
-    timeSeries_RecordRef_t recRef,
-    ResourceData_t* rdataPtr,
-    const char* value,
-    uint64_t timestamp
-)
-{
-    le_result_t result;
-
-    Data_t* dataPtr = (Data_t*)GetTimestampData(rdataPtr, timestamp);
-
-    // if existing timestamp is used, update value
-    if (dataPtr != NULL)
+    // Values are usually recorded in order, so they are appended.  If existing timestamp is used,
+    // update value.
+    if (row >= rdataPtr->column.presence.bitCount)
     {
-        le_utf8_Copy(dataPtr->strValuePtr, value, LE_AVDATA_STRING_VALUE_BYTES, NULL);
+        AppendValue(&rdataPtr->column, row, type, valuePtr);
     }
     else
     {
-        dataPtr = le_mem_ForceAlloc(DataValuePoolRef);
-        dataPtr->timestamp = timestamp;
-        dataPtr->strValuePtr = le_mem_ForceAlloc(StringValuePoolRef);
-        // TODO: handle case when string value is too long
-        le_utf8_Copy(dataPtr->strValuePtr, value, LE_AVDATA_STRING_VALUE_BYTES, NULL);
-        dataPtr->link = LE_DLS_LINK_INIT;
-        le_dls_Queue(&rdataPtr->dataList, &dataPtr->link);
+        RewriteValues(rdataPtr, row, valuePtr);
     }
 
     // new entry, we need re-encode
@@ -1318,7 +2007,7 @@ static le_result_t AddStringResourceData
     // if our buffer cannot fit this new added data, remove it
     if (result == LE_NO_MEMORY)
     {
-        DeleteData(recRef, rdataPtr->name, timestamp);
+        DeleteData(recRef, rdataPtr, timestamp);
         recRef->isEncoded = false;
     }
 
@@ -1344,39 +2033,11 @@ le_result_t timeSeries_AddInt
     uint64_t timestamp
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
-
-    result = GetResourceData(recRef, path, DATA_TYPE_INT, &resourceDataPtr);
-
-    // create or add resource data
-    if (result != LE_FAULT)
-    {
-        AddTimestamp(recRef, timestamp);
-
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
-        {
-            result = CreateResourceData(recRef, path, DATA_TYPE_INT);
-
-            if (result != LE_OK)
-            {
-                return result;
-            }
-
-            result = GetResourceData(recRef, path, DATA_TYPE_INT, &resourceDataPtr);
-
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
-        }
+    Data_t data;
 
-        result = AddIntResourceData(recRef, resourceDataPtr, value, timestamp);
-    }
+    data.intValue = value;
 
-    return result;
+    return AddResourceData(recRef, path, DATA_TYPE_INT, &data, timestamp);
 }
 
 
@@ -1398,39 +2059,11 @@ le_result_t timeSeries_AddFloat
     uint64_t timestamp
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
-
-    result = GetResourceData(recRef, path, DATA_TYPE_FLOAT, &resourceDataPtr);
-
-    // cmust be ok or not found
-    if (result != LE_FAULT)
-    {
-        AddTimestamp(recRef, timestamp);
+    Data_t data;
 
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
-        {
-            result = CreateResourceData(recRef, path, DATA_TYPE_FLOAT);
-
-            if (result != LE_OK)
-            {
-                return result;
-            }
-
-            result = GetResourceData(recRef, path, DATA_TYPE_FLOAT, &resourceDataPtr);
-
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
-        }
-
-        result = AddFloatResourceData(recRef, resourceDataPtr, value, timestamp);
-    }
+    data.floatValue = value;
 
-    return result;
+    return AddResourceData(recRef, path, DATA_TYPE_FLOAT, &data, timestamp);
 }
 
 
@@ -1452,39 +2085,11 @@ le_result_t timeSeries_AddBool
     uint64_t timestamp
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
-
-    result = GetResourceData(recRef, path, DATA_TYPE_BOOL, &resourceDataPtr);
-
-    // cmust be ok or not found
-    if (result != LE_FAULT)
-    {
-        AddTimestamp(recRef, timestamp);
-
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
-        {
-            result = CreateResourceData(recRef, path, DATA_TYPE_BOOL);
-
-            if (result != LE_OK)
-            {
-                return result;
-            }
-
-            result = GetResourceData(recRef, path, DATA_TYPE_BOOL, &resourceDataPtr);
-
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
-        }
+    Data_t data;
 
-        result = AddBoolResourceData(recRef, resourceDataPtr, value, timestamp);
-    }
+    data.boolValue = value;
 
-    return result;
+    return AddResourceData(recRef, path, DATA_TYPE_BOOL, &data, timestamp);
 }
 
 
@@ -1506,39 +2111,130 @@ le_result_t timeSeries_AddString
     uint64_t timestamp
 )
 {
-    le_result_t result;
-    ResourceData_t* resourceDataPtr;
+    Data_t data;
+    char stringValue[LE_AVDATA_STRING_VALUE_BYTES];
+
+    // TODO: handle case when string value is too long
+    le_utf8_Copy(stringValue, value, sizeof(stringValue), NULL);
+    data.strValuePtr = stringValue;
+
+    return AddResourceData(recRef, path, DATA_TYPE_STRING, &data, timestamp);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Handles the ACK of each chunk of a record pushed in several chunks, and calls the client handler
+ * once all of them have been acknowledged.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ChunkPushHandler
+(
+    le_avdata_PushStatus_t status,
+    void* contextPtr
+)
+{
+    PushGroup_t* groupPtr = (PushGroup_t*)contextPtr;
 
-    result = GetResourceData(recRef, path, DATA_TYPE_STRING, &resourceDataPtr);
+    if (status != LE_AVDATA_PUSH_SUCCESS)
+    {
+        groupPtr->status = LE_AVDATA_PUSH_FAILED;
+    }
 
-    // cmust be ok or not found
-    if (result != LE_FAULT)
+    groupPtr->pendingCount--;
+
+    if (0 == groupPtr->pendingCount)
     {
-        AddTimestamp(recRef, timestamp);
+        if (groupPtr->handlerPtr != NULL)
+        {
+            groupPtr->handlerPtr(groupPtr->status, groupPtr->contextPtr);
+        }
+        le_mem_Release(groupPtr);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Encode a range of timestamps and compress it in a chunk buffer.  If the compressed data does not
+ * fit, the range is shortened until it does.
+ *
+ * @return:
+ *      - LE_OK on success, timestampCountPtr is updated with the number of timestamps compressed
+ *      - LE_OVERFLOW if a single timestamp does not fit in a chunk
+ *      - LE_FAULT on any other error
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CompressChunk
+(
+    timeSeries_RecordRef_t recRef,
+    z_stream* streamPtr,                ///< Deflate stream, reset for each attempt
+    size_t firstRow,                    ///< Index of the first timestamp of the chunk
+    size_t* timestampCountPtr,          ///< [IN/OUT] Number of timestamps in the chunk
+    Chunk_t* chunkPtr                   ///< [OUT] Compressed chunk
+)
+{
+    size_t timestampCount = *timestampCountPtr;
 
-        // resource data does not exists
-        if (result == LE_NOT_FOUND)
+    while (true)
+    {
+        le_result_t result = EncodeTimestamps(recRef, firstRow, timestampCount);
+        if (result != LE_OK)
         {
-            result = CreateResourceData(recRef, path, DATA_TYPE_STRING);
+            return (result == LE_NO_MEMORY) ? LE_OVERFLOW : result;
+        }
 
-            if (result != LE_OK)
-            {
-                return result;
-            }
+        size_t cborSize = cbor_encoder_get_buffer_size(&recRef->streamRef, recRef->bufferPtr);
+
+        if (Z_OK != deflateReset(streamPtr))
+        {
+            return LE_FAULT;
+        }
 
-            result = GetResourceData(recRef, path, DATA_TYPE_STRING, &resourceDataPtr);
+        streamPtr->avail_in = cborSize;
+        streamPtr->next_in = (Bytef *)recRef->bufferPtr;
+        streamPtr->avail_out = MAX_CBOR_BUFFER_NUMBYTES;
+        streamPtr->next_out = (Bytef *)chunkPtr->bufferPtr;
 
-            // if creating it and we still cannot the resource, there is an issue
-            if (result != LE_OK)
-            {
-                return result;
-            }
+        int zResult = deflate(streamPtr, Z_FINISH);
+
+        if (Z_STREAM_END == zResult)
+        {
+            chunkPtr->bufferLength = streamPtr->total_out;
+            *timestampCountPtr = timestampCount;
+            return LE_OK;
         }
 
-        result = AddStringResourceData(recRef, resourceDataPtr, value, timestamp);
-    }
+        if (Z_OK != zResult)
+        {
+            LE_ERROR("Compression error %d", zResult);
+            return LE_FAULT;
+        }
 
-    return result;
+        if (timestampCount <= 1)
+        {
+            return LE_OVERFLOW;
+        }
+
+        // Output is full: finish the compression over the chunk buffer to learn the compressed size
+        // of the whole range, and retry with the share of timestamps that fits, with some margin.
+        while (Z_OK == zResult)
+        {
+            streamPtr->avail_out = MAX_CBOR_BUFFER_NUMBYTES;
+            streamPtr->next_out = (Bytef *)chunkPtr->bufferPtr;
+            zResult = deflate(streamPtr, Z_FINISH);
+        }
+
+        if (Z_STREAM_END != zResult)
+        {
+            LE_ERROR("Compression error %d", zResult);
+            return LE_FAULT;
+        }
+
+        size_t newCount = timestampCount * MAX_CBOR_BUFFER_NUMBYTES / streamPtr->total_out * 9 / 10;
+        timestampCount = (newCount < 1) ? 1 :
+                         ((newCount < timestampCount) ? newCount : timestampCount - 1);
+    }
 }
 
 
@@ -1546,8 +2242,15 @@ le_result_t timeSeries_AddString
 /**
  * Compress the accumulated time series data and send it to server.
  *
+ * A record that does not fit in a single push once compressed is split in chunks of consecutive
+ * timestamps, each chunk being a complete record on its own.  All the chunks are queued at once, and
+ * the handler is called once all of them have been acknowledged.  If only some of the chunks could
+ * be queued, the handler reports a failure.
+ *
  * @return:
  *      - LE_OK on success
+ *      - LE_BUSY if push is queued and will pushed later automatically
+ *      - LE_NOT_POSSIBLE if push queue cannot hold all the chunks, try again later
  *      - LE_FAULT on any other error
  */
 //--------------------------------------------------------------------------------------------------
@@ -1558,44 +2261,171 @@ le_result_t timeSeries_PushRecord
     void* contextPtr
 )
 {
-
     le_result_t result;
-    uint8_t buffer[MAX_CBOR_BUFFER_NUMBYTES];
-    size_t bufferLength;
+    Chunk_t chunks[MAX_PUSH_QUEUE];
+    size_t chunkCount = 0;
+    size_t freeSlotCount = push_GetFreeSlotCount();
     z_stream defstream;
+    int level = CompressionLevel;
 
-    result = Encode(recRef);
+    size_t firstRow = 0;
+    size_t remainingCount = GetTimestampCount(recRef);
+    size_t timestampCount = remainingCount;
+
+    memset(&defstream, 0, sizeof(defstream));
+    defstream.zalloc = Z_NULL;
+    defstream.zfree = Z_NULL;
+    defstream.opaque = Z_NULL;
+
+    if (Z_OK != deflateInit(&defstream, level))
+    {
+        LE_ERROR("Cannot initialize compression");
+        return LE_FAULT;
+    }
 
-    // Compress the cbor encoded data
-    if (result == LE_OK)
+    // Compress all the chunks first, so that nothing is pushed if the queue can't take them all.
+    // An empty record is pushed as one chunk without samples.
+    do
     {
-        defstream.zalloc = Z_NULL;
-        defstream.zfree = Z_NULL;
-        defstream.opaque = Z_NULL;
+        if (chunkCount >= freeSlotCount)
+        {
+            LE_WARN("Push queue cannot hold more than %zu chunks", freeSlotCount);
+            result = LE_NOT_POSSIBLE;
+            break;
+        }
 
-        defstream.avail_in = GetEncodedDataSize(recRef);
-        defstream.next_in = (Bytef *)recRef->bufferPtr;
-        defstream.avail_out = (uInt)sizeof(buffer);
-        defstream.next_out = (Bytef *)buffer;
+        le_clk_Time_t startTime = le_clk_GetRelativeTime();
 
-        deflateInit(&defstream, Z_BEST_COMPRESSION);
-        deflate(&defstream, Z_FINISH);
-        deflateEnd(&defstream);
+        chunks[chunkCount].bufferPtr = le_mem_ForceAlloc(ChunkBufferPoolRef);
+        result = CompressChunk(recRef,
+                               &defstream,
+                               firstRow,
+                               &timestampCount,
+                               &chunks[chunkCount]);
+        if (result != LE_OK)
+        {
+            LE_ERROR("Cannot compress record chunk: %s", LE_RESULT_TXT(result));
+            le_mem_Release(chunks[chunkCount].bufferPtr);
+            result = LE_FAULT;
+            break;
+        }
+
+        le_clk_Time_t encodeTime = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+        size_t bytesIn = cbor_encoder_get_buffer_size(&recRef->streamRef, recRef->bufferPtr);
+        size_t bytesOut = chunks[chunkCount].bufferLength;
+
+        LE_INFO("Chunk %zu: %zu timestamps, %zu bytes in, %zu bytes out, level %d, %" PRIu64 " us",
+                chunkCount + 1,
+                timestampCount,
+                bytesIn,
+                bytesOut,
+                level,
+                (uint64_t)encodeTime.sec * 1000000 + encodeTime.usec);
+
+        chunkCount++;
+        remainingCount -= timestampCount;
+        firstRow += timestampCount;
+
+        if (remainingCount > 0)
+        {
+            // Mostly incompressible data is not worth the slow compression levels
+            if ((level != Z_NO_COMPRESSION) && (level != Z_BEST_SPEED)
+                && (bytesOut * 100 > bytesIn * POOR_COMPRESSION_PERCENT))
+            {
+                level = Z_BEST_SPEED;
+                deflateEnd(&defstream);
+                if (Z_OK != deflateInit(&defstream, level))
+                {
+                    LE_ERROR("Cannot initialize compression");
+                    result = LE_FAULT;
+                    break;
+                }
+            }
+
+            // Size the next chunk from the compression ratio of this one, with some margin
+            timestampCount = timestampCount * MAX_CBOR_BUFFER_NUMBYTES / bytesOut * 9 / 10;
+            if (timestampCount < 1)
+            {
+                timestampCount = 1;
+            }
+            else if (timestampCount > remainingCount)
+            {
+                timestampCount = remainingCount;
+            }
+        }
+    }
+    while (remainingCount > 0);
+
+    deflateEnd(&defstream);
 
-        bufferLength = defstream.total_out;
+    // The record buffer was used for the chunks
+    recRef->isEncoded = false;
 
-        result = PushBuffer(buffer,
-                            bufferLength,
+    if ((LE_OK == result) && (1 == chunkCount))
+    {
+        result = PushBuffer(chunks[0].bufferPtr,
+                            chunks[0].bufferLength,
                             LWM2MCORE_PUSH_CONTENT_ZCBOR,
                             handlerPtr,
                             contextPtr);
+    }
+    else if (LE_OK == result)
+    {
+        PushGroup_t* groupPtr = le_mem_ForceAlloc(PushGroupPoolRef);
+        le_result_t chunkResult = LE_OK;
+        size_t i;
+
+        groupPtr->handlerPtr = handlerPtr;
+        groupPtr->contextPtr = contextPtr;
+        groupPtr->status = LE_AVDATA_PUSH_SUCCESS;
+
+        // One extra count keeps the group alive until all the chunks are queued
+        groupPtr->pendingCount = chunkCount + 1;
+
+        for (i = 0; i < chunkCount; i++)
+        {
+            chunkResult = PushBuffer(chunks[i].bufferPtr,
+                                     chunks[i].bufferLength,
+                                     LWM2MCORE_PUSH_CONTENT_ZCBOR,
+                                     ChunkPushHandler,
+                                     groupPtr);
+            if (0 == i)
+            {
+                result = chunkResult;
+            }
 
-        // if data was successfully pushed, reset our record
-        if ((result == LE_OK) || (result == LE_BUSY))
+            if ((LE_OK != chunkResult) && (LE_BUSY != chunkResult))
+            {
+                break;
+            }
+        }
+
+        // Chunks that were not queued will never be acknowledged.  A chunk that failed has already
+        // been reported to ChunkPushHandler(), unless the queue was full.
+        if (i < chunkCount)
         {
-            LE_DEBUG("Data push success");
-            ResetRecord(recRef); // clear all data accumulated for this record
+            groupPtr->status = LE_AVDATA_PUSH_FAILED;
+            groupPtr->pendingCount -= chunkCount - i - 1;
+            if (LE_NOT_POSSIBLE == chunkResult)
+            {
+                groupPtr->pendingCount--;
+            }
         }
+
+        ChunkPushHandler(groupPtr->status, groupPtr);
+    }
+
+    while (chunkCount > 0)
+    {
+        chunkCount--;
+        le_mem_Release(chunks[chunkCount].bufferPtr);
+    }
+
+    // if data was successfully pushed, reset our record
+    if ((result == LE_OK) || (result == LE_BUSY))
+    {
+        LE_DEBUG("Data push success");
+        ResetRecord(recRef); // clear all data accumulated for this record
     }
 
     return result;
@@ -1609,12 +2439,49 @@ le_result_t timeSeries_Init
 {
     // Create the various memory pools
     RecordDataPoolRef = le_mem_CreatePool("Record pool", sizeof(RecordData_t));
-    TimestampDataPoolRef = le_mem_CreatePool("Timestamp pool", sizeof(TimestampData_t));
     ResourceDataPoolRef = le_mem_CreatePool("Resource pool", sizeof(ResourceData_t));
-    DataValuePoolRef = le_mem_CreatePool("Data value pool", sizeof(Data_t));
-    StringValuePoolRef = le_mem_CreatePool("String pool", LE_AVDATA_STRING_VALUE_BYTES);
+    ColumnBlockPoolRef = le_mem_CreatePool("Column block pool", sizeof(ColumnBlock_t));
+
+    CborBufferPoolRef = le_mem_CreatePool("CBOR buffer pool", MAX_RECORD_CBOR_NUMBYTES);
+    ChunkBufferPoolRef = le_mem_CreatePool("Chunk buffer pool", MAX_CBOR_BUFFER_NUMBYTES);
+    PushGroupPoolRef = le_mem_CreatePool("Push group pool", sizeof(PushGroup_t));
+
+    // Read the compression policy from config tree @ /apps/avcService/timeSeries
+    le_cfg_IteratorRef_t iterRef = le_cfg_CreateReadTxn(CFG_TIME_SERIES_PATH);
+    char policy[LE_CFG_STR_LEN_BYTES] = "";
+
+    le_cfg_GetString(iterRef, CFG_COMPRESSION_POLICY, policy, sizeof(policy), "bandwidth");
+
+    if (0 == strcmp(policy, "cpu"))
+    {
+        CompressionLevel = Z_BEST_SPEED;
+    }
+    else if (0 == strcmp(policy, "balanced"))
+    {
+        CompressionLevel = Z_DEFAULT_COMPRESSION;
+    }
+    else
+    {
+        if (0 != strcmp(policy, "bandwidth"))
+        {
+            LE_WARN("Unknown compression policy '%s', using 'bandwidth'", policy);
+        }
+        CompressionLevel = Z_BEST_COMPRESSION;
+    }
+
+    int level = le_cfg_GetInt(iterRef, CFG_COMPRESSION_LEVEL, CompressionLevel);
+    le_cfg_CancelTxn(iterRef);
+
+    if ((level >= Z_NO_COMPRESSION) && (level <= Z_BEST_COMPRESSION))
+    {
+        CompressionLevel = level;
+    }
+    else if (level != CompressionLevel)
+    {
+        LE_WARN("Invalid compression level %d, using %d", level, CompressionLevel);
+    }
 
-    CborBufferPoolRef = le_mem_CreatePool("CBOR buffer pool", MAX_CBOR_BUFFER_NUMBYTES);
+    LE_INFO("Time series compression level: %d", CompressionLevel);
 
     return LE_OK;
 }
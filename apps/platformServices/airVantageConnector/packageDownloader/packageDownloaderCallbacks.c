@@ -86,6 +86,20 @@
 //--------------------------------------------------------------------------------------------------
 #define BUF_SIZE                        512
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the ring buffer between the download and the parser threads
+ */
+//--------------------------------------------------------------------------------------------------
+#define PIPELINE_BUFFER_SIZE            (64 * 1024)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Value of 1 kibibyte in bytes
+ */
+//--------------------------------------------------------------------------------------------------
+#define KIBIBYTE                        (1 << 10)
+
 //--------------------------------------------------------------------------------------------------
 /**
  * PackageInfo data structure.
@@ -121,6 +135,221 @@ Package_t;
 //--------------------------------------------------------------------------------------------------
 static long HttpRespCode = LE_AVC_HTTP_STATUS_INVALID;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download pipeline.
+ *
+ * The data received by curl are copied once into a ring buffer.  A parser thread hashes them in
+ * place and writes them to the FIFO, while curl keeps receiving.  The FW update process reads the
+ * FIFO and writes the flash in its own process, so network, hashing and flash writing overlap.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t               buffer[PIPELINE_BUFFER_SIZE]; ///< Received data not parsed yet
+    size_t                readOffset;       ///< Offset of the first byte to parse
+    size_t                count;            ///< Number of bytes to parse
+    bool                  isEnded;          ///< No more data will be received
+    bool                  isDiscarded;      ///< Data not parsed yet should be dropped
+    lwm2mcore_DwlResult_t result;           ///< Result of the DWL parser
+    pthread_mutex_t       mutex;            ///< Protects the fields above
+    pthread_cond_t        dataCond;         ///< Signaled when data is received or on the end
+    pthread_cond_t        spaceCond;        ///< Signaled when data is parsed or on error
+    le_thread_Ref_t       parserRef;        ///< Parser thread
+    uint64_t              receivedBytes;    ///< Bytes received by curl
+    uint64_t              parsedBytes;      ///< Bytes parsed and hashed
+    uint64_t              storedBytes;      ///< Bytes written to the FIFO
+    le_clk_Time_t         startTime;        ///< Download start
+    le_clk_Time_t         receiveWaitTime;  ///< Time curl waited for free space
+    le_clk_Time_t         parseTime;        ///< Time spent parsing, hashing and storing
+    le_clk_Time_t         storeTime;        ///< Time spent writing to the FIFO
+}
+Pipeline_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Download pipeline, only used during pkgDwlCb_Download()
+ */
+//--------------------------------------------------------------------------------------------------
+static Pipeline_t Pipeline =
+{
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .dataCond = PTHREAD_COND_INITIALIZER,
+    .spaceCond = PTHREAD_COND_INITIALIZER,
+};
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute a throughput in KiB/s
+ *
+ * @return
+ *      Throughput, 0 if the time is null
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetKiBPerSec
+(
+    uint64_t        bytes,  ///< [IN] Number of bytes processed
+    le_clk_Time_t   time    ///< [IN] Processing time
+)
+{
+    uint64_t msecs = (uint64_t)time.sec * SECS_TO_MSECS + time.usec / SECS_TO_MSECS;
+
+    if (0 == msecs)
+    {
+        return 0;
+    }
+
+    return (uint32_t)((bytes * SECS_TO_MSECS) / (msecs * KIBIBYTE));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parser thread: parse, hash and store the data of the ring buffer, in place
+ */
+//--------------------------------------------------------------------------------------------------
+static void* ParserThread
+(
+    void* contextPtr    ///< [IN] Context pointer
+)
+{
+    // Reading the package certificate requires the secure storage
+    le_secStore_ConnectService();
+
+    LE_FATAL_IF(0 != pthread_mutex_lock(&Pipeline.mutex), "Could not lock the mutex");
+
+    for (;;)
+    {
+        uint8_t* dataPtr;
+        size_t length;
+        lwm2mcore_DwlResult_t result;
+        le_clk_Time_t startTime;
+
+        while ((0 == Pipeline.count) && (!Pipeline.isEnded) && (!Pipeline.isDiscarded))
+        {
+            pthread_cond_wait(&Pipeline.dataCond, &Pipeline.mutex);
+        }
+
+        if ((Pipeline.isDiscarded) || (0 == Pipeline.count))
+        {
+            break;
+        }
+
+        // Parse the contiguous data, curl only writes outside of it
+        dataPtr = &Pipeline.buffer[Pipeline.readOffset];
+        length = PIPELINE_BUFFER_SIZE - Pipeline.readOffset;
+        if (length > Pipeline.count)
+        {
+            length = Pipeline.count;
+        }
+
+        LE_FATAL_IF(0 != pthread_mutex_unlock(&Pipeline.mutex), "Could not unlock the mutex");
+
+        startTime = le_clk_GetRelativeTime();
+        result = lwm2mcore_PackageDownloaderReceiveData(dataPtr, length);
+        Pipeline.parseTime = le_clk_Add(Pipeline.parseTime,
+                                        le_clk_Sub(le_clk_GetRelativeTime(), startTime));
+
+        LE_FATAL_IF(0 != pthread_mutex_lock(&Pipeline.mutex), "Could not lock the mutex");
+
+        Pipeline.readOffset = (Pipeline.readOffset + length) % PIPELINE_BUFFER_SIZE;
+        Pipeline.count -= length;
+        Pipeline.parsedBytes += length;
+
+        if (DWL_OK != result)
+        {
+            LE_ERROR("Data processing stopped by DWL parser");
+            Pipeline.result = result;
+            pthread_cond_signal(&Pipeline.spaceCond);
+            break;
+        }
+
+        pthread_cond_signal(&Pipeline.spaceCond);
+    }
+
+    LE_FATAL_IF(0 != pthread_mutex_unlock(&Pipeline.mutex), "Could not unlock the mutex");
+
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start the download pipeline
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartPipeline
+(
+    void
+)
+{
+    Pipeline.readOffset = 0;
+    Pipeline.count = 0;
+    Pipeline.isEnded = false;
+    Pipeline.isDiscarded = false;
+    Pipeline.result = DWL_OK;
+    Pipeline.receivedBytes = 0;
+    Pipeline.parsedBytes = 0;
+    Pipeline.storedBytes = 0;
+    Pipeline.startTime = le_clk_GetRelativeTime();
+    Pipeline.receiveWaitTime = (le_clk_Time_t){ 0, 0 };
+    Pipeline.parseTime = (le_clk_Time_t){ 0, 0 };
+    Pipeline.storeTime = (le_clk_Time_t){ 0, 0 };
+
+    Pipeline.parserRef = le_thread_Create("DwlParser", ParserThread, NULL);
+    le_thread_SetJoinable(Pipeline.parserRef);
+    le_thread_Start(Pipeline.parserRef);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the download pipeline, once the data still in the ring buffer are parsed or dropped
+ *
+ * @return
+ *      - DWL_OK        All the data have been processed by the DWL parser
+ *      - DWL_FAULT     The DWL parser failed
+ */
+//--------------------------------------------------------------------------------------------------
+static lwm2mcore_DwlResult_t StopPipeline
+(
+    bool isDiscarded    ///< [IN] Drop the data not parsed yet
+)
+{
+    lwm2mcore_DwlResult_t result;
+    le_clk_Time_t totalTime;
+    le_clk_Time_t hashTime;
+
+    LE_FATAL_IF(0 != pthread_mutex_lock(&Pipeline.mutex), "Could not lock the mutex");
+    Pipeline.isEnded = true;
+    Pipeline.isDiscarded = isDiscarded;
+    pthread_cond_signal(&Pipeline.dataCond);
+    LE_FATAL_IF(0 != pthread_mutex_unlock(&Pipeline.mutex), "Could not unlock the mutex");
+
+    le_thread_Join(Pipeline.parserRef, NULL);
+    Pipeline.parserRef = NULL;
+
+    result = Pipeline.result;
+
+    // Each stage throughput is computed on the time it was busy, the slowest one bounding the
+    // download speed
+    totalTime = le_clk_Sub(le_clk_GetRelativeTime(), Pipeline.startTime);
+    hashTime = le_clk_Sub(Pipeline.parseTime, Pipeline.storeTime);
+
+    LE_INFO("Download pipeline: %"PRIu64" bytes in %ld.%03ld s (%u KiB/s)",
+            Pipeline.receivedBytes,
+            (long)totalTime.sec,
+            (long)(totalTime.usec / SECS_TO_MSECS),
+            GetKiBPerSec(Pipeline.parsedBytes, totalTime));
+    LE_INFO("Receive %u KiB/s (%ld.%03ld s waiting for the parser), "
+            "parse and hash %u KiB/s, store %u KiB/s",
+            GetKiBPerSec(Pipeline.receivedBytes,
+                         le_clk_Sub(totalTime, Pipeline.receiveWaitTime)),
+            (long)Pipeline.receiveWaitTime.sec,
+            (long)(Pipeline.receiveWaitTime.usec / SECS_TO_MSECS),
+            GetKiBPerSec(Pipeline.parsedBytes, hashTime),
+            GetKiBPerSec(Pipeline.storedBytes, Pipeline.storeTime));
+
+    return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Send downloaded data to the package downloader
@@ -139,13 +368,61 @@ static size_t Write
 {
     size_t count = size * nmemb;
     Package_t *pkgPtr = (Package_t *)contextPtr;
+    uint8_t* dataPtr = (uint8_t*)contentsPtr;
+    size_t remaining = count;
+    lwm2mcore_DwlResult_t result;
 
     pkgPtr->result = DWL_FAULT;
 
-    // Process the downloaded data
-    if (DWL_OK != lwm2mcore_PackageDownloaderReceiveData(contentsPtr, count))
+    // Queue the downloaded data for the parser thread
+    LE_FATAL_IF(0 != pthread_mutex_lock(&Pipeline.mutex), "Could not lock the mutex");
+
+    while ((remaining > 0) && (DWL_OK == Pipeline.result))
+    {
+        size_t writeOffset;
+        size_t length;
+
+        if (PIPELINE_BUFFER_SIZE == Pipeline.count)
+        {
+            le_clk_Time_t startTime = le_clk_GetRelativeTime();
+            pthread_cond_wait(&Pipeline.spaceCond, &Pipeline.mutex);
+            Pipeline.receiveWaitTime = le_clk_Add(Pipeline.receiveWaitTime,
+                                                  le_clk_Sub(le_clk_GetRelativeTime(), startTime));
+            continue;
+        }
+
+        // Fill the contiguous free space, the parser only reads the queued data
+        writeOffset = (Pipeline.readOffset + Pipeline.count) % PIPELINE_BUFFER_SIZE;
+        if (writeOffset >= Pipeline.readOffset)
+        {
+            length = PIPELINE_BUFFER_SIZE - writeOffset;
+        }
+        else
+        {
+            length = Pipeline.readOffset - writeOffset;
+        }
+        if (length > remaining)
+        {
+            length = remaining;
+        }
+
+        LE_FATAL_IF(0 != pthread_mutex_unlock(&Pipeline.mutex), "Could not unlock the mutex");
+        memcpy(&Pipeline.buffer[writeOffset], dataPtr, length);
+        LE_FATAL_IF(0 != pthread_mutex_lock(&Pipeline.mutex), "Could not lock the mutex");
+
+        Pipeline.count += length;
+        Pipeline.receivedBytes += length;
+        dataPtr += length;
+        remaining -= length;
+        pthread_cond_signal(&Pipeline.dataCond);
+    }
+
+    result = Pipeline.result;
+
+    LE_FATAL_IF(0 != pthread_mutex_unlock(&Pipeline.mutex), "Could not unlock the mutex");
+
+    if (DWL_OK != result)
     {
-        LE_ERROR("Data processing stopped by DWL parser");
         return 0;
     }
 
@@ -731,6 +1008,9 @@ lwm2mcore_DwlResult_t pkgDwlCb_Download
         pkgPtr->size = (size_t)startOffset;
     }
 
+    // Parse the received data in a dedicated thread
+    StartPipeline();
+
     while (retry < DWL_RETRIES)
     {
         LE_INFO("attempt %d", retry);
@@ -781,6 +1061,15 @@ lwm2mcore_DwlResult_t pkgDwlCb_Download
         }
     }
 
+    // Data left in the pipeline is useless if the download is aborted or suspended: a resumed
+    // download restarts from the last stored data
+    if ((DWL_OK != StopPipeline((DWL_ABORTED == pkgPtr->result)
+                                || (DWL_SUSPEND == pkgPtr->result)))
+        && (DWL_OK == pkgPtr->result))
+    {
+        pkgPtr->result = DWL_FAULT;
+    }
+
     return pkgPtr->result;
 }
 
@@ -802,10 +1091,15 @@ lwm2mcore_DwlResult_t pkgDwlCb_StoreRange
 {
     packageDownloader_DownloadCtx_t* dwlCtxPtr;
     ssize_t count;
+    le_clk_Time_t startTime;
 
     dwlCtxPtr = (packageDownloader_DownloadCtx_t*)ctxPtr;
 
+    // The write blocks while the FIFO is full, i.e. as long as the flash is busy
+    startTime = le_clk_GetRelativeTime();
     count = write(dwlCtxPtr->downloadFd, bufPtr, bufSize);
+    Pipeline.storeTime = le_clk_Add(Pipeline.storeTime,
+                                    le_clk_Sub(le_clk_GetRelativeTime(), startTime));
 
     if (-1 == count)
     {
@@ -831,6 +1125,8 @@ lwm2mcore_DwlResult_t pkgDwlCb_StoreRange
         return DWL_FAULT;
     }
 
+    Pipeline.storedBytes += count;
+
     return DWL_OK;
 }
 
@@ -696,6 +696,7 @@ static void ListTreeTest()
 
 le_cfg_ChangeHandlerRef_t handlerRef = NULL;
 le_cfg_ChangeHandlerRef_t rootHandlerRef = NULL;
+le_cfg_ChangeSetHandlerRef_t changeSetHandlerRef = NULL;
 
 static void ConfigCallbackFunction
 (
@@ -714,6 +715,25 @@ static void RootConfigCallbackFunction
 {
     LE_INFO("------- Root Callback Called ------------------------------------");
     le_cfg_RemoveChangeHandler(rootHandlerRef);
+}
+
+
+static void ChangeSetCallbackFunction
+(
+    const char* changedPathsPtr,
+    uint32_t changeCount,
+    void* contextPtr
+)
+{
+    LE_INFO("------- Change Set Callback Called: %u change(s) ----------------------", changeCount);
+    le_cfg_RemoveChangeSetHandler(changeSetHandlerRef);
+
+    // Both commits should have been rolled into the one notification.
+    LE_FATAL_IF(changeCount < 2, "Expected at least 2 changes, got %u.", changeCount);
+    LE_FATAL_IF(   (strstr(changedPathsPtr, "valueA") == NULL)
+                || (strstr(changedPathsPtr, "valueB") == NULL),
+                "Unexpected changed paths: '%s'.",
+                changedPathsPtr);
 
     exit(EXIT_SUCCESS);
 }
@@ -730,11 +750,21 @@ static void CallbackTest()
 
     handlerRef = le_cfg_AddChangeHandler(pathBuffer, ConfigCallbackFunction, NULL);
     rootHandlerRef = le_cfg_AddChangeHandler("/", RootConfigCallbackFunction, NULL);
+    changeSetHandlerRef = le_cfg_AddChangeSetHandler(pathBuffer,
+                                                     500,
+                                                     ChangeSetCallbackFunction,
+                                                     NULL);
 
     le_cfg_IteratorRef_t iterRef = le_cfg_CreateWriteTxn(pathBuffer);
 
     le_cfg_SetString(iterRef, "valueA", "aNewValue");
     le_cfg_CommitTxn(iterRef);
+
+    // A second commit inside the debounce window.
+    iterRef = le_cfg_CreateWriteTxn(pathBuffer);
+
+    le_cfg_SetString(iterRef, "valueB", "anotherNewValue");
+    le_cfg_CommitTxn(iterRef);
 }
 
 
@@ -0,0 +1,224 @@
+/**
+ * Unit tests and throughput benchmark of le_crc_Crc32().
+ *
+ * le_crc_Crc32() picks an accelerated implementation for the CPU it runs on, so its results are
+ * cross-validated against the classic byte-at-a-time table lookup for all alignments, lengths and
+ * ways of splitting a buffer.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+
+#include <legato.h>
+
+#include <CUnit/Console.h>
+#include <CUnit/Basic.h>
+
+// Size of the buffer used for the cross-validation.
+#define CHECK_BUFFER_BYTES  4096
+
+// Size of the buffer and number of passes used for the benchmark.
+#define BENCH_BUFFER_BYTES  (4 * 1024 * 1024)
+#define BENCH_PASSES        16
+
+// Byte-at-a-time reference table, built from the polynomial.
+static uint32_t RefTable[256];
+
+static uint8_t CheckBuffer[CHECK_BUFFER_BYTES + 16];
+
+/* The suite initialization function.
+ * Builds the reference table and fills the test buffer.
+ * Returns zero on success, non-zero otherwise.
+ */
+int init_suite(void)
+{
+    uint32_t i, bit;
+
+    for (i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320U) : (crc >> 1);
+        }
+        RefTable[i] = crc;
+    }
+
+    srand(1234);
+    for (i = 0; i < sizeof(CheckBuffer); i++)
+    {
+        CheckBuffer[i] = (uint8_t)rand();
+    }
+
+    return 0;
+}
+
+/* The suite cleanup function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int clean_suite(void)
+{
+    return 0;
+}
+
+static uint32_t RefCrc32(const uint8_t* bufPtr, size_t size, uint32_t crc)
+{
+    for (; size > 0; size--)
+    {
+        crc = (crc >> 8) ^ RefTable[(crc ^ *bufPtr++) & 0xFF];
+    }
+    return crc;
+}
+
+void test_le_crc_KnownAnswer(void)
+{
+    uint8_t check[] = "123456789";
+    uint8_t zeros[32] = { 0 };
+
+    CU_ASSERT_EQUAL(le_crc_Crc32(check, 9, LE_CRC_START_CRC32) ^ 0xFFFFFFFFU, 0xCBF43926U);
+    CU_ASSERT_EQUAL(le_crc_Crc32(zeros, sizeof(zeros), LE_CRC_START_CRC32) ^ 0xFFFFFFFFU,
+                    0x190A55ADU);
+    CU_ASSERT_EQUAL(le_crc_Crc32(check, 0, 0x12345678U), 0x12345678U);
+
+    CU_PASS("le_crc_Crc32 known answers");
+}
+
+void test_le_crc_AlignmentsAndLengths(void)
+{
+    size_t offset, size;
+    int failures = 0;
+
+    for (offset = 0; offset < 16; offset++)
+    {
+        for (size = 0; size <= 300; size++)
+        {
+            if (le_crc_Crc32(CheckBuffer + offset, size, LE_CRC_START_CRC32) !=
+                RefCrc32(CheckBuffer + offset, size, LE_CRC_START_CRC32))
+            {
+                LE_ERROR("Mismatch at offset %zu, size %zu", offset, size);
+                failures++;
+            }
+        }
+
+        for (size = 1000; size <= CHECK_BUFFER_BYTES; size += 997)
+        {
+            if (le_crc_Crc32(CheckBuffer + offset, size, 0x5A5A5A5AU) !=
+                RefCrc32(CheckBuffer + offset, size, 0x5A5A5A5AU))
+            {
+                LE_ERROR("Mismatch at offset %zu, size %zu", offset, size);
+                failures++;
+            }
+        }
+    }
+
+    CU_ASSERT_EQUAL(failures, 0);
+}
+
+void test_le_crc_Chained(void)
+{
+    uint32_t whole = RefCrc32(CheckBuffer, CHECK_BUFFER_BYTES, LE_CRC_START_CRC32);
+    size_t split;
+    int failures = 0;
+
+    for (split = 0; split <= CHECK_BUFFER_BYTES; split += 61)
+    {
+        uint32_t crc = le_crc_Crc32(CheckBuffer, split, LE_CRC_START_CRC32);
+        crc = le_crc_Crc32(CheckBuffer + split, CHECK_BUFFER_BYTES - split, crc);
+
+        if (crc != whole)
+        {
+            LE_ERROR("Mismatch when split at %zu", split);
+            failures++;
+        }
+    }
+
+    CU_ASSERT_EQUAL(failures, 0);
+}
+
+static double MiBPerSec(le_clk_Time_t elapsed)
+{
+    double seconds = elapsed.sec + elapsed.usec / 1000000.0;
+
+    if (seconds <= 0)
+    {
+        return 0;
+    }
+    return (double)BENCH_BUFFER_BYTES * BENCH_PASSES / (1024 * 1024) / seconds;
+}
+
+void test_le_crc_Throughput(void)
+{
+    uint8_t* bufPtr = malloc(BENCH_BUFFER_BYTES);
+    uint32_t refCrc = LE_CRC_START_CRC32;
+    uint32_t crc = LE_CRC_START_CRC32;
+    le_clk_Time_t start;
+    le_clk_Time_t refElapsed, elapsed;
+    int pass;
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(bufPtr);
+    memset(bufPtr, 0xA5, BENCH_BUFFER_BYTES);
+
+    start = le_clk_GetRelativeTime();
+    for (pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        refCrc = RefCrc32(bufPtr, BENCH_BUFFER_BYTES, refCrc);
+    }
+    refElapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+
+    start = le_clk_GetRelativeTime();
+    for (pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        crc = le_crc_Crc32(bufPtr, BENCH_BUFFER_BYTES, crc);
+    }
+    elapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+
+    CU_ASSERT_EQUAL(crc, refCrc);
+
+    LE_INFO("CRC32 throughput: byte table %.1f MiB/s, le_crc_Crc32 %.1f MiB/s",
+            MiBPerSec(refElapsed), MiBPerSec(elapsed));
+    printf("CRC32 throughput: byte table %.1f MiB/s, le_crc_Crc32 %.1f MiB/s\n",
+           MiBPerSec(refElapsed), MiBPerSec(elapsed));
+
+    free(bufPtr);
+}
+
+COMPONENT_INIT
+{
+    CU_TestInfo test_array[] = {
+    { "CRC32 known answers",                test_le_crc_KnownAnswer },
+    { "CRC32 all alignments and lengths",   test_le_crc_AlignmentsAndLengths },
+    { "CRC32 computed in two parts",        test_le_crc_Chained },
+    { "CRC32 throughput",                   test_le_crc_Throughput },
+    CU_TEST_INFO_NULL,
+    };
+
+    CU_SuiteInfo suites[] = {
+    { "CRC32 tests"                         , init_suite, clean_suite, test_array },
+    CU_SUITE_INFO_NULL,
+    };
+
+    /* initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        exit(CU_get_error());
+
+    if ( CUE_SUCCESS != CU_register_suites(suites))
+    {
+        CU_cleanup_registry();
+        exit(CU_get_error());
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+
+    // Output summary of failures, if there were any
+    if ( CU_get_number_of_failures() > 0 )
+    {
+        fprintf(stdout,"\n [START]List of Failure :\n");
+        CU_basic_show_failures(CU_get_failure_list());
+        fprintf(stdout,"\n [STOP]List of Failure\n");
+    }
+
+    CU_cleanup_registry();
+    exit(CU_get_error());
+}
@@ -0,0 +1,732 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * Unit tests of the Update Daemon's streaming tarball extractor (untar.c).
+ *
+ * Tarballs are built in memory, entry by entry, and fed to an extractor in small chunks so that
+ * headers and data are split across calls.  Malicious entries must be rejected without anything
+ * being written outside the unpack directory.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "untar.h"
+#include <bzlib.h>
+#include <zlib.h>
+
+
+/// Size of a tar block.
+#define BLOCK_BYTES     512
+
+/// Maximum size of a tarball built by the tests.
+#define MAX_TAR_BYTES   (64 * 1024)
+
+/// Number of bytes fed to the extractor at a time.
+#define CHUNK_BYTES     77
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tarball being built.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t Tar[MAX_TAR_BYTES];
+static size_t TarBytes = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compressed tarball.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t Packed[MAX_TAR_BYTES];
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Test directory, and the unpack and outside directories in it.
+ */
+//--------------------------------------------------------------------------------------------------
+static char TestDir[] = "/tmp/untarTestXXXXXX";
+static char UnpackDir[PATH_MAX];
+static char OutsideDir[PATH_MAX];
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the checksum of a header block.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SetChecksum
+(
+    uint8_t* hdrPtr
+)
+{
+    unsigned int sum = 0;
+    size_t i;
+
+    memset(hdrPtr + 148, ' ', 8);
+    for (i = 0; i < BLOCK_BYTES; i++)
+    {
+        sum += hdrPtr[i];
+    }
+    snprintf((char*)hdrPtr + 148, 8, "%06o", sum);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Appends a header block to the tarball.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddHeader
+(
+    const char* namePtr,
+    char type,
+    size_t size,
+    const char* linkNamePtr
+)
+{
+    uint8_t* hdrPtr = Tar + TarBytes;
+
+    LE_ASSERT(TarBytes + BLOCK_BYTES <= sizeof(Tar));
+    memset(hdrPtr, 0, BLOCK_BYTES);
+
+    strncpy((char*)hdrPtr, namePtr, 100);
+    snprintf((char*)hdrPtr + 100, 8, "%07o", (type == '5') ? 0755 : 0644);
+    snprintf((char*)hdrPtr + 108, 8, "%07o", 0);
+    snprintf((char*)hdrPtr + 116, 8, "%07o", 0);
+    snprintf((char*)hdrPtr + 124, 12, "%011zo", size);
+    snprintf((char*)hdrPtr + 136, 12, "%011o", 0);
+    hdrPtr[156] = type;
+    if (linkNamePtr != NULL)
+    {
+        strncpy((char*)hdrPtr + 157, linkNamePtr, 100);
+    }
+    memcpy(hdrPtr + 257, "ustar\0" "00", 8);
+
+    SetChecksum(hdrPtr);
+
+    TarBytes += BLOCK_BYTES;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Appends the data of an entry to the tarball, padded to a whole number of blocks.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddData
+(
+    const void* dataPtr,
+    size_t size
+)
+{
+    size_t paddedSize = ((size + BLOCK_BYTES - 1) / BLOCK_BYTES) * BLOCK_BYTES;
+
+    LE_ASSERT(TarBytes + paddedSize <= sizeof(Tar));
+
+    memcpy(Tar + TarBytes, dataPtr, size);
+    memset(Tar + TarBytes + size, 0, paddedSize - size);
+    TarBytes += paddedSize;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Appends a regular file to the tarball.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddFile
+(
+    const char* namePtr,
+    const char* contentPtr
+)
+{
+    AddHeader(namePtr, '0', strlen(contentPtr), NULL);
+    AddData(contentPtr, strlen(contentPtr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Appends a pax extended header with a single record to the tarball.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddPaxRecord
+(
+    const char* keyPtr,
+    const char* valuePtr
+)
+{
+    char record[4096];
+    size_t size = strlen(keyPtr) + strlen(valuePtr) + 3;
+    int len;
+
+    // The length field counts its own digits.
+    for (len = 1; snprintf(NULL, 0, "%zu", size + len) != len; len++)
+    {
+    }
+    size += len;
+
+    LE_ASSERT((size_t)snprintf(record, sizeof(record), "%zu %s=%s\n", size, keyPtr, valuePtr)
+              == size);
+
+    AddHeader("PaxHeader", 'x', size, NULL);
+    AddData(record, size);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts a new tarball.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartTar
+(
+    void
+)
+{
+    TarBytes = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Appends the end of archive marker to the tarball.
+ */
+//--------------------------------------------------------------------------------------------------
+static void EndTar
+(
+    void
+)
+{
+    LE_ASSERT(TarBytes + (2 * BLOCK_BYTES) <= sizeof(Tar));
+    memset(Tar + TarBytes, 0, 2 * BLOCK_BYTES);
+    TarBytes += 2 * BLOCK_BYTES;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds data to a new extractor of the unpack directory, in chunks.
+ *
+ * @return The first error returned by the extractor, or the result of untar_Finish().
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Extract
+(
+    const uint8_t* dataPtr,
+    size_t size,
+    const char** compressionNamePtr     ///< [OUT] Compression detected, or NULL.
+)
+{
+    untar_Ref_t untarRef = untar_Create(UnpackDir);
+    le_result_t result = LE_OK;
+    size_t offset;
+
+    for (offset = 0; (offset < size) && (result == LE_OK); offset += CHUNK_BYTES)
+    {
+        size_t chunkSize = ((size - offset) < CHUNK_BYTES) ? (size - offset) : CHUNK_BYTES;
+
+        result = untar_Write(untarRef, dataPtr + offset, chunkSize);
+    }
+
+    if (result == LE_OK)
+    {
+        result = untar_Finish(untarRef);
+    }
+
+    if (compressionNamePtr != NULL)
+    {
+        *compressionNamePtr = untar_GetCompressionName(untarRef);
+    }
+
+    untar_Delete(untarRef);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds the tarball being built to a new extractor of the unpack directory.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ExtractTar
+(
+    void
+)
+{
+    return Extract(Tar, TarBytes, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Empties the unpack and outside directories.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ResetDirs
+(
+    void
+)
+{
+    LE_ASSERT(le_dir_RemoveRecursive(UnpackDir) == LE_OK);
+    LE_ASSERT(le_dir_RemoveRecursive(OutsideDir) == LE_OK);
+    LE_ASSERT(le_dir_Make(UnpackDir, S_IRWXU) == LE_OK);
+    LE_ASSERT(le_dir_Make(OutsideDir, S_IRWXU) == LE_OK);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks the content of a file relative to a directory.
+ *
+ * @return true if the file exists and has the expected content.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsFileContent
+(
+    const char* dirPtr,
+    const char* namePtr,
+    const char* contentPtr
+)
+{
+    char path[PATH_MAX];
+    char buf[4096];
+    ssize_t size;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s", dirPtr, namePtr);
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    size = read(fd, buf, sizeof(buf));
+    close(fd);
+
+    return (size == (ssize_t)strlen(contentPtr)) && (memcmp(buf, contentPtr, size) == 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether anything exists at a path relative to a directory.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool Exists
+(
+    const char* dirPtr,
+    const char* namePtr
+)
+{
+    char path[PATH_MAX];
+    struct stat st;
+
+    snprintf(path, sizeof(path), "%s/%s", dirPtr, namePtr);
+
+    return lstat(path, &st) == 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Regular files, directories, symlinks and hard links are extracted, from plain, gzip and bzip2
+ * tarballs.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestEntries
+(
+    void
+)
+{
+    const char* compressionPtr = NULL;
+    char target[PATH_MAX];
+    struct stat st;
+    z_stream zStream;
+    unsigned int bzSize = sizeof(Packed);
+
+    LE_INFO("======== TestEntries ========");
+
+    StartTar();
+    AddHeader("./dir/", '5', 0, NULL);
+    AddFile("./dir/file", "content of file");
+    AddHeader("./dir/symlink", '2', 0, "file");
+    AddHeader("./dir/hardlink", '1', 0, "./dir/file");
+    AddFile("/absolute/file", "absolute");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(Extract(Tar, TarBytes, &compressionPtr) == LE_OK);
+    LE_TEST(strcmp(compressionPtr, "none") == 0);
+    LE_TEST(IsFileContent(UnpackDir, "dir/file", "content of file"));
+    LE_TEST(IsFileContent(UnpackDir, "dir/hardlink", "content of file"));
+
+    snprintf(target, sizeof(target), "%s/dir/symlink", UnpackDir);
+    LE_TEST((lstat(target, &st) == 0) && S_ISLNK(st.st_mode));
+
+    // Absolute names are extracted in the unpack directory.
+    LE_TEST(IsFileContent(UnpackDir, "absolute/file", "absolute"));
+
+    // bzip2
+    LE_ASSERT(BZ2_bzBuffToBuffCompress((char*)Packed, &bzSize, (char*)Tar, TarBytes, 9, 0, 0)
+              == BZ_OK);
+    ResetDirs();
+    LE_TEST(Extract(Packed, bzSize, &compressionPtr) == LE_OK);
+    LE_TEST(strcmp(compressionPtr, "bzip2") == 0);
+    LE_TEST(IsFileContent(UnpackDir, "dir/hardlink", "content of file"));
+
+    // gzip
+    memset(&zStream, 0, sizeof(zStream));
+    LE_ASSERT(deflateInit2(&zStream, 9, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY)
+              == Z_OK);
+    zStream.next_in = Tar;
+    zStream.avail_in = TarBytes;
+    zStream.next_out = Packed;
+    zStream.avail_out = sizeof(Packed);
+    LE_ASSERT(deflate(&zStream, Z_FINISH) == Z_STREAM_END);
+    deflateEnd(&zStream);
+
+    ResetDirs();
+    LE_TEST(Extract(Packed, zStream.total_out, &compressionPtr) == LE_OK);
+    LE_TEST(strcmp(compressionPtr, "gzip") == 0);
+    LE_TEST(IsFileContent(UnpackDir, "dir/hardlink", "content of file"));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Names with ".." components are rejected.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestDotDot
+(
+    void
+)
+{
+    static const char* names[] =
+    {
+        "../outside/file",
+        "dir/../../outside/file",
+        "/../outside/file",
+        "..",
+    };
+    size_t i;
+
+    LE_INFO("======== TestDotDot ========");
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(names); i++)
+    {
+        StartTar();
+        AddFile(names[i], "escaped");
+        EndTar();
+
+        ResetDirs();
+        LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+        LE_TEST(!Exists(OutsideDir, "file"));
+    }
+
+    // Same through a pax path.
+    StartTar();
+    AddPaxRecord("path", "dir/../../outside/file");
+    AddFile("file", "escaped");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+    LE_TEST(!Exists(OutsideDir, "file"));
+    LE_TEST(!Exists(UnpackDir, "file"));
+
+    // ".." is only rejected as a whole component.
+    StartTar();
+    AddFile("dir/..file", "kept");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_OK);
+    LE_TEST(IsFileContent(UnpackDir, "dir/..file", "kept"));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entries under a symlink extracted earlier are rejected, as the symlink may point anywhere.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestSymlinkEscape
+(
+    void
+)
+{
+    LE_INFO("======== TestSymlinkEscape ========");
+
+    // Regular file written through a symlink to a directory.
+    StartTar();
+    AddHeader("escape", '2', 0, OutsideDir);
+    AddFile("escape/file", "escaped");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+    LE_TEST(!Exists(OutsideDir, "file"));
+
+    // Same with a relative symlink, and a directory entry.
+    StartTar();
+    AddHeader("dir/", '5', 0, NULL);
+    AddHeader("dir/escape", '2', 0, "../../outside");
+    AddHeader("dir/escape/subdir/", '5', 0, NULL);
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+    LE_TEST(!Exists(OutsideDir, "subdir"));
+
+    // A regular file replaces a symlink instead of being written through it.
+    StartTar();
+    AddHeader("file", '2', 0, "../outside/target");
+    AddFile("file", "replaced");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_OK);
+    LE_TEST(IsFileContent(UnpackDir, "file", "replaced"));
+    LE_TEST(!Exists(OutsideDir, "target"));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hard links to files outside the unpack directory are rejected.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestHardLinkEscape
+(
+    void
+)
+{
+    char path[PATH_MAX];
+    int fd;
+
+    LE_INFO("======== TestHardLinkEscape ========");
+
+    ResetDirs();
+    snprintf(path, sizeof(path), "%s/secret", OutsideDir);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    LE_ASSERT(fd != -1);
+    LE_ASSERT(write(fd, "secret", 6) == 6);
+    close(fd);
+
+    // Target outside by name
+    StartTar();
+    AddHeader("link", '1', 0, "../outside/secret");
+    EndTar();
+
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+    LE_TEST(!Exists(UnpackDir, "link"));
+
+    // Target outside through a symlink extracted earlier
+    StartTar();
+    AddHeader("escape", '2', 0, OutsideDir);
+    AddHeader("link", '1', 0, "escape/secret");
+    EndTar();
+
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+    LE_TEST(!Exists(UnpackDir, "link"));
+
+    // Absolute targets are names in the tarball, so they resolve in the unpack directory.
+    StartTar();
+    AddFile("file", "inside");
+    AddHeader("link", '1', 0, "/file");
+    EndTar();
+
+    LE_TEST(ExtractTar() == LE_OK);
+    LE_TEST(IsFileContent(UnpackDir, "link", "inside"));
+    LE_TEST(IsFileContent(OutsideDir, "secret", "secret"));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Truncated and damaged tarballs are rejected.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestTruncated
+(
+    void
+)
+{
+    const char* compressionPtr = NULL;
+    unsigned int bzSize = sizeof(Packed);
+
+    LE_INFO("======== TestTruncated ========");
+
+    StartTar();
+    AddFile("file", "content of file");
+    AddFile("other", "content of other");
+    EndTar();
+
+    // Inside a header, inside file data, and before the end of archive marker.
+    ResetDirs();
+    LE_TEST(Extract(Tar, 300, NULL) == LE_FORMAT_ERROR);
+    LE_TEST(Extract(Tar, BLOCK_BYTES + 5, NULL) == LE_FORMAT_ERROR);
+    LE_TEST(Extract(Tar, 4 * BLOCK_BYTES, NULL) == LE_FORMAT_ERROR);
+    LE_TEST(Extract(Tar, 0, NULL) == LE_FORMAT_ERROR);
+
+    // Bad header checksum.
+    Tar[BLOCK_BYTES * 2] ^= 0x01;
+    LE_TEST(Extract(Tar, TarBytes, NULL) == LE_FORMAT_ERROR);
+    Tar[BLOCK_BYTES * 2] ^= 0x01;
+
+    // Bad numeric field, with a valid checksum.
+    StartTar();
+    AddHeader("file", '0', 0, NULL);
+    memcpy(Tar + 124, "12345678z01", 11);
+    SetChecksum(Tar);
+    EndTar();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+
+    // Truncated compressed stream.
+    StartTar();
+    AddFile("file", "content of file");
+    EndTar();
+    LE_ASSERT(BZ2_bzBuffToBuffCompress((char*)Packed, &bzSize, (char*)Tar, TarBytes, 9, 0, 0)
+              == BZ_OK);
+    LE_TEST(Extract(Packed, bzSize / 2, &compressionPtr) == LE_FORMAT_ERROR);
+    LE_TEST(strcmp(compressionPtr, "bzip2") == 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Names longer than the header fields are taken from pax headers and GNU long name entries.
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestLongNames
+(
+    void
+)
+{
+    char longName[300];
+    char longLink[300];
+    char path[PATH_MAX];
+    char target[PATH_MAX];
+    ssize_t size;
+
+    LE_INFO("======== TestLongNames ========");
+
+    // 30 directories of 9 characters
+    longName[0] = '\0';
+    while (strlen(longName) < 270)
+    {
+        strcat(longName, "directory/");
+    }
+    strcat(longName, "file");
+    LE_ASSERT(strlen(longName) > 255);
+
+    StartTar();
+    AddPaxRecord("path", longName);
+    AddFile("truncated-name", "pax long name");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_OK);
+    LE_TEST(IsFileContent(UnpackDir, longName, "pax long name"));
+    LE_TEST(!Exists(UnpackDir, "truncated-name"));
+
+    // The long name only applies to the next entry.
+    StartTar();
+    AddPaxRecord("path", longName);
+    AddFile("first", "first");
+    AddFile("second", "second");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_OK);
+    LE_TEST(IsFileContent(UnpackDir, longName, "first"));
+    LE_TEST(IsFileContent(UnpackDir, "second", "second"));
+
+    // GNU long name and long link
+    snprintf(longLink, sizeof(longLink), "%s", longName);
+    longLink[strlen(longLink) - strlen("file")] = '\0';
+    strcat(longLink, "target");
+
+    StartTar();
+    AddHeader("././@LongLink", 'L', strlen(longName) + 1, NULL);
+    AddData(longName, strlen(longName) + 1);
+    AddFile("truncated-name", "gnu long name");
+    AddHeader("././@LongLink", 'K', strlen(longLink) + 1, NULL);
+    AddData(longLink, strlen(longLink) + 1);
+    AddHeader("symlink", '2', 0, "truncated-link");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_OK);
+    LE_TEST(IsFileContent(UnpackDir, longName, "gnu long name"));
+
+    snprintf(path, sizeof(path), "%s/symlink", UnpackDir);
+    size = readlink(path, target, sizeof(target) - 1);
+    LE_TEST((size == (ssize_t)strlen(longLink)) && (memcmp(target, longLink, size) == 0));
+
+    // Malformed pax records
+    StartTar();
+    AddHeader("PaxHeader", 'x', 12, NULL);
+    AddData("99 path=abc\n", 12);
+    AddFile("file", "content");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+    LE_TEST(!Exists(UnpackDir, "file"));
+
+    StartTar();
+    AddHeader("PaxHeader", 'x', 11, NULL);
+    AddData("11 pathabc\n", 11);
+    AddFile("file", "content");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+
+    // Pax name longer than a path can be
+    memset(path, 'a', sizeof(path) - 1);
+    path[sizeof(path) - 1] = '\0';
+    path[2000] = '\0';
+
+    StartTar();
+    AddPaxRecord("path", path);
+    AddFile("file", "content");
+    EndTar();
+
+    ResetDirs();
+    LE_TEST(ExtractTar() == LE_FORMAT_ERROR);
+}
+
+
+COMPONENT_INIT
+{
+    LE_TEST_INIT;
+
+    LE_INFO("=============== Start untarTest =====================");
+
+    untar_Init();
+
+    LE_ASSERT(mkdtemp(TestDir) != NULL);
+    snprintf(UnpackDir, sizeof(UnpackDir), "%s/unpack", TestDir);
+    snprintf(OutsideDir, sizeof(OutsideDir), "%s/outside", TestDir);
+
+    TestEntries();
+    TestDotDot();
+    TestSymlinkEscape();
+    TestHardLinkEscape();
+    TestTruncated();
+    TestLongNames();
+
+    LE_ASSERT(le_dir_RemoveRecursive(TestDir) == LE_OK);
+
+    LE_INFO("=============== untarTest done ===================");
+
+    LE_TEST_EXIT;
+}
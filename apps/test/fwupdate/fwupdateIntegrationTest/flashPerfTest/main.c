@@ -0,0 +1,507 @@
+ /**
+  * This module measures the write throughput of the flash PA, with and without the I/O thread
+  * (PA_FLASH_OPENMODE_ASYNC) and with the batched UBI header updates, and the time to scan the UBI
+  * partition with and without the UBI scan index.
+  *
+  * It writes, reads back and checks a pattern on the given MTD, so the MTD content is LOST. Use a
+  * spare partition or a NAND simulator, e.g.:
+  * @verbatim
+  * $ modprobe nandsim first_id_byte=0x2c second_id_byte=0xac third_id_byte=0x90 \
+  *                    fourth_id_byte=0x26
+  * $ cat /proc/mtd
+  * $ app start flashPerfTest
+  * $ app runProc flashPerfTest --exe=flashPerfTest -- <mtdNum> [<sizeMiB> [<delayMs>]]
+  * @endverbatim
+  *
+  * <delayMs> is the time spent to get the data of each erase block, to stand for the download
+  * (default 0). The I/O thread overlaps the flash operations with it.
+  *
+  * To measure the UBI scan on a 256 MiB partition, load nandsim with fourth_id_byte=0x15 (2 KiB
+  * pages, 128 KiB blocks, 256 MiB).
+  *
+  * It also checks that a UBI volume extended by an update interrupted before its deferred UBI
+  * headers are written can be scanned and resumed.
+  *
+  * Copyright (C) Sierra Wireless Inc.
+  *
+  */
+
+#include "legato.h"
+#include "pa_flash.h"
+#include "pa_flash_local.h"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Default size written by each test, in MiB
+ */
+//--------------------------------------------------------------------------------------------------
+#define DEFAULT_SIZE_MIB    16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * UBI volume ID and name used by the test
+ */
+//--------------------------------------------------------------------------------------------------
+#define UBI_VOL_ID          0
+#define UBI_VOL_NAME        "flashPerf"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Path of the UBI scan index kept by the flash PA
+ */
+//--------------------------------------------------------------------------------------------------
+#define UBI_INDEX_PATH      "/tmp/.pa_flash_ubi_mtd%d_%x.idx"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of scans measured with the UBI scan index
+ */
+//--------------------------------------------------------------------------------------------------
+#define NB_INDEXED_SCANS    4
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * MTD number and number of blocks to write
+ */
+//--------------------------------------------------------------------------------------------------
+static int MtdNum;
+static uint32_t NbBlk;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Time to get the data of each block, in ms
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t DelayMs;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffers for one erase block
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t* DataPtr;
+static uint8_t* CheckPtr;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill the buffer with the pattern of the given block. The CRC computed on it stands for the
+ * processing done on the downloaded data by the firmware update.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FillBlock
+(
+    uint8_t* bufPtr,
+    uint32_t blk,
+    size_t size
+)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        bufPtr[i] = (uint8_t)((i >> 8) ^ i ^ (blk * 0x3D));
+    }
+    (void)le_crc_Crc32(bufPtr, size, LE_CRC_START_CRC32);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the data of the given block, as the download would
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetBlock
+(
+    uint8_t* bufPtr,
+    uint32_t blk,
+    size_t size
+)
+{
+    FillBlock(bufPtr, blk, size);
+    if (DelayMs)
+    {
+        usleep(DelayMs * 1000);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the throughput of a test
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintRate
+(
+    const char* namePtr,
+    le_clk_Time_t start,
+    size_t size
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+    double seconds = elapsed.sec + elapsed.usec / 1000000.0;
+
+    LE_INFO("%s: %zu bytes in %.3f s: %.2f MB/s",
+            namePtr, size, seconds, (seconds > 0) ? (size / seconds / 1000000.0) : 0);
+    fprintf(stderr, "%s: %zu bytes in %.3f s: %.2f MB/s\n",
+            namePtr, size, seconds, (seconds > 0) ? (size / seconds / 1000000.0) : 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Print the duration of a test
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintTime
+(
+    const char* namePtr,
+    le_clk_Time_t start
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), start);
+    double ms = elapsed.sec * 1000.0 + elapsed.usec / 1000.0;
+
+    LE_INFO("%s: %.1f ms", namePtr, ms);
+    fprintf(stderr, "%s: %.1f ms\n", namePtr, ms);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the pattern on the raw MTD like the firmware update does, with or without the I/O thread
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestRawWrite
+(
+    bool isAsync
+)
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    le_clk_Time_t start;
+    uint32_t blk;
+    size_t size;
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum,
+                               PA_FLASH_OPENMODE_WRITEONLY | PA_FLASH_OPENMODE_MARKBAD |
+                               (isAsync ? PA_FLASH_OPENMODE_ASYNC : 0),
+                               &desc, &infoPtr));
+    LE_ASSERT_OK(pa_flash_Scan(desc, NULL));
+    LE_ASSERT(NbBlk <= infoPtr->nbLeb);
+    size = (size_t)NbBlk * infoPtr->eraseSize;
+
+    start = le_clk_GetRelativeTime();
+    if (isAsync)
+    {
+        // Erase the next block while the current one is written, as partition.c does
+        LE_ASSERT_OK(pa_flash_SeekAtOffset(desc, 0));
+        LE_ASSERT_OK(pa_flash_EraseNextBlocks(desc, 1));
+        for (blk = 0; blk < NbBlk; blk++)
+        {
+            GetBlock(DataPtr, blk, infoPtr->eraseSize);
+            LE_ASSERT_OK(pa_flash_Flush(desc));
+            LE_ASSERT_OK(pa_flash_Write(desc, DataPtr, infoPtr->eraseSize));
+            if ((blk + 1) < NbBlk)
+            {
+                LE_ASSERT_OK(pa_flash_EraseNextBlocks(desc, 1));
+            }
+        }
+        LE_ASSERT_OK(pa_flash_Flush(desc));
+    }
+    else
+    {
+        for (blk = 0; blk < NbBlk; blk++)
+        {
+            LE_ASSERT_OK(pa_flash_EraseBlock(desc, blk));
+        }
+        LE_ASSERT_OK(pa_flash_SeekAtOffset(desc, 0));
+        for (blk = 0; blk < NbBlk; blk++)
+        {
+            GetBlock(DataPtr, blk, infoPtr->eraseSize);
+            LE_ASSERT_OK(pa_flash_Write(desc, DataPtr, infoPtr->eraseSize));
+        }
+    }
+    LE_ASSERT_OK(pa_flash_Close(desc));
+    PrintRate(isAsync ? "Raw write, I/O thread" : "Raw write", start, size);
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READONLY, &desc, &infoPtr));
+    LE_ASSERT_OK(pa_flash_Scan(desc, NULL));
+    for (blk = 0; blk < NbBlk; blk++)
+    {
+        FillBlock(DataPtr, blk, infoPtr->eraseSize);
+        LE_ASSERT_OK(pa_flash_ReadAtBlock(desc, blk, CheckPtr, infoPtr->eraseSize));
+        LE_ASSERT(0 == memcmp(DataPtr, CheckPtr, infoPtr->eraseSize));
+    }
+    LE_ASSERT_OK(pa_flash_Close(desc));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the pattern in a static UBI volume extended block after block, like a delta patch does
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestUbiWrite
+(
+    void
+)
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    le_clk_Time_t start;
+    uint32_t blk, dataSize;
+    size_t size;
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READWRITE | PA_FLASH_OPENMODE_MARKBAD,
+                               &desc, &infoPtr));
+    LE_ASSERT_OK(pa_flash_CreateUbi(desc, true));
+    LE_ASSERT_OK(pa_flash_CreateUbiVolume(desc, UBI_VOL_ID, UBI_VOL_NAME,
+                                          PA_FLASH_VOLUME_STATIC, 0));
+    dataSize = infoPtr->eraseSize - (2 * infoPtr->writeSize);
+    // Keep room for the UBI layout and wear-levelling blocks
+    if (NbBlk + 16 > infoPtr->nbBlk)
+    {
+        NbBlk = infoPtr->nbBlk - 16;
+    }
+
+    start = le_clk_GetRelativeTime();
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    for (blk = 0; blk < NbBlk; blk++)
+    {
+        GetBlock(DataPtr, blk, dataSize);
+        LE_ASSERT_OK(pa_flash_WriteUbiAtBlock(desc, blk, DataPtr, dataSize, true));
+    }
+    LE_ASSERT_OK(pa_flash_AdjustUbiSize(desc, (size_t)NbBlk * dataSize));
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+    PrintRate("UBI static volume write", start, (size_t)NbBlk * dataSize);
+
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    for (blk = 0; blk < NbBlk; blk++)
+    {
+        FillBlock(DataPtr, blk, dataSize);
+        size = dataSize;
+        LE_ASSERT_OK(pa_flash_ReadUbiAtBlock(desc, blk, CheckPtr, &size));
+        LE_ASSERT(size == dataSize);
+        LE_ASSERT(0 == memcmp(DataPtr, CheckPtr, dataSize));
+    }
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+    LE_ASSERT_OK(pa_flash_Close(desc));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Scan the UBI volume written by TestUbiWrite without the UBI scan index, then with it, and check
+ * that both scans give the same volume
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestUbiScan
+(
+    void
+)
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    le_clk_Time_t start;
+    char path[PATH_MAX];
+    uint32_t freeBlock, volBlock, volSize;
+    uint32_t freeBlockIdx, volBlockIdx, volSizeIdx;
+    int i;
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READONLY, &desc, &infoPtr));
+    snprintf(path, sizeof(path), UBI_INDEX_PATH, MtdNum, infoPtr->startOffset);
+    unlink(path);
+
+    start = le_clk_GetRelativeTime();
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    PrintTime("UBI scan, no index", start);
+    LE_ASSERT_OK(pa_flash_GetUbiInfo(desc, &freeBlock, &volBlock, &volSize));
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+
+    for (i = 0; i < NB_INDEXED_SCANS; i++)
+    {
+        start = le_clk_GetRelativeTime();
+        LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+        PrintTime("UBI scan, with index", start);
+        LE_ASSERT_OK(pa_flash_GetUbiInfo(desc, &freeBlockIdx, &volBlockIdx, &volSizeIdx));
+        LE_ASSERT((freeBlock == freeBlockIdx) && (volBlock == volBlockIdx) &&
+                  (volSize == volSizeIdx));
+        LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+    }
+    LE_ASSERT_OK(pa_flash_Close(desc));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Add blocks to the UBI volume from the given block up to the given number of blocks, then stop as
+ * a power loss would: the UBI headers deferred since the last flush are never written. If isFlush
+ * is true, the descriptor is flushed first, as before the update records its progress.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteUbiAndStop
+(
+    uint32_t fromBlk,
+    uint32_t toBlk,
+    bool isFlush
+)
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    uint32_t blk, dataSize;
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READWRITE | PA_FLASH_OPENMODE_MARKBAD,
+                               &desc, &infoPtr));
+    dataSize = infoPtr->eraseSize - (2 * infoPtr->writeSize);
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    for (blk = fromBlk; blk < toBlk; blk++)
+    {
+        FillBlock(DataPtr, blk, dataSize);
+        LE_ASSERT_OK(pa_flash_WriteUbiAtBlock(desc, blk, DataPtr, dataSize, true));
+    }
+    if (isFlush)
+    {
+        LE_ASSERT_OK(pa_flash_Flush(desc));
+    }
+    ((pa_flash_MtdDesc_t*)desc)->ubiHdrPending = false;
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+    LE_ASSERT_OK(pa_flash_Close(desc));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reopen the UBI volume and get the number of blocks its VTBL reserves on the flash
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t GetUbiVolBlocks
+(
+    void
+)
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    uint32_t freeBlock, volBlock, volSize;
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READONLY, &desc, &infoPtr));
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    LE_ASSERT_OK(pa_flash_GetUbiInfo(desc, &freeBlock, &volBlock, &volSize));
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+    LE_ASSERT_OK(pa_flash_Close(desc));
+    return volBlock;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Interrupt the extension of a static UBI volume, reopen it, and check that its VTBL covers the
+ * blocks written up to the last periodic or explicit flush of the UBI headers. Then resume the
+ * write from there, as the update does, and check the whole volume
+ */
+//--------------------------------------------------------------------------------------------------
+static void TestUbiInterruptedWrite
+(
+    void
+)
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    uint32_t blk, dataSize, stopBlk, volBlock;
+    size_t size;
+
+    if (NbBlk < (4 * PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS))
+    {
+        LE_INFO("Too few blocks for the interrupted UBI write test");
+        return;
+    }
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READWRITE | PA_FLASH_OPENMODE_MARKBAD,
+                               &desc, &infoPtr));
+    LE_ASSERT_OK(pa_flash_CreateUbi(desc, true));
+    LE_ASSERT_OK(pa_flash_CreateUbiVolume(desc, UBI_VOL_ID, UBI_VOL_NAME,
+                                          PA_FLASH_VOLUME_STATIC, 0));
+    dataSize = infoPtr->eraseSize - (2 * infoPtr->writeSize);
+    LE_ASSERT_OK(pa_flash_Close(desc));
+
+    // Stop between two periodic flushes: the blocks added since the last one are past the VTBL
+    stopBlk = (2 * PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS) + 3;
+    WriteUbiAndStop(0, stopBlk, false);
+    volBlock = GetUbiVolBlocks();
+    LE_INFO("Interrupted at block %u: %u blocks in the volume", stopBlk, volBlock);
+    LE_ASSERT(volBlock == (2 * PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS));
+
+    // Resume from the volume size, and stop right after a flush, as when the progress is recorded
+    stopBlk = (3 * PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS) + 5;
+    WriteUbiAndStop(volBlock, stopBlk, true);
+    volBlock = GetUbiVolBlocks();
+    LE_INFO("Interrupted at block %u after a flush: %u blocks in the volume", stopBlk, volBlock);
+    LE_ASSERT(volBlock == stopBlk);
+
+    // Resume and complete the volume
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READWRITE | PA_FLASH_OPENMODE_MARKBAD,
+                               &desc, &infoPtr));
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    for (blk = volBlock; blk < NbBlk; blk++)
+    {
+        FillBlock(DataPtr, blk, dataSize);
+        LE_ASSERT_OK(pa_flash_WriteUbiAtBlock(desc, blk, DataPtr, dataSize, true));
+    }
+    LE_ASSERT_OK(pa_flash_AdjustUbiSize(desc, (size_t)NbBlk * dataSize));
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+
+    LE_ASSERT_OK(pa_flash_ScanUbi(desc, UBI_VOL_ID));
+    for (blk = 0; blk < NbBlk; blk++)
+    {
+        FillBlock(DataPtr, blk, dataSize);
+        size = dataSize;
+        LE_ASSERT_OK(pa_flash_ReadUbiAtBlock(desc, blk, CheckPtr, &size));
+        LE_ASSERT(size == dataSize);
+        LE_ASSERT(0 == memcmp(DataPtr, CheckPtr, dataSize));
+    }
+    LE_ASSERT_OK(pa_flash_UnscanUbi(desc));
+    LE_ASSERT_OK(pa_flash_Close(desc));
+    LE_ASSERT(GetUbiVolBlocks() == NbBlk);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Main thread.
+ *
+ */
+//--------------------------------------------------------------------------------------------------
+COMPONENT_INIT
+{
+    pa_flash_Desc_t desc;
+    pa_flash_Info_t* infoPtr;
+    uint32_t sizeMiB = DEFAULT_SIZE_MIB;
+
+    if (le_arg_NumArgs() < 1)
+    {
+        fprintf(stderr, "Usage: flashPerfTest -- <mtdNum> [<sizeMiB> [<delayMs>]]\n");
+        exit(EXIT_FAILURE);
+    }
+    MtdNum = atoi(le_arg_GetArg(0));
+    if (le_arg_NumArgs() >= 2)
+    {
+        sizeMiB = atoi(le_arg_GetArg(1));
+    }
+    if (le_arg_NumArgs() >= 3)
+    {
+        DelayMs = atoi(le_arg_GetArg(2));
+    }
+
+    LE_ASSERT_OK(pa_flash_Open(MtdNum, PA_FLASH_OPENMODE_READONLY, &desc, &infoPtr));
+    NbBlk = ((uint64_t)sizeMiB << 20) / infoPtr->eraseSize;
+    if (NbBlk > infoPtr->nbBlk / 2)
+    {
+        NbBlk = infoPtr->nbBlk / 2;
+    }
+    DataPtr = malloc(infoPtr->eraseSize);
+    CheckPtr = malloc(infoPtr->eraseSize);
+    LE_ASSERT(DataPtr && CheckPtr);
+    LE_INFO("MTD %d: %u blocks of %u bytes, writing %u blocks",
+            MtdNum, infoPtr->nbBlk, infoPtr->eraseSize, NbBlk);
+    LE_ASSERT_OK(pa_flash_Close(desc));
+
+    TestRawWrite(false);
+    TestRawWrite(true);
+    TestUbiWrite();
+    TestUbiScan();
+    TestUbiInterruptedWrite();
+
+    free(DataPtr);
+    free(CheckPtr);
+    LE_INFO("======== flashPerfTest PASSED ========");
+    exit(EXIT_SUCCESS);
+}
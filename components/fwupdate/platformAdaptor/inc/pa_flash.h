@@ -57,6 +57,24 @@
 #define PA_FLASH_OPENMODE_LOGICAL_DUAL     0x30U ///< This is a "logical and dual" partition
 #define PA_FLASH_OPENMODE_UBI              0x40U ///< Mode for UBI block management
 #define PA_FLASH_OPENMODE_MARKBAD          0x80U ///< Mark bad block and use next block
+#define PA_FLASH_OPENMODE_ASYNC           0x100U ///< Queue erase and write to an I/O thread
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * With PA_FLASH_OPENMODE_ASYNC, pa_flash_EraseBlock, pa_flash_EraseNextBlocks, pa_flash_Write,
+ * pa_flash_WriteAtBlock, pa_flash_SeekAtOffset and pa_flash_SeekAtBlock are queued to an I/O
+ * thread and return at once, so that the flash is erased and written while the caller prepares the
+ * next block. The data to write are copied, up to PA_FLASH_ASYNC_NB_BUFFERS erase blocks. The other
+ * functions wait for the queued operations to complete before doing their work.
+ * A queued operation that fails cancels the operations queued after it, and its error is returned
+ * by the next queued operation or by pa_flash_Flush. Data are on the flash only once pa_flash_Flush
+ * or pa_flash_Close returns LE_OK.
+ * This mode is not allowed for UBI.
+ */
+//--------------------------------------------------------------------------------------------------
+#ifndef PA_FLASH_ASYNC_NB_BUFFERS
+#define PA_FLASH_ASYNC_NB_BUFFERS 2
+#endif
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -233,11 +251,12 @@ LE_SHARED le_result_t pa_flash_Open
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Close a flash descriptor
+ * Close a flash descriptor. The pending operations are flushed before (see pa_flash_Flush)
  *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or not a valid flash descriptor
+ *      - others           If the flush fails. The descriptor is closed anyway
  */
 //--------------------------------------------------------------------------------------------------
 LE_SHARED le_result_t pa_flash_Close
@@ -245,6 +264,24 @@ LE_SHARED le_result_t pa_flash_Close
     pa_flash_Desc_t desc      ///< [IN] Private flash descriptor
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flush a flash descriptor: wait for the erase and write operations queued with
+ * PA_FLASH_OPENMODE_ASYNC, and write the UBI headers (VID and VTBL) whose update was deferred when
+ * the UBI volume was extended. When it returns LE_OK, all the data written through the descriptor
+ * are on the flash and the UBI volume is consistent.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or not a valid flash descriptor
+ *      - others           The error of the first failed operation since the last flush
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_flash_Flush
+(
+    pa_flash_Desc_t desc      ///< [IN] Private flash descriptor
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Scan a flash and produce a list of LEB and PEB. If no bad block is found, LEB = PEB
@@ -339,6 +376,26 @@ LE_SHARED le_result_t pa_flash_EraseBlock
     uint32_t blockIndex       ///< [IN] PEB or LEB to erase
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Erase the good blocks where the next pa_flash_Write will write, starting at the current position
+ * and skipping the bad blocks as pa_flash_Write does. With PA_FLASH_OPENMODE_MARKBAD, a block that
+ * fails to erase is marked bad and skipped. The current read/write position is not changed.
+ *
+ * @return
+ *      - LE_OK            On success, even if the end of the partition is reached before nbBlocks
+ *                         blocks are erased
+ *      - LE_BAD_PARAMETER If desc is NULL
+ *      - LE_FAULT         On failure
+ *      - LE_IO_ERROR      If a flash IO error occurs
+ */
+//--------------------------------------------------------------------------------------------------
+LE_SHARED le_result_t pa_flash_EraseNextBlocks
+(
+    pa_flash_Desc_t desc,     ///< [IN] Private flash descriptor
+    uint32_t nbBlocks         ///< [IN] Number of good blocks to erase
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the current read/write position of the flash to the given offset
@@ -491,6 +548,8 @@ LE_SHARED le_result_t pa_flash_CheckUbi
  * Scan an UBI partition for the volumes number and volumes name
  * volume ID.
  *
+ * The headers of the PEBs are cached in a scan index in /tmp, see pa_flash_ScanUbi().
+ *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or is not a valid descriptor
@@ -512,6 +571,11 @@ LE_SHARED le_result_t pa_flash_ScanUbiForVolumes
  * Scan a partition for the UBI volume ID given. Update the LebToPeb array field with LEB for this
  * volume ID.
  *
+ * The offsets and the VID header CRC of every used PEB are saved in a scan index in /tmp at the
+ * end of a successful scan. The next scans of the partition read only the VID header of the PEBs
+ * found in the index and skip their EC header, as long as the VID header CRC is unchanged. Other
+ * PEBs are fully read and their entry is refreshed. The index is lost at reboot.
+ *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or is not a valid descriptor
@@ -571,6 +635,8 @@ LE_SHARED le_result_t pa_flash_ReadUbiAtBlock
  * Write data to an UBI volume starting the given block. If a Bad block is detected,
  * the error LE_IO_ERROR is returned and operation is aborted.
  * Note that the length should be a multiple of writeSize
+ * When the volume is extended, the VID headers of its other blocks and the VTBL are only updated
+ * by pa_flash_AdjustUbiSize, pa_flash_Flush or pa_flash_Close.
  *
  * @return
  *      - LE_OK            On success
@@ -5,6 +5,12 @@
  * This file implements functions that can be used to import IMA keys (into the kernel keyring) and
  * verify IMA signatures.
  *
+ * Whole directories are verified in batches: up to one evmctl process per CPU runs at a time, and
+ * files that have already been verified are not verified again.  A file is known to be verified
+ * when the SHA-256 of its content, its IMA signature and the certificate it was checked against
+ * match those of a file that passed verification earlier.  These results are only kept in memory,
+ * since a result stored in the file system could be tampered with.
+ *
  * Copyright (C) Sierra Wireless Inc.
  */
 //--------------------------------------------------------------------------------------------------
@@ -17,6 +23,8 @@
 #include "ima.h"
 #include "file.h"
 #include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <sys/xattr.h>
 
 
 //--------------------------------------------------------------------------------------------------
@@ -44,6 +52,601 @@
 #define CHECK_EXPIRY_OPTION   "--check_expiry"
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the extended attribute holding the IMA signature of a file.
+ */
+//--------------------------------------------------------------------------------------------------
+#define IMA_XATTR_NAME   "security.ima"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of an IMA signature.  Files with a bigger signature are always verified.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_SIGNATURE_BYTES   1024
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of evmctl processes running at the same time for a batch.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_VERIFY_JOBS   4
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of verification results and recorded digests kept in memory.  Once the limit is
+ * reached, the oldest ones are forgotten.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_CACHED_RESULTS     4096
+#define MAX_RECORDED_DIGESTS   8192
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffer used to read a file's content.
+ */
+//--------------------------------------------------------------------------------------------------
+#define READ_BUFFER_BYTES   (16 * 1024)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Verification result known to be successful, keyed by the SHA-256 of the file content digest, its
+ * IMA signature and the certificate digest.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t key[IMA_DIGEST_BYTES];      ///< Key of the result.
+    le_dls_Link_t link;                 ///< Link in ResultList, oldest first.
+}
+CachedResult_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Identity of a file.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    dev_t dev;                          ///< Device holding the file.
+    ino_t ino;                          ///< Inode of the file.
+}
+FileId_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Content digest of a file, recorded by ima_RecordDigest().  It is only used while the file's
+ * size and status change time are unchanged.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    FileId_t id;                        ///< Identity of the file (key).
+    off_t size;                         ///< Size of the file when the digest was recorded.
+    struct timespec ctime;              ///< Status change time when the digest was recorded.
+    uint8_t digest[IMA_DIGEST_BYTES];   ///< SHA-256 of the file content.
+    le_dls_Link_t link;                 ///< Link in DigestList, oldest first.
+}
+RecordedDigest_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * An evmctl process verifying a file.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pid_t pid;                              ///< Process ID.
+    bool hasKey;                            ///< true if key is valid.
+    uint8_t key[IMA_DIGEST_BYTES];          ///< Key to cache the result with.
+    char filePath[LIMIT_MAX_PATH_BYTES];    ///< File being verified.
+    char certPath[LIMIT_MAX_PATH_BYTES];    ///< Certificate it is verified against.
+}
+VerifyJob_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Batch of files being verified.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct ima_Batch
+{
+    VerifyJob_t jobs[MAX_VERIFY_JOBS];      ///< Running jobs, in a ring, oldest first.
+    size_t firstJob;                        ///< Index of the oldest running job.
+    size_t numJobs;                         ///< Number of running jobs.
+    size_t maxJobs;                         ///< Maximum number of running jobs.
+    char certPath[LIMIT_MAX_PATH_BYTES];    ///< Certificate whose digest is in certDigest.
+    bool hasCertDigest;                     ///< true if certDigest is valid.
+    uint8_t certDigest[IMA_DIGEST_BYTES];   ///< SHA-256 of the certificate.
+    bool hasFailed;                         ///< true once a file failed verification.
+    ima_BatchStats_t stats;                 ///< Counters.
+}
+Batch_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Verification results, digests recorded by ima_RecordDigest() and batches.  Created when first
+ * needed.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t ResultPool = NULL;
+static le_hashmap_Ref_t ResultMap;
+static le_dls_List_t ResultList = LE_DLS_LIST_INIT;
+static le_mem_PoolRef_t DigestPool;
+static le_hashmap_Ref_t DigestMap;
+static le_dls_List_t DigestList = LE_DLS_LIST_INIT;
+static le_mem_PoolRef_t BatchPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hashes a verification result key for the hashmap.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t HashResultKey
+(
+    const void* keyPtr
+)
+{
+    size_t hash;
+
+    memcpy(&hash, keyPtr, sizeof(hash));
+    return hash;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares two verification result keys for the hashmap.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool EqualsResultKey
+(
+    const void* firstKeyPtr,
+    const void* secondKeyPtr
+)
+{
+    return memcmp(firstKeyPtr, secondKeyPtr, IMA_DIGEST_BYTES) == 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hashes a file identity for the hashmap.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t HashFileId
+(
+    const void* idPtr
+)
+{
+    const FileId_t* fileIdPtr = idPtr;
+
+    return (size_t)fileIdPtr->ino * 31 + (size_t)fileIdPtr->dev;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares two file identities for the hashmap.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool EqualsFileId
+(
+    const void* firstIdPtr,
+    const void* secondIdPtr
+)
+{
+    const FileId_t* firstPtr = firstIdPtr;
+    const FileId_t* secondPtr = secondIdPtr;
+
+    return (firstPtr->ino == secondPtr->ino) && (firstPtr->dev == secondPtr->dev);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the pools and hashmaps, if not done yet.
+ */
+//--------------------------------------------------------------------------------------------------
+static void InitCache
+(
+    void
+)
+{
+    if (ResultPool != NULL)
+    {
+        return;
+    }
+
+    ResultPool = le_mem_CreatePool("ImaResult", sizeof(CachedResult_t));
+    ResultMap = le_hashmap_Create("ImaResults", MAX_CACHED_RESULTS,
+                                  HashResultKey, EqualsResultKey);
+    DigestPool = le_mem_CreatePool("ImaDigest", sizeof(RecordedDigest_t));
+    DigestMap = le_hashmap_Create("ImaDigests", MAX_RECORDED_DIGESTS,
+                                  HashFileId, EqualsFileId);
+    BatchPool = le_mem_CreatePool("ImaBatch", sizeof(Batch_t));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes a recorded digest.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RemoveDigest
+(
+    RecordedDigest_t* digestPtr
+)
+{
+    le_hashmap_Remove(DigestMap, &digestPtr->id);
+    le_dls_Remove(&DigestList, &digestPtr->link);
+    le_mem_Release(digestPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Remembers that a verification was successful.
+ */
+//--------------------------------------------------------------------------------------------------
+static void AddResult
+(
+    const uint8_t* keyPtr
+)
+{
+    if (le_hashmap_ContainsKey(ResultMap, keyPtr))
+    {
+        return;
+    }
+
+    if (le_hashmap_Size(ResultMap) >= MAX_CACHED_RESULTS)
+    {
+        CachedResult_t* oldestPtr = CONTAINER_OF(le_dls_Pop(&ResultList), CachedResult_t, link);
+
+        le_hashmap_Remove(ResultMap, oldestPtr->key);
+        le_mem_Release(oldestPtr);
+    }
+
+    CachedResult_t* resultPtr = le_mem_ForceAlloc(ResultPool);
+
+    memcpy(resultPtr->key, keyPtr, IMA_DIGEST_BYTES);
+    resultPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&ResultList, &resultPtr->link);
+    le_hashmap_Put(ResultMap, resultPtr->key, resultPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the SHA-256 digest of the rest of a file's content.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_FAULT otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t DigestFd
+(
+    int fd,
+    uint8_t* digestPtr          ///< [OUT] IMA_DIGEST_BYTES bytes.
+)
+{
+    EVP_MD_CTX* ctxPtr = EVP_MD_CTX_create();
+    uint8_t buffer[READ_BUFFER_BYTES];
+    le_result_t result = LE_FAULT;
+
+    if ((ctxPtr == NULL) || (EVP_DigestInit_ex(ctxPtr, EVP_sha256(), NULL) != 1))
+    {
+        goto cleanup;
+    }
+
+    for (;;)
+    {
+        ssize_t readBytes = read(fd, buffer, sizeof(buffer));
+
+        if (readBytes == 0)
+        {
+            break;
+        }
+
+        if (readBytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            goto cleanup;
+        }
+
+        EVP_DigestUpdate(ctxPtr, buffer, readBytes);
+    }
+
+    if (EVP_DigestFinal_ex(ctxPtr, digestPtr, NULL) == 1)
+    {
+        result = LE_OK;
+    }
+
+cleanup:
+
+    if (ctxPtr != NULL)
+    {
+        EVP_MD_CTX_destroy(ctxPtr);
+    }
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the SHA-256 digest of a file's content, from the digest recorded when it was unpacked if
+ * the file hasn't changed since, or by reading it otherwise.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_FAULT otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetContentDigest
+(
+    int fd,
+    const struct stat* statPtr,
+    uint8_t* digestPtr          ///< [OUT] IMA_DIGEST_BYTES bytes.
+)
+{
+    FileId_t id = { .dev = statPtr->st_dev, .ino = statPtr->st_ino };
+    RecordedDigest_t* recordPtr = le_hashmap_Get(DigestMap, &id);
+
+    if (recordPtr != NULL)
+    {
+        // A digest is only used once: the file is about to be moved to its final location.
+        bool isValid = (recordPtr->size == statPtr->st_size) &&
+                       (recordPtr->ctime.tv_sec == statPtr->st_ctim.tv_sec) &&
+                       (recordPtr->ctime.tv_nsec == statPtr->st_ctim.tv_nsec);
+
+        memcpy(digestPtr, recordPtr->digest, IMA_DIGEST_BYTES);
+        RemoveDigest(recordPtr);
+
+        if (isValid)
+        {
+            return LE_OK;
+        }
+    }
+
+    return DigestFd(fd, digestPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the key a verification result is cached with.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_FAULT if the file can't be read or has no signature
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetResultKey
+(
+    Batch_t* batchPtr,
+    const char* filePath,
+    const char* certPath,
+    uint8_t* keyPtr             ///< [OUT] IMA_DIGEST_BYTES bytes.
+)
+{
+    uint8_t contentDigest[IMA_DIGEST_BYTES];
+    uint8_t signature[MAX_SIGNATURE_BYTES];
+    ssize_t signatureSize = -1;
+    struct stat fileStat;
+    le_result_t result = LE_FAULT;
+
+    if ((!batchPtr->hasCertDigest) || (strcmp(batchPtr->certPath, certPath) != 0))
+    {
+        int certFd = open(certPath, O_RDONLY);
+
+        batchPtr->hasCertDigest = false;
+        if (certFd < 0)
+        {
+            return LE_FAULT;
+        }
+        if (DigestFd(certFd, batchPtr->certDigest) == LE_OK)
+        {
+            batchPtr->hasCertDigest =
+                (le_utf8_Copy(batchPtr->certPath, certPath, sizeof(batchPtr->certPath), NULL)
+                 == LE_OK);
+        }
+        fd_Close(certFd);
+        if (!batchPtr->hasCertDigest)
+        {
+            return LE_FAULT;
+        }
+    }
+
+    int fd = open(filePath, O_RDONLY | O_NOFOLLOW);
+
+    if (fd < 0)
+    {
+        return LE_FAULT;
+    }
+
+    if (fstat(fd, &fileStat) == 0)
+    {
+        signatureSize = fgetxattr(fd, IMA_XATTR_NAME, signature, sizeof(signature));
+    }
+
+    if ((signatureSize > 0) && (GetContentDigest(fd, &fileStat, contentDigest) == LE_OK))
+    {
+        EVP_MD_CTX* ctxPtr = EVP_MD_CTX_create();
+        uint32_t size = (uint32_t)signatureSize;
+
+        if ((ctxPtr != NULL) && (EVP_DigestInit_ex(ctxPtr, EVP_sha256(), NULL) == 1))
+        {
+            EVP_DigestUpdate(ctxPtr, contentDigest, sizeof(contentDigest));
+            EVP_DigestUpdate(ctxPtr, &size, sizeof(size));
+            EVP_DigestUpdate(ctxPtr, signature, signatureSize);
+            EVP_DigestUpdate(ctxPtr, batchPtr->certDigest, sizeof(batchPtr->certDigest));
+
+            if (EVP_DigestFinal_ex(ctxPtr, keyPtr, NULL) == 1)
+            {
+                result = LE_OK;
+            }
+        }
+
+        if (ctxPtr != NULL)
+        {
+            EVP_MD_CTX_destroy(ctxPtr);
+        }
+    }
+
+    fd_Close(fd);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks if a file with a given key is being verified by a running job of a batch.
+ *
+ * @return true if it is.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsKeyRunning
+(
+    const Batch_t* batchPtr,
+    const uint8_t* keyPtr
+)
+{
+    size_t i;
+
+    for (i = 0; i < batchPtr->numJobs; i++)
+    {
+        const VerifyJob_t* jobPtr = &batchPtr->jobs[(batchPtr->firstJob + i) % MAX_VERIFY_JOBS];
+
+        if (jobPtr->hasKey && (memcmp(jobPtr->key, keyPtr, IMA_DIGEST_BYTES) == 0))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Waits for the oldest running job of a batch to finish, and caches its result.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitOldestJob
+(
+    Batch_t* batchPtr
+)
+{
+    VerifyJob_t* jobPtr = &batchPtr->jobs[batchPtr->firstJob];
+    int exitCode;
+    pid_t pid;
+
+    do
+    {
+        pid = waitpid(jobPtr->pid, &exitCode, 0);
+    }
+    while ((pid < 0) && (errno == EINTR));
+
+    if ((pid == jobPtr->pid) && WIFEXITED(exitCode) && (0 == WEXITSTATUS(exitCode)))
+    {
+        LE_DEBUG("Verified file: '%s' successfully", jobPtr->filePath);
+
+        if (jobPtr->hasKey)
+        {
+            AddResult(jobPtr->key);
+        }
+    }
+    else
+    {
+        LE_ERROR("Failed to verify file '%s' with certificate '%s', exitCode: %d",
+                 jobPtr->filePath, jobPtr->certPath, WEXITSTATUS(exitCode));
+        batchPtr->hasFailed = true;
+    }
+
+    batchPtr->firstJob = (batchPtr->firstJob + 1) % MAX_VERIFY_JOBS;
+    batchPtr->numJobs--;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts an evmctl process to verify a file, once a job slot is free.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartJob
+(
+    Batch_t* batchPtr,
+    const char* filePath,
+    const char* certPath,
+    const uint8_t* keyPtr       ///< [IN] Key to cache the result with, or NULL.
+)
+{
+    if (batchPtr->numJobs >= batchPtr->maxJobs)
+    {
+        WaitOldestJob(batchPtr);
+    }
+
+    if (batchPtr->hasFailed)
+    {
+        return;
+    }
+
+    VerifyJob_t* jobPtr =
+        &batchPtr->jobs[(batchPtr->firstJob + batchPtr->numJobs) % MAX_VERIFY_JOBS];
+
+    if ((le_utf8_Copy(jobPtr->filePath, filePath, sizeof(jobPtr->filePath), NULL) != LE_OK) ||
+        (le_utf8_Copy(jobPtr->certPath, certPath, sizeof(jobPtr->certPath), NULL) != LE_OK))
+    {
+        LE_ERROR("Path too long: '%s' or '%s'", filePath, certPath);
+        batchPtr->hasFailed = true;
+        return;
+    }
+
+    jobPtr->hasKey = (keyPtr != NULL);
+    if (keyPtr != NULL)
+    {
+        memcpy(jobPtr->key, keyPtr, IMA_DIGEST_BYTES);
+    }
+
+    LE_DEBUG("Verify file: %s ima_verify %s -k %s", EVMCTL_PATH, filePath, certPath);
+
+    jobPtr->pid = fork();
+
+    if (jobPtr->pid == 0)
+    {
+        execl(EVMCTL_PATH, EVMCTL_PATH, "ima_verify", filePath, "-k", certPath, (char*)NULL);
+        _exit(127);
+    }
+
+    if (jobPtr->pid < 0)
+    {
+        LE_ERROR("Failed to fork to verify '%s' (%m)", filePath);
+        batchPtr->hasFailed = true;
+        return;
+    }
+
+    batchPtr->numJobs++;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Verify a file IMA signature against provided public certificate path
@@ -111,6 +714,10 @@ static le_result_t VerifyDir
         return LE_FAULT;
     }
 
+    ima_BatchRef_t batchRef = ima_CreateBatch();
+    ima_BatchStats_t stats;
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
     // Traverse through the directory tree.
     FTSENT* entPtr;
     while (NULL != (entPtr = fts_read(ftsPtr)))
@@ -129,12 +736,13 @@ static le_result_t VerifyDir
             case FTS_F:
                 if (0 != strcmp(entPtr->fts_name, PUB_CERT_NAME ))
                 {
-                    if (LE_OK != VerifyFile(entPtr->fts_accpath, certPath))
+                    if (LE_OK != ima_AddToBatch(batchRef, entPtr->fts_accpath, certPath))
                     {
-                        LE_CRIT("Failed to verify file '%s' with public certificate '%s'",
-                                entPtr->fts_accpath,
+                        LE_CRIT("Failed to verify files in '%s' with public certificate '%s'",
+                                dirPath,
                                 certPath);
                         fts_close(ftsPtr);
+                        ima_CompleteBatch(batchRef, &stats);
                         return LE_FAULT;
                     }
                 }
@@ -145,6 +753,18 @@ static le_result_t VerifyDir
 
     fts_close(ftsPtr);
 
+    if (LE_OK != ima_CompleteBatch(batchRef, &stats))
+    {
+        LE_CRIT("Failed to verify files in '%s' with public certificate '%s'", dirPath, certPath);
+        return LE_FAULT;
+    }
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    LE_INFO("Verified %zu files of '%s' (%zu already verified) in %ld ms.",
+            stats.fileCount, dirPath, stats.cachedCount,
+            (long)(elapsed.sec * 1000 + elapsed.usec / 1000));
+
     return LE_OK;
 }
 
@@ -314,3 +934,184 @@ le_result_t ima_ImportPublicCert
 
     return LE_OK;
 }
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records the SHA-256 digest of the content of a file that has just been written, so that
+ * verifying the file doesn't require reading it again.  The digest is only used as long as the
+ * file's size and status change time don't change.
+ */
+//--------------------------------------------------------------------------------------------------
+void ima_RecordDigest
+(
+    int fd,                     ///< [IN] File.
+    const uint8_t* digestPtr,   ///< [IN] SHA-256 of the content of the file.
+    size_t digestSize           ///< [IN] Number of bytes in the digest.
+)
+{
+    struct stat fileStat;
+
+    if ((digestSize != IMA_DIGEST_BYTES) || (fstat(fd, &fileStat) != 0))
+    {
+        return;
+    }
+
+    InitCache();
+
+    FileId_t id = { .dev = fileStat.st_dev, .ino = fileStat.st_ino };
+    RecordedDigest_t* recordPtr = le_hashmap_Get(DigestMap, &id);
+
+    if (recordPtr != NULL)
+    {
+        RemoveDigest(recordPtr);
+    }
+    else if (le_hashmap_Size(DigestMap) >= MAX_RECORDED_DIGESTS)
+    {
+        RemoveDigest(CONTAINER_OF(le_dls_Peek(&DigestList), RecordedDigest_t, link));
+    }
+
+    recordPtr = le_mem_ForceAlloc(DigestPool);
+    recordPtr->id = id;
+    recordPtr->size = fileStat.st_size;
+    recordPtr->ctime = fileStat.st_ctim;
+    memcpy(recordPtr->digest, digestPtr, IMA_DIGEST_BYTES);
+    recordPtr->link = LE_DLS_LINK_INIT;
+    le_dls_Queue(&DigestList, &recordPtr->link);
+    le_hashmap_Put(DigestMap, &recordPtr->id, recordPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forgets the digests recorded by ima_RecordDigest() that have not been used.
+ */
+//--------------------------------------------------------------------------------------------------
+void ima_ForgetDigests
+(
+    void
+)
+{
+    le_dls_Link_t* linkPtr;
+
+    if (DigestPool == NULL)
+    {
+        return;
+    }
+
+    while ((linkPtr = le_dls_Peek(&DigestList)) != NULL)
+    {
+        RemoveDigest(CONTAINER_OF(linkPtr, RecordedDigest_t, link));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates a batch of files to verify.
+ *
+ * @return Reference to the batch.
+ */
+//--------------------------------------------------------------------------------------------------
+ima_BatchRef_t ima_CreateBatch
+(
+    void
+)
+{
+    InitCache();
+
+    Batch_t* batchPtr = le_mem_ForceAlloc(BatchPool);
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    memset(batchPtr, 0, sizeof(*batchPtr));
+    batchPtr->maxJobs = (numCpus > 0) ? (size_t)numCpus : 1;
+    if (batchPtr->maxJobs > MAX_VERIFY_JOBS)
+    {
+        batchPtr->maxJobs = MAX_VERIFY_JOBS;
+    }
+
+    return batchPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a file to a batch.  Its IMA signature is verified against the provided public certificate,
+ * unless an identical file has already passed verification against the same certificate.  The
+ * verification may still be running when this returns.
+ *
+ * @return
+ *      - LE_OK if the file was added
+ *      - LE_FAULT if a file of the batch failed verification
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ima_AddToBatch
+(
+    ima_BatchRef_t batchRef,
+    const char * filePath,
+    const char * certPath
+)
+{
+    Batch_t* batchPtr = batchRef;
+    uint8_t key[IMA_DIGEST_BYTES];
+
+    if (batchPtr->hasFailed)
+    {
+        return LE_FAULT;
+    }
+
+    batchPtr->stats.fileCount++;
+
+    if (LE_OK != GetResultKey(batchPtr, filePath, certPath, key))
+    {
+        // Let evmctl report what is wrong with this file.
+        StartJob(batchPtr, filePath, certPath, NULL);
+    }
+    else if (le_hashmap_ContainsKey(ResultMap, key) || IsKeyRunning(batchPtr, key))
+    {
+        // An identical file failing verification would fail the whole batch anyway.
+        LE_DEBUG("File '%s' already verified", filePath);
+        batchPtr->stats.cachedCount++;
+    }
+    else
+    {
+        StartJob(batchPtr, filePath, certPath, key);
+    }
+
+    return batchPtr->hasFailed ? LE_FAULT : LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Waits for the verification of all the files of a batch to finish, and deletes the batch.
+ *
+ * @return
+ *      - LE_OK if all the files passed verification
+ *      - LE_FAULT otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ima_CompleteBatch
+(
+    ima_BatchRef_t batchRef,
+    ima_BatchStats_t* statsPtr      ///< [OUT] Counters of the batch.  Can be NULL.
+)
+{
+    Batch_t* batchPtr = batchRef;
+
+    while (batchPtr->numJobs > 0)
+    {
+        WaitOldestJob(batchPtr);
+    }
+
+    le_result_t result = batchPtr->hasFailed ? LE_FAULT : LE_OK;
+
+    if (statsPtr != NULL)
+    {
+        *statsPtr = batchPtr->stats;
+    }
+
+    le_mem_Release(batchPtr);
+
+    return result;
+}
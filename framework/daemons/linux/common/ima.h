@@ -98,4 +98,109 @@ le_result_t ima_VerifyDir
     const char * certPath
 );
 
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the content digest given to ima_RecordDigest() (SHA-256).
+ */
+//--------------------------------------------------------------------------------------------------
+#define IMA_DIGEST_BYTES    32
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to a batch of files whose IMA signatures are verified in parallel.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct ima_Batch* ima_BatchRef_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counters of a batch.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t fileCount;       ///< Number of files added to the batch.
+    size_t cachedCount;     ///< Number of files not verified again because an identical file
+                            ///  already passed verification.
+}
+ima_BatchStats_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Records the SHA-256 digest of the content of a file that has just been written, so that
+ * verifying the file doesn't require reading it again.  The digest is only used as long as the
+ * file's size and status change time don't change.
+ */
+//--------------------------------------------------------------------------------------------------
+void ima_RecordDigest
+(
+    int fd,                     ///< [IN] File.
+    const uint8_t* digestPtr,   ///< [IN] SHA-256 of the content of the file.
+    size_t digestSize           ///< [IN] Number of bytes in the digest.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forgets the digests recorded by ima_RecordDigest() that have not been used.
+ */
+//--------------------------------------------------------------------------------------------------
+void ima_ForgetDigests
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates a batch of files to verify.
+ *
+ * @return Reference to the batch.
+ */
+//--------------------------------------------------------------------------------------------------
+ima_BatchRef_t ima_CreateBatch
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a file to a batch.  Its IMA signature is verified against the provided public certificate,
+ * unless an identical file has already passed verification against the same certificate.  The
+ * verification may still be running when this returns.
+ *
+ * @return
+ *      - LE_OK if the file was added
+ *      - LE_FAULT if a file of the batch failed verification
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ima_AddToBatch
+(
+    ima_BatchRef_t batchRef,
+    const char * filePath,
+    const char * certPath
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Waits for the verification of all the files of a batch to finish, and deletes the batch.
+ *
+ * @return
+ *      - LE_OK if all the files passed verification
+ *      - LE_FAULT otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t ima_CompleteBatch
+(
+    ima_BatchRef_t batchRef,
+    ima_BatchStats_t* statsPtr      ///< [OUT] Counters of the batch.  Can be NULL.
+);
+
 #endif // LEGATO_IMA_H_INCLUDE_GUARD
@@ -0,0 +1,1088 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file sandboxPlan.c
+ *
+ * This file implements the sandbox plans described in sandboxPlan.h.
+ *
+ * A saved plan is a text file with one item per line and tab separated fields:
+ *
+ * @verbatim
+   # sandbox plan 1
+   app     <appName>
+   hash    <appHash>
+   <type>  <src>   <dest>
+   ...
+   @endverbatim
+ *
+ * where \<type\> is one of "file", "dir", "sharedDir" or "tree".
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "interfaces.h"
+#include "limit.h"
+#include "sysPaths.h"
+#include "properties.h"
+#include "sandboxPlan.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * First line of a saved plan.  Changing the format of the plan requires changing this line so that
+ * plans saved in an older format get rebuilt.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PLAN_FILE_HEADER                        "# sandbox plan 1"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Format of the path to a saved plan.  The parameter is the app's hash.
+ */
+//--------------------------------------------------------------------------------------------------
+#define PLAN_FILE_PATH_FORMAT                   "/legato/apps/%s/" SANDBOXPLAN_FILE_NAME
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the app's info file, relative to the app's install directory, and the key in it that
+ * holds the app's hash.
+ */
+//--------------------------------------------------------------------------------------------------
+#define APP_INFO_FILE                           "info.properties"
+#define APP_INFO_KEY_MD5                        "app.md5"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Nodes in the app's configuration that hold the files to link into the app.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_NODE_APPS_LIST                      "/apps"
+#define CFG_NODE_BUNDLES                        "bundles"
+#define CFG_NODE_REQUIRES                       "requires"
+#define CFG_NODE_FILES                          "files"
+#define CFG_NODE_DIRS                           "dirs"
+#define CFG_NODE_DEVICES                        "devices"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum size of a line in a saved plan.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_LINE_BYTES                          (2 * LIMIT_MAX_PATH_BYTES + 32)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sandbox plan object.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct sandboxPlan
+{
+    char appName[LIMIT_MAX_APP_NAME_BYTES];         ///< Name of the app.
+    char hash[LIMIT_MD5_STR_BYTES];                 ///< Hash of the app, or "" if unknown.
+    char installDirPath[LIMIT_MAX_PATH_BYTES];      ///< Abs path to the app's install files dir.
+    le_sls_List_t links;                            ///< List of sandboxPlan_Link_t.
+    size_t numLinks;                                ///< Number of links in the list.
+}
+Plan_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Names of the link types in saved plans.  Indexed by sandboxPlan_LinkType_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* LinkTypeNames[] =
+{
+    [SANDBOXPLAN_FILE] = "file",
+    [SANDBOXPLAN_DIR] = "dir",
+    [SANDBOXPLAN_SHARED_DIR] = "sharedDir",
+    [SANDBOXPLAN_TREE] = "tree"
+};
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Memory pools for plans and links.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PlanPool;
+static le_mem_PoolRef_t LinkPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Destructor for plans.  Releases all the links in the plan.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PlanDestructor
+(
+    void* objPtr                        ///< [IN] Plan being released.
+)
+{
+    Plan_t* planPtr = objPtr;
+
+    le_sls_Link_t* linkPtr;
+
+    while ((linkPtr = le_sls_Pop(&(planPtr->links))) != NULL)
+    {
+        le_mem_Release(CONTAINER_OF(linkPtr, sandboxPlan_Link_t, link));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates an empty plan.
+ *
+ * @return
+ *      The plan, or NULL if the app name or hash is too long.
+ */
+//--------------------------------------------------------------------------------------------------
+static Plan_t* CreatePlan
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    const char* hashPtr                 ///< [IN] Hash of the app.
+)
+{
+    Plan_t* planPtr = le_mem_ForceAlloc(PlanPool);
+
+    planPtr->links = LE_SLS_LIST_INIT;
+    planPtr->numLinks = 0;
+    planPtr->installDirPath[0] = '\0';
+
+    if ( (le_utf8_Copy(planPtr->appName, appNamePtr, sizeof(planPtr->appName), NULL) != LE_OK) ||
+         (le_utf8_Copy(planPtr->hash, hashPtr, sizeof(planPtr->hash), NULL) != LE_OK) ||
+         (le_path_Concat("/", planPtr->installDirPath, sizeof(planPtr->installDirPath),
+                         APPS_INSTALL_DIR, appNamePtr, NULL) != LE_OK) )
+    {
+        LE_ERROR("App name '%s' or hash '%s' is too long.", appNamePtr, hashPtr);
+        le_mem_Release(planPtr);
+        return NULL;
+    }
+
+    return planPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a link to a plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddLink
+(
+    Plan_t* planPtr,                    ///< [IN] Plan to add to.
+    sandboxPlan_LinkType_t type,        ///< [IN] How the link is to be created.
+    const char* srcPtr,                 ///< [IN] Source path.
+    const char* destPtr                 ///< [IN] Destination path relative to the working dir.
+)
+{
+    sandboxPlan_Link_t* linkPtr = le_mem_ForceAlloc(LinkPool);
+
+    linkPtr->type = type;
+    linkPtr->link = LE_SLS_LINK_INIT;
+
+    if ( (le_utf8_Copy(linkPtr->src, srcPtr, sizeof(linkPtr->src), NULL) != LE_OK) ||
+         (le_utf8_Copy(linkPtr->dest, destPtr, sizeof(linkPtr->dest), NULL) != LE_OK) )
+    {
+        LE_ERROR("Link from '%s' to '%s' for app '%s' is too long.",
+                 srcPtr, destPtr, planPtr->appName);
+        le_mem_Release(linkPtr);
+        return LE_FAULT;
+    }
+
+    le_sls_Queue(&(planPtr->links), &(linkPtr->link));
+    planPtr->numLinks++;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds links to the app's lib and bin files to the plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddLibBinLinks
+(
+    Plan_t* planPtr                     ///< [IN] Plan to add to.
+)
+{
+    // Create links to the apps lib directory.
+    char srcLib[LIMIT_MAX_PATH_BYTES] = "";
+
+    if (le_path_Concat("/", srcLib, sizeof(srcLib), planPtr->installDirPath, "read-only/lib", NULL)
+          != LE_OK)
+    {
+        LE_ERROR("App's install dir path too long!");
+        return LE_FAULT;
+    }
+
+    if (AddLink(planPtr, SANDBOXPLAN_TREE, srcLib, "/lib") != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    // Create links to the apps bin directory.
+    char srcBin[LIMIT_MAX_PATH_BYTES] = "";
+
+    if (le_path_Concat("/", srcBin, sizeof(srcBin), planPtr->installDirPath, "read-only/bin", NULL)
+          != LE_OK)
+    {
+        LE_ERROR("App's install dir path too long!");
+        return LE_FAULT;
+    }
+
+    return AddLink(planPtr, SANDBOXPLAN_TREE, srcBin, "/bin");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the source path for read only bundled files at the current node in the config iterator.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetBundledReadOnlySrcPath
+(
+    Plan_t* planPtr,                    ///< [IN] Plan being built.
+    le_cfg_IteratorRef_t cfgIter,       ///< [IN] Config iterator.
+    char* bufPtr,                       ///< [OUT] Buffer to store the source path.
+    size_t bufSize                      ///< [IN] Size of the buffer.
+)
+{
+    char srcPath[LIMIT_MAX_PATH_BYTES] = "";
+
+    if (le_cfg_GetString(cfgIter, "src", srcPath, sizeof(srcPath), "") != LE_OK)
+    {
+        LE_ERROR("Source file path '%s...' for app '%s' is too long.", srcPath, planPtr->appName);
+        return LE_FAULT;
+    }
+
+    if (strlen(srcPath) == 0)
+    {
+        LE_ERROR("Empty source file path supplied for app %s.", planPtr->appName);
+        return LE_FAULT;
+    }
+
+    if (srcPath[0] == '/')
+    {
+        // The source path is an absolute path so just copy it to the user's buffer.
+        if (le_utf8_Copy(bufPtr, srcPath, bufSize, NULL) != LE_OK)
+        {
+            LE_ERROR("Source file path '%s...' for app '%s' is too long.",
+                     srcPath, planPtr->appName);
+            return LE_FAULT;
+        }
+    }
+    else
+    {
+        // The source file path is relative to the app install directory.
+        bufPtr[0] = '\0';
+        if (LE_OK != le_path_Concat("/",
+                                    bufPtr,
+                                    bufSize,
+                                    planPtr->installDirPath,
+                                    "read-only",
+                                    srcPath,
+                                    NULL) )
+        {
+            LE_ERROR("Import source path '%s' for app '%s' is too long.", bufPtr, planPtr->appName);
+            return LE_FAULT;
+        }
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get a path for the app at the current node in the config iterator.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetPath
+(
+    Plan_t* planPtr,                    ///< [IN] Plan being built.
+    le_cfg_IteratorRef_t cfgIter,       ///< [IN] Config iterator.
+    const char* nodeNamePtr,            ///< [IN] Name of the node holding the path.
+    char* bufPtr,                       ///< [OUT] Buffer to store the path.
+    size_t bufSize                      ///< [IN] Size of the buffer.
+)
+{
+    if (le_cfg_GetString(cfgIter, nodeNamePtr, bufPtr, bufSize, "") != LE_OK)
+    {
+        LE_ERROR("The %s path '%s...' for app '%s' is too long.",
+                 nodeNamePtr, bufPtr, planPtr->appName);
+        return LE_FAULT;
+    }
+
+    if (bufPtr[0] == '\0')
+    {
+        LE_ERROR("Empty %s path supplied for app %s.", nodeNamePtr, planPtr->appName);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds links to the app's read only bundled files or directories under the current node in the
+ * config iterator to the plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddBundledLinks
+(
+    Plan_t* planPtr,                    ///< [IN] Plan to add to.
+    le_cfg_IteratorRef_t cfgIter,       ///< [IN] Config iterator.
+    sandboxPlan_LinkType_t type         ///< [IN] Type of link to add for each entry.
+)
+{
+    if (le_cfg_GoToFirstChild(cfgIter) == LE_OK)
+    {
+        do
+        {
+            // Only handle read only files.  Writable files are copied into the working area by
+            // the installer.
+            if (!le_cfg_GetBool(cfgIter, "isWritable", false))
+            {
+                char srcPath[LIMIT_MAX_PATH_BYTES];
+                char destPath[LIMIT_MAX_PATH_BYTES];
+
+                if ( (GetBundledReadOnlySrcPath(planPtr, cfgIter, srcPath, sizeof(srcPath))
+                          != LE_OK) ||
+                     (GetPath(planPtr, cfgIter, "dest", destPath, sizeof(destPath)) != LE_OK) ||
+                     (AddLink(planPtr, type, srcPath, destPath) != LE_OK) )
+                {
+                    return LE_FAULT;
+                }
+            }
+        }
+        while (le_cfg_GoToNextSibling(cfgIter) == LE_OK);
+
+        le_cfg_GoToParent(cfgIter);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds links to the app's required files or devices under the current node in the config iterator
+ * to the plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddRequiredFileLinks
+(
+    Plan_t* planPtr,                    ///< [IN] Plan to add to.
+    le_cfg_IteratorRef_t cfgIter        ///< [IN] Config iterator.
+)
+{
+    if (le_cfg_GoToFirstChild(cfgIter) == LE_OK)
+    {
+        do
+        {
+            char srcPath[LIMIT_MAX_PATH_BYTES];
+            char destPath[LIMIT_MAX_PATH_BYTES];
+
+            if ( (GetPath(planPtr, cfgIter, "src", srcPath, sizeof(srcPath)) != LE_OK) ||
+                 (GetPath(planPtr, cfgIter, "dest", destPath, sizeof(destPath)) != LE_OK) ||
+                 (AddLink(planPtr, SANDBOXPLAN_FILE, srcPath, destPath) != LE_OK) )
+            {
+                return LE_FAULT;
+            }
+        }
+        while (le_cfg_GoToNextSibling(cfgIter) == LE_OK);
+
+        le_cfg_GoToParent(cfgIter);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds links to the app's required directories under the current node in the config iterator to
+ * the plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddRequiredDirLinks
+(
+    Plan_t* planPtr,                    ///< [IN] Plan to add to.
+    le_cfg_IteratorRef_t cfgIter        ///< [IN] Config iterator.
+)
+{
+    if (le_cfg_GoToFirstChild(cfgIter) == LE_OK)
+    {
+        do
+        {
+            char srcPath[LIMIT_MAX_PATH_BYTES];
+            char destPath[LIMIT_MAX_PATH_BYTES];
+
+            if ( (GetPath(planPtr, cfgIter, "src", srcPath, sizeof(srcPath)) != LE_OK) ||
+                 (GetPath(planPtr, cfgIter, "dest", destPath, sizeof(destPath)) != LE_OK) )
+            {
+                return LE_FAULT;
+            }
+
+            sandboxPlan_LinkType_t type = SANDBOXPLAN_TREE;
+
+            // Treat /proc and /sys differently.  These are kernel file systems that user space
+            // processes cannot write create files in.  So it is safe to create a link to the
+            // entire directory.
+            if ( le_path_IsEquivalent("/proc", srcPath, "/") ||
+                 le_path_IsEquivalent("/sys", srcPath, "/") ||
+                 le_path_IsSubpath("/proc", srcPath, "/") ||
+                 le_path_IsSubpath("/sys", srcPath, "/") )
+            {
+                type = SANDBOXPLAN_DIR;
+            }
+            // Treat /dev/shm differently.  These are shared memory expected to be shared between
+            // other apps but also other userland processes.  So export the entire directory.
+            else if (le_path_IsEquivalent("/dev/shm", srcPath, "/") ||
+                     le_path_IsSubpath("/dev/shm", srcPath, "/"))
+            {
+                type = SANDBOXPLAN_SHARED_DIR;
+            }
+
+            if (AddLink(planPtr, type, srcPath, destPath) != LE_OK)
+            {
+                return LE_FAULT;
+            }
+        }
+        while (le_cfg_GoToNextSibling(cfgIter) == LE_OK);
+
+        le_cfg_GoToParent(cfgIter);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds the links for all the app's bundled and required files to the plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddConfiguredLinks
+(
+    Plan_t* planPtr                     ///< [IN] Plan to add to.
+)
+{
+    char cfgPath[LIMIT_MAX_PATH_BYTES] = "";
+
+    if (le_path_Concat("/", cfgPath, sizeof(cfgPath),
+                       CFG_NODE_APPS_LIST, planPtr->appName, NULL) != LE_OK)
+    {
+        LE_ERROR("Config path for app '%s' is too long.", planPtr->appName);
+        return LE_FAULT;
+    }
+
+    le_cfg_IteratorRef_t appCfg = le_cfg_CreateReadTxn(cfgPath);
+    le_result_t result = LE_FAULT;
+
+    // Bundled directories and files.
+    le_cfg_GoToNode(appCfg, CFG_NODE_BUNDLES "/" CFG_NODE_DIRS);
+    if (AddBundledLinks(planPtr, appCfg, SANDBOXPLAN_TREE) != LE_OK)
+    {
+        goto done;
+    }
+
+    le_cfg_GoToNode(appCfg, "../" CFG_NODE_FILES);
+    if (AddBundledLinks(planPtr, appCfg, SANDBOXPLAN_FILE) != LE_OK)
+    {
+        goto done;
+    }
+
+    // Required directories, files and devices.
+    le_cfg_GoToNode(appCfg, "../../" CFG_NODE_REQUIRES "/" CFG_NODE_DIRS);
+    if (AddRequiredDirLinks(planPtr, appCfg) != LE_OK)
+    {
+        goto done;
+    }
+
+    le_cfg_GoToNode(appCfg, "../" CFG_NODE_FILES);
+    if (AddRequiredFileLinks(planPtr, appCfg) != LE_OK)
+    {
+        goto done;
+    }
+
+    le_cfg_GoToNode(appCfg, "../" CFG_NODE_DEVICES);
+    if (AddRequiredFileLinks(planPtr, appCfg) != LE_OK)
+    {
+        goto done;
+    }
+
+    result = LE_OK;
+
+done:
+    le_cfg_CancelTxn(appCfg);
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parses a link line from a saved plan and adds the link to the plan.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FORMAT_ERROR if the line is not a valid link.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ParseLink
+(
+    Plan_t* planPtr,                    ///< [IN] Plan to add to.
+    char* linePtr                       ///< [IN] Line, without the trailing newline.
+)
+{
+    char* savePtr = NULL;
+    char* typePtr = strtok_r(linePtr, "\t", &savePtr);
+    char* srcPtr = strtok_r(NULL, "\t", &savePtr);
+    char* destPtr = strtok_r(NULL, "\t", &savePtr);
+
+    if ((typePtr == NULL) || (srcPtr == NULL) || (destPtr == NULL))
+    {
+        return LE_FORMAT_ERROR;
+    }
+
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(LinkTypeNames); i++)
+    {
+        if (strcmp(typePtr, LinkTypeNames[i]) == 0)
+        {
+            return (AddLink(planPtr, i, srcPtr, destPtr) == LE_OK) ? LE_OK : LE_FORMAT_ERROR;
+        }
+    }
+
+    return LE_FORMAT_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads a "<key>\t<value>" line from a saved plan and checks that it has the expected key and
+ * value.
+ *
+ * @return
+ *      true if the line matches.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsExpectedLine
+(
+    FILE* filePtr,                      ///< [IN] Plan file.
+    const char* keyPtr,                 ///< [IN] Expected key, or NULL for a line with no key.
+    const char* valuePtr                ///< [IN] Expected value.
+)
+{
+    char line[MAX_LINE_BYTES];
+
+    if (fgets(line, sizeof(line), filePtr) == NULL)
+    {
+        return false;
+    }
+
+    line[strcspn(line, "\n")] = '\0';
+
+    if (keyPtr == NULL)
+    {
+        return (strcmp(line, valuePtr) == 0);
+    }
+
+    size_t keyLen = strlen(keyPtr);
+
+    return (strncmp(line, keyPtr, keyLen) == 0) &&
+           (line[keyLen] == '\t') &&
+           (strcmp(line + keyLen + 1, valuePtr) == 0);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the sandbox plan module.  Must be called before any other function in this module.
+ */
+//--------------------------------------------------------------------------------------------------
+void sandboxPlan_Init
+(
+    void
+)
+{
+    PlanPool = le_mem_CreatePool("SandboxPlans", sizeof(Plan_t));
+    le_mem_SetDestructor(PlanPool, PlanDestructor);
+
+    LinkPool = le_mem_CreatePool("SandboxPlanLinks", sizeof(sandboxPlan_Link_t));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the hash of the installed version of an app.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_NOT_FOUND if the app is not installed or has no hash.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t sandboxPlan_GetAppHash
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    char* bufPtr,                       ///< [OUT] Buffer to store the hash string.
+    size_t bufSize                      ///< [IN] Size of the buffer.
+)
+{
+    char infoFilePath[LIMIT_MAX_PATH_BYTES] = "";
+
+    if ( (le_path_Concat("/", infoFilePath, sizeof(infoFilePath),
+                         APPS_INSTALL_DIR, appNamePtr, APP_INFO_FILE, NULL) != LE_OK) ||
+         (access(infoFilePath, R_OK) != 0) ||
+         (properties_GetValueForKey(infoFilePath, APP_INFO_KEY_MD5, bufPtr, bufSize) != LE_OK) )
+    {
+        if (bufSize > 0)
+        {
+            bufPtr[0] = '\0';
+        }
+        return LE_NOT_FOUND;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the sandbox plan for an installed app from the app's configuration in the system config
+ * tree.  Must be called from a thread that is connected to the le_cfg service.
+ *
+ * @return
+ *      Reference to the plan, or NULL if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+sandboxPlan_Ref_t sandboxPlan_Build
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    const char* hashPtr                 ///< [IN] Hash of the installed app, or "" if unknown.
+)
+{
+    Plan_t* planPtr = CreatePlan(appNamePtr, hashPtr);
+
+    if (planPtr == NULL)
+    {
+        return NULL;
+    }
+
+    if ( (AddLibBinLinks(planPtr) != LE_OK) ||
+         (AddConfiguredLinks(planPtr) != LE_OK) )
+    {
+        le_mem_Release(planPtr);
+        return NULL;
+    }
+
+    return planPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Loads an app's saved sandbox plan.
+ *
+ * @return
+ *      Reference to the plan.
+ *      NULL if there is no saved plan for this version of the app or the plan could not be read.
+ */
+//--------------------------------------------------------------------------------------------------
+sandboxPlan_Ref_t sandboxPlan_Load
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    const char* hashPtr                 ///< [IN] Hash of the installed app.
+)
+{
+    char path[LIMIT_MAX_PATH_BYTES];
+
+    if ( (hashPtr[0] == '\0') ||
+         (snprintf(path, sizeof(path), PLAN_FILE_PATH_FORMAT, hashPtr) >= (int)sizeof(path)) )
+    {
+        return NULL;
+    }
+
+    FILE* filePtr = fopen(path, "r");
+
+    if (filePtr == NULL)
+    {
+        if (errno != ENOENT)
+        {
+            LE_WARN("Could not open sandbox plan '%s'.  %m.", path);
+        }
+        return NULL;
+    }
+
+    Plan_t* planPtr = CreatePlan(appNamePtr, hashPtr);
+
+    if (planPtr == NULL)
+    {
+        fclose(filePtr);
+        return NULL;
+    }
+
+    // The plan must have been saved for this app and this version of the app.
+    if ( !IsExpectedLine(filePtr, NULL, PLAN_FILE_HEADER) ||
+         !IsExpectedLine(filePtr, "app", appNamePtr) ||
+         !IsExpectedLine(filePtr, "hash", hashPtr) )
+    {
+        LE_WARN("Ignoring stale sandbox plan '%s'.", path);
+        goto failed;
+    }
+
+    char line[MAX_LINE_BYTES];
+
+    while (fgets(line, sizeof(line), filePtr) != NULL)
+    {
+        size_t len = strcspn(line, "\n");
+
+        if (line[len] != '\n')
+        {
+            LE_WARN("Truncated line in sandbox plan '%s'.", path);
+            goto failed;
+        }
+
+        line[len] = '\0';
+
+        if (ParseLink(planPtr, line) != LE_OK)
+        {
+            LE_WARN("Invalid line in sandbox plan '%s'.", path);
+            goto failed;
+        }
+    }
+
+    if (ferror(filePtr))
+    {
+        LE_WARN("Could not read sandbox plan '%s'.", path);
+        goto failed;
+    }
+
+    fclose(filePtr);
+    return planPtr;
+
+failed:
+    fclose(filePtr);
+    le_mem_Release(planPtr);
+    return NULL;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saves a sandbox plan next to the installed files of the version of the app it was built for.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_NOT_PERMITTED if the plan has no hash or the file system is read-only.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t sandboxPlan_Save
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan to save.
+)
+{
+    char path[LIMIT_MAX_PATH_BYTES];
+    char tmpPath[LIMIT_MAX_PATH_BYTES];
+
+    if ( (planRef->hash[0] == '\0') ||
+         (snprintf(path, sizeof(path), PLAN_FILE_PATH_FORMAT, planRef->hash) >= (int)sizeof(path)) ||
+         (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int)sizeof(tmpPath)) )
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    FILE* filePtr = fopen(tmpPath, "w");
+
+    if (filePtr == NULL)
+    {
+        if (errno == EROFS)
+        {
+            return LE_NOT_PERMITTED;
+        }
+
+        LE_WARN("Could not create sandbox plan '%s'.  %m.", tmpPath);
+        return LE_FAULT;
+    }
+
+    fprintf(filePtr, "%s\napp\t%s\nhash\t%s\n", PLAN_FILE_HEADER, planRef->appName, planRef->hash);
+
+    const sandboxPlan_Link_t* linkPtr = sandboxPlan_GetFirstLink(planRef);
+
+    while (linkPtr != NULL)
+    {
+        fprintf(filePtr, "%s\t%s\t%s\n",
+                LinkTypeNames[linkPtr->type], linkPtr->src, linkPtr->dest);
+
+        linkPtr = sandboxPlan_GetNextLink(planRef, linkPtr);
+    }
+
+    // Make sure the plan is complete on disk before it replaces any previous one.
+    if ( (fflush(filePtr) != 0) || (fsync(fileno(filePtr)) != 0) || ferror(filePtr) )
+    {
+        LE_WARN("Could not write sandbox plan '%s'.  %m.", tmpPath);
+        fclose(filePtr);
+        unlink(tmpPath);
+        return LE_FAULT;
+    }
+
+    fclose(filePtr);
+
+    if (rename(tmpPath, path) != 0)
+    {
+        LE_WARN("Could not rename '%s' to '%s'.  %m.", tmpPath, path);
+        unlink(tmpPath);
+        return LE_FAULT;
+    }
+
+    LE_INFO("Saved sandbox plan for app '%s' (%zu links).", planRef->appName, planRef->numLinks);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the sandbox plan for an installed app.  The saved plan is used if there is one for the
+ * installed version of the app, otherwise the plan is built from the app's configuration and saved.
+ * Must be called from a thread that is connected to the le_cfg service.
+ *
+ * @return
+ *      Reference to the plan, or NULL if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+sandboxPlan_Ref_t sandboxPlan_Get
+(
+    const char* appNamePtr              ///< [IN] Name of the app.
+)
+{
+    char hash[LIMIT_MD5_STR_BYTES];
+
+    if (sandboxPlan_GetAppHash(appNamePtr, hash, sizeof(hash)) == LE_OK)
+    {
+        sandboxPlan_Ref_t planRef = sandboxPlan_Load(appNamePtr, hash);
+
+        if (planRef != NULL)
+        {
+            LE_DEBUG("Loaded sandbox plan for app '%s'.", appNamePtr);
+            return planRef;
+        }
+    }
+
+    sandboxPlan_Ref_t planRef = sandboxPlan_Build(appNamePtr, hash);
+
+    if (planRef != NULL)
+    {
+        sandboxPlan_Save(planRef);
+    }
+
+    return planRef;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether two plans contain the same links in the same order.
+ *
+ * @return
+ *      true if the plans are equivalent.
+ */
+//--------------------------------------------------------------------------------------------------
+bool sandboxPlan_IsEqual
+(
+    sandboxPlan_Ref_t plan1Ref,         ///< [IN] First plan.
+    sandboxPlan_Ref_t plan2Ref          ///< [IN] Second plan.
+)
+{
+    if (plan1Ref->numLinks != plan2Ref->numLinks)
+    {
+        return false;
+    }
+
+    const sandboxPlan_Link_t* link1Ptr = sandboxPlan_GetFirstLink(plan1Ref);
+    const sandboxPlan_Link_t* link2Ptr = sandboxPlan_GetFirstLink(plan2Ref);
+
+    while ((link1Ptr != NULL) && (link2Ptr != NULL))
+    {
+        if ( (link1Ptr->type != link2Ptr->type) ||
+             (strcmp(link1Ptr->src, link2Ptr->src) != 0) ||
+             (strcmp(link1Ptr->dest, link2Ptr->dest) != 0) )
+        {
+            return false;
+        }
+
+        link1Ptr = sandboxPlan_GetNextLink(plan1Ref, link1Ptr);
+        link2Ptr = sandboxPlan_GetNextLink(plan2Ref, link2Ptr);
+    }
+
+    return (link1Ptr == NULL) && (link2Ptr == NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name of the app a plan was built for.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* sandboxPlan_GetAppName
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+)
+{
+    return planRef->appName;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the hash of the app a plan was built for.  This is "" if the app's hash was unknown.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* sandboxPlan_GetHash
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+)
+{
+    return planRef->hash;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of links in a plan.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t sandboxPlan_GetNumLinks
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+)
+{
+    return planRef->numLinks;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the first link in a plan.
+ *
+ * @return
+ *      The first link, or NULL if the plan is empty.
+ */
+//--------------------------------------------------------------------------------------------------
+const sandboxPlan_Link_t* sandboxPlan_GetFirstLink
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+)
+{
+    le_sls_Link_t* linkPtr = le_sls_Peek(&(planRef->links));
+
+    return (linkPtr == NULL) ? NULL : CONTAINER_OF(linkPtr, sandboxPlan_Link_t, link);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the link after a given link in a plan.
+ *
+ * @return
+ *      The next link, or NULL if the given link is the last one.
+ */
+//--------------------------------------------------------------------------------------------------
+const sandboxPlan_Link_t* sandboxPlan_GetNextLink
+(
+    sandboxPlan_Ref_t planRef,          ///< [IN] Plan.
+    const sandboxPlan_Link_t* linkPtr   ///< [IN] Current link.
+)
+{
+    le_sls_Link_t* nextPtr = le_sls_PeekNext(&(planRef->links), (le_sls_Link_t*)&(linkPtr->link));
+
+    return (nextPtr == NULL) ? NULL : CONTAINER_OF(nextPtr, sandboxPlan_Link_t, link);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name used for a link type in saved plans.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* sandboxPlan_GetLinkTypeName
+(
+    sandboxPlan_LinkType_t type         ///< [IN] Link type.
+)
+{
+    LE_ASSERT(type < NUM_ARRAY_MEMBERS(LinkTypeNames));
+
+    return LinkTypeNames[type];
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Increments the reference count of a plan.
+ */
+//--------------------------------------------------------------------------------------------------
+void sandboxPlan_AddRef
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+)
+{
+    le_mem_AddRef(planRef);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases a plan.  The plan is deleted when its last reference is released.
+ */
+//--------------------------------------------------------------------------------------------------
+void sandboxPlan_Release
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+)
+{
+    le_mem_Release(planRef);
+}
@@ -0,0 +1,279 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file sandboxPlan.h
+ *
+ * A sandbox plan is the list of links that the Supervisor creates in an app's working area: the
+ * app's lib and bin files, its read-only bundled files and its required files, directories and
+ * devices.  The plan is resolved from the app's configuration and can be saved next to the app's
+ * installed files (/legato/apps/<hash>/sandbox.plan), so that an app that has not changed since
+ * the plan was saved can be set up without reading its configuration again.
+ *
+ * Plans are generated by the Update Daemon when an app is installed, or by the Supervisor the first
+ * time an app is started, and can be examined with the on-target sandboxPlan tool.
+ *
+ * The default links that all sandboxed apps get are not part of the plan since they depend on the
+ * framework rather than on the app.
+ *
+ * This file exposes interfaces that are for use by the framework daemons and tools only.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LEGATO_SANDBOX_PLAN_H_INCLUDE_GUARD
+#define LEGATO_SANDBOX_PLAN_H_INCLUDE_GUARD
+
+#include "limit.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Name of the plan file in the app's install directory.
+ */
+//--------------------------------------------------------------------------------------------------
+#define SANDBOXPLAN_FILE_NAME                   "sandbox.plan"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * How a link in the plan is to be created in the app's working area.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    SANDBOXPLAN_FILE,           ///< Link a single file or device.
+    SANDBOXPLAN_DIR,            ///< Link the directory itself (used for /proc and /sys).
+    SANDBOXPLAN_SHARED_DIR,     ///< Link the directory itself and make it accessible to all.
+    SANDBOXPLAN_TREE            ///< Individually link every file under the directory.
+}
+sandboxPlan_LinkType_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A single link in a sandbox plan.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    sandboxPlan_LinkType_t type;        ///< How the link is to be created.
+    char src[LIMIT_MAX_PATH_BYTES];     ///< Absolute path to the source.
+    char dest[LIMIT_MAX_PATH_BYTES];    ///< Dest path relative to the application's runtime area.
+                                        ///  If this ends in a separator then the last node of the
+                                        ///  source is appended.
+    le_sls_Link_t link;                 ///< Link in the plan's list of links.
+}
+sandboxPlan_Link_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to a sandbox plan.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct sandboxPlan* sandboxPlan_Ref_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the sandbox plan module.  Must be called before any other function in this module.
+ */
+//--------------------------------------------------------------------------------------------------
+void sandboxPlan_Init
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reads the hash of the installed version of an app.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_NOT_FOUND if the app is not installed or has no hash.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t sandboxPlan_GetAppHash
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    char* bufPtr,                       ///< [OUT] Buffer to store the hash string.
+    size_t bufSize                      ///< [IN] Size of the buffer.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the sandbox plan for an installed app from the app's configuration in the system config
+ * tree.  Must be called from a thread that is connected to the le_cfg service.
+ *
+ * @return
+ *      Reference to the plan, or NULL if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+sandboxPlan_Ref_t sandboxPlan_Build
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    const char* hashPtr                 ///< [IN] Hash of the installed app, or "" if unknown.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Loads an app's saved sandbox plan.
+ *
+ * @return
+ *      Reference to the plan.
+ *      NULL if there is no saved plan for this version of the app or the plan could not be read.
+ */
+//--------------------------------------------------------------------------------------------------
+sandboxPlan_Ref_t sandboxPlan_Load
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    const char* hashPtr                 ///< [IN] Hash of the installed app.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Saves a sandbox plan next to the installed files of the version of the app it was built for.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_NOT_PERMITTED if the plan has no hash or the file system is read-only.
+ *      LE_FAULT if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t sandboxPlan_Save
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan to save.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the sandbox plan for an installed app.  The saved plan is used if there is one for the
+ * installed version of the app, otherwise the plan is built from the app's configuration and saved.
+ * Must be called from a thread that is connected to the le_cfg service.
+ *
+ * @return
+ *      Reference to the plan, or NULL if there was an error.
+ */
+//--------------------------------------------------------------------------------------------------
+sandboxPlan_Ref_t sandboxPlan_Get
+(
+    const char* appNamePtr              ///< [IN] Name of the app.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether two plans contain the same links in the same order.
+ *
+ * @return
+ *      true if the plans are equivalent.
+ */
+//--------------------------------------------------------------------------------------------------
+bool sandboxPlan_IsEqual
+(
+    sandboxPlan_Ref_t plan1Ref,         ///< [IN] First plan.
+    sandboxPlan_Ref_t plan2Ref          ///< [IN] Second plan.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name of the app a plan was built for.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* sandboxPlan_GetAppName
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the hash of the app a plan was built for.  This is "" if the app's hash was unknown.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* sandboxPlan_GetHash
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of links in a plan.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t sandboxPlan_GetNumLinks
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the first link in a plan.
+ *
+ * @return
+ *      The first link, or NULL if the plan is empty.
+ */
+//--------------------------------------------------------------------------------------------------
+const sandboxPlan_Link_t* sandboxPlan_GetFirstLink
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the link after a given link in a plan.
+ *
+ * @return
+ *      The next link, or NULL if the given link is the last one.
+ */
+//--------------------------------------------------------------------------------------------------
+const sandboxPlan_Link_t* sandboxPlan_GetNextLink
+(
+    sandboxPlan_Ref_t planRef,          ///< [IN] Plan.
+    const sandboxPlan_Link_t* linkPtr   ///< [IN] Current link.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name used for a link type in saved plans.
+ */
+//--------------------------------------------------------------------------------------------------
+const char* sandboxPlan_GetLinkTypeName
+(
+    sandboxPlan_LinkType_t type         ///< [IN] Link type.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Increments the reference count of a plan.
+ */
+//--------------------------------------------------------------------------------------------------
+void sandboxPlan_AddRef
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Releases a plan.  The plan is deleted when its last reference is released.
+ */
+//--------------------------------------------------------------------------------------------------
+void sandboxPlan_Release
+(
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan.
+);
+
+
+#endif // LEGATO_SANDBOX_PLAN_H_INCLUDE_GUARD
@@ -81,6 +81,27 @@ static void OnConfigAdminSessionClosed
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  When the supervisor shuts us down, make sure that any committed changes that are still waiting
+ *  to be written have made it to the filesystem before exiting.
+ */
+// -------------------------------------------------------------------------------------------------
+static void SigTermEventHandler
+(
+    int sigNum  ///< [IN] The signal that was received.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    LE_INFO("Flushing pending configuration writes before exiting.");
+
+    tdb_FlushPendingWrites();
+    exit(EXIT_SUCCESS);
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Initialize the configTree server interfaces and all of it's subsystems.
@@ -99,6 +120,10 @@ COMPONENT_INIT
     tdb_Init();    // Tree DB.
     ic_Init();     // Internal config, this depends on other subsystems and so need to go last.
 
+    // Trees are written by a background thread, so flush its queue before exiting on SIGTERM.
+    le_sig_Block(SIGTERM);
+    le_sig_SetEventHandler(SIGTERM, SigTermEventHandler);
+
     // Register our service handlers on those services so that we can properly free up resources if
     // clients unexpectedly disconnect.
     LE_DEBUG("** Setting up service event handlers.");
@@ -720,6 +720,72 @@ void le_cfg_RemoveChangeHandler
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Register a call back on a given node object, to be called with the list of paths that changed
+ *  at or below that node.  The call back is held until no more changes have been made for
+ *  debounceMs milliseconds.
+ *
+ *  @return A handle to the event registration.
+ */
+// -------------------------------------------------------------------------------------------------
+le_cfg_ChangeSetHandlerRef_t le_cfg_AddChangeSetHandler
+(
+    const char* newPathPtr,                    ///< [IN] Path to the object to watch.
+    uint32_t debounceMs,                       ///< [IN] How long the node must be quiet before
+                                               ///<      notifying, in ms.
+    le_cfg_ChangeSetHandlerFunc_t handlerPtr,  ///< [IN] Function to call back.
+    void* contextPtr                           ///< [IN] Context to give the function when called.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tu_UserRef_t userRef = tu_GetCurrentConfigUserInfo();
+    le_cfg_ChangeSetHandlerRef_t handlerRef = NULL;
+
+    if (userRef != NULL)
+    {
+        tdb_TreeRef_t treeRef = tu_GetRequestedTree(userRef, TU_TREE_READ, newPathPtr);
+
+        if (treeRef != NULL)
+        {
+            handlerRef = tdb_AddChangeSetHandler(treeRef,
+                                                 le_cfg_GetClientSessionRef(),
+                                                 newPathPtr,
+                                                 debounceMs,
+                                                 handlerPtr,
+                                                 contextPtr);
+        }
+    }
+
+    if (handlerRef == NULL)
+    {
+        tu_TerminateConfigClient(le_cfg_GetClientSessionRef(),
+                                 "Change set handler registration failed.");
+    }
+
+    return handlerRef;
+}
+
+
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function removes a change set handler.
+ */
+//--------------------------------------------------------------------------------------------------
+void le_cfg_RemoveChangeSetHandler
+(
+    le_cfg_ChangeSetHandlerRef_t handlerRef  ///< [IN] Previously registered handler to remove.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tdb_RemoveChangeHandler((le_cfg_ChangeHandlerRef_t)handlerRef, le_cfg_GetClientSessionRef());
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 //  Transactional reading/writing, creation/deletion.
 // -------------------------------------------------------------------------------------------------
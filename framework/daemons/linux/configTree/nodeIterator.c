@@ -576,6 +576,29 @@ tdb_TreeRef_t ni_GetTree
 
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Move a read iterator onto another version of the tree it was created on.  The iterator's
+ *  current node is looked up again, by path, in the new tree.
+ */
+//--------------------------------------------------------------------------------------------------
+void ni_SetTree
+(
+    ni_IteratorRef_t iteratorRef,  ///< [IN] The iterator object to update.
+    tdb_TreeRef_t treeRef          ///< [IN] The tree to move the iterator onto.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(iteratorRef != NULL);
+    LE_ASSERT(ni_IsWriteable(iteratorRef) == false);
+
+    iteratorRef->treeRef = treeRef;
+    iteratorRef->currentNodeRef = tdb_GetNode(tdb_GetRootNode(treeRef), iteratorRef->pathIterRef);
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  This function will find all iterators that have active safe refs.  For each found
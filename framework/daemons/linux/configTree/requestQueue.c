@@ -43,7 +43,6 @@ typedef enum
     RQ_INVALID,
 
     RQ_CREATE_WRITE_TXN,
-    RQ_COMMIT_WRITE_TXN,
     RQ_CREATE_READ_TXN,
     RQ_DELETE_TXN,
 
@@ -84,12 +83,6 @@ typedef struct UpdateRequest
         }
         createTxn;                               ///< Create new transaction info.
 
-        struct
-        {
-            ni_IteratorRef_t iteratorRef;        ///< Ptr to the iterator to commit.
-        }
-        commitTxn;
-
         struct
         {
             ni_IteratorRef_t iteratorRef;        ///< Ptr to the iterator to commit.
@@ -113,6 +106,8 @@ typedef struct UpdateRequest
     }
     data;
 
+    le_clk_Time_t queueTime;                     ///< When the request was queued.
+
     le_sls_Link_t link;                     ///< Link to the next request in the queue.
 }
 UpdateRequest_t;
@@ -120,6 +115,43 @@ UpdateRequest_t;
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  If a request had to wait in the queue for longer than this, a warning is logged.
+ */
+// -------------------------------------------------------------------------------------------------
+#define RQ_LATENCY_WARN_USEC 1000000
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  A summary of the queuing latency is logged every time this many queued requests have been
+ *  processed.
+ */
+// -------------------------------------------------------------------------------------------------
+#define RQ_LATENCY_REPORT_INTERVAL 100
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Running statistics on how long requests have had to wait in the queues before being processed.
+ */
+// -------------------------------------------------------------------------------------------------
+static struct
+{
+    uint64_t count;      ///< Number of queued requests processed.
+    uint64_t totalUsec;  ///< Total time spent waiting by those requests.
+    uint64_t maxUsec;    ///< Longest time any one request had to wait.
+}
+QueueLatency;
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  When client sessions are closed, this structure is used as part of the clean up process.
@@ -202,6 +234,8 @@ static void QueueRequest
 // -------------------------------------------------------------------------------------------------
 {
     LE_DEBUG("** Queuing request block <%p>.", requestPtr);
+
+    requestPtr->queueTime = le_clk_GetRelativeTime();
     le_sls_Queue(listPtr, &(requestPtr->link));
 }
 
@@ -271,6 +305,48 @@ static void QueueDeleteTxnRequest
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Update the queue latency statistics with a request that's about to be processed.
+ */
+// -------------------------------------------------------------------------------------------------
+static void RecordQueueLatency
+(
+    const UpdateRequest_t* requestPtr  ///< [IN] The request that's been taken off of the queue.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    le_clk_Time_t waitTime = le_clk_Sub(le_clk_GetRelativeTime(), requestPtr->queueTime);
+    uint64_t waitUsec = ((uint64_t)waitTime.sec * 1000000) + waitTime.usec;
+
+    QueueLatency.count++;
+    QueueLatency.totalUsec += waitUsec;
+
+    if (waitUsec > QueueLatency.maxUsec)
+    {
+        QueueLatency.maxUsec = waitUsec;
+    }
+
+    LE_DEBUG("** Request block <%p> waited %" PRIu64 " us in the queue.", requestPtr, waitUsec);
+
+    LE_WARN_IF(waitUsec > RQ_LATENCY_WARN_USEC,
+               "Request on tree '%s' waited %" PRIu64 " us in the queue.",
+               tdb_GetTreeName(requestPtr->treeRef),
+               waitUsec);
+
+    if ((QueueLatency.count % RQ_LATENCY_REPORT_INTERVAL) == 0)
+    {
+        LE_INFO("Queued requests: %" PRIu64 ", average wait %" PRIu64 " us, max wait %" PRIu64
+                " us.",
+                QueueLatency.count,
+                QueueLatency.totalUsec / QueueLatency.count,
+                QueueLatency.maxUsec);
+    }
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Process all of the queued requests.
@@ -313,6 +389,12 @@ static void ProcessRequestQueue
         {
             LE_DEBUG("** Process request block <%p>.", requestPtr);
 
+            // Internally generated deletes are never left waiting, so they don't count here.
+            if (requestPtr->type != RQ_DELETE_TXN)
+            {
+                RecordQueueLatency(requestPtr);
+            }
+
             switch (requestPtr->type)
             {
                 case RQ_CREATE_WRITE_TXN:
@@ -329,16 +411,6 @@ static void ProcessRequestQueue
                                               requestPtr->data.createTxn.pathPtr);
                     break;
 
-                case RQ_COMMIT_WRITE_TXN:
-                    LE_DEBUG("Committing deferred write txn for user %u (%s) on tree '%s'.",
-                             tu_GetUserId(requestPtr->userRef),
-                             tu_GetUserName(requestPtr->userRef),
-                             tdb_GetTreeName(requestPtr->treeRef));
-
-                    rq_HandleCommitTxnRequest(requestPtr->commandRef,
-                                              requestPtr->data.commitTxn.iteratorRef);
-                    break;
-
                case RQ_CREATE_READ_TXN:
                     LE_DEBUG("Starting deferred read txn for user %u (%s) on tree '%s'.",
                              tu_GetUserId(requestPtr->userRef),
@@ -471,14 +543,9 @@ static bool CanQuickSet
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // If there are active readers or writers on the tree then a quick write should be defered.
-    if (   (tdb_HasActiveReaders(treeRef) == false)
-        && (tdb_GetActiveWriteIter(treeRef) == NULL))
-    {
-        return true;
-    }
-
-    return false;
+    // If there is an active writer on the tree then a quick write should be defered.  Active readers
+    // don't matter, they're moved onto a snapshot of the tree when the write is committed.
+    return tdb_GetActiveWriteIter(treeRef) == NULL;
 }
 
 
@@ -613,7 +680,8 @@ void rq_HandleCreateTxnRequest
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Attempt to commit an outstanding write transaction.
+ *  Commit an outstanding write transaction.  Any readers still on the tree are moved onto a snapshot
+ *  of the tree, so the commit never has to wait for them.
  */
 // -------------------------------------------------------------------------------------------------
 void rq_HandleCommitTxnRequest
@@ -623,34 +691,20 @@ void rq_HandleCommitTxnRequest
 )
 //--------------------------------------------------------------------------------------------------
 {
-    if (ni_IsWriteable(iteratorRef) == false)
-    {
-        // Kill the iterator but do not try to comit it.
-        ni_Release(iteratorRef);
+    // Grab the queue now, the iterator is gone once released.
+    le_sls_List_t* queuePtr = tdb_GetRequestQueue(ni_GetTree(iteratorRef));
 
-        le_cfg_CommitTxnRespond(commandRef);
-        ProcessRequestQueue(tdb_GetRequestQueue(ni_GetTree(iteratorRef)), NULL);
-    }
-    else if (tdb_HasActiveReaders(ni_GetTree(iteratorRef)) == false)
+    if (ni_IsWriteable(iteratorRef))
     {
         ni_Close(iteratorRef);
         ni_Commit(iteratorRef);
-        ni_Release(iteratorRef);
-
-        le_cfg_CommitTxnRespond(commandRef);
-        ProcessRequestQueue(tdb_GetRequestQueue(ni_GetTree(iteratorRef)), NULL);
     }
-    else
-    {
-        UpdateRequest_t* requestPtr = NewRequestBlock(RQ_COMMIT_WRITE_TXN,
-                                                      ni_GetUser(iteratorRef),
-                                                      ni_GetTree(iteratorRef),
-                                                      ni_GetSession(iteratorRef),
-                                                      commandRef);
 
-        requestPtr->data.commitTxn.iteratorRef = iteratorRef;
-        QueueRequest(tdb_GetRequestQueue(ni_GetTree(iteratorRef)), requestPtr);
-    }
+    // Kill the iterator.  Read iterators are never committed.
+    ni_Release(iteratorRef);
+
+    le_cfg_CommitTxnRespond(commandRef);
+    ProcessRequestQueue(queuePtr, NULL);
 }
 
 
@@ -668,6 +722,9 @@ void rq_HandleCancelTxnRequest
 )
 //--------------------------------------------------------------------------------------------------
 {
+    // Grab the queue now, the iterator is gone once released.
+    le_sls_List_t* queuePtr = tdb_GetRequestQueue(ni_GetTree(iteratorRef));
+
     // Kill the iterator but do not try to comit it.
     ni_Release(iteratorRef);
 
@@ -680,7 +737,7 @@ void rq_HandleCancelTxnRequest
     }
 
     // Try to handle the tree's request backlog.  (If any.)
-    ProcessRequestQueue(tdb_GetRequestQueue(ni_GetTree(iteratorRef)), NULL);
+    ProcessRequestQueue(queuePtr, NULL);
 }
 
 
@@ -120,6 +120,40 @@
  *  in order to have a handler registed for it.  In fact, a handler will be called when a node is
  *  deleted and when it is recreated.
  *
+ *  To find the registrations affected by a change, the registrations are also indexed by a trie of
+ *  "watch" nodes, one per path segment, (the first level being the tree names.)  When a node is
+ *  changed its path is walked down the trie, and every registration passed along the way is
+ *  triggered.  Only the changed nodes themselves are looked up, not each of their ancestors, and
+ *  the lookup stops as soon as the path leaves the watched part of the tree.
+ *
+ *  Triggered registrations collect the set of changed paths, (relative to the registered path.)
+ *  Once the merge is done, plain change handlers are called once per registration.  Change set
+ *  handlers receive the collected paths in a single notification, optionally debounced so that a
+ *  burst of commits results in one notification.
+ *
+ *  <b>Snapshots:</b>
+ *
+ *  A write transaction is allowed to commit even if there are read transactions open on the tree.
+ *  Before the shadow tree is merged, a "snapshot" of the tree is taken and all of the open read
+ *  iterators are moved onto it.  So readers keep seeing the version of the tree they started with,
+ *  while the writer's changes are merged into the live tree.  A snapshot is freed once the last
+ *  read iterator on it is released.  Snapshots are only taken when there are readers to preserve.
+ *
+ *  A snapshot is built the same way as a write transaction's shadow tree, its nodes simply read
+ *  through to the live nodes they shadow.  Each live node keeps a list of the snapshot nodes
+ *  shadowing it.  Right before the merge changes a live node, (or releases it,) those snapshot
+ *  nodes are given their own copy of the node's contents and stop shadowing it.  So a commit only
+ *  copies the nodes it actually changes, and only while there are snapshots of the tree in use.
+ *
+ *  <b>Persistence:</b>
+ *
+ *  Once a merge is complete, the live tree is serialized into a memory buffer and handed off to a
+ *  dedicated persistence thread, which writes it to the filesystem.  This way flash writes are never
+ *  done on the main event loop.  If a newer version of a tree is committed before the persistence
+ *  thread gets to the previous one, the older buffer is simply replaced, so only the latest version
+ *  is written.  The revision ID of a tree's file is only maintained by the persistence thread, once
+ *  the tree has been loaded.
+ *
  *  Copyright (C) Sierra Wireless Inc.
  *
  */
@@ -149,6 +183,42 @@
 
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  A set of changed paths, as a newline separated list.
+ **/
+//--------------------------------------------------------------------------------------------------
+typedef struct ChangeSet
+{
+    char paths[LE_CFG_STR_LEN_BYTES];  ///< The changed paths.
+    size_t pathsLen;                   ///< Length of the path list.
+    uint32_t count;                    ///< Count of changes, including those that didn't fit.
+}
+ChangeSet_t;
+
+
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Node of the trie used to match changed paths to registrations.  Each node represents one segment
+ *  of a watched path.
+ **/
+//--------------------------------------------------------------------------------------------------
+typedef struct WatchNode
+{
+    char name[LE_CFG_NAME_LEN_BYTES];  ///< The path segment, or the tree name at the top level.
+    struct WatchNode* parentPtr;       ///< The node for the previous segment.
+    le_dls_List_t childList;           ///< Nodes for the following segments.
+    le_dls_Link_t link;                ///< Link in the parent's child list.
+    struct Registration* registrationPtr;  ///< Registration on this exact path, if any.
+    size_t useCount;                   ///< Number of registrations at or below this node.
+}
+WatchNode_t;
+
+
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Records the event registration for a given node in a given tree.
@@ -160,6 +230,9 @@ typedef struct Registration
                                                ///<   also include the tree name.
     bool triggered;                            ///< Has this registration been triggered for
                                                ///<   callback?
+    le_sls_Link_t triggeredLink;               ///< Link in the list of triggered registrations.
+    ChangeSet_t changes;                       ///< Paths changed by the current merge.
+    WatchNode_t* watchPtr;                     ///< This registration's node in the watch trie.
 
     union
     {
@@ -194,6 +267,13 @@ typedef struct Handler
     le_cfg_ChangeHandlerFunc_t handlerPtr;  ///< Function to call back.
     void* contextPtr;                       ///< Context to give the function when called.
 
+    le_cfg_ChangeSetHandlerFunc_t changeSetHandlerPtr;  ///< Function to call back with the set of
+                                                        ///<   changes, (instead of handlerPtr.)
+    uint32_t debounceMs;                    ///< How long to wait for changes to settle.
+    le_timer_Ref_t debounceTimerRef;        ///< Timer used to hold notifications while debouncing.
+    le_clk_Time_t firstChangeTime;          ///< When the pending changes started to collect.
+    ChangeSet_t pendingChanges;             ///< Changes waiting to be delivered.
+
     Registration_t* registrationPtr;        ///< The registration object this handler is attached
                                             ///<   to.
 
@@ -235,8 +315,9 @@ typedef enum
     NODE_FLAGS_UNSET = 0x0,  ///< No flags have been set.
     NODE_IS_SHADOW   = 0x1,  ///< The node is a shadow for a node in another tree.
     NODE_IS_MODIFIED = 0x2,  ///< This node has been modified.
-    NODE_IS_DELETED  = 0x4   ///< This node has been marked as deleted, the actual deletion will
+    NODE_IS_DELETED  = 0x4,  ///< This node has been marked as deleted, the actual deletion will
                              ///<   take place later.
+    NODE_IS_SNAPSHOT = 0x8   ///< The node belongs to a read only snapshot of a live tree.
 }
 NodeFlags_t;
 
@@ -257,6 +338,9 @@ typedef struct Node
     NodeFlags_t flags;               ///< Various flags set on the node.
     tdb_NodeRef_t shadowRef;         ///< If this node is shadowing another then the pointer to
                                      ///<   that shadowed node is here.
+    tdb_NodeRef_t snapshotRef;       ///< For a live node, the first of the snapshot nodes that
+                                     ///<   are still shadowing it.  For a snapshot node, the next
+                                     ///<   snapshot node shadowing the same live node.
 
     dstr_Ref_t nameRef;              ///< The name of this node.
 
@@ -307,12 +391,59 @@ typedef struct Tree
 
     le_sls_List_t requestList;            ///< Each tree maintains it's own list of pending
                                           ///<   requests.
+
+    struct Tree* liveTreeRef;             ///< If non-NULL then this tree is a read only snapshot
+                                          ///<   of an older version of this live tree.
+    size_t snapshotCount;                 ///< Count of the snapshots taken of this live tree that
+                                          ///<   are still in use.
+
+    struct PersistJob* pendingWritePtr;   ///< Write job for this tree that has been queued to the
+                                          ///<   persistence thread, but not yet picked up.
+                                          ///<   Protected by the PersistMutexRef.
 }
 Tree_t;
 
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  The kinds of work that can be given to the persistence thread.
+ */
+// -------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PERSIST_WRITE,   ///< Write a serialized tree to a new revision of the tree's file.
+    PERSIST_DELETE   ///< Delete all revisions of the tree's file.
+}
+PersistOp_t;
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  A unit of work queued to the persistence thread.  Jobs are allocated and freed by the main
+ *  thread.  The job holds a reference to its tree so that the tree object remains valid until the
+ *  job completes.
+ */
+// -------------------------------------------------------------------------------------------------
+typedef struct PersistJob
+{
+    PersistOp_t op;             ///< What should be done with the tree's file.
+    tdb_TreeRef_t treeRef;      ///< The tree being persisted.
+    le_dls_Link_t link;         ///< Link in the list of pending deletes, for delete jobs.
+    char* bufferPtr;            ///< Serialized contents of the tree, for write jobs.  Allocated
+                                ///<   with malloc() by open_memstream().  Protected by the
+                                ///<   PersistMutexRef until the job is picked up.
+    size_t bufferSize;          ///< Size of the serialized tree in bytes.
+    le_clk_Time_t queueTime;    ///< When the job was queued.
+}
+PersistJob_t;
+
+
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Types of lexical tokens that can be found in configuration data files.
@@ -388,6 +519,50 @@ static le_mem_PoolRef_t RegistrationPool = NULL;
 
 
 
+/// Pool for the watch trie nodes.
+static le_mem_PoolRef_t WatchNodePool = NULL;
+
+/// Name of the watch node pool.
+#define CFG_WATCH_NODE_POOL_NAME "WatchNodePool"
+
+/// Root of the watch trie, its children are the watched trees.
+static WatchNode_t WatchRoot = { .childList = LE_DLS_LIST_INIT, .link = LE_DLS_LINK_INIT };
+
+/// Registrations triggered by the merge in progress.
+static le_sls_List_t TriggeredList = LE_SLS_LIST_INIT;
+
+/// Notification for a debounced change set handler is never held longer than this.
+#define CFG_MAX_DEBOUNCE_MS 5000
+
+
+
+/// Pool for the persistence thread's jobs.
+static le_mem_PoolRef_t PersistJobPoolRef = NULL;
+
+/// Name of the persistence job pool.
+#define CFG_PERSIST_JOB_POOL_NAME "PersistJobPool"
+
+
+/// Thread that writes the trees to the filesystem.
+static le_thread_Ref_t PersistThreadRef = NULL;
+
+/// The main thread, where all tree object memory is managed.
+static le_thread_Ref_t MainThreadRef = NULL;
+
+/// Protects the tree's pending write jobs, and the count of outstanding jobs.
+static le_mutex_Ref_t PersistMutexRef = NULL;
+
+/// Count of jobs that have been queued to the persistence thread, but have not completed yet.
+static size_t PersistJobCount = 0;
+
+/// Posted by the persistence thread every time a job completes.
+static le_sem_Ref_t PersistDoneSemRef = NULL;
+
+/// Delete jobs that have not completed yet.  Protected by the PersistMutexRef.
+static le_dls_List_t PendingDeleteList = LE_DLS_LIST_INIT;
+
+
+
 
 // -------------------------------------------------------------------------------------------------
 /**
@@ -440,6 +615,57 @@ static void SetShadowFlag
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Clear the shadow flag in this node.
+ */
+// -------------------------------------------------------------------------------------------------
+static void ClearShadowFlag
+(
+    tdb_NodeRef_t nodeRef  ///< [IN] The node to update.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    nodeRef->flags &= ~NODE_IS_SHADOW;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Check to see if this node belongs to a snapshot.
+ */
+// -------------------------------------------------------------------------------------------------
+static bool IsSnapshot
+(
+    const tdb_NodeRef_t nodeRef  ///< [IN] The node to check.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    return (nodeRef->flags & NODE_IS_SNAPSHOT) != 0;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Set the snapshot flag in this node.
+ */
+// -------------------------------------------------------------------------------------------------
+static void SetSnapshotFlag
+(
+    tdb_NodeRef_t nodeRef  ///< [IN] The node to update.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    nodeRef->flags |= NODE_IS_SNAPSHOT;
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Check to see if this node has been modified.
@@ -562,6 +788,7 @@ static tdb_NodeRef_t NewNode
     newNodeRef->type = LE_CFG_TYPE_EMPTY;
     ClearFlags(newNodeRef);
     newNodeRef->shadowRef = NULL;
+    newNodeRef->snapshotRef = NULL;
     newNodeRef->nameRef = NULL;
     newNodeRef->siblingList = LE_DLS_LINK_INIT;
     memset(&newNodeRef->info, 0, sizeof(newNodeRef->info));
@@ -572,6 +799,36 @@ static tdb_NodeRef_t NewNode
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Remove a snapshot node from the list of snapshot nodes kept by the live node it's shadowing.
+ */
+// -------------------------------------------------------------------------------------------------
+static void UnlinkSnapshotNode
+(
+    tdb_NodeRef_t nodeRef  ///< [IN] The snapshot node to unlink.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tdb_NodeRef_t* linkPtr = &nodeRef->shadowRef->snapshotRef;
+
+    while (*linkPtr != NULL)
+    {
+        if (*linkPtr == nodeRef)
+        {
+            *linkPtr = nodeRef->snapshotRef;
+            break;
+        }
+
+        linkPtr = &(*linkPtr)->snapshotRef;
+    }
+
+    nodeRef->snapshotRef = NULL;
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  The node destructor function.  This will take care of freeing a node's string values and any
@@ -610,19 +867,30 @@ static void NodeDestructor
 
         case LE_CFG_TYPE_STEM:
             {
-                tdb_NodeRef_t childRef = tdb_GetFirstChildNode(nodeRef);
+                // Only release the children this node actually has.  Going through
+                // tdb_GetFirstChildNode would first shadow the original's children, just to free
+                // them again.
+                le_dls_Link_t* linkPtr = le_dls_Peek(&nodeRef->info.children);
 
-                while (childRef != NULL)
+                while (linkPtr != NULL)
                 {
-                    tdb_NodeRef_t nextChildRef = tdb_GetNextSiblingNode(childRef);
+                    le_dls_Link_t* nextLinkPtr = le_dls_PeekNext(&nodeRef->info.children, linkPtr);
 
-                    le_mem_Release(childRef);
-                    childRef = nextChildRef;
+                    le_mem_Release(CONTAINER_OF(linkPtr, Node_t, siblingList));
+                    linkPtr = nextLinkPtr;
                 }
             }
             break;
     }
 
+    // A snapshot node that is still shadowing a live node has to be taken off of that node's list.
+    if (   (IsSnapshot(nodeRef))
+        && (IsShadow(nodeRef))
+        && (nodeRef->shadowRef != NULL))
+    {
+        UnlinkSnapshotNode(nodeRef);
+    }
+
     if (nodeRef->parentRef != NULL)
     {
         LE_ASSERT(nodeRef->parentRef->type == LE_CFG_TYPE_STEM);
@@ -677,6 +945,37 @@ static tdb_NodeRef_t NewShadowNode
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Create a snapshot node that shadows the given live node, and add it to the live node's list of
+ *  snapshot nodes.  Until the live node is about to change, the snapshot node simply reads through
+ *  to it.
+ *
+ *  @return A new snapshot node.
+ */
+// -------------------------------------------------------------------------------------------------
+static tdb_NodeRef_t NewSnapshotNode
+(
+    tdb_NodeRef_t liveNodeRef  ///< [IN] The live node to shadow.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tdb_NodeRef_t newSnapshotRef = NewShadowNode(liveNodeRef);
+
+    // The snapshot only takes the live node's contents, not the flags of any pending changes.
+    ClearFlags(newSnapshotRef);
+    SetShadowFlag(newSnapshotRef);
+    SetSnapshotFlag(newSnapshotRef);
+
+    newSnapshotRef->snapshotRef = liveNodeRef->snapshotRef;
+    liveNodeRef->snapshotRef = newSnapshotRef;
+
+    return newSnapshotRef;
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Create a new node and insert it into the given node's children collection.
@@ -774,7 +1073,8 @@ static void ShadowChildren
 
     while (originalChildRef != NULL)
     {
-        tdb_NodeRef_t newShadowRef = NewShadowNode(originalChildRef);
+        tdb_NodeRef_t newShadowRef = IsSnapshot(shadowParentRef) ? NewSnapshotNode(originalChildRef)
+                                                                 : NewShadowNode(originalChildRef);
         newShadowRef->parentRef = shadowParentRef;
 
         le_dls_Queue(&shadowParentRef->info.children, &newShadowRef->siblingList);
@@ -1011,6 +1311,141 @@ static void PropagateValue
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Called before a live node is changed.  Every snapshot node that is still shadowing the live node
+ *  is given its own copy of the node's name, value and collection of children, and stops shadowing
+ *  it.  (The new children are themselves snapshot nodes shadowing the live node's children.)
+ */
+// -------------------------------------------------------------------------------------------------
+static void FreezeSnapshotNodes
+(
+    tdb_NodeRef_t liveNodeRef  ///< [IN] The live node that's about to change.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tdb_NodeRef_t snapshotNodeRef = liveNodeRef->snapshotRef;
+
+    while (snapshotNodeRef != NULL)
+    {
+        tdb_NodeRef_t nextSnapshotRef = snapshotNodeRef->snapshotRef;
+
+        ShadowChildren(snapshotNodeRef);
+
+        if (   (snapshotNodeRef->nameRef == NULL)
+            && (liveNodeRef->nameRef != NULL))
+        {
+            snapshotNodeRef->nameRef = dstr_NewFromDstr(liveNodeRef->nameRef);
+        }
+
+        PropagateValue(snapshotNodeRef);
+
+        snapshotNodeRef->shadowRef = NULL;
+        snapshotNodeRef->snapshotRef = NULL;
+        ClearShadowFlag(snapshotNodeRef);
+
+        snapshotNodeRef = nextSnapshotRef;
+    }
+
+    liveNodeRef->snapshotRef = NULL;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Make sure that the snapshot nodes for a live node exist.  Snapshot nodes are only created when
+ *  their parent's children are first shadowed, so this is done for each of the live node's parents,
+ *  from the root down.
+ */
+// -------------------------------------------------------------------------------------------------
+static void ExposeSnapshotNodes
+(
+    tdb_NodeRef_t liveNodeRef  ///< [IN] The live node whose children's snapshot nodes are needed.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    if (liveNodeRef == NULL)
+    {
+        return;
+    }
+
+    ExposeSnapshotNodes(liveNodeRef->parentRef);
+
+    tdb_NodeRef_t snapshotNodeRef = liveNodeRef->snapshotRef;
+
+    while (snapshotNodeRef != NULL)
+    {
+        ShadowChildren(snapshotNodeRef);
+        snapshotNodeRef = snapshotNodeRef->snapshotRef;
+    }
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Freeze the snapshot nodes of a live node and of all of it's children.
+ */
+// -------------------------------------------------------------------------------------------------
+static void FreezeSnapshotSubtree
+(
+    tdb_NodeRef_t liveNodeRef  ///< [IN] The live node that's about to be cleared or released.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    FreezeSnapshotNodes(liveNodeRef);
+
+    tdb_NodeRef_t childRef = tdb_GetFirstChildNode(liveNodeRef);
+
+    while (childRef != NULL)
+    {
+        FreezeSnapshotSubtree(childRef);
+        childRef = tdb_GetNextSiblingNode(childRef);
+    }
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Called before the merge changes a live node, so that any snapshots of the tree keep the node's
+ *  current contents.  Only the changed nodes are copied, the rest of a snapshot keeps reading
+ *  through to the live tree.
+ */
+// -------------------------------------------------------------------------------------------------
+static void PreserveSnapshots
+(
+    tdb_TreeRef_t treeRef,      ///< [IN] The live tree being changed.
+    tdb_NodeRef_t liveNodeRef,  ///< [IN] The node about to change.
+    bool includeChildren        ///< [IN] Are the node's children about to be released as well?
+)
+// -------------------------------------------------------------------------------------------------
+{
+    if (   (treeRef->snapshotCount == 0)
+        || (liveNodeRef == NULL))
+    {
+        return;
+    }
+
+    ExposeSnapshotNodes(liveNodeRef->parentRef);
+
+    if (includeChildren)
+    {
+        FreezeSnapshotSubtree(liveNodeRef);
+    }
+    else
+    {
+        FreezeSnapshotNodes(liveNodeRef);
+    }
+}
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Merge a shadow node with the original it represents.
@@ -1018,7 +1453,8 @@ static void PropagateValue
 // -------------------------------------------------------------------------------------------------
 static void MergeNode
 (
-    tdb_NodeRef_t nodeRef  ///< [IN] The shadow node to merge.
+    tdb_TreeRef_t treeRef,  ///< [IN] The live tree being merged into.
+    tdb_NodeRef_t nodeRef   ///< [IN] The shadow node to merge.
 )
 // -------------------------------------------------------------------------------------------------
 {
@@ -1043,6 +1479,8 @@ static void MergeNode
     // If this node has been marked as deleted, then simply drop the original node and move on.
     if (IsDeleted(nodeRef))
     {
+        PreserveSnapshots(treeRef, nodeRef->shadowRef, true);
+
         if (   (nodeRef->shadowRef != NULL)
             && (tdb_GetNodeParent(nodeRef->shadowRef) != NULL))
         {
@@ -1066,9 +1504,19 @@ static void MergeNode
         LE_ASSERT(nodeRef->parentRef != NULL);
         LE_ASSERT(nodeRef->parentRef->shadowRef != NULL);
 
+        PreserveSnapshots(treeRef, nodeRef->parentRef->shadowRef, false);
         nodeRef->shadowRef = originalRef = NewChildNode(nodeRef->parentRef->shadowRef);
     }
 
+    // Check the types of the original and the shadow nodes.  If the new node has been cleared,
+    // then the original node will be cleared out.  If the types have changed, then the original
+    // is also cleared so that we can properly populate it again.
+    le_cfg_nodeType_t nodeType = tdb_GetNodeType(nodeRef);
+    bool clearOriginal =    (nodeType == LE_CFG_TYPE_EMPTY)
+                         || (nodeType != originalRef->type);
+
+    PreserveSnapshots(treeRef, originalRef, clearOriginal);
+
     ClearModifiedFlag(originalRef);
 
     // If the name has been changed, then copy it over now.
@@ -1084,13 +1532,7 @@ static void MergeNode
         }
     }
 
-    // Check the types of the original and the shadow nodes.  If the new node has been cleared,
-    // then clear out the original node.  If the types have changed, then clear out the original so
-    // that we can properly populate it again.
-    le_cfg_nodeType_t nodeType = tdb_GetNodeType(nodeRef);
-
-    if (   (nodeType == LE_CFG_TYPE_EMPTY)
-        || (nodeType != originalRef->type))
+    if (clearOriginal)
     {
         tdb_SetEmpty(originalRef);
     }
@@ -1130,77 +1572,97 @@ static void MergeNode
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Called to fire any callbacks registered on the given node path.  If nothing is registered on the
- *  given path, nothing happens.
+ *  Add a path to a change set.  Paths already in the set are not added again.  If the path doesn't
+ *  fit, the change is still counted.
  */
 // -------------------------------------------------------------------------------------------------
-static void TriggerCallbacks
+static void AddToChangeSet
 (
-    le_pathIter_Ref_t pathRef  ///< [IN] The path to search for callback registrations.
+    ChangeSet_t* setPtr,  ///< [IN] The set to update.
+    const char* pathPtr   ///< [IN] The changed path.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Read the path out of the buffer.
-    char pathBuffer[CFG_MAX_PATH_SIZE] = { 0 };
-    if (le_pathIter_GetPath(pathRef, pathBuffer, sizeof(pathBuffer)) != LE_OK)
-    {
-        LE_ERROR("Callback path buffer overflow.");
-        return;
-    }
-
-    // Try to find a registration object for this path.  If one is found, flag it for calling once
-    // the merge is complete.
-    Registration_t* foundRegistrationPtr = le_hashmap_Get(HandlerRegistrationMap, pathBuffer);
+    size_t pathLen = strlen(pathPtr);
+    const char* linePtr = setPtr->paths;
+    const char* endPtr = setPtr->paths + setPtr->pathsLen;
 
-    if (foundRegistrationPtr != NULL)
+    while (linePtr < endPtr)
     {
-        foundRegistrationPtr->triggered = true;
+        const char* lineEndPtr = strchr(linePtr, '\n');
+
+        if (lineEndPtr == NULL)
+        {
+            lineEndPtr = endPtr;
+        }
+
+        if (   ((size_t)(lineEndPtr - linePtr) == pathLen)
+            && (strncmp(linePtr, pathPtr, pathLen) == 0))
+        {
+            return;
+        }
+
+        linePtr = lineEndPtr + 1;
     }
-}
 
+    setPtr->count++;
+
+    size_t neededLen = pathLen + (setPtr->pathsLen > 0 ? 1 : 0);
+
+    if ((setPtr->pathsLen + neededLen) < sizeof(setPtr->paths))
+    {
+        if (setPtr->pathsLen > 0)
+        {
+            setPtr->paths[setPtr->pathsLen++] = '\n';
+        }
+
+        memcpy(setPtr->paths + setPtr->pathsLen, pathPtr, pathLen + 1);
+        setPtr->pathsLen += pathLen;
+    }
+}
 
 
 
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Go through all of the registered event callbacks, and fire the call backs for each of the
- *  registrations that has been makred as triggered.
- *
- *  Once this is done, the triggered flag is cleared for next time.
+ *  Add all of the changes from one change set into another.
  */
 // -------------------------------------------------------------------------------------------------
-static void FireTriggeredCallbacks
+static void MergeChangeSet
 (
-    void
+    ChangeSet_t* destPtr,      ///< [IN] The set to update.
+    const ChangeSet_t* srcPtr  ///< [IN] The changes to add.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Go through the registration map.
-    le_hashmap_It_Ref_t handlerIterRef = le_hashmap_GetIterator(HandlerRegistrationMap);
+    char path[CFG_MAX_PATH_SIZE];
+    const char* linePtr = srcPtr->paths;
+    const char* endPtr = srcPtr->paths + srcPtr->pathsLen;
+    uint32_t listed = 0;
 
-    while (le_hashmap_NextNode(handlerIterRef) == LE_OK)
+    while (linePtr < endPtr)
     {
-        // For each registration, check to see if it was triggered.
-        Registration_t* registrationPtr = (Registration_t*)le_hashmap_GetValue(handlerIterRef);
+        const char* lineEndPtr = strchr(linePtr, '\n');
 
-        if (registrationPtr->triggered)
+        if (lineEndPtr == NULL)
         {
-            // This registration has been triggered, so call all of the handlers attached to it.
-            le_dls_Link_t* linkPtr = le_dls_Peek(&registrationPtr->handlerList);
+            lineEndPtr = endPtr;
+        }
 
-            while (linkPtr != NULL)
-            {
-                Handler_t* handlerObjectPtr = CONTAINER_OF(linkPtr, Handler_t, link);
+        size_t lineLen = lineEndPtr - linePtr;
 
-                handlerObjectPtr->handlerPtr(handlerObjectPtr->contextPtr);
-                linkPtr = le_dls_PeekNext(&registrationPtr->handlerList, linkPtr);
-            }
+        memcpy(path, linePtr, lineLen);
+        path[lineLen] = '\0';
 
-            // Now that that's done, clear the triggered flag.
-            registrationPtr->triggered = false;
-        }
+        AddToChangeSet(destPtr, path);
+        listed++;
+
+        linePtr = lineEndPtr + 1;
     }
+
+    // Carry over the count of the changes that didn't fit in the source list.
+    destPtr->count += srcPtr->count - listed;
 }
 
 
@@ -1208,39 +1670,18 @@ static void FireTriggeredCallbacks
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Check the given node to see if it was renamed.
- *
- *  @return True if the node was renamed within this transaction.  False if not.
+ *  Empty out a change set.
  */
 // -------------------------------------------------------------------------------------------------
-static bool WasRenamed
+static void ClearChangeSet
 (
-    tdb_NodeRef_t nodeRef  ///< [IN] Check this node to see if it was renamed in this transaction.
+    ChangeSet_t* setPtr  ///< [IN] The set to clear.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    if (IsModified(nodeRef) == false)
-    {
-        // The node wasn't even modified, so it can not have been renamed.
-        return false;
-    }
-
-    if (nodeRef->shadowRef == NULL)
-    {
-        // If the node doesn't have a shadow reference, then most likely this is a new node and not
-        // a rename of an existing one.
-        return false;
-    }
-
-    if (nodeRef->nameRef == NULL)
-    {
-        // The shadow node does not have a local copy of a name, so it can not have been renamed.
-        // It must have been modified for other reasons.
-        return false;
-    }
-
-    // Looks like the node has a new name.
-    return true;
+    setPtr->paths[0] = '\0';
+    setPtr->pathsLen = 0;
+    setPtr->count = 0;
 }
 
 
@@ -1248,26 +1689,33 @@ static bool WasRenamed
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Check the original non-shadow node to see if it will need to be cleared during the merge.
+ *  Get the next segment of a path, (segments are separated by '/'.)
  *
- *  @return True if the merge will clear out the original value.  False if not.
+ *  @return The start of the segment after this one, or NULL if there are no more segments.
  */
 // -------------------------------------------------------------------------------------------------
-static bool OriginalToBeCleared
+static const char* NextPathSegment
 (
-    tdb_NodeRef_t nodeRef  ///< [IN] The shadow node to check.
+    const char* pathPtr,  ///< [IN] Where to look for the segment.
+    const char** segPtr,  ///< [OUT] Start of the segment.
+    size_t* segLenPtr     ///< [OUT] Length of the segment.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    le_cfg_nodeType_t nodeType = tdb_GetNodeType(nodeRef);
+    while (*pathPtr == '/')
+    {
+        pathPtr++;
+    }
 
-    if (   (nodeType == LE_CFG_TYPE_EMPTY)
-        || (nodeType != tdb_GetNodeType(nodeRef->shadowRef)))
+    if (*pathPtr == '\0')
     {
-        return true;
+        return NULL;
     }
 
-    return false;
+    *segPtr = pathPtr;
+    *segLenPtr = strcspn(pathPtr, "/");
+
+    return pathPtr + *segLenPtr;
 }
 
 
@@ -1275,27 +1723,35 @@ static bool OriginalToBeCleared
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Append the name of a node onto the end of a path object.
+ *  Find the child of a watch node for the given path segment.
+ *
+ *  @return The child node, or NULL if there isn't one.
  */
 // -------------------------------------------------------------------------------------------------
-static void AppendNodeName
+static WatchNode_t* FindWatchChild
 (
-    le_pathIter_Ref_t pathRef,  ///< [IN] The path we're appending to.
-    tdb_NodeRef_t nodeRef       ///< [IN] The node we're appending.
+    WatchNode_t* watchPtr,  ///< [IN] The node to search.
+    const char* segPtr,     ///< [IN] The path segment.
+    size_t segLen           ///< [IN] Length of the path segment.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    char nodeName[LE_CFG_NAME_LEN_BYTES] = "";
+    le_dls_Link_t* linkPtr = le_dls_Peek(&watchPtr->childList);
 
-    LE_ASSERT(tdb_GetNodeName(nodeRef, nodeName, sizeof(nodeName)) == LE_OK);
-    le_result_t result = le_pathIter_Append(pathRef, nodeName);
+    while (linkPtr != NULL)
+    {
+        WatchNode_t* childPtr = CONTAINER_OF(linkPtr, WatchNode_t, link);
 
-    LE_WARN_IF(result != LE_OK,
-               "Could not append node '%s' onto the update callback tracking path.  "
-               "Reason: %d, '%s'.",
-               nodeName,
-               result,
-               LE_RESULT_TXT(result));
+        if (   (strncmp(childPtr->name, segPtr, segLen) == 0)
+            && (childPtr->name[segLen] == '\0'))
+        {
+            return childPtr;
+        }
+
+        linkPtr = le_dls_PeekNext(&watchPtr->childList, linkPtr);
+    }
+
+    return NULL;
 }
 
 
@@ -1303,21 +1759,68 @@ static void AppendNodeName
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Create a new config path for the tree name given.
+ *  Walk a full path, (tree name included,) down the watch trie.
  *
- *  @return A new config path, rooted on the given tree.
+ *  @return The deepest watch node matching the start of the path, or NULL if the path's tree isn't
+ *          watched, or if createNodes is set and the path could not be added.
  */
 // -------------------------------------------------------------------------------------------------
-static le_pathIter_Ref_t CreateBasePath
+static WatchNode_t* WalkWatchTrie
 (
-    const char* treeNamePtr  ///< [IN] The tree name to use for the new path object.
+    const char* pathPtr,  ///< [IN] The path to look up, for example "system:/apps".
+    bool createNodes      ///< [IN] Create any missing nodes for the path?
 )
 // -------------------------------------------------------------------------------------------------
 {
-    char basePath[CFG_MAX_PATH_SIZE] = { 0 };
+    const char* treeEndPtr = strchr(pathPtr, ':');
 
-    snprintf(basePath, sizeof(basePath), "%s:/", treeNamePtr);
-    return le_pathIter_CreateForUnix(basePath);
+    if (treeEndPtr == NULL)
+    {
+        return NULL;
+    }
+
+    WatchNode_t* watchPtr = &WatchRoot;
+    const char* segPtr = pathPtr;
+    size_t segLen = treeEndPtr - pathPtr;
+    const char* nextPtr = treeEndPtr + 1;
+
+    do
+    {
+        WatchNode_t* childPtr = FindWatchChild(watchPtr, segPtr, segLen);
+
+        if (childPtr == NULL)
+        {
+            if (createNodes == false)
+            {
+                // This is as far as the watched paths go.
+                return watchPtr == &WatchRoot ? NULL : watchPtr;
+            }
+
+            if (segLen >= sizeof(childPtr->name))
+            {
+                LE_ERROR("Path segment too long for change registration.");
+                return NULL;
+            }
+
+            childPtr = le_mem_ForceAlloc(WatchNodePool);
+
+            memcpy(childPtr->name, segPtr, segLen);
+            childPtr->name[segLen] = '\0';
+            childPtr->parentPtr = watchPtr;
+            childPtr->childList = LE_DLS_LIST_INIT;
+            childPtr->link = LE_DLS_LINK_INIT;
+            childPtr->registrationPtr = NULL;
+            childPtr->useCount = 0;
+
+            le_dls_Queue(&watchPtr->childList, &childPtr->link);
+        }
+
+        watchPtr = childPtr;
+        nextPtr = NextPathSegment(nextPtr, &segPtr, &segLen);
+    }
+    while (nextPtr != NULL);
+
+    return watchPtr;
 }
 
 
@@ -1325,23 +1828,35 @@ static le_pathIter_Ref_t CreateBasePath
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Generate a config path to the given node.
+ *  Add a registration to the watch trie.
+ *
+ *  @return LE_OK if the registration was added, LE_FAULT otherwise.
  */
 // -------------------------------------------------------------------------------------------------
-static void GeneratePath
+static le_result_t AddWatch
 (
-    le_pathIter_Ref_t pathRef,  ///< [IN] The path object we're updating.
-    tdb_NodeRef_t nodeRef       ///< [IN] The node we're creating a path for.
+    Registration_t* registrationPtr  ///< [IN] The new registration.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    if (nodeRef == NULL)
+    WatchNode_t* watchPtr = WalkWatchTrie(registrationPtr->registrationPath, true);
+
+    if (watchPtr == NULL)
     {
-        return;
+        return LE_FAULT;
     }
 
-    GeneratePath(pathRef, nodeRef->parentRef);
-    AppendNodeName(pathRef, nodeRef);
+    LE_ASSERT(watchPtr->registrationPtr == NULL);
+
+    watchPtr->registrationPtr = registrationPtr;
+    registrationPtr->watchPtr = watchPtr;
+
+    for (; watchPtr != &WatchRoot; watchPtr = watchPtr->parentPtr)
+    {
+        watchPtr->useCount++;
+    }
+
+    return LE_OK;
 }
 
 
@@ -1349,36 +1864,34 @@ static void GeneratePath
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Trigger callbacks for this node and all of it's children.
+ *  Remove a registration from the watch trie, freeing any nodes no longer needed.
  */
 // -------------------------------------------------------------------------------------------------
-static void FireAllChildren
+static void RemoveWatch
 (
-    le_pathIter_Ref_t pathRef,  ///< [IN] Path to the parent of the current node.
-    tdb_NodeRef_t nodeRef       ///< [IN] Node and any children to merge.
+    Registration_t* registrationPtr  ///< [IN] The registration going away.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Add this node to the path we're using to find registered callbacks.
-    AppendNodeName(pathRef, nodeRef);
+    WatchNode_t* watchPtr = registrationPtr->watchPtr;
 
-    // If the node is a stem then traverse it's children and try to trigger callbacks for them.  If
-    // there are no callbacks registered for those nodes, then nothing will happen.
-    if (nodeRef->type == LE_CFG_TYPE_STEM)
+    watchPtr->registrationPtr = NULL;
+    registrationPtr->watchPtr = NULL;
+
+    while (watchPtr != &WatchRoot)
     {
-        tdb_NodeRef_t childRef = tdb_GetFirstChildNode(nodeRef);
+        WatchNode_t* parentPtr = watchPtr->parentPtr;
 
-        while (childRef != NULL)
+        watchPtr->useCount--;
+
+        if (watchPtr->useCount == 0)
         {
-            FireAllChildren(pathRef, childRef);
-            childRef = tdb_GetNextSiblingNode(childRef);
+            le_dls_Remove(&parentPtr->childList, &watchPtr->link);
+            le_mem_Release(watchPtr);
         }
-    }
 
-    // Like with the children, try to do the same for this node.  Then remove this node from the
-    // tracking path.
-    TriggerCallbacks(pathRef);
-    le_pathIter_Truncate(pathRef);
+        watchPtr = parentPtr;
+    }
 }
 
 
@@ -1386,81 +1899,59 @@ static void FireAllChildren
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Check a given shadow node and the original node it's shadowing.  If the original has children
- *  that will be lost because of a merge, then we need to fire callbacks for those nodes that are
- *  about to go away.
- *
- *  The algorithm employed by this function is as follows:
- *
- *      1. Check the original node for the given shadow node.  If it exists and is a stem node,
- *         mark all of the children as deleted.  (This is done with the expectation that the
- *         original tree does not have nodes with the deleted flag set.)
- *
- *      2. Go through the shadow collection, and any shadow children that have links to the original
- *         nodes, clear the deleted flag.  These nodes are still considered "live."
- *
- *      3. Travers the original children one more time.  For any node that is still marked as
- *         deleted we queue up an event handler.  As this node has been removed from the colection
- *         and will be removed as part of the final merge.  The delete flag is also cleared at this
- *         step to ensure that there are no external side effects.
+ *  Called when a node has been changed.  Any registration on the node's path, or on any of the
+ *  node's parents, is flagged for calling once the merge is complete and the node's path is added
+ *  to that registration's set of changes.
  */
 // -------------------------------------------------------------------------------------------------
-static void FireLostChildren
+static void TriggerCallbacks
 (
-    le_pathIter_Ref_t pathRef,   ///< [IN] Path to the parent of the current node.
-    tdb_NodeRef_t shadowNodeRef  ///< [IN] Node and any children to merge.
+    le_pathIter_Ref_t pathRef  ///< [IN] The path of the changed node.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Is the original a stem?  If no, then done.
-    tdb_NodeRef_t originalRef = shadowNodeRef->shadowRef;
-
-    if (originalRef->type != LE_CFG_TYPE_STEM)
+    // Don't bother if nobody is watching anything.
+    if (le_dls_IsEmpty(&WatchRoot.childList))
     {
         return;
     }
 
-    // Mark all originals deleted.
-    tdb_NodeRef_t originalChildRef = tdb_GetFirstChildNode(originalRef);
-
-    while (originalChildRef != NULL)
+    // Read the path out of the buffer.
+    char pathBuffer[CFG_MAX_PATH_SIZE] = { 0 };
+    if (le_pathIter_GetPath(pathRef, pathBuffer, sizeof(pathBuffer)) != LE_OK)
     {
-        // Children in the original tree shouldn't currently be marked as deleted.
-        LE_ASSERT(IsDeleted(originalChildRef) == false);
-
-        SetDeletedFlag(originalChildRef);
-        originalChildRef = tdb_GetNextSiblingNode(originalChildRef);
+        LE_ERROR("Callback path buffer overflow.");
+        return;
     }
 
-    // Follow through all of the shadow links and unmark deletions.
-    if (shadowNodeRef->type == LE_CFG_TYPE_STEM)
+    // Find the deepest watched node along the path, then visit it and all of it's parents.
+    WatchNode_t* watchPtr = WalkWatchTrie(pathBuffer, false);
+
+    for (; watchPtr != NULL && watchPtr != &WatchRoot; watchPtr = watchPtr->parentPtr)
     {
-        tdb_NodeRef_t shadowChildRef = tdb_GetFirstChildNode(shadowNodeRef);
+        Registration_t* registrationPtr = watchPtr->registrationPtr;
 
-        while (shadowChildRef != NULL)
+        if (registrationPtr == NULL)
         {
-            if (shadowChildRef->shadowRef != NULL)
-            {
-                ClearDeletedFlag(shadowChildRef->shadowRef);
-            }
+            continue;
+        }
 
-            shadowChildRef = tdb_GetNextSiblingNode(shadowChildRef);
+        if (registrationPtr->triggered == false)
+        {
+            registrationPtr->triggered = true;
+            registrationPtr->triggeredLink = LE_SLS_LINK_INIT;
+            le_sls_Queue(&TriggeredList, &registrationPtr->triggeredLink);
         }
-    }
 
-    // Fire on all original nodes still marked.  But also take care to clear the deleted flags here
-    // in order to leave everything as it was.
-    originalChildRef = tdb_GetFirstChildNode(originalRef);
+        // Record the path relative to the registered node.
+        const char* subPathPtr = pathBuffer + strlen(registrationPtr->registrationPath);
 
-    while (originalChildRef != NULL)
-    {
-        if (IsDeleted(originalChildRef) == true)
+        while (*subPathPtr == '/')
         {
-            FireAllChildren(pathRef, originalChildRef);
-            ClearDeletedFlag(originalChildRef);
+            subPathPtr++;
         }
 
-        originalChildRef = tdb_GetNextSiblingNode(originalChildRef);
+        AddToChangeSet(&registrationPtr->changes, *subPathPtr == '\0' ? "." : subPathPtr);
     }
 }
 
@@ -1469,125 +1960,41 @@ static void FireLostChildren
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Recursive function to merge a collection of shadow nodes with the original tree.
- *
- *  @return True if the given node or any if it's children have been modified.  False if not.
+ *  Hand the changes collected for a change set handler over to the handler function.
  */
 // -------------------------------------------------------------------------------------------------
-static bool InternalMergeTree
+static void DeliverChangeSet
 (
-    const char* treeNamePtr,    ///< [IN] The name of the tree we're merging.
-    le_pathIter_Ref_t pathRef,  ///< [IN] Path to the parent of hte current node.
-    tdb_NodeRef_t nodeRef,      ///< [IN] Node and any children to merge.
-    bool forceFire              ///< [IN] Should update handlers be fired for this node and all it's
-                                ///<      children, regardless of wether or not this node has been
-                                ///<      directly modified?
+    Handler_t* handlerObjectPtr  ///< [IN] The handler to notify.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    bool isModified = IsModified(nodeRef);
-    bool renamed = WasRenamed(nodeRef);
-
-    // If this node was renamed, then all children also need to be triggered as well.
-    forceFire = renamed || forceFire;
-
-    // If this node has been renamed, marked as deleted or set empty, then all of the children need
-    // notifications fired on the original nodes.
-    if (   (renamed == true)
-        || (IsDeleted(nodeRef) == true)
-        || (OriginalToBeCleared(nodeRef) == true))
-    {
-        le_pathIter_Ref_t originalPathRef = CreateBasePath(treeNamePtr);
+    LE_DEBUG("** Delivering %" PRIu32 " change(s) under '%s'.",
+             handlerObjectPtr->pendingChanges.count,
+             handlerObjectPtr->registrationPtr->registrationPath);
 
-        if (nodeRef->shadowRef != NULL)
-        {
-            GeneratePath(originalPathRef, nodeRef->shadowRef->parentRef);
-            FireAllChildren(originalPathRef, nodeRef->shadowRef);
-        }
+    handlerObjectPtr->changeSetHandlerPtr(handlerObjectPtr->pendingChanges.paths,
+                                          handlerObjectPtr->pendingChanges.count,
+                                          handlerObjectPtr->contextPtr);
 
-        le_pathIter_Delete(originalPathRef);
-    }
-    else if (   (isModified == true)
-             && (nodeRef->type == LE_CFG_TYPE_STEM))
-    {
-        le_pathIter_Ref_t originalPathRef = CreateBasePath(treeNamePtr);
-
-        GeneratePath(originalPathRef, nodeRef->shadowRef);
-        FireLostChildren(originalPathRef, nodeRef);
-
-        le_pathIter_Delete(originalPathRef);
-    }
-
-    AppendNodeName(pathRef, nodeRef);
-
-    // IF this node is modified, mearge it.  If this node is a stem, then merge it's children.  Keep
-    // track of whether any of those children have been modified as well.
-    if (isModified)
-    {
-        MergeNode(nodeRef);
-    }
-
-    if (   (nodeRef->type == LE_CFG_TYPE_STEM)
-        && (IsDeleted(nodeRef) == false))
-    {
-        nodeRef = tdb_GetFirstChildNode(nodeRef);
-
-        while (nodeRef != NULL)
-        {
-            tdb_NodeRef_t nextNodeRef = tdb_GetNextSiblingNode(nodeRef);
-
-            isModified = InternalMergeTree(treeNamePtr, pathRef, nodeRef, forceFire) || isModified;
-            nodeRef = nextNodeRef;
-        }
-    }
-
-    // If this node, or any of it's children have been modified.  Try to fire any callbacks that may
-    // be registered.
-    if (isModified || forceFire)
-    {
-        TriggerCallbacks(pathRef);
-    }
-
-    // Now remove this node from the tracking path and let our caller know if any modifications have
-    // happened at this level or lower.
-    if (le_pathIter_GoToEnd(pathRef) == LE_OK)
-    {
-        le_pathIter_Truncate(pathRef);
-    }
-
-    return isModified;
-}
+    ClearChangeSet(&handlerObjectPtr->pendingChanges);
+}
 
 
 
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Create a new tree object and set it to default values.
- *
- *  @return A ref to the newly created tree object.
+ *  Called when a change set handler's changes have settled.
  */
 // -------------------------------------------------------------------------------------------------
-tdb_TreeRef_t NewTree
+static void OnDebounceExpiry
 (
-    const char* treeNameRef,   ///< [IN] The name of the new tree.
-    tdb_NodeRef_t rootNodeRef  ///< [IN] The root node of this new tree.
+    le_timer_Ref_t timerRef  ///< [IN] The handler's debounce timer.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    tdb_TreeRef_t treeRef = le_mem_ForceAlloc(TreePoolRef);
-
-    LE_ASSERT(le_utf8_Copy(treeRef->name, treeNameRef, MAX_TREE_NAME_BYTES, NULL) == LE_OK);
-
-    treeRef->isDeletePending = false;
-    treeRef->originalTreeRef = NULL;
-    treeRef->revisionId = 0;
-    treeRef->rootNodeRef = (rootNodeRef != NULL) ? rootNodeRef : NewNode();
-    treeRef->activeReadCount = 0;
-    treeRef->activeWriteIterRef = NULL;
-    treeRef->requestList = LE_SLS_LIST_INIT;
-
-    return treeRef;
+    DeliverChangeSet((Handler_t*)le_timer_GetContextPtr(timerRef));
 }
 
 
@@ -1595,25 +2002,42 @@ tdb_TreeRef_t NewTree
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Destructor called when a tree object is to be freed from memory.
+ *  Add a merge's changes to a change set handler's pending changes, and either deliver them now or
+ *  (re)start the handler's debounce timer.  The timer is restarted on every new batch of changes,
+ *  unless that would hold the notification for longer than CFG_MAX_DEBOUNCE_MS.
  */
 // -------------------------------------------------------------------------------------------------
-static void TreeDestructor
+static void QueueChangeSet
 (
-    void* objectPtr  ///< The memory object to destruct.
+    Handler_t* handlerObjectPtr,   ///< [IN] The handler to notify.
+    const ChangeSet_t* changesPtr  ///< [IN] The changes from the merge.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    tdb_TreeRef_t treeRef = (tdb_TreeRef_t)objectPtr;
+    MergeChangeSet(&handlerObjectPtr->pendingChanges, changesPtr);
 
-    // Kill the root node.
-    le_mem_Release(treeRef->rootNodeRef);
-    treeRef->rootNodeRef = NULL;
+    if (handlerObjectPtr->debounceTimerRef == NULL)
+    {
+        DeliverChangeSet(handlerObjectPtr);
+        return;
+    }
 
-    // Sanity check, is the tree actually ready to clean up?
-    LE_ASSERT(treeRef->activeReadCount == 0);
-    LE_ASSERT(treeRef->activeWriteIterRef == NULL);
-    LE_ASSERT(le_sls_IsEmpty(&treeRef->requestList) == true);
+    le_clk_Time_t now = le_clk_GetRelativeTime();
+
+    if (le_timer_IsRunning(handlerObjectPtr->debounceTimerRef) == false)
+    {
+        handlerObjectPtr->firstChangeTime = now;
+        le_timer_Start(handlerObjectPtr->debounceTimerRef);
+        return;
+    }
+
+    le_clk_Time_t heldTime = le_clk_Sub(now, handlerObjectPtr->firstChangeTime);
+    uint64_t heldMs = ((uint64_t)heldTime.sec * 1000) + (heldTime.usec / 1000);
+
+    if ((heldMs + handlerObjectPtr->debounceMs) <= CFG_MAX_DEBOUNCE_MS)
+    {
+        le_timer_Restart(handlerObjectPtr->debounceTimerRef);
+    }
 }
 
 
@@ -1621,40 +2045,47 @@ static void TreeDestructor
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Create a path to a tree file with the given revision id.
+ *  Go through all of the registrations that were triggered by the merge and notify their handlers.
  *
- *  @return A stringBuffer backed string containing the full path to the tree file.
+ *  Once this is done, the triggered flag and the collected changes are cleared for next time.
  */
 // -------------------------------------------------------------------------------------------------
-static void GetTreePath
+static void FireTriggeredCallbacks
 (
-    const char* treeNameRef,  ///< [IN] The name of the tree we're generating a name for.
-    int revisionId,           ///< [IN] Generate a name based on the tree revision.
-    char* pathBuffer,         ///< [IN] Buffer to hold the new path.
-    size_t pathSize           ///< [IN] Size of the path buffer.
+    void
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // paper    --> rock       1 -> 2
-    // rock     --> scissors   2 -> 3
-    // scissors --> paper      3 -> 1
+    le_sls_Link_t* triggeredLinkPtr = NULL;
 
-    static const char* revNames[] = { "paper", "rock", "scissors" };
-    int printSize;
+    while ((triggeredLinkPtr = le_sls_Pop(&TriggeredList)) != NULL)
+    {
+        Registration_t* registrationPtr = CONTAINER_OF(triggeredLinkPtr,
+                                                       Registration_t,
+                                                       triggeredLink);
 
-    LE_ASSERT((revisionId >= 1) && (revisionId <= 3));
+        // This registration has been triggered, so call all of the handlers attached to it.
+        le_dls_Link_t* linkPtr = le_dls_Peek(&registrationPtr->handlerList);
 
-    printSize = snprintf(pathBuffer,
-                         pathSize,
-                         "%s/%s.%s",
-                         CFG_TREE_PATH,
-                         treeNameRef,
-                         revNames[revisionId - 1]);
+        while (linkPtr != NULL)
+        {
+            Handler_t* handlerObjectPtr = CONTAINER_OF(linkPtr, Handler_t, link);
 
-    if (printSize >= pathSize)
-    {
-       LE_ERROR("Unable to store config tree path in buffer");
-       pathBuffer[0] = '\0';
+            if (handlerObjectPtr->changeSetHandlerPtr != NULL)
+            {
+                QueueChangeSet(handlerObjectPtr, &registrationPtr->changes);
+            }
+            else
+            {
+                handlerObjectPtr->handlerPtr(handlerObjectPtr->contextPtr);
+            }
+
+            linkPtr = le_dls_PeekNext(&registrationPtr->handlerList, linkPtr);
+        }
+
+        // Now that that's done, clear the triggered flag.
+        registrationPtr->triggered = false;
+        ClearChangeSet(&registrationPtr->changes);
     }
 }
 
@@ -1663,56 +2094,38 @@ static void GetTreePath
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Check to see if a configTree file at the given revision already exists in the filesystem.
- *
- *  @note If the tree file exists, but is empty, then it is invalid and will be deleted.
+ *  Check the given node to see if it was renamed.
  *
- *  @return True if the named file exists, false otherwise.
+ *  @return True if the node was renamed within this transaction.  False if not.
  */
 // -------------------------------------------------------------------------------------------------
-static bool TreeFileExists
+static bool WasRenamed
 (
-    const char* treeNameRef,  ///< [IN] Name of the tree to check.
-    int revisionId            ///< [IN] The revision of the tree to check against.
+    tdb_NodeRef_t nodeRef  ///< [IN] Check this node to see if it was renamed in this transaction.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    char fullPath[LE_CFG_STR_LEN_BYTES] = "";
-    GetTreePath(treeNameRef, revisionId, fullPath, sizeof(fullPath));
-
-    // Make sure this part was successful.
-    if (fullPath[0] == '\0')
+    if (IsModified(nodeRef) == false)
     {
+        // The node wasn't even modified, so it can not have been renamed.
         return false;
     }
 
-    // stat() the file to see if it exists and get its size.
-    struct stat s;
-    if (stat(fullPath, &s) == -1)
+    if (nodeRef->shadowRef == NULL)
     {
-        LE_DEBUG("Can't stat file '%s' (%m).", fullPath);
+        // If the node doesn't have a shadow reference, then most likely this is a new node and not
+        // a rename of an existing one.
         return false;
     }
 
-    // Make sure it's a regular file.
-    if (!S_ISREG(s.st_mode))
-    {
-        LE_FATAL("Object at '%s' is not a regular file.", fullPath);
-    }
-
-    // If it's zero size, delete it and report that it doesn't exist.
-    if (s.st_size == 0)
+    if (nodeRef->nameRef == NULL)
     {
-        if (unlink(fullPath) == -1)
-        {
-            LE_FATAL("Failed to unlink empty file '%s' (%m).", fullPath);
-        }
-
+        // The shadow node does not have a local copy of a name, so it can not have been renamed.
+        // It must have been modified for other reasons.
         return false;
     }
 
-    // NOTE: The Config Tree generally runs as root, so permissions should be irrelevant.
-
+    // Looks like the node has a new name.
     return true;
 }
 
@@ -1721,52 +2134,26 @@ static bool TreeFileExists
 
 // -------------------------------------------------------------------------------------------------
 /**
- * Check the filesystem and get the current "valid" version of the file and update the tree object
- * with that version number.
+ *  Check the original non-shadow node to see if it will need to be cleared during the merge.
  *
- * If there are two files for a given tree, we use the older one.  The idea being, if there are
- * two versions of the same file in the filesystem then there was a system failure during a save
- * operation.  So we abandon the newer (probably incomplete) file and go with the older file;
- * unless the size of the older file is zero, which can happen if deletion of that file is
- * interrupted.
+ *  @return True if the merge will clear out the original value.  False if not.
  */
 // -------------------------------------------------------------------------------------------------
-static void UpdateRevision
+static bool OriginalToBeCleared
 (
-    tdb_TreeRef_t treeRef  ///< [IN] Update the revision for this tree object.
+    tdb_NodeRef_t nodeRef  ///< [IN] The shadow node to check.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    int newRevision = 0;
+    le_cfg_nodeType_t nodeType = tdb_GetNodeType(nodeRef);
 
-    if (TreeFileExists(treeRef->name, 1))
-    {
-        if (TreeFileExists(treeRef->name, 3))
-        {
-            newRevision = 3;
-        }
-        else
-        {
-            newRevision = 1;
-        }
-    }
-    else if (TreeFileExists(treeRef->name, 3))
-    {
-        if (TreeFileExists(treeRef->name, 2))
-        {
-            newRevision = 2;
-        }
-        else
-        {
-            newRevision = 3;
-        }
-    }
-    else if (TreeFileExists(treeRef->name, 2))
+    if (   (nodeType == LE_CFG_TYPE_EMPTY)
+        || (nodeType != tdb_GetNodeType(nodeRef->shadowRef)))
     {
-        newRevision = 2;
+        return true;
     }
 
-    treeRef->revisionId = newRevision;
+    return false;
 }
 
 
@@ -1774,19 +2161,27 @@ static void UpdateRevision
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Peek into the input stream one character ahead.
+ *  Append the name of a node onto the end of a path object.
  */
 // -------------------------------------------------------------------------------------------------
-static signed char PeekChar
+static void AppendNodeName
 (
-    FILE* filePtr  ///< [IN] The file stream to peek into.
+    le_pathIter_Ref_t pathRef,  ///< [IN] The path we're appending to.
+    tdb_NodeRef_t nodeRef       ///< [IN] The node we're appending.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    char next = fgetc(filePtr);
-    ungetc(next, filePtr);
+    char nodeName[LE_CFG_NAME_LEN_BYTES] = "";
 
-    return next;
+    LE_ASSERT(tdb_GetNodeName(nodeRef, nodeName, sizeof(nodeName)) == LE_OK);
+    le_result_t result = le_pathIter_Append(pathRef, nodeName);
+
+    LE_WARN_IF(result != LE_OK,
+               "Could not append node '%s' onto the update callback tracking path.  "
+               "Reason: %d, '%s'.",
+               nodeName,
+               result,
+               LE_RESULT_TXT(result));
 }
 
 
@@ -1794,45 +2189,21 @@ static signed char PeekChar
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Skip any whitespace encountered in the input stream.  Stop skipping once we hit a valid token.
+ *  Create a new config path for the tree name given.
  *
- *  @return LE_OK if the whitespace is skiped and there is still more file to read.
- *          LE_OUT_OF_RANGE if the end of the file is hit.
+ *  @return A new config path, rooted on the given tree.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t SkipWhiteSpace
+static le_pathIter_Ref_t CreateBasePath
 (
-    FILE* filePtr  ///< [IN] The file stream to seek through.
+    const char* treeNamePtr  ///< [IN] The tree name to use for the new path object.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    bool done = false;
-    bool isEof = false;
-
-    while (done == false)
-    {
-        switch (PeekChar(filePtr))
-        {
-            case '\n':
-            case '\r':
-            case '\t':
-            case ' ':
-                // Eat the character.
-                fgetc(filePtr);
-                break;
-
-            case EOF:
-                done = true;
-                isEof = true;
-                break;
-
-            default:
-                done = true;
-                break;
-        }
-    }
+    char basePath[CFG_MAX_PATH_SIZE] = { 0 };
 
-    return isEof == true ? LE_OUT_OF_RANGE : LE_OK;
+    snprintf(basePath, sizeof(basePath), "%s:/", treeNamePtr);
+    return le_pathIter_CreateForUnix(basePath);
 }
 
 
@@ -1840,32 +2211,23 @@ static le_result_t SkipWhiteSpace
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Read a boolean literal from the input file.
- *
- *  @return LE_OK if the literal could be read.
- *          LE_FORMAT_ERROR if the literal could not be read.
+ *  Generate a config path to the given node.
  */
 // -------------------------------------------------------------------------------------------------
-static bool ReadBoolToken
+static void GeneratePath
 (
-    FILE* filePtr,     ///< [IN]  The file we're reading from.
-    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
-    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+    le_pathIter_Ref_t pathRef,  ///< [IN] The path object we're updating.
+    tdb_NodeRef_t nodeRef       ///< [IN] The node we're creating a path for.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    signed char next = fgetc(filePtr);
-
-    if (   (next == 't')
-        || (next == 'f'))
+    if (nodeRef == NULL)
     {
-        stringPtr[0] = next;
-        stringPtr[1] = 0;
-
-        return LE_OK;
+        return;
     }
 
-    return LE_FORMAT_ERROR;
+    GeneratePath(pathRef, nodeRef->parentRef);
+    AppendNodeName(pathRef, nodeRef);
 }
 
 
@@ -1873,67 +2235,36 @@ static bool ReadBoolToken
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Read a textual literal from the input file, the read is terminated successfuly if the terminal
- *  character is found.
- *
- *  @return LE_OK if the string is read from the file.
- *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ *  Trigger callbacks for this node and all of it's children.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t ReadTextLiteral
+static void FireAllChildren
 (
-    FILE* filePtr,        ///< [IN]  The file we're reading from.
-    char* stringPtr,      ///< [OUT] String buffer to hold the token we've read.
-    size_t stringSize,    ///< [IN]  How big is the supplied string buffer?
-    signed char terminal  ///< [IN]  The terminal character we're searching for.
+    le_pathIter_Ref_t pathRef,  ///< [IN] Path to the parent of the current node.
+    tdb_NodeRef_t nodeRef       ///< [IN] Node and any children to merge.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    signed char next;
-    size_t count = 0;
-
-    char* oldPtr = stringPtr;
+    // Add this node to the path we're using to find registered callbacks.
+    AppendNodeName(pathRef, nodeRef);
 
-    while ((next = fgetc(filePtr)) != terminal)
+    // If the node is a stem then traverse it's children and try to trigger callbacks for them.  If
+    // there are no callbacks registered for those nodes, then nothing will happen.
+    if (nodeRef->type == LE_CFG_TYPE_STEM)
     {
-        if (next == EOF)
-        {
-            LE_ERROR("Missing end specifier, ']' in int value.");
-            return LE_FORMAT_ERROR;
-        }
-
-        if (next == '\\')
-        {
-            next = fgetc(filePtr);
-
-            if (next == EOF)
-            {
-                LE_ERROR("Unexpected EOF after finding \\ character.");
-                return LE_FORMAT_ERROR;
-            }
-        }
-
-        *stringPtr = next;
-
-        ++stringPtr;
-        ++count;
+        tdb_NodeRef_t childRef = tdb_GetFirstChildNode(nodeRef);
 
-        if (count >= (stringSize - 1))
+        while (childRef != NULL)
         {
-            *stringPtr = 0;
-
-            LE_ERROR("String literal, '%s', too large.  (%zd/%zd)",
-                     oldPtr,
-                     strlen(oldPtr),
-                     stringSize);
-
-            return LE_FORMAT_ERROR;
+            FireAllChildren(pathRef, childRef);
+            childRef = tdb_GetNextSiblingNode(childRef);
         }
     }
 
-    *stringPtr = 0;
-
-    return LE_OK;
+    // Like with the children, try to do the same for this node.  Then remove this node from the
+    // tracking path.
+    TriggerCallbacks(pathRef);
+    le_pathIter_Truncate(pathRef);
 }
 
 
@@ -1941,51 +2272,82 @@ static le_result_t ReadTextLiteral
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Read an integer token string from the file.
+ *  Check a given shadow node and the original node it's shadowing.  If the original has children
+ *  that will be lost because of a merge, then we need to fire callbacks for those nodes that are
+ *  about to go away.
  *
- *  @return LE_OK if the string is read from the file.
- *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ *  The algorithm employed by this function is as follows:
+ *
+ *      1. Check the original node for the given shadow node.  If it exists and is a stem node,
+ *         mark all of the children as deleted.  (This is done with the expectation that the
+ *         original tree does not have nodes with the deleted flag set.)
+ *
+ *      2. Go through the shadow collection, and any shadow children that have links to the original
+ *         nodes, clear the deleted flag.  These nodes are still considered "live."
+ *
+ *      3. Travers the original children one more time.  For any node that is still marked as
+ *         deleted we queue up an event handler.  As this node has been removed from the colection
+ *         and will be removed as part of the final merge.  The delete flag is also cleared at this
+ *         step to ensure that there are no external side effects.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t ReadIntToken
+static void FireLostChildren
 (
-    FILE* filePtr,     ///< [IN]  The file we're reading from.
-    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
-    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+    le_pathIter_Ref_t pathRef,   ///< [IN] Path to the parent of the current node.
+    tdb_NodeRef_t shadowNodeRef  ///< [IN] Node and any children to merge.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    le_result_t result = ReadTextLiteral(filePtr, stringPtr, stringSize, ']');
+    // Is the original a stem?  If no, then done.
+    tdb_NodeRef_t originalRef = shadowNodeRef->shadowRef;
 
-    // TODO: Validate the int string.
+    if (originalRef->type != LE_CFG_TYPE_STEM)
+    {
+        return;
+    }
 
-    return result;
-}
+    // Mark all originals deleted.
+    tdb_NodeRef_t originalChildRef = tdb_GetFirstChildNode(originalRef);
+
+    while (originalChildRef != NULL)
+    {
+        // Children in the original tree shouldn't currently be marked as deleted.
+        LE_ASSERT(IsDeleted(originalChildRef) == false);
 
+        SetDeletedFlag(originalChildRef);
+        originalChildRef = tdb_GetNextSiblingNode(originalChildRef);
+    }
 
+    // Follow through all of the shadow links and unmark deletions.
+    if (shadowNodeRef->type == LE_CFG_TYPE_STEM)
+    {
+        tdb_NodeRef_t shadowChildRef = tdb_GetFirstChildNode(shadowNodeRef);
 
+        while (shadowChildRef != NULL)
+        {
+            if (shadowChildRef->shadowRef != NULL)
+            {
+                ClearDeletedFlag(shadowChildRef->shadowRef);
+            }
 
-// -------------------------------------------------------------------------------------------------
-/**
- *  Read a floating point token string from the file.
- *
- *  @return LE_OK if the string is read from the file.
- *          LE_FORMAT_ERROR if the text fails to be read from the file.
- */
-// -------------------------------------------------------------------------------------------------
-static le_result_t ReadFloatToken
-(
-    FILE* filePtr,     ///< [IN]  The file we're reading from.
-    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
-    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
-)
-// -------------------------------------------------------------------------------------------------
-{
-    le_result_t result = ReadTextLiteral(filePtr, stringPtr, stringSize, ')');
+            shadowChildRef = tdb_GetNextSiblingNode(shadowChildRef);
+        }
+    }
 
-    // TODO: Validate the float string.
+    // Fire on all original nodes still marked.  But also take care to clear the deleted flags here
+    // in order to leave everything as it was.
+    originalChildRef = tdb_GetFirstChildNode(originalRef);
 
-    return result;
+    while (originalChildRef != NULL)
+    {
+        if (IsDeleted(originalChildRef) == true)
+        {
+            FireAllChildren(pathRef, originalChildRef);
+            ClearDeletedFlag(originalChildRef);
+        }
+
+        originalChildRef = tdb_GetNextSiblingNode(originalChildRef);
+    }
 }
 
 
@@ -1993,95 +2355,129 @@ static le_result_t ReadFloatToken
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Read a string from the config tree file.
+ *  Recursive function to merge a collection of shadow nodes with the original tree.
  *
- *  @return LE_OK if the string is read from the file.
- *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ *  @return True if the given node or any if it's children have been modified.  False if not.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t ReadStringToken
+static bool InternalMergeTree
 (
-    FILE* filePtr,     ///< [IN]  The file we're reading from.
-    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
-    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+    tdb_TreeRef_t treeRef,      ///< [IN] The live tree we're merging into.
+    le_pathIter_Ref_t pathRef,  ///< [IN] Path to the parent of hte current node.
+    tdb_NodeRef_t nodeRef,      ///< [IN] Node and any children to merge.
+    bool forceFire              ///< [IN] Should update handlers be fired for this node and all it's
+                                ///<      children, regardless of wether or not this node has been
+                                ///<      directly modified?
 )
 // -------------------------------------------------------------------------------------------------
 {
-    le_result_t result = ReadTextLiteral(filePtr, stringPtr, stringSize, '"');
+    bool isModified = IsModified(nodeRef);
+    bool isSelfModified = isModified;
+    bool renamed = WasRenamed(nodeRef);
 
-    // TODO: Validate the literal string.
+    // If this node was renamed, then all children also need to be triggered as well.
+    forceFire = renamed || forceFire;
 
-    return result;
-}
+    // If this node has been renamed, marked as deleted or set empty, then all of the children need
+    // notifications fired on the original nodes.
+    if (   (renamed == true)
+        || (IsDeleted(nodeRef) == true)
+        || (OriginalToBeCleared(nodeRef) == true))
+    {
+        le_pathIter_Ref_t originalPathRef = CreateBasePath(treeRef->name);
 
+        if (nodeRef->shadowRef != NULL)
+        {
+            GeneratePath(originalPathRef, nodeRef->shadowRef->parentRef);
+            FireAllChildren(originalPathRef, nodeRef->shadowRef);
+        }
 
+        le_pathIter_Delete(originalPathRef);
+    }
+    else if (   (isModified == true)
+             && (nodeRef->type == LE_CFG_TYPE_STEM))
+    {
+        le_pathIter_Ref_t originalPathRef = CreateBasePath(treeRef->name);
 
+        GeneratePath(originalPathRef, nodeRef->shadowRef);
+        FireLostChildren(originalPathRef, nodeRef);
 
-// -------------------------------------------------------------------------------------------------
-/**
- *  Read a token from the input stream.
- *
- *  @return LE_OK if a token could be read.  LE_OUT_OF_RANGE if the end of the stream is reached
- *          before a token could be finished.
- */
-// -------------------------------------------------------------------------------------------------
-static le_result_t ReadToken
-(
-    FILE* filePtr,         ///< [IN]  The file we're reading from.
-    char* stringPtr,       ///< [OUT] String buffer to hold the token we've read.
-    size_t stringSize,     ///< [IN]  How big is the supplied string buffer?
-    TokenType_t* typePtr   ///< [OUT] The type of token read from the file.
-)
-// -------------------------------------------------------------------------------------------------
-{
-    *stringPtr = 0;
+        le_pathIter_Delete(originalPathRef);
+    }
 
-    if (SkipWhiteSpace(filePtr) != LE_OK)
+    AppendNodeName(pathRef, nodeRef);
+
+    // IF this node is modified, mearge it.  If this node is a stem, then merge it's children.  Keep
+    // track of whether any of those children have been modified as well.
+    if (isModified)
     {
-        return LE_OUT_OF_RANGE;
+        MergeNode(treeRef, nodeRef);
     }
 
-    signed char next;
-
-    while ((next = fgetc(filePtr)) != EOF)
+    if (   (nodeRef->type == LE_CFG_TYPE_STEM)
+        && (IsDeleted(nodeRef) == false))
     {
-        switch (next)
+        nodeRef = tdb_GetFirstChildNode(nodeRef);
+
+        while (nodeRef != NULL)
         {
-            case '~':
-                *typePtr = TT_EMPTY_VALUE;
-                return LE_OK;
+            tdb_NodeRef_t nextNodeRef = tdb_GetNextSiblingNode(nodeRef);
 
-            case '!':
-                *typePtr = TT_BOOL_VALUE;
-                return ReadBoolToken(filePtr, stringPtr, stringSize);
+            isModified = InternalMergeTree(treeRef, pathRef, nodeRef, forceFire) || isModified;
+            nodeRef = nextNodeRef;
+        }
+    }
 
-            case '[':
-                *typePtr = TT_INT_VALUE;
-                return ReadIntToken(filePtr, stringPtr, stringSize);
+    // If this node has been modified, try to fire any callbacks that may be registered on it or on
+    // any of it's parents.  (Modified children have already taken care of this themselves.)
+    if (isSelfModified || forceFire)
+    {
+        TriggerCallbacks(pathRef);
+    }
 
-            case '(':
-                *typePtr = TT_FLOAT_VALUE;
-                return ReadFloatToken(filePtr, stringPtr, stringSize);
+    // Now remove this node from the tracking path and let our caller know if any modifications have
+    // happened at this level or lower.
+    if (le_pathIter_GoToEnd(pathRef) == LE_OK)
+    {
+        le_pathIter_Truncate(pathRef);
+    }
 
-            case '\"':
-                *typePtr = TT_STRING_VALUE;
-                return ReadStringToken(filePtr, stringPtr, stringSize);
+    return isModified;
+}
 
-            case '{':
-                *typePtr = TT_OPEN_GROUP;
-                return LE_OK;
 
-            case '}':
-                *typePtr = TT_CLOSE_GROUP;
-                return LE_OK;
 
-            default:
-                LE_ERROR("Unexpected character in input stream.");
-                return LE_FORMAT_ERROR;
-        }
-    }
 
-    return LE_OUT_OF_RANGE;
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Create a new tree object and set it to default values.
+ *
+ *  @return A ref to the newly created tree object.
+ */
+// -------------------------------------------------------------------------------------------------
+tdb_TreeRef_t NewTree
+(
+    const char* treeNameRef,   ///< [IN] The name of the new tree.
+    tdb_NodeRef_t rootNodeRef  ///< [IN] The root node of this new tree.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tdb_TreeRef_t treeRef = le_mem_ForceAlloc(TreePoolRef);
+
+    LE_ASSERT(le_utf8_Copy(treeRef->name, treeNameRef, MAX_TREE_NAME_BYTES, NULL) == LE_OK);
+
+    treeRef->isDeletePending = false;
+    treeRef->originalTreeRef = NULL;
+    treeRef->revisionId = 0;
+    treeRef->rootNodeRef = (rootNodeRef != NULL) ? rootNodeRef : NewNode();
+    treeRef->activeReadCount = 0;
+    treeRef->activeWriteIterRef = NULL;
+    treeRef->requestList = LE_SLS_LIST_INIT;
+    treeRef->liveTreeRef = NULL;
+    treeRef->snapshotCount = 0;
+    treeRef->pendingWritePtr = NULL;
+
+    return treeRef;
 }
 
 
@@ -2089,83 +2485,79 @@ static le_result_t ReadToken
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Write data to the output stream.  This function will record any faults to the system log.
- *
- *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
+ *  Destructor called when a tree object is to be freed from memory.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t WriteFile
+static void TreeDestructor
 (
-    FILE* filePtr,        ///< [IN] The file being written to.
-    const void* dataPtr,  ///< [IN] The data being written to the file.
-    size_t dataSize       ///< [IN] The amount of data being written.
+    void* objectPtr  ///< The memory object to destruct.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    ssize_t written = fwrite(dataPtr, 1, dataSize, filePtr);
+    tdb_TreeRef_t treeRef = (tdb_TreeRef_t)objectPtr;
 
-    if (ferror(filePtr) != 0)
-    {
-        LE_EMERG("Failed to write to config tree file.");
-        return LE_IO_ERROR;
-    }
+    // Kill the root node.
+    le_mem_Release(treeRef->rootNodeRef);
+    treeRef->rootNodeRef = NULL;
 
-    if (written < dataSize)
+    // Sanity check, is the tree actually ready to clean up?
+    LE_ASSERT(treeRef->activeReadCount == 0);
+    LE_ASSERT(treeRef->activeWriteIterRef == NULL);
+    LE_ASSERT(le_sls_IsEmpty(&treeRef->requestList) == true);
+    LE_ASSERT(treeRef->pendingWritePtr == NULL);
+
+    // If this was a snapshot, let go of the live tree it was taken from.  Releasing the root has
+    // already taken the snapshot's nodes off of the live nodes they were shadowing.
+    if (treeRef->liveTreeRef != NULL)
     {
-        LE_EMERG("Data truncated while writing to configuration file.");
-        return LE_IO_ERROR;
-    }
+        LE_ASSERT(treeRef->liveTreeRef->snapshotCount > 0);
 
-    return LE_OK;
+        treeRef->liveTreeRef->snapshotCount--;
+        le_mem_Release(treeRef->liveTreeRef);
+        treeRef->liveTreeRef = NULL;
+    }
 }
 
 
 
+
 // -------------------------------------------------------------------------------------------------
 /**
- *  Write a string token to the output stream.  This function will write the string and escape all
- *  control characters as it does so.
+ *  Create a path to a tree file with the given revision id.
  *
- *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
+ *  @return A stringBuffer backed string containing the full path to the tree file.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t WriteStringValue
+static void GetTreePath
 (
-    FILE* filePtr,         ///< [IN] The file to write to.
-    char startChar,        ///< [IN] The delimiter to use.
-    char endChar,          ///< [IN] The closing delimiter to use.
-    const char* stringPtr  ///< [IN] The actual string to write.
+    const char* treeNameRef,  ///< [IN] The name of the tree we're generating a name for.
+    int revisionId,           ///< [IN] Generate a name based on the tree revision.
+    char* pathBuffer,         ///< [IN] Buffer to hold the new path.
+    size_t pathSize           ///< [IN] Size of the path buffer.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    le_result_t result = LE_OK;
-
-    result = WriteFile(filePtr, &startChar, 1);
+    // paper    --> rock       1 -> 2
+    // rock     --> scissors   2 -> 3
+    // scissors --> paper      3 -> 1
 
-    while (   (*stringPtr != 0)
-           && (result == LE_OK))
-    {
-        if (   (*stringPtr == '\"')
-            || (*stringPtr == '\\'))
-        {
-            result = WriteFile(filePtr, "\\", 1);
-        }
+    static const char* revNames[] = { "paper", "rock", "scissors" };
+    int printSize;
 
-        if (result == LE_OK)
-        {
-            result = WriteFile(filePtr, stringPtr, 1);
-        }
+    LE_ASSERT((revisionId >= 1) && (revisionId <= 3));
 
-        stringPtr++;
-    }
+    printSize = snprintf(pathBuffer,
+                         pathSize,
+                         "%s/%s.%s",
+                         CFG_TREE_PATH,
+                         treeNameRef,
+                         revNames[revisionId - 1]);
 
-    if (result == LE_OK)
+    if (printSize >= pathSize)
     {
-        char strBuffer[2] = { endChar, ' ' };
-        result = WriteFile(filePtr, strBuffer, sizeof(strBuffer));
+       LE_ERROR("Unable to store config tree path in buffer");
+       pathBuffer[0] = '\0';
     }
-
-    return result;
 }
 
 
@@ -2173,139 +2565,1130 @@ static le_result_t WriteStringValue
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Read a node value from the given file.  If the value is a collection, then read in those nodes
- *  too.
+ *  Check to see if a configTree file at the given revision already exists in the filesystem.
  *
- *  @return LE_OK if the read is successful.
- *          LE_FORMAT_ERROR if parse errors are encountered.
- *          LE_NOT_FOUND if the end of file is reached.
+ *  @note If the tree file exists, but is empty, then it is invalid and will be deleted.
+ *
+ *  @return True if the named file exists, false otherwise.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t InternalReadNode
+static bool TreeFileExists
 (
-    tdb_NodeRef_t nodeRef,  ///< [IN] The node we're reading a value for.
-    FILE* filePtr,          ///< [IN] The file we're reading the value from.
-    size_t pathLen          ///< [IN] The length of the path including nodeRef.
+    const char* treeNameRef,  ///< [IN] Name of the tree to check.
+    int revisionId            ///< [IN] The revision of the tree to check against.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    static char stringBuffer[LE_CFG_STR_LEN_BYTES] = "";
-
-    TokenType_t tokenType;
+    char fullPath[LE_CFG_STR_LEN_BYTES] = "";
+    GetTreePath(treeNameRef, revisionId, fullPath, sizeof(fullPath));
 
-    // Try to read this node's value.
-    if (ReadToken(filePtr, stringBuffer, sizeof(stringBuffer), &tokenType) != LE_OK)
+    // Make sure this part was successful.
+    if (fullPath[0] == '\0')
     {
-        LE_ERROR("Unexpected EOF or bad token in file.");
-        return LE_FORMAT_ERROR;
+        return false;
     }
 
-    tdb_SetEmpty(nodeRef);
-
-    switch (tokenType)
+    // stat() the file to see if it exists and get its size.
+    struct stat s;
+    if (stat(fullPath, &s) == -1)
     {
-        case TT_BOOL_VALUE:
-            tdb_SetValueAsString(nodeRef, stringBuffer);
-            nodeRef->type = LE_CFG_TYPE_BOOL;
-            break;
-
-        case TT_INT_VALUE:
-            tdb_SetValueAsString(nodeRef, stringBuffer);
-            nodeRef->type = LE_CFG_TYPE_INT;
-            break;
+        LE_DEBUG("Can't stat file '%s' (%m).", fullPath);
+        return false;
+    }
 
-        case TT_FLOAT_VALUE:
-            tdb_SetValueAsString(nodeRef, stringBuffer);
-            nodeRef->type = LE_CFG_TYPE_FLOAT;
-            break;
+    // Make sure it's a regular file.
+    if (!S_ISREG(s.st_mode))
+    {
+        LE_FATAL("Object at '%s' is not a regular file.", fullPath);
+    }
 
-        case TT_STRING_VALUE:
-            tdb_SetValueAsString(nodeRef, stringBuffer);
-            break;
+    // If it's zero size, delete it and report that it doesn't exist.
+    if (s.st_size == 0)
+    {
+        if (unlink(fullPath) == -1)
+        {
+            LE_FATAL("Failed to unlink empty file '%s' (%m).", fullPath);
+        }
 
-        case TT_EMPTY_VALUE:
-            // The node has already been cleared, so there's nothing left to do but make sure that
-            // the node exists.
-            ClearDeletedFlag(nodeRef);
-            break;
+        return false;
+    }
 
-        case TT_OPEN_GROUP:
-            while (tokenType != TT_CLOSE_GROUP)
-            {
-                if (ReadToken(filePtr, stringBuffer, sizeof(stringBuffer), &tokenType) != LE_OK)
-                {
-                    LE_ERROR("Unexpected EOF or bad token in file while looking for '}'.");
-                    return LE_FORMAT_ERROR;
-                }
+    // NOTE: The Config Tree generally runs as root, so permissions should be irrelevant.
 
-                if (tokenType == TT_STRING_VALUE)
-                {
-                    size_t strLen = le_utf8_NumBytes(stringBuffer);
-                    size_t newPathLen = pathLen + 1 + strLen;
+    return true;
+}
 
-                    if (newPathLen > LE_CFG_STR_LEN)
-                    {
-                        LE_ERROR("New path length for node '%s' is too long.  %zu of %zu bytes.",
-                                 stringBuffer,
-                                 strLen,
-                                 (size_t)LE_CFG_STR_LEN);
 
-                        return LE_FORMAT_ERROR;
-                    }
 
-                    tdb_NodeRef_t childRef = GetNamedChild(nodeRef, stringBuffer);
 
-                    if (childRef == NULL)
-                    {
-                        childRef = NewChildNode(nodeRef);
-                        if (tdb_SetNodeName(childRef, stringBuffer) != LE_OK)
-                        {
-                            LE_ERROR("Bad node name, '%s'.", stringBuffer);
-                            return LE_FORMAT_ERROR;
+// -------------------------------------------------------------------------------------------------
+/**
+ * Check the filesystem and get the current "valid" version of the file and update the tree object
+ * with that version number.
+ *
+ * If there are two files for a given tree, we use the older one.  The idea being, if there are
+ * two versions of the same file in the filesystem then there was a system failure during a save
+ * operation.  So we abandon the newer (probably incomplete) file and go with the older file;
+ * unless the size of the older file is zero, which can happen if deletion of that file is
+ * interrupted.
+ */
+// -------------------------------------------------------------------------------------------------
+static void UpdateRevision
+(
+    tdb_TreeRef_t treeRef  ///< [IN] Update the revision for this tree object.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    int newRevision = 0;
+
+    if (TreeFileExists(treeRef->name, 1))
+    {
+        if (TreeFileExists(treeRef->name, 3))
+        {
+            newRevision = 3;
+        }
+        else
+        {
+            newRevision = 1;
+        }
+    }
+    else if (TreeFileExists(treeRef->name, 3))
+    {
+        if (TreeFileExists(treeRef->name, 2))
+        {
+            newRevision = 2;
+        }
+        else
+        {
+            newRevision = 3;
+        }
+    }
+    else if (TreeFileExists(treeRef->name, 2))
+    {
+        newRevision = 2;
+    }
+
+    treeRef->revisionId = newRevision;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Peek into the input stream one character ahead.
+ */
+// -------------------------------------------------------------------------------------------------
+static signed char PeekChar
+(
+    FILE* filePtr  ///< [IN] The file stream to peek into.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    char next = fgetc(filePtr);
+    ungetc(next, filePtr);
+
+    return next;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Skip any whitespace encountered in the input stream.  Stop skipping once we hit a valid token.
+ *
+ *  @return LE_OK if the whitespace is skiped and there is still more file to read.
+ *          LE_OUT_OF_RANGE if the end of the file is hit.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t SkipWhiteSpace
+(
+    FILE* filePtr  ///< [IN] The file stream to seek through.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    bool done = false;
+    bool isEof = false;
+
+    while (done == false)
+    {
+        switch (PeekChar(filePtr))
+        {
+            case '\n':
+            case '\r':
+            case '\t':
+            case ' ':
+                // Eat the character.
+                fgetc(filePtr);
+                break;
+
+            case EOF:
+                done = true;
+                isEof = true;
+                break;
+
+            default:
+                done = true;
+                break;
+        }
+    }
+
+    return isEof == true ? LE_OUT_OF_RANGE : LE_OK;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read a boolean literal from the input file.
+ *
+ *  @return LE_OK if the literal could be read.
+ *          LE_FORMAT_ERROR if the literal could not be read.
+ */
+// -------------------------------------------------------------------------------------------------
+static bool ReadBoolToken
+(
+    FILE* filePtr,     ///< [IN]  The file we're reading from.
+    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
+    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+)
+// -------------------------------------------------------------------------------------------------
+{
+    signed char next = fgetc(filePtr);
+
+    if (   (next == 't')
+        || (next == 'f'))
+    {
+        stringPtr[0] = next;
+        stringPtr[1] = 0;
+
+        return LE_OK;
+    }
+
+    return LE_FORMAT_ERROR;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read a textual literal from the input file, the read is terminated successfuly if the terminal
+ *  character is found.
+ *
+ *  @return LE_OK if the string is read from the file.
+ *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t ReadTextLiteral
+(
+    FILE* filePtr,        ///< [IN]  The file we're reading from.
+    char* stringPtr,      ///< [OUT] String buffer to hold the token we've read.
+    size_t stringSize,    ///< [IN]  How big is the supplied string buffer?
+    signed char terminal  ///< [IN]  The terminal character we're searching for.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    signed char next;
+    size_t count = 0;
+
+    char* oldPtr = stringPtr;
+
+    while ((next = fgetc(filePtr)) != terminal)
+    {
+        if (next == EOF)
+        {
+            LE_ERROR("Missing end specifier, ']' in int value.");
+            return LE_FORMAT_ERROR;
+        }
+
+        if (next == '\\')
+        {
+            next = fgetc(filePtr);
+
+            if (next == EOF)
+            {
+                LE_ERROR("Unexpected EOF after finding \\ character.");
+                return LE_FORMAT_ERROR;
+            }
+        }
+
+        *stringPtr = next;
+
+        ++stringPtr;
+        ++count;
+
+        if (count >= (stringSize - 1))
+        {
+            *stringPtr = 0;
+
+            LE_ERROR("String literal, '%s', too large.  (%zd/%zd)",
+                     oldPtr,
+                     strlen(oldPtr),
+                     stringSize);
+
+            return LE_FORMAT_ERROR;
+        }
+    }
+
+    *stringPtr = 0;
+
+    return LE_OK;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read an integer token string from the file.
+ *
+ *  @return LE_OK if the string is read from the file.
+ *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t ReadIntToken
+(
+    FILE* filePtr,     ///< [IN]  The file we're reading from.
+    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
+    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+)
+// -------------------------------------------------------------------------------------------------
+{
+    le_result_t result = ReadTextLiteral(filePtr, stringPtr, stringSize, ']');
+
+    // TODO: Validate the int string.
+
+    return result;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read a floating point token string from the file.
+ *
+ *  @return LE_OK if the string is read from the file.
+ *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t ReadFloatToken
+(
+    FILE* filePtr,     ///< [IN]  The file we're reading from.
+    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
+    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+)
+// -------------------------------------------------------------------------------------------------
+{
+    le_result_t result = ReadTextLiteral(filePtr, stringPtr, stringSize, ')');
+
+    // TODO: Validate the float string.
+
+    return result;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read a string from the config tree file.
+ *
+ *  @return LE_OK if the string is read from the file.
+ *          LE_FORMAT_ERROR if the text fails to be read from the file.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t ReadStringToken
+(
+    FILE* filePtr,     ///< [IN]  The file we're reading from.
+    char* stringPtr,   ///< [OUT] String buffer to hold the token we've read.
+    size_t stringSize  ///< [IN]  How big is the supplied string buffer?
+)
+// -------------------------------------------------------------------------------------------------
+{
+    le_result_t result = ReadTextLiteral(filePtr, stringPtr, stringSize, '"');
+
+    // TODO: Validate the literal string.
+
+    return result;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read a token from the input stream.
+ *
+ *  @return LE_OK if a token could be read.  LE_OUT_OF_RANGE if the end of the stream is reached
+ *          before a token could be finished.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t ReadToken
+(
+    FILE* filePtr,         ///< [IN]  The file we're reading from.
+    char* stringPtr,       ///< [OUT] String buffer to hold the token we've read.
+    size_t stringSize,     ///< [IN]  How big is the supplied string buffer?
+    TokenType_t* typePtr   ///< [OUT] The type of token read from the file.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    *stringPtr = 0;
+
+    if (SkipWhiteSpace(filePtr) != LE_OK)
+    {
+        return LE_OUT_OF_RANGE;
+    }
+
+    signed char next;
+
+    while ((next = fgetc(filePtr)) != EOF)
+    {
+        switch (next)
+        {
+            case '~':
+                *typePtr = TT_EMPTY_VALUE;
+                return LE_OK;
+
+            case '!':
+                *typePtr = TT_BOOL_VALUE;
+                return ReadBoolToken(filePtr, stringPtr, stringSize);
+
+            case '[':
+                *typePtr = TT_INT_VALUE;
+                return ReadIntToken(filePtr, stringPtr, stringSize);
+
+            case '(':
+                *typePtr = TT_FLOAT_VALUE;
+                return ReadFloatToken(filePtr, stringPtr, stringSize);
+
+            case '\"':
+                *typePtr = TT_STRING_VALUE;
+                return ReadStringToken(filePtr, stringPtr, stringSize);
+
+            case '{':
+                *typePtr = TT_OPEN_GROUP;
+                return LE_OK;
+
+            case '}':
+                *typePtr = TT_CLOSE_GROUP;
+                return LE_OK;
+
+            default:
+                LE_ERROR("Unexpected character in input stream.");
+                return LE_FORMAT_ERROR;
+        }
+    }
+
+    return LE_OUT_OF_RANGE;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Write data to the output stream.  This function will record any faults to the system log.
+ *
+ *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t WriteFile
+(
+    FILE* filePtr,        ///< [IN] The file being written to.
+    const void* dataPtr,  ///< [IN] The data being written to the file.
+    size_t dataSize       ///< [IN] The amount of data being written.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    ssize_t written = fwrite(dataPtr, 1, dataSize, filePtr);
+
+    if (ferror(filePtr) != 0)
+    {
+        LE_EMERG("Failed to write to config tree file.");
+        return LE_IO_ERROR;
+    }
+
+    if (written < dataSize)
+    {
+        LE_EMERG("Data truncated while writing to configuration file.");
+        return LE_IO_ERROR;
+    }
+
+    return LE_OK;
+}
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Write a string token to the output stream.  This function will write the string and escape all
+ *  control characters as it does so.
+ *
+ *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t WriteStringValue
+(
+    FILE* filePtr,         ///< [IN] The file to write to.
+    char startChar,        ///< [IN] The delimiter to use.
+    char endChar,          ///< [IN] The closing delimiter to use.
+    const char* stringPtr  ///< [IN] The actual string to write.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    le_result_t result = LE_OK;
+
+    result = WriteFile(filePtr, &startChar, 1);
+
+    while (   (*stringPtr != 0)
+           && (result == LE_OK))
+    {
+        if (   (*stringPtr == '\"')
+            || (*stringPtr == '\\'))
+        {
+            result = WriteFile(filePtr, "\\", 1);
+        }
+
+        if (result == LE_OK)
+        {
+            result = WriteFile(filePtr, stringPtr, 1);
+        }
+
+        stringPtr++;
+    }
+
+    if (result == LE_OK)
+    {
+        char strBuffer[2] = { endChar, ' ' };
+        result = WriteFile(filePtr, strBuffer, sizeof(strBuffer));
+    }
+
+    return result;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Read a node value from the given file.  If the value is a collection, then read in those nodes
+ *  too.
+ *
+ *  @return LE_OK if the read is successful.
+ *          LE_FORMAT_ERROR if parse errors are encountered.
+ *          LE_NOT_FOUND if the end of file is reached.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t InternalReadNode
+(
+    tdb_NodeRef_t nodeRef,  ///< [IN] The node we're reading a value for.
+    FILE* filePtr,          ///< [IN] The file we're reading the value from.
+    size_t pathLen          ///< [IN] The length of the path including nodeRef.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    static char stringBuffer[LE_CFG_STR_LEN_BYTES] = "";
+
+    TokenType_t tokenType;
+
+    // Try to read this node's value.
+    if (ReadToken(filePtr, stringBuffer, sizeof(stringBuffer), &tokenType) != LE_OK)
+    {
+        LE_ERROR("Unexpected EOF or bad token in file.");
+        return LE_FORMAT_ERROR;
+    }
+
+    tdb_SetEmpty(nodeRef);
+
+    switch (tokenType)
+    {
+        case TT_BOOL_VALUE:
+            tdb_SetValueAsString(nodeRef, stringBuffer);
+            nodeRef->type = LE_CFG_TYPE_BOOL;
+            break;
+
+        case TT_INT_VALUE:
+            tdb_SetValueAsString(nodeRef, stringBuffer);
+            nodeRef->type = LE_CFG_TYPE_INT;
+            break;
+
+        case TT_FLOAT_VALUE:
+            tdb_SetValueAsString(nodeRef, stringBuffer);
+            nodeRef->type = LE_CFG_TYPE_FLOAT;
+            break;
+
+        case TT_STRING_VALUE:
+            tdb_SetValueAsString(nodeRef, stringBuffer);
+            break;
+
+        case TT_EMPTY_VALUE:
+            // The node has already been cleared, so there's nothing left to do but make sure that
+            // the node exists.
+            ClearDeletedFlag(nodeRef);
+            break;
+
+        case TT_OPEN_GROUP:
+            while (tokenType != TT_CLOSE_GROUP)
+            {
+                if (ReadToken(filePtr, stringBuffer, sizeof(stringBuffer), &tokenType) != LE_OK)
+                {
+                    LE_ERROR("Unexpected EOF or bad token in file while looking for '}'.");
+                    return LE_FORMAT_ERROR;
+                }
+
+                if (tokenType == TT_STRING_VALUE)
+                {
+                    size_t strLen = le_utf8_NumBytes(stringBuffer);
+                    size_t newPathLen = pathLen + 1 + strLen;
+
+                    if (newPathLen > LE_CFG_STR_LEN)
+                    {
+                        LE_ERROR("New path length for node '%s' is too long.  %zu of %zu bytes.",
+                                 stringBuffer,
+                                 strLen,
+                                 (size_t)LE_CFG_STR_LEN);
+
+                        return LE_FORMAT_ERROR;
+                    }
+
+                    tdb_NodeRef_t childRef = GetNamedChild(nodeRef, stringBuffer);
+
+                    if (childRef == NULL)
+                    {
+                        childRef = NewChildNode(nodeRef);
+                        if (tdb_SetNodeName(childRef, stringBuffer) != LE_OK)
+                        {
+                            LE_ERROR("Bad node name, '%s'.", stringBuffer);
+                            return LE_FORMAT_ERROR;
                         }
 
-                        LE_DEBUG("New node, %s", stringBuffer);
-                    }
+                        LE_DEBUG("New node, %s", stringBuffer);
+                    }
+
+                    tdb_EnsureExists(childRef);
+
+                    le_result_t result = InternalReadNode(childRef, filePtr, newPathLen);
+
+                    if (result != LE_OK)
+                    {
+                        return result;
+                    }
+                }
+                else if (tokenType == TT_CLOSE_GROUP)
+                {
+                    break;
+                }
+                else
+                {
+                    LE_ERROR("Unexpected token in found while looking for '}'.");
+                    return LE_FORMAT_ERROR;
+                }
+            }
+            break;
+
+        case TT_CLOSE_GROUP:
+        default:
+            LE_ERROR("Unexpected token found.");
+            return LE_FORMAT_ERROR;
+    }
+
+    if (IsShadow(nodeRef) == false)
+    {
+        ClearModifiedFlag(nodeRef);
+    }
+    else
+    {
+        SetModifiedFlag(nodeRef);
+    }
+
+    tdb_EnsureExists(nodeRef);
+
+    return LE_OK;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Serialize a tree node and it's children to a file in the filesystem.
+ *
+ *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
+ */
+// -------------------------------------------------------------------------------------------------
+static le_result_t InternalWriteNode
+(
+    tdb_NodeRef_t nodeRef,  ///< [IN] The node being written.
+    FILE* filePtr           ///< [IN] The file being written to.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    // If there is no node to write, or if the node is marked as having been deleted...  Then write
+    // a blank node.
+    if (   (nodeRef == NULL)
+        || (IsDeleted(nodeRef) == true))
+    {
+        return WriteFile(filePtr, "~ ", 2);
+    }
+
+    // Get the node's value as a string.
+    static char stringBuffer[LE_CFG_STR_LEN_BYTES] = "";
+    le_result_t result = LE_OK;
+
+    tdb_GetValueAsString(nodeRef, stringBuffer, sizeof(stringBuffer), "");
+
+    // Now, depending on the type of node, write out any required format information.
+    switch (nodeRef->type)
+    {
+        case LE_CFG_TYPE_EMPTY:
+        case LE_CFG_TYPE_DOESNT_EXIST:
+            result = WriteFile(filePtr, "~ ", 2);
+            break;
+
+        case LE_CFG_TYPE_BOOL:
+            {
+                const char boolBuffer[3] = { '!', stringBuffer[0], ' ' };
+                result = WriteFile(filePtr, boolBuffer, sizeof(boolBuffer));
+            }
+            break;
+
+        case LE_CFG_TYPE_STRING:
+            result = WriteStringValue(filePtr, '\"', '\"', stringBuffer);
+            break;
+
+        case LE_CFG_TYPE_INT:
+            result = WriteStringValue(filePtr, '[', ']', stringBuffer);
+            break;
+
+        case LE_CFG_TYPE_FLOAT:
+            result = WriteStringValue(filePtr, '(', ')', stringBuffer);
+            break;
+
+        // Looks like this node is a collection, so write out it's child nodes now.
+        case LE_CFG_TYPE_STEM:
+            if ((result = WriteFile(filePtr, "{ ", 2)) == LE_OK)
+            {
+                tdb_NodeRef_t childRef = tdb_GetFirstActiveChildNode(nodeRef);
+
+                while (   (childRef != NULL)
+                       && (result == LE_OK))
+                {
+                    tdb_GetNodeName(childRef, stringBuffer, sizeof(stringBuffer));
+                    result = WriteStringValue(filePtr, '\"', '\"', stringBuffer);
+
+                    if (result == LE_OK)
+                    {
+                        result = InternalWriteNode(childRef, filePtr);
+                    }
+
+                    childRef = tdb_GetNextActiveSiblingNode(childRef);
+                }
+
+                if (result == LE_OK)
+                {
+                    result = WriteFile(filePtr, "} ", 2);
+                }
+            }
+            break;
+    }
+
+    return result;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Calculate the number of bytes required to store a node path, including seperators and a trailing
+ *  NULL.
+ *
+ *  @return The amount of bytes required to store the whole path string.
+ */
+// -------------------------------------------------------------------------------------------------
+static size_t ComputePathLength
+(
+    tdb_NodeRef_t nodeRef  ///< [IN] Compute a path for this node.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    size_t pathLen = 0;
+    char nodeName[LE_CFG_NAME_LEN_BYTES] = "";
+
+    while (nodeRef != NULL)
+    {
+        LE_ASSERT(tdb_GetNodeName(nodeRef, nodeName, sizeof(nodeName)) == LE_OK);
+
+        // Add this path segment's length to our running total, along with the required path
+        // seperator.
+        pathLen += 1 + le_utf8_NumBytes(nodeName);
+        nodeRef = tdb_GetNodeParent(nodeRef);
+    }
+
+    // Don't forget to include a spot for the trailing NULL.
+    return pathLen + 1;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Bump up the version id of this tree.
+ */
+// -------------------------------------------------------------------------------------------------
+static void IncrementRevision
+(
+    tdb_TreeRef_t treeRef  ///< [IN] Increment the revision of this tree.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    treeRef->revisionId++;
+
+    if (treeRef->revisionId > 3)
+    {
+        treeRef->revisionId = 1;
+    }
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Check to see if the removal of a tree's files is still waiting on the persistence thread.
+ *
+ *  @return True if the tree's files are queued to be deleted, false if not.
+ */
+// -------------------------------------------------------------------------------------------------
+static bool IsTreeFileDeletePending
+(
+    const char* treeNamePtr  ///< [IN] The name of the tree to check.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    bool isPending = false;
+
+    le_mutex_Lock(PersistMutexRef);
+
+    le_dls_Link_t* linkPtr = le_dls_Peek(&PendingDeleteList);
+
+    while (linkPtr != NULL)
+    {
+        PersistJob_t* jobPtr = CONTAINER_OF(linkPtr, PersistJob_t, link);
+
+        if (strcmp(jobPtr->treeRef->name, treeNamePtr) == 0)
+        {
+            isPending = true;
+            break;
+        }
+
+        linkPtr = le_dls_PeekNext(&PendingDeleteList, linkPtr);
+    }
+
+    le_mutex_Unlock(PersistMutexRef);
+
+    return isPending;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Attempt to load a configuration tree from a config file.  This function will look for the latest
+ *  valid version of the config file and load that one.
+ */
+// -------------------------------------------------------------------------------------------------
+static void LoadTree
+(
+    tdb_TreeRef_t treeRef  ///< [IN] The tree object to load from the filesystem.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    // If this tree has no root, create it now.
+    if (treeRef->rootNodeRef == NULL)
+    {
+        treeRef->rootNodeRef = NewNode();
+    }
+
+    // Writes are only queued for trees that are loaded, so the only persistence job that can still
+    // be using this tree's files is the removal of a tree of the same name that has since been
+    // deleted.  Those files are on their way out, so just start this tree out empty instead of
+    // waiting on the persistence thread.  Any write of the new tree is queued after the delete.
+    if (IsTreeFileDeletePending(treeRef->name))
+    {
+        LE_DEBUG("** Tree '%s' is still being deleted, starting it out empty.", treeRef->name);
+        return;
+    }
+
+    // If we don't know the revision then hunt it out from the filesystem.
+    if (treeRef->revisionId == 0)
+    {
+        UpdateRevision(treeRef);
+    }
+
+    // Ok, if we found a valid revision of the tree in the fs, try to load it now.
+    if (treeRef->revisionId != 0)
+    {
+        char pathPtr[LE_CFG_STR_LEN_BYTES] = "";
+        GetTreePath(treeRef->name, treeRef->revisionId, pathPtr, sizeof(pathPtr));
 
-                    tdb_EnsureExists(childRef);
+        LE_DEBUG("** Loading configuration tree from '%s'.", pathPtr);
 
-                    le_result_t result = InternalReadNode(childRef, filePtr, newPathLen);
+        int fileRef = -1;
 
-                    if (result != LE_OK)
-                    {
-                        return result;
-                    }
-                }
-                else if (tokenType == TT_CLOSE_GROUP)
-                {
-                    break;
-                }
-                else
-                {
-                    LE_ERROR("Unexpected token in found while looking for '}'.");
-                    return LE_FORMAT_ERROR;
-                }
+        do
+        {
+            fileRef = open(pathPtr, O_RDONLY);
+        }
+        while ((fileRef == -1) && (errno == EINTR));
+
+        tdb_EnsureExists(treeRef->rootNodeRef);
+
+        if (fileRef == -1)
+        {
+            LE_ERROR("Could not open configuration tree file: %s, reason: %s",
+                     pathPtr,
+                     strerror(errno));
+        }
+        else
+        {
+            if (tdb_ReadTreeNode(treeRef->rootNodeRef, fileRef) == false)
+            {
+                LE_ERROR("Could not parse configuration tree file: %s.", pathPtr);
+                le_mem_Release(treeRef->rootNodeRef);
+                treeRef->rootNodeRef = NewNode();
             }
-            break;
 
-        case TT_CLOSE_GROUP:
-        default:
-            LE_ERROR("Unexpected token found.");
-            return LE_FORMAT_ERROR;
+            close(fileRef);
+        }
     }
+}
 
-    if (IsShadow(nodeRef) == false)
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Free a registration object that no longer has any handlers.
+ */
+// -------------------------------------------------------------------------------------------------
+static void ReleaseRegistration
+(
+    Registration_t* registrationPtr  ///< [IN] The registration object to free.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(registrationPtr->triggered == false);
+
+    RemoveWatch(registrationPtr);
+    le_hashmap_Remove(HandlerRegistrationMap, registrationPtr->registrationPath);
+    le_mem_Release(registrationPtr);
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Removes the handler object from the given registration object.  This function will also free the
+ *  memory that the handler object had used.
+ */
+// -------------------------------------------------------------------------------------------------
+static void RemoveHandler
+(
+    Registration_t* registrationPtr,  ///< [IN] The registration object to remove the link from.
+    Handler_t* handlerPtr             ///< [IN] The handler object we're removing.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    // Kill the ref, and remove the object from the registration list.  Any changes still waiting
+    // on the debounce timer are dropped.
+    le_ref_DeleteRef(HandlerSafeRefMap, handlerPtr->safeRef);
+    le_dls_Remove(&registrationPtr->handlerList, &handlerPtr->link);
+
+    if (handlerPtr->debounceTimerRef != NULL)
     {
-        ClearModifiedFlag(nodeRef);
+        le_timer_Delete(handlerPtr->debounceTimerRef);
+        handlerPtr->debounceTimerRef = NULL;
     }
-    else
+
+    // Clear out the link data, just to be safe.
+    handlerPtr->link = LE_DLS_LINK_INIT;
+    handlerPtr->sessionRef = NULL;
+    handlerPtr->registrationPtr = NULL;
+    handlerPtr->safeRef = NULL;
+
+    // Finally kill the object.
+    le_mem_Release(handlerPtr);
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  This function is called by the hash map ForEach function, which is invoked when a session closed
+ *  event occurs.
+ *
+ *  This function takes care of cleaning out orphaned event handlers from the registration objects
+ *  currently stored in the registration hash map.  If a given registration handler is no longer
+ *  required then the object itself is queued for deletion.  It is queued and not deleted in place
+ *  because the hash map does not support deleting objects in the middle of an iteration.
+ *
+ *  @return True.  This function always returns true to indicate that iteration should continue
+ *          until the end of the hash map.
+ */
+// -------------------------------------------------------------------------------------------------
+static bool OnHandlerRegistrationCleanup
+(
+    const void* keyPtr,    ///< [IN] The key used by this hash entry.
+    const void* valuePtr,  ///< [IN] The registration object.
+    void* contextPtr       ///< [IN] Context info including the ref for the session that closed.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    // Convert our pointers into something useable.
+    Registration_t* registrationPtr = (Registration_t*)valuePtr;
+    CleanUpContext_t* cleanUpContextPtr = (CleanUpContext_t*)contextPtr;
+
+    // Go through this registration object's list of update handlers and check to see if they were
+    // registered on the target session.  If so, free them from the list.
+    le_dls_Link_t* linkPtr = le_dls_Peek(&registrationPtr->handlerList);
+
+    while (linkPtr != NULL)
     {
-        SetModifiedFlag(nodeRef);
+        Handler_t* handlerObjectPtr = CONTAINER_OF(linkPtr, Handler_t, link);
+        linkPtr = le_dls_PeekNext(&registrationPtr->handlerList, linkPtr);
+
+        if (handlerObjectPtr->sessionRef == cleanUpContextPtr->sessionRef)
+        {
+            RemoveHandler(registrationPtr, handlerObjectPtr);
+        }
+    }
+
+    // Now, check to see if there are any handlers left in this object.  If the registration object
+    // is empty, then queue it for deletion.
+    if (le_dls_IsEmpty(&registrationPtr->handlerList))
+    {
+        registrationPtr->link = LE_SLS_LINK_INIT;
+        le_sls_Queue(&cleanUpContextPtr->deleteQueue, &registrationPtr->link);
+    }
+
+    // We want to continue iterating through the collection.
+    return true;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Call this function to delete a tree file from the filesystem.
+ */
+// -------------------------------------------------------------------------------------------------
+static void DeleteTreeFile
+(
+    const char* filePathPtr  ///< Path to the tree file in question.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    LE_DEBUG("** Deleting tree file, '%s'.", filePathPtr);
+
+    if (unlink(filePathPtr) != 0)
+    {
+        LE_ERROR("File delete failure, '%s', reason '%m'.", filePathPtr);
+    }
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Find the root node represented by the path ref.
+ *
+ *  If the path is an absolute path, then the base node for the reference is the root node of the
+ *  tree in question.
+ *
+ *  If the path is a relative path, then the base node of the request is the node given.
+ *
+ *  @return A reference to the base node of the operation.
+ */
+// -------------------------------------------------------------------------------------------------
+static tdb_NodeRef_t GetPathBaseNodeRef
+(
+    tdb_NodeRef_t nodeRef,         ///< [IN] The base node to start from.
+    le_pathIter_Ref_t nodePathRef  ///< [IN] The path we're searching for in the tree.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    // If the path is absolute and the node we were given is NOT the root node of it's tree, find
+    // the root node of the tree.  Otherwise just return the node reference we were given.
+    if (   (le_pathIter_IsAbsolute(nodePathRef))
+        && (nodeRef->parentRef != NULL))
+    {
+        nodeRef = GetRootParentNode(nodeRef);
+    }
+
+    return nodeRef;
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Create a new C style file pointer from the POSIX file descriptor.
+ *
+ *  @return A file pointer that may be read or written if successful.  A null pointer otherwise.
+ */
+// -------------------------------------------------------------------------------------------------
+static FILE* OpenFilePtr
+(
+    int descriptor,   ///< [IN] The POSIX file descriptor to create a file pointer from.
+    const char* mode  ///< [IN] The mode to open the file pointer in.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    // Duplicate the file descriptor, this is because we later use a C library file pointer for the
+    // parsing routines.  When the file pointer is closed it also closes the underlying descriptor,
+    // which may not be what the caller wants or expects.
+    int newDescriptor = -1;
+
+    do
+    {
+        newDescriptor = dup(descriptor);
+    }
+    while (   (newDescriptor == -1)
+           && (errno == EINTR));
+
+    if (newDescriptor == -1)
+    {
+        LE_ERROR("Could not duplicate file descriptor, reason: %s", strerror(errno));
+        return NULL;
     }
 
-    tdb_EnsureExists(nodeRef);
+    // Attempt to open the file pointer from the descriptor.
+    FILE* filePtr = fdopen(newDescriptor, mode);
+
+    if (filePtr == NULL)
+    {
+        // The open failed, so clean up the dangling descriptor.
+        int oldErrno = errno;
+
+        close(newDescriptor);
+
+        LE_ERROR("Could not access the input stream for tree import, reason: %s",
+                 strerror(oldErrno));
+    }
 
-    return LE_OK;
+    // Return the file pointer we have now.  Note, it may be NULL at this point.
+    return filePtr;
 }
 
 
@@ -2313,88 +3696,47 @@ static le_result_t InternalReadNode
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Serialize a tree node and it's children to a file in the filesystem.
- *
- *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
+ *  Close the file pointer and flush any data left unwritten.
  */
 // -------------------------------------------------------------------------------------------------
-static le_result_t InternalWriteNode
+static void CloseFilePtr
 (
-    tdb_NodeRef_t nodeRef,  ///< [IN] The node being written.
-    FILE* filePtr           ///< [IN] The file being written to.
+    FILE* filePtr  ///< The file pointer to close.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // If there is no node to write, or if the node is marked as having been deleted...  Then write
-    // a blank node.
-    if (   (nodeRef == NULL)
-        || (IsDeleted(nodeRef) == true))
+    if (fclose(filePtr) == EOF)
     {
-        return WriteFile(filePtr, "~ ", 2);
+        LE_ERROR("Could not properly close file, reason: %s", strerror(errno));
     }
+}
 
-    // Get the node's value as a string.
-    static char stringBuffer[LE_CFG_STR_LEN_BYTES] = "";
-    le_result_t result = LE_OK;
-
-    tdb_GetValueAsString(nodeRef, stringBuffer, sizeof(stringBuffer), "");
-
-    // Now, depending on the type of node, write out any required format information.
-    switch (nodeRef->type)
-    {
-        case LE_CFG_TYPE_EMPTY:
-        case LE_CFG_TYPE_DOESNT_EXIST:
-            result = WriteFile(filePtr, "~ ", 2);
-            break;
-
-        case LE_CFG_TYPE_BOOL:
-            {
-                const char boolBuffer[3] = { '!', stringBuffer[0], ' ' };
-                result = WriteFile(filePtr, boolBuffer, sizeof(boolBuffer));
-            }
-            break;
-
-        case LE_CFG_TYPE_STRING:
-            result = WriteStringValue(filePtr, '\"', '\"', stringBuffer);
-            break;
-
-        case LE_CFG_TYPE_INT:
-            result = WriteStringValue(filePtr, '[', ']', stringBuffer);
-            break;
-
-        case LE_CFG_TYPE_FLOAT:
-            result = WriteStringValue(filePtr, '(', ')', stringBuffer);
-            break;
 
-        // Looks like this node is a collection, so write out it's child nodes now.
-        case LE_CFG_TYPE_STEM:
-            if ((result = WriteFile(filePtr, "{ ", 2)) == LE_OK)
-            {
-                tdb_NodeRef_t childRef = tdb_GetFirstActiveChildNode(nodeRef);
 
-                while (   (childRef != NULL)
-                       && (result == LE_OK))
-                {
-                    tdb_GetNodeName(childRef, stringBuffer, sizeof(stringBuffer));
-                    result = WriteStringValue(filePtr, '\"', '\"', stringBuffer);
 
-                    if (result == LE_OK)
-                    {
-                        result = InternalWriteNode(childRef, filePtr);
-                    }
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Called for each active iterator when a snapshot of a tree is taken.  Read iterators on the live
+ *  tree are moved onto the snapshot.
+ */
+// -------------------------------------------------------------------------------------------------
+static void OnMoveReaderToSnapshot
+(
+    ni_ConstIteratorRef_t iteratorRef,  ///< [IN] The iterator pointer.
+    void* contextPtr                    ///< [IN] The snapshot tree.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    tdb_TreeRef_t snapshotRef = (tdb_TreeRef_t)contextPtr;
 
-                    childRef = tdb_GetNextActiveSiblingNode(childRef);
-                }
+    if (   (ni_GetTree(iteratorRef) == snapshotRef->liveTreeRef)
+        && (ni_IsWriteable(iteratorRef) == false))
+    {
+        ni_SetTree((ni_IteratorRef_t)iteratorRef, snapshotRef);
 
-                if (result == LE_OK)
-                {
-                    result = WriteFile(filePtr, "} ", 2);
-                }
-            }
-            break;
+        snapshotRef->liveTreeRef->activeReadCount--;
+        snapshotRef->activeReadCount++;
     }
-
-    return result;
 }
 
 
@@ -2402,33 +3744,50 @@ static le_result_t InternalWriteNode
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Calculate the number of bytes required to store a node path, including seperators and a trailing
- *  NULL.
+ *  If there are read iterators open on the given tree, take a snapshot of the tree's current
+ *  contents and move those readers onto it.  This way the live tree can be updated without changing
+ *  the data out from under the readers.
  *
- *  @return The amount of bytes required to store the whole path string.
+ *  Nothing is copied here.  The snapshot's nodes shadow the live tree's nodes, and are only given
+ *  their own copy of a node's contents when the merge is about to change that node.
  */
 // -------------------------------------------------------------------------------------------------
-static size_t ComputePathLength
+static void MoveReadersToSnapshot
 (
-    tdb_NodeRef_t nodeRef  ///< [IN] Compute a path for this node.
+    tdb_TreeRef_t treeRef  ///< [IN] The live tree that's about to be modified.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    size_t pathLen = 0;
-    char nodeName[LE_CFG_NAME_LEN_BYTES] = "";
+    LE_ASSERT(treeRef->originalTreeRef == NULL);
+    LE_ASSERT(treeRef->liveTreeRef == NULL);
 
-    while (nodeRef != NULL)
+    if (treeRef->activeReadCount == 0)
     {
-        LE_ASSERT(tdb_GetNodeName(nodeRef, nodeName, sizeof(nodeName)) == LE_OK);
-
-        // Add this path segment's length to our running total, along with the required path
-        // seperator.
-        pathLen += 1 + le_utf8_NumBytes(nodeName);
-        nodeRef = tdb_GetNodeParent(nodeRef);
+        return;
     }
 
-    // Don't forget to include a spot for the trailing NULL.
-    return pathLen + 1;
+    tdb_TreeRef_t snapshotRef = NewTree(treeRef->name, NewSnapshotNode(treeRef->rootNodeRef));
+
+    snapshotRef->liveTreeRef = treeRef;
+    treeRef->snapshotCount++;
+    le_mem_AddRef(treeRef);
+
+    ni_ForEachIter(OnMoveReaderToSnapshot, snapshotRef);
+
+    LE_DEBUG("** Moved %zd reader(s) of tree '%s' onto snapshot <%p>.",
+             snapshotRef->activeReadCount,
+             treeRef->name,
+             snapshotRef);
+
+    LE_WARN_IF(treeRef->activeReadCount != 0,
+               "%zd reader(s) of tree '%s' could not be moved onto a snapshot.",
+               treeRef->activeReadCount,
+               treeRef->name);
+
+    if (snapshotRef->activeReadCount == 0)
+    {
+        le_mem_Release(snapshotRef);
+    }
 }
 
 
@@ -2436,21 +3795,39 @@ static size_t ComputePathLength
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Bump up the version id of this tree.
+ *  Write a block of data to a file descriptor, retrying on interruptions and partial writes.
+ *
+ *  @return LE_OK if the write succeeded, LE_IO_ERROR if the write failed.
  */
 // -------------------------------------------------------------------------------------------------
-static void IncrementRevision
+static le_result_t WriteBuffer
 (
-    tdb_TreeRef_t treeRef  ///< [IN] Increment the revision of this tree.
+    int descriptor,       ///< [IN] The file being written to.
+    const char* dataPtr,  ///< [IN] The data being written to the file.
+    size_t dataSize       ///< [IN] The amount of data being written.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    treeRef->revisionId++;
-
-    if (treeRef->revisionId > 3)
+    while (dataSize > 0)
     {
-        treeRef->revisionId = 1;
+        ssize_t written = write(descriptor, dataPtr, dataSize);
+
+        if (written == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            LE_EMERG("Failed to write to config tree file (%m).");
+            return LE_IO_ERROR;
+        }
+
+        dataPtr += written;
+        dataSize -= written;
     }
+
+    return LE_OK;
 }
 
 
@@ -2458,93 +3835,132 @@ static void IncrementRevision
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Attempt to load a configuration tree from a config file.  This function will look for the latest
- *  valid version of the config file and load that one.
+ *  Write a serialized tree to the next revision of the tree's file, then remove the previous
+ *  revision.  Called on the persistence thread.
  */
 // -------------------------------------------------------------------------------------------------
-static void LoadTree
+static void WriteTreeFile
 (
-    tdb_TreeRef_t treeRef  ///< [IN] The tree object to load from the filesystem.
+    tdb_TreeRef_t treeRef,  ///< [IN] The tree being written.
+    const char* dataPtr,    ///< [IN] The serialized tree.
+    size_t dataSize         ///< [IN] Size of the serialized tree.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // If we don't know the revision then hunt it out from the filesystem.
-    if (treeRef->revisionId == 0)
+    // Increment revision of the tree and open a tree file for writing.
+    int oldId = treeRef->revisionId;
+
+    IncrementRevision(treeRef);
+
+    char filePath[LE_CFG_STR_LEN_BYTES] = "";
+    GetTreePath(treeRef->name, treeRef->revisionId, filePath, sizeof(filePath));
+
+    LE_DEBUG("Attempting to serialize the tree to '%s'.", filePath);
+
+    int fileRef = -1;
+
+    do
     {
-        UpdateRevision(treeRef);
+        fileRef = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
     }
+    while (   (fileRef == -1)
+           && (errno == EINTR));
 
-    // If this tree has no root, create it now.
-    if (treeRef->rootNodeRef == NULL)
+    if ((-1 == fileRef) && (EROFS == errno))
     {
-        treeRef->rootNodeRef = NewNode();
+        // In case we are R/O for the config tree, we discard the update to flash
+        return;
     }
 
-    // Ok, if we found a valid revision of the tree in the fs, try to load it now.
-    if (treeRef->revisionId != 0)
+    if (fileRef == -1)
     {
-        char pathPtr[LE_CFG_STR_LEN_BYTES] = "";
-        GetTreePath(treeRef->name, treeRef->revisionId, pathPtr, sizeof(pathPtr));
+        LE_EMERG("Failed to open config file '%s' (%m).", filePath);
+        LE_EMERG("Changes have been merged in memory, however they could not be committed to the "
+                 "filesystem!!");
+        return;
+    }
 
-        LE_DEBUG("** Loading configuration tree from '%s'.", pathPtr);
+    // We have a tree file to write to, so stream the new tree to it.  As this isn't holding up the
+    // main thread, make sure the data actually makes it to the disk before the old revision is
+    // removed.
+    le_result_t writeResult = WriteBuffer(fileRef, dataPtr, dataSize);
 
-        int fileRef = -1;
+    if (   (writeResult == LE_OK)
+        && (fsync(fileRef) == -1))
+    {
+        LE_EMERG("Failed to sync config file '%s' (%m).", filePath);
+        writeResult = LE_IO_ERROR;
+    }
 
-        do
-        {
-            fileRef = open(pathPtr, O_RDONLY);
-        }
-        while ((fileRef == -1) && (errno == EINTR));
+    int retVal = close(fileRef);
 
-        tdb_EnsureExists(treeRef->rootNodeRef);
+    LE_EMERG_IF(retVal == -1, "An error occurred while closing the tree file: %s", strerror(errno));
 
-        if (fileRef == -1)
+    // Finally remove the old version of the tree file, if there is one.
+    if (writeResult == LE_OK)
+    {
+        if (   (oldId != 0)
+            && (TreeFileExists(treeRef->name, oldId)))
         {
-            LE_ERROR("Could not open configuration tree file: %s, reason: %s",
-                     pathPtr,
-                     strerror(errno));
+            GetTreePath(treeRef->name, oldId, filePath, sizeof(filePath));
+            DeleteTreeFile(filePath);
         }
-        else
+    }
+    else
+    {
+        // The write failed, delete the new file we attempted to create.
+        LE_EMERG("The attempt to write to the config tree file, '%s,' failed.", filePath);
+        DeleteTreeFile(filePath);
+    }
+}
+
+
+
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Remove all revisions of a tree's file from the filesystem.  Called on the persistence thread.
+ */
+// -------------------------------------------------------------------------------------------------
+static void DeleteTreeFiles
+(
+    tdb_TreeRef_t treeRef  ///< [IN] The tree being deleted.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    for (int id = 1; id <= 3; id++)
+    {
+        if (TreeFileExists(treeRef->name, id))
         {
-            if (tdb_ReadTreeNode(treeRef->rootNodeRef, fileRef) == false)
-            {
-                LE_ERROR("Could not parse configuration tree file: %s.", pathPtr);
-                le_mem_Release(treeRef->rootNodeRef);
-                treeRef->rootNodeRef = NewNode();
-            }
+            char filePathPtr[LE_CFG_STR_LEN_BYTES] = "";
+            GetTreePath(treeRef->name, id, filePathPtr, sizeof(filePathPtr));
 
-            close(fileRef);
+            DeleteTreeFile(filePathPtr);
         }
     }
+
+    treeRef->revisionId = 0;
 }
 
 
 
+
 // -------------------------------------------------------------------------------------------------
 /**
- *  Removes the handler object from the given registration object.  This function will also free the
- *  memory that the handler object had used.
+ *  Called on the main thread once the persistence thread is done with a job.
  */
 // -------------------------------------------------------------------------------------------------
-static void RemoveHandler
+static void ReleasePersistJob
 (
-    Registration_t* registrationPtr,  ///< [IN] The registration object to remove the link from.
-    Handler_t* handlerPtr             ///< [IN] The handler object we're removing.
+    void* param1Ptr,  ///< [IN] The completed job.
+    void* param2Ptr   ///< [IN] Not used.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Kill the ref, and remove the object from the registration list.
-    le_ref_DeleteRef(HandlerSafeRefMap, handlerPtr->safeRef);
-    le_dls_Remove(&registrationPtr->handlerList, &handlerPtr->link);
-
-    // Clear out the link data, just to be safe.
-    handlerPtr->link = LE_DLS_LINK_INIT;
-    handlerPtr->sessionRef = NULL;
-    handlerPtr->registrationPtr = NULL;
-    handlerPtr->safeRef = NULL;
+    PersistJob_t* jobPtr = (PersistJob_t*)param1Ptr;
 
-    // Finally kill the object.
-    le_mem_Release(handlerPtr);
+    le_mem_Release(jobPtr->treeRef);
+    le_mem_Release(jobPtr);
 }
 
 
@@ -2552,55 +3968,74 @@ static void RemoveHandler
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  This function is called by the hash map ForEach function, which is invoked when a session closed
- *  event occurs.
- *
- *  This function takes care of cleaning out orphaned event handlers from the registration objects
- *  currently stored in the registration hash map.  If a given registration handler is no longer
- *  required then the object itself is queued for deletion.  It is queued and not deleted in place
- *  because the hash map does not support deleting objects in the middle of an iteration.
- *
- *  @return True.  This function always returns true to indicate that iteration should continue
- *          until the end of the hash map.
+ *  Run a persistence job.  Called on the persistence thread.
  */
 // -------------------------------------------------------------------------------------------------
-static bool OnHandlerRegistrationCleanup
+static void RunPersistJob
 (
-    const void* keyPtr,    ///< [IN] The key used by this hash entry.
-    const void* valuePtr,  ///< [IN] The registration object.
-    void* contextPtr       ///< [IN] Context info including the ref for the session that closed.
+    void* param1Ptr,  ///< [IN] The job to run.
+    void* param2Ptr   ///< [IN] Not used.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Convert our pointers into something useable.
-    Registration_t* registrationPtr = (Registration_t*)valuePtr;
-    CleanUpContext_t* cleanUpContextPtr = (CleanUpContext_t*)contextPtr;
+    PersistJob_t* jobPtr = (PersistJob_t*)param1Ptr;
+    tdb_TreeRef_t treeRef = jobPtr->treeRef;
+
+    // Take the job off of the tree so that newer versions of the tree are given a new job, and
+    // grab the data to write.
+    le_mutex_Lock(PersistMutexRef);
+
+    if (treeRef->pendingWritePtr == jobPtr)
+    {
+        treeRef->pendingWritePtr = NULL;
+    }
+
+    char* bufferPtr = jobPtr->bufferPtr;
+    size_t bufferSize = jobPtr->bufferSize;
+
+    jobPtr->bufferPtr = NULL;
+    jobPtr->bufferSize = 0;
 
-    // Go through this registration object's list of update handlers and check to see if they were
-    // registered on the target session.  If so, free them from the list.
-    le_dls_Link_t* linkPtr = le_dls_Peek(&registrationPtr->handlerList);
+    le_mutex_Unlock(PersistMutexRef);
 
-    while (linkPtr != NULL)
+    switch (jobPtr->op)
     {
-        Handler_t* handlerObjectPtr = CONTAINER_OF(linkPtr, Handler_t, link);
-        linkPtr = le_dls_PeekNext(&registrationPtr->handlerList, linkPtr);
+        case PERSIST_WRITE:
+            // The buffer may have been dropped if the tree was deleted in the meantime.
+            if (bufferPtr != NULL)
+            {
+                WriteTreeFile(treeRef, bufferPtr, bufferSize);
+            }
+            break;
 
-        if (handlerObjectPtr->sessionRef == cleanUpContextPtr->sessionRef)
-        {
-            RemoveHandler(registrationPtr, handlerObjectPtr);
-        }
+        case PERSIST_DELETE:
+            DeleteTreeFiles(treeRef);
+            break;
     }
 
-    // Now, check to see if there are any handlers left in this object.  If the registration object
-    // is empty, then queue it for deletion.
-    if (le_dls_IsEmpty(&registrationPtr->handlerList))
+    free(bufferPtr);
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), jobPtr->queueTime);
+
+    LE_DEBUG("** Persisted tree '%s', %zu bytes, %ld.%06ld seconds after the commit.",
+             treeRef->name,
+             bufferSize,
+             (long)elapsed.sec,
+             (long)elapsed.usec);
+
+    le_mutex_Lock(PersistMutexRef);
+
+    if (jobPtr->op == PERSIST_DELETE)
     {
-        registrationPtr->link = LE_SLS_LINK_INIT;
-        le_sls_Queue(&cleanUpContextPtr->deleteQueue, &registrationPtr->link);
+        le_dls_Remove(&PendingDeleteList, &jobPtr->link);
     }
 
-    // We want to continue iterating through the collection.
-    return true;
+    PersistJobCount--;
+    le_mutex_Unlock(PersistMutexRef);
+
+    le_sem_Post(PersistDoneSemRef);
+
+    le_event_QueueFunctionToThread(MainThreadRef, ReleasePersistJob, jobPtr, NULL);
 }
 
 
@@ -2608,21 +4043,36 @@ static bool OnHandlerRegistrationCleanup
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Call this function to delete a tree file from the filesystem.
+ *  Create a new job and queue it to the persistence thread.  Must be called with the
+ *  PersistMutexRef held.
+ *
+ *  @return The newly queued job.
  */
 // -------------------------------------------------------------------------------------------------
-static void DeleteTreeFile
+static PersistJob_t* QueuePersistJob
 (
-    const char* filePathPtr  ///< Path to the tree file in question.
+    PersistOp_t op,         ///< [IN] What to do with the tree's file.
+    tdb_TreeRef_t treeRef,  ///< [IN] The tree to persist.
+    char* bufferPtr,        ///< [IN] Serialized tree for write jobs, ownership is taken by the job.
+    size_t bufferSize       ///< [IN] Size of the serialized tree.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    LE_DEBUG("** Deleting tree file, '%s'.", filePathPtr);
+    PersistJob_t* jobPtr = le_mem_ForceAlloc(PersistJobPoolRef);
 
-    if (unlink(filePathPtr) != 0)
-    {
-        LE_ERROR("File delete failure, '%s', reason '%m'.", filePathPtr);
-    }
+    jobPtr->op = op;
+    jobPtr->link = LE_DLS_LINK_INIT;
+    jobPtr->treeRef = treeRef;
+    jobPtr->bufferPtr = bufferPtr;
+    jobPtr->bufferSize = bufferSize;
+    jobPtr->queueTime = le_clk_GetRelativeTime();
+
+    le_mem_AddRef(treeRef);
+    PersistJobCount++;
+
+    le_event_QueueFunctionToThread(PersistThreadRef, RunPersistJob, jobPtr, NULL);
+
+    return jobPtr;
 }
 
 
@@ -2630,32 +4080,66 @@ static void DeleteTreeFile
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Find the root node represented by the path ref.
- *
- *  If the path is an absolute path, then the base node for the reference is the root node of the
- *  tree in question.
- *
- *  If the path is a relative path, then the base node of the request is the node given.
- *
- *  @return A reference to the base node of the operation.
+ *  Serialize the given live tree into memory and queue it to be written to the filesystem by the
+ *  persistence thread.  If an earlier version of the tree is still waiting to be written, it is
+ *  replaced by this one.
  */
 // -------------------------------------------------------------------------------------------------
-static tdb_NodeRef_t GetPathBaseNodeRef
+static void QueueTreeWrite
 (
-    tdb_NodeRef_t nodeRef,         ///< [IN] The base node to start from.
-    le_pathIter_Ref_t nodePathRef  ///< [IN] The path we're searching for in the tree.
+    tdb_TreeRef_t treeRef  ///< [IN] The tree to persist.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // If the path is absolute and the node we were given is NOT the root node of it's tree, find
-    // the root node of the tree.  Otherwise just return the node reference we were given.
-    if (   (le_pathIter_IsAbsolute(nodePathRef))
-        && (nodeRef->parentRef != NULL))
+    char* bufferPtr = NULL;
+    size_t bufferSize = 0;
+
+    FILE* filePtr = open_memstream(&bufferPtr, &bufferSize);
+
+    if (filePtr == NULL)
     {
-        nodeRef = GetRootParentNode(nodeRef);
+        LE_EMERG("Could not create the buffer for serializing tree '%s' (%m).", treeRef->name);
+        LE_EMERG("Changes have been merged in memory, however they could not be committed to the "
+                 "filesystem!!");
+        return;
     }
 
-    return nodeRef;
+    le_result_t result = InternalWriteNode(treeRef->rootNodeRef, filePtr);
+
+    if (fclose(filePtr) == EOF)
+    {
+        result = LE_IO_ERROR;
+    }
+
+    if (result != LE_OK)
+    {
+        LE_EMERG("Failed to serialize tree '%s'.", treeRef->name);
+        LE_EMERG("Changes have been merged in memory, however they could not be committed to the "
+                 "filesystem!!");
+        free(bufferPtr);
+        return;
+    }
+
+    le_mutex_Lock(PersistMutexRef);
+
+    PersistJob_t* jobPtr = treeRef->pendingWritePtr;
+
+    if (jobPtr != NULL)
+    {
+        // The persistence thread hasn't gotten to the last version yet, so just replace it.
+        free(jobPtr->bufferPtr);
+
+        jobPtr->bufferPtr = bufferPtr;
+        jobPtr->bufferSize = bufferSize;
+
+        LE_DEBUG("** Replaced pending write of tree '%s'.", treeRef->name);
+    }
+    else
+    {
+        treeRef->pendingWritePtr = QueuePersistJob(PERSIST_WRITE, treeRef, bufferPtr, bufferSize);
+    }
+
+    le_mutex_Unlock(PersistMutexRef);
 }
 
 
@@ -2663,52 +4147,51 @@ static tdb_NodeRef_t GetPathBaseNodeRef
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Create a new C style file pointer from the POSIX file descriptor.
- *
- *  @return A file pointer that may be read or written if successful.  A null pointer otherwise.
+ *  Queue the removal of a tree's files to the persistence thread.  Any write of the tree that has
+ *  not been started yet is dropped.
  */
 // -------------------------------------------------------------------------------------------------
-static FILE* OpenFilePtr
+static void QueueTreeDelete
 (
-    int descriptor,   ///< [IN] The POSIX file descriptor to create a file pointer from.
-    const char* mode  ///< [IN] The mode to open the file pointer in.
+    tdb_TreeRef_t treeRef  ///< [IN] The tree being deleted.
 )
 // -------------------------------------------------------------------------------------------------
 {
-    // Duplicate the file descriptor, this is because we later use a C library file pointer for the
-    // parsing routines.  When the file pointer is closed it also closes the underlying descriptor,
-    // which may not be what the caller wants or expects.
-    int newDescriptor = -1;
+    le_mutex_Lock(PersistMutexRef);
 
-    do
-    {
-        newDescriptor = dup(descriptor);
-    }
-    while (   (newDescriptor == -1)
-           && (errno == EINTR));
+    PersistJob_t* jobPtr = treeRef->pendingWritePtr;
 
-    if (newDescriptor == -1)
+    if (jobPtr != NULL)
     {
-        LE_ERROR("Could not duplicate file descriptor, reason: %s", strerror(errno));
-        return NULL;
+        free(jobPtr->bufferPtr);
+
+        jobPtr->bufferPtr = NULL;
+        jobPtr->bufferSize = 0;
+
+        treeRef->pendingWritePtr = NULL;
     }
 
-    // Attempt to open the file pointer from the descriptor.
-    FILE* filePtr = fdopen(newDescriptor, mode);
+    jobPtr = QueuePersistJob(PERSIST_DELETE, treeRef, NULL, 0);
+    le_dls_Queue(&PendingDeleteList, &jobPtr->link);
 
-    if (filePtr == NULL)
-    {
-        // The open failed, so clean up the dangling descriptor.
-        int oldErrno = errno;
+    le_mutex_Unlock(PersistMutexRef);
+}
 
-        close(newDescriptor);
 
-        LE_ERROR("Could not access the input stream for tree import, reason: %s",
-                 strerror(oldErrno));
-    }
 
-    // Return the file pointer we have now.  Note, it may be NULL at this point.
-    return filePtr;
+
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Main function of the persistence thread.
+ */
+// -------------------------------------------------------------------------------------------------
+static void* PersistThreadMain
+(
+    void* contextPtr  ///< [IN] Not used.
+)
+// -------------------------------------------------------------------------------------------------
+{
+    le_event_RunLoop();
 }
 
 
@@ -2716,19 +4199,30 @@ static FILE* OpenFilePtr
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Close the file pointer and flush any data left unwritten.
+ *  Block until all of the tree writes and deletes queued so far have reached the filesystem.
  */
 // -------------------------------------------------------------------------------------------------
-static void CloseFilePtr
+void tdb_FlushPendingWrites
 (
-    FILE* filePtr  ///< The file pointer to close.
+    void
 )
 // -------------------------------------------------------------------------------------------------
 {
-    if (fclose(filePtr) == EOF)
+    if (PersistMutexRef == NULL)
     {
-        LE_ERROR("Could not properly close file, reason: %s", strerror(errno));
+        return;
+    }
+
+    le_mutex_Lock(PersistMutexRef);
+
+    while (PersistJobCount > 0)
+    {
+        le_mutex_Unlock(PersistMutexRef);
+        le_sem_Wait(PersistDoneSemRef);
+        le_mutex_Lock(PersistMutexRef);
     }
+
+    le_mutex_Unlock(PersistMutexRef);
 }
 
 
@@ -2779,6 +4273,16 @@ void tdb_Init
 
     HandlerPool = le_mem_CreatePool(CFG_HANDLER_POOL_NAME, sizeof(Handler_t));
     RegistrationPool = le_mem_CreatePool(CFG_REGISTRATION_POOL_NAME, sizeof(Registration_t));
+    WatchNodePool = le_mem_CreatePool(CFG_WATCH_NODE_POOL_NAME, sizeof(WatchNode_t));
+
+    // Start up the thread that writes committed trees out to the filesystem.
+    PersistJobPoolRef = le_mem_CreatePool(CFG_PERSIST_JOB_POOL_NAME, sizeof(PersistJob_t));
+    PersistMutexRef = le_mutex_CreateNonRecursive("PersistMutex");
+    PersistDoneSemRef = le_sem_Create("PersistDoneSem", 0);
+
+    MainThreadRef = le_thread_GetCurrent();
+    PersistThreadRef = le_thread_Create("CfgPersist", PersistThreadMain, NULL);
+    le_thread_Start(PersistThreadRef);
 
     // Preload the system tree.
     tdb_GetTree("system");
@@ -2843,16 +4347,7 @@ void tdb_DeleteTree
         // kill the tree itself.
         LE_DEBUG("** Deleting configuration tree, '%s'.", treeRef->name);
 
-        for (int id = 1; id <= 3; id++)
-        {
-            if (TreeFileExists(treeRef->name, id))
-            {
-                char filePathPtr[LE_CFG_STR_LEN_BYTES] = "";
-                GetTreePath(treeRef->name, id, filePathPtr, sizeof(filePathPtr));
-
-                DeleteTreeFile(filePathPtr);
-            }
-        }
+        QueueTreeDelete(treeRef);
 
         LE_ASSERT(le_hashmap_Remove(TreeCollectionRef, treeRef->name) == treeRef);
         le_mem_Release(treeRef);
@@ -2973,6 +4468,11 @@ ni_IteratorRef_t tdb_GetActiveWriteIter
         return treeRef->originalTreeRef->activeWriteIterRef;
     }
 
+    if (treeRef->liveTreeRef != NULL)
+    {
+        return treeRef->liveTreeRef->activeWriteIterRef;
+    }
+
     return treeRef->activeWriteIterRef;
 }
 
@@ -2981,7 +4481,8 @@ ni_IteratorRef_t tdb_GetActiveWriteIter
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Call to check for any active read iterator's on the tree.
+ *  Call to check for any active read iterator's on the tree.  Readers that have been moved onto a
+ *  snapshot of the tree are not counted.
  *
  *  @return True if there are active iterators on the tree, False otherwise.
  */
@@ -2996,7 +4497,7 @@ bool tdb_HasActiveReaders
 
     if (treeRef->originalTreeRef != NULL)
     {
-        return treeRef->originalTreeRef->activeReadCount;
+        return treeRef->originalTreeRef->activeReadCount != 0;
     }
 
     return treeRef->activeReadCount != 0;
@@ -3077,6 +4578,13 @@ void tdb_UnregisterIterator
         LE_ASSERT(treeRef->activeReadCount >= 0);
     }
 
+    // Readers on a snapshot keep the count on the snapshot itself, but it's the live tree that
+    // may be waiting on them to go away.
+    if (treeRef->liveTreeRef != NULL)
+    {
+        treeRef = treeRef->liveTreeRef;
+    }
+
     if (treeRef->isDeletePending)
     {
         tdb_DeleteTree(treeRef);
@@ -3106,6 +4614,11 @@ le_sls_List_t* tdb_GetRequestQueue
         return &treeRef->originalTreeRef->requestList;
     }
 
+    if (treeRef->liveTreeRef != NULL)
+    {
+        return &treeRef->liveTreeRef->requestList;
+    }
+
     return &treeRef->requestList;
 }
 
@@ -3114,8 +4627,10 @@ le_sls_List_t* tdb_GetRequestQueue
 
 // -------------------------------------------------------------------------------------------------
 /**
- *  Merge a shadow tree into the original tree it was created from.  Once the change is merged the
- *  updated tree is serialized to the filesystem.
+ *  Merge a shadow tree into the original tree it was created from.  Any readers still on the
+ *  original tree are first moved onto a snapshot of it, so that they continue to see the data as it
+ *  was when they started.  Once the change is merged the updated tree is queued up to be serialized
+ *  to the filesystem.
  */
 // -------------------------------------------------------------------------------------------------
 void tdb_MergeTree
@@ -3124,75 +4639,24 @@ void tdb_MergeTree
 )
 // -------------------------------------------------------------------------------------------------
 {
+    tdb_TreeRef_t originalTreeRef = shadowTreeRef->originalTreeRef;
+
+    MoveReadersToSnapshot(originalTreeRef);
+
     // Get our shadow tree's root node and merge it's changes into the real tree.  Create a path
     // iterator to track the merge and allow for update handlers to be called.
     tdb_NodeRef_t nodeRef = shadowTreeRef->rootNodeRef;
-    le_pathIter_Ref_t pathRef = CreateBasePath(shadowTreeRef->originalTreeRef->name);
+    le_pathIter_Ref_t pathRef = CreateBasePath(originalTreeRef->name);
 
-    InternalMergeTree(shadowTreeRef->originalTreeRef->name, pathRef, nodeRef, false);
+    InternalMergeTree(originalTreeRef, pathRef, nodeRef, false);
     le_pathIter_Delete(pathRef);
 
     // Now, go through and call the triggered callbacks.
     FireTriggeredCallbacks();
 
-    // Now increment revision of the tree and open a tree file for writing.
-    tdb_TreeRef_t originalTreeRef = shadowTreeRef->originalTreeRef;
-    int oldId = originalTreeRef->revisionId;
-
-    IncrementRevision(originalTreeRef);
-
-    char filePath[LE_CFG_STR_LEN_BYTES] = "";
-    GetTreePath(originalTreeRef->name, originalTreeRef->revisionId, filePath, sizeof(filePath));
-
-    LE_DEBUG("Changes merged, now attempting to serialize the tree to '%s'.", filePath);
-
-    int fileRef = -1;
-
-    do
-    {
-        fileRef = open(filePath, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
-    }
-    while (   (fileRef == -1)
-           && (errno == EINTR));
-
-    if ((-1 == fileRef) && (EROFS == errno))
-    {
-        // In case we are R/O for the config tree, we discard the update to flash
-        return;
-    }
-
-    if (fileRef == -1)
-    {
-        LE_EMERG("Failed to open config file '%s' (%m).", filePath);
-        LE_EMERG("Changes have been merged in memory, however they could not be committed to the "
-                 "filesystem!!");
-        return;
-    }
-
-    // We have a tree file to write to, so stream the new tree to it then close the output file.
-    le_result_t writeResult = tdb_WriteTreeNode(originalTreeRef->rootNodeRef, fileRef);
-    int retVal = -1;
-
-    retVal = close(fileRef);
-
-    LE_EMERG_IF(retVal == -1, "An error occurred while closing the tree file: %s", strerror(errno));
-
-    // Finally remove the old version of the tree file, if there is one.
-    if (writeResult == LE_OK)
-    {
-        if (   (oldId != 0)
-            && (TreeFileExists(originalTreeRef->name, oldId)))
-        {
-            GetTreePath(originalTreeRef->name, oldId, filePath, sizeof(filePath));
-            DeleteTreeFile(filePath);
-        }
-    }
-    else
-    {
-        // The write failed, delete the new file we attempted to create.
-        LE_EMERG("The attempt to write to the config tree file, '%s,' failed.", filePath);
-        DeleteTreeFile(filePath);
-    }
+    // Finally hand the new version of the tree off to be written to the filesystem.
+    LE_DEBUG("Changes merged, now queuing tree '%s' to be serialized.", originalTreeRef->name);
+    QueueTreeWrite(originalTreeRef);
 }
 
 
@@ -3215,6 +4679,12 @@ void tdb_ReleaseTree
     {
         le_mem_Release(treeRef);
     }
+    else if (   (treeRef->liveTreeRef != NULL)
+             && (treeRef->activeReadCount == 0))
+    {
+        // The last reader of this snapshot is gone.
+        le_mem_Release(treeRef);
+    }
 
     // TODO: Possibly free regular trees if there are no active iterators on it?
     //       Should timeouts be used for this?
@@ -4235,17 +5705,21 @@ void tdb_SetValueAsFloat
 
 //--------------------------------------------------------------------------------------------------
 /**
- *  Registers a handler function to be called when a node at or below a given path changes.
+ *  Create a handler object for either a plain change handler, or a change set handler, on the given
+ *  path.
  *
  *  @return A new safe ref backed object, or NULL if the creation failed.
  */
 //--------------------------------------------------------------------------------------------------
-le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
+static le_cfg_ChangeHandlerRef_t AddHandler
 (
     tdb_TreeRef_t treeRef,                  ///< [IN] The tree to register the handler on.
     le_msg_SessionRef_t sessionRef,         ///< [IN] The session that the request came in on.
     const char* pathPtr,                    ///< [IN] Path of the node to watch.
-    le_cfg_ChangeHandlerFunc_t handlerPtr,  ///< [IN] Function to call back.
+    le_cfg_ChangeHandlerFunc_t handlerPtr,  ///< [IN] Plain function to call back, or NULL.
+    le_cfg_ChangeSetHandlerFunc_t changeSetHandlerPtr,  ///< [IN] Change set function to call back,
+                                                        ///<      or NULL.
+    uint32_t debounceMs,                    ///< [IN] Debounce time for the change set function.
     void* contextPtr                        ///< [IN] Opaque value to pass to the function when
                                             ///<      called.
 )
@@ -4290,10 +5764,13 @@ le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
     if (foundRegistrationPtr == NULL)
     {
         // Looks like a registration object hasn't been created yet.  So, do so now and add it to
-        // our map.
+        // our map and the watch trie.
         foundRegistrationPtr = le_mem_ForceAlloc(RegistrationPool);
 
         foundRegistrationPtr->triggered = false;
+        foundRegistrationPtr->triggeredLink = LE_SLS_LINK_INIT;
+        ClearChangeSet(&foundRegistrationPtr->changes);
+        foundRegistrationPtr->watchPtr = NULL;
 
         foundRegistrationPtr->handlerList = LE_DLS_LIST_INIT;
         le_utf8_Copy(foundRegistrationPtr->registrationPath,
@@ -4301,6 +5778,12 @@ le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
                      sizeof(foundRegistrationPtr->registrationPath),
                      NULL);
 
+        if (AddWatch(foundRegistrationPtr) != LE_OK)
+        {
+            le_mem_Release(foundRegistrationPtr);
+            return NULL;
+        }
+
         le_hashmap_Put(HandlerRegistrationMap,
                        foundRegistrationPtr->registrationPath,
                        foundRegistrationPtr);
@@ -4313,9 +5796,25 @@ le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
     handlerObjectPtr->sessionRef = sessionRef;
     handlerObjectPtr->handlerPtr = handlerPtr;
     handlerObjectPtr->contextPtr = contextPtr;
+    handlerObjectPtr->changeSetHandlerPtr = changeSetHandlerPtr;
+    handlerObjectPtr->debounceMs = debounceMs;
+    handlerObjectPtr->debounceTimerRef = NULL;
+    handlerObjectPtr->firstChangeTime = (le_clk_Time_t){ 0, 0 };
+    ClearChangeSet(&handlerObjectPtr->pendingChanges);
     handlerObjectPtr->registrationPtr = foundRegistrationPtr;
     handlerObjectPtr->safeRef = le_ref_CreateRef(HandlerSafeRefMap, handlerObjectPtr);
 
+    if (   (changeSetHandlerPtr != NULL)
+        && (debounceMs > 0))
+    {
+        handlerObjectPtr->debounceTimerRef = le_timer_Create("CfgDebounce");
+
+        le_timer_SetMsInterval(handlerObjectPtr->debounceTimerRef,
+                               debounceMs < CFG_MAX_DEBOUNCE_MS ? debounceMs : CFG_MAX_DEBOUNCE_MS);
+        le_timer_SetHandler(handlerObjectPtr->debounceTimerRef, OnDebounceExpiry);
+        le_timer_SetContextPtr(handlerObjectPtr->debounceTimerRef, handlerObjectPtr);
+    }
+
     le_dls_Queue(&foundRegistrationPtr->handlerList, &handlerObjectPtr->link);
 
     return handlerObjectPtr->safeRef;
@@ -4324,6 +5823,66 @@ le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
 
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Registers a handler function to be called when a node at or below a given path changes.
+ *
+ *  @return A new safe ref backed object, or NULL if the creation failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
+(
+    tdb_TreeRef_t treeRef,                  ///< [IN] The tree to register the handler on.
+    le_msg_SessionRef_t sessionRef,         ///< [IN] The session that the request came in on.
+    const char* pathPtr,                    ///< [IN] Path of the node to watch.
+    le_cfg_ChangeHandlerFunc_t handlerPtr,  ///< [IN] Function to call back.
+    void* contextPtr                        ///< [IN] Opaque value to pass to the function when
+                                            ///<      called.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return AddHandler(treeRef, sessionRef, pathPtr, handlerPtr, NULL, 0, contextPtr);
+}
+
+
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Registers a handler function to be called with the set of changed paths when nodes at or below a
+ *  given path change.  If debounceMs is non-zero, changes are held until the path has been left
+ *  alone for that long.
+ *
+ *  The returned reference can be removed with tdb_RemoveChangeHandler().
+ *
+ *  @return A new safe ref backed object, or NULL if the creation failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_ChangeSetHandlerRef_t tdb_AddChangeSetHandler
+(
+    tdb_TreeRef_t treeRef,                     ///< [IN] The tree to register the handler on.
+    le_msg_SessionRef_t sessionRef,            ///< [IN] The session that the request came in on.
+    const char* pathPtr,                       ///< [IN] Path of the node to watch.
+    uint32_t debounceMs,                       ///< [IN] How long the changes must settle before
+                                               ///<      the handler is called.
+    le_cfg_ChangeSetHandlerFunc_t handlerPtr,  ///< [IN] Function to call back.
+    void* contextPtr                           ///< [IN] Opaque value to pass to the function when
+                                               ///<      called.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return (le_cfg_ChangeSetHandlerRef_t)AddHandler(treeRef,
+                                                    sessionRef,
+                                                    pathPtr,
+                                                    NULL,
+                                                    handlerPtr,
+                                                    debounceMs,
+                                                    contextPtr);
+}
+
+
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Deregisters a handler function that was registered using tdb_AddChangeHandler().
@@ -4351,8 +5910,7 @@ void tdb_RemoveChangeHandler
         // If there are no more handlers in this registration object, kill the object.
         if (le_dls_IsEmpty(&registrationPtr->handlerList))
         {
-            le_hashmap_Remove(HandlerRegistrationMap, registrationPtr->registrationPath);
-            le_mem_Release(registrationPtr);
+            ReleaseRegistration(registrationPtr);
         }
     }
 }
@@ -4385,7 +5943,6 @@ void tdb_CleanUpHandlers
     {
         Registration_t* registrationPtr = CONTAINER_OF(linkPtr, Registration_t, link);
 
-        le_hashmap_Remove(HandlerRegistrationMap, registrationPtr->registrationPath);
-        le_mem_Release(registrationPtr);
+        ReleaseRegistration(registrationPtr);
     }
 }
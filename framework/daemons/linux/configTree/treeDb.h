@@ -60,6 +60,22 @@ void tdb_Init
 
 
 
+// -------------------------------------------------------------------------------------------------
+/**
+ *  Block until all of the tree writes and deletes queued so far have reached the filesystem.
+ *
+ *  Committed changes are written out to the filesystem by a background thread, call this before
+ *  shutting down to make sure that no committed changes are lost.
+ */
+// -------------------------------------------------------------------------------------------------
+void tdb_FlushPendingWrites
+(
+    void
+);
+
+
+
+
 // -------------------------------------------------------------------------------------------------
 /**
  *  Get the named tree.
@@ -656,6 +672,32 @@ le_cfg_ChangeHandlerRef_t tdb_AddChangeHandler
 
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ *  Registers a handler function to be called with the set of changed paths when nodes at or below a
+ *  given path change.  If debounceMs is non-zero, changes are held until the path has been left
+ *  alone for that long.
+ *
+ *  The returned reference can be removed with tdb_RemoveChangeHandler().
+ *
+ *  @return A new safe ref backed object, or NULL if the creation failed.
+ */
+//--------------------------------------------------------------------------------------------------
+le_cfg_ChangeSetHandlerRef_t tdb_AddChangeSetHandler
+(
+    tdb_TreeRef_t treeRef,                     ///< [IN] The tree to register the handler on.
+    le_msg_SessionRef_t sessionRef,            ///< [IN] The session that the request came in on.
+    const char* pathPtr,                       ///< [IN] Path of the node to watch.
+    uint32_t debounceMs,                       ///< [IN] How long the changes must settle before
+                                               ///<      the handler is called.
+    le_cfg_ChangeSetHandlerFunc_t handlerPtr,  ///< [IN] Function to call back.
+    void* contextPtr                           ///< [IN] Opaque value to pass to the function when
+                                               ///<      called.
+);
+
+
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  *  Deregisters a handler function that was registered using tdb_AddChangeHandler().
@@ -59,6 +59,13 @@
  * running process that belongs to an IPC session reference when the IPC system reports that
  * a session closed.  This is how the Log Control Daemon finds out that a client process died.
  *
+ * The lists above are used for iteration only.  Component Name, Trace Name, Log Session and Trace
+ * objects are also kept in hash maps keyed by their "path" (e.g., "<pid>/<component>/<keyword>"
+ * for a Trace), so that looking one up doesn't depend on how many siblings it has.
+ *
+ * Setting updates for a running process are queued on that process and sent as a single batch
+ * message once the command from the log control tool (or the registration) has been handled.
+ *
  * Copyright (C) Sierra Wireless Inc.
  */
 
@@ -71,31 +78,79 @@
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum number of processes that we expect to see.  Used to set the hashmap and pool sizes.
- *
- * @todo Make this configurable.
+ * Number of processes that we expect to see at start-up.  Used to set the initial pool sizes.
+ * The pools grow in chunks of this size beyond that.
  **/
 //--------------------------------------------------------------------------------------------------
 #define MAX_EXPECTED_PROCESSES 32
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum number of components that we expect to see.  Used to set the pool sizes.
- *
- * @todo Make this configurable.
+ * Number of components that we expect to see at start-up.  Used to set the initial pool sizes.
+ * The pools grow in chunks of this size beyond that.
  **/
 //--------------------------------------------------------------------------------------------------
 #define MAX_EXPECTED_COMPONENTS 128
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Maximum number of traces that we expect to see.  Used to set the pool sizes.
- *
- * @todo Make this configurable.
+ * Number of traces that we expect to see at start-up.  Used to set the initial pool sizes.
+ * The pools grow in chunks of this size beyond that.
  **/
 //--------------------------------------------------------------------------------------------------
 #define MAX_EXPECTED_TRACES 20
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of processes the hash maps are sized for.  The maps don't resize, so this is the number
+ * of processes that can be tracked before lookups start to slow down.  Can be overridden at
+ * build time.
+ **/
+//--------------------------------------------------------------------------------------------------
+#ifndef LOG_DAEMON_PROCESS_MAP_SIZE
+#define LOG_DAEMON_PROCESS_MAP_SIZE 256
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of component names and log sessions the hash maps are sized for.  Can be overridden at
+ * build time.
+ **/
+//--------------------------------------------------------------------------------------------------
+#ifndef LOG_DAEMON_COMPONENT_MAP_SIZE
+#define LOG_DAEMON_COMPONENT_MAP_SIZE 1024
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of trace names and traces the hash maps are sized for.  Can be overridden at build time.
+ **/
+//--------------------------------------------------------------------------------------------------
+#ifndef LOG_DAEMON_TRACE_MAP_SIZE
+#define LOG_DAEMON_TRACE_MAP_SIZE 256
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the keys of the Component Name Map ("<process name>/<component name>").
+ **/
+//--------------------------------------------------------------------------------------------------
+#define COMPONENT_KEY_BYTES (LIMIT_MAX_PROCESS_NAME_BYTES + LIMIT_MAX_COMPONENT_NAME_BYTES)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the keys of the Log Session Map ("<pid>/<component name>").
+ **/
+//--------------------------------------------------------------------------------------------------
+#define LOG_SESSION_KEY_BYTES (LIMIT_MAX_PROCESS_NAME_BYTES + LIMIT_MAX_COMPONENT_NAME_BYTES)
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the keys of the Trace Name Map and the Trace Map ("<component key>/<keyword>").
+ **/
+//--------------------------------------------------------------------------------------------------
+#define TRACE_KEY_BYTES (COMPONENT_KEY_BYTES + LIMIT_MAX_LOG_KEYWORD_BYTES)
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -127,19 +182,68 @@ static le_hashmap_Ref_t IpcSessionMapRef;
 static le_hashmap_Ref_t ProcessIdMapRef;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash map of Component Name objects, keyed by "<process name>/<component name>".
+ *
+ * Value pointer points to a ComponentName_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t ComponentNameMapRef;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash map of Trace Name objects, keyed by "<process name>/<component name>/<keyword>".
+ *
+ * Value pointer points to a TraceName_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t TraceNameMapRef;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash map of Log Session objects, keyed by "<pid>/<component name>".
+ *
+ * Value pointer points to a LogSession_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t LogSessionMapRef;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Hash map of Trace objects, keyed by "<pid>/<component name>/<keyword>".
+ *
+ * Value pointer points to a Trace_t.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t TraceMapRef;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * List of Running Process objects that have setting updates waiting to be sent to them.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_dls_List_t PendingUpdateList = LE_DLS_LIST_INIT;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Component Name objects are used to store the log level setting associated with a component
  * name for all processes sharing the same process name.
  *
- * Each of these objects is kept on a Process Name object's Component Name List.  They are
- * keyed by component name.
+ * Each of these objects is kept on a Process Name object's Component Name List and in the
+ * Component Name Map.
  */
 //--------------------------------------------------------------------------------------------------
 typedef struct
 {
     le_dls_Link_t       link;                   ///< Link in the Process Name's component name list.
     char name[LIMIT_MAX_COMPONENT_NAME_BYTES];  ///< The component name.
+    char key[COMPONENT_KEY_BYTES];              ///< Key in the Component Name Map.
     le_log_Level_t      level;                  ///< The log level setting.
     le_dls_List_t       enabledTracesList;      ///< List of enabled trace keywords.
 }
@@ -182,9 +286,8 @@ static le_mem_PoolRef_t ProcessNamePoolRef;
  * Trace Name objects are used to hold trace keywords that have been enabled for all processes
  * that share the same process name.
  *
- * These objects are each kept on a single Component Name object's list of enabled traces.
- *
- * They are keyed by trace keyword string.
+ * These objects are each kept on a single Component Name object's list of enabled traces and in
+ * the Trace Name Map.
  *
  * If a keyword is disabled, it is deleted, so only enabled trace names appear in the list.
  **/
@@ -193,6 +296,7 @@ typedef struct
 {
     le_dls_Link_t   link;          ///< Used to link into Component Name's list of enabled keywords.
     char            name[LIMIT_MAX_LOG_KEYWORD_BYTES];   ///< The keyword.
+    char            key[TRACE_KEY_BYTES];                ///< Key in the Trace Name Map.
 }
 TraceName_t;
 
@@ -223,6 +327,9 @@ typedef struct
     pid_t               pid;            ///< The process ID.
     le_msg_SessionRef_t ipcSessionRef;  ///< Reference to the IPC session connected to this process.
     le_dls_List_t       logSessionList; ///< List of log sessions in this process.
+    le_msg_MessageRef_t updateMsgRef;   ///< Batch of setting updates not yet sent (or NULL).
+    size_t              updateBytes;    ///< Length of the batch in updateMsgRef.
+    le_dls_Link_t       pendingLink;    ///< Link in the Pending Update List.
 /* TODO: Implement shared memory.
     void*               sharedMemAddr;  ///< Address of base of memory region shared with
                                         ///  this process.
@@ -243,13 +350,14 @@ static le_mem_PoolRef_t RunningProcessPoolRef;
 /**
  * Log Session objects are used to store the log session details for a single, active log session
  * in a running process.  Each of these objects is kept on a Running Process object's
- * Log Session List.  They are keyed by component name.
+ * Log Session List and in the Log Session Map.
  */
 //--------------------------------------------------------------------------------------------------
 typedef struct
 {
     le_dls_Link_t       link;               ///< Link in the Running Process's log session list.
     char componentName[LIMIT_MAX_COMPONENT_NAME_BYTES];  ///< The component name.
+    char key[LOG_SESSION_KEY_BYTES];        ///< Key in the Log Session Map.
     le_log_Level_t      level;              ///< This session's log level.
     le_dls_List_t       traceList;          ///< List of Trace objects for this log session.
 }
@@ -269,15 +377,14 @@ static le_mem_PoolRef_t LogSessionPoolRef;
  * Trace objects are used to hold trace keywords and their associated information for
  * active log sessions.
  *
- * These objects are each kept on a Log Session object's list of traces.
- *
- * They are keyed by trace keyword string.
+ * These objects are each kept on a Log Session object's list of traces and in the Trace Map.
  **/
 //--------------------------------------------------------------------------------------------------
 typedef struct
 {
     le_dls_Link_t   link;           ///< Used to link into the Running Process's trace flag list.
     char            name[LIMIT_MAX_LOG_KEYWORD_BYTES];   ///< The keyword.
+    char            key[TRACE_KEY_BYTES];                ///< Key in the Trace Map.
     bool            isEnabled;      ///< true = the keyword is enabled.
 }
 Trace_t;
@@ -434,6 +541,52 @@ static const char* GetLevelString
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds a hash map key of the form "<prefix>/<name>".
+ *
+ * @return
+ *      true if the key fit in the buffer.
+ *      false if it didn't, in which case no object can have that key.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool MakeKey
+(
+    char* keyBuffPtr,           ///< [OUT] Buffer to store the key in.
+    size_t keyBuffSize,         ///< [IN] Size of the buffer.
+    const char* prefixStr,      ///< [IN] Key of the parent object (or a process name).
+    const char* nameStr         ///< [IN] Name of the object.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    int len = snprintf(keyBuffPtr, keyBuffSize, "%s/%s", prefixStr, nameStr);
+
+    return ((len >= 0) && ((size_t)len < keyBuffSize));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds a Log Session Map key of the form "<pid>/<component name>".
+ *
+ * @return
+ *      true if the key fit in the buffer.
+ *      false if it didn't, in which case no object can have that key.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool MakeLogSessionKey
+(
+    char* keyBuffPtr,           ///< [OUT] Buffer to store the key in (LOG_SESSION_KEY_BYTES).
+    pid_t pid,                  ///< [IN] Process ID of the running process.
+    const char* componentNameStr///< [IN] Component name.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return (snprintf(keyBuffPtr, LOG_SESSION_KEY_BYTES, "%d/%s", pid, componentNameStr)
+            < LOG_SESSION_KEY_BYTES);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Find a Process Name object for a given process name.
@@ -476,9 +629,11 @@ static void DeleteAllComponentNamesForProcessName
         {
             TraceName_t* traceNameObjPtr = CONTAINER_OF(traceNameLinkPtr, TraceName_t, link);
 
+            le_hashmap_Remove(TraceNameMapRef, traceNameObjPtr->key);
             le_mem_Release(traceNameObjPtr);
         }
 
+        le_hashmap_Remove(ComponentNameMapRef, compNameObjPtr->key);
         le_mem_Release(compNameObjPtr);
     }
 }
@@ -519,23 +674,14 @@ static ComponentName_t* FindComponentName
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // Search for the component in the list.
-    le_dls_Link_t* linkPtr = le_dls_Peek(&procNameObjPtr->componentNameList);
+    char key[COMPONENT_KEY_BYTES];
 
-    while (linkPtr != NULL)
+    if (!MakeKey(key, sizeof(key), procNameObjPtr->name, componentNameStr))
     {
-        ComponentName_t* compPtr = CONTAINER_OF(linkPtr, ComponentName_t, link);
-
-        if (strcmp(compPtr->name, componentNameStr) == 0)
-        {
-            return compPtr;
-        }
-
-        // Get the next component.
-        linkPtr = le_dls_PeekNext(&procNameObjPtr->componentNameList, linkPtr);
+        return NULL;
     }
 
-    return NULL;
+    return le_hashmap_Get(ComponentNameMapRef, key);
 }
 
 
@@ -564,6 +710,9 @@ static ComponentName_t* CreateComponentName
     objPtr->level = -1;
     objPtr->enabledTracesList = LE_DLS_LIST_INIT;
 
+    LE_ASSERT(MakeKey(objPtr->key, sizeof(objPtr->key), procNameObjPtr->name, objPtr->name));
+    le_hashmap_Put(ComponentNameMapRef, objPtr->key, objPtr);
+
     objPtr->link = LE_DLS_LINK_INIT;
     le_dls_Queue(&procNameObjPtr->componentNameList, &objPtr->link);
 
@@ -593,6 +742,9 @@ static TraceName_t* CreateTraceName
         LE_WARN("Trace keyword '%s' truncated to '%s'.", keywordStr, objPtr->name);
     }
 
+    LE_ASSERT(MakeKey(objPtr->key, sizeof(objPtr->key), compNameObjPtr->key, objPtr->name));
+    le_hashmap_Put(TraceNameMapRef, objPtr->key, objPtr);
+
     objPtr->link = LE_DLS_LINK_INIT;
 
     le_dls_Stack(&compNameObjPtr->enabledTracesList, &objPtr->link);
@@ -647,23 +799,14 @@ static TraceName_t* FindTraceName
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // Search for the keyword in the list.
-    le_dls_Link_t* linkPtr = le_dls_Peek(&compNameObjPtr->enabledTracesList);
+    char key[TRACE_KEY_BYTES];
 
-    while (linkPtr != NULL)
+    if (!MakeKey(key, sizeof(key), compNameObjPtr->key, traceNameStr))
     {
-        TraceName_t* tracePtr = CONTAINER_OF(linkPtr, TraceName_t, link);
-
-        if (strcmp(tracePtr->name, traceNameStr) == 0)
-        {
-            return tracePtr;
-        }
-
-        // Get the next component.
-        linkPtr = le_dls_PeekNext(&compNameObjPtr->enabledTracesList, linkPtr);
+        return NULL;
     }
 
-    return NULL;
+    return le_hashmap_Get(TraceNameMapRef, key);
 }
 
 
@@ -724,7 +867,10 @@ static RunningProcess_t* CreateRunningProcess
     RunningProcess_t* objPtr = le_mem_ForceAlloc(RunningProcessPoolRef);
 
     objPtr->logSessionList = LE_DLS_LIST_INIT;
+    objPtr->updateMsgRef = NULL;
+    objPtr->pendingLink = LE_DLS_LINK_INIT;
 
+    objPtr->link = LE_DLS_LINK_INIT;
     le_dls_Queue(&procNameObjPtr->runningProcessesList, &objPtr->link);
     objPtr->procNameObjPtr = procNameObjPtr;
 
@@ -755,23 +901,14 @@ static LogSession_t* FindLogSession
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // Search for the keyword in the list.
-    le_dls_Link_t* linkPtr = le_dls_Peek(&procPtr->logSessionList);
+    char key[LOG_SESSION_KEY_BYTES];
 
-    while (linkPtr != NULL)
+    if (!MakeLogSessionKey(key, procPtr->pid, componentNameStr))
     {
-        LogSession_t* sessionPtr = CONTAINER_OF(linkPtr, LogSession_t, link);
-
-        if (strcmp(sessionPtr->componentName, componentNameStr) == 0)
-        {
-            return sessionPtr;
-        }
-
-        // Get the next component.
-        linkPtr = le_dls_PeekNext(&procPtr->logSessionList, linkPtr);
+        return NULL;
     }
 
-    return NULL;
+    return le_hashmap_Get(LogSessionMapRef, key);
 }
 
 
@@ -805,6 +942,9 @@ static LogSession_t* CreateLogSession
     objPtr->traceList = LE_DLS_LIST_INIT;
     // TODO: implement shared memory.
 
+    LE_ASSERT(MakeLogSessionKey(objPtr->key, runningProcPtr->pid, objPtr->componentName));
+    le_hashmap_Put(LogSessionMapRef, objPtr->key, objPtr);
+
     objPtr->link = LE_DLS_LINK_INIT;
     le_dls_Queue(&runningProcPtr->logSessionList, &objPtr->link);
 
@@ -828,22 +968,14 @@ static Trace_t* FindTrace
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // Search for the keyword in the list.
-    le_dls_Link_t* linkPtr = le_dls_Peek(&logSessionPtr->traceList);
+    char key[TRACE_KEY_BYTES];
 
-    while (linkPtr != NULL)
+    if (!MakeKey(key, sizeof(key), logSessionPtr->key, keywordStr))
     {
-        Trace_t* traceObjPtr = CONTAINER_OF(linkPtr, Trace_t, link);
-
-        if (strcmp(traceObjPtr->name, keywordStr) == 0)
-        {
-            return traceObjPtr;
-        }
-
-        linkPtr = le_dls_PeekNext(&logSessionPtr->traceList, linkPtr);
+        return NULL;
     }
 
-    return NULL;
+    return le_hashmap_Get(TraceMapRef, key);
 }
 
 
@@ -877,6 +1009,9 @@ static Trace_t* CreateTrace
     objPtr->isEnabled = true;
     // TODO: implement shared memory.
 
+    LE_ASSERT(MakeKey(objPtr->key, sizeof(objPtr->key), logSessionPtr->key, objPtr->name));
+    le_hashmap_Put(TraceMapRef, objPtr->key, objPtr);
+
     le_dls_Stack(&logSessionPtr->traceList, &objPtr->link);
 
     return objPtr;
@@ -1099,101 +1234,146 @@ static void SendToLogTool
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Sends a client an update to its log session settings.
+ * Sends a client the batch of setting updates that has been queued for it, if any.
  **/
 //--------------------------------------------------------------------------------------------------
-static void UpdateClientSessionSettings
+static void SendClientUpdates
 (
-    RunningProcess_t* runningProcObjPtr,
-    LogSession_t* logSessionPtr
+    RunningProcess_t* runningProcObjPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    le_msg_MessageRef_t msgRef;
-    char* payloadPtr;
-    size_t maxSize;
-    size_t byteCount;
-
-    // First send the level update, if it's not -1 (default).
-    if (logSessionPtr->level != (le_log_Level_t)-1)
+    if (runningProcObjPtr->updateMsgRef != NULL)
     {
-        msgRef = le_msg_CreateMsg(runningProcObjPtr->ipcSessionRef);
-        payloadPtr = le_msg_GetPayloadPtr(msgRef);
-        maxSize = le_msg_GetMaxPayloadSize(msgRef);
-
-        byteCount = snprintf(payloadPtr,
-                             maxSize,
-                             "%c%s/%s",
-                             LOG_CMD_SET_LEVEL,
-                             logSessionPtr->componentName,
-                             GetLevelString(logSessionPtr->level));
+        le_msg_Send(runningProcObjPtr->updateMsgRef);
+        runningProcObjPtr->updateMsgRef = NULL;
 
-        if (byteCount >= maxSize)
-        {
-            LE_CRIT("Message too long (%zu bytes) to send to component '%s' in process '%s' (pid %d).",
-                    byteCount,
-                    logSessionPtr->componentName,
-                    runningProcObjPtr->procNameObjPtr->name,
-                    runningProcObjPtr->pid);
-            le_msg_ReleaseMsg(msgRef);
-        }
-        else
-        {
-            le_msg_Send(msgRef);
-        }
+        le_dls_Remove(&PendingUpdateList, &runningProcObjPtr->pendingLink);
     }
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Sends a client an update to one of its trace settings.
+ * Sends all the clients the setting updates that have been queued for them.  Must be called once
+ * the handling of a command or registration is finished.
  **/
 //--------------------------------------------------------------------------------------------------
-static void UpdateClientTraceSetting
+static void SendAllClientUpdates
 (
-    RunningProcess_t* runningProcObjPtr,
-    LogSession_t* logSessionPtr,
-    Trace_t* traceObjPtr
+    void
 )
 //--------------------------------------------------------------------------------------------------
 {
-    // First send the level update.
-    le_msg_MessageRef_t msgRef = le_msg_CreateMsg(runningProcObjPtr->ipcSessionRef);
-    char* payloadPtr = le_msg_GetPayloadPtr(msgRef);
-    size_t maxSize = le_msg_GetMaxPayloadSize(msgRef);
-
-    char commandChar;
+    le_dls_Link_t* linkPtr;
 
-    if (traceObjPtr->isEnabled)
+    while ((linkPtr = le_dls_Peek(&PendingUpdateList)) != NULL)
     {
-        commandChar = LOG_CMD_ENABLE_TRACE;
-    }
-    else
-    {
-        commandChar = LOG_CMD_DISABLE_TRACE;
+        SendClientUpdates(CONTAINER_OF(linkPtr, RunningProcess_t, pendingLink));
     }
+}
 
-    size_t byteCount = snprintf(payloadPtr,
-                                maxSize,
-                                "%c%s/%s",
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues a log command to be sent to a client.  Commands for the same client are batched so that
+ * a single message is sent to each client process per command from the log control tool.
+ **/
+//--------------------------------------------------------------------------------------------------
+static void QueueClientUpdate
+(
+    RunningProcess_t* runningProcObjPtr,
+    char commandChar,
+    const char* componentName,
+    const char* commandData
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char packet[LOG_MAX_CMD_PACKET_BYTES];
+
+    size_t byteCount = snprintf(packet,
+                                sizeof(packet),
+                                "%c%s/%s\n",
                                 commandChar,
-                                logSessionPtr->componentName,
-                                traceObjPtr->name);
+                                componentName,
+                                commandData);
 
-    if (byteCount >= maxSize)
+    // There must be room for the batch command character and the null terminator as well.
+    if (byteCount + 2 > sizeof(packet))
     {
         LE_CRIT("Message too long (%zu bytes) to send to component '%s' in process '%s' (pid %d).",
                 byteCount,
-                logSessionPtr->componentName,
+                componentName,
                 runningProcObjPtr->procNameObjPtr->name,
                 runningProcObjPtr->pid);
-        le_msg_ReleaseMsg(msgRef);
+        return;
     }
-    else
+
+    // If this doesn't fit in the batch that's already queued, send that batch first.
+    if (   (runningProcObjPtr->updateMsgRef != NULL)
+        && (  runningProcObjPtr->updateBytes + byteCount + 1
+            > le_msg_GetMaxPayloadSize(runningProcObjPtr->updateMsgRef)) )
     {
-        le_msg_Send(msgRef);
+        SendClientUpdates(runningProcObjPtr);
+    }
+
+    if (runningProcObjPtr->updateMsgRef == NULL)
+    {
+        runningProcObjPtr->updateMsgRef = le_msg_CreateMsg(runningProcObjPtr->ipcSessionRef);
+
+        char* payloadPtr = le_msg_GetPayloadPtr(runningProcObjPtr->updateMsgRef);
+        payloadPtr[0] = LOG_CMD_BATCH;
+        runningProcObjPtr->updateBytes = 1;
+
+        le_dls_Queue(&PendingUpdateList, &runningProcObjPtr->pendingLink);
     }
+
+    char* payloadPtr = le_msg_GetPayloadPtr(runningProcObjPtr->updateMsgRef);
+    memcpy(payloadPtr + runningProcObjPtr->updateBytes, packet, byteCount + 1);
+    runningProcObjPtr->updateBytes += byteCount;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues an update to a client's log session settings.
+ **/
+//--------------------------------------------------------------------------------------------------
+static void UpdateClientSessionSettings
+(
+    RunningProcess_t* runningProcObjPtr,
+    LogSession_t* logSessionPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Only send the level update if it's not -1 (default).
+    if (logSessionPtr->level != (le_log_Level_t)-1)
+    {
+        QueueClientUpdate(runningProcObjPtr,
+                          LOG_CMD_SET_LEVEL,
+                          logSessionPtr->componentName,
+                          GetLevelString(logSessionPtr->level));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues an update to one of a client's trace settings.
+ **/
+//--------------------------------------------------------------------------------------------------
+static void UpdateClientTraceSetting
+(
+    RunningProcess_t* runningProcObjPtr,
+    LogSession_t* logSessionPtr,
+    Trace_t* traceObjPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    QueueClientUpdate(runningProcObjPtr,
+                      traceObjPtr->isEnabled ? LOG_CMD_ENABLE_TRACE : LOG_CMD_DISABLE_TRACE,
+                      logSessionPtr->componentName,
+                      traceObjPtr->name);
 }
 
 
@@ -1492,12 +1672,24 @@ static void ClientIpcSessionClosed
         // Delete all the traces for this log session.
         while ((linkPtr = le_dls_Pop(&logSessionPtr->traceList)) != NULL)
         {
-            le_mem_Release(CONTAINER_OF(linkPtr, Trace_t, link));
+            Trace_t* traceObjPtr = CONTAINER_OF(linkPtr, Trace_t, link);
+
+            le_hashmap_Remove(TraceMapRef, traceObjPtr->key);
+            le_mem_Release(traceObjPtr);
         }
 
+        le_hashmap_Remove(LogSessionMapRef, logSessionPtr->key);
         le_mem_Release(logSessionPtr);
     }
 
+    // Drop any updates that were waiting to be sent to the process.
+    if (runningProcObjPtr->updateMsgRef != NULL)
+    {
+        le_msg_ReleaseMsg(runningProcObjPtr->updateMsgRef);
+        runningProcObjPtr->updateMsgRef = NULL;
+        le_dls_Remove(&PendingUpdateList, &runningProcObjPtr->pendingLink);
+    }
+
     // Remove the process from the list of processes with this name.
     le_dls_Remove(&procNameObjPtr->runningProcessesList,
                   &runningProcObjPtr->link);
@@ -1900,6 +2092,7 @@ static void SetTraceForComponentName
         if (!isEnabled)
         {
             le_dls_Remove(&compNameObjPtr->enabledTracesList, &traceNameObjPtr->link);
+            le_hashmap_Remove(TraceNameMapRef, traceNameObjPtr->key);
             le_mem_Release(traceNameObjPtr);
         }
     }
@@ -2487,6 +2680,9 @@ static void ClientMsgReceiveHandler
             case LOG_CMD_REG_COMPONENT:
 
                 RegComponent(processName, componentName, commandDataPtr, ipcSessionRef);
+
+                // The settings must reach the client before the response does.
+                SendAllClientUpdates();
                 le_msg_Respond(msgRef);
 
                 return;
@@ -2496,6 +2692,7 @@ static void ClientMsgReceiveHandler
             case LOG_CMD_DISABLE_TRACE:
             case LOG_CMD_LIST_COMPONENTS:
             case LOG_CMD_FORGET_PROCESS:
+            case LOG_CMD_BATCH:
 
                 LE_ERROR("Client attempted to issue a log control command (%c)!", command);
 
@@ -2590,6 +2787,9 @@ static void ControlToolMsgReceiveHandler
 
                 break;
         }
+
+        // Send each affected client all of its updates in a single message.
+        SendAllClientUpdates();
     }
 
     le_msg_CloseSession(le_msg_GetSession(msgRef));
@@ -2803,7 +3003,6 @@ COMPONENT_INIT
     FdLogPoolRef = le_mem_CreatePool("FdLogs", sizeof(FdLog_t));
 
     // Tune the pools' initial sizes to reduce warnings in the log at start-up.
-    // TODO: Make this configurable.
     le_mem_ExpandPool(ProcessNamePoolRef, MAX_EXPECTED_PROCESSES);
     le_mem_ExpandPool(ComponentNamePoolRef, MAX_EXPECTED_COMPONENTS);
     le_mem_ExpandPool(TraceNamePoolRef, MAX_EXPECTED_TRACES);
@@ -2812,19 +3011,45 @@ COMPONENT_INIT
     le_mem_ExpandPool(TracePoolRef, MAX_EXPECTED_TRACES);
     le_mem_ExpandPool(FdLogPoolRef, MAX_EXPECTED_PROCESSES * 2); // Generally 2 fds per process (stderr, stdout).
 
+    // With many apps installed the pools will grow past that, so grow them in chunks rather than
+    // one block at a time.
+    le_mem_SetNumObjsToForce(ProcessNamePoolRef, MAX_EXPECTED_PROCESSES);
+    le_mem_SetNumObjsToForce(ComponentNamePoolRef, MAX_EXPECTED_COMPONENTS);
+    le_mem_SetNumObjsToForce(TraceNamePoolRef, MAX_EXPECTED_TRACES);
+    le_mem_SetNumObjsToForce(RunningProcessPoolRef, MAX_EXPECTED_PROCESSES);
+    le_mem_SetNumObjsToForce(LogSessionPoolRef, MAX_EXPECTED_COMPONENTS);
+    le_mem_SetNumObjsToForce(TracePoolRef, MAX_EXPECTED_TRACES);
+    le_mem_SetNumObjsToForce(FdLogPoolRef, MAX_EXPECTED_PROCESSES * 2);
+
     // Create the hash maps.
     ProcessNameMapRef = le_hashmap_Create("ProcessName",
-                                          MAX_EXPECTED_PROCESSES,
+                                          LOG_DAEMON_PROCESS_MAP_SIZE,
                                           le_hashmap_HashString,
                                           le_hashmap_EqualsString);
     IpcSessionMapRef  = le_hashmap_Create("IPCSession",
-                                          MAX_EXPECTED_PROCESSES,
+                                          LOG_DAEMON_PROCESS_MAP_SIZE,
                                           IpcSessionHash,
                                           IpcSessionEquals);
     ProcessIdMapRef   = le_hashmap_Create("ProcessID",
-                                          MAX_EXPECTED_PROCESSES,
+                                          LOG_DAEMON_PROCESS_MAP_SIZE,
                                           ProcessIdHash,
                                           ProcessIdEquals);
+    ComponentNameMapRef = le_hashmap_Create("ComponentName",
+                                            LOG_DAEMON_COMPONENT_MAP_SIZE,
+                                            le_hashmap_HashString,
+                                            le_hashmap_EqualsString);
+    TraceNameMapRef   = le_hashmap_Create("TraceName",
+                                          LOG_DAEMON_TRACE_MAP_SIZE,
+                                          le_hashmap_HashString,
+                                          le_hashmap_EqualsString);
+    LogSessionMapRef  = le_hashmap_Create("LogSession",
+                                          LOG_DAEMON_COMPONENT_MAP_SIZE,
+                                          le_hashmap_HashString,
+                                          le_hashmap_EqualsString);
+    TraceMapRef       = le_hashmap_Create("Trace",
+                                          LOG_DAEMON_TRACE_MAP_SIZE,
+                                          le_hashmap_HashString,
+                                          le_hashmap_EqualsString);
 
     // Get a reference to the Log Control Protocol identification.
     le_msg_ProtocolRef_t protocolRef = le_msg_GetProtocolRef(LOG_CONTROL_PROTOCOL_ID,
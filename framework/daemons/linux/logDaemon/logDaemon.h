@@ -96,6 +96,18 @@
 #define LOG_CMD_REG_COMPONENT           'r' // CommandData = string containing the process ID.
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Logging commands that can be sent from the log daemon to the components only.
+ *
+ * A batch is the command character followed by one or more SET_LEVEL, ENABLE_TRACE or
+ * DISABLE_TRACE packets (Command ComponentName '/' CommandData), each terminated by a '\n'.
+ * The log daemon uses it to send all the setting changes for a process in a single message.
+ */
+//--------------------------------------------------------------------------------------------------
+#define LOG_CMD_BATCH                   'b' // No ProcessName
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Logging commands that can be sent from the log tool to the log daemon only.
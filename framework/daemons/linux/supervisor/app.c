@@ -27,6 +27,12 @@
  * So, instead when a directory is required or bundled, all files in the directory are individually
  * linked.
  *
+ * Apart from the default links, the links for an app are taken from the app's sandbox plan (see
+ * sandboxPlan.h), which is saved with the app's installed files and kept in memory while the app's
+ * hash is unchanged, so that starting an unchanged app does not walk its config again.  Executing
+ * a plan only touches the file system, so the areas of several apps can be set up in parallel on
+ * worker threads (see app_QueueAreaSetup() and app_SetupQueuedAreas()).
+ *
  * The working area is not cleaned up by the Supervisor, rather it is left to the installer to
  * clean up.
  *
@@ -61,6 +67,7 @@
 #include "file.h"
 #include "ima.h"
 #include "kernelModules.h"
+#include "sandboxPlan.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -351,6 +358,7 @@ typedef struct app_Ref
     le_sls_List_t   additionalLinks;    // List of additional links that are temporarily added to
                                         // the app.
     le_sls_List_t reqModuleName;        // List of required kernel module names
+    bool            isAreaReady;        // true if the app's area was set up ahead of the start.
 }
 App_t;
 
@@ -384,6 +392,58 @@ FileLinkNode_t;
 static le_mem_PoolRef_t FileLinkNodePool;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sandbox plans of apps that have been started, keyed by app name.  A plan is reused until the
+ * app's hash changes.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_hashmap_Ref_t LinkPlanMap;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A request to set up an app's working area ahead of starting the app.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    app_Ref_t appRef;                   ///< App to set up.
+    sandboxPlan_Ref_t planRef;          ///< App's sandbox plan.
+    le_result_t result;                 ///< Result of the setup.
+    long elapsedMs;                     ///< Time taken by the setup, in milliseconds.
+    le_sls_Link_t link;                 ///< Link in the queue or the done list.
+}
+AreaSetupJob_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The memory pool for area setup jobs.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t AreaSetupJobPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Area setup jobs waiting for a worker, and jobs completed by the workers.  Both lists are
+ * protected by AreaSetupMutex while the workers are running.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_sls_List_t AreaSetupQueue = LE_SLS_LIST_INIT;
+static le_sls_List_t AreaSetupDoneList = LE_SLS_LIST_INIT;
+static le_mutex_Ref_t AreaSetupMutex;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of worker threads used to set up app areas in parallel.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_AREA_SETUP_THREADS                          8
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Prototype for process stopped handler.
@@ -1665,7 +1725,8 @@ static le_result_t RecursivelyCreateLinks
         }
     }
 
-    // Open the directory tree to search.
+    // Open the directory tree to search.  Several sandboxes are set up at once, so fts must not
+    // change the process's working directory.
     char* pathArrayPtr[] = {(char*)srcDirPtr, NULL};
 
     FTS* ftsPtr = NULL;
@@ -1675,11 +1736,11 @@ static le_result_t RecursivelyCreateLinks
     {
         if (appRef->sandboxed)
         {
-            ftsPtr = fts_open(pathArrayPtr, FTS_LOGICAL | FTS_NOSTAT, NULL);
+            ftsPtr = fts_open(pathArrayPtr, FTS_LOGICAL | FTS_NOSTAT | FTS_NOCHDIR, NULL);
         }
         else
         {
-            ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL | FTS_NOSTAT, NULL);
+            ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL | FTS_NOSTAT | FTS_NOCHDIR, NULL);
         }
     }
     while ( (ftsPtr == NULL) && (errno == EINTR) );
@@ -1829,141 +1890,113 @@ static le_result_t CreateDefaultLinks
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Create links to the app's lib and bin files.
+ * Gets the sandbox plan for an app.  Plans are kept in memory once they have been loaded or built
+ * (see sandboxPlan.h) so that restarts of the same version of the app do not need to read the plan
+ * or the app's configuration again.
+ *
+ * Must be called from the Supervisor's main thread because it uses the config API.
  *
  * @return
- *      LE_OK if successful.
- *      LE_FAULT if there was an error.
+ *      A reference to the plan, which the caller must release when done with it.
+ *      NULL if there was an error.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t CreateLibBinLinks
+static sandboxPlan_Ref_t GetLinkPlan
 (
-    app_Ref_t appRef,                   ///< [IN] Application reference.
-    const char* appDirLabelPtr          ///< [IN] SMACK label to use for created directories.
+    app_Ref_t appRef                    ///< [IN] Application reference.
 )
 {
-    // Create links to the apps lib directory.
-    char srcLib[LIMIT_MAX_PATH_BYTES] = "";
+    char hash[LIMIT_MD5_STR_BYTES];
+    bool isHashed = (sandboxPlan_GetAppHash(appRef->name, hash, sizeof(hash)) == LE_OK);
 
-    if (le_path_Concat("/", srcLib, sizeof(srcLib), appRef->installDirPath, "read-only/lib", NULL)
-          != LE_OK)
-    {
-        LE_ERROR("App's install dir path too long!");
-        return LE_FAULT;
-    }
+    sandboxPlan_Ref_t planRef = le_hashmap_Get(LinkPlanMap, appRef->name);
 
-    if (RecursivelyCreateLinks(appRef, appDirLabelPtr, srcLib, "/lib") != LE_OK)
+    if (planRef != NULL)
     {
-        return LE_FAULT;
+        if (isHashed && (strcmp(sandboxPlan_GetHash(planRef), hash) == 0))
+        {
+            sandboxPlan_AddRef(planRef);
+            return planRef;
+        }
+
+        // The app has changed since the plan was built.
+        le_hashmap_Remove(LinkPlanMap, appRef->name);
+        sandboxPlan_Release(planRef);
     }
 
-    // Create links to the apps bin directory.
-    char srcBin[LIMIT_MAX_PATH_BYTES] = "";
+    planRef = sandboxPlan_Get(appRef->name);
 
-    if (le_path_Concat("/", srcBin, sizeof(srcBin), appRef->installDirPath, "read-only/bin", NULL)
-          != LE_OK)
+    if (planRef == NULL)
     {
-        LE_ERROR("App's install dir path too long!");
-        return LE_FAULT;
+        return NULL;
     }
 
-    if (RecursivelyCreateLinks(appRef, appDirLabelPtr, srcBin, "/bin") != LE_OK)
+    // Only keep plans that can be validated against the app's hash later.
+    if (isHashed && (strcmp(sandboxPlan_GetHash(planRef), hash) == 0))
     {
-        return LE_FAULT;
+        sandboxPlan_AddRef(planRef);
+        le_hashmap_Put(LinkPlanMap, sandboxPlan_GetAppName(planRef), planRef);
     }
 
-    return LE_OK;
+    return planRef;
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the source path for read only bundled files at the current node in the config iterator.
+ * Creates all the links in an app's sandbox plan.
+ *
+ * This does not use the config API so it may be called from any thread.
  *
  * @return
  *      LE_OK if successful.
  *      LE_FAULT if there was an error.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t GetBundledReadOnlySrcPath
+static le_result_t ExecuteLinkPlan
 (
-    app_Ref_t appRef,                   ///< [IN] Reference to the application object.
-    le_cfg_IteratorRef_t cfgIter,       ///< [IN] Config iterator.
-    char* bufPtr,                       ///< [OUT] Buffer to store the source path.
-    size_t bufSize                      ///< [IN] Size of the buffer.
+    app_Ref_t appRef,                   ///< [IN] Application reference.
+    const char* appDirLabelPtr,         ///< [IN] SMACK label to use for created directories.
+    sandboxPlan_Ref_t planRef           ///< [IN] Plan to execute.
 )
 {
-    char srcPath[LIMIT_MAX_PATH_BYTES] = "";
-
-    if (le_cfg_GetString(cfgIter, "src", srcPath, sizeof(srcPath), "") != LE_OK)
-    {
-        LE_ERROR("Source file path '%s...' for app '%s' is too long.", srcPath, app_GetName(appRef));
-        return LE_FAULT;
-    }
+    const sandboxPlan_Link_t* linkPtr = sandboxPlan_GetFirstLink(planRef);
 
-    if (strlen(srcPath) == 0)
+    while (linkPtr != NULL)
     {
-        LE_ERROR("Empty source file path supplied for app %s.", app_GetName(appRef));
-        return LE_FAULT;
-    }
+        le_result_t result = LE_FAULT;
 
-    if (srcPath[0] == '/')
-    {
-        // The source path is an absolute path so just copy it to the user's buffer.
-        if (le_utf8_Copy(bufPtr, srcPath, bufSize, NULL) != LE_OK)
+        switch (linkPtr->type)
         {
-            LE_ERROR("Source file path '%s...' for app '%s' is too long.", srcPath, app_GetName(appRef));
-            return LE_FAULT;
+            case SANDBOXPLAN_FILE:
+                result = CreateFileLink(appRef, appDirLabelPtr, linkPtr->src, linkPtr->dest);
+                break;
+
+            case SANDBOXPLAN_DIR:
+                result = CreateDirLink(appRef, appDirLabelPtr, linkPtr->src, linkPtr->dest);
+                break;
+
+            case SANDBOXPLAN_SHARED_DIR:
+                result = CreateDirLink(appRef, appDirLabelPtr, linkPtr->src, linkPtr->dest);
+
+                if (result == LE_OK)
+                {
+                    result = smack_SetLabel(linkPtr->src, "*");
+                }
+                break;
+
+            case SANDBOXPLAN_TREE:
+                result = RecursivelyCreateLinks(appRef, appDirLabelPtr,
+                                                linkPtr->src, linkPtr->dest);
+                break;
         }
-    }
-    else
-    {
-        // The source file path is relative to the app install directory.
-        bufPtr[0] = '\0';
-        if (LE_OK != le_path_Concat("/",
-                                    bufPtr,
-                                    bufSize,
-                                    appRef->installDirPath,
-                                    "read-only",
-                                    srcPath,
-                                    NULL) )
+
+        if (result != LE_OK)
         {
-            LE_ERROR("Import source path '%s' for app '%s' is too long.", bufPtr, app_GetName(appRef));
             return LE_FAULT;
         }
-    }
 
-    return LE_OK;
-}
-
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Get the destination path for the app at the current node in the config iterator.
- *
- * @return
- *      LE_OK if successful.
- *      LE_FAULT if there was an error.
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t GetDestPath
-(
-    app_Ref_t appRef,                   ///< [IN] Reference to the application object.
-    le_cfg_IteratorRef_t cfgIter,       ///< [IN] Config iterator.
-    char* bufPtr,                       ///< [OUT] Buffer to store the path.
-    size_t bufSize                      ///< [IN] Size of the buffer.
-)
-{
-    if (le_cfg_GetString(cfgIter, "dest", bufPtr, bufSize, "") != LE_OK)
-    {
-        LE_ERROR("Destination path '%s...' for app '%s' is too long.", bufPtr, appRef->name);
-        return LE_FAULT;
-    }
-
-    if (bufPtr[0] == '\0')
-    {
-        LE_ERROR("Empty dest path supplied for app %s.", appRef->name);
-        return LE_FAULT;
+        linkPtr = sandboxPlan_GetNextLink(planRef, linkPtr);
     }
 
     return LE_OK;
@@ -1972,181 +2005,75 @@ static le_result_t GetDestPath
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Get the source path for the app at the current node in the config iterator.
+ * Sets up the application execution area in the file system.  For a sandboxed app this will be the
+ * sandbox, including its /tmp.  For an unsandboxed app this will be the app's current working
+ * directory.
+ *
+ * This does not use the config API so it may be called from any thread.
  *
  * @return
  *      LE_OK if successful.
  *      LE_FAULT if there was an error.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t GetSrcPath
+static le_result_t SetupAppArea
 (
-    app_Ref_t appRef,                   ///< [IN] Reference to the application object.
-    le_cfg_IteratorRef_t cfgIter,       ///< [IN] Config iterator.
-    char* bufPtr,                       ///< [OUT] Buffer to store the path.
-    size_t bufSize                      ///< [IN] Size of the buffer.
+    app_Ref_t appRef,                   ///< [IN] The application reference.
+    sandboxPlan_Ref_t planRef           ///< [IN] The app's sandbox plan.
 )
 {
-    if (le_cfg_GetString(cfgIter, "src", bufPtr, bufSize, "") != LE_OK)
-    {
-        LE_ERROR("Source path '%s...' for app '%s' is too long.", bufPtr, appRef->name);
-        return LE_FAULT;
-    }
+    // Get the SMACK label for the folders we create.
+    char appDirLabel[LIMIT_MAX_SMACK_LABEL_BYTES];
+    smack_GetAppAccessLabel(app_GetName(appRef), S_IRWXU, appDirLabel, sizeof(appDirLabel));
 
-    if (bufPtr[0] == '\0')
+    // Create the appsWritable/<appName> directory if it does not already exist.
+    if (dir_MakeSmack(appRef->workingDir,
+                      S_IRUSR | S_IXUSR | S_IROTH | S_IWOTH | S_IXOTH,
+                      appDirLabel) == LE_FAULT)
     {
-        LE_ERROR("Empty src path supplied for app %s.", appRef->name);
         return LE_FAULT;
     }
 
-    return LE_OK;
-}
-
-
-//--------------------------------------------------------------------------------------------------
-/**
- * Create links to the app's read only bundled files.
- *
- * @return
- *      LE_OK if successful.
- *      LE_FAULT if there was an error.
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t CreateBundledLinks
-(
-    app_Ref_t appRef,                   ///< [IN] Application reference.
-    const char* appDirLabelPtr          ///< [IN] SMACK label to use for created directories.
-)
-{
-    // Get a config iterator for this app.
-    le_cfg_IteratorRef_t appCfg = le_cfg_CreateReadTxn(appRef->cfgPathRoot);
-
-    // Go to the bundled directories section.
-    le_cfg_GoToNode(appCfg, CFG_NODE_BUNDLES);
-    le_cfg_GoToNode(appCfg, CFG_NODE_DIRS);
-
-    if (le_cfg_GoToFirstChild(appCfg) == LE_OK)
+    if (appRef->sandboxed)
     {
-        do
+        if (!fs_IsMountPoint(appRef->workingDir))
         {
-            // Only handle read only directories.
-            if (!le_cfg_GetBool(appCfg, "isWritable", false))
+            // Bind mount the root of the sandbox unto itself so that we just lazy umount this when we
+            // need to clean up.
+            if (mount(appRef->workingDir, appRef->workingDir, NULL, MS_BIND, NULL) != 0)
             {
-                // Get source path.
-                char srcPath[LIMIT_MAX_PATH_BYTES];
-                if (GetBundledReadOnlySrcPath(appRef, appCfg, srcPath, sizeof(srcPath)) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-
-                // Get destination path.
-                char destPath[LIMIT_MAX_PATH_BYTES];
-                if (GetDestPath(appRef, appCfg, destPath, sizeof(destPath)) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-
-                // Create links for all files in the source directory.
-                if (RecursivelyCreateLinks(appRef, appDirLabelPtr, srcPath, destPath) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
+                LE_ERROR("Couldn't bind mount '%s' unto itself. %m", appRef->workingDir);
+                return LE_FAULT;
             }
         }
-        while (le_cfg_GoToNextSibling(appCfg) == LE_OK);
-
-        le_cfg_GoToParent(appCfg);
-    }
 
-    // Go to the requires files section.
-    le_cfg_GoToParent(appCfg);
-    le_cfg_GoToNode(appCfg, CFG_NODE_FILES);
-
-    if (le_cfg_GoToFirstChild(appCfg) == LE_OK)
-    {
-        do
+        // Create default links.
+        if (CreateDefaultLinks(appRef, appDirLabel) != LE_OK)
         {
-            // Only handle read only files.
-            if (!le_cfg_GetBool(appCfg, "isWritable", false))
-            {
-                // Get source path.
-                char srcPath[LIMIT_MAX_PATH_BYTES];
-                if (GetBundledReadOnlySrcPath(appRef, appCfg, srcPath, sizeof(srcPath)) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-
-                // Get destination path.
-                char destPath[LIMIT_MAX_PATH_BYTES];
-                if (GetDestPath(appRef, appCfg, destPath, sizeof(destPath)) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-
-                if (CreateFileLink(appRef, appDirLabelPtr, srcPath, destPath) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-            }
+            return LE_FAULT;
         }
-        while (le_cfg_GoToNextSibling(appCfg) == LE_OK);
     }
 
-    le_cfg_CancelTxn(appCfg);
-
-    return LE_OK;
-}
-
+    // Create the lib, bin, bundled and required links.
+    if (ExecuteLinkPlan(appRef, appDirLabel, planRef) != LE_OK)
+    {
+        return LE_FAULT;
+    }
 
-//--------------------------------------------------------------------------------------------------
-/**
- * Create links to the app's required files under the current node in the configuration iterator.
- *
- * @return
- *      LE_OK if successful.
- *      LE_FAULT if there was an error.
- */
-//--------------------------------------------------------------------------------------------------
-static le_result_t CreateRequiredFileLinks
-(
-    app_Ref_t appRef,                   ///< [IN] Application reference.
-    const char* appDirLabelPtr,         ///< [IN] SMACK label to use for created directories.
-    le_cfg_IteratorRef_t cfgIter        ///< [IN] Config iterator.
-)
-{
-    if (le_cfg_GoToFirstChild(cfgIter) == LE_OK)
+    // Create /tmp for sandboxed apps and link in /tmp files.
+    if (appRef->sandboxed)
     {
-        do
+        // Create the app's /tmp for sandboxed apps.
+        if (CreateTmpFs(appRef, appDirLabel) != LE_OK)
         {
-            // Get source path.
-            char srcPath[LIMIT_MAX_PATH_BYTES];
-
-            if (GetSrcPath(appRef, cfgIter, srcPath, sizeof(srcPath)) != LE_OK)
-            {
-                return LE_FAULT;
-            }
-
-            // Get destination path.
-            char destPath[LIMIT_MAX_PATH_BYTES];
-            if (GetDestPath(appRef, cfgIter, destPath, sizeof(destPath)) != LE_OK)
-            {
-                return LE_FAULT;
-            }
-
-            if (CreateFileLink(appRef, appDirLabelPtr, srcPath, destPath) != LE_OK)
-            {
-                return LE_FAULT;
-            }
+            return LE_FAULT;
         }
-        while (le_cfg_GoToNextSibling(cfgIter) == LE_OK);
 
-        le_cfg_GoToParent(cfgIter);
+        // Create default links.
+        if (CreateDefaultTmpLinks(appRef, appDirLabel) != LE_OK)
+        {
+            return LE_FAULT;
+        }
     }
 
     return LE_OK;
@@ -2155,180 +2082,55 @@ static le_result_t CreateRequiredFileLinks
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Create links to the app's required directories, files and devices.
+ * Gets the number of milliseconds elapsed since a given relative time.
  *
  * @return
- *      LE_OK if successful.
- *      LE_FAULT if there was an error.
+ *      Elapsed time in milliseconds.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t CreateRequiredLinks
+static long GetElapsedMs
 (
-    app_Ref_t appRef,                   ///< [IN] Application reference.
-    const char* appDirLabelPtr          ///< [IN] SMACK label to use for created directories.
+    le_clk_Time_t startTime             ///< [IN] Relative time to measure from.
 )
 {
-    // Get a config iterator for this app.
-    le_cfg_IteratorRef_t appCfg = le_cfg_CreateReadTxn(appRef->cfgPathRoot);
-
-    // Go to the required directories section.
-    le_cfg_GoToNode(appCfg, CFG_NODE_REQUIRES);
-    le_cfg_GoToNode(appCfg, CFG_NODE_DIRS);
-
-    if (le_cfg_GoToFirstChild(appCfg) == LE_OK)
-    {
-        do
-        {
-            // Get source path.
-            char srcPath[LIMIT_MAX_PATH_BYTES];
-
-            if (GetSrcPath(appRef, appCfg, srcPath, sizeof(srcPath)) != LE_OK)
-            {
-                le_cfg_CancelTxn(appCfg);
-                return LE_FAULT;
-            }
-
-            // Get destination path.
-            char destPath[LIMIT_MAX_PATH_BYTES];
-            if (GetDestPath(appRef, appCfg, destPath, sizeof(destPath)) != LE_OK)
-            {
-                le_cfg_CancelTxn(appCfg);
-                return LE_FAULT;
-            }
-
-            // Treat /proc and /sys differently.  These are kernel file systems that user space
-            // processes cannot write create files in.  So it is safe to create a link to the
-            // entire directory.
-            if ( le_path_IsEquivalent("/proc", srcPath, "/") ||
-                 le_path_IsEquivalent("/sys", srcPath, "/") ||
-                 le_path_IsSubpath("/proc", srcPath, "/") ||
-                 le_path_IsSubpath("/sys", srcPath, "/") )
-            {
-                if (CreateDirLink(appRef, appDirLabelPtr, srcPath, destPath) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-            }
-            // Treat /dev/shm differently.  These are shared memory expected to be shared between
-            // other apps but also other userland processes.  So export the entire directory.
-            else if (le_path_IsEquivalent("/dev/shm", srcPath, "/") ||
-                     le_path_IsSubpath("/dev/shm", srcPath, "/"))
-            {
-                if ((CreateDirLink(appRef, appDirLabelPtr, srcPath, destPath) != LE_OK) ||
-                    (smack_SetLabel(srcPath, "*") != LE_OK))
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-
-            }
-            else
-            {
-                // Create links for all files in the source directory.
-                if (RecursivelyCreateLinks(appRef, appDirLabelPtr, srcPath, destPath) != LE_OK)
-                {
-                    le_cfg_CancelTxn(appCfg);
-                    return LE_FAULT;
-                }
-            }
-        }
-        while (le_cfg_GoToNextSibling(appCfg) == LE_OK);
-
-        le_cfg_GoToParent(appCfg);
-    }
-
-    // Go to the requires files section
-    le_cfg_GoToParent(appCfg);
-    le_cfg_GoToNode(appCfg, CFG_NODE_FILES);
-
-    if (CreateRequiredFileLinks(appRef, appDirLabelPtr, appCfg) != LE_OK)
-    {
-        le_cfg_CancelTxn(appCfg);
-        return LE_FAULT;
-    }
-
-    // Go to the devices section.
-    le_cfg_GoToParent(appCfg);
-    le_cfg_GoToNode(appCfg, CFG_NODE_DEVICES);
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
 
-    if (CreateRequiredFileLinks(appRef, appDirLabelPtr, appCfg) != LE_OK)
-    {
-        le_cfg_CancelTxn(appCfg);
-        return LE_FAULT;
-    }
-
-    le_cfg_CancelTxn(appCfg);
-    return LE_OK;
+    return (long)(elapsed.sec * 1000 + elapsed.usec / 1000);
 }
 
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Sets up the application execution area in the file system.  For a sandboxed app this will be the
- * sandbox.  For an unsandboxed app this will be the app's current working directory..
- *
- * @return
- *      LE_OK if successful.
- *      LE_FAULT if there was an error.
+ * Sandbox preparation worker thread.  Takes jobs off the queue until it is empty.
  */
 //--------------------------------------------------------------------------------------------------
-static le_result_t SetupAppArea
+static void* AreaSetupWorker
 (
-    app_Ref_t appRef                    ///< [IN] The application reference.
+    void* contextPtr                    ///< [IN] Not used.
 )
 {
-    // Get the SMACK label for the folders we create.
-    char appDirLabel[LIMIT_MAX_SMACK_LABEL_BYTES];
-    smack_GetAppAccessLabel(app_GetName(appRef), S_IRWXU, appDirLabel, sizeof(appDirLabel));
-
-    // Create the appsWritable/<appName> directory if it does not already exist.
-    if (dir_MakeSmack(appRef->workingDir,
-                      S_IRUSR | S_IXUSR | S_IROTH | S_IWOTH | S_IXOTH,
-                      appDirLabel) == LE_FAULT)
+    while (true)
     {
-        return LE_FAULT;
-    }
+        le_mutex_Lock(AreaSetupMutex);
+        le_sls_Link_t* linkPtr = le_sls_Pop(&AreaSetupQueue);
+        le_mutex_Unlock(AreaSetupMutex);
 
-    if (appRef->sandboxed)
-    {
-        if (!fs_IsMountPoint(appRef->workingDir))
+        if (linkPtr == NULL)
         {
-            // Bind mount the root of the sandbox unto itself so that we just lazy umount this when we
-            // need to clean up.
-            if (mount(appRef->workingDir, appRef->workingDir, NULL, MS_BIND, NULL) != 0)
-            {
-                LE_ERROR("Couldn't bind mount '%s' unto itself. %m", appRef->workingDir);
-                return LE_FAULT;
-            }
+            return NULL;
         }
 
-        // Create default links.
-        if (CreateDefaultLinks(appRef, appDirLabel) != LE_OK)
-        {
-            return LE_FAULT;
-        }
-    }
+        AreaSetupJob_t* jobPtr = CONTAINER_OF(linkPtr, AreaSetupJob_t, link);
 
-    // Create links to the app's lib and bin directories.
-    if (CreateLibBinLinks(appRef, appDirLabel) != LE_OK)
-    {
-        return LE_FAULT;
-    }
+        le_clk_Time_t startTime = le_clk_GetRelativeTime();
 
-    // Create links to bundled files.
-    if (CreateBundledLinks(appRef, appDirLabel) != LE_OK)
-    {
-        return LE_FAULT;
-    }
+        jobPtr->result = SetupAppArea(jobPtr->appRef, jobPtr->planRef);
+        jobPtr->elapsedMs = GetElapsedMs(startTime);
 
-    // Create links to required files.
-    if (CreateRequiredLinks(appRef, appDirLabel) != LE_OK)
-    {
-        return LE_FAULT;
+        le_mutex_Lock(AreaSetupMutex);
+        le_sls_Queue(&AreaSetupDoneList, &(jobPtr->link));
+        le_mutex_Unlock(AreaSetupMutex);
     }
-
-    return LE_OK;
 }
 
 
@@ -2578,6 +2380,12 @@ void app_Init
     ProcContainerPool = le_mem_CreatePool("ProcContainers", sizeof(ProcContainer_t));
     ReqModStringPool = le_mem_CreatePool("Required Modules", sizeof(ModNameNode_t));
 
+    sandboxPlan_Init();
+    LinkPlanMap = le_hashmap_Create("LinkPlans", 31, le_hashmap_HashString, le_hashmap_EqualsString);
+
+    AreaSetupJobPool = le_mem_CreatePool("AreaSetupJobs", sizeof(AreaSetupJob_t));
+    AreaSetupMutex = le_mutex_CreateNonRecursive("AreaSetup");
+
     proc_Init();
 
     // Create the appsWriteable area.
@@ -2731,6 +2539,7 @@ app_Ref_t app_Create
     appPtr->state = APP_STATE_STOPPED;
     appPtr->killTimer = NULL;
     appPtr->reqModuleName = LE_SLS_LIST_INIT;
+    appPtr->isAreaReady = false;
 
     LE_INFO("Creating app '%s'", appPtr->name);
 
@@ -2904,6 +2713,17 @@ void app_Delete
         le_timer_Delete(appRef->killTimer);
     }
 
+    // Drop the cached sandbox plan if the app has been uninstalled.
+    if (access(appRef->installDirPath, F_OK) != 0)
+    {
+        sandboxPlan_Ref_t planRef = le_hashmap_Remove(LinkPlanMap, appRef->name);
+
+        if (planRef != NULL)
+        {
+            sandboxPlan_Release(planRef);
+        }
+    }
+
     // Release app.
     le_mem_Release(appRef);
 }
@@ -2941,40 +2761,56 @@ le_result_t app_Start
 
     appRef->state = APP_STATE_RUNNING;
 
+    // The area may have been set up ahead of time by app_SetupQueuedAreas().
+    bool isAreaReady = appRef->isAreaReady;
+    appRef->isAreaReady = false;
+
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+    le_clk_Time_t phaseTime = startTime;
+
     if (GetKernelModules(appRef) != LE_OK)
     {
         LE_CRIT("Error in installing dependent kernel modules for app '%s'", appRef->name);
     }
 
+    long modulesMs = GetElapsedMs(phaseTime);
+    phaseTime = le_clk_GetRelativeTime();
+
     // Set SMACK rules for this app.
-    // Setup the runtime area in the file system.
-    if ( (SetSmackRules(appRef) != LE_OK) ||
-         (SetupAppArea(appRef) != LE_OK) )
+    if (SetSmackRules(appRef) != LE_OK)
     {
         LE_ERROR("Failed to set Smack rules or set up app area.");
         return LE_FAULT;
     }
 
-    // Create /tmp for sandboxed apps and link in /tmp files.
-    if (appRef->sandboxed)
+    long smackMs = GetElapsedMs(phaseTime);
+    phaseTime = le_clk_GetRelativeTime();
+
+    // Setup the runtime area in the file system.
+    if (!isAreaReady)
     {
-        // Get the SMACK label for the folders we create.
-        char appDirLabel[LIMIT_MAX_SMACK_LABEL_BYTES];
-        smack_GetAppAccessLabel(app_GetName(appRef), S_IRWXU, appDirLabel, sizeof(appDirLabel));
+        sandboxPlan_Ref_t planRef = GetLinkPlan(appRef);
 
-        // Create the app's /tmp for sandboxed apps.
-        if (CreateTmpFs(appRef, appDirLabel) != LE_OK)
+        if (planRef == NULL)
         {
+            LE_ERROR("Failed to set Smack rules or set up app area.");
             return LE_FAULT;
         }
 
-        // Create default links.
-        if (CreateDefaultTmpLinks(appRef, appDirLabel) != LE_OK)
+        le_result_t result = SetupAppArea(appRef, planRef);
+
+        sandboxPlan_Release(planRef);
+
+        if (result != LE_OK)
         {
+            LE_ERROR("Failed to set Smack rules or set up app area.");
             return LE_FAULT;
         }
     }
 
+    long areaMs = GetElapsedMs(phaseTime);
+    phaseTime = le_clk_GetRelativeTime();
+
     // Start all the processes in the application.
     le_dls_Link_t* procLinkPtr = le_dls_Peek(&(appRef->procs));
 
@@ -2998,10 +2834,149 @@ le_result_t app_Start
         procLinkPtr = le_dls_PeekNext(&(appRef->procs), procLinkPtr);
     }
 
+    LE_INFO("App '%s' started in %ld ms (modules %ld ms, smack %ld ms, area %ld ms%s, procs %ld ms).",
+            appRef->name,
+            GetElapsedMs(startTime),
+            modulesMs,
+            smackMs,
+            areaMs,
+            isAreaReady ? " (prepared ahead)" : "",
+            GetElapsedMs(phaseTime));
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues an app to have its working area set up by the next call to app_SetupQueuedAreas().  The
+ * app's sandbox plan is resolved here, so this must be called from the Supervisor's main thread.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.  The area will be set up when the app is started instead.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t app_QueueAreaSetup
+(
+    app_Ref_t appRef                    ///< [IN] Reference to the application.
+)
+{
+    if ((appRef->state == APP_STATE_RUNNING) || appRef->isAreaReady)
+    {
+        return LE_OK;
+    }
+
+    sandboxPlan_Ref_t planRef = GetLinkPlan(appRef);
+
+    if (planRef == NULL)
+    {
+        return LE_FAULT;
+    }
+
+    AreaSetupJob_t* jobPtr = le_mem_ForceAlloc(AreaSetupJobPool);
+
+    jobPtr->appRef = appRef;
+    jobPtr->planRef = planRef;
+    jobPtr->result = LE_FAULT;
+    jobPtr->elapsedMs = 0;
+    jobPtr->link = LE_SLS_LINK_INIT;
+
+    le_sls_Queue(&AreaSetupQueue, &(jobPtr->link));
+
     return LE_OK;
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets up the working areas of all apps queued by app_QueueAreaSetup(), using up to one worker
+ * thread per CPU.  Apps whose areas are set up successfully skip that phase when they are next
+ * started.  Returns when all the queued areas have been processed.
+ */
+//--------------------------------------------------------------------------------------------------
+void app_SetupQueuedAreas
+(
+    void
+)
+{
+    size_t numJobs = le_sls_NumLinks(&AreaSetupQueue);
+
+    if (numJobs == 0)
+    {
+        return;
+    }
+
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t numThreads = (numCpus > 0) ? (size_t)numCpus : 1;
+
+    if (numThreads > MAX_AREA_SETUP_THREADS)
+    {
+        numThreads = MAX_AREA_SETUP_THREADS;
+    }
+
+    if (numThreads > numJobs)
+    {
+        numThreads = numJobs;
+    }
+
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+    if (numThreads == 1)
+    {
+        // Not worth a thread.
+        AreaSetupWorker(NULL);
+    }
+    else
+    {
+        le_thread_Ref_t threads[MAX_AREA_SETUP_THREADS];
+        size_t i;
+
+        for (i = 0; i < numThreads; i++)
+        {
+            char threadName[LIMIT_MAX_THREAD_NAME_BYTES];
+            snprintf(threadName, sizeof(threadName), "AreaSetup%zu", i);
+
+            threads[i] = le_thread_Create(threadName, AreaSetupWorker, NULL);
+            le_thread_SetJoinable(threads[i]);
+            le_thread_Start(threads[i]);
+        }
+
+        for (i = 0; i < numThreads; i++)
+        {
+            le_thread_Join(threads[i], NULL);
+        }
+    }
+
+    // The workers are done so the done list is no longer shared.
+    le_sls_Link_t* linkPtr;
+
+    while ((linkPtr = le_sls_Pop(&AreaSetupDoneList)) != NULL)
+    {
+        AreaSetupJob_t* jobPtr = CONTAINER_OF(linkPtr, AreaSetupJob_t, link);
+
+        if (jobPtr->result == LE_OK)
+        {
+            LE_INFO("Set up area for app '%s' (%zu links) in %ld ms.",
+                    jobPtr->appRef->name, sandboxPlan_GetNumLinks(jobPtr->planRef), jobPtr->elapsedMs);
+
+            jobPtr->appRef->isAreaReady = true;
+        }
+        else
+        {
+            LE_WARN("Failed to set up area for app '%s' ahead of time.  Retrying at app start.",
+                    jobPtr->appRef->name);
+        }
+
+        sandboxPlan_Release(jobPtr->planRef);
+        le_mem_Release(jobPtr);
+    }
+
+    LE_INFO("Set up %zu app areas on %zu threads in %ld ms.",
+            numJobs, numThreads, GetElapsedMs(startTime));
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Stops an application.  This is an asynchronous function call that returns immediately but
@@ -171,6 +171,35 @@ le_result_t app_Start
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queues an app to have its working area set up by the next call to app_SetupQueuedAreas().  The
+ * app's sandbox plan is resolved here, so this must be called from the Supervisor's main thread.
+ *
+ * @return
+ *      LE_OK if successful.
+ *      LE_FAULT if there was an error.  The area will be set up when the app is started instead.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t app_QueueAreaSetup
+(
+    app_Ref_t appRef                    ///< [IN] Reference to the application.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets up the working areas of all apps queued by app_QueueAreaSetup(), using up to one worker
+ * thread per CPU.  Apps whose areas are set up successfully skip that phase when they are next
+ * started.  Returns when all the queued areas have been processed.
+ */
+//--------------------------------------------------------------------------------------------------
+void app_SetupQueuedAreas
+(
+    void
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Stops an application.  This is an asynchronous function call that returns immediately but
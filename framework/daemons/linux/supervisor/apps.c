@@ -100,6 +100,18 @@
 #define CFG_NODE_START_MANUAL               "startManual"
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * The path in the config tree to the value that selects parallel app start.
+ *
+ * When true, the working areas (sandboxes) of all auto-start apps are set up concurrently on
+ * worker threads before the apps' processes are started one after another.  When false or missing
+ * each app's area is set up as part of starting the app.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_PARALLEL_APP_START              "/parallelAppStart"
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * The name of the node in the config tree that states whether the application is sandboxed or not
@@ -1326,12 +1338,12 @@ void apps_SetShutdownHandler
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Start all applications marked as 'auto' start.
+ * Calls a function for every application marked as 'auto' start.
  */
 //--------------------------------------------------------------------------------------------------
-void apps_AutoStart
+static void ForEachAutoStartApp
 (
-    void
+    void (*funcPtr)(const char* appNamePtr)     ///< [IN] Function to call with each app's name.
 )
 {
     // Read the list of applications from the config tree.
@@ -1362,9 +1374,7 @@ void apps_AutoStart
             }
             else
             {
-                // Launch the application now.  No need to check the return code because there is
-                // nothing we can do about errors.
-                LaunchApp(appName);
+                funcPtr(appName);
             }
         }
     }
@@ -1374,6 +1384,70 @@ void apps_AutoStart
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates an auto-start app and queues it to have its working area set up in parallel with the
+ * other auto-start apps.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueAutoStartApp
+(
+    const char* appNamePtr      ///< [IN] Name of the application.
+)
+{
+    AppContainer_t* appContainerPtr;
+
+    // No need to report errors here, they will be reported again when the app is launched.
+    if ( (CreateApp(appNamePtr, &appContainerPtr) == LE_OK) && !appContainerPtr->isActive )
+    {
+        app_QueueAreaSetup(appContainerPtr->appRef);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Launches an auto-start app.
+ */
+//--------------------------------------------------------------------------------------------------
+static void LaunchAutoStartApp
+(
+    const char* appNamePtr      ///< [IN] Name of the application.
+)
+{
+    // Launch the application now.  No need to check the return code because there is nothing we
+    // can do about errors.
+    LaunchApp(appNamePtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start all applications marked as 'auto' start.
+ */
+//--------------------------------------------------------------------------------------------------
+void apps_AutoStart
+(
+    void
+)
+{
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+    if (le_cfg_QuickGetBool(CFG_PARALLEL_APP_START, false))
+    {
+        ForEachAutoStartApp(QueueAutoStartApp);
+
+        app_SetupQueuedAreas();
+    }
+
+    ForEachAutoStartApp(LaunchAutoStartApp);
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    LE_INFO("Auto-start of apps took %ld ms.", (long)(elapsed.sec * 1000 + elapsed.usec / 1000));
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * The SIGCHLD handler for the applications.  This should be called from the Supervisor's SIGCHILD
@@ -40,6 +40,8 @@
 #include "sysPaths.h"
 #include "fileSystem.h"
 #include "ima.h"
+#include "sandboxPlan.h"
+#include "dedup.h"
 
 
 static const char* InstallHookScriptPath = "/legato/systems/current/bin/install-hook";
@@ -54,6 +56,78 @@ static const char* PreInstallPath = "/legato/apps/%s/read-only/script/pre-instal
 static const char* PostInstallPath = "/legato/apps/%s/read-only/script/post-install";
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of worker threads used to install the apps of a system update in parallel.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_INSTALL_THREADS     4
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Kinds of per-app install steps that can be run by the install workers.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    JOB_MOVE_UNPACKED,      ///< Move an unpacked app into /legato/apps/<hash> and label its files.
+    JOB_INSTALL_WRITEABLES  ///< Install an app's writeable files in the unpack system.
+}
+InstallJobType_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A per-app install step queued for the install workers.
+ *
+ * Only steps that work on the app's own files can be queued.  Anything that talks to other
+ * processes (e.g., the Config Tree) must be done by the main thread before queuing the step.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    InstallJobType_t type;                  ///< What to do.
+    char appMd5[LIMIT_MD5_STR_BYTES];       ///< Hash of the app.
+    char appName[LIMIT_MAX_APP_NAME_BYTES]; ///< Name of the app.
+    char unpackPath[LIMIT_MAX_PATH_BYTES];  ///< Where the app was unpacked (JOB_MOVE_UNPACKED).
+    bool hasRun;                            ///< true if a worker ran the step.
+    le_result_t result;                     ///< Result of the step.
+    long elapsedMs;                         ///< Time taken by the step, in milliseconds.
+    le_sls_Link_t link;                     ///< Link in the queue or the done list.
+}
+InstallJob_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * The memory pool for install jobs.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t InstallJobPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Install jobs waiting for a worker, and jobs completed by the workers.  Both lists, and
+ * InstallJobFailed, are protected by InstallJobMutex while the workers are running.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_sls_List_t InstallJobQueue = LE_SLS_LIST_INIT;
+static le_sls_List_t InstallJobDoneList = LE_SLS_LIST_INIT;
+static bool InstallJobFailed = false;
+static le_mutex_Ref_t InstallJobMutex;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Whether IMA is enabled, checked by the main thread before starting the install workers because
+ * ima_IsEnabled() runs a shell.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool InstallImaEnabled = false;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Import an applications configuration into the system config tree, allowing the supervisor to be
@@ -88,6 +162,16 @@ static void ImportConfig
     else
     {
         le_cfg_CommitTxn(iterRef);
+
+        // Save the app's sandbox plan now so that the Supervisor doesn't have to build it from the
+        // config when the app is first started.
+        sandboxPlan_Ref_t planRef = sandboxPlan_Build(appNamePtr, appMd5Ptr);
+
+        if (planRef != NULL)
+        {
+            sandboxPlan_Save(planRef);
+            sandboxPlan_Release(planRef);
+        }
     }
 }
 
@@ -212,7 +296,9 @@ static void ExecPostinstallHook
 static le_result_t SetSmackPermReadOnlyDir
 (
     const char* appMd5Ptr,  ///< [IN] Hash ID of the application to install.
-    const char* appNamePtr  ///< [IN] Name of the application to install.
+    const char* appNamePtr, ///< [IN] Name of the application to install.
+    bool isImaEnabled       ///< [IN] Result of ima_IsEnabled().  Checked once per app, not per
+                            ///       file, because it runs a shell.
 )
 {
     char fileLabel[LIMIT_MAX_SMACK_LABEL_BYTES];
@@ -276,7 +362,7 @@ static le_result_t SetSmackPermReadOnlyDir
 
             case FTS_F:
                 // These are files. Set the SMACK label.
-                if (ima_IsEnabled())
+                if (isImaEnabled)
                 {
                     int accessMode = entPtr->fts_statp->st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
                     // If the file has executable or write (for group/other) flag, set the SMACK
@@ -424,7 +510,7 @@ static le_result_t PerformAppUpgrade
     ExecPreinstallHook(appMd5Ptr, appNamePtr);
 
     // Set smackfs file permission for installed files
-    SetSmackPermReadOnlyDir(appMd5Ptr, appNamePtr);
+    SetSmackPermReadOnlyDir(appMd5Ptr, appNamePtr, ima_IsEnabled());
 
     // Update non-writeable files dir symlink to point to the new version of the app
     system_SymlinkApp("current", appMd5Ptr, appNamePtr);
@@ -456,7 +542,7 @@ static le_result_t PerformAppInstall
     ExecPreinstallHook(appMd5Ptr, appNamePtr);
 
     // Set smackfs file permission for installed files
-    SetSmackPermReadOnlyDir(appMd5Ptr, appNamePtr);
+    SetSmackPermReadOnlyDir(appMd5Ptr, appNamePtr, ima_IsEnabled());
 
     // Create a non-writeable files dir symlink pointing to the app's installed files.
     system_SymlinkApp("current", appMd5Ptr, appNamePtr);
@@ -572,7 +658,7 @@ le_result_t app_SetSmackPermReadOnly
     const char* appNamePtr  ///< [IN] Name of the application to install.
 )
 {
-    return SetSmackPermReadOnlyDir(appMd5Ptr, appNamePtr);
+    return SetSmackPermReadOnlyDir(appMd5Ptr, appNamePtr, ima_IsEnabled());
 }
 
 
@@ -641,19 +727,217 @@ void app_PrepUnpackDir
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of milliseconds elapsed since a given relative time.
+ *
+ * @return
+ *      Elapsed time in milliseconds.
+ */
+//--------------------------------------------------------------------------------------------------
+static long GetElapsedMs
+(
+    le_clk_Time_t startTime             ///< [IN] Relative time to measure from.
+)
+{
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    return (long)(elapsed.sec * 1000 + elapsed.usec / 1000);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets a printable name for an install job type.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetJobTypeName
+(
+    InstallJobType_t type               ///< [IN] Job type.
+)
+{
+    return (type == JOB_MOVE_UNPACKED) ? "Install" : "Writeable files setup";
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Moves an app unpacked as part of a system update to /legato/apps/<hash>, sets the SMACK labels
+ * of its read-only files and shares the files that have not changed with the other installed apps.
+ *
+ * @return LE_OK if successful, LE_FAULT if fails.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t MoveUnpackedApp
+(
+    const InstallJob_t* jobPtr          ///< [IN] Job describing the app.
+)
+{
+    char appPath[LIMIT_MAX_PATH_BYTES];
+
+    LE_ASSERT(snprintf(appPath, sizeof(appPath), "/legato/apps/%s", jobPtr->appMd5)
+              < sizeof(appPath));
+
+    (void)unlink(appPath);
+
+    LE_DEBUG("Renaming '%s' to '%s'", jobPtr->unpackPath, appPath);
+
+    if (rename(jobPtr->unpackPath, appPath) != 0)
+    {
+        LE_CRIT("Failed to rename '%s' to '%s', %m.", jobPtr->unpackPath, appPath);
+        return LE_FAULT;
+    }
+
+    if (SetSmackPermReadOnlyDir(jobPtr->appMd5, jobPtr->appName, InstallImaEnabled) != LE_OK)
+    {
+        LE_CRIT("Failed to setup smack permission for app '%s<%s>'",
+                jobPtr->appName,
+                jobPtr->appMd5);
+        return LE_FAULT;
+    }
+
+    // Must come after the labels are set, since they are part of what makes two files identical.
+    (void)dedup_Tree(appPath);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Install worker thread.  Takes jobs off the queue until it is empty.  Once a job has failed, the
+ * remaining jobs are not run because the update is going to fail anyway.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* InstallWorker
+(
+    void* contextPtr                    ///< [IN] Not used.
+)
+{
+    while (true)
+    {
+        le_mutex_Lock(InstallJobMutex);
+        le_sls_Link_t* linkPtr = le_sls_Pop(&InstallJobQueue);
+        bool hasFailed = InstallJobFailed;
+        le_mutex_Unlock(InstallJobMutex);
+
+        if (linkPtr == NULL)
+        {
+            return NULL;
+        }
+
+        InstallJob_t* jobPtr = CONTAINER_OF(linkPtr, InstallJob_t, link);
+
+        if (!hasFailed)
+        {
+            le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+            if (jobPtr->type == JOB_MOVE_UNPACKED)
+            {
+                jobPtr->result = MoveUnpackedApp(jobPtr);
+            }
+            else
+            {
+                jobPtr->result = installer_InstallAppWriteableFiles(jobPtr->appMd5,
+                                                                    jobPtr->appName,
+                                                                    "current");
+            }
+
+            jobPtr->elapsedMs = GetElapsedMs(startTime);
+            jobPtr->hasRun = true;
+        }
+
+        le_mutex_Lock(InstallJobMutex);
+        if (jobPtr->hasRun && (jobPtr->result != LE_OK))
+        {
+            InstallJobFailed = true;
+        }
+        le_sls_Queue(&InstallJobDoneList, &(jobPtr->link));
+        le_mutex_Unlock(InstallJobMutex);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates an install job and adds it to the queue.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueInstallJob
+(
+    InstallJobType_t type,              ///< [IN] What to do.
+    const char* appMd5Ptr,              ///< [IN] Hash ID of the application.
+    const char* appNamePtr,             ///< [IN] Name of the application.
+    const char* unpackPathPtr           ///< [IN] Where the app was unpacked, or NULL.
+)
+{
+    InstallJob_t* jobPtr = le_mem_ForceAlloc(InstallJobPool);
+
+    jobPtr->type = type;
+    LE_ASSERT(le_utf8_Copy(jobPtr->appMd5, appMd5Ptr, sizeof(jobPtr->appMd5), NULL) == LE_OK);
+    LE_ASSERT(le_utf8_Copy(jobPtr->appName, appNamePtr, sizeof(jobPtr->appName), NULL) == LE_OK);
+    LE_ASSERT(le_utf8_Copy(jobPtr->unpackPath,
+                           (unpackPathPtr != NULL) ? unpackPathPtr : "",
+                           sizeof(jobPtr->unpackPath),
+                           NULL) == LE_OK);
+    jobPtr->hasRun = false;
+    jobPtr->result = LE_FAULT;
+    jobPtr->elapsedMs = 0;
+    jobPtr->link = LE_SLS_LINK_INIT;
+
+    le_sls_Queue(&InstallJobQueue, &(jobPtr->link));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the app module.
+ */
+//--------------------------------------------------------------------------------------------------
+void app_Init
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    InstallJobPool = le_mem_CreatePool("InstallJob", sizeof(InstallJob_t));
+    InstallJobMutex = le_mutex_CreateNonRecursive("InstallJob");
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue the move of an app unpacked as part of a system update into /legato/apps/<hash>, along
+ * with the setup of the SMACK labels of its read-only files.  The move is done by
+ * app_RunQueuedInstallJobs().
+ */
+//--------------------------------------------------------------------------------------------------
+void app_QueueMoveUnpacked
+(
+    const char* unpackPathPtr,  ///< [IN] Directory the app was unpacked into.
+    const char* appMd5Ptr,      ///< [IN] Hash ID of the application to install.
+    const char* appNamePtr      ///< [IN] Name of the application to install.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    QueueInstallJob(JOB_MOVE_UNPACKED, appMd5Ptr, appNamePtr, unpackPathPtr);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set up a given app's writeable files in the "unpack" system.
  *
  * Files will be copied to the system unpack area based on whether an app with the same name
- * exists in the current system.
+ * exists in the current system.  The app's config tree is copied right away, but the files are
+ * copied by app_RunQueuedInstallJobs().
  *
  * @warning Assumes the app identified by the hash is installed in /legato/apps/<hash>.
  *
  * @return LE_OK if successful.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t app_SetUpAppWriteables
+le_result_t app_QueueAppWriteables
 (
     const char* appMd5Ptr,  ///< [IN] Hash ID of the application to install.
     const char* appNamePtr  ///< [IN] Name of the application to install.
@@ -663,7 +947,8 @@ le_result_t app_SetUpAppWriteables
     // If an app with the same name is installed in the current system,
     if (system_HasApp(appNamePtr))
     {
-        // Copy the app's config tree file.
+        // Copy the app's config tree file.  This talks to the Config Tree, so it can't be left to
+        // the install workers.
         if (system_CopyAppConfig(appNamePtr) != LE_OK)
         {
             return LE_FAULT;
@@ -671,7 +956,129 @@ le_result_t app_SetUpAppWriteables
     }
 
     // Install appropriate writable app files.
-    return installer_InstallAppWriteableFiles(appMd5Ptr, appNamePtr, "current");
+    QueueInstallJob(JOB_INSTALL_WRITEABLES, appMd5Ptr, appNamePtr, NULL);
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run all the install jobs queued by app_QueueMoveUnpacked() and app_QueueAppWriteables(), using
+ * up to one worker thread per CPU.  Returns when all the queued jobs have been processed.
+ *
+ * @return LE_OK if all the jobs succeeded, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t app_RunQueuedInstallJobs
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t numJobs = le_sls_NumLinks(&InstallJobQueue);
+
+    if (numJobs == 0)
+    {
+        return LE_OK;
+    }
+
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t numThreads = (numCpus > 0) ? (size_t)numCpus : 1;
+
+    if (numThreads > MAX_INSTALL_THREADS)
+    {
+        numThreads = MAX_INSTALL_THREADS;
+    }
+
+    if (numThreads > numJobs)
+    {
+        numThreads = numJobs;
+    }
+
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+    InstallJobFailed = false;
+    InstallImaEnabled = ima_IsEnabled();
+
+    if (numThreads == 1)
+    {
+        // Not worth a thread.
+        InstallWorker(NULL);
+    }
+    else
+    {
+        le_thread_Ref_t threads[MAX_INSTALL_THREADS];
+        size_t i;
+
+        for (i = 0; i < numThreads; i++)
+        {
+            char threadName[LIMIT_MAX_THREAD_NAME_BYTES];
+            snprintf(threadName, sizeof(threadName), "Install%zu", i);
+
+            threads[i] = le_thread_Create(threadName, InstallWorker, NULL);
+            le_thread_SetJoinable(threads[i]);
+            le_thread_Start(threads[i]);
+        }
+
+        for (i = 0; i < numThreads; i++)
+        {
+            le_thread_Join(threads[i], NULL);
+        }
+    }
+
+    // The workers are done so the done list is no longer shared.
+    le_result_t result = LE_OK;
+    le_sls_Link_t* linkPtr;
+
+    while ((linkPtr = le_sls_Pop(&InstallJobDoneList)) != NULL)
+    {
+        InstallJob_t* jobPtr = CONTAINER_OF(linkPtr, InstallJob_t, link);
+
+        if (!jobPtr->hasRun)
+        {
+            result = LE_FAULT;
+        }
+        else if (jobPtr->result != LE_OK)
+        {
+            LE_CRIT("%s failed for app '%s<%s>'.",
+                    GetJobTypeName(jobPtr->type), jobPtr->appName, jobPtr->appMd5);
+            result = LE_FAULT;
+        }
+        else
+        {
+            LE_INFO("%s for app '%s<%s>' took %ld ms.",
+                    GetJobTypeName(jobPtr->type), jobPtr->appName, jobPtr->appMd5,
+                    jobPtr->elapsedMs);
+        }
+
+        le_mem_Release(jobPtr);
+    }
+
+    LE_INFO("Ran %zu install jobs on %zu threads in %ld ms.",
+            numJobs, numThreads, GetElapsedMs(startTime));
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Throw away all the queued install jobs without running them.
+ */
+//--------------------------------------------------------------------------------------------------
+void app_DiscardQueuedInstallJobs
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_sls_Link_t* linkPtr;
+
+    while ((linkPtr = le_sls_Pop(&InstallJobQueue)) != NULL)
+    {
+        le_mem_Release(CONTAINER_OF(linkPtr, InstallJob_t, link));
+    }
 }
 
 
@@ -693,6 +1100,7 @@ le_result_t app_InstallIndividual
 //--------------------------------------------------------------------------------------------------
 {
     bool systemHasThisApp = false;
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
 
     if (system_HasApp(appNamePtr))
     {
@@ -773,6 +1181,11 @@ le_result_t app_InstallIndividual
         }
     }
 
+    // Now that the app's files are labelled, share the ones that didn't change with the other
+    // installed apps (e.g., the version kept in the snapshot).
+    char appPath[PATH_MAX];
+    LE_ASSERT(snprintf(appPath, sizeof(appPath), "/legato/apps/%s", appMd5Ptr) < sizeof(appPath));
+    (void)dedup_Tree(appPath);
 
     // Reload the bindings configuration
     system("/legato/systems/current/bin/sdir load");
@@ -785,7 +1198,7 @@ le_result_t app_InstallIndividual
 
     supCtrl_StartApp(appNamePtr);
 
-    LE_INFO("App %s <%s> installed", appNamePtr, appMd5Ptr);
+    LE_INFO("App %s <%s> installed in %ld ms", appNamePtr, appMd5Ptr, GetElapsedMs(startTime));
 
     return LE_OK;
 }
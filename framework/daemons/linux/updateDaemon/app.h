@@ -72,25 +72,77 @@ le_result_t app_SetSmackPermReadOnly
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initialize the app module.
+ */
+//--------------------------------------------------------------------------------------------------
+void app_Init
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue the move of an app unpacked as part of a system update into /legato/apps/<hash>, along
+ * with the setup of the SMACK labels of its read-only files.  The move is done by
+ * app_RunQueuedInstallJobs().
+ */
+//--------------------------------------------------------------------------------------------------
+void app_QueueMoveUnpacked
+(
+    const char* unpackPathPtr,  ///< [IN] Directory the app was unpacked into.
+    const char* appMd5Ptr,      ///< [IN] Hash ID of the application to install.
+    const char* appNamePtr      ///< [IN] Name of the application to install.
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set up a given app's writeable files in the "unpack" system.
  *
  * Files will be copied to the system unpack area based on whether an app with the same name
- * exists in the current system.
+ * exists in the current system.  The app's config tree is copied right away, but the files are
+ * copied by app_RunQueuedInstallJobs().
  *
  * @warning Assumes the app identified by the hash is installed in /legato/apps/<hash>.
  *
  * @return LE_OK if successful.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t app_SetUpAppWriteables
+le_result_t app_QueueAppWriteables
 (
     const char* appMd5Ptr,  ///< [IN] Hash ID of the application to install.
     const char* appNamePtr  ///< [IN] Name of the application to install.
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Run all the install jobs queued by app_QueueMoveUnpacked() and app_QueueAppWriteables(), using
+ * up to one worker thread per CPU.  Returns when all the queued jobs have been processed.
+ *
+ * @return LE_OK if all the jobs succeeded, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t app_RunQueuedInstallJobs
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Throw away all the queued install jobs without running them.
+ */
+//--------------------------------------------------------------------------------------------------
+void app_DiscardQueuedInstallJobs
+(
+    void
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Install a new individual application update in the current running system.
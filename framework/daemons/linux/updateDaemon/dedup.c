@@ -0,0 +1,517 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file dedup.c
+ *
+ * Content-addressed store used to share identical read-only files between installed apps.
+ *
+ * Structure:
+ *
+ * legato/
+ *   objects/
+ *     <sha256 of inode attributes and content>
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "limit.h"
+#include "fileDescriptor.h"
+#include "fileSystem.h"
+#include "dedup.h"
+#include <sys/xattr.h>
+#include <openssl/evp.h>
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directory holding the objects.  It must be on the same file system as /legato/apps, but not
+ * under it, since everything under /legato/apps is expected to be an app.
+ */
+//--------------------------------------------------------------------------------------------------
+#define OBJECT_DIR              "/legato/objects"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Files this size or smaller are not worth linking: the space saved would be less than the space
+ * used by the directory entry of the object.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MIN_FILE_BYTES          1024
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the buffer used to read a file's content.
+ */
+//--------------------------------------------------------------------------------------------------
+#define READ_BUFFER_BYTES       (16 * 1024)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of extended attributes and the size of their names and values.  Files with more
+ * or bigger attributes than this are not linked.
+ */
+//--------------------------------------------------------------------------------------------------
+#define MAX_XATTRS              16
+#define MAX_XATTR_NAMES_BYTES   1024
+#define MAX_XATTR_VALUE_BYTES   1024
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Size of the object key, as a string of hex digits.
+ */
+//--------------------------------------------------------------------------------------------------
+#define KEY_BYTES               (2 * 32 + 1)
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Counters for one call to dedup_Tree().
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    size_t fileCount;           ///< Number of regular files found.
+    size_t linkedCount;         ///< Number of files replaced with a link to an existing object.
+    size_t addedCount;          ///< Number of files added to the store.
+    unsigned long long savedBytes;  ///< Bytes no longer stored twice.
+}
+DedupStats_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compares two strings for qsort().
+ */
+//--------------------------------------------------------------------------------------------------
+static int CompareNames
+(
+    const void* aPtr,
+    const void* bPtr
+)
+{
+    return strcmp(*(const char* const*)aPtr, *(const char* const*)bPtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds a file's extended attributes, sorted by name, to a digest.
+ *
+ * @return LE_OK if successful, LE_FAULT if the attributes could not be read or are too big.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t DigestXattrs
+(
+    EVP_MD_CTX* ctxPtr,         ///< [IN] Digest.
+    int fd,                     ///< [IN] File.
+    const char* pathPtr         ///< [IN] Path to the file, for logging.
+)
+{
+    char names[MAX_XATTR_NAMES_BYTES];
+    const char* namePtrs[MAX_XATTRS];
+    size_t nameCount = 0;
+
+    ssize_t namesSize = flistxattr(fd, names, sizeof(names));
+
+    if (namesSize < 0)
+    {
+        if (errno == ENOTSUP)
+        {
+            return LE_OK;
+        }
+
+        LE_WARN("Could not list extended attributes of '%s' (%m).", pathPtr);
+        return LE_FAULT;
+    }
+
+    ssize_t offset = 0;
+
+    while (offset < namesSize)
+    {
+        if (nameCount >= MAX_XATTRS)
+        {
+            return LE_FAULT;
+        }
+
+        namePtrs[nameCount++] = names + offset;
+        offset += strlen(names + offset) + 1;
+    }
+
+    qsort(namePtrs, nameCount, sizeof(namePtrs[0]), CompareNames);
+
+    size_t i;
+
+    for (i = 0; i < nameCount; i++)
+    {
+        char value[MAX_XATTR_VALUE_BYTES];
+
+        ssize_t valueSize = fgetxattr(fd, namePtrs[i], value, sizeof(value));
+
+        if (valueSize < 0)
+        {
+            LE_WARN("Could not read extended attribute '%s' of '%s' (%m).", namePtrs[i], pathPtr);
+            return LE_FAULT;
+        }
+
+        uint32_t size = (uint32_t)valueSize;
+
+        EVP_DigestUpdate(ctxPtr, namePtrs[i], strlen(namePtrs[i]) + 1);
+        EVP_DigestUpdate(ctxPtr, &size, sizeof(size));
+        EVP_DigestUpdate(ctxPtr, value, valueSize);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Computes the object key of a file: the SHA-256 digest of everything that two files must have in
+ * common to share an inode.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t GetKey
+(
+    const char* pathPtr,        ///< [IN] Path to the file.
+    const struct stat* statPtr, ///< [IN] Status of the file.
+    char* keyPtr                ///< [OUT] Key, as KEY_BYTES worth of hex digits.
+)
+{
+    int fd = open(pathPtr, O_RDONLY | O_NOFOLLOW);
+
+    if (fd < 0)
+    {
+        LE_WARN("Could not open '%s' (%m).", pathPtr);
+        return LE_FAULT;
+    }
+
+    EVP_MD_CTX* ctxPtr = EVP_MD_CTX_create();
+    le_result_t result = LE_FAULT;
+
+    if ((ctxPtr == NULL) || (EVP_DigestInit_ex(ctxPtr, EVP_sha256(), NULL) != 1))
+    {
+        LE_ERROR("Could not initialize digest.");
+        goto cleanup;
+    }
+
+    uint32_t mode = statPtr->st_mode;
+    uint32_t uid = statPtr->st_uid;
+    uint32_t gid = statPtr->st_gid;
+    uint64_t size = statPtr->st_size;
+
+    EVP_DigestUpdate(ctxPtr, &mode, sizeof(mode));
+    EVP_DigestUpdate(ctxPtr, &uid, sizeof(uid));
+    EVP_DigestUpdate(ctxPtr, &gid, sizeof(gid));
+    EVP_DigestUpdate(ctxPtr, &size, sizeof(size));
+
+    if (DigestXattrs(ctxPtr, fd, pathPtr) != LE_OK)
+    {
+        goto cleanup;
+    }
+
+    uint8_t buffer[READ_BUFFER_BYTES];
+    uint64_t totalBytes = 0;
+
+    for (;;)
+    {
+        ssize_t readBytes = read(fd, buffer, sizeof(buffer));
+
+        if (readBytes == 0)
+        {
+            break;
+        }
+
+        if (readBytes < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            LE_WARN("Could not read '%s' (%m).", pathPtr);
+            goto cleanup;
+        }
+
+        EVP_DigestUpdate(ctxPtr, buffer, readBytes);
+        totalBytes += readBytes;
+    }
+
+    if (totalBytes != size)
+    {
+        LE_WARN("'%s' changed while it was being read.", pathPtr);
+        goto cleanup;
+    }
+
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int digestSize = 0;
+
+    if (EVP_DigestFinal_ex(ctxPtr, digest, &digestSize) != 1)
+    {
+        LE_ERROR("Could not finalize digest.");
+        goto cleanup;
+    }
+
+    LE_ASSERT(le_hex_BinaryToString(digest, digestSize, keyPtr, KEY_BYTES) >= 0);
+
+    result = LE_OK;
+
+cleanup:
+
+    if (ctxPtr != NULL)
+    {
+        EVP_MD_CTX_destroy(ctxPtr);
+    }
+
+    fd_Close(fd);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Links a file into the object store, or replaces it with a link to the object that is already in
+ * the store.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DedupFile
+(
+    const char* pathPtr,        ///< [IN] Path to the file.
+    const struct stat* statPtr, ///< [IN] Status of the file.
+    DedupStats_t* statsPtr      ///< [IN/OUT] Counters.
+)
+{
+    char key[KEY_BYTES];
+
+    if (GetKey(pathPtr, statPtr, key) != LE_OK)
+    {
+        return;
+    }
+
+    char objPath[LIMIT_MAX_PATH_BYTES];
+
+    LE_ASSERT(snprintf(objPath, sizeof(objPath), "%s/%s", OBJECT_DIR, key) < sizeof(objPath));
+
+    if (link(pathPtr, objPath) == 0)
+    {
+        statsPtr->addedCount++;
+        return;
+    }
+
+    if (errno != EEXIST)
+    {
+        // E.g., EXDEV or EMLINK.  The file stays as it is.
+        LE_DEBUG("Could not add '%s' to the object store (%m).", pathPtr);
+        return;
+    }
+
+    // The key covers all these, but double check in case the object was tampered with.
+    struct stat objStat;
+
+    if (lstat(objPath, &objStat) != 0)
+    {
+        LE_WARN("Could not stat '%s' (%m).", objPath);
+        return;
+    }
+
+    if (   (!S_ISREG(objStat.st_mode))
+        || (objStat.st_mode != statPtr->st_mode)
+        || (objStat.st_uid != statPtr->st_uid)
+        || (objStat.st_gid != statPtr->st_gid)
+        || (objStat.st_size != statPtr->st_size) )
+    {
+        LE_WARN("Object '%s' does not match '%s'.", objPath, pathPtr);
+        return;
+    }
+
+    if (objStat.st_ino == statPtr->st_ino)
+    {
+        return;
+    }
+
+    // Link to a temporary name first, so the file is replaced atomically.
+    char tmpPath[LIMIT_MAX_PATH_BYTES];
+
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.dedup", pathPtr) >= sizeof(tmpPath))
+    {
+        return;
+    }
+
+    (void)unlink(tmpPath);
+
+    if (link(objPath, tmpPath) != 0)
+    {
+        LE_DEBUG("Could not link '%s' to '%s' (%m).", tmpPath, objPath);
+        return;
+    }
+
+    if (rename(tmpPath, pathPtr) != 0)
+    {
+        LE_WARN("Could not replace '%s' (%m).", pathPtr);
+        (void)unlink(tmpPath);
+        return;
+    }
+
+    statsPtr->linkedCount++;
+    statsPtr->savedBytes += statPtr->st_size;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replaces the regular files under a directory with hard links to identical files in the object
+ * store, adding the files that are not in the store yet.
+ *
+ * This is best-effort: files that can't be linked are left as they are.  It can be called from
+ * several threads at once.
+ *
+ * @return
+ *      - LE_OK if the directory was walked (even if some files were not linked).
+ *      - LE_FAULT if the directory could not be walked.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t dedup_Tree
+(
+    const char* dirPath         ///< [IN] Directory to deduplicate.
+)
+{
+    le_clk_Time_t startTime = le_clk_GetRelativeTime();
+
+    if ((mkdir(OBJECT_DIR, S_IRWXU) != 0) && (errno != EEXIST))
+    {
+        LE_ERROR("Could not create '%s' (%m).", OBJECT_DIR);
+        return LE_FAULT;
+    }
+
+    char* pathArrayPtr[] = { (char*)dirPath, NULL };
+    FTS* ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL | FTS_NOCHDIR, NULL);
+
+    if (ftsPtr == NULL)
+    {
+        LE_ERROR("Could not access dir '%s' (%m).", dirPath);
+        return LE_FAULT;
+    }
+
+    DedupStats_t stats = { 0 };
+
+    FTSENT* entPtr;
+    while ((entPtr = fts_read(ftsPtr)) != NULL)
+    {
+        if (entPtr->fts_info != FTS_F)
+        {
+            continue;
+        }
+
+        stats.fileCount++;
+
+        // Files that already have several links are either already in the store or linked from
+        // somewhere this doesn't know about; either way, leave them alone.
+        if (   (entPtr->fts_statp->st_nlink > 1)
+            || (entPtr->fts_statp->st_size <= MIN_FILE_BYTES) )
+        {
+            continue;
+        }
+
+        DedupFile(entPtr->fts_path, entPtr->fts_statp, &stats);
+    }
+
+    fts_close(ftsPtr);
+
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    LE_INFO("Deduplicated '%s': %zu files, %zu added, %zu linked, %llu KiB saved in %ld ms.",
+            dirPath,
+            stats.fileCount,
+            stats.addedCount,
+            stats.linkedCount,
+            stats.savedBytes / 1024,
+            (long)(elapsed.sec * 1000 + elapsed.usec / 1000));
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes the objects that are not linked from anywhere but the object store anymore.  Must not be
+ * called while dedup_Tree() is running in another thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void dedup_Prune
+(
+    void
+)
+{
+    DIR* dirPtr = opendir(OBJECT_DIR);
+
+    if (dirPtr == NULL)
+    {
+        if (errno != ENOENT)
+        {
+            LE_ERROR("Could not open '%s' (%m).", OBJECT_DIR);
+        }
+
+        return;
+    }
+
+    size_t removedCount = 0;
+    unsigned long long removedBytes = 0;
+
+    for (;;)
+    {
+        errno = 0;
+
+        struct dirent* entryPtr = readdir(dirPtr);
+
+        if (entryPtr == NULL)
+        {
+            if (errno != 0)
+            {
+                LE_ERROR("Error reading directory '%s' (%m).", OBJECT_DIR);
+            }
+
+            break;
+        }
+
+        if (entryPtr->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        struct stat objStat;
+
+        if (fstatat(dirfd(dirPtr), entryPtr->d_name, &objStat, AT_SYMLINK_NOFOLLOW) != 0)
+        {
+            LE_WARN("Could not stat '%s/%s' (%m).", OBJECT_DIR, entryPtr->d_name);
+            continue;
+        }
+
+        if (S_ISREG(objStat.st_mode) && (objStat.st_nlink > 1))
+        {
+            continue;
+        }
+
+        if (unlinkat(dirfd(dirPtr), entryPtr->d_name, 0) != 0)
+        {
+            LE_WARN("Could not remove '%s/%s' (%m).", OBJECT_DIR, entryPtr->d_name);
+            continue;
+        }
+
+        removedCount++;
+        removedBytes += objStat.st_size;
+    }
+
+    closedir(dirPtr);
+
+    if (removedCount > 0)
+    {
+        LE_INFO("Removed %zu unused objects (%llu KiB).", removedCount, removedBytes / 1024);
+    }
+}
@@ -0,0 +1,58 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file dedup.h
+ *
+ * Content-addressed store used by the Update Daemon to share identical read-only files between
+ * installed apps.
+ *
+ * Every installed app lives in its own /legato/apps/<hash> directory, so a new version of an app
+ * normally carries its own copy of every file, even the ones that did not change since the version
+ * that is kept for roll-back.  Once an app's files have been installed and labelled, each regular
+ * file is keyed by a SHA-256 digest of its content and the attributes that the file system stores
+ * in the inode (mode, owner, extended attributes such as the SMACK label and IMA signature).  The
+ * first file with a given key is hard linked into /legato/objects/<key>, and later files with the
+ * same key are replaced with a hard link to that object.
+ *
+ * Because linked files share their inode, this must only be used on files that are never modified
+ * in place.  Objects that are no longer linked from anywhere are removed by dedup_Prune().
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LEGATO_DEDUP_H_INCLUDE_GUARD
+#define LEGATO_DEDUP_H_INCLUDE_GUARD
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Replaces the regular files under a directory with hard links to identical files in the object
+ * store, adding the files that are not in the store yet.
+ *
+ * This is best-effort: files that can't be linked are left as they are.  It can be called from
+ * several threads at once.
+ *
+ * @return
+ *      - LE_OK if the directory was walked (even if some files were not linked).
+ *      - LE_FAULT if the directory could not be walked.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t dedup_Tree
+(
+    const char* dirPath         ///< [IN] Directory to deduplicate.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes the objects that are not linked from anywhere but the object store anymore.  Must not be
+ * called while dedup_Tree() is running in another thread.
+ */
+//--------------------------------------------------------------------------------------------------
+void dedup_Prune
+(
+    void
+);
+
+
+#endif // LEGATO_DEDUP_H_INCLUDE_GUARD
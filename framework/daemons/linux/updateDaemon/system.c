@@ -23,6 +23,7 @@
 #include "sysPaths.h"
 #include "sysStatus.h"
 #include "smack.h"
+#include "dedup.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -753,6 +754,143 @@ le_result_t system_FinishUpdate
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Directories of a system whose files are never modified in place, so a snapshot can share them
+ * with the current system through hard links instead of copying them.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* ImmutableSystemDirs[] = { "bin", "lib", "modules" };
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether a top-level entry of a system is one of its immutable directories.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsImmutableSystemDir
+(
+    const char* namePtr             ///< [IN] Name of the entry.
+)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ARRAY_MEMBERS(ImmutableSystemDirs); i++)
+    {
+        if (strcmp(namePtr, ImmutableSystemDirs[i]) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copies the current system into the unpack directory.  The immutable directories are hard linked
+ * rather than copied, which saves both the time and the flash space of a full copy.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CopyCurrentSystem
+(
+    void
+)
+{
+    DIR* dirPtr = opendir(CURRENT_SYSTEM_PATH);
+
+    if (dirPtr == NULL)
+    {
+        LE_ERROR("Error opening directory %s.  %m.", CURRENT_SYSTEM_PATH);
+        return LE_FAULT;
+    }
+
+    le_result_t result = LE_OK;
+
+    while (result == LE_OK)
+    {
+        errno = 0;
+
+        struct dirent* entryPtr = readdir(dirPtr);
+
+        if (entryPtr == NULL)
+        {
+            if (errno != 0)
+            {
+                LE_ERROR("Error reading directory %s.  %m.", CURRENT_SYSTEM_PATH);
+                result = LE_FAULT;
+            }
+
+            break;
+        }
+
+        if ((strcmp(entryPtr->d_name, ".") == 0) || (strcmp(entryPtr->d_name, "..") == 0))
+        {
+            continue;
+        }
+
+        char srcPath[LIMIT_MAX_PATH_BYTES] = CURRENT_SYSTEM_PATH;
+        char destPath[LIMIT_MAX_PATH_BYTES] = "";
+
+        if (   (le_path_Concat("/", srcPath, sizeof(srcPath), entryPtr->d_name, NULL) != LE_OK)
+            || (le_path_Concat("/", destPath, sizeof(destPath),
+                               system_UnpackPath, entryPtr->d_name, NULL) != LE_OK) )
+        {
+            LE_ERROR("Path to '%s' is too long.", entryPtr->d_name);
+            result = LE_FAULT;
+            break;
+        }
+
+        struct stat srcStat;
+
+        if (lstat(srcPath, &srcStat) != 0)
+        {
+            LE_ERROR("Could not stat '%s'.  %m.", srcPath);
+            result = LE_FAULT;
+        }
+        else if (S_ISLNK(srcStat.st_mode))
+        {
+            char target[LIMIT_MAX_PATH_BYTES];
+            ssize_t len = readlink(srcPath, target, sizeof(target) - 1);
+
+            if (len < 0)
+            {
+                LE_ERROR("Could not read link '%s'.  %m.", srcPath);
+                result = LE_FAULT;
+            }
+            else
+            {
+                target[len] = '\0';
+
+                if (symlink(target, destPath) != 0)
+                {
+                    LE_ERROR("Could not create link '%s'.  %m.", destPath);
+                    result = LE_FAULT;
+                }
+            }
+        }
+        else if (S_ISDIR(srcStat.st_mode) && IsImmutableSystemDir(entryPtr->d_name))
+        {
+            if (file_LinkRecursive(srcPath, destPath) != LE_OK)
+            {
+                result = LE_FAULT;
+            }
+        }
+        else if (file_CopyRecursive(srcPath, destPath, NULL) != LE_OK)
+        {
+            result = LE_FAULT;
+        }
+    }
+
+    closedir(dirPtr);
+
+    return result;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Take a snapshot of the current system.
@@ -783,7 +921,7 @@ le_result_t system_Snapshot
 
     system_PrepUnpackDir();
 
-    if (file_CopyRecursive(CURRENT_SYSTEM_PATH, system_UnpackPath, NULL) != LE_OK)
+    if (CopyCurrentSystem() != LE_OK)
     {
         return LE_FAULT;
     }
@@ -1057,6 +1195,9 @@ void system_RemoveUnusedApps
     }
 
     fts_close(ftsPtr);
+
+    // Drop the shared files that were only used by the apps just removed.
+    dedup_Prune();
 }
 
 
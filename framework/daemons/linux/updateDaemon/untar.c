@@ -0,0 +1,1887 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file untar.c
+ *
+ * Implementation of the streaming tarball extractor.  See untar.h.
+ *
+ * The extractor is a push parser with two layers:
+ *
+ *  - the decompression layer detects the compression from the first bytes fed to it and
+ *    decompresses into an output buffer;
+ *  - the tar layer is a state machine that consumes the decompressed bytes in 512-byte blocks
+ *    and creates the entries on the file system as their data arrives.
+ *
+ * Only what the mk tools and bsdtar/GNU tar produce is supported: regular files, directories,
+ * symbolic links and hard links, with GNU long name and pax extended headers.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#include "legato.h"
+#include "limit.h"
+#include "fileDescriptor.h"
+#include "untar.h"
+#include <bzlib.h>
+#include <zlib.h>
+#include <sys/xattr.h>
+#include <openssl/evp.h>
+
+
+/// Size of a tar block.
+#define TAR_BLOCK_BYTES         512
+
+/// Size of the buffer that decompressed data is written to.
+#define OUTPUT_BUFFER_BYTES     (64 * 1024)
+
+/// Maximum size of a pax extended header or GNU long name entry.
+#define MAX_META_BYTES          16384
+
+/// Maximum number of extended attributes on a single entry.
+#define MAX_XATTRS              16
+
+/// Maximum size of an extended attribute name, including the null terminator.
+#define MAX_XATTR_NAME_BYTES    256
+
+/// Maximum size of all the extended attribute values of a single entry.
+#define MAX_XATTR_DATA_BYTES    8192
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Offsets and sizes of the fields of a tar header block.
+ */
+//--------------------------------------------------------------------------------------------------
+#define HDR_NAME_OFFSET         0
+#define HDR_NAME_SIZE           100
+#define HDR_MODE_OFFSET         100
+#define HDR_MODE_SIZE           8
+#define HDR_SIZE_OFFSET         124
+#define HDR_SIZE_SIZE           12
+#define HDR_CHKSUM_OFFSET       148
+#define HDR_CHKSUM_SIZE         8
+#define HDR_TYPE_OFFSET         156
+#define HDR_LINKNAME_OFFSET     157
+#define HDR_LINKNAME_SIZE       100
+#define HDR_MAGIC_OFFSET        257
+#define HDR_PREFIX_OFFSET       345
+#define HDR_PREFIX_SIZE         155
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compression formats.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    COMPRESSION_UNKNOWN,        ///< Not enough data yet to tell.
+    COMPRESSION_NONE,           ///< Plain tarball.
+    COMPRESSION_BZIP2,          ///< bzip2 compressed tarball (tar cj).
+    COMPRESSION_GZIP            ///< gzip compressed tarball (tar cz).
+}
+Compression_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * States of the tar layer.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    TAR_STATE_HEADER,           ///< Collecting a header block.
+    TAR_STATE_FILE_DATA,        ///< Writing the data of a regular file.
+    TAR_STATE_META_DATA,        ///< Collecting the data of a long name or pax header entry.
+    TAR_STATE_SKIP,             ///< Skipping padding or data that isn't needed.
+    TAR_STATE_END,              ///< The end of archive marker has been seen.
+    TAR_STATE_ERROR             ///< An error occurred.
+}
+TarState_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * An extended attribute to be set on the next entry.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    char name[MAX_XATTR_NAME_BYTES];    ///< Attribute name (e.g., "security.ima").
+    size_t valueOffset;                 ///< Offset of the value in the extractor's xattrData.
+    size_t valueSize;                   ///< Size of the value.
+}
+Xattr_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Extractor object.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct untar_Extractor
+{
+    char dirPath[LIMIT_MAX_PATH_BYTES];     ///< Directory being unpacked into.
+
+    Compression_t compression;              ///< Compression of the tarball.
+    uint8_t magic[3];                       ///< First bytes of the data, to detect compression.
+    size_t magicBytes;                      ///< Number of bytes in magic.
+    bool isDecoderInit;                     ///< true if the decoder below has been initialized.
+    bool isStreamEnd;                       ///< true if the end of the compressed stream was hit.
+    bz_stream bzStream;                     ///< bzip2 decoder.
+    z_stream zStream;                       ///< gzip decoder.
+    size_t tarBytes;                        ///< Number of bytes of tarball processed.
+
+    TarState_t state;                       ///< State of the tar layer.
+    le_result_t error;                      ///< Error to report once in the error state.
+    uint8_t header[TAR_BLOCK_BYTES];        ///< Header block being collected.
+    size_t headerBytes;                     ///< Number of bytes in header.
+    uint64_t dataRemaining;                 ///< Bytes of entry data (or skip) still to come.
+    uint64_t padRemaining;                  ///< Bytes of padding after the entry data.
+    char metaType;                          ///< Type of meta data entry being collected.
+    char metaBuf[MAX_META_BYTES + 1];       ///< Meta data being collected.
+    size_t metaBytes;                       ///< Number of bytes in metaBuf.
+    bool hasSymlinks;                       ///< true if a symlink has been extracted.
+
+    int fd;                                 ///< Regular file being written, or -1.
+    char path[LIMIT_MAX_PATH_BYTES];        ///< Path of the regular file being written.
+    mode_t mode;                            ///< Permissions of the regular file being written.
+    untar_FileHandler_t fileHandler;        ///< Called when a regular file is written, or NULL.
+    void* fileHandlerContextPtr;            ///< Passed to fileHandler.
+    EVP_MD_CTX* fileDigestPtr;              ///< Digest of the regular file being written.
+
+    char longName[LIMIT_MAX_PATH_BYTES];    ///< Name for the next entry, from a meta entry.
+    char longLink[LIMIT_MAX_PATH_BYTES];    ///< Link name for the next entry, from a meta entry.
+    bool hasSizeOverride;                   ///< true if the next entry's size came from pax.
+    uint64_t sizeOverride;                  ///< Size for the next entry, from a pax header.
+    Xattr_t xattrs[MAX_XATTRS];             ///< Extended attributes for the next entry.
+    size_t numXattrs;                       ///< Number of entries in xattrs.
+    uint8_t xattrData[MAX_XATTR_DATA_BYTES];///< Values of the extended attributes.
+    size_t xattrDataBytes;                  ///< Number of bytes used in xattrData.
+
+    uint8_t outBuf[OUTPUT_BUFFER_BYTES];    ///< Decompression output buffer.
+}
+Extractor_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool of extractor objects.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t ExtractorPool;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Puts an extractor in the error state.
+ *
+ * @return The error code.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SetError
+(
+    Extractor_t* exPtr,
+    le_result_t result
+)
+//--------------------------------------------------------------------------------------------------
+{
+    exPtr->state = TAR_STATE_ERROR;
+    exPtr->error = result;
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parses a numeric header field, which is either octal text or (GNU) base-256 binary.
+ *
+ * @return true if successful.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool ParseNumber
+(
+    const uint8_t* fieldPtr,
+    size_t fieldSize,
+    uint64_t* valuePtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t value = 0;
+    size_t i = 0;
+
+    if (fieldPtr[0] & 0x80)
+    {
+        value = fieldPtr[0] & 0x3f;
+
+        for (i = 1; i < fieldSize; i++)
+        {
+            if (value >> 56)
+            {
+                return false;
+            }
+            value = (value << 8) | fieldPtr[i];
+        }
+    }
+    else
+    {
+        while ((i < fieldSize) && (fieldPtr[i] == ' '))
+        {
+            i++;
+        }
+
+        for (; (i < fieldSize) && (fieldPtr[i] != '\0') && (fieldPtr[i] != ' '); i++)
+        {
+            if ((fieldPtr[i] < '0') || (fieldPtr[i] > '7') || (value >> 61))
+            {
+                return false;
+            }
+            value = (value << 3) | (fieldPtr[i] - '0');
+        }
+    }
+
+    *valuePtr = value;
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks the checksum of the header block.
+ *
+ * @return true if the checksum is correct.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsChecksumValid
+(
+    const uint8_t* headerPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint64_t expected;
+
+    if (!ParseNumber(headerPtr + HDR_CHKSUM_OFFSET, HDR_CHKSUM_SIZE, &expected))
+    {
+        return false;
+    }
+
+    // The checksum is computed with the checksum field filled with spaces.  Some old tars used
+    // signed chars, so accept that too.
+    uint64_t unsignedSum = 0;
+    int64_t signedSum = 0;
+    size_t i;
+
+    for (i = 0; i < TAR_BLOCK_BYTES; i++)
+    {
+        uint8_t byte = headerPtr[i];
+
+        if ((i >= HDR_CHKSUM_OFFSET) && (i < HDR_CHKSUM_OFFSET + HDR_CHKSUM_SIZE))
+        {
+            byte = ' ';
+        }
+
+        unsignedSum += byte;
+        signedSum += (int8_t)byte;
+    }
+
+    return (expected == unsignedSum) || ((int64_t)expected == signedSum);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether a block is all zeros (end of archive marker).
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsZeroBlock
+(
+    const uint8_t* blockPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t i;
+
+    for (i = 0; i < TAR_BLOCK_BYTES; i++)
+    {
+        if (blockPtr[i] != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copies a possibly unterminated string field.
+ *
+ * @return LE_OK if successful, LE_OVERFLOW if the buffer is too small.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CopyField
+(
+    char* destPtr,
+    size_t destSize,
+    const char* srcPtr,
+    size_t srcSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t len = strnlen(srcPtr, srcSize);
+
+    if (len >= destSize)
+    {
+        return LE_OVERFLOW;
+    }
+
+    memcpy(destPtr, srcPtr, len);
+    destPtr[len] = '\0';
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the absolute path of an entry from its name in the tarball.  Leading "/" and "./" are
+ * removed, and names containing ".." components are rejected so that nothing can be written
+ * outside the directory being unpacked into.
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR if the name is not acceptable.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t MakeDestPath
+(
+    Extractor_t* exPtr,
+    const char* namePtr,
+    char* pathPtr,
+    size_t pathSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    for (;;)
+    {
+        if (namePtr[0] == '/')
+        {
+            namePtr++;
+        }
+        else if ((namePtr[0] == '.') && (namePtr[1] == '/'))
+        {
+            namePtr += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    const char* componentPtr = namePtr;
+
+    while (*componentPtr != '\0')
+    {
+        size_t len = strcspn(componentPtr, "/");
+
+        if ((len == 2) && (componentPtr[0] == '.') && (componentPtr[1] == '.'))
+        {
+            LE_ERROR("Tarball entry '%s' is outside the unpack directory.", namePtr);
+            return LE_FORMAT_ERROR;
+        }
+
+        componentPtr += len;
+        componentPtr += strspn(componentPtr, "/");
+    }
+
+    int len;
+
+    if ((namePtr[0] == '\0') || (strcmp(namePtr, ".") == 0))
+    {
+        len = snprintf(pathPtr, pathSize, "%s", exPtr->dirPath);
+    }
+    else
+    {
+        len = snprintf(pathPtr, pathSize, "%s/%s", exPtr->dirPath, namePtr);
+    }
+
+    if ((len < 0) || ((size_t)len >= pathSize))
+    {
+        LE_ERROR("Path of tarball entry '%s' is too long.", namePtr);
+        return LE_FORMAT_ERROR;
+    }
+
+    // Directory entries end with a separator.
+    while ((len > 1) && (pathPtr[len - 1] == '/'))
+    {
+        pathPtr[--len] = '\0';
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks that none of the directories between the unpack directory and an entry are symlinks,
+ * so that a symlink extracted earlier can't be used to write outside the unpack directory.
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR if a symlink was found.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CheckParents
+(
+    Extractor_t* exPtr,
+    const char* pathPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (!exPtr->hasSymlinks)
+    {
+        return LE_OK;
+    }
+
+    char parent[LIMIT_MAX_PATH_BYTES];
+    size_t dirLen = strlen(exPtr->dirPath);
+    const char* sepPtr = pathPtr + dirLen;
+
+    while ((sepPtr = strchr(sepPtr + 1, '/')) != NULL)
+    {
+        struct stat st;
+
+        memcpy(parent, pathPtr, sepPtr - pathPtr);
+        parent[sepPtr - pathPtr] = '\0';
+
+        if ((lstat(parent, &st) == 0) && S_ISLNK(st.st_mode))
+        {
+            LE_ERROR("Tarball entry '%s' is under symlink '%s'.", pathPtr, parent);
+            return LE_FORMAT_ERROR;
+        }
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates the parent directories of a path.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t MakeParents
+(
+    const char* pathPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char parent[LIMIT_MAX_PATH_BYTES];
+
+    LE_ASSERT(le_utf8_Copy(parent, pathPtr, sizeof(parent), NULL) == LE_OK);
+
+    char* sepPtr = strrchr(parent, '/');
+    if (sepPtr == NULL)
+    {
+        return LE_FAULT;
+    }
+    *sepPtr = '\0';
+
+    return le_dir_MakePath(parent, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Removes whatever is at a path so that an entry can be created there.  Directories are kept.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RemoveExisting
+(
+    const char* pathPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    struct stat st;
+
+    if (lstat(pathPtr, &st) != 0)
+    {
+        return LE_OK;
+    }
+
+    if (S_ISDIR(st.st_mode))
+    {
+        LE_ERROR("Can't replace directory '%s' with a file.", pathPtr);
+        return LE_FAULT;
+    }
+
+    if (unlink(pathPtr) != 0)
+    {
+        LE_ERROR("Failed to remove '%s' (%m).", pathPtr);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets the extended attributes collected from the pax header on an entry.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t SetXattrs
+(
+    Extractor_t* exPtr,
+    int fd,                 ///< File descriptor of the entry, or -1 to use the path.
+    const char* pathPtr,
+    bool isSymlink
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t i;
+
+    for (i = 0; i < exPtr->numXattrs; i++)
+    {
+        const Xattr_t* xattrPtr = &exPtr->xattrs[i];
+        const void* valuePtr = exPtr->xattrData + xattrPtr->valueOffset;
+        int result;
+
+        if (fd != -1)
+        {
+            result = fsetxattr(fd, xattrPtr->name, valuePtr, xattrPtr->valueSize, 0);
+        }
+        else
+        {
+            result = lsetxattr(pathPtr, xattrPtr->name, valuePtr, xattrPtr->valueSize, 0);
+        }
+
+        if (result != 0)
+        {
+            // Not all file systems support attributes on symlinks.  That's not fatal.
+            if (isSymlink)
+            {
+                LE_WARN("Failed to set attribute '%s' on '%s' (%m).", xattrPtr->name, pathPtr);
+            }
+            else
+            {
+                LE_ERROR("Failed to set attribute '%s' on '%s' (%m).", xattrPtr->name, pathPtr);
+                return LE_FAULT;
+            }
+        }
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forgets the long names, size and extended attributes collected for an entry.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearEntryOverrides
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    exPtr->longName[0] = '\0';
+    exPtr->longLink[0] = '\0';
+    exPtr->hasSizeOverride = false;
+    exPtr->numXattrs = 0;
+    exPtr->xattrDataBytes = 0;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Adds an extended attribute to be set on the next entry.
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR if there are too many or they are too big.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AddXattr
+(
+    Extractor_t* exPtr,
+    const char* namePtr,
+    const uint8_t* valuePtr,
+    size_t valueSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t i;
+
+    // bsdtar stores each attribute twice (SCHILY and LIBARCHIVE records).
+    for (i = 0; i < exPtr->numXattrs; i++)
+    {
+        if (strcmp(exPtr->xattrs[i].name, namePtr) == 0)
+        {
+            return LE_OK;
+        }
+    }
+
+    if (   (exPtr->numXattrs >= MAX_XATTRS)
+        || (valueSize > sizeof(exPtr->xattrData) - exPtr->xattrDataBytes))
+    {
+        LE_ERROR("Too many extended attributes on tarball entry.");
+        return LE_FORMAT_ERROR;
+    }
+
+    Xattr_t* xattrPtr = &exPtr->xattrs[exPtr->numXattrs];
+
+    if (le_utf8_Copy(xattrPtr->name, namePtr, sizeof(xattrPtr->name), NULL) != LE_OK)
+    {
+        LE_ERROR("Extended attribute name '%s' too long.", namePtr);
+        return LE_FORMAT_ERROR;
+    }
+
+    memcpy(exPtr->xattrData + exPtr->xattrDataBytes, valuePtr, valueSize);
+    xattrPtr->valueOffset = exPtr->xattrDataBytes;
+    xattrPtr->valueSize = valueSize;
+
+    exPtr->xattrDataBytes += valueSize;
+    exPtr->numXattrs++;
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decodes base64 text in place.
+ *
+ * @return The number of decoded bytes, or -1 if the text is not valid base64.
+ */
+//--------------------------------------------------------------------------------------------------
+static ssize_t DecodeBase64
+(
+    char* textPtr,
+    size_t textSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    uint32_t bits = 0;
+    int numBits = 0;
+    size_t outSize = 0;
+    size_t i;
+
+    for (i = 0; (i < textSize) && (textPtr[i] != '='); i++)
+    {
+        const char* posPtr = memchr(alphabet, textPtr[i], sizeof(alphabet) - 1);
+
+        if (posPtr == NULL)
+        {
+            return -1;
+        }
+
+        bits = (bits << 6) | (uint32_t)(posPtr - alphabet);
+        numBits += 6;
+
+        if (numBits >= 8)
+        {
+            numBits -= 8;
+            textPtr[outSize++] = (char)((bits >> numBits) & 0xff);
+        }
+    }
+
+    return outSize;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Decodes a URL-encoded ("%XX") string in place.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DecodeUrl
+(
+    char* textPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char* outPtr = textPtr;
+
+    while (*textPtr != '\0')
+    {
+        unsigned int value;
+
+        if ((textPtr[0] == '%') && isxdigit(textPtr[1]) && isxdigit(textPtr[2])
+            && (sscanf(textPtr + 1, "%2x", &value) == 1))
+        {
+            *outPtr++ = (char)value;
+            textPtr += 3;
+        }
+        else
+        {
+            *outPtr++ = *textPtr++;
+        }
+    }
+
+    *outPtr = '\0';
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Processes a single "key=value" record of a pax extended header.
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ProcessPaxRecord
+(
+    Extractor_t* exPtr,
+    char* keyPtr,
+    char* valuePtr,
+    size_t valueSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    static const char schilyPrefix[] = "SCHILY.xattr.";
+    static const char libarchivePrefix[] = "LIBARCHIVE.xattr.";
+
+    if (strcmp(keyPtr, "path") == 0)
+    {
+        return (CopyField(exPtr->longName, sizeof(exPtr->longName), valuePtr, valueSize) == LE_OK)
+               ? LE_OK : LE_FORMAT_ERROR;
+    }
+
+    if (strcmp(keyPtr, "linkpath") == 0)
+    {
+        return (CopyField(exPtr->longLink, sizeof(exPtr->longLink), valuePtr, valueSize) == LE_OK)
+               ? LE_OK : LE_FORMAT_ERROR;
+    }
+
+    if (strcmp(keyPtr, "size") == 0)
+    {
+        char* endPtr;
+
+        valuePtr[valueSize] = '\0';
+        errno = 0;
+        exPtr->sizeOverride = strtoull(valuePtr, &endPtr, 10);
+
+        if ((errno != 0) || (endPtr == valuePtr) || (*endPtr != '\0'))
+        {
+            LE_ERROR("Invalid size '%s' in pax header.", valuePtr);
+            return LE_FORMAT_ERROR;
+        }
+
+        exPtr->hasSizeOverride = true;
+        return LE_OK;
+    }
+
+    if (strncmp(keyPtr, schilyPrefix, sizeof(schilyPrefix) - 1) == 0)
+    {
+        return AddXattr(exPtr,
+                        keyPtr + sizeof(schilyPrefix) - 1,
+                        (const uint8_t*)valuePtr,
+                        valueSize);
+    }
+
+    if (strncmp(keyPtr, libarchivePrefix, sizeof(libarchivePrefix) - 1) == 0)
+    {
+        char* namePtr = keyPtr + sizeof(libarchivePrefix) - 1;
+        ssize_t decodedSize = DecodeBase64(valuePtr, valueSize);
+
+        if (decodedSize < 0)
+        {
+            LE_ERROR("Invalid value for extended attribute '%s' in pax header.", namePtr);
+            return LE_FORMAT_ERROR;
+        }
+
+        DecodeUrl(namePtr);
+
+        return AddXattr(exPtr, namePtr, (const uint8_t*)valuePtr, decodedSize);
+    }
+
+    // Everything else (times, owners, etc.) is not restored.
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Parses a pax extended header.  Each record is "<length> <key>=<value>\n".
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ParsePaxHeader
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    size_t pos = 0;
+
+    while (pos < exPtr->metaBytes)
+    {
+        char* recordPtr = exPtr->metaBuf + pos;
+        size_t available = exPtr->metaBytes - pos;
+        size_t recordSize = 0;
+        size_t i = 0;
+
+        while ((i < available) && isdigit((unsigned char)recordPtr[i]))
+        {
+            recordSize = (recordSize * 10) + (recordPtr[i] - '0');
+            if (recordSize > available)
+            {
+                break;
+            }
+            i++;
+        }
+
+        if (   (i == 0) || (i >= available) || (recordPtr[i] != ' ')
+            || (recordSize > available) || (recordSize <= i + 1)
+            || (recordPtr[recordSize - 1] != '\n') )
+        {
+            LE_ERROR("Malformed pax header record.");
+            return LE_FORMAT_ERROR;
+        }
+
+        char* keyPtr = recordPtr + i + 1;
+        char* endPtr = recordPtr + recordSize - 1;
+        char* equalsPtr = memchr(keyPtr, '=', endPtr - keyPtr);
+
+        if (equalsPtr == NULL)
+        {
+            LE_ERROR("Malformed pax header record.");
+            return LE_FORMAT_ERROR;
+        }
+
+        *equalsPtr = '\0';
+
+        le_result_t result = ProcessPaxRecord(exPtr, keyPtr, equalsPtr + 1, endPtr - equalsPtr - 1);
+        if (result != LE_OK)
+        {
+            return result;
+        }
+
+        pos += recordSize;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Moves the tar layer on to the padding after the current entry's data.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SkipPadding
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    exPtr->dataRemaining = exPtr->padRemaining;
+    exPtr->padRemaining = 0;
+    exPtr->state = (exPtr->dataRemaining > 0) ? TAR_STATE_SKIP : TAR_STATE_HEADER;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finishes writing a regular file.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t FinishFile
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_result_t result = LE_OK;
+
+    if (fchmod(exPtr->fd, exPtr->mode) != 0)
+    {
+        LE_ERROR("Failed to set permissions of '%s' (%m).", exPtr->path);
+        result = LE_FAULT;
+    }
+    else
+    {
+        result = SetXattrs(exPtr, exPtr->fd, exPtr->path, false);
+    }
+
+    if ((result == LE_OK) && (exPtr->fileHandler != NULL))
+    {
+        uint8_t digest[EVP_MAX_MD_SIZE];
+        unsigned int digestSize = 0;
+
+        LE_ASSERT(EVP_DigestFinal_ex(exPtr->fileDigestPtr, digest, &digestSize) == 1);
+        exPtr->fileHandler(exPtr->fd, digest, digestSize, exPtr->fileHandlerContextPtr);
+    }
+
+    fd_Close(exPtr->fd);
+    exPtr->fd = -1;
+
+    ClearEntryOverrides(exPtr);
+    SkipPadding(exPtr);
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Finishes collecting a meta data entry (GNU long name/link or pax header).
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t FinishMetaData
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_result_t result = LE_OK;
+
+    exPtr->metaBuf[exPtr->metaBytes] = '\0';
+
+    switch (exPtr->metaType)
+    {
+        case 'L':
+            result = CopyField(exPtr->longName, sizeof(exPtr->longName),
+                               exPtr->metaBuf, exPtr->metaBytes);
+            break;
+
+        case 'K':
+            result = CopyField(exPtr->longLink, sizeof(exPtr->longLink),
+                               exPtr->metaBuf, exPtr->metaBytes);
+            break;
+
+        case 'x':
+            result = ParsePaxHeader(exPtr);
+            break;
+    }
+
+    SkipPadding(exPtr);
+
+    return (result == LE_OK) ? LE_OK : LE_FORMAT_ERROR;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Starts writing a regular file entry.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartFile
+(
+    Extractor_t* exPtr,
+    const char* pathPtr,
+    mode_t mode
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (RemoveExisting(pathPtr) != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC;
+    int fd = open(pathPtr, flags, S_IRUSR | S_IWUSR);
+
+    if ((fd == -1) && (errno == ENOENT) && (MakeParents(pathPtr) == LE_OK))
+    {
+        fd = open(pathPtr, flags, S_IRUSR | S_IWUSR);
+    }
+
+    if (fd == -1)
+    {
+        LE_ERROR("Failed to create '%s' (%m).", pathPtr);
+        return LE_FAULT;
+    }
+
+    exPtr->fd = fd;
+    exPtr->mode = mode;
+    LE_ASSERT(le_utf8_Copy(exPtr->path, pathPtr, sizeof(exPtr->path), NULL) == LE_OK);
+
+    if (exPtr->fileHandler != NULL)
+    {
+        LE_ASSERT(EVP_DigestInit_ex(exPtr->fileDigestPtr, EVP_sha256(), NULL) == 1);
+    }
+
+    exPtr->state = TAR_STATE_FILE_DATA;
+
+    if (exPtr->dataRemaining == 0)
+    {
+        return FinishFile(exPtr);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates a directory entry.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t MakeDirectory
+(
+    Extractor_t* exPtr,
+    const char* pathPtr,
+    mode_t mode
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (mkdir(pathPtr, S_IRWXU) != 0)
+    {
+        struct stat st;
+
+        if ((errno == ENOENT) && (MakeParents(pathPtr) == LE_OK) && (mkdir(pathPtr, S_IRWXU) == 0))
+        {
+            // Created after making its parents.
+        }
+        else if ((errno != EEXIST) || (lstat(pathPtr, &st) != 0) || !S_ISDIR(st.st_mode))
+        {
+            LE_ERROR("Failed to create directory '%s' (%m).", pathPtr);
+            return LE_FAULT;
+        }
+    }
+
+    if (chmod(pathPtr, mode) != 0)
+    {
+        LE_ERROR("Failed to set permissions of '%s' (%m).", pathPtr);
+        return LE_FAULT;
+    }
+
+    return SetXattrs(exPtr, -1, pathPtr, false);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates a symlink or hard link entry.
+ *
+ * @return LE_OK if successful, LE_FAULT or LE_FORMAT_ERROR otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t MakeLink
+(
+    Extractor_t* exPtr,
+    const char* pathPtr,
+    const char* linkNamePtr,
+    bool isSymlink
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (RemoveExisting(pathPtr) != LE_OK)
+    {
+        return LE_FAULT;
+    }
+
+    if (isSymlink)
+    {
+        if (   (symlink(linkNamePtr, pathPtr) != 0)
+            && ((errno != ENOENT) || (MakeParents(pathPtr) != LE_OK)
+                || (symlink(linkNamePtr, pathPtr) != 0)) )
+        {
+            LE_ERROR("Failed to create symlink '%s' -> '%s' (%m).", pathPtr, linkNamePtr);
+            return LE_FAULT;
+        }
+
+        exPtr->hasSymlinks = true;
+
+        return SetXattrs(exPtr, -1, pathPtr, true);
+    }
+
+    // Hard link targets are names of earlier entries in the same tarball.  They get the same
+    // checks as entry names, otherwise a symlink extracted earlier could be used to link to a
+    // file outside the unpack directory.
+    char targetPath[LIMIT_MAX_PATH_BYTES];
+
+    le_result_t result = MakeDestPath(exPtr, linkNamePtr, targetPath, sizeof(targetPath));
+    if (result == LE_OK)
+    {
+        result = CheckParents(exPtr, targetPath);
+    }
+    if (result != LE_OK)
+    {
+        return result;
+    }
+
+    if (link(targetPath, pathPtr) != 0)
+    {
+        LE_ERROR("Failed to create hard link '%s' -> '%s' (%m).", pathPtr, targetPath);
+        return LE_FAULT;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Processes a complete header block.
+ *
+ * @return LE_OK if successful, LE_FORMAT_ERROR or LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ProcessHeader
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    const uint8_t* hdrPtr = exPtr->header;
+
+    // A zero block marks the end of the archive.  Anything after it (the second zero block and
+    // the record padding) is ignored.
+    if (IsZeroBlock(hdrPtr))
+    {
+        exPtr->state = TAR_STATE_END;
+        return LE_OK;
+    }
+
+    if (!IsChecksumValid(hdrPtr))
+    {
+        LE_ERROR("Bad tarball header checksum.");
+        return LE_FORMAT_ERROR;
+    }
+
+    uint64_t size;
+    uint64_t mode;
+
+    if (   !ParseNumber(hdrPtr + HDR_SIZE_OFFSET, HDR_SIZE_SIZE, &size)
+        || !ParseNumber(hdrPtr + HDR_MODE_OFFSET, HDR_MODE_SIZE, &mode) )
+    {
+        LE_ERROR("Bad numeric field in tarball header.");
+        return LE_FORMAT_ERROR;
+    }
+
+    char type = (char)hdrPtr[HDR_TYPE_OFFSET];
+
+    if (exPtr->hasSizeOverride && (type != 'x') && (type != 'g'))
+    {
+        size = exPtr->sizeOverride;
+    }
+
+    exPtr->dataRemaining = size;
+    exPtr->padRemaining = (TAR_BLOCK_BYTES - (size % TAR_BLOCK_BYTES)) % TAR_BLOCK_BYTES;
+
+    // Meta data entries apply to the entry that follows them.
+    if ((type == 'L') || (type == 'K') || (type == 'x'))
+    {
+        if (size > MAX_META_BYTES)
+        {
+            LE_ERROR("Tarball meta data entry too big (%" PRIu64 " bytes).", size);
+            return LE_FORMAT_ERROR;
+        }
+
+        exPtr->metaType = type;
+        exPtr->metaBytes = 0;
+        exPtr->state = TAR_STATE_META_DATA;
+
+        return (size == 0) ? FinishMetaData(exPtr) : LE_OK;
+    }
+
+    // Global pax headers aren't needed.
+    if (type == 'g')
+    {
+        exPtr->dataRemaining += exPtr->padRemaining;
+        exPtr->padRemaining = 0;
+        exPtr->state = (exPtr->dataRemaining > 0) ? TAR_STATE_SKIP : TAR_STATE_HEADER;
+        return LE_OK;
+    }
+
+    // Work out the entry's name and link name.
+    char name[LIMIT_MAX_PATH_BYTES];
+    char linkName[LIMIT_MAX_PATH_BYTES];
+
+    if (exPtr->longName[0] != '\0')
+    {
+        LE_ASSERT(le_utf8_Copy(name, exPtr->longName, sizeof(name), NULL) == LE_OK);
+    }
+    else
+    {
+        size_t prefixLen = 0;
+
+        // Only POSIX ustar headers have a prefix field.
+        if (memcmp(hdrPtr + HDR_MAGIC_OFFSET, "ustar\0", 6) == 0)
+        {
+            prefixLen = strnlen((const char*)hdrPtr + HDR_PREFIX_OFFSET, HDR_PREFIX_SIZE);
+        }
+
+        if (prefixLen > 0)
+        {
+            snprintf(name, sizeof(name), "%.*s/%.*s",
+                     (int)prefixLen, (const char*)hdrPtr + HDR_PREFIX_OFFSET,
+                     HDR_NAME_SIZE, (const char*)hdrPtr + HDR_NAME_OFFSET);
+        }
+        else
+        {
+            CopyField(name, sizeof(name), (const char*)hdrPtr + HDR_NAME_OFFSET, HDR_NAME_SIZE);
+        }
+    }
+
+    if (exPtr->longLink[0] != '\0')
+    {
+        LE_ASSERT(le_utf8_Copy(linkName, exPtr->longLink, sizeof(linkName), NULL) == LE_OK);
+    }
+    else
+    {
+        CopyField(linkName, sizeof(linkName),
+                  (const char*)hdrPtr + HDR_LINKNAME_OFFSET, HDR_LINKNAME_SIZE);
+    }
+
+    char path[LIMIT_MAX_PATH_BYTES];
+
+    le_result_t result = MakeDestPath(exPtr, name, path, sizeof(path));
+    if (result == LE_OK)
+    {
+        result = CheckParents(exPtr, path);
+    }
+    if (result != LE_OK)
+    {
+        return result;
+    }
+
+    mode &= (S_ISUID | S_ISGID | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO);
+
+    switch (type)
+    {
+        case '0':
+        case '\0':
+        case '7':
+            // Regular file.  The data follows.
+            return StartFile(exPtr, path, mode);
+
+        case '5':
+            result = MakeDirectory(exPtr, path, mode);
+            break;
+
+        case '2':
+            result = MakeLink(exPtr, path, linkName, true);
+            break;
+
+        case '1':
+            result = MakeLink(exPtr, path, linkName, false);
+            break;
+
+        default:
+            LE_ERROR("Unsupported type '%c' for tarball entry '%s'.", type, name);
+            return LE_FORMAT_ERROR;
+    }
+
+    // Entries other than regular files have no data of their own.
+    ClearEntryOverrides(exPtr);
+    exPtr->dataRemaining += exPtr->padRemaining;
+    exPtr->padRemaining = 0;
+    exPtr->state = (exPtr->dataRemaining > 0) ? TAR_STATE_SKIP : TAR_STATE_HEADER;
+
+    return result;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds uncompressed tarball bytes to the tar layer.
+ *
+ * @return LE_OK if successful, or the error code.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteTar
+(
+    Extractor_t* exPtr,
+    const uint8_t* bufPtr,
+    size_t bufSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    exPtr->tarBytes += bufSize;
+
+    while (bufSize > 0)
+    {
+        size_t used = bufSize;
+        le_result_t result = LE_OK;
+
+        switch (exPtr->state)
+        {
+            case TAR_STATE_HEADER:
+
+                if (used > TAR_BLOCK_BYTES - exPtr->headerBytes)
+                {
+                    used = TAR_BLOCK_BYTES - exPtr->headerBytes;
+                }
+                memcpy(exPtr->header + exPtr->headerBytes, bufPtr, used);
+                exPtr->headerBytes += used;
+
+                if (exPtr->headerBytes == TAR_BLOCK_BYTES)
+                {
+                    exPtr->headerBytes = 0;
+                    result = ProcessHeader(exPtr);
+                }
+                break;
+
+            case TAR_STATE_FILE_DATA:
+
+                if (used > exPtr->dataRemaining)
+                {
+                    used = exPtr->dataRemaining;
+                }
+                if (fd_WriteSize(exPtr->fd, (void*)bufPtr, used) != (ssize_t)used)
+                {
+                    LE_ERROR("Failed to write to '%s' (%m).", exPtr->path);
+                    result = LE_FAULT;
+                    break;
+                }
+                if (exPtr->fileHandler != NULL)
+                {
+                    EVP_DigestUpdate(exPtr->fileDigestPtr, bufPtr, used);
+                }
+                exPtr->dataRemaining -= used;
+
+                if (exPtr->dataRemaining == 0)
+                {
+                    result = FinishFile(exPtr);
+                }
+                break;
+
+            case TAR_STATE_META_DATA:
+
+                if (used > exPtr->dataRemaining)
+                {
+                    used = exPtr->dataRemaining;
+                }
+                memcpy(exPtr->metaBuf + exPtr->metaBytes, bufPtr, used);
+                exPtr->metaBytes += used;
+                exPtr->dataRemaining -= used;
+
+                if (exPtr->dataRemaining == 0)
+                {
+                    result = FinishMetaData(exPtr);
+                }
+                break;
+
+            case TAR_STATE_SKIP:
+
+                if (used > exPtr->dataRemaining)
+                {
+                    used = exPtr->dataRemaining;
+                }
+                exPtr->dataRemaining -= used;
+
+                if (exPtr->dataRemaining == 0)
+                {
+                    exPtr->state = TAR_STATE_HEADER;
+                }
+                break;
+
+            case TAR_STATE_END:
+
+                // Ignore the rest.
+                return LE_OK;
+
+            case TAR_STATE_ERROR:
+
+                return exPtr->error;
+        }
+
+        if (result != LE_OK)
+        {
+            return SetError(exPtr, result);
+        }
+
+        bufPtr += used;
+        bufSize -= used;
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Detects the compression from the first bytes of data and initializes the decoder.
+ *
+ * @return LE_OK if successful, LE_FAULT otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartDecoder
+(
+    Extractor_t* exPtr
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (memcmp(exPtr->magic, "BZh", 3) == 0)
+    {
+        exPtr->compression = COMPRESSION_BZIP2;
+
+        memset(&exPtr->bzStream, 0, sizeof(exPtr->bzStream));
+        if (BZ2_bzDecompressInit(&exPtr->bzStream, 0, 0) != BZ_OK)
+        {
+            LE_ERROR("Failed to initialize bzip2 decoder.");
+            return LE_FAULT;
+        }
+    }
+    else if ((exPtr->magic[0] == 0x1f) && (exPtr->magic[1] == 0x8b))
+    {
+        exPtr->compression = COMPRESSION_GZIP;
+
+        memset(&exPtr->zStream, 0, sizeof(exPtr->zStream));
+        if (inflateInit2(&exPtr->zStream, 16 + MAX_WBITS) != Z_OK)
+        {
+            LE_ERROR("Failed to initialize gzip decoder.");
+            return LE_FAULT;
+        }
+    }
+    else
+    {
+        // Anything else had better be a plain tarball.  The tar layer will reject it if not.
+        exPtr->compression = COMPRESSION_NONE;
+        return LE_OK;
+    }
+
+    exPtr->isDecoderInit = true;
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds bzip2 compressed data to the decoder and the decoded data to the tar layer.
+ *
+ * @return LE_OK if successful, or the error code.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteBzip2
+(
+    Extractor_t* exPtr,
+    const uint8_t* bufPtr,
+    size_t bufSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    bz_stream* streamPtr = &exPtr->bzStream;
+
+    streamPtr->next_in = (char*)bufPtr;
+    streamPtr->avail_in = bufSize;
+
+    do
+    {
+        // Data after the end of a stream is another stream (e.g., from a parallel compressor).
+        if (exPtr->isStreamEnd)
+        {
+            char* nextInPtr = streamPtr->next_in;
+            unsigned int availIn = streamPtr->avail_in;
+
+            BZ2_bzDecompressEnd(streamPtr);
+            memset(streamPtr, 0, sizeof(*streamPtr));
+            if (BZ2_bzDecompressInit(streamPtr, 0, 0) != BZ_OK)
+            {
+                exPtr->isDecoderInit = false;
+                return SetError(exPtr, LE_FAULT);
+            }
+            streamPtr->next_in = nextInPtr;
+            streamPtr->avail_in = availIn;
+            exPtr->isStreamEnd = false;
+        }
+
+        streamPtr->next_out = (char*)exPtr->outBuf;
+        streamPtr->avail_out = sizeof(exPtr->outBuf);
+
+        int bzResult = BZ2_bzDecompress(streamPtr);
+
+        if (bzResult == BZ_STREAM_END)
+        {
+            exPtr->isStreamEnd = true;
+        }
+        else if (bzResult != BZ_OK)
+        {
+            LE_ERROR("bzip2 decompression failed (%d).", bzResult);
+            return SetError(exPtr, LE_FORMAT_ERROR);
+        }
+
+        le_result_t result = WriteTar(exPtr,
+                                      exPtr->outBuf,
+                                      sizeof(exPtr->outBuf) - streamPtr->avail_out);
+        if ((result != LE_OK) || (exPtr->state == TAR_STATE_END))
+        {
+            return result;
+        }
+    }
+    while ((streamPtr->avail_in > 0) || ((streamPtr->avail_out == 0) && !exPtr->isStreamEnd));
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds gzip compressed data to the decoder and the decoded data to the tar layer.
+ *
+ * @return LE_OK if successful, or the error code.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t WriteGzip
+(
+    Extractor_t* exPtr,
+    const uint8_t* bufPtr,
+    size_t bufSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    z_stream* streamPtr = &exPtr->zStream;
+
+    streamPtr->next_in = (Bytef*)bufPtr;
+    streamPtr->avail_in = bufSize;
+
+    do
+    {
+        // Data after the end of a gzip member is another member.
+        if (exPtr->isStreamEnd)
+        {
+            if (inflateReset(streamPtr) != Z_OK)
+            {
+                return SetError(exPtr, LE_FAULT);
+            }
+            exPtr->isStreamEnd = false;
+        }
+
+        streamPtr->next_out = exPtr->outBuf;
+        streamPtr->avail_out = sizeof(exPtr->outBuf);
+
+        int zResult = inflate(streamPtr, Z_NO_FLUSH);
+
+        if (zResult == Z_STREAM_END)
+        {
+            exPtr->isStreamEnd = true;
+        }
+        else if ((zResult != Z_OK) && (zResult != Z_BUF_ERROR))
+        {
+            LE_ERROR("gzip decompression failed (%d).", zResult);
+            return SetError(exPtr, LE_FORMAT_ERROR);
+        }
+
+        le_result_t result = WriteTar(exPtr,
+                                      exPtr->outBuf,
+                                      sizeof(exPtr->outBuf) - streamPtr->avail_out);
+        if ((result != LE_OK) || (exPtr->state == TAR_STATE_END))
+        {
+            return result;
+        }
+
+        // No progress possible until more input arrives.
+        if (zResult == Z_BUF_ERROR)
+        {
+            break;
+        }
+    }
+    while ((streamPtr->avail_in > 0) || ((streamPtr->avail_out == 0) && !exPtr->isStreamEnd));
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds data to the decompression layer.
+ *
+ * @return LE_OK if successful, or the error code.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t Decompress
+(
+    Extractor_t* exPtr,
+    const uint8_t* bufPtr,
+    size_t bufSize
+)
+//--------------------------------------------------------------------------------------------------
+{
+    // Once the end of the archive has been reached, there's nothing left worth decompressing.
+    if ((bufSize == 0) || (exPtr->state == TAR_STATE_END))
+    {
+        return LE_OK;
+    }
+
+    switch (exPtr->compression)
+    {
+        case COMPRESSION_BZIP2:
+            return WriteBzip2(exPtr, bufPtr, bufSize);
+
+        case COMPRESSION_GZIP:
+            return WriteGzip(exPtr, bufPtr, bufSize);
+
+        case COMPRESSION_NONE:
+            return WriteTar(exPtr, bufPtr, bufSize);
+
+        case COMPRESSION_UNKNOWN:
+            break;
+    }
+
+    LE_FATAL("Invalid compression %d.", exPtr->compression);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the module.  Must be called before any other function in this module.
+ */
+//--------------------------------------------------------------------------------------------------
+void untar_Init
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    ExtractorPool = le_mem_CreatePool("Untar", sizeof(Extractor_t));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates an extractor that unpacks a tarball into a given directory.
+ *
+ * @return Reference to the extractor.
+ */
+//--------------------------------------------------------------------------------------------------
+untar_Ref_t untar_Create
+(
+    const char* dirPath         ///< [IN] Directory to unpack into.  Must already exist.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Extractor_t* exPtr = le_mem_ForceAlloc(ExtractorPool);
+
+    LE_ASSERT(le_utf8_Copy(exPtr->dirPath, dirPath, sizeof(exPtr->dirPath), NULL) == LE_OK);
+
+    exPtr->compression = COMPRESSION_UNKNOWN;
+    exPtr->magicBytes = 0;
+    exPtr->isDecoderInit = false;
+    exPtr->isStreamEnd = false;
+    exPtr->tarBytes = 0;
+    exPtr->state = TAR_STATE_HEADER;
+    exPtr->error = LE_OK;
+    exPtr->headerBytes = 0;
+    exPtr->dataRemaining = 0;
+    exPtr->padRemaining = 0;
+    exPtr->hasSymlinks = false;
+    exPtr->fd = -1;
+    exPtr->fileHandler = NULL;
+    exPtr->fileHandlerContextPtr = NULL;
+    exPtr->fileDigestPtr = NULL;
+
+    ClearEntryOverrides(exPtr);
+
+    return exPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets a function to be called each time an extractor has finished writing a regular file.  The
+ * content of the regular files is then hashed as it is written, so it doesn't have to be read back
+ * from the file system.  Must be called before any data is fed to the extractor.
+ */
+//--------------------------------------------------------------------------------------------------
+void untar_SetFileHandler
+(
+    untar_Ref_t untarRef,               ///< [IN] Extractor.
+    untar_FileHandler_t handlerFunc,    ///< [IN] Function to call.
+    void* contextPtr                    ///< [IN] Passed to the function.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Extractor_t* exPtr = untarRef;
+
+    LE_ASSERT(exPtr->tarBytes == 0);
+
+    if (exPtr->fileDigestPtr == NULL)
+    {
+        exPtr->fileDigestPtr = EVP_MD_CTX_create();
+        LE_ASSERT(exPtr->fileDigestPtr != NULL);
+    }
+
+    exPtr->fileHandler = handlerFunc;
+    exPtr->fileHandlerContextPtr = contextPtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds the next part of the (possibly compressed) tarball to an extractor.
+ *
+ * @return
+ *      - LE_OK if successful.
+ *      - LE_FORMAT_ERROR if the data is not a valid tarball.
+ *      - LE_FAULT if an entry could not be written to the file system.
+ *
+ * @note Once an error has been returned, the extractor rejects all further data.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t untar_Write
+(
+    untar_Ref_t untarRef,       ///< [IN] Extractor.
+    const uint8_t* bufPtr,      ///< [IN] Data.
+    size_t bufSize              ///< [IN] Number of bytes of data.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Extractor_t* exPtr = untarRef;
+
+    if (exPtr->state == TAR_STATE_ERROR)
+    {
+        return exPtr->error;
+    }
+
+    if (exPtr->compression == COMPRESSION_UNKNOWN)
+    {
+        while ((bufSize > 0) && (exPtr->magicBytes < sizeof(exPtr->magic)))
+        {
+            exPtr->magic[exPtr->magicBytes++] = *bufPtr++;
+            bufSize--;
+        }
+
+        if (exPtr->magicBytes < sizeof(exPtr->magic))
+        {
+            return LE_OK;
+        }
+
+        le_result_t result = StartDecoder(exPtr);
+        if (result == LE_OK)
+        {
+            result = Decompress(exPtr, exPtr->magic, exPtr->magicBytes);
+        }
+        if (result != LE_OK)
+        {
+            return SetError(exPtr, result);
+        }
+    }
+
+    return Decompress(exPtr, bufPtr, bufSize);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks that a complete tarball has been fed to an extractor.
+ *
+ * @return
+ *      - LE_OK if the end of the tarball has been reached.
+ *      - LE_FORMAT_ERROR if the tarball was truncated or an error happened earlier.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t untar_Finish
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Extractor_t* exPtr = untarRef;
+
+    if (exPtr->state == TAR_STATE_ERROR)
+    {
+        return exPtr->error;
+    }
+
+    if (exPtr->state != TAR_STATE_END)
+    {
+        LE_ERROR("Tarball truncated after %zu bytes.", exPtr->tarBytes);
+        return SetError(exPtr, LE_FORMAT_ERROR);
+    }
+
+    return LE_OK;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name of the compression format detected by an extractor ("bzip2", "gzip", "none" or
+ * "unknown" if not enough data has been fed yet).
+ */
+//--------------------------------------------------------------------------------------------------
+const char* untar_GetCompressionName
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    switch (untarRef->compression)
+    {
+        case COMPRESSION_BZIP2:
+            return "bzip2";
+
+        case COMPRESSION_GZIP:
+            return "gzip";
+
+        case COMPRESSION_NONE:
+            return "none";
+
+        case COMPRESSION_UNKNOWN:
+            break;
+    }
+
+    return "unknown";
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of (uncompressed) bytes of tarball an extractor has processed.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t untar_GetTarBytes
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return untarRef->tarBytes;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deletes an extractor.  Any partially written file is closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void untar_Delete
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    Extractor_t* exPtr = untarRef;
+
+    if (exPtr->fd != -1)
+    {
+        fd_Close(exPtr->fd);
+    }
+
+    if (exPtr->fileDigestPtr != NULL)
+    {
+        EVP_MD_CTX_destroy(exPtr->fileDigestPtr);
+    }
+
+    if (exPtr->isDecoderInit)
+    {
+        if (exPtr->compression == COMPRESSION_BZIP2)
+        {
+            BZ2_bzDecompressEnd(&exPtr->bzStream);
+        }
+        else if (exPtr->compression == COMPRESSION_GZIP)
+        {
+            inflateEnd(&exPtr->zStream);
+        }
+    }
+
+    le_mem_Release(exPtr);
+}
@@ -0,0 +1,157 @@
+//--------------------------------------------------------------------------------------------------
+/**
+ * @file untar.h
+ *
+ * Streaming tarball extractor used by the Update Unpacker to unpack update pack payloads inside
+ * the Update Daemon, rather than piping them to a separate tar process.
+ *
+ * The payload is fed to the extractor as it is read from the update pack.  The compression is
+ * detected from the first bytes of the payload: bzip2 (the format produced by the mk tools),
+ * gzip (much faster to decompress on the target) and uncompressed tarballs are supported.
+ *
+ * Entries are extracted the way "bsdtar xmop" would: permissions are restored, but ownership and
+ * modification times are not.  Extended attributes (e.g., IMA signatures) stored in pax headers
+ * are restored.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+//--------------------------------------------------------------------------------------------------
+
+#ifndef LEGATO_UNTAR_H_INCLUDE_GUARD
+#define LEGATO_UNTAR_H_INCLUDE_GUARD
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Reference to a tarball extractor.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct untar_Extractor* untar_Ref_t;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Function called by an extractor each time it has finished writing a regular file.
+ *
+ * The digest is the SHA-256 of the content of the file, computed while the file was written.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef void (*untar_FileHandler_t)
+(
+    int fd,                     ///< [IN] File, with its permissions and extended attributes set.
+                                ///       It is closed once the function returns.
+    const uint8_t* digestPtr,   ///< [IN] Digest of the content of the file.
+    size_t digestSize,          ///< [IN] Number of bytes in the digest.
+    void* contextPtr            ///< [IN] Context given to untar_SetFileHandler().
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the module.  Must be called before any other function in this module.
+ */
+//--------------------------------------------------------------------------------------------------
+void untar_Init
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Creates an extractor that unpacks a tarball into a given directory.
+ *
+ * @return Reference to the extractor.
+ */
+//--------------------------------------------------------------------------------------------------
+untar_Ref_t untar_Create
+(
+    const char* dirPath         ///< [IN] Directory to unpack into.  Must already exist.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Sets a function to be called each time an extractor has finished writing a regular file.  The
+ * content of the regular files is then hashed as it is written, so it doesn't have to be read back
+ * from the file system.  Must be called before any data is fed to the extractor.
+ */
+//--------------------------------------------------------------------------------------------------
+void untar_SetFileHandler
+(
+    untar_Ref_t untarRef,               ///< [IN] Extractor.
+    untar_FileHandler_t handlerFunc,    ///< [IN] Function to call.
+    void* contextPtr                    ///< [IN] Passed to the function.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Feeds the next part of the (possibly compressed) tarball to an extractor.
+ *
+ * @return
+ *      - LE_OK if successful.
+ *      - LE_FORMAT_ERROR if the data is not a valid tarball.
+ *      - LE_FAULT if an entry could not be written to the file system.
+ *
+ * @note Once an error has been returned, the extractor rejects all further data.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t untar_Write
+(
+    untar_Ref_t untarRef,       ///< [IN] Extractor.
+    const uint8_t* bufPtr,      ///< [IN] Data.
+    size_t bufSize              ///< [IN] Number of bytes of data.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks that a complete tarball has been fed to an extractor.
+ *
+ * @return
+ *      - LE_OK if the end of the tarball has been reached.
+ *      - LE_FORMAT_ERROR if the tarball was truncated or an error happened earlier.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t untar_Finish
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the name of the compression format detected by an extractor ("bzip2", "gzip", "none" or
+ * "unknown" if not enough data has been fed yet).
+ */
+//--------------------------------------------------------------------------------------------------
+const char* untar_GetCompressionName
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the number of (uncompressed) bytes of tarball an extractor has processed.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t untar_GetTarBytes
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Deletes an extractor.  Any partially written file is closed.
+ */
+//--------------------------------------------------------------------------------------------------
+void untar_Delete
+(
+    untar_Ref_t untarRef        ///< [IN] Extractor.
+);
+
+
+#endif // LEGATO_UNTAR_H_INCLUDE_GUARD
@@ -52,6 +52,8 @@
 #include "properties.h"
 #include "fsSys.h"
 #include "ima.h"
+#include "sandboxPlan.h"
+#include "untar.h"
 #include "file.h"
 
 // Default probation period.
@@ -68,6 +70,15 @@
 #define MAX_CFGTREE_NAME_BYTES   LIMIT_MAX_USER_NAME_BYTES
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Config node that allows a system update to be resumed part-way through the update pack.  Only
+ * set this on platforms whose security-unpack doesn't need the whole update pack to verify it.
+ */
+//--------------------------------------------------------------------------------------------------
+#define CFG_PARTIAL_RESUME "system:/updateDaemon/partialResume"
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * State of the Update Daemon state machine.
@@ -116,6 +127,17 @@ le_timer_Ref_t ProbationTimer;
 static le_msg_SessionRef_t IpcSession = NULL;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * The IPC Session Reference for the IPC session that last called le_update_GetResumePosition(),
+ * and the position it was given.  The next update started by that session reads the update pack
+ * from that position.  NULL if no position was asked for.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_msg_SessionRef_t ResumeSession = NULL;
+static size_t ResumePosition = 0;
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Reference to the security-unpack process pipeline, or NULL if the pipeline doesn't exist.
@@ -288,6 +310,28 @@ static bool IsValidFileDesc
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an interrupted system update can be resumed part-way through the update pack.
+ *
+ * security-unpack only sees the part of the update pack that is sent again, so its verdict can't
+ * cover the sections unpacked by the earlier attempt unless the platform says it doesn't need to
+ * see them.  Otherwise the whole update pack has to be sent again: the sections already unpacked
+ * are then checked against it rather than unpacked again.
+ *
+ * @return true if the update pack can be resumed part-way through.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsPartialResumeAllowed
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return le_cfg_QuickGetBool(CFG_PARTIAL_RESUME, false);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function that runs in the security-unpack child process inside the pipeline.
@@ -423,6 +467,12 @@ static void UpdateFailed
     {
         ErrorCode = errCode;
     }
+
+    // Don't resume from a rejected update pack.
+    if ((errCode == LE_UPDATE_ERR_BAD_PACKAGE) || (errCode == LE_UPDATE_ERR_SECURITY_FAILURE))
+    {
+        updateUnpack_ForgetCheckpoint();
+    }
 }
 
 
@@ -496,6 +546,7 @@ static le_result_t InstallSystemApps
                     if (result != LE_OK)
                     {
                         fts_close(ftsPtr);
+                        app_DiscardQueuedInstallJobs();
                         LE_CRIT("Failed to get 'app.md5' from '%s'", appPropertyPath);
                         return LE_FAULT;
                     }
@@ -507,43 +558,14 @@ static le_result_t InstallSystemApps
                     if (result != LE_OK)
                     {
                         fts_close(ftsPtr);
+                        app_DiscardQueuedInstallJobs();
                         LE_CRIT("Failed to get 'app.name' from '%s'", appPropertyPath);
                         return LE_FAULT;
                     }
 
-
-                    char appPath[LIMIT_MAX_PATH_BYTES];
-
-                    LE_ASSERT(snprintf(appPath,
-                                       sizeof(appPath),
-                                       "/legato/apps/%s",
-                                       appMd5Hash)
-                                       < sizeof(appPath));
-
-                    (void)unlink(appPath);
-
-                    LE_DEBUG("Renaming '%s' to '%s'",
-                             entPtr->fts_path,
-                             appPath);
-
-                    if (rename(entPtr->fts_path, appPath) != 0)
-                    {
-                        fts_close(ftsPtr);
-                        LE_CRIT("Failed to rename '%s' to '%s', %m.",
-                                app_UnpackPath,
-                                appPath);
-                        return LE_FAULT;
-                    }
-
-                    // Now setup the smack permission.
-                    if (app_SetSmackPermReadOnly(appMd5Hash, appName) != LE_OK)
-                    {
-                        fts_close(ftsPtr);
-                        LE_CRIT("Failed to setup smack permission for app '%s<%s>'",
-                                appName,
-                                appMd5Hash);
-                        return LE_FAULT;
-                    }
+                    // Moving the app to /legato/apps/<hash> and setting up its SMACK labels only
+                    // touches the app's own files, so the apps are done in parallel below.
+                    app_QueueMoveUnpacked(entPtr->fts_path, appMd5Hash, appName);
                     // We don't need to go into this directory.
                     fts_set(ftsPtr, entPtr, FTS_SKIP);
                 }
@@ -567,7 +589,7 @@ static le_result_t InstallSystemApps
 
     fts_close(ftsPtr);
 
-    return LE_OK;
+    return app_RunQueuedInstallJobs();
 }
 
 
@@ -622,14 +644,16 @@ static le_result_t SetupSystemAppsWritable
                 LE_DEBUG("Path '%s' AppName '%s', MD5 '%s'", entPtr->fts_path, appName, appMd5Buf);
 
                 // Set up the app's writeable files in the new system (copying from install dir and/or
-                // current system).
-                if (app_SetUpAppWriteables(appMd5Buf, appName) != LE_OK)
+                // current system).  The files of all the apps are copied in parallel below.
+                if (app_QueueAppWriteables(appMd5Buf, appName) != LE_OK)
                 {
                     if (ftsPtr)
                     {
                        fts_close(ftsPtr);
                     }
 
+                    app_DiscardQueuedInstallJobs();
+
                     LE_CRIT("Failed to setup writable for app '%s<%s>'",
                             appName,
                             appMd5Buf);
@@ -652,10 +676,50 @@ static le_result_t SetupSystemAppsWritable
        fts_close(ftsPtr);
     }
 
+    return app_RunQueuedInstallJobs();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Waits for the IMA signature verification of a batch of files to finish, and reports how long it
+ * took.
+ *
+ * @return
+ *      - LE_OK on success
+ *      - LE_FAULT otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CompleteVerifyBatch
+(
+    ima_BatchRef_t batchRef,        ///< [IN] Batch.
+    const char* dirPath,            ///< [IN] Directory holding the files of the batch.
+    le_clk_Time_t startTime         ///< [IN] Time the batch was created.
+)
+{
+    ima_BatchStats_t stats;
+    le_clk_Time_t elapsed;
+
+    if (LE_OK != ima_CompleteBatch(batchRef, &stats))
+    {
+        LE_CRIT("Failed to verify files in '%s'", dirPath);
+        return LE_FAULT;
+    }
+
+    elapsed = le_clk_Sub(le_clk_GetRelativeTime(), startTime);
+
+    if (stats.fileCount > 0)
+    {
+        LE_INFO("Verified %zu files of '%s' (%zu already verified) in %ld ms.",
+                stats.fileCount, dirPath, stats.cachedCount,
+                (long)(elapsed.sec * 1000 + elapsed.usec / 1000));
+    }
+
     return LE_OK;
 }
 
 
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Recursively traverse the directory and verify each file IMA signature against the public
@@ -743,7 +807,8 @@ le_result_t  VerifyUnpackedSystem
         return LE_FAULT;
     }
 
-    // Now traverse the system app unpack directory and verify each app files
+    // Now traverse the system app unpack directory and verify each app files.  The files of each
+    // app are verified in parallel, as one batch.
     char* pathArrayPtr[] = {(char *)app_UnpackPath,
                                 NULL};
 
@@ -761,6 +826,11 @@ le_result_t  VerifyUnpackedSystem
     // Traverse through the directory tree.
     FTSENT* entPtr;
     char appPubCertPath[LIMIT_MAX_PATH_BYTES] = "";
+    char batchDir[LIMIT_MAX_PATH_BYTES] = "";
+    ima_BatchRef_t batchRef = ima_CreateBatch();
+    le_clk_Time_t batchStartTime = le_clk_GetRelativeTime();
+
+    LE_ASSERT(LE_OK == le_utf8_Copy(batchDir, app_UnpackPath, sizeof(batchDir), NULL));
 
     while (NULL != (entPtr = fts_read(ftsPtr)))
     {
@@ -773,6 +843,19 @@ le_result_t  VerifyUnpackedSystem
             case FTS_D:
                 if (1 == entPtr->fts_level)
                 {
+                    result = CompleteVerifyBatch(batchRef, batchDir, batchStartTime);
+
+                    if (LE_OK != result)
+                    {
+                        fts_close(ftsPtr);
+                        return LE_FAULT;
+                    }
+
+                    batchRef = ima_CreateBatch();
+                    batchStartTime = le_clk_GetRelativeTime();
+                    LE_ASSERT(LE_OK == le_utf8_Copy(batchDir, entPtr->fts_path,
+                                                    sizeof(batchDir), NULL));
+
                     snprintf(appPubCertPath,
                              sizeof(appPubCertPath),
                              "%s/%s",
@@ -786,6 +869,7 @@ le_result_t  VerifyUnpackedSystem
                         {
                             LE_CRIT("Failed to import public certificate '%s'", appPubCertPath);
                             fts_close(ftsPtr);
+                            ima_CompleteBatch(batchRef, NULL);
                             return LE_FAULT;
                         }
                     }
@@ -805,19 +889,20 @@ le_result_t  VerifyUnpackedSystem
                 // certificate should be ok.
                 if (file_Exists(appPubCertPath))
                 {
-                    result = ima_VerifyFile(entPtr->fts_accpath, appPubCertPath);
+                    result = ima_AddToBatch(batchRef, entPtr->fts_accpath, appPubCertPath);
                 }
                 else
                 {
-                    result = ima_VerifyFile(entPtr->fts_accpath, path);
+                    result = ima_AddToBatch(batchRef, entPtr->fts_accpath, path);
                 }
 
                 if (LE_OK != result)
                 {
-                    LE_CRIT("Failed to verify file '%s' with public certificate '%s'",
-                            entPtr->fts_accpath,
+                    LE_CRIT("Failed to verify files in '%s' with public certificate '%s'",
+                            batchDir,
                             file_Exists(appPubCertPath) ? appPubCertPath : path);
                     fts_close(ftsPtr);
+                    ima_CompleteBatch(batchRef, NULL);
                     return LE_FAULT;
                 }
                 break;
@@ -827,7 +912,7 @@ le_result_t  VerifyUnpackedSystem
 
     fts_close(ftsPtr);
 
-    return LE_OK;
+    return CompleteVerifyBatch(batchRef, batchDir, batchStartTime);
 }
 
 
@@ -842,9 +927,16 @@ static void ApplySystemUpdate
 )
 //--------------------------------------------------------------------------------------------------
 {
+    // The unpacked system is either installed or discarded from now on.
+    updateUnpack_ForgetCheckpoint();
+
     if (ima_IsEnabled())
     {
-        if (LE_OK != VerifyUnpackedSystem())
+        le_result_t result = VerifyUnpackedSystem();
+
+        ima_ForgetDigests();
+
+        if (LE_OK != result)
         {
             LE_CRIT("Failed to unpacked system");
             UpdateFailed(LE_UPDATE_ERR_INTERNAL_ERROR);
@@ -897,6 +989,8 @@ static void ApplyAppUpdate
     {
         result = VerifyAppUnpackDir();
 
+        ima_ForgetDigests();
+
         if (LE_FAULT == result)
         {
             LE_CRIT("Failed to install app '%s<%s>'.", appName, md5);
@@ -1147,6 +1241,11 @@ static void UpdateServiceClosed
         EndUpdate();
     }
 
+    if (sessionRef == ResumeSession)
+    {
+        ResumeSession = NULL;
+    }
+
     // NOTE: We don't have to remove all the registered progress handlers for this session
     //       because the generated IPC code will call le_update_RemoveProgressHandler()
     //       automatically for us.
@@ -2053,9 +2152,17 @@ le_result_t le_update_Start
     // Close the input fd as pipeline_SetInput dups() this.
     fd_Close(clientFd);
 
+    // If this client asked where to resume, the update pack starts at that position.
+    size_t position = 0;
+    if ((ResumeSession == IpcSession) && IsPartialResumeAllowed())
+    {
+        position = ResumePosition;
+    }
+    ResumeSession = NULL;
+
     // Pass the readFd to the updateUnpacker module.
-    LE_DEBUG("Starting unpack");
-    updateUnpack_Start(readFd, HandleUpdateProgress);
+    LE_DEBUG("Starting unpack at %zu", position);
+    updateUnpack_Start(readFd, position, HandleUpdateProgress);
 
     State = STATE_UNPACKING;
 
@@ -2063,6 +2170,54 @@ le_result_t le_update_Start
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the position in the update pack from which an interrupted system update can be resumed.
+ *
+ * @return
+ *      - LE_OK on success.
+ *      - LE_BUSY if an update is in progress.
+ *      - LE_UNSUPPORTED if Legato system is R/O.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t le_update_GetResumePosition
+(
+    size_t* positionPtr         ///<[OUT] Position in the update pack to resume from.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (IsReadOnly)
+    {
+        LE_ERROR("Legato is R/O");
+        return LE_UNSUPPORTED;
+    }
+
+    if (State != STATE_IDLE)
+    {
+        LE_WARN("Another update is already in progress.");
+        return LE_BUSY;
+    }
+
+    ResumeSession = le_update_GetClientSessionRef();
+
+    if (IsPartialResumeAllowed())
+    {
+        ResumePosition = updateUnpack_GetResumePosition();
+        LE_INFO("Update can be resumed at offset %zu.", ResumePosition);
+    }
+    else
+    {
+        // The whole update pack has to go through security-unpack again.
+        ResumePosition = 0;
+        LE_INFO("Update can only be resumed from the start.");
+    }
+
+    *positionPtr = ResumePosition;
+
+    return LE_OK;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Function to get error code when update fails.
@@ -2308,6 +2463,18 @@ COMPONENT_INIT
     // Initialize the User module
     user_Init();
 
+    // Initialize the sandbox plan module
+    sandboxPlan_Init();
+
+    // Initialize the tarball extractor used to unpack update payloads
+    untar_Init();
+
+    // Initialize the update pack parser
+    updateUnpack_Init();
+
+    // Initialize the app module
+    app_Init();
+
     // Initialize pools
     ClientProgressHandlerPool = le_mem_CreatePool("ProgressHandler",
                                                   sizeof(ClientProgressHandler_t));
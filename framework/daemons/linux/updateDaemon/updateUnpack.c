@@ -7,6 +7,30 @@
  *
  * This is single-threaded, event-driven code that shares the main thread's event loop.
  *
+ * Payloads are unpacked in-process: bytes read from the update pack are fed straight to a
+ * streaming tarball extractor (see untar.h).  When IMA is enabled, the content of each unpacked
+ * file is hashed as it is written, so that verifying its signature later doesn't require reading it
+ * back (see ima_RecordDigest()).
+ *
+ * The sections of a system update pack that have been completely unpacked are recorded in a
+ * checkpoint file inside the system unpack directory, one line per section giving the positions in
+ * the update pack of the start and end of the section, the MD5 hash of the system or app it
+ * contains and the SHA-256 digest of its payload bytes.  The first line is always the system
+ * section, so the checkpoint identifies the update pack by its size up to there and the digest of
+ * its system payload.  Each line is only appended once the section's files have been synced, so
+ * after an interruption (lost power, stalled stream, cancelled session) the recorded sections are
+ * on the flash.  They were never approved by security-unpack though, so they are only used again if
+ * the same bytes are sent again:
+ *
+ *  - If the same update pack is sent again from the start, the payloads of the recorded sections
+ *    are read and hashed instead of being unpacked again.  If one doesn't match the checkpoint, the
+ *    update pack is rejected.  Since the whole update pack goes through security-unpack again, its
+ *    verdict covers the sections unpacked by the earlier attempt.
+ *  - If the client asks for the resume position (see updateUnpack_GetResumePosition()), it can
+ *    send only the rest of the update pack, starting with the last recorded section, which must
+ *    match the checkpoint.  The update daemon only allows this when security-unpack doesn't need
+ *    to see the whole update pack.
+ *
  * Copyright (C) Sierra Wireless Inc.
  */
 //--------------------------------------------------------------------------------------------------
@@ -15,15 +39,27 @@
 #include "interfaces.h"
 #include "limit.h"
 #include "updateUnpack.h"
-#include "pipeline.h"
 #include "fileDescriptor.h"
 #include "system.h"
 #include "app.h"
+#include "untar.h"
+#include "ima.h"
+#include <openssl/evp.h>
 
 
 /// An MD5 hash string is 32 characters long, plus a null terminator.
 #define MD5_STRING_BYTES 33
 
+/// A SHA-256 digest string is 64 characters long, plus a null terminator.
+#define DIGEST_STRING_BYTES 65
+
+/// Name of the checkpoint file inside the system unpack directory.
+#define CHECKPOINT_FILE_NAME ".checkpoint"
+
+/// Number of bytes read from the update pack at a time.  Large reads mean fewer system calls and
+/// fewer trips through the event loop per payload.
+#define PAYLOAD_READ_BYTES (64 * 1024)
+
 /// File descriptor to read the update pack from.
 static int InputFd = -1;
 
@@ -34,11 +70,20 @@ static bool InputFdClosed = false;
 /// Reference to the FD Monitor for the input stream (NULL if not unpacking).
 static le_fdMonitor_Ref_t InputFdMonitor = NULL;
 
-/// Reference to an unpack pipeline (NULL if not unpacking).
-static pipeline_Ref_t Pipeline = NULL;
+/// Tarball extractor the payload is being fed to (NULL if not unpacking).
+static untar_Ref_t Extractor = NULL;
+
+/// Digest of the payload of the current section of a system update pack (NULL if not reading one).
+static EVP_MD_CTX* PayloadDigestPtr = NULL;
 
-/// File descriptor connected to the input of a pipeline (-1 if not unpacking)
-static int PipelineFd = -1;
+/// true if IMA is enabled, checked once per update pack because ima_IsEnabled() runs a shell.
+static bool IsImaEnabled = false;
+
+/// Time at which unpacking of the current payload started.  Used to report throughput.
+static le_clk_Time_t UnpackStartTime;
+
+/// Buffer that payload bytes are read into.
+static uint8_t ReadBuffer[PAYLOAD_READ_BYTES];
 
 /// Function to be called to report progress.
 static updateUnpack_ProgressHandler_t ProgressFunc = NULL;
@@ -58,12 +103,50 @@ static char Md5[MD5_STRING_BYTES]; ///< The system's MD5 hash.
 /// # of bytes of payload following the JSON.
 static size_t PayloadSize;
 
-/// # of bytes of payload that have been copied to the unpack pipeline.
+/// # of bytes of payload that have been fed to the extractor (or skipped).
 static size_t PayloadBytesCopied;
 
 /// Percentage complete on current task.
 static unsigned int PercentDone;
 
+/// Position in the update pack of the next byte that will be read from InputFd.
+static size_t PackOffset;
+
+/// Position in the update pack of the start of the current section's JSON header.
+static size_t SectionStart;
+
+/// Position in the update pack of the end of the current section's payload.
+static size_t SectionEnd;
+
+/// true if the input stream was started part way through a system update pack and no section
+/// header has been read from it yet.
+static bool IsResuming;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * A section of a system update pack that has been completely unpacked.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    le_sls_Link_t link;             ///< Link in the Checkpoint list.
+    size_t startOffset;             ///< Position in the update pack of the start of the section.
+    size_t endOffset;               ///< Position in the update pack of the end of the section.
+    char md5[MD5_STRING_BYTES];     ///< MD5 hash of the system or app contained in the section.
+    char digest[DIGEST_STRING_BYTES];   ///< SHA-256 digest of the section's payload bytes.
+}
+CheckpointEntry_t;
+
+/// Pool of CheckpointEntry_t objects.
+static le_mem_PoolRef_t CheckpointEntryPool;
+
+/// Sections recorded in the checkpoint file, in update pack order.  The first one is the system.
+static le_sls_List_t Checkpoint = LE_SLS_LIST_INIT;
+
+/// Entry of the Checkpoint list for the current section, or NULL if it isn't recorded there.
+static CheckpointEntry_t* SectionEntryPtr = NULL;
+
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -142,6 +225,378 @@ static void DeleteFdMonitor
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the path of the checkpoint file.
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetCheckpointPath
+(
+    char* pathPtr,      ///< [OUT] Buffer to put the path in.
+    size_t pathSize     ///< Size of the buffer (bytes).
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(snprintf(pathPtr, pathSize, "%s/%s", system_UnpackPath, CHECKPOINT_FILE_NAME)
+              < pathSize);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the sections recorded in the checkpoint (without touching the checkpoint file).
+ */
+//--------------------------------------------------------------------------------------------------
+static void ClearCheckpoint
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_sls_Link_t* linkPtr;
+
+    SectionEntryPtr = NULL;
+
+    while ((linkPtr = le_sls_Pop(&Checkpoint)) != NULL)
+    {
+        le_mem_Release(CONTAINER_OF(linkPtr, CheckpointEntry_t, link));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether an app unpacked by an earlier section of a system update pack is still there,
+ * either in its unpack directory or already installed.
+ *
+ * @return true if the app is still there.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsAppUnpacked
+(
+    const char* md5Ptr  ///< MD5 hash of the app.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[LIMIT_MAX_PATH_BYTES] = "";
+
+    le_path_Concat("/", path, sizeof(path), app_UnpackPath, md5Ptr, NULL);
+
+    return (le_dir_IsDir(path) || app_Exists(md5Ptr));
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the checkpoint file, keeping the sections up to the first one that can't be trusted
+ * anymore (cut short by an interruption, or whose app has been removed since).
+ */
+//--------------------------------------------------------------------------------------------------
+static void LoadCheckpoint
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[LIMIT_MAX_PATH_BYTES];
+    char line[160];
+    size_t lastOffset = 0;
+
+    ClearCheckpoint();
+    GetCheckpointPath(path, sizeof(path));
+
+    FILE* filePtr = fopen(path, "r");
+
+    if (filePtr == NULL)
+    {
+        if (errno != ENOENT)
+        {
+            LE_WARN("Failed to open '%s' (%m).", path);
+        }
+        return;
+    }
+
+    while (fgets(line, sizeof(line), filePtr) != NULL)
+    {
+        size_t length = strlen(line);
+        size_t startOffset;
+        size_t endOffset;
+        char md5[MD5_STRING_BYTES];
+        char digest[DIGEST_STRING_BYTES];
+
+        // Sections follow each other, starting with the system at the start of the update pack.
+        if (   (length == 0)
+            || (line[length - 1] != '\n')
+            || (sscanf(line, "%zu %zu %32s %64s", &startOffset, &endOffset, md5, digest) != 4)
+            || (strlen(md5) != (MD5_STRING_BYTES - 1))
+            || (strlen(digest) != (DIGEST_STRING_BYTES - 1))
+            || (startOffset != lastOffset)
+            || (endOffset <= startOffset))
+        {
+            LE_WARN("Ignoring the end of the checkpoint after offset %zu.", lastOffset);
+            break;
+        }
+
+        // The first section is the system, the others are apps.
+        if (!le_sls_IsEmpty(&Checkpoint) && !IsAppUnpacked(md5))
+        {
+            LE_WARN("App with MD5 sum %s is gone, can't resume after offset %zu.",
+                    md5,
+                    lastOffset);
+            break;
+        }
+
+        CheckpointEntry_t* entryPtr = le_mem_ForceAlloc(CheckpointEntryPool);
+
+        entryPtr->link = LE_SLS_LINK_INIT;
+        entryPtr->startOffset = startOffset;
+        entryPtr->endOffset = endOffset;
+        LE_ASSERT(le_utf8_Copy(entryPtr->md5, md5, sizeof(entryPtr->md5), NULL) == LE_OK);
+        LE_ASSERT(le_utf8_Copy(entryPtr->digest, digest, sizeof(entryPtr->digest), NULL) == LE_OK);
+        le_sls_Queue(&Checkpoint, &entryPtr->link);
+
+        lastOffset = endOffset;
+    }
+
+    fclose(filePtr);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the last section recorded in the checkpoint.
+ *
+ * @return The section, or NULL if there is no checkpoint.
+ */
+//--------------------------------------------------------------------------------------------------
+static CheckpointEntry_t* GetLastSection
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_sls_Link_t* linkPtr = le_sls_PeekTail(&Checkpoint);
+
+    if (linkPtr == NULL)
+    {
+        return NULL;
+    }
+
+    return CONTAINER_OF(linkPtr, CheckpointEntry_t, link);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the position in the update pack of the end of the last section recorded in the checkpoint.
+ *
+ * @return The position, or 0 if there is no checkpoint.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetCheckpointEnd
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CheckpointEntry_t* entryPtr = GetLastSection();
+
+    return (entryPtr == NULL) ? 0 : entryPtr->endOffset;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the position in the update pack from which an interrupted system update can be resumed,
+ * i.e., the start of the last section recorded in the checkpoint.  That section is sent again so
+ * that it can be checked against the checkpoint.
+ *
+ * @return The position, or 0 if there is nothing to resume.
+ */
+//--------------------------------------------------------------------------------------------------
+static size_t GetResumeOffset
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CheckpointEntry_t* entryPtr = GetLastSection();
+
+    // Resuming at the system section is the same as starting over.
+    if ((entryPtr == NULL) || (&entryPtr->link == le_sls_Peek(&Checkpoint)))
+    {
+        return 0;
+    }
+
+    return entryPtr->startOffset;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check whether the current section is recorded in the checkpoint, i.e., whether it has already
+ * been unpacked by an earlier attempt at the same update pack.  Whether its payload is the same as
+ * then is only known once it has been read (see CompleteSection()).
+ *
+ * @return true if the section is recorded in the checkpoint.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSectionDone
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    le_sls_Link_t* linkPtr = le_sls_Peek(&Checkpoint);
+
+    while (linkPtr != NULL)
+    {
+        CheckpointEntry_t* entryPtr = CONTAINER_OF(linkPtr, CheckpointEntry_t, link);
+
+        if (   (entryPtr->startOffset == SectionStart)
+            && (entryPtr->endOffset == SectionEnd)
+            && (strcmp(entryPtr->md5, Md5) == 0))
+        {
+            SectionEntryPtr = entryPtr;
+            return true;
+        }
+
+        linkPtr = le_sls_PeekNext(&Checkpoint, linkPtr);
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Record the current section in the checkpoint file.  This is best-effort: if it fails, the update
+ * carries on but can't be resumed after this section.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RecordSection
+(
+    const char* digestPtr   ///< SHA-256 digest of the section's payload.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[LIMIT_MAX_PATH_BYTES];
+    char line[160];
+
+    GetCheckpointPath(path, sizeof(path));
+
+    int length = snprintf(line, sizeof(line), "%zu %zu %s %s\n",
+                          SectionStart,
+                          SectionEnd,
+                          Md5,
+                          digestPtr);
+    LE_ASSERT(length < sizeof(line));
+
+    // The section's files must be on the flash before the section is recorded as unpacked.
+    sync();
+
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+    if (fd == -1)
+    {
+        LE_WARN("Failed to open '%s' (%m).", path);
+        return;
+    }
+
+    if ((write(fd, line, length) != length) || (fsync(fd) != 0))
+    {
+        LE_WARN("Failed to write to '%s' (%m).", path);
+        fd_Close(fd);
+        return;
+    }
+
+    fd_Close(fd);
+
+    CheckpointEntry_t* entryPtr = le_mem_ForceAlloc(CheckpointEntryPool);
+
+    entryPtr->link = LE_SLS_LINK_INIT;
+    entryPtr->startOffset = SectionStart;
+    entryPtr->endOffset = SectionEnd;
+    LE_ASSERT(le_utf8_Copy(entryPtr->md5, Md5, sizeof(entryPtr->md5), NULL) == LE_OK);
+    LE_ASSERT(le_utf8_Copy(entryPtr->digest, digestPtr, sizeof(entryPtr->digest), NULL) == LE_OK);
+    le_sls_Queue(&Checkpoint, &entryPtr->link);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Start computing the digest of the payload of a section of a system update pack.
+ */
+//--------------------------------------------------------------------------------------------------
+static void StartPayloadDigest
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (Type != TYPE_SYSTEM_UPDATE)
+    {
+        return;
+    }
+
+    PayloadDigestPtr = EVP_MD_CTX_create();
+    LE_ASSERT(PayloadDigestPtr != NULL);
+    LE_ASSERT(EVP_DigestInit_ex(PayloadDigestPtr, EVP_sha256(), NULL) == 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Called when the payload of a section of a system update pack has been unpacked or skipped.  The
+ * section is recorded in the checkpoint, or if it already was, its payload is checked against the
+ * one unpacked by the earlier attempt.
+ *
+ * @return
+ *      - LE_OK if the section is complete.
+ *      - LE_FORMAT_ERROR if the payload isn't the one unpacked by the earlier attempt.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t CompleteSection
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int digestSize = 0;
+    char digestStr[DIGEST_STRING_BYTES];
+    unsigned int i;
+
+    LE_ASSERT(PayloadDigestPtr != NULL);
+    LE_ASSERT(EVP_DigestFinal_ex(PayloadDigestPtr, digest, &digestSize) == 1);
+    EVP_MD_CTX_destroy(PayloadDigestPtr);
+    PayloadDigestPtr = NULL;
+
+    LE_ASSERT((2 * digestSize) + 1 == sizeof(digestStr));
+    for (i = 0; i < digestSize; i++)
+    {
+        snprintf(digestStr + (2 * i), sizeof(digestStr) - (2 * i), "%02x", digest[i]);
+    }
+
+    PackOffset = SectionEnd;
+
+    if (SectionEntryPtr == NULL)
+    {
+        RecordSection(digestStr);
+    }
+    else if (strcmp(SectionEntryPtr->digest, digestStr) != 0)
+    {
+        LE_ERROR("Section at offset %zu isn't the one unpacked before (payload digest %s, not %s).",
+                 SectionStart,
+                 digestStr,
+                 SectionEntryPtr->digest);
+        return LE_FORMAT_ERROR;
+    }
+
+    return LE_OK;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Reset the update unpacker.
@@ -176,17 +631,17 @@ static void Reset
 
         InputFd = -1;
     }
-    if (PipelineFd != -1)
+
+    // Delete the extractor and digest.
+    if (Extractor != NULL)
     {
-        fd_Close(PipelineFd);
-        PipelineFd = -1;
+        untar_Delete(Extractor);
+        Extractor = NULL;
     }
-
-    // Delete the pipeline.
-    if (Pipeline != NULL)
+    if (PayloadDigestPtr != NULL)
     {
-        pipeline_Delete(Pipeline);
-        Pipeline = NULL;
+        EVP_MD_CTX_destroy(PayloadDigestPtr);
+        PayloadDigestPtr = NULL;
     }
 }
 
@@ -359,6 +814,7 @@ static void StartParsing
     AppName[0] = '\0';
     Md5[0] = '\0';
     PayloadSize = 0;
+    SectionEntryPtr = NULL;
 
     // Set the state
     State = STATE_PARSING_JSON;
@@ -370,38 +826,41 @@ static void StartParsing
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Completion callback for "tar xj" operation.
+ * Called when all the payload bytes have been fed to the extractor.
  */
 //--------------------------------------------------------------------------------------------------
-static void UntarDone
+static void UnpackPayloadDone
 (
-    pipeline_Ref_t pipeline,
-    int status
+    void
 )
 //--------------------------------------------------------------------------------------------------
 {
-    pipeline_Delete(Pipeline);
-    Pipeline = NULL;
+    DeleteFdMonitor();
+
+    le_result_t result = untar_Finish(Extractor);
 
-    if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS))
+    if (result != LE_OK)
     {
-        if (WIFEXITED(status))
-        {
-            LE_ERROR("Payload unpack pipeline failed with exit code: %d", WEXITSTATUS(status));
-        }
-        else if (WIFSIGNALED(status))
-        {
-            LE_ERROR("Payload unpack pipeline killed by signal: %d", WTERMSIG(status));
-        }
-        else
-        {
-            LE_ERROR("Payload unpack pipeline died for unknown reason (status: %d)", status);
-        }
+        LE_ERROR("Failed to unpack payload (%s).", LE_RESULT_TXT(result));
 
-        HandleInternalError();
+        HandleFormatError();
         return;
     }
 
+    le_clk_Time_t elapsed = le_clk_Sub(le_clk_GetRelativeTime(), UnpackStartTime);
+    uint64_t elapsedMs = ((uint64_t)elapsed.sec * 1000) + (elapsed.usec / 1000);
+
+    LE_INFO("Unpacked %zu byte %s payload (%zu bytes uncompressed) in %" PRIu64 " ms"
+            " (%" PRIu64 " KiB/s).",
+            PayloadSize,
+            untar_GetCompressionName(Extractor),
+            untar_GetTarBytes(Extractor),
+            elapsedMs,
+            (elapsedMs > 0) ? (((uint64_t)PayloadSize * 1000) / 1024) / elapsedMs : 0);
+
+    untar_Delete(Extractor);
+    Extractor = NULL;
+
     // If this update pack contains changes to individual apps,
     if (Type == TYPE_APP_UPDATE)
     {
@@ -429,6 +888,12 @@ static void UntarDone
             ReportProgress();
         }
 
+        if (CompleteSection() != LE_OK)
+        {
+            HandleFormatError();
+            return;
+        }
+
         // There could be more after this payload, so look for another JSON header.
         StartParsing();
     }
@@ -458,6 +923,12 @@ static void SkipForwardDone
     }
     else if (Type == TYPE_SYSTEM_UPDATE)
     {
+        if (CompleteSection() != LE_OK)
+        {
+            HandleFormatError();
+            return;
+        }
+
         // There could be more after this payload, so look for another JSON header.
         StartParsing();
     }
@@ -472,33 +943,31 @@ static void SkipForwardDone
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Copy bytes from the input fd to the pipeline's input fd until the input fd's read buffer is
- * empty or we have copied all the payload bytes.
+ * Feed bytes from the input fd to the extractor until the input fd's read buffer is empty or we
+ * have fed all the payload bytes.
  */
 //--------------------------------------------------------------------------------------------------
-static void CopyBytesToPipeline
+static void UnpackPayloadBytes
 (
     void
 )
 //--------------------------------------------------------------------------------------------------
 {
-    char buffer[1024];
-
-    // Keep copying as much as we can until we've copied all the payload.
+    // Keep unpacking as much as we can until we've unpacked all the payload.
     while (PayloadBytesCopied < PayloadSize)
     {
         // Compute the number of bytes to read.
         size_t bytesToRead = PayloadSize - PayloadBytesCopied;
-        if (bytesToRead > sizeof(buffer))
+        if (bytesToRead > sizeof(ReadBuffer))
         {
-            bytesToRead = sizeof(buffer);
+            bytesToRead = sizeof(ReadBuffer);
         }
 
         // Read the bytes, retrying if interrupted by a signal.
         ssize_t readResult;
         do
         {
-            readResult = read(InputFd, buffer, bytesToRead);
+            readResult = read(InputFd, ReadBuffer, bytesToRead);
         }
         while ((readResult == -1) && (errno == EINTR));
 
@@ -515,7 +984,8 @@ static void CopyBytesToPipeline
             }
 
             LE_ERROR("Failed to read from input stream (%m).");
-            goto error;
+            HandleInternalError();
+            return;
         }
 
         // Handle end of file.
@@ -524,31 +994,29 @@ static void CopyBytesToPipeline
             LE_ERROR("Unexpected early end of input after %zu bytes of %zu.",
                      PayloadBytesCopied,
                      PayloadSize);
-            goto error;
+            HandleInternalError();
+            return;
         }
 
-        // Write the bytes that we read.
-        ssize_t bytesWritten = 0;
-        ssize_t writeResult;
-        do
+        // Hash and unpack the bytes that we read.
+        if (PayloadDigestPtr != NULL)
         {
-            writeResult = write(PipelineFd, buffer + bytesWritten, readResult - bytesWritten);
-
-            // If some bytes were written, remember how many bytes, so we don't try to write the
-            // same bytes again if we have more to write.
-            if (writeResult > 0)
-            {
-                bytesWritten += writeResult;
-            }
+            LE_ASSERT(EVP_DigestUpdate(PayloadDigestPtr, ReadBuffer, readResult) == 1);
         }
-        while (   ((writeResult == -1) && (errno == EINTR)) // Retry if interrupted by a signal
-               || ((writeResult != -1) && (bytesWritten < readResult))  ); // Continue if not done
 
-        // Check for errors.
-        if (writeResult == -1)
+        le_result_t result = untar_Write(Extractor, ReadBuffer, readResult);
+
+        if (result == LE_FORMAT_ERROR)
         {
-            LE_ERROR("Failed to write to output stream (%m)");
-            goto error;
+            LE_ERROR("Malformed update pack (invalid payload tarball).");
+            HandleFormatError();
+            return;
+        }
+        else if (result != LE_OK)
+        {
+            LE_ERROR("Failed to unpack payload (%s).", LE_RESULT_TXT(result));
+            HandleInternalError();
+            return;
         }
 
         // Update the static progress variables and report progress to the client.
@@ -557,22 +1025,14 @@ static void CopyBytesToPipeline
         ReportProgress();
     }
 
-    // If we have copied all the payload bytes to the pipeline's input, then we can stop
-    // monitoring the input fd now, close the pipeline input write pipe, and wait for the pipeline
-    // completion callback (UntarDone()).
-    LE_INFO("Payload copied: %zu/%zu", PayloadBytesCopied, PayloadSize);
+    // If we have fed all the payload bytes to the extractor, then we can stop monitoring the input
+    // fd now and finish up the payload.
+    LE_DEBUG("Payload unpacked: %zu/%zu", PayloadBytesCopied, PayloadSize);
     LE_ASSERT(PayloadBytesCopied <= PayloadSize);
     if (PayloadBytesCopied == PayloadSize)
     {
-        DeleteFdMonitor();
-        fd_Close(PipelineFd);
-        PipelineFd = -1;
+        UnpackPayloadDone();
     }
-    return;
-
-error:
-
-    HandleInternalError();
 }
 
 
@@ -588,23 +1048,21 @@ static void DiscardPayloadBytes
 )
 //--------------------------------------------------------------------------------------------------
 {
-    char buffer[1024];
-
     // Keep reading as much as we can until we've read all the payload.
     while (PayloadBytesCopied < PayloadSize)
     {
         // Compute the number of bytes to read.
         size_t bytesToRead = PayloadSize - PayloadBytesCopied;
-        if (bytesToRead > sizeof(buffer))
+        if (bytesToRead > sizeof(ReadBuffer))
         {
-            bytesToRead = sizeof(buffer);
+            bytesToRead = sizeof(ReadBuffer);
         }
 
         // Read the bytes, retrying if interrupted by a signal.
         ssize_t readResult;
         do
         {
-            readResult = read(InputFd, buffer, bytesToRead);
+            readResult = read(InputFd, ReadBuffer, bytesToRead);
         }
         while ((readResult == -1) && (errno == EINTR));
 
@@ -634,6 +1092,12 @@ static void DiscardPayloadBytes
             break;
         }
 
+        // The payload of a system update section is hashed even though it is thrown away.
+        if (PayloadDigestPtr != NULL)
+        {
+            LE_ASSERT(EVP_DigestUpdate(PayloadDigestPtr, ReadBuffer, readResult) == 1);
+        }
+
         // Update the static progress variables and report progress to the client.
         PayloadBytesCopied += readResult;
         PercentDone = (100 * PayloadBytesCopied) / PayloadSize;
@@ -654,7 +1118,7 @@ static void DiscardPayloadBytes
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Event handler for the input fd when copying bytes to a pipeline.
+ * Event handler for the input fd when unpacking or skipping a payload.
  */
 //--------------------------------------------------------------------------------------------------
 static void InputFdEventHandler
@@ -668,7 +1132,7 @@ static void InputFdEventHandler
     {
         if (State == STATE_UNPACKING_PAYLOAD)
         {
-            CopyBytesToPipeline();
+            UnpackPayloadBytes();
         }
         else if (State == STATE_SKIPPING_PAYLOAD)
         {
@@ -689,26 +1153,19 @@ static void InputFdEventHandler
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Function that runs in the unpack pipeline's "tar" process.
- **/
+ * Records the digest of a file written by the extractor, for the IMA signature verification.
+ */
 //--------------------------------------------------------------------------------------------------
-static int Untar
+static void RecordFileDigest
 (
-    void* param
+    int fd,
+    const uint8_t* digestPtr,
+    size_t digestSize,
+    void* contextPtr
 )
 //--------------------------------------------------------------------------------------------------
 {
-    const char* unpackDir = param;
-
-    // Close all open file descriptors except for stdin, stdout, and stderr.
-    // This ensures that we don't keep copies of things like the pipeline input write pipe open.
-    fd_CloseAllNonStd();
-
-    // Try bsdtar first.  If that fails, fallback to tar.
-    execl("/usr/bin/bsdtar", "bsdtar", "xjmop", "-f", "-", "-C", unpackDir, (char*)NULL);
-    execl("/bin/tar", "tar", "xjop", "-C", unpackDir, (char*)NULL);
-
-    LE_FATAL("Failed to exec tar (%m)");
+    ima_RecordDigest(fd, digestPtr, digestSize);
 }
 
 
@@ -717,7 +1174,7 @@ static int Untar
  * Start unpacking a tarball.
  */
 //--------------------------------------------------------------------------------------------------
-static void StartUntar
+static void StartUnpack
 (
     const char* dirPath ///< Path to the directory to unpack the tarball into.
 )
@@ -726,12 +1183,16 @@ static void StartUntar
     State = STATE_UNPACKING_PAYLOAD;
 
     PayloadBytesCopied = 0;
+    UnpackStartTime = le_clk_GetRelativeTime();
 
-    // Create a pipeline: PipelineFd -> tar
-    Pipeline = pipeline_Create();
-    PipelineFd = pipeline_CreateInputPipe(Pipeline);
-    pipeline_Append(Pipeline, Untar, (void*)dirPath);
-    pipeline_Start(Pipeline, UntarDone);
+    Extractor = untar_Create(dirPath);
+
+    if (IsImaEnabled)
+    {
+        untar_SetFileHandler(Extractor, RecordFileDigest, NULL);
+    }
+
+    StartPayloadDigest();
 
     fd_SetNonBlocking(InputFd);
 
@@ -740,6 +1201,46 @@ static void StartUntar
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Try to skip over the payload by seeking, which is possible when the update pack is being read
+ * from a regular file.
+ *
+ * @return true if the payload was skipped.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool SeekPastPayload
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    struct stat st;
+    off_t pos = lseek(InputFd, 0, SEEK_CUR);
+
+    if ((pos == -1) || (fstat(InputFd, &st) != 0) || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+
+    // If the file is truncated, let the read path report the early end of input.
+    if ((uint64_t)(st.st_size - pos) < (uint64_t)PayloadSize)
+    {
+        return false;
+    }
+
+    if (lseek(InputFd, PayloadSize, SEEK_CUR) == -1)
+    {
+        return false;
+    }
+
+    PayloadBytesCopied = PayloadSize;
+    LE_INFO("Payload skipped by seeking: %zu bytes", PayloadSize);
+
+    return true;
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Start reading and throwing away payload bytes from the input stream.
@@ -755,6 +1256,15 @@ static void StartSkipForward
 
     PayloadBytesCopied = 0;
 
+    // The payload of a system update section must be read to be hashed.
+    if ((Type != TYPE_SYSTEM_UPDATE) && SeekPastPayload())
+    {
+        SkipForwardDone();
+        return;
+    }
+
+    StartPayloadDigest();
+
     fd_SetNonBlocking(InputFd);
 
     // Create FD Monitor for the Input FD.
@@ -812,6 +1322,36 @@ static void JsonDone
 )
 //--------------------------------------------------------------------------------------------------
 {
+    // A system update header can only be at the start of an update pack, so if the client was
+    // asked to resume but sent the whole update pack again, go back to the start.
+    if (IsResuming && (strcmp(Command, "updateSystem") == 0))
+    {
+        LE_INFO("Update pack restarted from the beginning instead of resuming at %zu.",
+                PackOffset);
+        PackOffset = 0;
+        Type = TYPE_UNKNOWN;
+    }
+
+    // Work out where this section starts and where its payload ends in the update pack.
+    SectionStart = PackOffset;
+    PackOffset += le_json_GetBytesRead(le_json_GetSession());
+    SectionEnd = PackOffset + PayloadSize;
+
+    // A resumed stream starts with the last section unpacked by the earlier attempt, so check that
+    // it is the same update pack.  The section's payload is checked by CompleteSection().
+    if (IsResuming)
+    {
+        IsResuming = false;
+
+        if (!IsSectionDone() || (SectionEntryPtr != GetLastSection()))
+        {
+            LE_ERROR("Malformed update pack (doesn't continue the one unpacked up to offset %zu)",
+                     GetCheckpointEnd());
+            HandleFormatError();
+            return;
+        }
+    }
+
     if (strcmp(Command, "updateSystem") == 0)
     {
         // System update header MUST be the first thing in a system update pack.
@@ -836,17 +1376,34 @@ static void JsonDone
         else
         {
             Type = TYPE_SYSTEM_UPDATE;
-            State = STATE_UNPACKING_PAYLOAD;
 
-            // Make space by removing extra systems.
-            system_RemoveUnneeded();
+            // If an earlier attempt at this update pack was interrupted, keep what it unpacked.
+            LoadCheckpoint();
 
-            // Delete any old unpack junk from previous incomplete/failed updates.
-            system_PrepUnpackDir();
+            if (IsSectionDone())
+            {
+                LE_INFO("System with MD5 sum %s already unpacked up to offset %zu. Skipping.",
+                        Md5,
+                        GetCheckpointEnd());
 
-            // Unpack the system tarball.
-            // This is asynchronous and will call UntarDone() when finished.
-            StartUntar(system_UnpackPath);
+                // This is asynchronous and will call SkipForwardDone() when finished.
+                StartSkipForward();
+            }
+            else
+            {
+                State = STATE_UNPACKING_PAYLOAD;
+
+                // Make space by removing extra systems.
+                system_RemoveUnneeded();
+
+                // Delete any old unpack junk from previous incomplete/failed updates.
+                system_PrepUnpackDir();
+                ClearCheckpoint();
+
+                // Unpack the system tarball.
+                // This is asynchronous and will call UnpackPayloadDone() when finished.
+                StartUnpack(system_UnpackPath);
+            }
         }
     }
     else if (strcmp(Command, "updateApp") == 0)
@@ -885,7 +1442,14 @@ static void JsonDone
                 system_RemoveUnusedApps();
             }
 
-            if (app_Exists(Md5) == false)
+            if ((Type == TYPE_SYSTEM_UPDATE) && IsSectionDone())
+            {
+                LE_INFO("App with MD5 sum %s already unpacked. Skipping.", Md5);
+
+                // This is asynchronous and will call SkipForwardDone() when finished.
+                StartSkipForward();
+            }
+            else if (app_Exists(Md5) == false)
             {
                 LE_INFO("App with MD5 sum %s being unpacked.", Md5);
 
@@ -897,8 +1461,8 @@ static void JsonDone
                     // Prepare the directory to unpack into.
                     app_PrepUnpackDir();
                     // Unpack the app tarball.
-                    // This is asynchronous and will call UntarDone() when finished.
-                    StartUntar(app_UnpackPath);
+                    // This is asynchronous and will call UnpackPayloadDone() when finished.
+                    StartUnpack(app_UnpackPath);
                 }
                 else
                 {
@@ -912,8 +1476,8 @@ static void JsonDone
                     LE_FATAL_IF(LE_OK != le_dir_MakePath(unpackPath, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH),
                                 "Failed to create directory '%s'.",
                                 unpackPath);
-                    // Untar the app tarball. Will call UntarDone() when finished.
-                    StartUntar(unpackPath);
+                    // Untar the app tarball. Will call UnpackPayloadDone() when finished.
+                    StartUnpack(unpackPath);
                 }
 
             }
@@ -1215,6 +1779,21 @@ static void JsonEventHandler
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the module.  Must be called before any other function in this module.
+ */
+//--------------------------------------------------------------------------------------------------
+void updateUnpack_Init
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    CheckpointEntryPool = le_mem_CreatePool("UnpackCheckpoint", sizeof(CheckpointEntry_t));
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Starts processing an update pack.
@@ -1227,6 +1806,7 @@ static void JsonEventHandler
 void updateUnpack_Start
 (
     int fd,             ///< File descriptor to read the update pack from.
+    size_t position,    ///< Position in the update pack of the first byte read from fd.
     updateUnpack_ProgressHandler_t progressFunc  ///< Progress reporting callback.
 )
 //--------------------------------------------------------------------------------------------------
@@ -1237,15 +1817,87 @@ void updateUnpack_Start
     InputFdClosed = false; // reset InputFdClosed since it's initialized.
     ProgressFunc = progressFunc;
     PercentDone = 0;
+    IsImaEnabled = ima_IsEnabled();
 
     ProgressFunc(UPDATE_UNPACK_STATUS_UNPACKING, 0);
 
     Type = TYPE_UNKNOWN;
+    PackOffset = 0;
+    IsResuming = false;
+
+    if (position != 0)
+    {
+        // The sections up to the resume position must all have been unpacked already.
+        LoadCheckpoint();
+
+        if (GetResumeOffset() != position)
+        {
+            LE_ERROR("Can't resume update pack at offset %zu (resume position is %zu).",
+                     position,
+                     GetResumeOffset());
+            HandleInternalError();
+            return;
+        }
+
+        LE_INFO("Resuming update of system with MD5 sum %s at offset %zu.",
+                CONTAINER_OF(le_sls_Peek(&Checkpoint), CheckpointEntry_t, link)->md5,
+                position);
+
+        Type = TYPE_SYSTEM_UPDATE;
+        PackOffset = position;
+        IsResuming = true;
+    }
 
     StartParsing();
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the position in the update pack from which an interrupted system update can be resumed,
+ * i.e., the start of the last section that was completely unpacked.
+ *
+ * @return The resume position, or 0 if there is nothing to resume.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t updateUnpack_GetResumePosition
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    LE_ASSERT(State == STATE_IDLE);
+
+    LoadCheckpoint();
+
+    return GetResumeOffset();
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the sections unpacked so far, so that the next system update starts from scratch.  Must
+ * be called when the update pack is rejected or the unpacked system is being installed.
+ */
+//--------------------------------------------------------------------------------------------------
+void updateUnpack_ForgetCheckpoint
+(
+    void
+)
+//--------------------------------------------------------------------------------------------------
+{
+    char path[LIMIT_MAX_PATH_BYTES];
+
+    ClearCheckpoint();
+    GetCheckpointPath(path, sizeof(path));
+
+    if ((unlink(path) != 0) && (errno != ENOENT))
+    {
+        LE_WARN("Failed to delete '%s' (%m).", path);
+    }
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the type of the update pack (available when 100% done).
@@ -58,19 +58,63 @@ typedef enum
 updateUnpack_Type_t;
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Initializes the module.  Must be called before any other function in this module.
+ */
+//--------------------------------------------------------------------------------------------------
+void updateUnpack_Init
+(
+    void
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Start unpacking an update pack.  When sections of the update pack are unpacked, the
  * update unpacker will call functions in the update executor to perform the update actions.
+ *
+ * If position is not 0, fd must start at that position in a system update pack, which must be the
+ * position returned by updateUnpack_GetResumePosition().  The stream must start with the last
+ * section unpacked by the earlier attempt, unchanged, or the update pack is rejected.  If the
+ * stream turns out to start with a system update header instead, it is unpacked as a whole update
+ * pack, and the sections already unpacked are checked instead of being unpacked again.
  */
 //--------------------------------------------------------------------------------------------------
 void updateUnpack_Start
 (
     int fd,             ///< File descriptor to read the update pack from.
+    size_t position,    ///< Position in the update pack of the first byte read from fd.
     updateUnpack_ProgressHandler_t progressHandler  ///< Progress reporting callback.
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the position in the update pack from which an interrupted system update can be resumed,
+ * i.e., the start of the last section that was completely unpacked.
+ *
+ * @return The resume position, or 0 if there is nothing to resume.
+ */
+//--------------------------------------------------------------------------------------------------
+size_t updateUnpack_GetResumePosition
+(
+    void
+);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Forget the sections unpacked so far, so that the next system update starts from scratch.  Must
+ * be called when the update pack is rejected or the unpacked system is being installed.
+ */
+//--------------------------------------------------------------------------------------------------
+void updateUnpack_ForgetCheckpoint
+(
+    void
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the type of the update pack (available when 100% done).
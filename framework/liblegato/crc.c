@@ -5,11 +5,39 @@
  *
  * @note Only CRC32 is supported in this API
  *
+ * The CRC32 is computed by the fastest implementation the CPU supports, selected the first time
+ * le_crc_Crc32() is called:
+ *  - carry-less multiplication (PCLMULQDQ) folding on x86,
+ *  - the CRC32 instructions of ARMv8,
+ *  - otherwise, a "slicing-by-8" table lookup processing 8 bytes per step.
+ *
+ * All of them give the same result as the classic byte-at-a-time table lookup, which is still used
+ * for the unaligned head and the tail of the buffer.
+ *
+ * @note This file is also built into host tools (e.g., mkPatch), so it must not use the Legato
+ *       logging or memory APIs.
+ *
  * Copyright (C) Sierra Wireless Inc.
  *
  */
 
 #include "legato.h"
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <smmintrin.h>
+#define CRC_HAVE_CLMUL 1
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#define CRC_HAVE_ARMV8 1
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#elif defined(__arm__) && defined(__ARM_FEATURE_CRC32)
+#define CRC_HAVE_ARMV8 1
+#endif
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -86,17 +114,50 @@ static const unsigned int Crc32Table[256] =
 
 //--------------------------------------------------------------------------------------------------
 /**
- * This function is used to calculate a CRC-32
+ * Additional tables for slicing-by-8: SliceTable[k][n] is the CRC of byte n followed by k + 1 zero
+ * bytes.  Built from Crc32Table when the implementation is selected.
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t SliceTable[7][256];
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prototype of a CRC32 implementation.  Same parameters as le_crc_Crc32().
+ */
+//--------------------------------------------------------------------------------------------------
+typedef uint32_t (*Crc32Func_t)(const uint8_t* addressPtr, size_t size, uint32_t crc);
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Implementation selected by SelectImpl().
+ */
+//--------------------------------------------------------------------------------------------------
+static Crc32Func_t Crc32Impl;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Makes sure SelectImpl() runs only once, even if the first calls are made by several threads.
+ */
+//--------------------------------------------------------------------------------------------------
+static pthread_once_t SelectOnce = PTHREAD_ONCE_INIT;
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Classic byte-at-a-time CRC32.
  *
  * @return
  *      - 32-bit CRC
  */
 //--------------------------------------------------------------------------------------------------
-uint32_t le_crc_Crc32
+static uint32_t Crc32Bytes
 (
-    uint8_t* addressPtr,///< [IN] Input buffer
-    size_t   size,      ///< [IN] Number of bytes to read
-    uint32_t crc        ///< [IN] Starting CRC seed
+    const uint8_t* addressPtr,  ///< [IN] Input buffer
+    size_t   size,              ///< [IN] Number of bytes to read
+    uint32_t crc                ///< [IN] Starting CRC seed
 )
 {
     for (; size > 0 ; size--)
@@ -107,3 +168,397 @@ uint32_t le_crc_Crc32
     return crc;
 }
 
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Slicing-by-8 CRC32: each step looks up 8 bytes in 8 independent tables, which removes the
+ * dependency of every lookup on the previous one.  Falls back to the byte loop on big-endian CPUs.
+ *
+ * @return
+ *      - 32-bit CRC
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t Crc32Slice8
+(
+    const uint8_t* addressPtr,  ///< [IN] Input buffer
+    size_t   size,              ///< [IN] Number of bytes to read
+    uint32_t crc                ///< [IN] Starting CRC seed
+)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Align the buffer so the words are read in one access.
+    size_t headSize = (-(uintptr_t)addressPtr) & 3;
+
+    if (headSize > size)
+    {
+        headSize = size;
+    }
+
+    crc = Crc32Bytes(addressPtr, headSize, crc);
+    addressPtr += headSize;
+    size -= headSize;
+
+    for (; size >= 8; size -= 8, addressPtr += 8)
+    {
+        uint32_t low;
+        uint32_t high;
+
+        memcpy(&low, addressPtr, sizeof(low));
+        memcpy(&high, addressPtr + 4, sizeof(high));
+        low ^= crc;
+
+        crc = SliceTable[6][low & 0xFF] ^
+              SliceTable[5][(low >> 8) & 0xFF] ^
+              SliceTable[4][(low >> 16) & 0xFF] ^
+              SliceTable[3][low >> 24] ^
+              SliceTable[2][high & 0xFF] ^
+              SliceTable[1][(high >> 8) & 0xFF] ^
+              SliceTable[0][(high >> 16) & 0xFF] ^
+              Crc32Table[high >> 24];
+    }
+#endif
+
+    return Crc32Bytes(addressPtr, size, crc);
+}
+
+
+#ifdef CRC_HAVE_CLMUL
+//--------------------------------------------------------------------------------------------------
+/**
+ * Folds a buffer into a CRC32 with carry-less multiplications, 64 bytes per step, then reduces the
+ * result with a Barrett reduction.  See "Fast CRC Computation for Generic Polynomials Using
+ * PCLMULQDQ Instruction" (Intel, 2009) for the constants.
+ *
+ * @note size must be at least 64 and a multiple of 16.
+ *
+ * @return
+ *      - 32-bit CRC
+ */
+//--------------------------------------------------------------------------------------------------
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t Crc32ClmulBlocks
+(
+    const uint8_t* addressPtr,  ///< [IN] Input buffer
+    size_t   size,              ///< [IN] Number of bytes to read
+    uint32_t crc                ///< [IN] Starting CRC seed
+)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+    const __m128i k5k0 = _mm_set_epi64x(0x0000000000LL, 0x0163CD6124LL);
+    const __m128i poly = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(addressPtr + 0x00));
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(addressPtr + 0x10));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(addressPtr + 0x20));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(addressPtr + 0x30));
+    __m128i x4;
+    __m128i x5;
+    __m128i x6;
+    __m128i x7;
+
+    x0 = _mm_xor_si128(x0, _mm_cvtsi32_si128((int)crc));
+    addressPtr += 64;
+    size -= 64;
+
+    // Fold 4 x 128 bits in parallel.
+    for (; size >= 64; size -= 64, addressPtr += 64)
+    {
+        x4 = _mm_clmulepi64_si128(x0, k1k2, 0x00);
+        x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+
+        x0 = _mm_clmulepi64_si128(x0, k1k2, 0x11);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+
+        x0 = _mm_xor_si128(_mm_xor_si128(x0, x4),
+                           _mm_loadu_si128((const __m128i*)(addressPtr + 0x00)));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                           _mm_loadu_si128((const __m128i*)(addressPtr + 0x10)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                           _mm_loadu_si128((const __m128i*)(addressPtr + 0x20)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                           _mm_loadu_si128((const __m128i*)(addressPtr + 0x30)));
+    }
+
+    // Fold the 4 x 128 bits into 128 bits.
+    x4 = _mm_clmulepi64_si128(x0, k3k4, 0x00);
+    x0 = _mm_clmulepi64_si128(x0, k3k4, 0x11);
+    x0 = _mm_xor_si128(_mm_xor_si128(x0, x1), x4);
+
+    x4 = _mm_clmulepi64_si128(x0, k3k4, 0x00);
+    x0 = _mm_clmulepi64_si128(x0, k3k4, 0x11);
+    x0 = _mm_xor_si128(_mm_xor_si128(x0, x2), x4);
+
+    x4 = _mm_clmulepi64_si128(x0, k3k4, 0x00);
+    x0 = _mm_clmulepi64_si128(x0, k3k4, 0x11);
+    x0 = _mm_xor_si128(_mm_xor_si128(x0, x3), x4);
+
+    // Fold the remaining 128-bit blocks.
+    for (; size >= 16; size -= 16, addressPtr += 16)
+    {
+        x4 = _mm_clmulepi64_si128(x0, k3k4, 0x00);
+        x0 = _mm_clmulepi64_si128(x0, k3k4, 0x11);
+        x0 = _mm_xor_si128(_mm_xor_si128(x0, x4),
+                           _mm_loadu_si128((const __m128i*)addressPtr));
+    }
+
+    // Fold 128 bits into 64 bits.
+    x1 = _mm_clmulepi64_si128(x0, k3k4, 0x10);
+    x0 = _mm_xor_si128(_mm_srli_si128(x0, 8), x1);
+
+    // Fold 64 bits into 32 bits.
+    x1 = _mm_srli_si128(x0, 4);
+    x0 = _mm_and_si128(x0, mask32);
+    x0 = _mm_clmulepi64_si128(x0, k5k0, 0x00);
+    x0 = _mm_xor_si128(x0, x1);
+
+    // Barrett reduction.
+    x1 = _mm_and_si128(x0, mask32);
+    x1 = _mm_clmulepi64_si128(x1, poly, 0x10);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, poly, 0x00);
+    x0 = _mm_xor_si128(x0, x1);
+
+    return (uint32_t)_mm_extract_epi32(x0, 1);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CRC32 using carry-less multiplication for the bulk of the buffer.
+ *
+ * @return
+ *      - 32-bit CRC
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t Crc32Clmul
+(
+    const uint8_t* addressPtr,  ///< [IN] Input buffer
+    size_t   size,              ///< [IN] Number of bytes to read
+    uint32_t crc                ///< [IN] Starting CRC seed
+)
+{
+    if (size >= 64)
+    {
+        size_t blockSize = size & ~(size_t)15;
+
+        crc = Crc32ClmulBlocks(addressPtr, blockSize, crc);
+        addressPtr += blockSize;
+        size -= blockSize;
+    }
+
+    return Crc32Slice8(addressPtr, size, crc);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether the CPU has the instructions used by Crc32ClmulBlocks().
+ */
+//--------------------------------------------------------------------------------------------------
+static bool HasClmul
+(
+    void
+)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+
+    return ((ecx & bit_PCLMUL) != 0) && ((ecx & bit_SSE4_1) != 0);
+}
+#endif // CRC_HAVE_CLMUL
+
+
+#ifdef CRC_HAVE_ARMV8
+//--------------------------------------------------------------------------------------------------
+/**
+ * Runs one of the 8 or 32-bit ARMv8 CRC32 instructions.  Registers are named differently in
+ * AArch64 and AArch32 assembly.
+ */
+//--------------------------------------------------------------------------------------------------
+#ifdef __aarch64__
+#define CRC32_INSN(insn, crc, value)    __asm__(insn " %w0, %w0, %w1" : "+r"(crc) : "r"(value))
+#else
+#define CRC32_INSN(insn, crc, value)    __asm__(insn " %0, %0, %1" : "+r"(crc) : "r"(value))
+#endif
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * CRC32 using the ARMv8 CRC32 instructions, which use the same polynomial and bit order as
+ * Crc32Table.
+ *
+ * @return
+ *      - 32-bit CRC
+ */
+//--------------------------------------------------------------------------------------------------
+#ifdef __aarch64__
+__attribute__((target("+crc")))
+#endif
+static uint32_t Crc32Armv8
+(
+    const uint8_t* addressPtr,  ///< [IN] Input buffer
+    size_t   size,              ///< [IN] Number of bytes to read
+    uint32_t crc                ///< [IN] Starting CRC seed
+)
+{
+    for (; (size > 0) && (((uintptr_t)addressPtr & 3) != 0); size--)
+    {
+        CRC32_INSN("crc32b", crc, (uint32_t)*addressPtr++);
+    }
+
+#ifdef __aarch64__
+    for (; size >= 8; size -= 8, addressPtr += 8)
+    {
+        uint64_t value;
+
+        memcpy(&value, addressPtr, sizeof(value));
+        __asm__("crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(value));
+    }
+#endif
+
+    for (; size >= 4; size -= 4, addressPtr += 4)
+    {
+        uint32_t value;
+
+        memcpy(&value, addressPtr, sizeof(value));
+        CRC32_INSN("crc32w", crc, value);
+    }
+
+    for (; size > 0; size--)
+    {
+        CRC32_INSN("crc32b", crc, (uint32_t)*addressPtr++);
+    }
+
+    return crc;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks whether the CPU has the instructions used by Crc32Armv8().
+ */
+//--------------------------------------------------------------------------------------------------
+static bool HasArmv8Crc
+(
+    void
+)
+{
+#ifdef __aarch64__
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    // Only built when the compiler targets a CPU that has them.
+    return true;
+#endif
+}
+#endif // CRC_HAVE_ARMV8
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks that an implementation gives the same results as the byte loop, for all the alignments
+ * and lengths that go through a different code path.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsImplValid
+(
+    Crc32Func_t func            ///< [IN] Implementation to check.
+)
+{
+    uint8_t buffer[256 + 8];
+    size_t i;
+
+    for (i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = (uint8_t)(i * 167 + 13);
+    }
+
+    for (i = 0; i < 8; i++)
+    {
+        static const size_t sizes[] = { 0, 1, 7, 63, 64, 65, 127, 128, 200, 256 };
+        size_t j;
+
+        for (j = 0; j < NUM_ARRAY_MEMBERS(sizes); j++)
+        {
+            if (func(buffer + i, sizes[j], LE_CRC_START_CRC32) !=
+                Crc32Bytes(buffer + i, sizes[j], LE_CRC_START_CRC32))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Builds the slicing tables and selects the fastest valid implementation for this CPU.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SelectImpl
+(
+    void
+)
+{
+    int i;
+    int k;
+
+    for (i = 0; i < 256; i++)
+    {
+        uint32_t crc = Crc32Table[i];
+
+        for (k = 0; k < 7; k++)
+        {
+            crc = (crc >> 8) ^ Crc32Table[crc & 0xFF];
+            SliceTable[k][i] = crc;
+        }
+    }
+
+    Crc32Impl = Crc32Slice8;
+
+#ifdef CRC_HAVE_CLMUL
+    if (HasClmul() && IsImplValid(Crc32Clmul))
+    {
+        Crc32Impl = Crc32Clmul;
+    }
+#endif
+
+#ifdef CRC_HAVE_ARMV8
+    if (HasArmv8Crc() && IsImplValid(Crc32Armv8))
+    {
+        Crc32Impl = Crc32Armv8;
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * This function is used to calculate a CRC-32
+ *
+ * @return
+ *      - 32-bit CRC
+ */
+//--------------------------------------------------------------------------------------------------
+uint32_t le_crc_Crc32
+(
+    uint8_t* addressPtr,///< [IN] Input buffer
+    size_t   size,      ///< [IN] Number of bytes to read
+    uint32_t crc        ///< [IN] Starting CRC seed
+)
+{
+    pthread_once(&SelectOnce, SelectImpl);
+
+    return Crc32Impl(addressPtr, size, crc);
+}
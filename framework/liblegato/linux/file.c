@@ -664,11 +664,39 @@ le_result_t file_Copy
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Copy a batch of files recursively from one directory into another.  This function copies the
- * source files' owner, permissions and extended attributes to the destination files as well.
+ * Hard link a file to a new path, falling back to copying it if a link can't be made (e.g., the
+ * destination is on another file system or the file has too many links already).
  *
- * @note Does not copy mounted files or any files under mounted directories.  Does not copy anything
- *       if the source path directory is empty.
+ * @return - LE_OK if successful.
+ *         - Any error returned by file_Copy() otherwise.
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t LinkFile
+(
+    const char* sourcePathPtr,  ///< [IN] Link to this file...
+    const char* destPathPtr     ///< [IN] From this path.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    if (link(sourcePathPtr, destPathPtr) == 0)
+    {
+        return LE_OK;
+    }
+
+    if ((errno != EXDEV) && (errno != EMLINK) && (errno != EPERM))
+    {
+        LE_CRIT("Failed to link '%s' to '%s'. (%m)", destPathPtr, sourcePathPtr);
+        return LE_IO_ERROR;
+    }
+
+    return file_Copy(sourcePathPtr, destPathPtr, NULL);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy a directory tree, either copying or hard linking the regular files in it.  See
+ * file_CopyRecursive() and file_LinkRecursive().
  *
  * @return - LE_OK if the copy was successful.
  *         - LE_NOT_PERMITTED if either the source or destination paths are not files or could not
@@ -677,11 +705,12 @@ le_result_t file_Copy
  *         - LE_NOT_FOUND if source file or the destination directory does not exist.
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t file_CopyRecursive
+static le_result_t CopyTree
 (
     const char* sourcePathPtr,  ///< [IN] Copy recursively from this path...
     const char* destPathPtr,    ///< [IN] To this path.
-    const char* smackLabelPtr   ///< [IN] If not NULL, the file will have this smack label set.
+    const char* smackLabelPtr,  ///< [IN] If not NULL, the file will have this smack label set.
+    bool linkFiles              ///< [IN] true to hard link regular files instead of copying them.
 )
 //--------------------------------------------------------------------------------------------------
 {
@@ -699,6 +728,11 @@ le_result_t file_CopyRecursive
     // If the source is a file, then just copy it.
     if (S_ISREG(sourceStatus.st_mode))
     {
+        if (linkFiles)
+        {
+            return LinkFile(sourcePathPtr, destPathPtr);
+        }
+
         return file_Copy(sourcePathPtr, destPathPtr, smackLabelPtr);
     }
 
@@ -792,7 +826,15 @@ le_result_t file_CopyRecursive
             case FTS_F:
                 if (!fs_IsMountPoint(entPtr->fts_path))
                 {
-                    result = file_Copy(entPtr->fts_path, newPath, smackLabelPtr);
+                    if (linkFiles)
+                    {
+                        result = LinkFile(entPtr->fts_path, newPath);
+                    }
+                    else
+                    {
+                        result = file_Copy(entPtr->fts_path, newPath, smackLabelPtr);
+                    }
+
                     if (result != LE_OK)
                     {
                         goto cleanup;
@@ -877,6 +919,62 @@ le_result_t file_CopyRecursive
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Copy a batch of files recursively from one directory into another.  This function copies the
+ * source files' owner, permissions and extended attributes to the destination files as well.
+ *
+ * @note Does not copy mounted files or any files under mounted directories.  Does not copy anything
+ *       if the source path directory is empty.
+ *
+ * @return - LE_OK if the copy was successful.
+ *         - LE_NOT_PERMITTED if either the source or destination paths are not files or could not
+ *           be opened.
+ *         - LE_IO_ERROR if an IO error occurs during the copy operation.
+ *         - LE_NOT_FOUND if source file or the destination directory does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t file_CopyRecursive
+(
+    const char* sourcePathPtr,  ///< [IN] Copy recursively from this path...
+    const char* destPathPtr,    ///< [IN] To this path.
+    const char* smackLabelPtr   ///< [IN] If not NULL, the file will have this smack label set.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return CopyTree(sourcePathPtr, destPathPtr, smackLabelPtr, false);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recreate a directory tree under another path, hard linking the regular files rather than copying
+ * them.  Directories and symlinks are created the same way file_CopyRecursive() does.  Files that
+ * can't be linked (e.g., because the destination is on another file system) are copied.
+ *
+ * @warning The source and destination share the files' contents and attributes afterwards, so
+ *          this must only be used on trees whose files are never modified in place.
+ *
+ * @note Does not link mounted files or any files under mounted directories.
+ *
+ * @return - LE_OK if successful.
+ *         - LE_NOT_PERMITTED if either the source or destination paths are not files or could not
+ *           be opened.
+ *         - LE_IO_ERROR if an IO error occurs.
+ *         - LE_NOT_FOUND if source file or the destination directory does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t file_LinkRecursive
+(
+    const char* sourcePathPtr,  ///< [IN] Link recursively from this path...
+    const char* destPathPtr     ///< [IN] To this path.
+)
+//--------------------------------------------------------------------------------------------------
+{
+    return CopyTree(sourcePathPtr, destPathPtr, NULL, true);
+}
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Rename a file or directory.
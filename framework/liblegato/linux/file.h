@@ -135,6 +135,31 @@ le_result_t file_CopyRecursive
 );
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Recreate a directory tree under another path, hard linking the regular files rather than copying
+ * them.  Directories and symlinks are created the same way file_CopyRecursive() does.  Files that
+ * can't be linked (e.g., because the destination is on another file system) are copied.
+ *
+ * @warning The source and destination share the files' contents and attributes afterwards, so
+ *          this must only be used on trees whose files are never modified in place.
+ *
+ * @note Does not link mounted files or any files under mounted directories.
+ *
+ * @return - LE_OK if successful.
+ *         - LE_NOT_PERMITTED if either the source or destination paths are not files or could not
+ *           be opened.
+ *         - LE_IO_ERROR if an IO error occurs.
+ *         - LE_NOT_FOUND if source file or the destination directory does not exist.
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t file_LinkRecursive
+(
+    const char* sourcePathPtr,  ///< [IN] Link recursively from this path...
+    const char* destPathPtr     ///< [IN] To this path.
+);
+
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Rename a file or directory.
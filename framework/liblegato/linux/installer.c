@@ -116,8 +116,10 @@ le_result_t installer_InstallAppWriteableFiles
                      appMd5Ptr);
     LE_ASSERT(baseDirPathLen < sizeof(freshWriteablesDir));
 
+    // This runs on several install threads at once: fts must not change the process's working
+    // directory.
     char* pathArrayPtr[] = { freshWriteablesDir, NULL };
-    FTS* ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL, NULL);
+    FTS* ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL | FTS_NOCHDIR, NULL);
 
     if (ftsPtr == NULL)
     {
@@ -308,7 +310,7 @@ le_result_t installer_UpdateAppWriteableFiles
     LE_ASSERT(baseDirPathLen < sizeof(freshWriteablesDir));
 
     char* pathArrayPtr[] = { freshWriteablesDir, NULL };
-    FTS* ftsPtr = fts_open(pathArrayPtr, FTS_LOGICAL, NULL);
+    FTS* ftsPtr = fts_open(pathArrayPtr, FTS_LOGICAL | FTS_NOCHDIR, NULL);
 
     if (ftsPtr == NULL)
     {
@@ -432,7 +434,7 @@ le_result_t installer_UpdateAppWriteableFiles
                               appNamePtr);
     LE_ASSERT(baseDirPathLen < sizeof(appWriteableDirPath));
     pathArrayPtr[0] = appWriteableDirPath;
-    ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL, NULL);
+    ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL | FTS_NOCHDIR, NULL);
 
     if (ftsPtr == NULL)
     {
@@ -567,7 +569,7 @@ le_result_t installer_RemoveAppWriteableDeviceFiles
                                  appNamePtr);
     LE_ASSERT(baseDirPathLen < sizeof(appWriteableDirPath));
     char* pathArrayPtr[] = { appWriteableDirPath, NULL };
-    FTS*  ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL, NULL);
+    FTS*  ftsPtr = fts_open(pathArrayPtr, FTS_PHYSICAL | FTS_NOCHDIR, NULL);
 
     if (ftsPtr == NULL)
     {
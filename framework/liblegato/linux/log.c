@@ -620,18 +620,14 @@ static bool ParseCmdPacket
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Processes a remote logging command.  This function should be called by the event loop when there
- * is a received log command.
+ * Processes a single log command packet received from the Log Control Daemon.
  */
 //--------------------------------------------------------------------------------------------------
-static void ProcessLogCmd
+static void ProcessCmdPacket
 (
-    le_msg_MessageRef_t msgRef,
-    void*               contextPtr  // not used.
+    const char* cmdPacketPtr    ///< [IN] The command packet.
 )
 {
-    char* cmdPacketPtr = le_msg_GetPayloadPtr(msgRef);
-
     char command;
     char componentName[LIMIT_MAX_COMPONENT_NAME_BYTES];
     const char* commandDataPtr;
@@ -670,6 +666,40 @@ static void ProcessLogCmd
     {
         LE_ERROR("Malformed command packet '%s'.", cmdPacketPtr);
     }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Processes a remote logging command.  This function should be called by the event loop when there
+ * is a received log command.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ProcessLogCmd
+(
+    le_msg_MessageRef_t msgRef,
+    void*               contextPtr  // not used.
+)
+{
+    char* cmdPacketPtr = le_msg_GetPayloadPtr(msgRef);
+
+    // A batch holds several newline-terminated command packets for this process.
+    if (cmdPacketPtr[0] == LOG_CMD_BATCH)
+    {
+        char* savePtr;
+        char* packetPtr = strtok_r(cmdPacketPtr + 1, "\n", &savePtr);
+
+        while (packetPtr != NULL)
+        {
+            ProcessCmdPacket(packetPtr);
+
+            packetPtr = strtok_r(NULL, "\n", &savePtr);
+        }
+    }
+    else
+    {
+        ProcessCmdPacket(cmdPacketPtr);
+    }
 
     le_msg_ReleaseMsg(msgRef);
 }
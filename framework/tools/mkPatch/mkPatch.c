@@ -9,15 +9,16 @@
 #define _LARGEFILE64_SOURCE
 #include "legato.h"
 #include <endian.h>
+#include <pthread.h>
 
 #include "flash-ubi.h"
+#include "bsdiff.h"
 
 //--------------------------------------------------------------------------------------------------
 /**
  * Defines some executables requested by the tool
  */
 //--------------------------------------------------------------------------------------------------
-#define BSDIFF "bsdiff"
 #define HDRCNV "hdrcnv"
 
 //--------------------------------------------------------------------------------------------------
@@ -119,6 +120,39 @@ typedef struct
 }
 VtblMap_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Patch computed for a segment of the destination image
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t* patchPtr;       ///< Patch in BSDIFF40 format
+    size_t   size;           ///< Size of the patch
+}
+SegmentPatch_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Work shared by the threads computing the segment patches. Each thread takes the next segment
+ * not yet handled and stores its patch at the index of the segment, so the output does not depend
+ * on the number of threads nor on the order they finish.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    const bsDiffIndex_t* indexPtr;  ///< Index of the original image
+    const uint8_t* destPtr;         ///< Destination image
+    size_t destSize;                ///< Size of the destination image
+    size_t segmentSize;             ///< Size of a segment
+    uint32_t numSegments;           ///< Number of segments
+    SegmentPatch_t* patchesPtr;     ///< Patches, one per segment
+    pthread_mutex_t mutex;          ///< Protects the fields below
+    uint32_t nextSegment;           ///< Next segment to handle
+    bool isFailed;                  ///< A segment patch could not be computed
+}
+DiffWork_t;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Map array for all volumes of an UBI image
@@ -212,10 +246,10 @@ static uint8_t Chunk[SEGMENT_SIZE];
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Buffer for the segment patch
+ * Number of threads computing the segment patches. 0 means one per online CPU
  */
 //--------------------------------------------------------------------------------------------------
-static uint8_t PatchedChunk[2 * SEGMENT_SIZE];
+static int DiffJobs = 0;
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -749,6 +783,211 @@ clean_exit:
     return res;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a whole image in memory. Exit on failure.
+ *
+ * @return
+ *      - Pointer to the image, to release with free(3)
+ */
+//--------------------------------------------------------------------------------------------------
+static uint8_t* ReadImage
+(
+    int    fd,               ///< [IN] File descriptor of the image
+    char*  fileNamePtr,      ///< [IN] Name of the image
+    size_t* sizePtr          ///< [OUT] Size of the image
+)
+{
+    struct stat st;
+    uint8_t* imagePtr;
+    size_t readLen = 0;
+    ssize_t rc;
+
+    if( 0 > fstat( fd, &st ) )
+    {
+        fprintf(stderr, "fstat() of '%s' fails: %m\n", fileNamePtr);
+        exit(1);
+    }
+    // We use malloc(3). No alternative to this within the tool
+    imagePtr = (uint8_t*)malloc(st.st_size + 1);
+    if( NULL == imagePtr )
+    {
+        fprintf(stderr, "Malloc fails: %m\n");
+        exit(1);
+    }
+    while( readLen < st.st_size )
+    {
+        rc = read( fd, imagePtr + readLen, st.st_size - readLen );
+        if( (0 > rc) && ((EAGAIN == errno) || (EINTR == errno)) )
+        {
+            continue;
+        }
+        if( 0 >= rc )
+        {
+            fprintf(stderr, "read() of '%s' fails: %m\n", fileNamePtr);
+            exit(4);
+        }
+        readLen += rc;
+    }
+    *sizePtr = st.st_size;
+    return imagePtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Thread computing segment patches until all segments are handled.
+ */
+//--------------------------------------------------------------------------------------------------
+static void* DiffThread
+(
+    void* contextPtr         ///< [IN] Work shared by the threads
+)
+{
+    DiffWork_t* workPtr = (DiffWork_t*)contextPtr;
+    uint32_t segment;
+    size_t offset, size;
+    le_result_t res;
+
+    for( ;; )
+    {
+        pthread_mutex_lock( &workPtr->mutex );
+        segment = workPtr->nextSegment++;
+        if( workPtr->isFailed )
+        {
+            segment = workPtr->numSegments;
+        }
+        pthread_mutex_unlock( &workPtr->mutex );
+
+        if( segment >= workPtr->numSegments )
+        {
+            break;
+        }
+
+        offset = (size_t)segment * workPtr->segmentSize;
+        size = workPtr->destSize - offset;
+        if( size > workPtr->segmentSize )
+        {
+            size = workPtr->segmentSize;
+        }
+
+        res = bsDiff( workPtr->indexPtr, workPtr->destPtr + offset, size,
+                      &workPtr->patchesPtr[segment].patchPtr,
+                      &workPtr->patchesPtr[segment].size );
+        if( LE_OK != res )
+        {
+            fprintf(stderr, "bsDiff() of segment %u fails: %d\n", segment, res);
+            pthread_mutex_lock( &workPtr->mutex );
+            workPtr->isFailed = true;
+            pthread_mutex_unlock( &workPtr->mutex );
+            break;
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the patches of all segments of the destination image against the whole original image,
+ * on several threads. Exit on failure.
+ *
+ * @return
+ *      - Array of patches, one per segment, to release with FreeSegmentPatches()
+ */
+//--------------------------------------------------------------------------------------------------
+static SegmentPatch_t* DiffSegments
+(
+    const bsDiffIndex_t* indexPtr,  ///< [IN] Index of the original image
+    const uint8_t* destPtr,         ///< [IN] Destination image
+    size_t destSize,                ///< [IN] Size of the destination image
+    size_t segmentSize,             ///< [IN] Size of a segment
+    int jobs,                       ///< [IN] Number of threads. 0 means one per online CPU
+    uint32_t* numSegmentsPtr        ///< [OUT] Number of segments
+)
+{
+    DiffWork_t work;
+    pthread_t threads[64];
+    int i, rc;
+
+    memset( &work, 0, sizeof(work) );
+    work.indexPtr = indexPtr;
+    work.destPtr = destPtr;
+    work.destSize = destSize;
+    work.segmentSize = segmentSize;
+    work.numSegments = (destSize + segmentSize - 1) / segmentSize;
+    pthread_mutex_init( &work.mutex, NULL );
+
+    // We use calloc(3). No alternative to this within the tool
+    work.patchesPtr = (SegmentPatch_t*)calloc(work.numSegments + 1, sizeof(SegmentPatch_t));
+    if( NULL == work.patchesPtr )
+    {
+        fprintf(stderr, "Calloc fails: %m\n");
+        exit(1);
+    }
+
+    if( 0 >= jobs )
+    {
+        jobs = sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if( jobs > (int)NUM_ARRAY_MEMBERS(threads) )
+    {
+        jobs = NUM_ARRAY_MEMBERS(threads);
+    }
+    if( jobs > (int)work.numSegments )
+    {
+        jobs = work.numSegments;
+    }
+    if( IsVerbose )
+    {
+        fprintf(stderr, "Diffing %u segments on %d threads\n", work.numSegments, jobs);
+    }
+
+    // The calling thread takes its share of the work too.
+    for( i = 1; i < jobs; i++ )
+    {
+        rc = pthread_create( &threads[i], NULL, DiffThread, &work );
+        if( rc )
+        {
+            fprintf(stderr, "pthread_create() fails: %d\n", rc);
+            exit(1);
+        }
+    }
+    DiffThread( &work );
+    for( i = 1; i < jobs; i++ )
+    {
+        pthread_join( threads[i], NULL );
+    }
+    pthread_mutex_destroy( &work.mutex );
+
+    if( work.isFailed )
+    {
+        exit(8);
+    }
+
+    *numSegmentsPtr = work.numSegments;
+    return work.patchesPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Release the patches returned by DiffSegments()
+ */
+//--------------------------------------------------------------------------------------------------
+static void FreeSegmentPatches
+(
+    SegmentPatch_t* patchesPtr,     ///< [IN] Patches
+    uint32_t numSegments            ///< [IN] Number of segments
+)
+{
+    uint32_t i;
+
+    for( i = 0; i < numSegments; i++ )
+    {
+        // We use free(3). No alternative to this within the tool
+        free( patchesPtr[i].patchPtr );
+    }
+    free( patchesPtr );
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Call at exit(3) to perform all clean-up actions
@@ -791,6 +1030,313 @@ static void ExecSystem
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pseudo-random generator for the benchmark images, so that they are the same on every run
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t BenchRandom
+(
+    uint32_t* statePtr       ///< [IN/OUT] Generator state
+)
+{
+    uint32_t x = *statePtr;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *statePtr = x;
+    return x;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Fill a 4K block of a benchmark image with data looking like file system content: text, already
+ * compressed data, or erased/zeroed space.
+ */
+//--------------------------------------------------------------------------------------------------
+static void FillBenchBlock
+(
+    uint8_t* blockPtr,       ///< [OUT] Block to fill
+    size_t size,             ///< [IN] Size of the block
+    uint32_t* statePtr       ///< [IN/OUT] Generator state
+)
+{
+    static const char* const words[] =
+    {
+        "legato ", "config ", "/legato/systems/current/", "app ", "le_result_t ", "LE_OK ",
+        "#include ", "return ", "0x00000000 ", "supervisor ", "\n", "libc.so.6 ",
+    };
+    uint32_t kind = BenchRandom(statePtr) % 10;
+    size_t i;
+
+    if( kind < 5 )
+    {
+        for( i = 0; i < size; )
+        {
+            const char* wordPtr = words[BenchRandom(statePtr) % NUM_ARRAY_MEMBERS(words)];
+
+            while( *wordPtr && (i < size) )
+            {
+                blockPtr[i++] = *wordPtr++;
+            }
+        }
+    }
+    else if( kind < 8 )
+    {
+        for( i = 0; i < size; i++ )
+        {
+            blockPtr[i] = BenchRandom(statePtr);
+        }
+    }
+    else
+    {
+        memset( blockPtr, (kind == 8) ? 0 : ERASED_VALUE, size );
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the data of a dynamic UBI volume (ID 0) as an UBI image: a layout volume PEB followed by
+ * one PEB per LEB of data. Exit on failure.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WriteBenchUbiImage
+(
+    char*    fileNamePtr,    ///< [IN] File name of the image
+    uint8_t* dataPtr,        ///< [IN] Volume data, a multiple of the LEB size
+    size_t   dataSize        ///< [IN] Size of the volume data
+)
+{
+    size_t lebSize = FlashPEBSize - (2 * FlashPageSize);
+    uint32_t lebCount = dataSize / lebSize;
+    uint8_t* pebPtr = (uint8_t*)malloc(FlashPEBSize);
+    struct ubi_ec_hdr* ecHeaderPtr = (struct ubi_ec_hdr*)pebPtr;
+    struct ubi_vid_hdr* vidHeaderPtr = (struct ubi_vid_hdr*)(pebPtr + FlashPageSize);
+    struct ubi_vtbl_record* vtblPtr = (struct ubi_vtbl_record*)(pebPtr + (2 * FlashPageSize));
+    uint32_t peb;
+    int i, fd;
+
+    if( NULL == pebPtr )
+    {
+        fprintf(stderr, "Malloc fails: %m\n");
+        exit(1);
+    }
+    fd = open( fileNamePtr, O_WRONLY | O_TRUNC | O_CREAT, S_IWUSR | S_IRUSR );
+    if( 0 > fd )
+    {
+        fprintf(stderr, "Open of '%s' fails: %m\n", fileNamePtr);
+        exit(1);
+    }
+
+    for( peb = 0; peb <= lebCount; peb++ )
+    {
+        memset( pebPtr, ERASED_VALUE, FlashPEBSize );
+
+        memset( ecHeaderPtr, 0, UBI_EC_HDR_SIZE );
+        ecHeaderPtr->magic = htobe32(UBI_EC_HDR_MAGIC);
+        ecHeaderPtr->version = UBI_VERSION;
+        ecHeaderPtr->vid_hdr_offset = htobe32(FlashPageSize);
+        ecHeaderPtr->data_offset = htobe32(2 * FlashPageSize);
+        ecHeaderPtr->image_seq = htobe32(UBI_IMAGE_SEQ_BASE);
+        ecHeaderPtr->hdr_crc = htobe32(le_crc_Crc32( (uint8_t*)ecHeaderPtr, UBI_EC_HDR_SIZE_CRC,
+                                                     LE_CRC_START_CRC32 ));
+
+        memset( vidHeaderPtr, 0, UBI_VID_HDR_SIZE );
+        vidHeaderPtr->magic = htobe32(UBI_VID_HDR_MAGIC);
+        vidHeaderPtr->version = UBI_VERSION;
+        vidHeaderPtr->vol_type = UBI_VID_DYNAMIC;
+        if( 0 == peb )
+        {
+            vidHeaderPtr->vol_id = htobe32(UBI_LAYOUT_VOLUME_ID);
+            vidHeaderPtr->lnum = 0;
+
+            for( i = 0; i < UBI_MAX_VOLUMES; i++ )
+            {
+                memset( &vtblPtr[i], 0, UBI_VTBL_RECORD_HDR_SIZE );
+                vtblPtr[i].reserved_pebs = (uint32_t)-1;
+            }
+            vtblPtr[0].reserved_pebs = htobe32(lebCount);
+            vtblPtr[0].alignment = htobe32(1);
+            vtblPtr[0].vol_type = UBI_VID_DYNAMIC;
+            vtblPtr[0].name_len = htobe16(5);
+            memcpy( vtblPtr[0].name, "bench", 5 );
+            vtblPtr[0].crc = htobe32(le_crc_Crc32( (uint8_t*)&vtblPtr[0], UBI_VTBL_RECORD_SIZE_CRC,
+                                                   LE_CRC_START_CRC32 ));
+        }
+        else
+        {
+            vidHeaderPtr->vol_id = 0;
+            vidHeaderPtr->lnum = htobe32(peb - 1);
+            memcpy( pebPtr + (2 * FlashPageSize), dataPtr + ((peb - 1) * lebSize), lebSize );
+        }
+        vidHeaderPtr->hdr_crc = htobe32(le_crc_Crc32( (uint8_t*)vidHeaderPtr, UBI_VID_HDR_SIZE_CRC,
+                                                      LE_CRC_START_CRC32 ));
+
+        if( FlashPEBSize != write( fd, pebPtr, FlashPEBSize ) )
+        {
+            fprintf(stderr, "write() fails: %m\n");
+            exit(1);
+        }
+    }
+    close( fd );
+    // We use free(3). No alternative to this within the tool
+    free( pebPtr );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build an UBI image of about the given size and a modified copy of it, extract their volume the
+ * way delta patches of UBI images are built, and time the computation of the segment patches with
+ * a single thread and with one thread per online CPU. Exit on failure, or if the patches differ.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunBenchmark
+(
+    char* sizePtr            ///< [IN] Size of the images in MiB
+)
+{
+    size_t lebSize, dataSize, origSize, destSize, patchSize = 0;
+    uint8_t *origPtr, *destPtr;
+    uint32_t state = 0x2545F491;
+    uint32_t numSegments, numSegmentsN, i;
+    size_t inPos, outPos;
+    SegmentPatch_t *patchesPtr, *patchesNPtr;
+    bsDiffIndex_t* indexPtr;
+    struct timespec t0, t1, t2, t3;
+    char* endPtr;
+    int fd, nbVolume, jobs;
+    unsigned long sizeMiB;
+    uint32_t crc32;
+
+    errno = 0;
+    sizeMiB = strtoul( sizePtr, &endPtr, 10 );
+    if( (errno) || (*endPtr) || (0 == sizeMiB) || (256 < sizeMiB) )
+    {
+        fprintf(stderr, "Incorrect benchmark size '%s' (1 to 256 MiB)\n", sizePtr );
+        exit(1);
+    }
+    FlashPageSize = FLASH_PAGESIZE_4K;
+    FlashPEBSize = FLASH_PEBSIZE_256K;
+    lebSize = FlashPEBSize - (2 * FlashPageSize);
+    dataSize = ((sizeMiB * 1024 * 1024) / lebSize) * lebSize;
+    if( dataSize > (NUM_ARRAY_MEMBERS(VtblMap[0].lebToPeb) - 1) * lebSize )
+    {
+        dataSize = (NUM_ARRAY_MEMBERS(VtblMap[0].lebToPeb) - 1) * lebSize;
+    }
+
+    // We use malloc(3). No alternative to this within the tool
+    origPtr = (uint8_t*)malloc(dataSize);
+    destPtr = (uint8_t*)malloc(dataSize);
+    if( (NULL == origPtr) || (NULL == destPtr) )
+    {
+        fprintf(stderr, "Malloc fails: %m\n");
+        exit(1);
+    }
+    for( inPos = 0; inPos < dataSize; inPos += 4096 )
+    {
+        FillBenchBlock( origPtr + inPos, ((dataSize - inPos) > 4096) ? 4096 : (dataSize - inPos),
+                        &state );
+    }
+
+    // The destination keeps most blocks, but some are rewritten, inserted or dropped, which
+    // shifts the rest of the image like a rebuilt file system would.
+    for( inPos = 0, outPos = 0; outPos < dataSize; )
+    {
+        size_t len = ((dataSize - outPos) > 4096) ? 4096 : (dataSize - outPos);
+        uint32_t change = BenchRandom(&state) % 100;
+
+        if( (change < 3) || (inPos >= dataSize) )
+        {
+            FillBenchBlock( destPtr + outPos, len, &state );
+            outPos += len;
+            inPos += (change == 0) ? 0 : 4096;
+        }
+        else if( change < 4 )
+        {
+            inPos += 4096;
+        }
+        else
+        {
+            len = (len > (dataSize - inPos)) ? (dataSize - inPos) : len;
+            memcpy( destPtr + outPos, origPtr + inPos, len );
+            outPos += len;
+            inPos += len;
+        }
+    }
+
+    WriteBenchUbiImage( "bench.orig.ubi", origPtr, dataSize );
+    WriteBenchUbiImage( "bench.dest.ubi", destPtr, dataSize );
+    free( origPtr );
+    free( destPtr );
+
+    fd = open( "bench.orig.ubi", O_RDONLY );
+    if( (0 > fd) || (LE_OK != ScanUbi( fd, (1 + (dataSize / lebSize)) * FlashPEBSize, &nbVolume ))
+        || (1 != nbVolume) || (LE_OK != ExtractUbiData( fd, 0, "bench.orig.0", &origSize, &crc32 )) )
+    {
+        fprintf(stderr, "Unable to extract the benchmark original volume\n");
+        exit(1);
+    }
+    close( fd );
+    fd = open( "bench.dest.ubi", O_RDONLY );
+    if( (0 > fd) || (LE_OK != ScanUbi( fd, (1 + (dataSize / lebSize)) * FlashPEBSize, &nbVolume ))
+        || (1 != nbVolume) || (LE_OK != ExtractUbiData( fd, 0, "bench.dest.0", &destSize, &crc32 )) )
+    {
+        fprintf(stderr, "Unable to extract the benchmark destination volume\n");
+        exit(1);
+    }
+    close( fd );
+
+    fd = open( "bench.orig.0", O_RDONLY );
+    origPtr = ReadImage( fd, "bench.orig.0", &origSize );
+    close( fd );
+    fd = open( "bench.dest.0", O_RDONLY );
+    destPtr = ReadImage( fd, "bench.dest.0", &destSize );
+    close( fd );
+
+    jobs = sysconf( _SC_NPROCESSORS_ONLN );
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    indexPtr = bsDiffCreateIndex( origPtr, origSize );
+    if( NULL == indexPtr )
+    {
+        fprintf(stderr, "Unable to index the benchmark original volume: out of memory\n");
+        exit(1);
+    }
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+    patchesPtr = DiffSegments( indexPtr, destPtr, destSize, lebSize, 1, &numSegments );
+    clock_gettime( CLOCK_MONOTONIC, &t2 );
+    patchesNPtr = DiffSegments( indexPtr, destPtr, destSize, lebSize, jobs, &numSegmentsN );
+    clock_gettime( CLOCK_MONOTONIC, &t3 );
+
+    for( i = 0; i < numSegments; i++ )
+    {
+        if( (patchesPtr[i].size != patchesNPtr[i].size) ||
+            memcmp( patchesPtr[i].patchPtr, patchesNPtr[i].patchPtr, patchesPtr[i].size ) )
+        {
+            fprintf(stderr, "Patch of segment %u differs between 1 and %d threads\n", i, jobs);
+            exit(9);
+        }
+        patchSize += patchesPtr[i].size;
+    }
+
+#define ELAPSED_MS(start, end) \
+    (((end).tv_sec - (start).tv_sec) * 1000.0 + ((end).tv_nsec - (start).tv_nsec) / 1000000.0)
+
+    printf("Volume %zu bytes, %u segments of %zu bytes, patch %zu bytes\n",
+           destSize, numSegments, lebSize, patchSize);
+    printf("Index of original image: %.0f ms\n", ELAPSED_MS(t0, t1));
+    printf("Segment patches, 1 thread: %.0f ms\n", ELAPSED_MS(t1, t2));
+    printf("Segment patches, %d threads: %.0f ms (x%.1f), identical output\n",
+           jobs, ELAPSED_MS(t2, t3), ELAPSED_MS(t1, t2) / ELAPSED_MS(t2, t3));
+
+    FreeSegmentPatches( patchesPtr, numSegments );
+    FreeSegmentPatches( patchesNPtr, numSegmentsN );
+    bsDiffDeleteIndex( indexPtr );
+    free( origPtr );
+    free( destPtr );
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Print usage and exit...
@@ -802,9 +1348,10 @@ static void Usage
 )
 {
     fprintf(stderr,
-            "usage: %s -T TARGET [-o patchname] [-S 4K|2K] [-E 256K|128K] [-N] [-v]\n"
-            "        {-p PART {[-U VOLID] file-orig file-dest}}\n",
-            ProgName );
+            "usage: %s -T TARGET [-o patchname] [-S 4K|2K] [-E 256K|128K] [-j JOBS] [-N] [-v]\n"
+            "        {-p PART {[-U VOLID] file-orig file-dest}}\n"
+            "       %s --benchmark SIZE_MB\n",
+            ProgName, ProgName );
     fprintf(stderr, "\n");
     fprintf(stderr, "   -T, --target <TARGET>\n"
                     "        Specify the TARGET (mandatory - specified only one time).\n");
@@ -815,6 +1362,9 @@ static void Usage
                     "        Specify another page size (optional - specified only one time).\n");
     fprintf(stderr, "   -E, --pebsize <256K|128K>\n"
                     "        Specify another PEB size (optional - specified only one time).\n");
+    fprintf(stderr, "   -j, --jobs <JOBS>\n"
+                    "        Number of threads computing the patch segments."
+                           " Else use one per online CPU.\n");
     fprintf(stderr, "   -N, --no-spkg-header\n"
                     "        Do not generate the CWE SPKG header.\n");
     fprintf(stderr, "   -v, --verbose\n"
@@ -823,6 +1373,8 @@ static void Usage
                     "        Specify the partition where apply the patch.\n");
     fprintf(stderr, "   -U, --ubi <VOLID>\n"
                     "        Specify the UBI volume ID where apply the patch.\n");
+    fprintf(stderr, "   --benchmark <SIZE_MB>\n"
+                    "        Time the patch computation between two synthetic UBI images.\n");
     fprintf(stderr, "\n");
     exit(1);
 }
@@ -885,7 +1437,12 @@ int main
 {
     char tmpName[PATH_MAX];
     int fdr, fdw, fdp;
-    int len, patchNum = 0;
+    uint32_t patchNum = 0;
+    uint8_t *origPtr, *destPtr;
+    size_t origSize, destSize, segmentLen;
+    bsDiffIndex_t* origIndexPtr;
+    SegmentPatch_t* patchesPtr;
+    uint32_t numSegments;
     int iargc = argc;
     char** argvPtr = &argv[1];
     struct stat st;
@@ -910,8 +1467,6 @@ int main
 
     ProgName = argv[0];
 
-    CheckForTool( BSDIFF, NULL );
-
     getcwd(CurrentWorkDir, sizeof(CurrentWorkDir));
     atexit( Exithandler );
     snprintf( CmdBuf, sizeof(CmdBuf), "/tmp/patchdir.%u", pid );
@@ -926,6 +1481,12 @@ int main
         exit( 1 );
     }
 
+    if( (3 == argc) && (0 == strcmp(argv[1], "--benchmark")) )
+    {
+        RunBenchmark( argv[2] );
+        exit( 0 );
+    }
+
     while( argc > 1 )
     {
         if( (iargc >= 5) &&
@@ -1036,6 +1597,23 @@ int main
             iargc -= 2;
         }
 
+        else if( (iargc >= 5) &&
+                 ((0 == strcmp(*argvPtr, "--jobs")) || (0 == strcmp(*argvPtr, "-j"))) )
+        {
+            char *endPtr;
+
+            ++argvPtr;
+            errno = 0;
+            DiffJobs = strtol( *argvPtr, &endPtr, 10 );
+            if( (errno) || (*endPtr) || (1 > DiffJobs) )
+            {
+                fprintf(stderr, "Incorrect number of jobs '%s'\n", *argvPtr );
+                exit(1);
+            }
+            ++argvPtr;
+            iargc -= 2;
+        }
+
         else if( (iargc >= 4) &&
                  ((0 == strcmp(*argvPtr, "--no-spkg-header")) || (0 == strcmp(*argvPtr, "-N"))) )
         {
@@ -1235,14 +1813,18 @@ int main
             fstat( fdr, &st );
             PatchMetaHeader.origSize = htobe32(st.st_size);
 
-            crc32Orig = LE_CRC_START_CRC32;
+            origPtr = ReadImage( fdr, OrigName, &origSize );
+            close( fdr );
+            crc32Orig = le_crc_Crc32( origPtr, origSize, LE_CRC_START_CRC32 );
+            PatchMetaHeader.origCrc32 = htobe32(crc32Orig);
 
-            while( 0 < (len = read( fdr, Chunk, chunkLen )) )
+            // The suffix sort of the original image is shared by all segments.
+            origIndexPtr = bsDiffCreateIndex( origPtr, origSize );
+            if( NULL == origIndexPtr )
             {
-                crc32Orig = le_crc_Crc32( Chunk, len, crc32Orig );
+                fprintf(stderr, "Unable to index origin file %s: out of memory\n", OrigName);
+                exit(1);
             }
-            close( fdr );
-            PatchMetaHeader.origCrc32 = htobe32(crc32Orig);
 
             if( notUbiOpt && isUbiImage )
             {
@@ -1280,59 +1862,35 @@ int main
             }
             write( fdp, &PatchMetaHeader, sizeof(PatchMetaHeader) );
 
-            while( 0 < (len = read( fdr, Chunk, chunkLen)) )
+            destPtr = ReadImage( fdr, DestName, &destSize );
+            patchesPtr = DiffSegments( origIndexPtr, destPtr, destSize, chunkLen, DiffJobs,
+                                       &numSegments );
+
+            // Write the segment patches in order.
+            for( patchNum = 0; patchNum < numSegments; patchNum++ )
             {
-                crc32Dest = le_crc_Crc32( Chunk, len, crc32Dest );
-                snprintf( tmpName, sizeof(tmpName), "patchdest.%u.bin.%d", pid, patchNum );
-                fdw = open( tmpName, O_WRONLY | O_TRUNC | O_CREAT, S_IWUSR | S_IRUSR );
-                if( 0 <= fdw )
-                {
-                    write( fdw, Chunk, len );
-                    close( fdw );
-                }
-                else {
-                    fprintf( stderr, "Open of patch file %s fails: %m\n", tmpName );
-                    exit(3);
-                }
-                snprintf( CmdBuf, sizeof(CmdBuf),
-                          BSDIFF " %s %s patched.%u.bin.%d",
-                          OrigName, tmpName, pid, patchNum );
-                if( IsVerbose )
+                segmentLen = destSize - (patchNum * chunkLen);
+                if( segmentLen > chunkLen )
                 {
-                    printf( "%s\n", CmdBuf );
+                    segmentLen = chunkLen;
                 }
-                ExecSystem( CmdBuf );
-                snprintf( tmpName, sizeof(tmpName), "patched.%u.bin.%d", pid, patchNum );
-                fdw = open( tmpName, O_RDONLY );
-                if( 0 > fdw )
-                {
-                    fprintf(stderr, "Unable to open destination file %s: %m\n", tmpName);
-                    exit(1);
-                }
-                fstat( fdw, &st );
+                crc32Dest = le_crc_Crc32( destPtr + (patchNum * chunkLen), segmentLen, crc32Dest );
                 PatchHeader.offset = htobe32(patchNum * chunkLen);
-                patchNum++;
-                PatchHeader.number = htobe32(patchNum);
-                PatchHeader.size = htobe32(st.st_size);
+                PatchHeader.number = htobe32(patchNum + 1);
+                PatchHeader.size = htobe32(patchesPtr[patchNum].size);
                 printf("Patch Header: offset 0x%x number %d size %u (0x%x)\n",
                        be32toh(PatchHeader.offset), be32toh(PatchHeader.number),
                        be32toh(PatchHeader.size), be32toh(PatchHeader.size));
-                len = read( fdw, PatchedChunk, st.st_size );
-                if( 0 > len )
-                {
-                    fprintf(stderr, "read() fails: %m\n" );
-                    exit(4);
-                }
-                close(fdw);
                 write( fdp, &PatchHeader, sizeof(PatchHeader) );
-                write( fdp, PatchedChunk, st.st_size );
-            }
-            if( len < 0 )
-            {
-                fprintf(stderr, "read() fails: %m\n" );
-                exit(4);
+                write( fdp, patchesPtr[patchNum].patchPtr, patchesPtr[patchNum].size );
             }
 
+            FreeSegmentPatches( patchesPtr, numSegments );
+            bsDiffDeleteIndex( origIndexPtr );
+            // We use free(3). No alternative to this within the tool
+            free( destPtr );
+            free( origPtr );
+
             PatchMetaHeader.destCrc32 = htobe32(crc32Dest);
             PatchMetaHeader.numPatches = htobe32(patchNum);
             PatchMetaHeader.segmentSize = htobe32(chunkLen);
@@ -0,0 +1,278 @@
+/** @file sandboxPlanTool.c
+ *
+ * Command line tool used to examine the sandbox plans saved for installed apps.  See sandboxPlan.h
+ * for a description of sandbox plans.
+ *
+ * Copyright (C) Sierra Wireless Inc.
+ */
+
+#include "legato.h"
+#include "interfaces.h"
+#include "limit.h"
+#include "sandboxPlan.h"
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prints help to stdout.
+ */
+//--------------------------------------------------------------------------------------------------
+static void PrintHelp
+(
+    void
+)
+{
+    puts(
+        "NAME:\n"
+        "    sandboxPlan - Examines the sandbox plans saved for installed apps.\n"
+        "\n"
+        "DESCRIPTION:\n"
+        "    sandboxPlan dump APP_NAME\n"
+        "       Prints the links in the sandbox plan saved for the installed version of APP_NAME.\n"
+        "\n"
+        "    sandboxPlan verify APP_NAME\n"
+        "       Checks that the saved sandbox plan for APP_NAME matches the app's configuration\n"
+        "       and that the source of every link exists.  Exits with a non-zero status if not.\n"
+        "\n"
+        );
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Gets the app name argument and the hash of the installed version of that app.  Exits if there is
+ * no such app.
+ *
+ * @return
+ *      The app name.
+ */
+//--------------------------------------------------------------------------------------------------
+static const char* GetApp
+(
+    char* hashBufPtr,                   ///< [OUT] Buffer to store the app's hash.
+    size_t hashBufSize                  ///< [IN] Size of the buffer.
+)
+{
+    const char* appNamePtr = le_arg_GetArg(1);
+
+    if (appNamePtr == NULL)
+    {
+        fprintf(stderr, "Please specify an app name.\n");
+        PrintHelp();
+        exit(EXIT_FAILURE);
+    }
+
+    if (sandboxPlan_GetAppHash(appNamePtr, hashBufPtr, hashBufSize) != LE_OK)
+    {
+        fprintf(stderr, "App '%s' is not installed.\n", appNamePtr);
+        exit(EXIT_FAILURE);
+    }
+
+    return appNamePtr;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Loads the saved plan for the installed version of an app.  Exits if there is none.
+ *
+ * @return
+ *      Reference to the plan.
+ */
+//--------------------------------------------------------------------------------------------------
+static sandboxPlan_Ref_t LoadPlan
+(
+    const char* appNamePtr,             ///< [IN] Name of the app.
+    const char* hashPtr                 ///< [IN] Hash of the installed app.
+)
+{
+    sandboxPlan_Ref_t planRef = sandboxPlan_Load(appNamePtr, hashPtr);
+
+    if (planRef == NULL)
+    {
+        fprintf(stderr, "There is no valid sandbox plan saved for app '%s' (%s).\n",
+                appNamePtr, hashPtr);
+        exit(EXIT_FAILURE);
+    }
+
+    return planRef;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Prints all the links in the saved plan for an app.
+ */
+//--------------------------------------------------------------------------------------------------
+static void DumpPlan
+(
+    void
+)
+{
+    char hash[LIMIT_MD5_STR_BYTES];
+    const char* appNamePtr = GetApp(hash, sizeof(hash));
+
+    sandboxPlan_Ref_t planRef = LoadPlan(appNamePtr, hash);
+
+    printf("app:   %s\n", sandboxPlan_GetAppName(planRef));
+    printf("hash:  %s\n", sandboxPlan_GetHash(planRef));
+    printf("links: %zu\n", sandboxPlan_GetNumLinks(planRef));
+
+    const sandboxPlan_Link_t* linkPtr = sandboxPlan_GetFirstLink(planRef);
+
+    while (linkPtr != NULL)
+    {
+        printf("    %-10s %s -> %s\n",
+               sandboxPlan_GetLinkTypeName(linkPtr->type), linkPtr->src, linkPtr->dest);
+
+        linkPtr = sandboxPlan_GetNextLink(planRef, linkPtr);
+    }
+
+    sandboxPlan_Release(planRef);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Checks the source of a link.
+ *
+ * @return
+ *      true if the source is usable.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsSourceValid
+(
+    const sandboxPlan_Link_t* linkPtr   ///< [IN] Link to check.
+)
+{
+    struct stat srcStat;
+
+    if (stat(linkPtr->src, &srcStat) == -1)
+    {
+        // The app's lib and bin directories, for instance, don't have to exist.
+        if ((errno == ENOENT) && (linkPtr->type == SANDBOXPLAN_TREE))
+        {
+            return true;
+        }
+
+        printf("    missing source: %s (%m)\n", linkPtr->src);
+        return false;
+    }
+
+    bool isDir = S_ISDIR(srcStat.st_mode);
+
+    if ((linkPtr->type == SANDBOXPLAN_FILE) && isDir)
+    {
+        printf("    source is a directory: %s\n", linkPtr->src);
+        return false;
+    }
+
+    if ((linkPtr->type != SANDBOXPLAN_FILE) && !isDir)
+    {
+        printf("    source is not a directory: %s\n", linkPtr->src);
+        return false;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Verifies the saved plan for an app against the app's configuration and the file system.  Exits
+ * with a failure status if the plan is not valid.
+ */
+//--------------------------------------------------------------------------------------------------
+static void VerifyPlan
+(
+    void
+)
+{
+    char hash[LIMIT_MD5_STR_BYTES];
+    const char* appNamePtr = GetApp(hash, sizeof(hash));
+
+    sandboxPlan_Ref_t planRef = LoadPlan(appNamePtr, hash);
+    bool isValid = true;
+
+    // The saved plan must be the one the app's configuration gives now.
+    sandboxPlan_Ref_t cfgPlanRef = sandboxPlan_Build(appNamePtr, hash);
+
+    if (cfgPlanRef == NULL)
+    {
+        printf("Could not build the sandbox plan from the configuration of app '%s'.\n",
+               appNamePtr);
+        isValid = false;
+    }
+    else
+    {
+        if (!sandboxPlan_IsEqual(planRef, cfgPlanRef))
+        {
+            printf("Saved sandbox plan does not match the configuration of app '%s'.\n",
+                   appNamePtr);
+            isValid = false;
+        }
+
+        sandboxPlan_Release(cfgPlanRef);
+    }
+
+    // Every link must have a usable source.
+    const sandboxPlan_Link_t* linkPtr = sandboxPlan_GetFirstLink(planRef);
+
+    while (linkPtr != NULL)
+    {
+        if (!IsSourceValid(linkPtr))
+        {
+            isValid = false;
+        }
+
+        linkPtr = sandboxPlan_GetNextLink(planRef, linkPtr);
+    }
+
+    printf("Sandbox plan for app '%s' (%zu links) is %s.\n",
+           appNamePtr, sandboxPlan_GetNumLinks(planRef), isValid ? "valid" : "NOT valid");
+
+    sandboxPlan_Release(planRef);
+
+    if (!isValid)
+    {
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+COMPONENT_INIT
+{
+    sandboxPlan_Init();
+
+    const char* cmdPtr = le_arg_GetArg(0);
+
+    if (cmdPtr == NULL)
+    {
+        fprintf(stderr, "Please specify a command.\n");
+
+        PrintHelp();
+        exit(EXIT_FAILURE);
+    }
+
+    if (strcmp(cmdPtr, "dump") == 0)
+    {
+        DumpPlan();
+    }
+    else if (strcmp(cmdPtr, "verify") == 0)
+    {
+        VerifyPlan();
+    }
+    else if ( (strcmp(cmdPtr, "help") == 0) || (strcmp(cmdPtr, "--help") == 0) )
+    {
+        PrintHelp();
+    }
+    else
+    {
+        fprintf(stderr, "Unknown command.\n");
+
+        PrintHelp();
+        exit(EXIT_FAILURE);
+    }
+
+    exit(EXIT_SUCCESS);
+}
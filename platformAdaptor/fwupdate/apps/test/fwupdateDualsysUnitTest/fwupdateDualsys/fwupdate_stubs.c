@@ -625,6 +625,31 @@ le_result_t pa_flash_EraseBlock
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Erase the good blocks where the next pa_flash_Write will write
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flash_EraseNextBlocks
+(
+    pa_flash_Desc_t desc,
+    uint32_t nbBlocks
+)
+{
+    pa_flash_MtdDesc_t *descPtr = (pa_flash_MtdDesc_t *)desc;
+
+    if( (!descPtr) || (descPtr->magic != desc) )
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Write data starting the given block. If a Bad block is detected,
@@ -652,6 +677,23 @@ le_result_t pa_flash_WriteAtBlock
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the queued operations of a flash descriptor to be done
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or not a valid flash descriptor
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flash_Flush
+(
+    pa_flash_Desc_t desc
+)
+{
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Close a flash descriptor
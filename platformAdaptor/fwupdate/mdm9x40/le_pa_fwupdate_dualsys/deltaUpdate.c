@@ -465,7 +465,7 @@ le_result_t deltaUpdate_ApplyPatch
         pa_flash_Desc_t desc;
         pa_patch_Context_t ctx;
         le_result_t res;
-        bool isUbiPatch = false, isUbiPartition;
+        bool isUbiPatch = false, isUbiPartition, isLastPatch;
 
         close(PatchFd);
         PatchFd = -1;
@@ -502,6 +502,7 @@ le_result_t deltaUpdate_ApplyPatch
         ctx.destImageDesc.flash.ubiVolId = patchMetaHdrPtr->ubiVolId;
         ctx.destImageDesc.flash.isLogical = IsDestLogical;
         ctx.destImageDesc.flash.isDual = IsDestDual;
+        ctx.maxMemory = PA_PATCH_MAX_MEMORY;
 
         if (isUbiPatch)
         {
@@ -526,18 +527,20 @@ le_result_t deltaUpdate_ApplyPatch
                  goto error;
              }
         }
+        isLastPatch = (patchMetaHdrPtr->numPatches == patchHdrPtr->number);
         res = bsPatch( &ctx,
                        TMP_PATCH_PATH,
                        &PatchCrc32,
-                       patchMetaHdrPtr->numPatches == patchHdrPtr->number,
+                       isLastPatch,
                        false);
         unlink(TMP_PATCH_PATH);
         if (LE_OK == res)
         {
-            if (isUbiPatch)
+            if (isUbiPatch && isLastPatch)
             {
                 // In this case, we need to recompute the checksum of the MTD to ensure that
-                // it is conform to what we read during the patch.
+                // it is conform to what we read during the patch. This reads the whole origin
+                // volume, so it is done once all the segments are applied.
                 res = CheckUbiData( MtdOrigNum,
                                     patchMetaHdrPtr->ubiVolId,
                                     patchMetaHdrPtr->origSize,
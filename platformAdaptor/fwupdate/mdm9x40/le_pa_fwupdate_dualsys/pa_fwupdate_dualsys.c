@@ -898,6 +898,12 @@ static size_t WriteImageData
     else
     {
         static size_t LenToFlash = 0;
+        // Resume point of a block still queued to the flash, stored when it is known to be written
+        static bool IsCkptPending = false;
+        static size_t CkptLen;
+        static size_t CkptOffset;
+        static uint32_t CkptImageCrc;
+        static uint32_t CkptGlobalCrc;
         ResumeCtxSave_t *saveCtxPtr = &resumeCtxPtr->saveCtx;
 
         // There are 3 cases where (saveCtxPtr->currentOffset == CurrentImageOffset):
@@ -908,10 +914,11 @@ static size_t WriteImageData
         // For cases 2 and 3, there is a possibility that the download was previously suspended or
         // stopped, leaving LenToFlash != 0. In these cases, LenToFlash should be cleared here to
         // keep correct calculation of ResumeCtx (saveCtxPtr->totalRead).
-        if ((saveCtxPtr->currentOffset == CurrentImageOffset) && LenToFlash)
+        if ((saveCtxPtr->currentOffset == CurrentImageOffset) && (LenToFlash || IsCkptPending))
         {
             LE_DEBUG ("Clear LenToFlash %d in a new download cycle", LenToFlash);
             LenToFlash = 0;
+            IsCkptPending = false;
         }
 
         if (LE_OK == WriteData (cweHeaderPtr,
@@ -933,23 +940,50 @@ static size_t WriteImageData
             if (isFlashed)
             {// some data have been flashed => update the resume context
                 le_result_t ret;
-
-                LE_DEBUG("Store resume context ...");
+                bool isCtxToBeSaved = false;
 
                 if (cweHeaderPtr->miscOpts & CWE_MISC_OPTS_DELTAPATCH)
                 {
                     // a patch has been completely received => wait a new header
                     saveCtxPtr->isImageToBeRead = false;
                 }
-                saveCtxPtr->currentImageCrc = CurrentImageCrc32;
-                saveCtxPtr->currentGlobalCrc = CurrentGlobalCrc32;
-                saveCtxPtr->totalRead += LenToFlash;
+                if (IsCkptPending)
+                {
+                    // The previous block is written now
+                    saveCtxPtr->currentImageCrc = CkptImageCrc;
+                    saveCtxPtr->currentGlobalCrc = CkptGlobalCrc;
+                    saveCtxPtr->totalRead += CkptLen;
+                    saveCtxPtr->currentOffset = CkptOffset;
+                    IsCkptPending = false;
+                    isCtxToBeSaved = true;
+                }
+                if (partition_IsWritePending())
+                {
+                    // This block is still queued: it is covered by the resume context once it
+                    // is known to be written
+                    CkptImageCrc = CurrentImageCrc32;
+                    CkptGlobalCrc = CurrentGlobalCrc32;
+                    CkptLen = LenToFlash;
+                    CkptOffset = CurrentImageOffset;
+                    IsCkptPending = true;
+                }
+                else
+                {
+                    saveCtxPtr->currentImageCrc = CurrentImageCrc32;
+                    saveCtxPtr->currentGlobalCrc = CurrentGlobalCrc32;
+                    saveCtxPtr->totalRead += LenToFlash;
+                    saveCtxPtr->currentOffset = CurrentImageOffset;
+                    isCtxToBeSaved = true;
+                }
                 LenToFlash = 0;
-                saveCtxPtr->currentOffset = CurrentImageOffset;
-                ret = UpdateResumeCtx(resumeCtxPtr);
-                if (ret != LE_OK)
+                if (isCtxToBeSaved)
                 {
-                    LE_WARN("Failed to update Resume context");
+                    LE_DEBUG("Store resume context ...");
+                    ret = UpdateResumeCtx(resumeCtxPtr);
+                    if (ret != LE_OK)
+                    {
+                        LE_WARN("Failed to update Resume context");
+                    }
                 }
             }
         }
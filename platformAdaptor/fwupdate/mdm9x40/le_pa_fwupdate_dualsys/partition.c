@@ -168,6 +168,13 @@ static const unsigned char partition_SBLPreamble[8] = {
 //--------------------------------------------------------------------------------------------------
 static size_t  ImageSize = 0;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * A block of the image is queued to the flash but is not known to be written yet
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsWritePending = false;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Sub system defined by user. If not defined, it set to the default initial boot system.
@@ -1222,6 +1229,11 @@ forceclose:
 /**
  * Write data in UPDATE partitions
  *
+ * The flash is opened with PA_FLASH_OPENMODE_ASYNC: when a block is full, its write and the erase
+ * of the next block are queued and run while the next data are received. At most one block is
+ * queued: it is known to be written when the next block is full or at the end of the image, as
+ * reported by partition_IsWritePending().
+ *
  * @return
  *      - LE_OK on success
  *      - LE_FAULT on failure
@@ -1281,6 +1293,7 @@ le_result_t partition_WriteUpdatePartition
 
         if (LE_OK != pa_flash_Open( mtdNum,
                                     PA_FLASH_OPENMODE_WRITEONLY | PA_FLASH_OPENMODE_MARKBAD |
+                                    PA_FLASH_OPENMODE_ASYNC |
                                     (isLogical
                                      ? (isDual ? PA_FLASH_OPENMODE_LOGICAL_DUAL
                                                : PA_FLASH_OPENMODE_LOGICAL)
@@ -1311,35 +1324,22 @@ le_result_t partition_WriteUpdatePartition
             goto error;
         }
 
-        for (iblk = offset / FlashInfoPtr->eraseSize; iblk < FlashInfoPtr->nbLeb; iblk++)
-        {
-            bool isBad;
-
-            if ((LE_OK != (res = pa_flash_CheckBadBlock( MtdFd, iblk, &isBad )))
-                && (res != LE_NOT_PERMITTED))
-            {
-                LE_ERROR("Fails to check bad block %d", iblk);
-                goto error;
-            }
-            if (isBad)
-            {
-                LE_WARN("Skipping bad block %d", iblk);
-            }
-            else
-            {
-                res = pa_flash_EraseBlock( MtdFd, iblk );
-                if ((LE_OK != res) && (res != LE_NOT_PERMITTED))
-                {
-                    LE_ERROR("Fails to erase block %d: res=%d", iblk, res);
-                    goto error;
-                }
-            }
-        }
+        iblk = offset / FlashInfoPtr->eraseSize;
         if (LE_OK != pa_flash_SeekAtOffset( MtdFd, offset ))
         {
             LE_ERROR("Fails to seek block at %d", iblk);
             goto error;
         }
+        // Only the block of the first write is erased now, the next ones are erased while the
+        // previous one is written. The blocks after the image are erased at the end.
+        // pa_flash_EraseNextBlocks erases the good block the next write uses, skipping the bad
+        // blocks as pa_flash_Write does.
+        res = pa_flash_EraseNextBlocks( MtdFd, 1 );
+        if (LE_OK != res)
+        {
+            LE_ERROR("Fails to erase block %d: res=%d", iblk, res);
+            goto error;
+        }
         DataPtr = le_mem_ForceAlloc(*ctxPtr->flashPoolPtr);
         InOffset = 0;
         ImageSize = hdrPtr->imageSize;
@@ -1360,11 +1360,23 @@ le_result_t partition_WriteUpdatePartition
         {
             *isFlashedPtr = true;
         }
+        // Wait for the previous block to be written and this one to be erased
+        if (LE_OK != pa_flash_Flush( MtdFd ))
+        {
+            LE_ERROR( "Write to flash fails" );
+            goto error;
+        }
         if (LE_OK != pa_flash_Write( MtdFd, DataPtr, FlashInfoPtr->eraseSize ))
         {
             LE_ERROR( "fwrite to nandwrite fails: %m" );
             goto error;
         }
+        IsWritePending = true;
+        if (LE_OK != pa_flash_EraseNextBlocks( MtdFd, 1 ))
+        {
+            LE_ERROR( "Fails to erase the next block" );
+            goto error;
+        }
         InOffset = length - (FlashInfoPtr->eraseSize - InOffset);
         memcpy( DataPtr, dataPtr, InOffset );
     }
@@ -1396,6 +1408,24 @@ le_result_t partition_WriteUpdatePartition
                 goto error;
             }
         }
+        if (LE_OK != pa_flash_Flush( MtdFd ))
+        {
+            LE_ERROR( "Write to flash fails" );
+            goto error;
+        }
+        IsWritePending = false;
+
+        // Erase the blocks left after the image
+        if (LE_OK != pa_flash_EraseNextBlocks( MtdFd, FlashInfoPtr->nbBlk ))
+        {
+            LE_ERROR( "Fails to erase the blocks after the image" );
+            goto error;
+        }
+        if (LE_OK != pa_flash_Flush( MtdFd ))
+        {
+            LE_ERROR( "Erase of flash fails" );
+            goto error;
+        }
         le_mem_Release(DataPtr);
         DataPtr = NULL;
         InOffset = 0;
@@ -1418,6 +1448,7 @@ le_result_t partition_WriteUpdatePartition
     return ret;
 error:
     InOffset = 0;
+    IsWritePending = false;
     ret = LE_OK;
     if (MtdFd)
     {
@@ -1435,6 +1466,24 @@ error:
 }
 
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tell if the last block given to partition_WriteUpdatePartition is still queued to the flash.
+ * The resume context must not cover it until this returns false.
+ *
+ * @return
+ *      - true if a block write is queued but not known to be done
+ *      - false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+bool partition_IsWritePending
+(
+    void
+)
+{
+    return IsWritePending;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get bad image bitmask value
@@ -187,6 +187,21 @@ le_result_t partition_WriteUpdatePartition
     bool *isFlashedPtr                ///< [OUT] true if flash write was done
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Tell if the last block given to partition_WriteUpdatePartition is still queued to the flash.
+ * The resume context must not cover it until this returns false.
+ *
+ * @return
+ *      - true if a block write is queued but not known to be done
+ *      - false otherwise
+ */
+//--------------------------------------------------------------------------------------------------
+bool partition_IsWritePending
+(
+    void
+);
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set bad image flag preventing concurrent partition access
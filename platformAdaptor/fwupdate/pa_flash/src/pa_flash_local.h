@@ -12,6 +12,52 @@
 #ifndef LEGATO_LEPAFLASHLOCAL_INCLUDE_GUARD
 #define LEGATO_LEPAFLASHLOCAL_INCLUDE_GUARD
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of operations queued to the I/O thread of a PA_FLASH_OPENMODE_ASYNC descriptor
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_FLASH_ASYNC_MAX_JOBS  8
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of blocks pa_flash_WriteUbiAtBlock may add to a UBI volume before writing the deferred
+ * VID headers and VTBL. An interrupted update leaves at most this number of blocks minus one past
+ * the reserved_pebs of the VTBL on the flash
+ */
+//--------------------------------------------------------------------------------------------------
+#define PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS  16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Operation queued to the I/O thread
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    PA_FLASH_JOB_ERASE,          ///< pa_flash_EraseBlock
+    PA_FLASH_JOB_ERASE_NEXT,     ///< pa_flash_EraseNextBlocks
+    PA_FLASH_JOB_SEEK_OFFSET,    ///< pa_flash_SeekAtOffset
+    PA_FLASH_JOB_SEEK_BLOCK,     ///< pa_flash_SeekAtBlock
+    PA_FLASH_JOB_WRITE,          ///< pa_flash_Write
+}
+pa_flash_JobType_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Job of the I/O thread
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    pa_flash_JobType_t type;     ///< Operation to do
+    uint32_t blockIndex;         ///< Block to erase or to seek, or number of blocks to erase
+    off_t offset;                ///< Offset to seek
+    uint32_t bufIndex;           ///< Buffer holding the data to write
+    size_t dataSize;             ///< Size of the data to write
+}
+pa_flash_Job_t;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Internal flash MTD descriptor. To be valid, the magic should be its own address
@@ -33,7 +79,35 @@ typedef struct
     struct ubi_vtbl_record *vtblPtr;     ///< Pointer to VTBL is UBI
     uint32_t vtblPeb[2];     ///< PEB containing the VTBL if UBI
     uint32_t ubiBadBlkCnt;   ///< counter of bad blocks
+    bool ubiHdrPending;      ///< VID headers and VTBL not updated yet after the volume was extended
+    uint32_t ubiHdrPendingBlocks; ///< Number of blocks added since the UBI headers were written
+    le_thread_Ref_t ioThreadRef;  ///< I/O thread if PA_FLASH_OPENMODE_ASYNC, NULL else
+    le_mutex_Ref_t ioMutexRef;    ///< Protect the job queue against the I/O thread
+    le_sem_Ref_t ioJobSemRef;     ///< Posted for each job queued to the I/O thread
+    le_sem_Ref_t ioDoneSemRef;    ///< Posted for each job done by the I/O thread
+    pa_flash_Job_t ioJobs[PA_FLASH_ASYNC_MAX_JOBS]; ///< Queue of the jobs, oldest first
+    uint32_t ioJobFirst;          ///< Index of the oldest job in the queue
+    uint32_t ioJobCount;          ///< Number of jobs queued or running
+    uint8_t *ioBufPtr[PA_FLASH_ASYNC_NB_BUFFERS]; ///< Copies of the data to write
+    bool ioBufBusy[PA_FLASH_ASYNC_NB_BUFFERS];    ///< The buffer is used by a queued write
+    le_result_t ioResult;         ///< First error of the jobs since the last flush
+    bool ioStopping;              ///< The I/O thread has to exit
 }
 pa_flash_MtdDesc_t;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the UBI VID headers and VTBL whose update was deferred by pa_flash_WriteUbiAtBlock when
+ * the volume was extended. Does nothing if there is no pending update.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - others           Depending of the flash operations
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flashUbi_FlushHeaders
+(
+    pa_flash_MtdDesc_t *descPtr   ///< [IN] Private flash descriptor
+);
+
 #endif // LEGATO_LEPAFLASHLOCAL_INCLUDE_GUARD
@@ -50,6 +50,15 @@
 //--------------------------------------------------------------------------------------------------
 static le_mem_PoolRef_t FlashMtdDescPool = NULL;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool for the write buffers of the PA_FLASH_OPENMODE_ASYNC descriptors, and size of its blocks
+ * (the erase block of the first MTD opened in this mode)
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t FlashIoBufPool = NULL;
+static size_t FlashIoBufSize = 0;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get the valid offset and PEB (Physical Erase Block) of inside the current flash
@@ -135,6 +144,283 @@ static le_result_t GetBlock
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if an operation on the descriptor has to be queued to the I/O thread. It is not when the
+ * descriptor is synchronous, or when the I/O thread runs the job itself.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsAsync
+(
+    pa_flash_MtdDesc_t *descPtr  ///< [IN] MTD device descriptor
+)
+{
+    return (descPtr->ioThreadRef && (le_thread_GetCurrent() != descPtr->ioThreadRef));
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until the I/O thread has done all the queued jobs. Does nothing if the descriptor is
+ * synchronous.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitIdle
+(
+    pa_flash_MtdDesc_t *descPtr  ///< [IN] MTD device descriptor
+)
+{
+    if( !IsAsync( descPtr ) )
+    {
+        return;
+    }
+
+    le_mutex_Lock( descPtr->ioMutexRef );
+    while( descPtr->ioJobCount )
+    {
+        le_mutex_Unlock( descPtr->ioMutexRef );
+        le_sem_Wait( descPtr->ioDoneSemRef );
+        le_mutex_Lock( descPtr->ioMutexRef );
+    }
+    le_mutex_Unlock( descPtr->ioMutexRef );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue a job to the I/O thread. The data of a write are copied into a free buffer. Wait if the
+ * queue is full or if all buffers are used.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - others           The error of a previous job: this one is not queued
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t QueueJob
+(
+    pa_flash_MtdDesc_t *descPtr, ///< [IN] MTD device descriptor
+    pa_flash_Job_t *jobPtr,      ///< [IN] Job to queue
+    const uint8_t *dataPtr       ///< [IN] Data to write if the job is a write
+)
+{
+    bool isWrite = (PA_FLASH_JOB_WRITE == jobPtr->type);
+    uint32_t buf = PA_FLASH_ASYNC_NB_BUFFERS;
+    le_result_t res;
+
+    le_mutex_Lock( descPtr->ioMutexRef );
+    for( ;; )
+    {
+        if( LE_OK != descPtr->ioResult )
+        {
+            res = descPtr->ioResult;
+            le_mutex_Unlock( descPtr->ioMutexRef );
+            return res;
+        }
+        if( isWrite )
+        {
+            for( buf = 0; (buf < PA_FLASH_ASYNC_NB_BUFFERS) && descPtr->ioBufBusy[buf]; buf++ )
+            {
+            }
+        }
+        if( (descPtr->ioJobCount < PA_FLASH_ASYNC_MAX_JOBS) &&
+            ((!isWrite) || (buf < PA_FLASH_ASYNC_NB_BUFFERS)) )
+        {
+            break;
+        }
+        le_mutex_Unlock( descPtr->ioMutexRef );
+        le_sem_Wait( descPtr->ioDoneSemRef );
+        le_mutex_Lock( descPtr->ioMutexRef );
+    }
+
+    if( isWrite )
+    {
+        // The buffer is not used by the I/O thread until the job is queued
+        descPtr->ioBufBusy[buf] = true;
+        le_mutex_Unlock( descPtr->ioMutexRef );
+        memcpy( descPtr->ioBufPtr[buf], dataPtr, jobPtr->dataSize );
+        le_mutex_Lock( descPtr->ioMutexRef );
+        jobPtr->bufIndex = buf;
+    }
+    descPtr->ioJobs[(descPtr->ioJobFirst + descPtr->ioJobCount) % PA_FLASH_ASYNC_MAX_JOBS] =
+        *jobPtr;
+    descPtr->ioJobCount++;
+    le_mutex_Unlock( descPtr->ioMutexRef );
+    le_sem_Post( descPtr->ioJobSemRef );
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Do a job in the I/O thread
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - others           Depending of the flash operation
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t RunJob
+(
+    pa_flash_MtdDesc_t *descPtr, ///< [IN] MTD device descriptor
+    pa_flash_Job_t *jobPtr       ///< [IN] Job to do
+)
+{
+    pa_flash_Desc_t desc = (pa_flash_Desc_t)descPtr;
+
+    switch( jobPtr->type )
+    {
+        case PA_FLASH_JOB_ERASE:
+            return pa_flash_EraseBlock( desc, jobPtr->blockIndex );
+
+        case PA_FLASH_JOB_ERASE_NEXT:
+            return pa_flash_EraseNextBlocks( desc, jobPtr->blockIndex );
+
+        case PA_FLASH_JOB_SEEK_OFFSET:
+            return pa_flash_SeekAtOffset( desc, jobPtr->offset );
+
+        case PA_FLASH_JOB_SEEK_BLOCK:
+            return pa_flash_SeekAtBlock( desc, jobPtr->blockIndex );
+
+        case PA_FLASH_JOB_WRITE:
+            return pa_flash_Write( desc, descPtr->ioBufPtr[jobPtr->bufIndex], jobPtr->dataSize );
+
+        default:
+            return LE_FAULT;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * I/O thread: erase and write the flash in the order the jobs were queued. Once a job has failed,
+ * the following ones are dropped until the error is reported by pa_flash_Flush.
+ */
+//--------------------------------------------------------------------------------------------------
+static void *IoThread
+(
+    void *contextPtr    ///< [IN] MTD device descriptor
+)
+{
+    pa_flash_MtdDesc_t *descPtr = (pa_flash_MtdDesc_t *)contextPtr;
+    pa_flash_Job_t job;
+    le_result_t res;
+    bool isFailed;
+
+    for( ;; )
+    {
+        le_sem_Wait( descPtr->ioJobSemRef );
+
+        le_mutex_Lock( descPtr->ioMutexRef );
+        if( 0 == descPtr->ioJobCount )
+        {
+            bool isStopping = descPtr->ioStopping;
+
+            le_mutex_Unlock( descPtr->ioMutexRef );
+            if( isStopping )
+            {
+                break;
+            }
+            continue;
+        }
+        // The job stays in the queue while it runs, so that WaitIdle waits for it
+        job = descPtr->ioJobs[descPtr->ioJobFirst];
+        isFailed = (LE_OK != descPtr->ioResult);
+        le_mutex_Unlock( descPtr->ioMutexRef );
+
+        res = (isFailed ? LE_OK : RunJob( descPtr, &job ));
+
+        le_mutex_Lock( descPtr->ioMutexRef );
+        if( (LE_OK != res) && (LE_OK == descPtr->ioResult) )
+        {
+            LE_ERROR("MTD %d: queued operation %d fails: %d", descPtr->mtdNum, job.type, res);
+            descPtr->ioResult = res;
+        }
+        if( PA_FLASH_JOB_WRITE == job.type )
+        {
+            descPtr->ioBufBusy[job.bufIndex] = false;
+        }
+        descPtr->ioJobFirst = (descPtr->ioJobFirst + 1) % PA_FLASH_ASYNC_MAX_JOBS;
+        descPtr->ioJobCount--;
+        le_mutex_Unlock( descPtr->ioMutexRef );
+        le_sem_Post( descPtr->ioDoneSemRef );
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocate the write buffers and start the I/O thread of a PA_FLASH_OPENMODE_ASYNC descriptor
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_OUT_OF_RANGE  If the erase block does not fit the buffers
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t StartAsync
+(
+    pa_flash_MtdDesc_t *descPtr  ///< [IN] MTD device descriptor
+)
+{
+    uint32_t buf;
+
+    if( NULL == FlashIoBufPool )
+    {
+        FlashIoBufPool = le_mem_CreatePool("FlashIoBufPool", descPtr->mtdInfo.eraseSize);
+        FlashIoBufSize = descPtr->mtdInfo.eraseSize;
+    }
+    if( descPtr->mtdInfo.eraseSize > FlashIoBufSize )
+    {
+        LE_ERROR("MTD %d: erase block %x does not fit the I/O buffers %zx",
+                 descPtr->mtdNum, descPtr->mtdInfo.eraseSize, FlashIoBufSize);
+        return LE_OUT_OF_RANGE;
+    }
+
+    for( buf = 0; buf < PA_FLASH_ASYNC_NB_BUFFERS; buf++ )
+    {
+        descPtr->ioBufPtr[buf] = le_mem_ForceAlloc(FlashIoBufPool);
+        descPtr->ioBufBusy[buf] = false;
+    }
+    descPtr->ioResult = LE_OK;
+    descPtr->ioStopping = false;
+    descPtr->ioMutexRef = le_mutex_CreateNonRecursive("FlashIo");
+    descPtr->ioJobSemRef = le_sem_Create("FlashIoJobs", 0);
+    descPtr->ioDoneSemRef = le_sem_Create("FlashIoDone", 0);
+    descPtr->ioThreadRef = le_thread_Create("FlashIo", IoThread, descPtr);
+    le_thread_SetJoinable( descPtr->ioThreadRef );
+    le_thread_Start( descPtr->ioThreadRef );
+    return LE_OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the I/O thread once the queued jobs are done, and release the write buffers
+ */
+//--------------------------------------------------------------------------------------------------
+static void StopAsync
+(
+    pa_flash_MtdDesc_t *descPtr  ///< [IN] MTD device descriptor
+)
+{
+    uint32_t buf;
+
+    if( descPtr->ioThreadRef )
+    {
+        le_mutex_Lock( descPtr->ioMutexRef );
+        descPtr->ioStopping = true;
+        le_mutex_Unlock( descPtr->ioMutexRef );
+        le_sem_Post( descPtr->ioJobSemRef );
+        le_thread_Join( descPtr->ioThreadRef, NULL );
+        descPtr->ioThreadRef = NULL;
+        le_sem_Delete( descPtr->ioDoneSemRef );
+        le_sem_Delete( descPtr->ioJobSemRef );
+        le_mutex_Delete( descPtr->ioMutexRef );
+    }
+    for( buf = 0; buf < PA_FLASH_ASYNC_NB_BUFFERS; buf++ )
+    {
+        if( descPtr->ioBufPtr[buf] )
+        {
+            le_mem_Release( descPtr->ioBufPtr[buf] );
+            descPtr->ioBufPtr[buf] = NULL;
+        }
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Get flash information
@@ -289,6 +575,8 @@ le_result_t pa_flash_GetEccStats
         return LE_BAD_PARAMETER;
     }
 
+    WaitIdle( descPtr );
+
     ret = ioctl(descPtr->fd, ECCGETSTATS, &eccStats);
     if( -1 == ret )
     {
@@ -329,8 +617,9 @@ le_result_t pa_flash_Open
     bool isDual = ((mode & PA_FLASH_OPENMODE_LOGICAL_DUAL) != PA_FLASH_OPENMODE_LOGICAL);
     bool isUbi = (mode & PA_FLASH_OPENMODE_UBI) ? true : false;
     bool markBad = (mode & PA_FLASH_OPENMODE_MARKBAD) ? true : false;
+    bool isAsync = (mode & PA_FLASH_OPENMODE_ASYNC) ? true : false;
 
-    if( !descPtr )
+    if( (!descPtr) || (isAsync && isUbi) )
     {
         return LE_BAD_PARAMETER;
     }
@@ -390,6 +679,18 @@ le_result_t pa_flash_Open
     // Clear the LEB to PEB array
     memset( &(mtdDescPtr->lebToPeb), -1, sizeof(mtdDescPtr->lebToPeb));
 
+    if( isAsync && (O_RDONLY != omode) )
+    {
+        rc = StartAsync( mtdDescPtr );
+        if( LE_OK != rc )
+        {
+            StopAsync( mtdDescPtr );
+            close(mtdDescPtr->fd);
+            le_mem_Release(mtdDescPtr);
+            return rc;
+        }
+    }
+
     if( infoPtr )
     {
         *infoPtr = &(mtdDescPtr->mtdInfo);
@@ -404,11 +705,12 @@ le_result_t pa_flash_Open
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Close a flash descriptor
+ * Close a flash descriptor. The pending operations are flushed before (see pa_flash_Flush)
  *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or not a valid flash descriptor
+ *      - others           If the flush fails. The descriptor is closed anyway
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_flash_Close
@@ -417,17 +719,61 @@ le_result_t pa_flash_Close
 )
 {
     pa_flash_MtdDesc_t *descPtr = (pa_flash_MtdDesc_t *)desc;
+    le_result_t res;
 
     if( (!descPtr) || (descPtr->magic != desc) )
     {
         return LE_BAD_PARAMETER;
     }
+    res = pa_flash_Flush( desc );
+    StopAsync( descPtr );
+
     // Close and release the MTD descriptor
     descPtr->magic = NULL;
     close(descPtr->fd);
     le_mem_Release(descPtr);
 
-    return LE_OK;
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Flush a flash descriptor: wait for the erase and write operations queued with
+ * PA_FLASH_OPENMODE_ASYNC, and write the UBI headers (VID and VTBL) whose update was deferred when
+ * the UBI volume was extended.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or not a valid flash descriptor
+ *      - others           The error of the first failed operation since the last flush
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flash_Flush
+(
+    pa_flash_Desc_t desc
+)
+{
+    pa_flash_MtdDesc_t *descPtr = (pa_flash_MtdDesc_t *)desc;
+    le_result_t res = LE_OK;
+
+    if( (!descPtr) || (descPtr->magic != desc) )
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if( IsAsync( descPtr ) )
+    {
+        WaitIdle( descPtr );
+        le_mutex_Lock( descPtr->ioMutexRef );
+        res = descPtr->ioResult;
+        descPtr->ioResult = LE_OK;
+        le_mutex_Unlock( descPtr->ioMutexRef );
+    }
+    if( descPtr->ubiHdrPending && (LE_OK == res) )
+    {
+        res = pa_flashUbi_FlushHeaders( descPtr );
+    }
+    return res;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -461,6 +807,8 @@ le_result_t pa_flash_Scan
         return LE_BAD_PARAMETER;
     }
 
+    WaitIdle( descPtr );
+
     if( descPtr->mtdInfo.nbBlk > PA_FLASH_MAX_LEB )
     {
         return LE_OUT_OF_RANGE;
@@ -535,6 +883,8 @@ le_result_t pa_flash_Unscan
         return LE_BAD_PARAMETER;
     }
 
+    WaitIdle( descPtr );
+
     if( descPtr->scanDone )
     {
         // Reset the LEB to PEB array and set number of LEB = PEB
@@ -576,6 +926,8 @@ le_result_t pa_flash_CheckBadBlock
         return LE_BAD_PARAMETER;
     }
 
+    WaitIdle( descPtr );
+
     if( blockIndex >= descPtr->mtdInfo.nbLeb )
     {
         return LE_OUT_OF_RANGE;
@@ -635,6 +987,8 @@ le_result_t pa_flash_MarkBadBlock
         return LE_BAD_PARAMETER;
     }
 
+    WaitIdle( descPtr );
+
     if( blockIndex >= descPtr->mtdInfo.nbLeb )
     {
         return LE_OUT_OF_RANGE;
@@ -694,6 +1048,13 @@ le_result_t pa_flash_EraseBlock
         return LE_BAD_PARAMETER;
     }
 
+    if( IsAsync( descPtr ) )
+    {
+        pa_flash_Job_t job = { .type = PA_FLASH_JOB_ERASE, .blockIndex = blockIndex };
+
+        return QueueJob( descPtr, &job, NULL );
+    }
+
     if( blockIndex >= descPtr->mtdInfo.nbLeb )
     {
         return LE_OUT_OF_RANGE;
@@ -745,6 +1106,101 @@ le_result_t pa_flash_EraseBlock
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Erase the good blocks where the next pa_flash_Write will write: the physical block at the current
+ * position, or the one after it if the position is not on an erase block frontier, and the
+ * following ones. Bad blocks are skipped as pa_flash_Write does, and a block that fails to erase
+ * is marked bad and skipped if the descriptor was opened with PA_FLASH_OPENMODE_MARKBAD. The
+ * current read/write position is not changed.
+ *
+ * @return
+ *      - LE_OK            On success, even if the end of the partition is reached before nbBlocks
+ *                         blocks are erased
+ *      - LE_BAD_PARAMETER If desc is NULL
+ *      - LE_FAULT         On failure
+ *      - LE_IO_ERROR      If a flash IO error occurs
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flash_EraseNextBlocks
+(
+    pa_flash_Desc_t desc,
+    uint32_t nbBlocks
+)
+{
+    struct erase_info_user eraseMe;
+    pa_flash_MtdDesc_t *descPtr = (pa_flash_MtdDesc_t *)desc;
+    off_t pOffset;
+    loff_t blkOff;
+    uint32_t peb;
+    int rc;
+
+    if( (!descPtr) || (descPtr->magic != desc) )
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    if( IsAsync( descPtr ) )
+    {
+        pa_flash_Job_t job = { .type = PA_FLASH_JOB_ERASE_NEXT, .blockIndex = nbBlocks };
+
+        return QueueJob( descPtr, &job, NULL );
+    }
+
+    pOffset = lseek(descPtr->fd, 0, SEEK_CUR);
+    if( -1 == pOffset )
+    {
+        LE_ERROR("MTD %d: lseek fails for retrieve offset: %m", descPtr->mtdNum);
+        return (EIO == errno) ? LE_IO_ERROR : LE_FAULT;
+    }
+    pOffset -= (off_t)descPtr->mtdInfo.startOffset;
+    peb = ((uint32_t)pOffset + descPtr->mtdInfo.eraseSize - 1) / descPtr->mtdInfo.eraseSize;
+
+    for( ; nbBlocks && (peb < descPtr->mtdInfo.nbBlk); peb++ )
+    {
+        blkOff = ((loff_t)peb * descPtr->mtdInfo.eraseSize) + descPtr->mtdInfo.startOffset;
+        rc = ioctl(descPtr->fd, MEMGETBADBLOCK, &blkOff);
+        if( -1 == rc )
+        {
+            LE_ERROR("MTD %d: MEMGETBADBLOCK fails for peb %u offset %llx: %m",
+                     descPtr->mtdNum, peb, blkOff);
+            return (EIO == errno) ? LE_IO_ERROR : LE_FAULT;
+        }
+        if( rc )
+        {
+            LE_WARN("MTD %d: Skipping bad block: %u", descPtr->mtdNum, peb);
+            continue;
+        }
+
+        eraseMe.start = (uint32_t)blkOff;
+        eraseMe.length = descPtr->mtdInfo.eraseSize;
+        if( -1 == ioctl(descPtr->fd, MEMERASE, &eraseMe) )
+        {
+            LE_ERROR("MTD %d: MEMERASE fails for block %u offset %x: %m",
+                     descPtr->mtdNum, peb, eraseMe.start);
+            if( (EIO != errno) || (!descPtr->markBad) )
+            {
+                return (EIO == errno) ? LE_IO_ERROR : LE_FAULT;
+            }
+            if( -1 == ioctl(descPtr->fd, MEMSETBADBLOCK, &blkOff) )
+            {
+                LE_ERROR("MTD %d: MEMSETBADBLOCK fails for peb %u, offset %llx: %m",
+                         descPtr->mtdNum, peb, blkOff);
+                return (EIO == errno) ? LE_IO_ERROR : LE_FAULT;
+            }
+            LE_INFO("MTD %d: Marked bad block %u", descPtr->mtdNum, peb);
+            if( descPtr->scanDone && (LE_OK != pa_flash_Scan( desc, NULL )) )
+            {
+                return LE_FAULT;
+            }
+            continue;
+        }
+        nbBlocks--;
+    }
+
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the current pointer of the flash to the given offset
@@ -774,6 +1230,13 @@ le_result_t pa_flash_SeekAtOffset
         return LE_BAD_PARAMETER;
     }
 
+    if( IsAsync( descPtr ) )
+    {
+        pa_flash_Job_t job = { .type = PA_FLASH_JOB_SEEK_OFFSET, .offset = offset };
+
+        return QueueJob( descPtr, &job, NULL );
+    }
+
     if( offset > descPtr->mtdInfo.size )
     {
         return LE_OUT_OF_RANGE;
@@ -837,6 +1300,13 @@ le_result_t pa_flash_SeekAtBlock
         return LE_BAD_PARAMETER;
     }
 
+    if( IsAsync( descPtr ) )
+    {
+        pa_flash_Job_t job = { .type = PA_FLASH_JOB_SEEK_BLOCK, .blockIndex = blockIndex };
+
+        return QueueJob( descPtr, &job, NULL );
+    }
+
     if( blockIndex >= descPtr->mtdInfo.nbBlk )
     {
         return LE_OUT_OF_RANGE;
@@ -897,6 +1367,8 @@ le_result_t pa_flash_Read
         return LE_BAD_PARAMETER;
     }
 
+    WaitIdle( descPtr );
+
     if( dataSize > descPtr->mtdInfo.eraseSize )
     {
         return LE_OUT_OF_RANGE;
@@ -964,6 +1436,13 @@ le_result_t pa_flash_Write
         return LE_OUT_OF_RANGE;
     }
 
+    if( IsAsync( descPtr ) )
+    {
+        pa_flash_Job_t job = { .type = PA_FLASH_JOB_WRITE, .dataSize = dataSize };
+
+        return QueueJob( descPtr, &job, dataPtr );
+    }
+
     size_t remain = (dataSize & (descPtr->mtdInfo.writeSize - 1));
     uint8_t padBlock[ descPtr->mtdInfo.writeSize ];
     int32_t nbWrite = dataSize / descPtr->mtdInfo.writeSize;
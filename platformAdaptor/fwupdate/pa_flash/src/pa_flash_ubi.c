@@ -78,6 +78,70 @@
 //--------------------------------------------------------------------------------------------------
 static le_mem_PoolRef_t UbiBlockPool = NULL;
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Path of the UBI scan index of a partition, built with the MTD number and the start offset of
+ * the logical partition. It is kept in RAM (tmpfs) so it does not survive a reboot.
+ */
+//--------------------------------------------------------------------------------------------------
+#define UBI_INDEX_PATH         "/tmp/.pa_flash_ubi_mtd%d_%x.idx"
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Length for building the UBI scan index path, with room for the ".new" suffix
+ */
+//--------------------------------------------------------------------------------------------------
+#define UBI_INDEX_PATH_LENGTH  64
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Magic and version of the UBI scan index
+ */
+//--------------------------------------------------------------------------------------------------
+#define UBI_INDEX_MAGIC        0x55424958U
+#define UBI_INDEX_VERSION      1
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Entry of the UBI scan index for a PEB holding a VID header at the last scan
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t vidCrc;        ///< CRC of the VID header (hdr_crc field)
+    uint32_t vidHdrOffset;  ///< Offset of the VID header in the PEB, 0 if the PEB is not indexed
+    uint32_t dataOffset;    ///< Offset of the data in the PEB, read from the EC header
+}
+UbiIndexPeb_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * UBI scan index of a partition. When the VID header of an indexed PEB is unchanged, the scan
+ * reads only this header and takes the offsets from the index instead of reading the EC header.
+ * PEBs whose VID header has changed are read again and their entry is refreshed.
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint32_t magic;         ///< UBI_INDEX_MAGIC
+    uint32_t version;       ///< UBI_INDEX_VERSION
+    uint32_t size;          ///< Geometry of the partition when the index was built
+    uint32_t eraseSize;
+    uint32_t writeSize;
+    uint32_t startOffset;
+    uint32_t nbBlk;
+    uint32_t crc;           ///< CRC of the index, computed with this field set to 0
+    UbiIndexPeb_t peb[PA_FLASH_MAX_LEB]; ///< Entries, indexed by PEB
+}
+UbiIndex_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pool for the UBI scan indexes
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t UbiIndexPool = NULL;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Update the free size for an ubi volume
@@ -407,6 +471,7 @@ static le_result_t UpdateAllVidBlock
     off_t blkOff;
     uint32_t blk;
     uint32_t dataSize = descPtr->mtdInfo.eraseSize - (2 * descPtr->mtdInfo.writeSize);
+    uint32_t lastSize = newSize % dataSize;
     le_result_t res;
 
     if( descPtr->vtblPtr->vol_type == UBI_VID_STATIC )
@@ -423,15 +488,18 @@ static le_result_t UpdateAllVidBlock
             }
         }
 
-        res = UpdateVidBlock(desc, blk, blockPtr, reservedPebs, newSize % dataSize);
+        // A last block filled up keeps the data size it was written with
+        res = UpdateVidBlock(desc, blk, blockPtr, reservedPebs,
+                             ((UBI_NO_SIZE == newSize) || (0 == lastSize)) ? UBI_NO_SIZE : lastSize);
         if ((LE_OK != res) && (LE_OUT_OF_RANGE != res))
         {
             return res;
         }
     }
+    // Also release the blocks left beyond reserved_pebs by an update of the volume that was
+    // interrupted before its VTBL was written
     for( blk = reservedPebs;
-         (blk < be32toh(descPtr->vtblPtr->reserved_pebs))
-             && (INVALID_PEB != descPtr->lebToPeb[blk]);
+         (blk < PA_FLASH_MAX_LEB) && (INVALID_PEB != descPtr->lebToPeb[blk]);
          blk++ )
     {
         blkOff = descPtr->lebToPeb[blk] * descPtr->mtdInfo.eraseSize;
@@ -781,6 +849,223 @@ static le_result_t ReadVtbl
     return LE_OK;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Build the path of the UBI scan index of the partition
+ */
+//--------------------------------------------------------------------------------------------------
+static void GetUbiIndexPath
+(
+    pa_flash_MtdDesc_t* descPtr,  ///< [IN] Private flash descriptor
+    char*               pathPtr   ///< [OUT] Path, UBI_INDEX_PATH_LENGTH bytes
+)
+{
+    snprintf( pathPtr, UBI_INDEX_PATH_LENGTH, UBI_INDEX_PATH,
+              descPtr->mtdNum, descPtr->mtdInfo.startOffset );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Compute the CRC of an UBI scan index
+ *
+ * @return
+ *      - The CRC
+ */
+//--------------------------------------------------------------------------------------------------
+static uint32_t ComputeUbiIndexCrc
+(
+    UbiIndex_t* indexPtr  ///< [IN] UBI scan index
+)
+{
+    uint32_t crc = indexPtr->crc;
+    uint32_t indexCrc;
+
+    indexPtr->crc = 0;
+    indexCrc = le_crc_Crc32( (uint8_t*)indexPtr, sizeof(UbiIndex_t), LE_CRC_START_CRC32 );
+    indexPtr->crc = crc;
+    return indexCrc;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Load the UBI scan index of the partition. If there is no valid index for this partition, an
+ * empty one is returned.
+ *
+ * @return
+ *      - Pointer to the index, to be given to SaveUbiIndex
+ *      - NULL if the partition is too large to be indexed
+ */
+//--------------------------------------------------------------------------------------------------
+static UbiIndex_t* LoadUbiIndex
+(
+    pa_flash_MtdDesc_t* descPtr  ///< [IN] Private flash descriptor
+)
+{
+    pa_flash_Info_t* infoPtr = &descPtr->mtdInfo;
+    char path[UBI_INDEX_PATH_LENGTH];
+    UbiIndex_t* indexPtr;
+    ssize_t rc = -1;
+    int fd;
+
+    if( infoPtr->nbBlk > PA_FLASH_MAX_LEB )
+    {
+        return NULL;
+    }
+
+    if( !UbiIndexPool )
+    {
+        UbiIndexPool = le_mem_CreatePool("UBI Index Pool", sizeof(UbiIndex_t));
+        le_mem_ExpandPool( UbiIndexPool, 1 );
+    }
+    indexPtr = le_mem_ForceAlloc(UbiIndexPool);
+
+    GetUbiIndexPath( descPtr, path );
+    fd = open( path, O_RDONLY );
+    if( -1 != fd )
+    {
+        rc = read( fd, indexPtr, sizeof(UbiIndex_t) );
+        close( fd );
+    }
+    if( (sizeof(UbiIndex_t) == rc) &&
+        (UBI_INDEX_MAGIC == indexPtr->magic) &&
+        (UBI_INDEX_VERSION == indexPtr->version) &&
+        (infoPtr->size == indexPtr->size) &&
+        (infoPtr->eraseSize == indexPtr->eraseSize) &&
+        (infoPtr->writeSize == indexPtr->writeSize) &&
+        (infoPtr->startOffset == indexPtr->startOffset) &&
+        (infoPtr->nbBlk == indexPtr->nbBlk) &&
+        (ComputeUbiIndexCrc( indexPtr ) == indexPtr->crc) )
+    {
+        return indexPtr;
+    }
+
+    memset( indexPtr, 0, sizeof(UbiIndex_t) );
+    indexPtr->magic = UBI_INDEX_MAGIC;
+    indexPtr->version = UBI_INDEX_VERSION;
+    indexPtr->size = infoPtr->size;
+    indexPtr->eraseSize = infoPtr->eraseSize;
+    indexPtr->writeSize = infoPtr->writeSize;
+    indexPtr->startOffset = infoPtr->startOffset;
+    indexPtr->nbBlk = infoPtr->nbBlk;
+    return indexPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Save the UBI scan index of the partition if it has changed, and release it. If the scan has
+ * failed, the index is only released.
+ */
+//--------------------------------------------------------------------------------------------------
+static void SaveUbiIndex
+(
+    pa_flash_MtdDesc_t* descPtr,  ///< [IN] Private flash descriptor
+    UbiIndex_t*         indexPtr, ///< [IN] UBI scan index, may be NULL
+    bool                isScanOk  ///< [IN] true if the scan was successful
+)
+{
+    char path[UBI_INDEX_PATH_LENGTH];
+    char newPath[UBI_INDEX_PATH_LENGTH];
+    uint32_t crc;
+    ssize_t rc = -1;
+    int fd;
+
+    if( !indexPtr )
+    {
+        return;
+    }
+
+    crc = ComputeUbiIndexCrc( indexPtr );
+    if( isScanOk && (crc != indexPtr->crc) )
+    {
+        indexPtr->crc = crc;
+        GetUbiIndexPath( descPtr, path );
+        snprintf( newPath, sizeof(newPath), "%s.new", path );
+        fd = open( newPath, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
+        if( -1 != fd )
+        {
+            rc = write( fd, indexPtr, sizeof(UbiIndex_t) );
+            close( fd );
+        }
+        if( (sizeof(UbiIndex_t) != rc) || (-1 == rename( newPath, path )) )
+        {
+            LE_WARN("MTD %d: Unable to save UBI index %s: %m", descPtr->mtdNum, path);
+            unlink( newPath );
+        }
+    }
+    le_mem_Release(indexPtr);
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read the UBI headers of a PEB during a scan. If the PEB is in the index and its VID header is
+ * unchanged, only the VID header is read.
+ *
+ * @return
+ *      - LE_OK            On success, the VID header is valid
+ *      - LE_FORMAT_ERROR  The PEB is erased or has no VID header: it is free
+ *      - LE_FAULT         On failure
+ *      - others           Depending of the flash operations
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadPebHeaders
+(
+    pa_flash_MtdDesc_t* descPtr,      ///< [IN] Private flash descriptor
+    UbiIndex_t*         indexPtr,     ///< [IN] UBI scan index, may be NULL
+    uint32_t            peb,          ///< [IN] PEB to read
+    struct ubi_vid_hdr* vidHeaderPtr, ///< [OUT] VID header
+    uint32_t*           dataOffsetPtr ///< [OUT] Offset of the data in the PEB
+)
+{
+    pa_flash_Desc_t desc = (pa_flash_Desc_t)descPtr;
+    off_t pebOffset = peb * descPtr->mtdInfo.eraseSize;
+    UbiIndexPeb_t* entryPtr = (indexPtr ? &indexPtr->peb[peb] : NULL);
+    struct ubi_ec_hdr ecHeader;
+    le_result_t res;
+
+    if( entryPtr && entryPtr->vidHdrOffset )
+    {
+        res = pa_flash_SeekAtOffset( desc, pebOffset + entryPtr->vidHdrOffset );
+        if( LE_OK == res )
+        {
+            res = pa_flash_Read( desc, (uint8_t*)vidHeaderPtr, UBI_VID_HDR_SIZE );
+        }
+        if( LE_OK != res )
+        {
+            return res;
+        }
+        if( ((uint32_t)UBI_VID_HDR_MAGIC == be32toh(vidHeaderPtr->magic)) &&
+            (UBI_VERSION == vidHeaderPtr->version) &&
+            (be32toh(vidHeaderPtr->hdr_crc) == entryPtr->vidCrc) &&
+            (le_crc_Crc32( (uint8_t*)vidHeaderPtr, UBI_VID_HDR_SIZE_CRC, LE_CRC_START_CRC32 )
+                 == entryPtr->vidCrc) )
+        {
+            *dataOffsetPtr = entryPtr->dataOffset;
+            return LE_OK;
+        }
+        // The PEB was rewritten since the last scan
+        memset( entryPtr, 0, sizeof(UbiIndexPeb_t) );
+    }
+
+    res = ReadEcHeader( desc, pebOffset, &ecHeader, false );
+    if( LE_OK != res )
+    {
+        return res;
+    }
+    res = ReadVidHeader( desc, pebOffset, vidHeaderPtr, be32toh(ecHeader.vid_hdr_offset) );
+    if( LE_OK != res )
+    {
+        return res;
+    }
+    *dataOffsetPtr = be32toh(ecHeader.data_offset);
+    if( entryPtr )
+    {
+        entryPtr->vidCrc = be32toh(vidHeaderPtr->hdr_crc);
+        entryPtr->vidHdrOffset = be32toh(ecHeader.vid_hdr_offset);
+        entryPtr->dataOffset = *dataOffsetPtr;
+    }
+    return LE_OK;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Check if the partition is an UBI container and all blocks belonging to this partition are valid.
@@ -859,6 +1144,8 @@ error:
  * Scan an UBI partition for the volumes number and volumes name
  * volume ID.
  *
+ * The headers of the PEBs are cached in a scan index in /tmp, see pa_flash_ScanUbi().
+ *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or is not a valid descriptor
@@ -878,13 +1165,13 @@ le_result_t pa_flash_ScanUbiForVolumes
 {
     pa_flash_MtdDesc_t *descPtr = (pa_flash_MtdDesc_t *)desc;
     uint32_t peb;
-    struct ubi_ec_hdr ecHeader;
     struct ubi_vid_hdr vidHeader;
     off_t pebOffset;
     bool isBad;
-    uint32_t iVtblPeb = 0;
+    uint32_t iVtblPeb = 0, dataOffset;
     le_result_t res;
     pa_flash_Info_t *infoPtr = &descPtr->mtdInfo;
+    UbiIndex_t* indexPtr;
 
     if( (!descPtr) || (descPtr->magic != desc))
     {
@@ -898,6 +1185,7 @@ le_result_t pa_flash_ScanUbiForVolumes
     memset(descPtr->vtbl, 0, sizeof(struct ubi_vtbl_record) * PA_FLASH_UBI_MAX_VOLUMES);
     memset(descPtr->vtblPeb, -1, sizeof(descPtr->vtblPeb));
     memset(descPtr->lebToPeb, -1, sizeof(descPtr->lebToPeb));
+    indexPtr = LoadUbiIndex( descPtr );
     for( peb = 0; (peb < infoPtr->nbBlk); peb++ )
     {
         LE_DEBUG("Check if bad block at peb %u", peb);
@@ -913,28 +1201,19 @@ le_result_t pa_flash_ScanUbiForVolumes
         }
 
         pebOffset = peb * infoPtr->eraseSize;
-        res = ReadEcHeader( descPtr, pebOffset, &ecHeader, false );
-        if (LE_FORMAT_ERROR == res)
-        {
-            continue;
-        }
-        else if (LE_OK != res)
-        {
-            goto error;
-        }
-        res = ReadVidHeader( descPtr, pebOffset, &vidHeader, be32toh(ecHeader.vid_hdr_offset) );
+        res = ReadPebHeaders( descPtr, indexPtr, peb, &vidHeader, &dataOffset );
         if (LE_FORMAT_ERROR == res)
         {
             continue;
         }
         if (LE_OK != res)
         {
-            LE_CRIT("Error when reading VID Header at %d", peb);
+            LE_CRIT("Error when reading UBI headers at %d", peb);
             goto error;
         }
         if (UBI_LAYOUT_VOLUME_ID == be32toh(vidHeader.vol_id))
         {
-            res = ReadVtbl( descPtr, pebOffset, descPtr->vtbl, be32toh(ecHeader.data_offset) );
+            res = ReadVtbl( descPtr, pebOffset, descPtr->vtbl, dataOffset );
             if (LE_OK != res)
             {
                 LE_CRIT("Error when reading Vtbl at %d", peb);
@@ -955,8 +1234,10 @@ le_result_t pa_flash_ScanUbiForVolumes
         (INVALID_PEB == descPtr->vtblPeb[1]) )
     {
         LE_ERROR("No volume present on MTD %d or NOT an UBI", descPtr->mtdNum);
+        SaveUbiIndex( descPtr, indexPtr, false );
         return LE_FORMAT_ERROR;
     }
+    SaveUbiIndex( descPtr, indexPtr, true );
 
     if ((ubiVolNumberPtr) && (ubiVolName))
     {
@@ -979,6 +1260,7 @@ le_result_t pa_flash_ScanUbiForVolumes
     return LE_OK;
 
 error:
+    SaveUbiIndex( descPtr, indexPtr, false );
     return (LE_IO_ERROR == res ? LE_IO_ERROR : LE_FAULT);
 }
 
@@ -987,6 +1269,11 @@ error:
  * Scan a partition for the UBI volume ID given. Update the LebToPeb array field with LEB for this
  * volume ID.
  *
+ * The offsets and the VID header CRC of every used PEB are saved in a scan index in /tmp at the
+ * end of a successful scan. The next scans of the partition read only the VID header of the PEBs
+ * found in the index and skip their EC header, as long as the VID header CRC is unchanged. Other
+ * PEBs are fully read and their entry is refreshed. The index is lost at reboot.
+ *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or is not a valid descriptor
@@ -994,6 +1281,7 @@ error:
  *      - LE_OUT_OF_RANGE  If the UBI volume ID is over its permitted values
  *      - LE_IO_ERROR      If a flash IO error occurs
  *      - LE_FORMAT_ERROR  If the flash is not in UBI format
+ *      - LE_NOT_PERMITTED If the descriptor was opened with PA_FLASH_OPENMODE_ASYNC
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_flash_ScanUbi
@@ -1004,19 +1292,30 @@ le_result_t pa_flash_ScanUbi
 {
     pa_flash_MtdDesc_t* descPtr = (pa_flash_MtdDesc_t *)desc;
     uint32_t peb;
-    struct ubi_ec_hdr ecHeader;
     struct ubi_vid_hdr vidHeader;
     off_t pebOffset;
     bool isBad;
-    uint32_t iVtblPeb = 0, ubiVolSize = 0;
+    uint32_t iVtblPeb = 0, ubiVolSize = 0, dataOffset;
     le_result_t res;
     pa_flash_Info_t* infoPtr;
+    UbiIndex_t* indexPtr;
 
     if( (!descPtr) || (descPtr->magic != desc) || (ubiVolId >= PA_FLASH_UBI_MAX_VOLUMES) )
     {
         return LE_BAD_PARAMETER;
     }
 
+    if( descPtr->ioThreadRef )
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    res = pa_flashUbi_FlushHeaders( descPtr );
+    if( LE_OK != res )
+    {
+        return res;
+    }
+
     infoPtr = &descPtr->mtdInfo;
     descPtr->scanDone = false;
     descPtr->ubiBadBlkCnt = 0;
@@ -1031,6 +1330,7 @@ le_result_t pa_flash_ScanUbi
     memset(descPtr->vtblPeb, -1, sizeof(descPtr->vtblPeb));
     memset(descPtr->lebToPeb, -1, sizeof(descPtr->lebToPeb));
 
+    indexPtr = LoadUbiIndex( descPtr );
     for( peb = 0; peb < infoPtr->nbBlk; peb++ )
     {
         LE_DEBUG("Check if bad block at peb %u", peb);
@@ -1047,17 +1347,7 @@ le_result_t pa_flash_ScanUbi
         }
 
         pebOffset = peb * infoPtr->eraseSize;
-        res = ReadEcHeader( descPtr, pebOffset, &ecHeader, false );
-        if (LE_FORMAT_ERROR == res)
-        {
-            infoPtr->ubiPebFreeCount++;
-            continue;
-        }
-        else if (LE_OK != res)
-        {
-            goto error;
-        }
-        res = ReadVidHeader( descPtr, pebOffset, &vidHeader, be32toh(ecHeader.vid_hdr_offset) );
+        res = ReadPebHeaders( descPtr, indexPtr, peb, &vidHeader, &dataOffset );
         if (LE_FORMAT_ERROR == res)
         {
             infoPtr->ubiPebFreeCount++;
@@ -1065,12 +1355,12 @@ le_result_t pa_flash_ScanUbi
         }
         if (LE_OK != res)
         {
-            LE_CRIT("Error when reading VID Header at %d", peb);
+            LE_CRIT("Error when reading UBI headers at %d", peb);
             goto error;
         }
         if (UBI_LAYOUT_VOLUME_ID == be32toh(vidHeader.vol_id))
         {
-            res = ReadVtbl( descPtr, pebOffset, descPtr->vtbl, be32toh(ecHeader.data_offset) );
+            res = ReadVtbl( descPtr, pebOffset, descPtr->vtbl, dataOffset );
             if (LE_OK != res)
             {
                 LE_CRIT("Error when reading Vtbl at %d", peb);
@@ -1091,7 +1381,7 @@ le_result_t pa_flash_ScanUbi
         else if ((be32toh(vidHeader.vol_id) < PA_FLASH_UBI_MAX_VOLUMES) &&
                  (be32toh(vidHeader.vol_id) == ubiVolId))
         {
-            descPtr->ubiOffset = be32toh(ecHeader.data_offset);
+            descPtr->ubiOffset = dataOffset;
             descPtr->lebToPeb[be32toh(vidHeader.lnum)] = peb;
             if( UBI_VID_STATIC == vidHeader.vol_type )
             {
@@ -1122,8 +1412,10 @@ le_result_t pa_flash_ScanUbi
     {
         LE_ERROR("Volume ID %d not present on MTD %d or NOT an UBI",
                  ubiVolId, descPtr->mtdNum);
+        SaveUbiIndex( descPtr, indexPtr, false );
         return LE_FORMAT_ERROR;
     }
+    SaveUbiIndex( descPtr, indexPtr, true );
 
     int i, j;
     for( i = 0; i < PA_FLASH_UBI_MAX_VOLUMES; i++ )
@@ -1149,6 +1441,7 @@ le_result_t pa_flash_ScanUbi
     return LE_OK;
 
 error:
+    SaveUbiIndex( descPtr, indexPtr, false );
     return LE_FAULT;
 }
 
@@ -1161,6 +1454,7 @@ error:
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or is not a valid descriptor
  *      - LE_FORMAT_ERROR  If the flash is not in UBI format
+ *      - LE_NOT_PERMITTED If the descriptor was opened with PA_FLASH_OPENMODE_ASYNC
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_flash_UnscanUbi
@@ -1170,12 +1464,24 @@ le_result_t pa_flash_UnscanUbi
 {
     pa_flash_MtdDesc_t* descPtr = (pa_flash_MtdDesc_t *)desc;
     pa_flash_Info_t* infoPtr;
+    le_result_t res;
 
     if( (!descPtr) || (descPtr->magic != desc))
     {
         return LE_BAD_PARAMETER;
     }
 
+    if( descPtr->ioThreadRef )
+    {
+        return LE_NOT_PERMITTED;
+    }
+
+    res = pa_flashUbi_FlushHeaders( descPtr );
+    if( LE_OK != res )
+    {
+        return res;
+    }
+
     infoPtr = &descPtr->mtdInfo;
     infoPtr->nbLeb = infoPtr->nbBlk;
     infoPtr->ubi = false;
@@ -1354,25 +1660,17 @@ le_result_t pa_flash_WriteUbiAtBlock
                  blk, descPtr->ubiVolumeId, descPtr->vtblPtr->name);
         reservedPebs++;
 
-        if( descPtr->vtblPtr->vol_type == UBI_VID_STATIC )
-        {
-            res = UpdateAllVidBlock( desc, blockPtr, reservedPebs, UBI_NO_SIZE );
-            if (LE_OK != res)
-            {
-                goto error;
-            }
-        }
-        res = UpdateVtbl( desc, blockPtr, reservedPebs );
-        if (LE_OK != res)
-        {
-            goto error;
-        }
+        // Rewriting the VID header of every block of the volume and the VTBL for each block added
+        // is quadratic in the volume size: this is done once for PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS
+        // blocks added, and by pa_flash_AdjustUbiSize, pa_flash_Flush or pa_flash_Close
+        descPtr->ubiHdrPending = true;
+        descPtr->ubiHdrPendingBlocks++;
 
         res = GetNewBlock( desc, blockPtr, &eraseCount, &ieb );
         if( LE_OK != res )
         {
             LE_CRIT("Failed to add one block on volume %d", descPtr->ubiVolumeId);
-            return res;
+            goto error;
         }
 
         ecHdrPtr = (struct ubi_ec_hdr *)blockPtr;
@@ -1384,6 +1682,12 @@ le_result_t pa_flash_WriteUbiAtBlock
         vidHdrPtr = (struct ubi_vid_hdr *)(blockPtr + be32toh(ecHdrPtr->vid_hdr_offset));
         CreateVidHeader(descPtr, vidHdrPtr, blk, reservedPebs);
         descPtr->vtblPtr->reserved_pebs = htobe32(reservedPebs);
+        if( INVALID_PEB != descPtr->lebToPeb[blk] )
+        {
+            // This LEB was written by an update interrupted before the VTBL was written: release
+            // its old block once the new one is written
+            pebErase = descPtr->lebToPeb[blk];
+        }
         descPtr->lebToPeb[blk] = ieb;
         blkOff = descPtr->lebToPeb[blk] * infoPtr->eraseSize;
         res = pa_flash_SeekAtOffset( desc, blkOff );
@@ -1548,6 +1852,15 @@ le_result_t pa_flash_WriteUbiAtBlock
                                      infoPtr->writeSize );
     }
 
+    // Keep the blocks past the reserved_pebs of the VTBL on the flash few, as UBI refuses to attach
+    // a volume with such blocks
+    if( (LE_OK == res) &&
+        (descPtr->ubiHdrPendingBlocks >= PA_FLASH_UBI_HDR_FLUSH_NB_BLOCKS) )
+    {
+        le_mem_Release(blockPtr);
+        return pa_flashUbi_FlushHeaders( descPtr );
+    }
+
 error:
     if( blockPtr )
     {
@@ -1556,6 +1869,83 @@ error:
     return res;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write the UBI VID headers and VTBL whose update was deferred by pa_flash_WriteUbiAtBlock when
+ * the volume was extended. Only the VID headers with an outdated used_ebs are rewritten.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - others           Depending of the flash operations
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flashUbi_FlushHeaders
+(
+    pa_flash_MtdDesc_t *descPtr   ///< [IN] Private flash descriptor
+)
+{
+    pa_flash_Desc_t desc = (pa_flash_Desc_t)descPtr;
+    pa_flash_Info_t* infoPtr = &descPtr->mtdInfo;
+    struct ubi_ec_hdr* ecHdrPtr;
+    struct ubi_vid_hdr* vidHdrPtr;
+    uint32_t blk, reservedPebs;
+    uint8_t* blockPtr;
+    le_result_t res = LE_OK;
+
+    if( (!descPtr->ubiHdrPending) || (!descPtr->vtblPtr) )
+    {
+        descPtr->ubiHdrPending = false;
+        descPtr->ubiHdrPendingBlocks = 0;
+        return LE_OK;
+    }
+
+    if( (!UbiBlockPool) )
+    {
+        UbiBlockPool = le_mem_CreatePool("UBI Block Pool", infoPtr->eraseSize);
+        le_mem_ExpandPool( UbiBlockPool, 1 );
+    }
+    blockPtr = le_mem_ForceAlloc(UbiBlockPool);
+
+    reservedPebs = be32toh(descPtr->vtblPtr->reserved_pebs);
+    LE_DEBUG("Updating headers of VolId %d for %u blocks", descPtr->ubiVolumeId, reservedPebs);
+    if( descPtr->vtblPtr->vol_type == UBI_VID_STATIC )
+    {
+        for( blk = 0; (blk < reservedPebs) && (LE_OK == res); blk++ )
+        {
+            if( INVALID_PEB == descPtr->lebToPeb[blk] )
+            {
+                continue;
+            }
+            res = pa_flash_SeekAtOffset( desc, descPtr->lebToPeb[blk] * infoPtr->eraseSize );
+            if( LE_OK == res )
+            {
+                res = pa_flash_Read( desc, blockPtr, PEB_HDR_NB_BLOCKS * infoPtr->writeSize );
+            }
+            if( LE_OK != res )
+            {
+                break;
+            }
+            ecHdrPtr = (struct ubi_ec_hdr *)blockPtr;
+            vidHdrPtr = (struct ubi_vid_hdr *)(blockPtr + be32toh(ecHdrPtr->vid_hdr_offset));
+            if( be32toh(vidHdrPtr->used_ebs) != reservedPebs )
+            {
+                res = UpdateVidBlock( desc, blk, blockPtr, reservedPebs, UBI_NO_SIZE );
+            }
+        }
+    }
+    if( LE_OK == res )
+    {
+        res = UpdateVtbl( desc, blockPtr, reservedPebs );
+    }
+    if( LE_OK == res )
+    {
+        descPtr->ubiHdrPending = false;
+        descPtr->ubiHdrPendingBlocks = 0;
+    }
+    le_mem_Release(blockPtr);
+    return res;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Adjust (reduce) the UBI volume size to the given size.
@@ -1608,7 +1998,8 @@ le_result_t pa_flash_AdjustUbiSize
         }
         blockPtr = le_mem_ForceAlloc(UbiBlockPool);
 
-        if( (reservedPebs == be32toh(descPtr->vtblPtr->reserved_pebs)) )
+        if( (reservedPebs == be32toh(descPtr->vtblPtr->reserved_pebs)) &&
+            (!(descPtr->ubiHdrPending && (descPtr->vtblPtr->vol_type == UBI_VID_STATIC))) )
         {
             res = LE_OK;
             if (lastSize)
@@ -1619,6 +2010,7 @@ le_result_t pa_flash_AdjustUbiSize
         }
         else
         {
+            // Also done when the volume was extended, to update the VID headers of all its blocks
             LE_DEBUG("Starting to reduce reserved_pebs for VolId %d", descPtr->ubiVolumeId);
             res = UpdateAllVidBlock( desc, blockPtr, reservedPebs, newSize );
         }
@@ -1631,9 +2023,10 @@ le_result_t pa_flash_AdjustUbiSize
         {
             goto error;
         }
+        descPtr->ubiHdrPending = false;
         le_mem_Release(blockPtr);
     }
-    return LE_OK;
+    return pa_flashUbi_FlushHeaders( descPtr );
 
 error:
     if( blockPtr )
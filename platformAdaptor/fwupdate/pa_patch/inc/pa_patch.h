@@ -17,6 +17,18 @@
 //--------------------------------------------------------------------------------------------------
 #define PA_PATCH_MAX_SEGMENTSIZE (1024U * 1024U)
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Define the default ceiling of the memory used for the flash buffers of a patch. The patch uses
+ * flash-block-sized buffers: up to two for the destination and the rest as a read-ahead cache of
+ * the origin. With less than three blocks, the flash accesses are done synchronously.
+ * May be overridden by the build (-DPA_PATCH_MAX_MEMORY=...) for modules with little RAM.
+ */
+//--------------------------------------------------------------------------------------------------
+#ifndef PA_PATCH_MAX_MEMORY
+#define PA_PATCH_MAX_MEMORY (2U * PA_PATCH_MAX_SEGMENTSIZE)
+#endif
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Define the open mode options and type for pa_patch
@@ -75,6 +87,7 @@ typedef struct
     size_t               destImageSize;  ///< Full size of the image for destination
     uint32_t             destImageCrc32; ///< CRC32 of the image for destination
     pa_patch_ImageDesc_t destImageDesc;  ///< Device description for destination
+    size_t               maxMemory;      ///< Ceiling of the memory used for the flash buffers
 }
 pa_patch_Context_t;
 
@@ -93,7 +106,8 @@ typedef void *pa_patch_Desc_t;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Open a patch context and return a patch descriptor
+ * Open a patch context and return a patch descriptor. The descriptor may be kept open to apply
+ * all the patch segments of an image.
  *
  * @return
  *      - LE_OK            On success
@@ -107,19 +121,18 @@ typedef void *pa_patch_Desc_t;
 le_result_t pa_patch_Open
 (
     pa_patch_Context_t *ctx,  ///< [IN] Context of the patch to be open
-    pa_patch_Desc_t *desc,    ///< [OUT] Private patch descriptor
-    uint8_t **origDataPtr,    ///< [OUT] Pointer to the orig data buffer
-    uint8_t **destDataPtr     ///< [OUT] Pointer to the dest data buffer
+    pa_patch_Desc_t *desc     ///< [OUT] Private patch descriptor
 );
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Close a patch descriptor
+ * Close a patch descriptor. The pending writes are completed before.
  *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or not a valid patch descriptor
- *      - others           Depending of the image type and PA device used
+ *      - others           Depending of the image type and PA device used, or the error of a
+ *                         pending write
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_patch_Close
@@ -131,47 +144,92 @@ le_result_t pa_patch_Close
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Read data starting the given block. If a Bad block is detected,
- * the error LE_IO_ERROR is returned and operation is aborted.
- * Note that the length should not be greater than eraseSize
+ * Return the size of the data of a flash block: the erase block for RAW flash, the LEB for UBI.
+ * The origin and destination images are read and written by flash blocks.
+ *
+ * @return
+ *      - The size of a block, 0 if desc is not a valid patch descriptor
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pa_patch_GetBlockSize
+(
+    pa_patch_Desc_t desc      ///< [IN] Private patch descriptor
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the origin data of the block containing the given offset. The data are read from the
+ * read-ahead cache, or from the flash if not cached yet, and the next block is read ahead.
+ * The returned pointer is valid until the next call.
  *
  * @return
  *      - LE_OK            On success
- *      - LE_BAD_PARAMETER If desc is NULL or dataPtr is NULL or dataSizePtr is NULL
- *      - LE_FAULT         On failure
+ *      - LE_BAD_PARAMETER If desc is NULL or a pointer is NULL
  *      - LE_OUT_OF_RANGE  If the block is outside the partition
  *      - others           Depending of the image type and PA device used
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_patch_ReadSegment
+le_result_t pa_patch_ReadOrigBlock
 (
     pa_patch_Desc_t desc,     ///< [IN] Private patch descriptor
-    off_t offset,             ///< [IN] Offset of the data to read
-    uint8_t *dataPtr,         ///< [IN] Pointer to data to be read
-    size_t *dataSizePtr       ///< [OUT] Pointer to real amount of data read
+    off_t offset,             ///< [IN] Offset in the origin image
+    const uint8_t **dataPtr,  ///< [OUT] Pointer to the data of the block
+    off_t *blockOffsetPtr,    ///< [OUT] Offset of the block in the origin image
+    size_t *dataSizePtr       ///< [OUT] Size of the data of the block
 );
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Write data starting the given block. If a Bad block is detected,
- * the error LE_IO_ERROR is returned and operation is aborted.
- * Note that the block should be erased before the first write (pa_patch_EraseAtBlock)
- * Note that the length should be a multiple of writeSize and should not be greater than eraseSize
+ * Get a free destination buffer of one block. If all the destination buffers are being written,
+ * wait until one is written.
  *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or dataPtr is NULL
- *      - LE_FAULT         On failure
- *      - LE_OUT_OF_RANGE  If the block is outside the partition
- *      - others           Depending of the image type and PA device used
+ *      - others           The error of a previous write
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_patch_WriteSegment
+le_result_t pa_patch_GetDestBuffer
 (
     pa_patch_Desc_t desc,     ///< [IN] Private patch descriptor
-    off_t offset,             ///< [IN] Offset of the data to be written
-    uint8_t *dataPtr,         ///< [IN] Pointer to data to be written
+    uint8_t **dataPtr         ///< [OUT] Pointer to the destination buffer
+);
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a destination buffer at the block of the given offset. The block is erased before. The
+ * write is queued and the buffer is given back to the patch descriptor: it must not be accessed
+ * anymore. If a Bad block is detected, the error LE_IO_ERROR is returned by a later call.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or dataPtr is not a destination buffer
+ *      - others           The error of a previous write
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_patch_WriteDestBlock
+(
+    pa_patch_Desc_t desc,     ///< [IN] Private patch descriptor
+    off_t offset,             ///< [IN] Offset of the block in the destination image
+    uint8_t *dataPtr,         ///< [IN] Destination buffer to be written
     size_t dataSize           ///< [IN] Size of data to write
 );
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until all the queued writes are done, and flush the destination flash, so that the blocks
+ * written are on the flash and, for an UBI volume, covered by its headers. Called before the
+ * progress of the update is recorded.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or not a valid patch descriptor
+ *      - others           The error of a write
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_patch_Flush
+(
+    pa_patch_Desc_t desc      ///< [IN] Private patch descriptor
+);
+
 #endif // LEGATO_PA_PATCH_INCLUDE_GUARD
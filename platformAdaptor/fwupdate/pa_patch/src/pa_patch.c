@@ -9,6 +9,53 @@
 #include "pa_patch.h"
 #include "pa_flash.h"
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Maximum number of origin blocks kept in the read-ahead cache
+ */
+//--------------------------------------------------------------------------------------------------
+#define PATCH_MAX_ORIG_BLOCKS  16
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Number of destination buffers: one is filled by the patch while the other is written
+ */
+//--------------------------------------------------------------------------------------------------
+#define PATCH_MAX_DEST_BLOCKS  2
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * State of a block buffer
+ */
+//--------------------------------------------------------------------------------------------------
+typedef enum
+{
+    BLOCK_FREE = 0,         ///< Buffer not used
+    BLOCK_LOADING,          ///< Origin block queued or being read
+    BLOCK_VALID,            ///< Origin block read
+    BLOCK_FILLING,          ///< Destination buffer given to the patch
+    BLOCK_WRITING,          ///< Destination block queued or being written
+}
+BlockState_t;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Buffer of one flash block, for the origin or the destination image
+ */
+//--------------------------------------------------------------------------------------------------
+typedef struct
+{
+    uint8_t *dataPtr;       ///< Data of the block
+    BlockState_t state;     ///< State of the buffer
+    off_t offset;           ///< Offset of the block in the image
+    size_t size;            ///< Size of the data
+    le_result_t result;     ///< Result of the read of an origin block
+    uint32_t seq;           ///< Order of the writes, or of the last use of an origin block
+    bool isQueued;          ///< The I/O thread has not started the read or write yet
+    bool isUrgent;          ///< The patch is waiting for this origin block
+}
+Block_t;
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Internal descriptor type for patch access
@@ -24,8 +71,18 @@ typedef struct
     pa_flash_Desc_t flashDestDesc;
     pa_flash_Info_t *flashDestInfo;
     pa_flash_LebToPeb_t *flashDestLebToPeb;
-    uint8_t *origDataPtr;
-    uint8_t *destDataPtr;
+    size_t blockSize;                           ///< Size of the data of a block
+    uint32_t nbOrigBlocks;                      ///< Number of origin buffers
+    Block_t origBlocks[PATCH_MAX_ORIG_BLOCKS];  ///< Read-ahead cache of the origin
+    uint32_t nbDestBlocks;                      ///< Number of destination buffers
+    Block_t destBlocks[PATCH_MAX_DEST_BLOCKS];  ///< Destination buffers
+    uint32_t seq;                               ///< Sequence counter of the block accesses
+    le_result_t writeResult;                    ///< First error returned by a write
+    le_thread_Ref_t ioThreadRef;                ///< I/O thread, NULL if accesses are synchronous
+    le_mutex_Ref_t mutexRef;                    ///< Protect the blocks against the I/O thread
+    le_sem_Ref_t jobSemRef;                     ///< Posted for each job queued to the I/O thread
+    le_sem_Ref_t doneSemRef;                    ///< Posted for each job done by the I/O thread
+    bool isStopping;                            ///< The I/O thread has to exit
 }
 pa_patch_InternalDesc_t;
 
@@ -38,10 +95,515 @@ static le_mem_PoolRef_t PatchDescPool = NULL;
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Pool for the patch segment buffer
+ * Pool for the block buffers, and size of its blocks (the flash erase block)
+ */
+//--------------------------------------------------------------------------------------------------
+static le_mem_PoolRef_t PatchBlockPool = NULL;
+static size_t PatchBlockPoolSize = 0;
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Read a block of the origin image into a buffer
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_OUT_OF_RANGE  If the block is outside the partition
+ *      - others           Depending of the image type and PA device used
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t ReadBlock
+(
+    pa_patch_InternalDesc_t *descPtr,   ///< [IN] Internal patch descriptor
+    Block_t *blockPtr                   ///< [IN] Block to read
+)
+{
+    size_t size = descPtr->blockSize;
+    le_result_t res;
+
+    blockPtr->size = 0;
+    switch( descPtr->context.origImage )
+    {
+        case PA_PATCH_IMAGE_RAWFLASH:
+             if( (blockPtr->offset + (off_t)size) > (off_t)(descPtr->flashOrigInfo->nbLeb *
+                                                            descPtr->flashOrigInfo->eraseSize) )
+             {
+                 return LE_OUT_OF_RANGE;
+             }
+             res = pa_flash_SeekAtOffset( descPtr->flashOrigDesc, blockPtr->offset );
+             if( LE_OK != res )
+             {
+                 return res;
+             }
+             res = pa_flash_Read( descPtr->flashOrigDesc, blockPtr->dataPtr, size );
+             break;
+        case PA_PATCH_IMAGE_UBIFLASH:
+             res = pa_flash_ReadUbiAtBlock( descPtr->flashOrigDesc,
+                                            blockPtr->offset / descPtr->blockSize,
+                                            blockPtr->dataPtr, &size );
+             break;
+        default:
+             return LE_UNSUPPORTED;
+    }
+    if( LE_OK == res )
+    {
+        blockPtr->size = size;
+    }
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Erase and write a block of the destination image from a buffer
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_OUT_OF_RANGE  If the block is outside the partition
+ *      - others           Depending of the image type and PA device used
  */
 //--------------------------------------------------------------------------------------------------
-le_mem_PoolRef_t PatchSegmentPool = NULL;
+static le_result_t WriteBlock
+(
+    pa_patch_InternalDesc_t *descPtr,   ///< [IN] Internal patch descriptor
+    Block_t *blockPtr                   ///< [IN] Block to write
+)
+{
+    size_t writeSize = descPtr->flashDestInfo->writeSize;
+    le_result_t res;
+
+    switch( descPtr->context.destImage )
+    {
+        case PA_PATCH_IMAGE_RAWFLASH:
+             // Pad a partial block as erased flash
+             memset( blockPtr->dataPtr + blockPtr->size, 0xFF,
+                     descPtr->blockSize - blockPtr->size );
+             LE_DEBUG("Erase and write blk %lx\n",
+                      blockPtr->offset / descPtr->flashDestInfo->eraseSize);
+             res = pa_flash_EraseBlock( descPtr->flashDestDesc,
+                                        blockPtr->offset / descPtr->flashDestInfo->eraseSize );
+             if( LE_OK != res )
+             {
+                 return res;
+             }
+             res = pa_flash_SeekAtOffset( descPtr->flashDestDesc, blockPtr->offset );
+             if( LE_OK != res )
+             {
+                 return res;
+             }
+             return pa_flash_Write( descPtr->flashDestDesc, blockPtr->dataPtr,
+                                    descPtr->blockSize );
+        case PA_PATCH_IMAGE_UBIFLASH:
+             return pa_flash_WriteUbiAtBlock( descPtr->flashDestDesc,
+                                              blockPtr->offset / descPtr->blockSize,
+                                              blockPtr->dataPtr,
+                                              (blockPtr->size + (writeSize - 1)) &
+                                              ~(writeSize - 1),
+                                              true );
+        default:
+             return LE_UNSUPPORTED;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Do the read or the write of a block and update its state. Called by the I/O thread, or by the
+ * caller if the accesses are synchronous. The mutex must not be held.
+ */
+//--------------------------------------------------------------------------------------------------
+static void RunJob
+(
+    pa_patch_InternalDesc_t *descPtr,   ///< [IN] Internal patch descriptor
+    Block_t *blockPtr                   ///< [IN] Block to read or write
+)
+{
+    le_result_t res;
+
+    if( BLOCK_LOADING == blockPtr->state )
+    {
+        res = ReadBlock( descPtr, blockPtr );
+
+        le_mutex_Lock( descPtr->mutexRef );
+        blockPtr->result = res;
+        blockPtr->state = BLOCK_VALID;
+        le_mutex_Unlock( descPtr->mutexRef );
+    }
+    else
+    {
+        res = WriteBlock( descPtr, blockPtr );
+        if( LE_OK != res )
+        {
+            LE_ERROR("Write of block at %lx fails: %d\n", blockPtr->offset, res);
+        }
+
+        le_mutex_Lock( descPtr->mutexRef );
+        if( (LE_OK != res) && (LE_OK == descPtr->writeResult) )
+        {
+            descPtr->writeResult = res;
+        }
+        blockPtr->state = BLOCK_FREE;
+        le_mutex_Unlock( descPtr->mutexRef );
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Pick the next job of the I/O thread: the origin block the patch is waiting for, then the writes
+ * in order, then the read-ahead. The mutex must be held.
+ *
+ * @return
+ *      - The block to read or write, NULL if there is no job queued
+ */
+//--------------------------------------------------------------------------------------------------
+static Block_t *NextJob
+(
+    pa_patch_InternalDesc_t *descPtr    ///< [IN] Internal patch descriptor
+)
+{
+    Block_t *jobPtr = NULL;
+    uint32_t i;
+
+    for( i = 0; i < descPtr->nbOrigBlocks; i++ )
+    {
+        if( descPtr->origBlocks[i].isQueued && descPtr->origBlocks[i].isUrgent )
+        {
+            return &descPtr->origBlocks[i];
+        }
+    }
+    for( i = 0; i < descPtr->nbDestBlocks; i++ )
+    {
+        if( descPtr->destBlocks[i].isQueued &&
+            ((!jobPtr) || ((int32_t)(descPtr->destBlocks[i].seq - jobPtr->seq) < 0)) )
+        {
+            jobPtr = &descPtr->destBlocks[i];
+        }
+    }
+    for( i = 0; (!jobPtr) && (i < descPtr->nbOrigBlocks); i++ )
+    {
+        if( descPtr->origBlocks[i].isQueued )
+        {
+            jobPtr = &descPtr->origBlocks[i];
+        }
+    }
+    return jobPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * I/O thread: read and write the flash blocks queued by the patch, so that the flash accesses
+ * overlap the decompression of the patch.
+ */
+//--------------------------------------------------------------------------------------------------
+static void *IoThread
+(
+    void *contextPtr    ///< [IN] Internal patch descriptor
+)
+{
+    pa_patch_InternalDesc_t *descPtr = (pa_patch_InternalDesc_t *)contextPtr;
+    Block_t *jobPtr;
+    bool isStopping;
+
+    for( ;; )
+    {
+        le_sem_Wait( descPtr->jobSemRef );
+
+        le_mutex_Lock( descPtr->mutexRef );
+        jobPtr = NextJob( descPtr );
+        if( jobPtr )
+        {
+            jobPtr->isQueued = false;
+        }
+        isStopping = descPtr->isStopping;
+        le_mutex_Unlock( descPtr->mutexRef );
+
+        if( jobPtr )
+        {
+            RunJob( descPtr, jobPtr );
+            le_sem_Post( descPtr->doneSemRef );
+        }
+        else if( isStopping )
+        {
+            break;
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Queue the read or the write of a block, or do it now if the accesses are synchronous. The state
+ * of the block must be set before. The mutex must be held.
+ */
+//--------------------------------------------------------------------------------------------------
+static void QueueJob
+(
+    pa_patch_InternalDesc_t *descPtr,   ///< [IN] Internal patch descriptor
+    Block_t *blockPtr                   ///< [IN] Block to read or write
+)
+{
+    if( descPtr->ioThreadRef )
+    {
+        blockPtr->isQueued = true;
+        le_sem_Post( descPtr->jobSemRef );
+    }
+    else
+    {
+        le_mutex_Unlock( descPtr->mutexRef );
+        RunJob( descPtr, blockPtr );
+        le_mutex_Lock( descPtr->mutexRef );
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the I/O thread to complete a job. The mutex must be held: it is released while waiting.
+ */
+//--------------------------------------------------------------------------------------------------
+static void WaitJob
+(
+    pa_patch_InternalDesc_t *descPtr    ///< [IN] Internal patch descriptor
+)
+{
+    le_mutex_Unlock( descPtr->mutexRef );
+    le_sem_Wait( descPtr->doneSemRef );
+    le_mutex_Lock( descPtr->mutexRef );
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Look for an origin block in the read-ahead cache. The mutex must be held.
+ *
+ * @return
+ *      - The block being read or read, NULL if it is not in the cache
+ */
+//--------------------------------------------------------------------------------------------------
+static Block_t *FindOrigBlock
+(
+    pa_patch_InternalDesc_t *descPtr,   ///< [IN] Internal patch descriptor
+    off_t offset                        ///< [IN] Offset of the block
+)
+{
+    uint32_t i;
+
+    for( i = 0; i < descPtr->nbOrigBlocks; i++ )
+    {
+        if( (BLOCK_FREE != descPtr->origBlocks[i].state) &&
+            (offset == descPtr->origBlocks[i].offset) )
+        {
+            return &descPtr->origBlocks[i];
+        }
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get an origin buffer to read a block: a free one, else the least recently used one. Buffers
+ * being read are not reused. The mutex must be held.
+ *
+ * @return
+ *      - The buffer, NULL if all other buffers are being read
+ */
+//--------------------------------------------------------------------------------------------------
+static Block_t *GetOrigBuffer
+(
+    pa_patch_InternalDesc_t *descPtr,   ///< [IN] Internal patch descriptor
+    const Block_t *keepPtr              ///< [IN] Block that must not be reused, may be NULL
+)
+{
+    Block_t *blockPtr = NULL;
+    uint32_t i;
+
+    for( i = 0; i < descPtr->nbOrigBlocks; i++ )
+    {
+        Block_t *candidatePtr = &descPtr->origBlocks[i];
+
+        if( (candidatePtr == keepPtr) || (BLOCK_LOADING == candidatePtr->state) )
+        {
+            continue;
+        }
+        if( BLOCK_FREE == candidatePtr->state )
+        {
+            return candidatePtr;
+        }
+        if( (!blockPtr) || ((int32_t)(candidatePtr->seq - blockPtr->seq) < 0) )
+        {
+            blockPtr = candidatePtr;
+        }
+    }
+    return blockPtr;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if an origin block is being read ahead. The mutex must be held.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsOrigLoading
+(
+    pa_patch_InternalDesc_t *descPtr    ///< [IN] Internal patch descriptor
+)
+{
+    uint32_t i;
+
+    for( i = 0; i < descPtr->nbOrigBlocks; i++ )
+    {
+        if( BLOCK_LOADING == descPtr->origBlocks[i].state )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Check if a destination block is being written. The mutex must be held.
+ */
+//--------------------------------------------------------------------------------------------------
+static bool IsDestWriting
+(
+    pa_patch_InternalDesc_t *descPtr    ///< [IN] Internal patch descriptor
+)
+{
+    uint32_t i;
+
+    for( i = 0; i < descPtr->nbDestBlocks; i++ )
+    {
+        if( BLOCK_WRITING == descPtr->destBlocks[i].state )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Stop the I/O thread and release the block buffers and synchronization objects. The queued
+ * jobs are done before.
+ */
+//--------------------------------------------------------------------------------------------------
+static void ReleaseBlocks
+(
+    pa_patch_InternalDesc_t *descPtr    ///< [IN] Internal patch descriptor
+)
+{
+    uint32_t i;
+
+    if( descPtr->ioThreadRef )
+    {
+        le_mutex_Lock( descPtr->mutexRef );
+        descPtr->isStopping = true;
+        le_mutex_Unlock( descPtr->mutexRef );
+        le_sem_Post( descPtr->jobSemRef );
+        le_thread_Join( descPtr->ioThreadRef, NULL );
+        descPtr->ioThreadRef = NULL;
+    }
+    for( i = 0; i < PATCH_MAX_ORIG_BLOCKS; i++ )
+    {
+        if( descPtr->origBlocks[i].dataPtr )
+        {
+            le_mem_Release( descPtr->origBlocks[i].dataPtr );
+            descPtr->origBlocks[i].dataPtr = NULL;
+        }
+    }
+    for( i = 0; i < PATCH_MAX_DEST_BLOCKS; i++ )
+    {
+        if( descPtr->destBlocks[i].dataPtr )
+        {
+            le_mem_Release( descPtr->destBlocks[i].dataPtr );
+            descPtr->destBlocks[i].dataPtr = NULL;
+        }
+    }
+    if( descPtr->doneSemRef )
+    {
+        le_sem_Delete( descPtr->doneSemRef );
+        descPtr->doneSemRef = NULL;
+    }
+    if( descPtr->jobSemRef )
+    {
+        le_sem_Delete( descPtr->jobSemRef );
+        descPtr->jobSemRef = NULL;
+    }
+    if( descPtr->mutexRef )
+    {
+        le_mutex_Delete( descPtr->mutexRef );
+        descPtr->mutexRef = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Allocate the block buffers within the memory ceiling of the patch context, and start the I/O
+ * thread if there is room for two destination buffers and a cache of the origin.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_OUT_OF_RANGE  If the flash erase block does not fit the buffers
+ */
+//--------------------------------------------------------------------------------------------------
+static le_result_t AllocBlocks
+(
+    pa_patch_InternalDesc_t *descPtr    ///< [IN] Internal patch descriptor
+)
+{
+    size_t eraseSize = descPtr->flashOrigInfo->eraseSize;
+    size_t nbBlocks;
+    uint32_t i;
+
+    if( !PatchBlockPool )
+    {
+        PatchBlockPool = le_mem_CreatePool("Patch Block Pool", eraseSize );
+        PatchBlockPoolSize = eraseSize;
+    }
+    if( (eraseSize > PatchBlockPoolSize) || (descPtr->flashDestInfo->eraseSize > eraseSize) )
+    {
+        LE_ERROR("Erase block %zx does not fit the patch buffers %zx\n",
+                 eraseSize, PatchBlockPoolSize);
+        return LE_OUT_OF_RANGE;
+    }
+
+    nbBlocks = descPtr->context.maxMemory / PatchBlockPoolSize;
+    if( nbBlocks < 2 )
+    {
+        LE_WARN("Memory ceiling %zu is below two blocks of %zu bytes\n",
+                descPtr->context.maxMemory, PatchBlockPoolSize);
+        nbBlocks = 2;
+    }
+
+    descPtr->mutexRef = le_mutex_CreateNonRecursive("PatchBlocks");
+    if( nbBlocks > PATCH_MAX_DEST_BLOCKS )
+    {
+        descPtr->nbDestBlocks = PATCH_MAX_DEST_BLOCKS;
+        descPtr->nbOrigBlocks = nbBlocks - PATCH_MAX_DEST_BLOCKS;
+        if( descPtr->nbOrigBlocks > PATCH_MAX_ORIG_BLOCKS )
+        {
+            descPtr->nbOrigBlocks = PATCH_MAX_ORIG_BLOCKS;
+        }
+        descPtr->jobSemRef = le_sem_Create("PatchJobs", 0);
+        descPtr->doneSemRef = le_sem_Create("PatchDone", 0);
+        descPtr->ioThreadRef = le_thread_Create("PatchIo", IoThread, descPtr);
+        le_thread_SetJoinable( descPtr->ioThreadRef );
+        le_thread_Start( descPtr->ioThreadRef );
+    }
+    else
+    {
+        descPtr->nbDestBlocks = 1;
+        descPtr->nbOrigBlocks = 1;
+    }
+
+    for( i = 0; i < descPtr->nbOrigBlocks; i++ )
+    {
+        descPtr->origBlocks[i].dataPtr = le_mem_ForceAlloc(PatchBlockPool);
+    }
+    for( i = 0; i < descPtr->nbDestBlocks; i++ )
+    {
+        descPtr->destBlocks[i].dataPtr = le_mem_ForceAlloc(PatchBlockPool);
+    }
+
+    LE_INFO("Patch buffers: %u origin and %u destination blocks of %zu bytes\n",
+            descPtr->nbOrigBlocks, descPtr->nbDestBlocks, PatchBlockPoolSize);
+    return LE_OK;
+}
 
 //--------------------------------------------------------------------------------------------------
 /**
@@ -58,9 +620,7 @@ le_mem_PoolRef_t PatchSegmentPool = NULL;
 le_result_t pa_patch_Open
 (
     pa_patch_Context_t *ctx,  ///< [IN] Context of the patch to be open
-    pa_patch_Desc_t *desc,    ///< [OUT] Private flash descriptor
-    uint8_t **origDataPtr,    ///< [OUT] Pointer to the orig data buffer
-    uint8_t **destDataPtr     ///< [OUT] Pointer to the dest data buffer
+    pa_patch_Desc_t *desc     ///< [OUT] Private flash descriptor
 )
 {
     pa_patch_InternalDesc_t *descPtr = NULL;
@@ -68,7 +628,7 @@ le_result_t pa_patch_Open
     pa_flash_OpenMode_t destMode = 0;
     le_result_t res = LE_FAULT;
 
-    if( (!ctx) || (!desc) || (!origDataPtr) || (!destDataPtr) )
+    if( (!ctx) || (!desc) )
     {
         return LE_BAD_PARAMETER;
     }
@@ -92,11 +652,6 @@ le_result_t pa_patch_Open
         PatchDescPool = le_mem_CreatePool("Patch Desc Pool", sizeof(pa_patch_InternalDesc_t) );
         le_mem_ExpandPool( PatchDescPool, 1 );
     }
-    if( (!PatchSegmentPool) )
-    {
-        PatchSegmentPool = le_mem_CreatePool("Patch Segment Pool", PA_PATCH_MAX_SEGMENTSIZE );
-        le_mem_ExpandPool( PatchSegmentPool, 2 );
-    }
     descPtr = le_mem_ForceAlloc(PatchDescPool);
     memset( descPtr, 0, sizeof(pa_patch_InternalDesc_t) );
     memcpy( &(descPtr->context), ctx, sizeof(pa_patch_Context_t) );
@@ -171,6 +726,7 @@ le_result_t pa_patch_Open
                           res);
                  goto erroropen;
              }
+             descPtr->blockSize = descPtr->flashOrigInfo->eraseSize;
              break;
         case PA_PATCH_IMAGE_UBIFLASH:
              origMode |= PA_FLASH_OPENMODE_UBI;
@@ -235,35 +791,30 @@ le_result_t pa_patch_Open
                           res);
                  goto erroropen;
              }
+             descPtr->blockSize = descPtr->context.segmentSize;
              break;
         default:
              LE_ERROR("Unsupported Image %d\n", descPtr->context.origImage);
              goto erroropen;
     }
-    descPtr->origDataPtr = le_mem_ForceAlloc(PatchSegmentPool);
-    descPtr->destDataPtr = le_mem_ForceAlloc(PatchSegmentPool);
-    *origDataPtr = descPtr->origDataPtr;
-    *destDataPtr = descPtr->destDataPtr;
+    res = AllocBlocks( descPtr );
+    if( LE_OK != res )
+    {
+        goto erroropen;
+    }
     descPtr->magic = (pa_patch_Desc_t *)descPtr;
     *desc = (pa_patch_Desc_t*)descPtr;
     return LE_OK;
 
 erroropen:
+    ReleaseBlocks( descPtr );
     if( descPtr->flashDestDesc )
     {
         pa_flash_Close( descPtr->flashDestDesc );
     }
     if( descPtr->flashOrigDesc )
     {
-        pa_flash_Close( descPtr->flashDestDesc );
-    }
-    if( descPtr->destDataPtr )
-    {
-        le_mem_Release(descPtr->destDataPtr);
-    }
-    if( descPtr->origDataPtr )
-    {
-        le_mem_Release(descPtr->origDataPtr);
+        pa_flash_Close( descPtr->flashOrigDesc );
     }
     if( descPtr )
     {
@@ -274,11 +825,13 @@ erroropen:
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Close a patch descriptor
+ * Close a patch descriptor. The pending writes are completed before.
  *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PAREMETER If desc is NULL or not a valid flash descriptor
+ *      - others           Depending of the image type and PA device used, or the error of a
+ *                         pending write
  */
 //--------------------------------------------------------------------------------------------------
 le_result_t pa_patch_Close
@@ -297,9 +850,11 @@ le_result_t pa_patch_Close
         return LE_BAD_PARAMETER;
     }
 
+    res = pa_patch_Flush( desc );
+    ReleaseBlocks( descPtr );
     descPtr->magic = NULL;
 
-    if( update )
+    if( update && (LE_OK == res) )
     {
         LE_DEBUG("update %d, destSize = %x\n", update, destSize );
         switch( descPtr->context.destImage )
@@ -330,14 +885,6 @@ le_result_t pa_patch_Close
     {
         pa_flash_Close( descPtr->flashOrigDesc );
     }
-    if( descPtr->destDataPtr )
-    {
-        le_mem_Release(descPtr->destDataPtr);
-    }
-    if( descPtr->origDataPtr )
-    {
-        le_mem_Release(descPtr->origDataPtr);
-    }
     if( descPtr )
     {
         le_mem_Release(descPtr);
@@ -347,157 +894,267 @@ le_result_t pa_patch_Close
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Read data starting the given block. If a Bad block is detected,
- * the error LE_IO_ERROR is returned and operation is aborted.
- * Note that the length should not be greater than eraseSize
+ * Return the size of the data of a flash block: the erase block for RAW flash, the LEB for UBI.
+ * The origin and destination images are read and written by flash blocks.
+ *
+ * @return
+ *      - The size of a block, 0 if desc is not a valid patch descriptor
+ */
+//--------------------------------------------------------------------------------------------------
+size_t pa_patch_GetBlockSize
+(
+    pa_patch_Desc_t desc      ///< [IN] Private patch descriptor
+)
+{
+    pa_patch_InternalDesc_t *descPtr = (pa_patch_InternalDesc_t *)desc;
+
+    if( (!desc) || (descPtr->magic != desc) )
+    {
+        return 0;
+    }
+    return descPtr->blockSize;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Get the origin data of the block containing the given offset. The data are read from the
+ * read-ahead cache, or from the flash if not cached yet, and the next block is read ahead.
+ * The returned pointer is valid until the next call.
  *
  * @return
  *      - LE_OK            On success
- *      - LE_BAD_PARAMETER If desc is NULL or dataPtr is NULL or dataSizePtr is NULL
- *      - LE_FAULT         On failure
+ *      - LE_BAD_PARAMETER If desc is NULL or a pointer is NULL
  *      - LE_OUT_OF_RANGE  If the block is outside the partition
  *      - others           Depending of the image type and PA device used
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_patch_ReadSegment
+le_result_t pa_patch_ReadOrigBlock
 (
-    pa_patch_Desc_t desc,
-    off_t offset,
-    uint8_t *dataPtr,
-    size_t  *dataSizePtr
+    pa_patch_Desc_t desc,     ///< [IN] Private patch descriptor
+    off_t offset,             ///< [IN] Offset in the origin image
+    const uint8_t **dataPtr,  ///< [OUT] Pointer to the data of the block
+    off_t *blockOffsetPtr,    ///< [OUT] Offset of the block in the origin image
+    size_t *dataSizePtr       ///< [OUT] Size of the data of the block
 )
 {
     pa_patch_InternalDesc_t *descPtr = (pa_patch_InternalDesc_t *)desc;
-    size_t size, chunckSize;
-    int blk;
+    Block_t *blockPtr;
+    Block_t *nextPtr;
+    off_t blockOffset, nextOffset;
     le_result_t res;
 
-    if( (!desc) || (descPtr->magic != desc) || (!dataSizePtr) )
+    if( (!desc) || (descPtr->magic != desc) || (!dataPtr) || (!blockOffsetPtr) ||
+        (!dataSizePtr) || (offset < 0) )
     {
         return LE_BAD_PARAMETER;
     }
 
-    *dataSizePtr = 0;
-    size = descPtr->context.segmentSize;
-    switch( descPtr->context.origImage )
+    blockOffset = (offset / descPtr->blockSize) * descPtr->blockSize;
+
+    le_mutex_Lock( descPtr->mutexRef );
+    blockPtr = FindOrigBlock( descPtr, blockOffset );
+    if( !blockPtr )
     {
-        case PA_PATCH_IMAGE_RAWFLASH:
-             if( ((off_t)size + offset) > (off_t)(descPtr->flashOrigInfo->nbLeb *
-                                                  descPtr->flashOrigInfo->eraseSize) )
-             {
-                 size = (size_t)(descPtr->flashOrigInfo->nbLeb *
-                                 descPtr->flashOrigInfo->eraseSize) -
-                        (size_t)offset;
-             }
-             res = pa_flash_SeekAtOffset( descPtr->flashOrigDesc, offset );
-             if( LE_OK != res )
-             {
-                 return res;
-             }
-             *dataSizePtr = size;
-             chunckSize = descPtr->context.origImage == PA_PATCH_IMAGE_RAWFLASH
-                             ? descPtr->flashOrigInfo->eraseSize
-                             : descPtr->context.segmentSize;
-             for( blk = 0; blk < (size / chunckSize); blk++ )
-             {
-                 res = pa_flash_Read( descPtr->flashOrigDesc,
-                                      (descPtr->origDataPtr + (blk * chunckSize)),
-                                      chunckSize );
-                 if( LE_OK != res )
-                 {
-                     return res;
-                 }
-             }
-             return res;
-        case PA_PATCH_IMAGE_UBIFLASH:
-             blk = offset / descPtr->context.segmentSize;
-             res = pa_flash_ReadUbiAtBlock( descPtr->flashOrigDesc,
-                                            blk, descPtr->origDataPtr, &size);
-             *dataSizePtr = size;
-             return res;
+        while( NULL == (blockPtr = GetOrigBuffer( descPtr, NULL )) )
+        {
+            WaitJob( descPtr );
+        }
+        LE_DEBUG("Read origin block at %lx\n", blockOffset);
+        blockPtr->offset = blockOffset;
+        blockPtr->state = BLOCK_LOADING;
+        blockPtr->isUrgent = true;
+        QueueJob( descPtr, blockPtr );
+    }
+    else if( BLOCK_LOADING == blockPtr->state )
+    {
+        blockPtr->isUrgent = true;
+    }
+    while( BLOCK_LOADING == blockPtr->state )
+    {
+        WaitJob( descPtr );
     }
-    return LE_UNSUPPORTED;
+
+    blockPtr->seq = ++descPtr->seq;
+    res = blockPtr->result;
+    if( LE_OK != res )
+    {
+        blockPtr->state = BLOCK_FREE;
+        le_mutex_Unlock( descPtr->mutexRef );
+        return res;
+    }
+
+    // Read ahead the next block while the patch uses this one
+    nextOffset = blockOffset + descPtr->blockSize;
+    if( (descPtr->ioThreadRef) && (nextOffset < (off_t)descPtr->context.origImageSize) &&
+        (!FindOrigBlock( descPtr, nextOffset )) && (!IsOrigLoading( descPtr )) )
+    {
+        nextPtr = GetOrigBuffer( descPtr, blockPtr );
+        if( nextPtr )
+        {
+            nextPtr->offset = nextOffset;
+            nextPtr->state = BLOCK_LOADING;
+            nextPtr->isUrgent = false;
+            QueueJob( descPtr, nextPtr );
+        }
+    }
+
+    *dataPtr = blockPtr->dataPtr;
+    *blockOffsetPtr = blockOffset;
+    *dataSizePtr = blockPtr->size;
+    le_mutex_Unlock( descPtr->mutexRef );
+    return LE_OK;
 }
 
 //--------------------------------------------------------------------------------------------------
 /**
- * Write data starting the given block. If a Bad block is detected,
- * the error LE_IO_ERROR is returned and operation is aborted.
- * Note that the block should be erased before the first write (pa_patch_EraseAtBlock)
- * Note that the length should be a multiple of writeSize and should not be greater than eraseSize
+ * Get a free destination buffer of one block. If all the destination buffers are being written,
+ * wait until one is written.
  *
  * @return
  *      - LE_OK            On success
  *      - LE_BAD_PARAMETER If desc is NULL or dataPtr is NULL
- *      - LE_FAULT         On failure
- *      - LE_OUT_OF_RANGE  If the block is outside the partition
- *      - others           Depending of the image type and PA device used
+ *      - others           The error of a previous write
  */
 //--------------------------------------------------------------------------------------------------
-le_result_t pa_patch_WriteSegment
+le_result_t pa_patch_GetDestBuffer
 (
-    pa_patch_Desc_t desc,
-    off_t offset,
-    uint8_t *dataPtr,
-    uint32_t newSize
+    pa_patch_Desc_t desc,     ///< [IN] Private patch descriptor
+    uint8_t **dataPtr         ///< [OUT] Pointer to the destination buffer
 )
 {
     pa_patch_InternalDesc_t *descPtr = (pa_patch_InternalDesc_t *)desc;
-    int blk, maxblk;
-    off_t blkOff;
+    Block_t *blockPtr = NULL;
     le_result_t res;
+    uint32_t i;
 
-    if( (!desc) || (descPtr->magic != desc) )
+    if( (!desc) || (descPtr->magic != desc) || (!dataPtr) )
     {
         return LE_BAD_PARAMETER;
     }
 
-    switch( descPtr->context.destImage )
+    le_mutex_Lock( descPtr->mutexRef );
+    for( ;; )
     {
-        case PA_PATCH_IMAGE_RAWFLASH:
-            maxblk = (newSize + (descPtr->flashDestInfo->eraseSize - 1))
-                     / descPtr->flashDestInfo->eraseSize;
-            for( blk = 0; blk < maxblk; blk++ )
+        for( i = 0; (!blockPtr) && (i < descPtr->nbDestBlocks); i++ )
+        {
+            if( BLOCK_FREE == descPtr->destBlocks[i].state )
             {
-                blkOff = (blk * descPtr->flashDestInfo->eraseSize) + offset;
-
-                LE_DEBUG("Erase and write blk %d, size %d at %lx to %x\n",
-                         blk, descPtr->flashDestInfo->eraseSize, blkOff,
-                         blk * descPtr->flashDestInfo->eraseSize );
-                LE_DEBUG("Erase and write blk %d, blkOff=%lx, _ph_offset=%lx\n",
-                         blk, blkOff, offset);
-                res = pa_flash_EraseBlock( descPtr->flashDestDesc,
-                                           blkOff / descPtr->flashDestInfo->eraseSize );
-                if (LE_OK != res)
-                {
-                    return res;
-                }
-                res = pa_flash_SeekAtOffset( descPtr->flashDestDesc, blkOff );
-                if (LE_OK != res)
-                {
-                    return res;
-                }
-                res = pa_flash_Write( descPtr->flashDestDesc,
-                                      &dataPtr[blk * descPtr->flashDestInfo->eraseSize],
-                                      descPtr->flashDestInfo->eraseSize);
-                if (LE_OK != res)
-                {
-                    return res;
-                }
+                blockPtr = &descPtr->destBlocks[i];
             }
+        }
+        if( (blockPtr) || (!IsDestWriting( descPtr )) )
+        {
             break;
-        case PA_PATCH_IMAGE_UBIFLASH:
-             blk = offset / descPtr->context.segmentSize;
-             res = pa_flash_WriteUbiAtBlock( descPtr->flashDestDesc,
-                                             blk,
-                                             descPtr->destDataPtr,
-                                             (newSize + (descPtr->flashDestInfo->writeSize - 1)) &
-                                             ~(descPtr->flashDestInfo->writeSize - 1),
-                                             true);
-             return res;
-        default:
-            return LE_UNSUPPORTED;
+        }
+        WaitJob( descPtr );
     }
-    return LE_OK;
+
+    res = descPtr->writeResult;
+    if( (LE_OK == res) && (!blockPtr) )
+    {
+        // All the buffers are already given to the patch
+        res = LE_FAULT;
+    }
+    if( LE_OK == res )
+    {
+        blockPtr->state = BLOCK_FILLING;
+        *dataPtr = blockPtr->dataPtr;
+    }
+    le_mutex_Unlock( descPtr->mutexRef );
+    return res;
+}
+
+//--------------------------------------------------------------------------------------------------
+/**
+ * Write a destination buffer at the block of the given offset. The block is erased before. The
+ * write is queued and the buffer is given back to the patch descriptor: it must not be accessed
+ * anymore. If a Bad block is detected, the error LE_IO_ERROR is returned by a later call.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or dataPtr is not a destination buffer
+ *      - others           The error of a previous write
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_patch_WriteDestBlock
+(
+    pa_patch_Desc_t desc,     ///< [IN] Private patch descriptor
+    off_t offset,             ///< [IN] Offset of the block in the destination image
+    uint8_t *dataPtr,         ///< [IN] Destination buffer to be written
+    size_t dataSize           ///< [IN] Size of data to write
+)
+{
+    pa_patch_InternalDesc_t *descPtr = (pa_patch_InternalDesc_t *)desc;
+    Block_t *blockPtr = NULL;
+    le_result_t res;
+    uint32_t i;
+
+    if( (!desc) || (descPtr->magic != desc) || (dataSize > descPtr->blockSize) ||
+        (offset % descPtr->blockSize) )
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    le_mutex_Lock( descPtr->mutexRef );
+    for( i = 0; i < descPtr->nbDestBlocks; i++ )
+    {
+        if( (BLOCK_FILLING == descPtr->destBlocks[i].state) &&
+            (dataPtr == descPtr->destBlocks[i].dataPtr) )
+        {
+            blockPtr = &descPtr->destBlocks[i];
+        }
+    }
+    if( !blockPtr )
+    {
+        le_mutex_Unlock( descPtr->mutexRef );
+        return LE_BAD_PARAMETER;
+    }
+
+    blockPtr->offset = offset;
+    blockPtr->size = dataSize;
+    blockPtr->seq = ++descPtr->seq;
+    blockPtr->state = BLOCK_WRITING;
+    QueueJob( descPtr, blockPtr );
+    res = descPtr->writeResult;
+    le_mutex_Unlock( descPtr->mutexRef );
+    return res;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait until all the queued writes are done, and flush the destination flash, so that the blocks
+ * written are on the flash and, for an UBI volume, covered by its headers. Called before the
+ * progress of the update is recorded.
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or not a valid patch descriptor
+ *      - others           The error of a write
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_patch_Flush
+(
+    pa_patch_Desc_t desc      ///< [IN] Private patch descriptor
+)
+{
+    pa_patch_InternalDesc_t *descPtr = (pa_patch_InternalDesc_t *)desc;
+    le_result_t res;
+
+    if( (!desc) || (descPtr->magic != desc) )
+    {
+        return LE_BAD_PARAMETER;
+    }
+
+    le_mutex_Lock( descPtr->mutexRef );
+    while( IsDestWriting( descPtr ) )
+    {
+        WaitJob( descPtr );
+    }
+    res = descPtr->writeResult;
+    le_mutex_Unlock( descPtr->mutexRef );
+    if( LE_OK == res )
+    {
+        res = pa_flash_Flush( descPtr->flashDestDesc );
+    }
+    return res;
+}
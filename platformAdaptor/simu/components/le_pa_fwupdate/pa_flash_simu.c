@@ -89,6 +89,23 @@ le_result_t pa_flash_Open
     return LE_FAULT;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Wait for the queued operations of a flash descriptor to be done
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL or not a valid flash descriptor
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flash_Flush
+(
+    pa_flash_Desc_t desc      ///< [IN] Private flash descriptor
+)
+{
+    return LE_FAULT;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Close a flash descriptor
@@ -215,6 +232,26 @@ le_result_t pa_flash_EraseBlock
     return LE_FAULT;
 }
 
+//--------------------------------------------------------------------------------------------------
+/**
+ * Erase the good blocks where the next pa_flash_Write will write
+ *
+ * @return
+ *      - LE_OK            On success
+ *      - LE_BAD_PARAMETER If desc is NULL
+ *      - LE_FAULT         On failure
+ *      - LE_IO_ERROR      If a flash IO error occurs
+ */
+//--------------------------------------------------------------------------------------------------
+le_result_t pa_flash_EraseNextBlocks
+(
+    pa_flash_Desc_t desc,     ///< [IN] Private flash descriptor
+    uint32_t nbBlocks         ///< [IN] Number of good blocks to erase
+)
+{
+    return LE_FAULT;
+}
+
 //--------------------------------------------------------------------------------------------------
 /**
  * Set the current read/write position of the flash to the given offset